@@ -19,6 +19,9 @@ namespace toy::editor
 
         void unselect();
 
+        // Drop selection and find editor camera after scene has been replaced, a new one is created if scene has none
+        void reset_scene();
+
         EntityWrapper &get_editor_camera_entity();
 
         EntityWrapper &get_selected_entity();
@@ -33,6 +36,9 @@ namespace toy::editor
 
         float &get_mouse_sensitivity_y();
 
+    private:
+        void create_editor_camera();
+
     private:
         EntityWrapper m_selected_entity = {};
         EntityWrapper m_editor_camera_entity = {};
@@ -31,6 +31,14 @@ namespace toy::editor
 
         void on_start_page_render();
 
+        // Replace scene by a scene file picked by user, false if none is picked or it can not be loaded
+        bool open_scene();
+
+        void save_scene();
+
+        // Stream world description picked by user, see data/worlds
+        void open_world_file();
+
     private:
         bool m_show_start_page = true;
     };
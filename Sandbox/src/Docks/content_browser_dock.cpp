@@ -153,14 +153,14 @@ namespace toy::editor
         auto sound_srv = texture_manager.create_from_file(DXTOY_HOME "data/icons/sound.png");
         auto text_srv = texture_manager.create_from_file(DXTOY_HOME "data/icons/copy.png");
 
-        store_shader_resource_view_info(IconType::Folder, folder_srv);
-        store_shader_resource_view_info(IconType::Scene, scene_srv);
-        store_shader_resource_view_info(IconType::Mesh, mesh_srv);
-        store_shader_resource_view_info(IconType::Material, material_srv);
-        store_shader_resource_view_info(IconType::Shader, shader_srv);
-        store_shader_resource_view_info(IconType::Prefab, prefab_srv);
-        store_shader_resource_view_info(IconType::Sound, sound_srv);
-        store_shader_resource_view_info(IconType::Text, text_srv);
+        store_shader_resource_view_info(IconType::Folder, folder_srv.get().Get());
+        store_shader_resource_view_info(IconType::Scene, scene_srv.get().Get());
+        store_shader_resource_view_info(IconType::Mesh, mesh_srv.get().Get());
+        store_shader_resource_view_info(IconType::Material, material_srv.get().Get());
+        store_shader_resource_view_info(IconType::Shader, shader_srv.get().Get());
+        store_shader_resource_view_info(IconType::Prefab, prefab_srv.get().Get());
+        store_shader_resource_view_info(IconType::Sound, sound_srv.get().Get());
+        store_shader_resource_view_info(IconType::Text, text_srv.get().Get());
     }
 
     void ContentBrowserDock::on_render(float delta_time)
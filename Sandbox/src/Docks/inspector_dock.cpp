@@ -265,48 +265,38 @@ namespace toy::editor
 
             auto&& material = static_mesh_component.model_asset->materials[0];
             auto&& texture_manager = model::TextureManager::get();
-            constexpr std::string_view diffuse_color_name = material_semantics_name(model::MaterialSemantics::DiffuseColor);
-            constexpr std::string_view metalness_name = material_semantics_name(model::MaterialSemantics::Metalness);
-            constexpr std::string_view roughness_name = material_semantics_name(model::MaterialSemantics::Roughness);
-            constexpr std::string_view diffuse_map_name = material_semantics_name(model::MaterialSemantics::DiffuseMap);
-            constexpr std::string_view normal_map_name = material_semantics_name(model::MaterialSemantics::NormalMap);
-            constexpr std::string_view metalness_map_name = material_semantics_name(model::MaterialSemantics::MetalnessMap);
-            constexpr std::string_view roughness_map_name = material_semantics_name(model::MaterialSemantics::RoughnessMap);
-            if (material.has_property(diffuse_color_name))
+            using model::MaterialSemantics;
+            if (material.has(MaterialSemantics::DiffuseColor))
             {
-                auto&& diffuse_color = material.get<DirectX::XMFLOAT4>(diffuse_color_name);
+                auto&& diffuse_color = material.get_color(MaterialSemantics::DiffuseColor);
                 draw_item("Diffuse", std::span{ s_color_button_label.data(), s_color_button_label.size() },
                             std::span{ s_color_drag_label.data(), s_color_drag_label.size() }, diffuse_color);
             }
-            if (material.has_property(metalness_name))
+            if (material.has(MaterialSemantics::Metalness))
             {
-                auto&& metalness_value = material.get<float>(metalness_name);
+                auto&& metalness_value = material.get_scalar(MaterialSemantics::Metalness);
                 draw_item("Metalness", s_metalness_button_label, s_vec4_drag_label.front(), metalness_value);
             }
-            if (material.has_property(roughness_name))
+            if (material.has(MaterialSemantics::Roughness))
             {
-                auto&& roughness_value = material.get<float>(roughness_name);
+                auto&& roughness_value = material.get_scalar(MaterialSemantics::Roughness);
                 draw_item("Roughness", s_roughness_button_label, s_vec4_drag_label.front(), roughness_value);
             }
-            if (material.has_property(diffuse_map_name))
+            if (material.has(MaterialSemantics::DiffuseMap))
             {
-                auto&& diffuse_map_path = material.get<std::string>(diffuse_map_name);
-                draw_image("DiffuseMap", texture_manager.get_texture(diffuse_map_path));
+                draw_image("DiffuseMap", texture_manager.get_texture(material.get_texture(MaterialSemantics::DiffuseMap)));
             }
-            if (material.has_property(normal_map_name))
+            if (material.has(MaterialSemantics::NormalMap))
             {
-                auto&& normal_map_path = material.get<std::string>(normal_map_name);
-                draw_image("NormalMap", texture_manager.get_texture(normal_map_path));
+                draw_image("NormalMap", texture_manager.get_texture(material.get_texture(MaterialSemantics::NormalMap)));
             }
-            if (material.has_property(metalness_map_name))
+            if (material.has(MaterialSemantics::MetalnessMap))
             {
-                auto&& metalness_map_path = material.get<std::string>(metalness_map_name);
-                draw_image("MetalnessMap", texture_manager.get_texture(metalness_map_path));
+                draw_image("MetalnessMap", texture_manager.get_texture(material.get_texture(MaterialSemantics::MetalnessMap)));
             }
-            if (material.has_property(roughness_map_name))
+            if (material.has(MaterialSemantics::RoughnessMap))
             {
-                auto&& roughness_map_path = material.get<std::string>(roughness_map_name);
-                draw_image("RoughnessMap", texture_manager.get_texture(roughness_map_path));
+                draw_image("RoughnessMap", texture_manager.get_texture(material.get_texture(MaterialSemantics::RoughnessMap)));
             }
 
             ImGui::TreePop();
@@ -9,67 +9,57 @@
 
 namespace toy::editor
 {
+    static constexpr std::string_view s_editor_camera_name = "EditorCamera";
+
     EditingSystem::EditingSystem()
     {
         // Initialize editor camera
         using namespace DirectX;
         auto&& renderer = core::get_subsystem<runtime::Renderer>();
         auto&& scene_graph = core::get_subsystem<runtime::SceneGraph>();
-        auto editor_camera = std::make_shared<FirstPersonCamera>();
-        float width = 1600.0f;
-        float height = 900.0f;
-        editor_camera->set_viewport(0.0f, 0.0f, width, height);
-        editor_camera->set_frustum(XM_PI / 3.0f, width / height, 0.5f, 360.0f);
-        editor_camera->look_at(XMFLOAT3{-60.0f, 10.0f, 2.5f }, XMFLOAT3{ 0.0f, 0.0f, 0.0f }, XMFLOAT3{ 0.0f, 1.0f, 0.0f });
-
-        m_editor_camera_entity = scene_graph.create_entity("EditorCamera");
-        auto&& camera_component = m_editor_camera_entity.add_component<CameraComponent>();
-        camera_component.camera = std::move(editor_camera);
-        camera_component.camera_type = CameraType::FirstPersonCamera;
-        DX_INFO("Editor camera entity id: {}", static_cast<uint32_t>(m_editor_camera_entity.entity_inst));
+        create_editor_camera();
 
         // TODO: remove these below
         // Initialize texture assets - cube map, irradiance map, specular environment map, BRDF lut, others
-        PreProcessEffect::get().compute_cubemap(renderer.get_device(), renderer.get_device_context(), DXTOY_HOME "data/textures/environment.hdr");
-        PreProcessEffect::get().compute_sp_env_map(renderer.get_device(), renderer.get_device_context());
-        PreProcessEffect::get().compute_irradiance_map(renderer.get_device(), renderer.get_device_context());
-        PreProcessEffect::get().compute_brdf_lut(renderer.get_device(), renderer.get_device_context());
-
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_diffuse.jpg");
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_normal.jpg");
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_metallic.jpg");
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_roughness.jpg");
-
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_A.tga", true, 1);
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_N.tga");
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_M.tga");
-        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_R.tga");
+        PreProcessEffect::get().compute_ibl(renderer.get_device(), renderer.get_device_context(), DXTOY_HOME "data/textures/environment.hdr");
+
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_diffuse.jpg", false, 0,
+                                                      model::TextureUsage::Albedo);
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_normal.jpg", false, 0,
+                                                      model::TextureUsage::Normal);
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_metallic.jpg", false, 0,
+                                                      model::TextureUsage::Mask);
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/textures/cgaxis_brown_clay_tiles_4K/brown_clay_tiles_44_49_roughness.jpg", false, 0,
+                                                      model::TextureUsage::Mask);
+
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_A.tga", true, 1, model::TextureUsage::Albedo);
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_N.tga", false, 0, model::TextureUsage::Normal);
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_M.tga", false, 0, model::TextureUsage::Mask);
+        model::TextureManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_R.tga", false, 0, model::TextureUsage::Mask);
 
         // Initialize skybox
         auto skybox_entity = scene_graph.create_entity("Skybox");
-        model::ModelManager::get().create_from_geometry("SkyboxCube", geometry::create_box(static_cast<uint32_t>(skybox_entity.entity_inst)));
         skybox_entity.add_component<TransformComponent>();
         auto& skybox_mesh = skybox_entity.add_component<StaticMeshComponent>();
-        skybox_mesh.model_asset = model::ModelManager::get().get_model("SkyboxCube");
+        skybox_mesh.model_asset = model::ModelManager::get().create_from_geometry("SkyboxCube", geometry::create_box());
         skybox_mesh.is_skybox = true;
         DX_INFO("Skybox entity id: {}", static_cast<uint32_t>(skybox_entity.entity_inst));
 
         // Initialize cerberus
         auto cerberus_entity = scene_graph.create_entity("Cerberus");
-        model::ModelManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Cerberus_LP.fbx", static_cast<uint32_t>(cerberus_entity.entity_inst));
         auto& cerberus_transform = cerberus_entity.add_component<TransformComponent>();
         cerberus_transform.transform.set_scale(0.3f, 0.3f, 0.3f);
         cerberus_transform.transform.set_rotation(XM_PI / 2.0f, XM_PI, XM_PI / 2.0f);
         auto& cerberus_mesh = cerberus_entity.add_component<StaticMeshComponent>();
-        cerberus_mesh.model_asset = model::ModelManager::get().get_model(DXTOY_HOME "data/models/Cerberus/Cerberus_LP.fbx");
-        cerberus_mesh.model_asset->materials[0].set<std::string>(material_semantics_name(model::MaterialSemantics::DiffuseMap),
-                                                                    DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_A.tga");
-        cerberus_mesh.model_asset->materials[0].set<std::string>(material_semantics_name(model::MaterialSemantics::NormalMap),
-                                                                    DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_N.tga");
-        cerberus_mesh.model_asset->materials[0].set<std::string>(material_semantics_name(model::MaterialSemantics::MetalnessMap),
-                                                                    DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_M.tga");
-        cerberus_mesh.model_asset->materials[0].set<std::string>(material_semantics_name(model::MaterialSemantics::RoughnessMap),
-                                                                    DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_R.tga");
+        cerberus_mesh.model_asset = model::ModelManager::get().create_from_file(DXTOY_HOME "data/models/Cerberus/Cerberus_LP.fbx");
+        cerberus_mesh.model_asset->materials[0].set_texture(model::MaterialSemantics::DiffuseMap,
+                                                            string_to_id(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_A.tga"));
+        cerberus_mesh.model_asset->materials[0].set_texture(model::MaterialSemantics::NormalMap,
+                                                            string_to_id(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_N.tga"));
+        cerberus_mesh.model_asset->materials[0].set_texture(model::MaterialSemantics::MetalnessMap,
+                                                            string_to_id(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_M.tga"));
+        cerberus_mesh.model_asset->materials[0].set_texture(model::MaterialSemantics::RoughnessMap,
+                                                            string_to_id(DXTOY_HOME "data/models/Cerberus/Textures/Cerberus_R.tga"));
         DX_INFO("Cerberus entity id: {}", static_cast<uint32_t>(cerberus_entity.entity_inst));
 
         // Initialize directional light
@@ -102,6 +92,38 @@ namespace toy::editor
         renderer.reset_selected_entity(m_selected_entity);
     }
 
+    void EditingSystem::reset_scene()
+    {
+        auto&& scene_graph = core::get_subsystem<runtime::SceneGraph>();
+        unselect();
+
+        // Saved scene holds the editor camera it was saved with
+        m_editor_camera_entity = scene_graph.find_entity(s_editor_camera_name);
+        if (!m_editor_camera_entity.is_valid() || !m_editor_camera_entity.has_component<CameraComponent>() ||
+            m_editor_camera_entity.get_component<CameraComponent>().camera_type != CameraType::FirstPersonCamera)
+        {
+            create_editor_camera();
+        }
+    }
+
+    void EditingSystem::create_editor_camera()
+    {
+        using namespace DirectX;
+        auto&& scene_graph = core::get_subsystem<runtime::SceneGraph>();
+        auto editor_camera = std::make_shared<FirstPersonCamera>();
+        float width = 1600.0f;
+        float height = 900.0f;
+        editor_camera->set_viewport(0.0f, 0.0f, width, height);
+        editor_camera->set_frustum(XM_PI / 3.0f, width / height, 0.5f, 360.0f);
+        editor_camera->look_at(XMFLOAT3{-60.0f, 10.0f, 2.5f }, XMFLOAT3{ 0.0f, 0.0f, 0.0f }, XMFLOAT3{ 0.0f, 1.0f, 0.0f });
+
+        m_editor_camera_entity = scene_graph.create_entity(s_editor_camera_name);
+        auto&& camera_component = m_editor_camera_entity.add_component<CameraComponent>();
+        camera_component.camera = std::move(editor_camera);
+        camera_component.camera_type = CameraType::FirstPersonCamera;
+        DX_INFO("Editor camera entity id: {}", static_cast<uint32_t>(m_editor_camera_entity.entity_inst));
+    }
+
     EntityWrapper &EditingSystem::get_editor_camera_entity()
     {
         return m_editor_camera_entity;
@@ -7,6 +7,10 @@
 #include <Toy/Runtime/events.h>
 #include <Toy/Runtime/render_window.h>
 #include <Toy/Runtime/task_system.h>
+#include <Toy/Runtime/scene_graph.h>
+#include <Toy/Runtime/scene_file.h>
+#include <Toy/Runtime/world_streamer.h>
+#include <Toy/Runtime/async_model_loader.h>
 #include <Sandbox/Runtime/gui_system.h>
 #include <Sandbox/Runtime/docking_system.h>
 #include <Sandbox/Runtime/editing_system.h>
@@ -67,6 +71,9 @@ namespace toy::editor
         auto&& render_window = core::get_subsystem<runtime::RenderWindow>();
         auto&& task_system = core::get_subsystem<runtime::TaskSystem>();
         bool load_file = false;
+        bool open_scene_file = false;
+        bool save_scene_file = false;
+        bool pick_world_file = false;
         bool exit = false;
         if (input_controller.is_key_pressed_with_mod(key::Q, key::LeftControl))
         {
@@ -81,6 +88,18 @@ namespace toy::editor
                 {
                     load_file = true;
                 }
+                if (ImGui::MenuItem("Open scene"))
+                {
+                    open_scene_file = true;
+                }
+                if (ImGui::MenuItem("Save scene"))
+                {
+                    save_scene_file = true;
+                }
+                if (ImGui::MenuItem("Open world"))
+                {
+                    pick_world_file = true;
+                }
                 ImGui::Separator();
                 if (ImGui::MenuItem("Exit", "Ctrl+Q"))
                 {
@@ -88,6 +107,25 @@ namespace toy::editor
                 }
                 ImGui::EndMenu();
             }
+
+            // Models loading on workers, each can be cancelled
+            auto loads = core::get_subsystem<runtime::AsyncModelLoader>().get_loads();
+            if (!loads.empty() && ImGui::BeginMenu("Loading"))
+            {
+                for (auto&& load : loads)
+                {
+                    ImGui::PushID(load.get());
+                    std::string file_name = std::filesystem::path(load->get_file_name()).filename().string();
+                    ImGui::ProgressBar(load->get_progress(), ImVec2{ 240.0f, 0.0f }, file_name.c_str());
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("Cancel"))
+                    {
+                        load->cancel();
+                    }
+                    ImGui::PopID();
+                }
+                ImGui::EndMenu();
+            }
             ImGui::EndMainMenuBar();
         }
 
@@ -103,6 +141,21 @@ namespace toy::editor
                                                                 "glTF(.gltf, .glb), HDR(.hdr), FBX(.fbx)|*.gltf;*.hdr;*.fbx");
             task_system.push(DropEvent{ filepath });
         }
+
+        if (open_scene_file)
+        {
+            open_scene();
+        }
+
+        if (save_scene_file)
+        {
+            save_scene();
+        }
+
+        if (pick_world_file)
+        {
+            open_world_file();
+        }
     }
 
     void EditorApplication::on_start_page_render()
@@ -140,7 +193,7 @@ namespace toy::editor
                 on_create_project();
             }
 
-            if (ImGui::Button("Open project", ImVec2{ ImGui::GetContentRegionAvail().x, 0.0f }))
+            if (ImGui::Button("Open project", ImVec2{ ImGui::GetContentRegionAvail().x, 0.0f }) && open_scene())
             {
                 on_create_project();
             }
@@ -149,6 +202,44 @@ namespace toy::editor
         ImGui::PopStyleVar();
     }
 
+    bool EditorApplication::open_scene()
+    {
+        auto&& render_window = core::get_subsystem<runtime::RenderWindow>();
+        auto file_path = FileDialog::window_open_file_dialog(render_window.get_native_window(), "Open scene", "Toy scene(.tscene)|*.tscene");
+        if (file_path.empty() || !core::get_subsystem<runtime::SceneGraph>().load_scene(file_path))
+        {
+            return false;
+        }
+        core::get_subsystem<EditingSystem>().reset_scene();
+        return true;
+    }
+
+    void EditorApplication::save_scene()
+    {
+        auto&& render_window = core::get_subsystem<runtime::RenderWindow>();
+        auto file_path = FileDialog::window_save_file_dialog(render_window.get_native_window(), "Save scene", "Toy scene(.tscene)|*.tscene");
+        if (file_path.empty())
+        {
+            return;
+        }
+        std::filesystem::path scene_path(file_path);
+        if (scene_path.extension() != runtime::scene_file_extension)
+        {
+            scene_path += runtime::scene_file_extension;
+        }
+        core::get_subsystem<runtime::SceneGraph>().save_scene(scene_path);
+    }
+
+    void EditorApplication::open_world_file()
+    {
+        auto&& render_window = core::get_subsystem<runtime::RenderWindow>();
+        auto file_path = FileDialog::window_open_file_dialog(render_window.get_native_window(), "Open world", "World description(.json)|*.json");
+        if (!file_path.empty())
+        {
+            Application::open_world(file_path);
+        }
+    }
+
     void EditorApplication::on_docks_render(float delta_time)
     {
         on_menu_render();
@@ -0,0 +1,95 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/block_compression.h>
+
+// Compressed gradients must decode above a PSNR floor per format and image, floors sit about 2 dB under what the encoders reach,
+// so that a regression in endpoint fitting or index assignment fails here instead of showing up as banding
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    // Gradient along the diagonal, channels ramp at different rates and directions but stay collinear inside a block,
+    // what a single subset endpoint line can represent, so error is down to endpoint and index precision
+    ImageMip make_ramp(uint32_t width, uint32_t height)
+    {
+        ImageMip image{ width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height * 4) };
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float t = static_cast<float>(x + y) / static_cast<float>(std::max(width + height - 2, 1u));
+                uint8_t* texel = image.pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                texel[0] = static_cast<uint8_t>(t * 255.0f + 0.5f);
+                texel[1] = static_cast<uint8_t>((1.0f - t) * 255.0f + 0.5f);
+                texel[2] = static_cast<uint8_t>((0.25f + 0.5f * t) * 255.0f + 0.5f);
+                texel[3] = static_cast<uint8_t>((1.0f - 0.75f * t) * 255.0f + 0.5f);
+            }
+        }
+        return image;
+    }
+
+    // Red along x, green along y, blue as their product, a block spans a plane in color space instead of a line,
+    // so single subset formats are bounded by the format rather than the encoder
+    ImageMip make_planar_gradient(uint32_t width, uint32_t height)
+    {
+        ImageMip image{ width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height * 4) };
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float u = static_cast<float>(x) / static_cast<float>(std::max(width - 1, 1u));
+                float v = static_cast<float>(y) / static_cast<float>(std::max(height - 1, 1u));
+                uint8_t* texel = image.pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                texel[0] = static_cast<uint8_t>(u * 255.0f + 0.5f);
+                texel[1] = static_cast<uint8_t>(v * 255.0f + 0.5f);
+                texel[2] = static_cast<uint8_t>((1.0f - u) * v * 255.0f + 0.5f);
+                texel[3] = static_cast<uint8_t>((u + v) * 0.5f * 255.0f + 0.5f);
+            }
+        }
+        return image;
+    }
+}
+
+TOY_TEST(BlockCompressionPsnr)
+{
+    struct FormatFloor
+    {
+        BlockFormat format;
+        std::string_view name;
+        double ramp_psnr;
+        double planar_psnr;
+    };
+    constexpr std::array<FormatFloor, 4> floors = { {
+        { BlockFormat::BC1, "BC1", 36.0, 30.0 },
+        { BlockFormat::BC3, "BC3", 37.0, 31.0 },
+        { BlockFormat::BC5, "BC5", 42.0, 44.0 },
+        { BlockFormat::BC7, "BC7", 50.0, 31.0 }
+    } };
+
+    // Whole blocks and partial blocks on the right and bottom edges
+    for (auto [width, height] : { std::pair(64u, 64u), std::pair(30u, 18u) })
+    {
+        for (bool is_planar : { false, true })
+        {
+            ImageMip image = is_planar ? make_planar_gradient(width, height) : make_ramp(width, height);
+            for (auto&& [format, name, ramp_psnr, planar_psnr] : floors)
+            {
+                auto blocks = compress_image(image, format);
+                TOY_REQUIRE(blocks.size() == get_compressed_byte_width(width, height, format));
+                ImageMip decoded = decompress_image(blocks, width, height, format);
+                TOY_REQUIRE(decoded.width == width && decoded.height == height && decoded.pixels.size() == image.pixels.size());
+
+                double psnr = compute_psnr(image, decoded, format);
+                double min_psnr = is_planar ? planar_psnr : ramp_psnr;
+                DX_INFO("{} {} x {} {}: {:.2f} dB, floor {:.1f} dB", name, width, height, is_planar ? "planar gradient" : "ramp", psnr, min_psnr);
+                TOY_CHECK(psnr >= min_psnr);
+            }
+        }
+    }
+}
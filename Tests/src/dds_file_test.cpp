@@ -0,0 +1,222 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/dds_file.h>
+#include <Toy/Core/mapped_file.h>
+
+// DDS headers are validated and subresources located in place, these checks run on every platform:
+// DX10 and legacy headers, arrays and cubes, spans pointing into the parsed bytes, malformed files rejected
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    // Legacy DDS_HEADER as dwords after the magic, see DirectX documentation
+    enum LegacyHeaderDword : uint32_t
+    {
+        Magic = 0,
+        Size = 1,
+        Height = 3,
+        Width = 4,
+        MipMapCount = 7,
+        PixelFormatSize = 19,
+        PixelFormatFlags = 20,
+        FourCC = 21,
+        RgbBitCount = 22,
+        RedMask = 23,
+        GreenMask = 24,
+        BlueMask = 25,
+        AlphaMask = 26,
+        Caps2 = 28,
+        LegacyHeaderDwordCount = 32
+    };
+
+    constexpr uint32_t make_fourcc(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    std::vector<uint8_t> make_legacy_dds(const std::array<uint32_t, LegacyHeaderDwordCount>& header, size_t data_byte_width)
+    {
+        std::vector<uint8_t> bytes(sizeof(header) + data_byte_width);
+        std::memcpy(bytes.data(), header.data(), sizeof(header));
+        for (size_t i = sizeof(header); i < bytes.size(); ++i)
+        {
+            bytes[i] = static_cast<uint8_t>(i * 7);
+        }
+        return bytes;
+    }
+
+    std::array<uint32_t, LegacyHeaderDwordCount> make_legacy_header(uint32_t width, uint32_t height, uint32_t mip_count)
+    {
+        std::array<uint32_t, LegacyHeaderDwordCount> header{};
+        header[Magic] = make_fourcc('D', 'D', 'S', ' ');
+        header[Size] = 124;
+        header[Width] = width;
+        header[Height] = height;
+        header[MipMapCount] = mip_count;
+        header[PixelFormatSize] = 32;
+        return header;
+    }
+
+    // Subresources follow one another without gap from the end of header, inside the parsed bytes
+    bool is_contiguous(const DdsView& view, std::span<const uint8_t> bytes, size_t data_offset)
+    {
+        const uint8_t* next = bytes.data() + data_offset;
+        for (auto&& subresource : view.subresources)
+        {
+            if (subresource.bytes.data() != next || subresource.bytes.size() != subresource.slice_pitch)
+            {
+                return false;
+            }
+            next += subresource.bytes.size();
+        }
+        return next <= bytes.data() + bytes.size();
+    }
+}
+
+TOY_TEST(DdsParse)
+{
+    auto dir = test::make_test_dir("DdsParse");
+
+    // DX10 header as written by texture caches, BC1 256 x 128 with full chain
+    DdsDesc desc{};
+    desc.format = DXGI_FORMAT_BC1_UNORM;
+    desc.width = 256;
+    desc.height = 128;
+    desc.mip_count = 9;
+    desc.pitch_or_linear_size = 64 * 32 * 8;
+    size_t data_byte_width = 0;
+    for (uint32_t mip = 0; mip < desc.mip_count; ++mip)
+    {
+        data_byte_width += static_cast<size_t>(std::max((desc.width >> mip) / 4, 1u)) * std::max((desc.height >> mip) / 4, 1u) * 8;
+    }
+    std::vector<uint8_t> data(data_byte_width);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    auto file_path = dir / "bc1.dds";
+    TOY_REQUIRE(write_dds_file(file_path, desc, data));
+
+    {
+        // Parsed straight from the mapping, nothing is copied
+        MappedFile file{ file_path };
+        TOY_REQUIRE(file.is_open());
+        auto view = parse_dds(file.bytes());
+        TOY_REQUIRE(view.has_value());
+        TOY_CHECK(view->desc.format == DXGI_FORMAT_BC1_UNORM);
+        TOY_CHECK(view->desc.width == 256 && view->desc.height == 128 && view->desc.mip_count == 9);
+        TOY_CHECK(view->desc.array_size == 1 && !view->desc.is_cube);
+        TOY_REQUIRE(view->subresources.size() == 9);
+        TOY_CHECK(is_contiguous(*view, file.bytes(), file.bytes().size() - data.size()));
+        TOY_CHECK(view->get_subresource(0).row_pitch == 64 * 8);
+        TOY_CHECK(view->get_subresource(0).slice_pitch == 64 * 32 * 8);
+        // 4 x 2 and smaller mips still take a whole block
+        TOY_CHECK(view->get_subresource(6).row_pitch == 8 && view->get_subresource(6).slice_pitch == 8);
+        TOY_CHECK(view->get_subresource(8).slice_pitch == 8);
+        TOY_CHECK(std::equal(data.begin(), data.end(), view->get_subresource(0).bytes.data()));
+        TOY_CHECK(get_block_byte_width(view->desc.format) == 8);
+    }
+
+    auto dds_file = read_dds_file(file_path);
+    TOY_REQUIRE(dds_file.has_value());
+    TOY_CHECK(dds_file->data == data);
+    TOY_CHECK(dds_file->desc.pitch_or_linear_size == desc.pitch_or_linear_size);
+
+    // Cube of RGBA8, subresources are mip chains of faces one after another
+    DdsDesc cube_desc{};
+    cube_desc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    cube_desc.width = 16;
+    cube_desc.height = 16;
+    cube_desc.mip_count = 5;
+    cube_desc.array_size = 6;
+    cube_desc.is_cube = true;
+    size_t face_byte_width = (16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1) * 4;
+    std::vector<uint8_t> cube_data(face_byte_width * 6, 0x5A);
+    TOY_REQUIRE(write_dds_file(dir / "cube.dds", cube_desc, cube_data));
+    {
+        MappedFile file{ dir / "cube.dds" };
+        auto view = parse_dds(file.bytes());
+        TOY_REQUIRE(view.has_value());
+        TOY_CHECK(view->desc.is_cube && view->desc.array_size == 6 && view->desc.mip_count == 5);
+        TOY_REQUIRE(view->subresources.size() == 30);
+        TOY_CHECK(is_contiguous(*view, file.bytes(), file.bytes().size() - cube_data.size()));
+        TOY_CHECK(view->get_subresource(2, 3).row_pitch == 4 * 4);
+        TOY_CHECK(view->get_subresource(2, 3).bytes.data() - view->get_subresource(0, 0).bytes.data() ==
+                  static_cast<ptrdiff_t>(3 * face_byte_width + (16 * 16 + 8 * 8) * 4));
+    }
+
+    // Legacy header of older tools, mip count 0 is a single level, trailing bytes are ignored
+    auto header = make_legacy_header(64, 32, 0);
+    header[PixelFormatFlags] = 0x4;
+    header[FourCC] = make_fourcc('D', 'X', 'T', '5');
+    auto legacy = make_legacy_dds(header, 16 * 8 * 16 + 100);
+    auto legacy_view = parse_dds(legacy);
+    TOY_REQUIRE(legacy_view.has_value());
+    TOY_CHECK(legacy_view->desc.format == DXGI_FORMAT_BC3_UNORM && legacy_view->desc.mip_count == 1);
+    TOY_REQUIRE(legacy_view->subresources.size() == 1);
+    TOY_CHECK(is_contiguous(*legacy_view, legacy, sizeof(header)));
+
+    header = make_legacy_header(8, 8, 4);
+    header[PixelFormatFlags] = 0x40 | 0x1;
+    header[RgbBitCount] = 32;
+    header[RedMask] = 0x00FF0000;
+    header[GreenMask] = 0x0000FF00;
+    header[BlueMask] = 0x000000FF;
+    header[AlphaMask] = 0xFF000000;
+    legacy = make_legacy_dds(header, (64 + 16 + 4 + 1) * 4);
+    legacy_view = parse_dds(legacy);
+    TOY_REQUIRE(legacy_view.has_value());
+    TOY_CHECK(legacy_view->desc.format == DXGI_FORMAT_B8G8R8A8_UNORM);
+    TOY_CHECK(is_contiguous(*legacy_view, legacy, sizeof(header)));
+}
+
+TOY_TEST(DdsReject)
+{
+    auto header = make_legacy_header(64, 64, 7);
+    header[PixelFormatFlags] = 0x4;
+    header[FourCC] = make_fourcc('D', 'X', 'T', '1');
+    size_t data_byte_width = (256 + 64 + 16 + 4 + 1 + 1 + 1) * 8;
+    TOY_REQUIRE(parse_dds(make_legacy_dds(header, data_byte_width)).has_value());
+
+    // Truncated data or header
+    TOY_CHECK(!parse_dds(make_legacy_dds(header, data_byte_width - 1)).has_value());
+    auto bytes = make_legacy_dds(header, 0);
+    TOY_CHECK(!parse_dds(std::span<const uint8_t>(bytes).first(100)).has_value());
+    TOY_CHECK(!parse_dds({}).has_value());
+
+    auto reject = [&](auto&& modify)
+    {
+        auto modified = header;
+        modify(modified);
+        return !parse_dds(make_legacy_dds(modified, data_byte_width)).has_value();
+    };
+    TOY_CHECK(reject([](auto&& h) { h[Magic] = make_fourcc('D', 'D', 'S', 'X'); }));
+    TOY_CHECK(reject([](auto&& h) { h[Size] = 128; }));
+    TOY_CHECK(reject([](auto&& h) { h[PixelFormatSize] = 0; }));
+    TOY_CHECK(reject([](auto&& h) { h[Width] = 0; }));
+    TOY_CHECK(reject([](auto&& h) { h[Width] = 32768; }));
+    // More mips than the chain of 64 x 64 has
+    TOY_CHECK(reject([](auto&& h) { h[MipMapCount] = 8; }));
+    TOY_CHECK(reject([](auto&& h) { h[FourCC] = make_fourcc('A', 'B', 'C', 'D'); }));
+    // Volume texture and cube missing faces
+    TOY_CHECK(reject([](auto&& h) { h[Caps2] = 0x200000; }));
+    TOY_CHECK(reject([](auto&& h) { h[Caps2] = 0x200 | 0x400; }));
+
+    // Array size past Direct3D limit is rejected before any size is computed
+    auto dir = test::make_test_dir("DdsReject");
+    DdsDesc desc{};
+    desc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.width = 4;
+    desc.height = 4;
+    desc.array_size = 4096;
+    TOY_REQUIRE(write_dds_file(dir / "array.dds", desc, std::vector<uint8_t>(64)));
+    MappedFile file{ dir / "array.dds" };
+    TOY_CHECK(!parse_dds(file.bytes()).has_value());
+    TOY_CHECK(!read_dds_file(dir / "missing.dds").has_value());
+}
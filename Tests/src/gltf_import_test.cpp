@@ -0,0 +1,236 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/gltf_import.h>
+#include <Toy/Model/mesh_codec.h>
+#include <Toy/Model/mesh_import.h>
+
+// Native glTF import must leave the same model as the Assimp path it replaces, see gltf_import.h
+// Both import a small file written here, a quad and a triangle with their own material, then meshes,
+// bounding boxes, triangles with their corners and diffuse colors are compared
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+    using namespace DirectX;
+
+    // Corner of triangle, position, normal and uv rounded so that float noise of both paths compares equal
+    using Corner = std::array<int64_t, 8>;
+    using Triangle = std::array<Corner, 3>;
+
+    constexpr float s_epsilon = 1.0e-4f;
+
+    Corner make_corner(const XMFLOAT3& position, const XMFLOAT3& normal, const XMFLOAT2& uv)
+    {
+        auto round = [](float value) { return static_cast<int64_t>(std::llround(value / s_epsilon)); };
+        return { round(position.x), round(position.y), round(position.z), round(normal.x), round(normal.y), round(normal.z),
+                 round(uv.x), round(uv.y) };
+    }
+
+    // Rotate smallest corner first, winding is kept, then sort, so that vertex and triangle order do not matter
+    void add_triangle(std::vector<Triangle>& triangles, const Corner& a, const Corner& b, const Corner& c)
+    {
+        Triangle triangle = { a, b, c };
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.emplace_back(triangle);
+    }
+
+    bool is_near(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return std::abs(a.x - b.x) <= s_epsilon && std::abs(a.y - b.y) <= s_epsilon && std::abs(a.z - b.z) <= s_epsilon;
+    }
+
+    bool is_near(const XMFLOAT4& a, const XMFLOAT4& b)
+    {
+        return std::abs(a.x - b.x) <= s_epsilon && std::abs(a.y - b.y) <= s_epsilon && std::abs(a.z - b.z) <= s_epsilon &&
+               std::abs(a.w - b.w) <= s_epsilon;
+    }
+
+    // Stream of cache image, decoded if mesh_codec encoded it
+    template<typename T>
+    std::vector<T> read_cache_stream(std::span<const uint8_t> image, const MeshCacheBlob& blob)
+    {
+        auto bytes = get_mesh_cache_blob<uint8_t>(image, blob);
+        std::vector<T> values(static_cast<size_t>((blob.decoded_byte_width ? blob.decoded_byte_width : blob.byte_width) / sizeof(T)));
+        if (blob.decoded_byte_width)
+        {
+            if (!decode_mesh_stream(bytes, { reinterpret_cast<uint8_t *>(values.data()), values.size() * sizeof(T) }))
+            {
+                values.clear();
+            }
+        } else
+        {
+            std::memcpy(values.data(), bytes.data(), values.size() * sizeof(T));
+        }
+        return values;
+    }
+
+    struct TestPrimitive
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT3> normals;
+        std::vector<XMFLOAT2> texcoords;
+        std::vector<uint16_t> indices;
+        XMFLOAT4 base_color;
+    };
+
+    // Right-handed glTF with one buffer file, every attribute has its own buffer view
+    void write_test_gltf(const std::filesystem::path& dir, std::span<const TestPrimitive> primitives)
+    {
+        std::vector<uint8_t> buffer{};
+        std::string buffer_views{}, accessors{}, meshes{}, materials{}, nodes{}, node_indices{};
+        uint32_t accessor_count = 0;
+        auto add_accessor = [&](const void* data, size_t count, size_t byte_width, uint32_t component_type, std::string_view type,
+                                uint32_t target, std::string_view bounds)
+        {
+            size_t offset = buffer.size();
+            auto bytes = static_cast<const uint8_t *>(data);
+            buffer.insert(buffer.end(), bytes, bytes + byte_width);
+            buffer.resize((buffer.size() + 3) & ~size_t{ 3 });
+            buffer_views += fmt::format("{}{{\"buffer\":0,\"byteOffset\":{},\"byteLength\":{},\"target\":{}}}",
+                                        accessor_count ? "," : "", offset, byte_width, target);
+            accessors += fmt::format("{}{{\"bufferView\":{},\"componentType\":{},\"count\":{},\"type\":\"{}\"{}}}",
+                                     accessor_count ? "," : "", accessor_count, component_type, count, type, bounds);
+            return accessor_count++;
+        };
+
+        for (size_t i = 0; i < primitives.size(); ++i)
+        {
+            auto&& primitive = primitives[i];
+            BoundingBox bounding_box{};
+            BoundingBox::CreateFromPoints(bounding_box, primitive.positions.size(), primitive.positions.data(), sizeof(XMFLOAT3));
+            XMFLOAT3 min{}, max{};
+            XMStoreFloat3(&min, XMVectorSubtract(XMLoadFloat3(&bounding_box.Center), XMLoadFloat3(&bounding_box.Extents)));
+            XMStoreFloat3(&max, XMVectorAdd(XMLoadFloat3(&bounding_box.Center), XMLoadFloat3(&bounding_box.Extents)));
+            std::string bounds = fmt::format(",\"min\":[{},{},{}],\"max\":[{},{},{}]", min.x, min.y, min.z, max.x, max.y, max.z);
+
+            size_t num_vertices = primitive.positions.size();
+            uint32_t position = add_accessor(primitive.positions.data(), num_vertices, num_vertices * sizeof(XMFLOAT3), 5126, "VEC3", 34962, bounds);
+            uint32_t normal = add_accessor(primitive.normals.data(), num_vertices, num_vertices * sizeof(XMFLOAT3), 5126, "VEC3", 34962, "");
+            uint32_t texcoord = add_accessor(primitive.texcoords.data(), num_vertices, num_vertices * sizeof(XMFLOAT2), 5126, "VEC2", 34962, "");
+            uint32_t index = add_accessor(primitive.indices.data(), primitive.indices.size(), primitive.indices.size() * sizeof(uint16_t),
+                                          5123, "SCALAR", 34963, "");
+
+            std::string_view separator = i ? "," : "";
+            meshes += fmt::format("{}{{\"primitives\":[{{\"attributes\":{{\"POSITION\":{},\"NORMAL\":{},\"TEXCOORD_0\":{}}},"
+                                  "\"indices\":{},\"material\":{}}}]}}", separator, position, normal, texcoord, index, i);
+            materials += fmt::format("{}{{\"pbrMetallicRoughness\":{{\"baseColorFactor\":[{},{},{},{}]}}}}", separator,
+                                     primitive.base_color.x, primitive.base_color.y, primitive.base_color.z, primitive.base_color.w);
+            nodes += fmt::format("{}{{\"mesh\":{}}}", separator, i);
+            node_indices += fmt::format("{}{}", separator, i);
+        }
+
+        std::string gltf = fmt::format("{{\"asset\":{{\"version\":\"2.0\"}},\"scene\":0,\"scenes\":[{{\"nodes\":[{}]}}],\"nodes\":[{}],"
+                                       "\"meshes\":[{}],\"materials\":[{}],\"buffers\":[{{\"uri\":\"test.bin\",\"byteLength\":{}}}],"
+                                       "\"bufferViews\":[{}],\"accessors\":[{}]}}",
+                                       node_indices, nodes, meshes, materials, buffer.size(), buffer_views, accessors);
+        TOY_CHECK(test::write_test_file(dir / "test.bin", buffer.data(), buffer.size()));
+        TOY_CHECK(test::write_test_file(dir / "test.gltf", gltf.data(), gltf.size()));
+    }
+}
+
+TOY_TEST(GltfImport)
+{
+    // Quad facing +z and a tilted triangle, uvs are distinct per corner so that a flip of either path shows
+    std::vector<TestPrimitive> primitives = {
+        {
+            { { -1.0f, -1.0f, 0.5f }, { 1.0f, -1.0f, 0.5f }, { 1.0f, 1.0f, 0.5f }, { -1.0f, 1.0f, 0.5f } },
+            { { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+            { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f } },
+            { 0, 1, 2, 0, 2, 3 },
+            { 0.9f, 0.2f, 0.1f, 1.0f }
+        },
+        {
+            { { 2.0f, 0.0f, -1.0f }, { 3.0f, 0.0f, -2.0f }, { 2.5f, 1.5f, -1.5f } },
+            { { 0.6f, 0.0f, 0.8f }, { 0.6f, 0.0f, 0.8f }, { 0.6f, 0.0f, 0.8f } },
+            { { 0.25f, 0.75f }, { 0.75f, 0.75f }, { 0.5f, 0.125f } },
+            { 0, 1, 2 },
+            { 0.1f, 0.3f, 0.7f, 0.5f }
+        }
+    };
+    auto dir = test::make_test_dir("GltfImport");
+    write_test_gltf(dir, primitives);
+    std::string file_name = (dir / "test.gltf").string();
+
+    GltfModel gltf_model{};
+    TOY_REQUIRE(import_gltf(file_name, gltf_model));
+    auto image = import_model(file_name, import_cache_key(file_name, VertexEncoding::Full), VertexEncoding::Full);
+    TOY_REQUIRE(image.size() >= sizeof(MeshCacheHeader));
+    MeshCacheHeader header{};
+    std::memcpy(&header, image.data(), sizeof(MeshCacheHeader));
+    auto cached_meshes = get_mesh_cache_blob<MeshCacheMesh>(image, header.meshes);
+    auto cached_materials = get_mesh_cache_blob<MeshCacheMaterial>(image, header.materials);
+
+    TOY_REQUIRE(gltf_model.meshes.size() == primitives.size());
+    TOY_REQUIRE(cached_meshes.size() == gltf_model.meshes.size());
+    // Assimp appends its default material even if every primitive has one, native import only when one is missing
+    TOY_CHECK(gltf_model.materials.size() <= cached_materials.size());
+    TOY_CHECK(is_near(gltf_model.bounding_box.Center, header.bounding_box.Center));
+    TOY_CHECK(is_near(gltf_model.bounding_box.Extents, header.bounding_box.Extents));
+
+    // Assimp keeps glTF mesh order, one mesh per primitive
+    for (size_t i = 0; i < cached_meshes.size(); ++i)
+    {
+        auto&& gltf_mesh = gltf_model.meshes[i];
+        auto&& cached_mesh = cached_meshes[i];
+        TOY_CHECK(gltf_mesh.indices.size() == cached_mesh.index_count);
+        TOY_CHECK(gltf_mesh.texcoords.size() == cached_mesh.texcoord_count);
+        TOY_CHECK(is_near(gltf_mesh.bounding_box.Center, cached_mesh.bounding_box.Center));
+        TOY_CHECK(is_near(gltf_mesh.bounding_box.Extents, cached_mesh.bounding_box.Extents));
+        TOY_REQUIRE(cached_mesh.vertex_encoding == static_cast<uint32_t>(VertexEncoding::Full));
+        TOY_REQUIRE(!gltf_mesh.normals.empty() && !gltf_mesh.texcoords.empty() && cached_mesh.texcoord_count > 0);
+
+        std::vector<Triangle> gltf_triangles{};
+        auto gltf_corner = [&gltf_mesh](uint32_t index)
+        {
+            return make_corner(gltf_mesh.positions[index], gltf_mesh.normals[index], gltf_mesh.texcoords[0][index]);
+        };
+        for (size_t j = 0; j + 2 < gltf_mesh.indices.size(); j += 3)
+        {
+            add_triangle(gltf_triangles, gltf_corner(gltf_mesh.indices[j]), gltf_corner(gltf_mesh.indices[j + 1]),
+                         gltf_corner(gltf_mesh.indices[j + 2]));
+        }
+
+        auto positions = read_cache_stream<XMFLOAT3>(image, cached_mesh.positions);
+        auto normals = read_cache_stream<XMFLOAT3>(image, cached_mesh.normals);
+        auto texcoords = read_cache_stream<XMFLOAT2>(image, cached_mesh.texcoords[0]);
+        std::vector<uint32_t> indices{};
+        if (cached_mesh.index_stride == sizeof(uint16_t))
+        {
+            auto indices16 = read_cache_stream<uint16_t>(image, cached_mesh.indices);
+            indices.assign(indices16.begin(), indices16.end());
+        } else
+        {
+            indices = read_cache_stream<uint32_t>(image, cached_mesh.indices);
+        }
+        TOY_REQUIRE(positions.size() == cached_mesh.vertex_count && normals.size() == cached_mesh.vertex_count &&
+                    texcoords.size() == cached_mesh.vertex_count && indices.size() == cached_mesh.index_count);
+        TOY_REQUIRE(std::all_of(indices.begin(), indices.end(), [&cached_mesh](uint32_t index) { return index < cached_mesh.vertex_count; }));
+
+        std::vector<Triangle> assimp_triangles{};
+        auto assimp_corner = [&](uint32_t index) { return make_corner(positions[index], normals[index], texcoords[index]); };
+        for (size_t j = 0; j + 2 < indices.size(); j += 3)
+        {
+            add_triangle(assimp_triangles, assimp_corner(indices[j]), assimp_corner(indices[j + 1]), assimp_corner(indices[j + 2]));
+        }
+
+        std::sort(gltf_triangles.begin(), gltf_triangles.end());
+        std::sort(assimp_triangles.begin(), assimp_triangles.end());
+        TOY_CHECK(gltf_triangles == assimp_triangles);
+
+        // Base color factor is what Assimp exposes as diffuse color
+        TOY_REQUIRE(gltf_mesh.material_index == cached_mesh.material_index);
+        TOY_REQUIRE(gltf_mesh.material_index < gltf_model.materials.size() && cached_mesh.material_index < cached_materials.size());
+        auto&& gltf_material = gltf_model.materials[gltf_mesh.material_index];
+        auto&& cached_material = cached_materials[cached_mesh.material_index];
+        uint32_t diffuse_slot = static_cast<uint32_t>(MaterialSemantics::DiffuseColor) - material_texture_count;
+        TOY_CHECK(gltf_material.has(MaterialSemantics::DiffuseColor));
+        TOY_CHECK((cached_material.presence_mask >> static_cast<uint32_t>(MaterialSemantics::DiffuseColor)) & 1u);
+        TOY_CHECK(is_near(gltf_material.get_color(MaterialSemantics::DiffuseColor), cached_material.colors[diffuse_slot]));
+        TOY_CHECK(is_near(gltf_material.get_color(MaterialSemantics::DiffuseColor), primitives[i].base_color));
+    }
+}
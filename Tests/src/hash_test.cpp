@@ -0,0 +1,32 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Core/hash.h>
+
+// Cache keys are built from path IDs, so a path must hash alike however it is spelled and on every platform
+
+namespace
+{
+    using namespace toy;
+}
+
+TOY_TEST(PathToId)
+{
+    XID id = path_to_id("a/b.obj");
+    TOY_CHECK(path_to_id("a\\b.obj") == id);
+    TOY_CHECK(path_to_id("a/./b.obj") == id);
+    TOY_CHECK(path_to_id("a\\.\\b.obj") == id);
+    TOY_CHECK(path_to_id("a//b.obj") == id);
+    TOY_CHECK(path_to_id("a/c/../b.obj") == id);
+    TOY_CHECK(path_to_id("a\\c\\..\\b.obj") == id);
+    TOY_CHECK(path_to_id("./a/b.obj") == id);
+    TOY_CHECK(path_to_id("data\\models\\Sponza\\sponza.obj") == path_to_id("data/models/Sponza/sponza.obj"));
+
+    // Case and extension are part of the path
+    TOY_CHECK(path_to_id("a/B.obj") != id);
+    TOY_CHECK(path_to_id("a/b.gltf") != id);
+    TOY_CHECK(path_to_id("b/b.obj") != id);
+}
@@ -0,0 +1,221 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/hdr_image.h>
+
+// Radiance images written here, flat and run length encoded, must decode to RGBA16F and RGB9E5
+// within the precision of those formats against the exact RGBE values
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+    using namespace DirectX;
+
+    using Rgbe = std::array<uint8_t, 4>;
+
+    Rgbe encode_rgbe(const XMFLOAT3& color)
+    {
+        float max_component = std::max({ color.x, color.y, color.z });
+        if (max_component < 1.0e-32f)
+        {
+            return { 0, 0, 0, 0 };
+        }
+        int exponent = 0;
+        float scale = std::frexp(max_component, &exponent) * 256.0f / max_component;
+        return { static_cast<uint8_t>(color.x * scale), static_cast<uint8_t>(color.y * scale), static_cast<uint8_t>(color.z * scale),
+                 static_cast<uint8_t>(exponent + 128) };
+    }
+
+    // Exact value of RGBE texel, what the decoder has to approximate
+    XMFLOAT3 decode_rgbe(const Rgbe& rgbe)
+    {
+        if (rgbe[3] == 0)
+        {
+            return { 0.0f, 0.0f, 0.0f };
+        }
+        float scale = std::ldexp(1.0f, rgbe[3] - (128 + 8));
+        return { rgbe[0] * scale, rgbe[1] * scale, rgbe[2] * scale };
+    }
+
+    // Runs of 3 or more equal bytes are encoded as runs, the rest as literals
+    void append_rle_component(std::vector<uint8_t>& output, const std::vector<Rgbe>& scanline, uint32_t component)
+    {
+        size_t x = 0;
+        while (x < scanline.size())
+        {
+            size_t run = 1;
+            while (x + run < scanline.size() && run < 127 && scanline[x + run][component] == scanline[x][component])
+            {
+                run++;
+            }
+            if (run >= 3)
+            {
+                output.push_back(static_cast<uint8_t>(128 + run));
+                output.push_back(scanline[x][component]);
+                x += run;
+                continue;
+            }
+
+            size_t literal = 0;
+            while (x + literal < scanline.size() && literal < 128 &&
+                   !(x + literal + 2 < scanline.size() && scanline[x + literal][component] == scanline[x + literal + 1][component] &&
+                     scanline[x + literal][component] == scanline[x + literal + 2][component]))
+            {
+                literal++;
+            }
+            literal = std::max<size_t>(literal, 1);
+            output.push_back(static_cast<uint8_t>(literal));
+            for (size_t i = 0; i < literal; ++i)
+            {
+                output.push_back(scanline[x + i][component]);
+            }
+            x += literal;
+        }
+    }
+
+    std::vector<uint8_t> write_radiance(const std::vector<std::vector<Rgbe>>& rows, bool is_rle, std::string_view orientation = "-Y")
+    {
+        auto width = static_cast<uint32_t>(rows.front().size());
+        std::string header = fmt::format("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\nEXPOSURE=1.0\n\n{} {} +X {}\n", orientation, rows.size(), width);
+        std::vector<uint8_t> output(header.begin(), header.end());
+        for (auto&& row : rows)
+        {
+            if (is_rle)
+            {
+                output.insert(output.end(), { 2, 2, static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width & 0xff) });
+                for (uint32_t component = 0; component < 4; ++component)
+                {
+                    append_rle_component(output, row, component);
+                }
+            } else
+            {
+                for (auto&& rgbe : row)
+                {
+                    output.insert(output.end(), rgbe.begin(), rgbe.end());
+                }
+            }
+        }
+        return output;
+    }
+
+    // Dynamic range from 2^-10 to 2^14, flat spans for runs, black and saturated texels
+    std::vector<std::vector<Rgbe>> make_environment(uint32_t width, uint32_t height)
+    {
+        std::vector<std::vector<Rgbe>> rows(height);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float t = static_cast<float>(x) / static_cast<float>(width - 1);
+                XMFLOAT3 color{ std::exp2(-10.0f + 24.0f * t), std::exp2(4.0f - 8.0f * t) * (1.0f + 0.1f * y), 0.75f };
+                if (x % 11 < 4)
+                {
+                    color = { 2.0f, 1.0f, 0.5f };
+                } else if (x % 13 == 0)
+                {
+                    color = { 0.0f, 0.0f, 0.0f };
+                }
+                rows[y].push_back(encode_rgbe(color));
+            }
+        }
+        return rows;
+    }
+
+    XMFLOAT4 load_texel(const HdrImage& image, size_t index)
+    {
+        XMFLOAT4 texel{};
+        if (image.format == HdrFormat::RGBA16F)
+        {
+            XMStoreFloat4(&texel, PackedVector::XMLoadHalf4(reinterpret_cast<const PackedVector::XMHALF4 *>(image.pixels.data()) + index));
+        } else
+        {
+            XMStoreFloat4(&texel, PackedVector::XMLoadFloat3SE(reinterpret_cast<const PackedVector::XMFLOAT3SE *>(image.pixels.data()) + index));
+        }
+        return texel;
+    }
+
+    // Largest error relative to the bound of format, half float rounds each component, shared exponent rounds to the largest
+    // 8-bit RGBE mantissas fit both formats, so a correct decode stays well below 1
+    float measure_relative_error(const std::vector<std::vector<Rgbe>>& rows, const HdrImage& image)
+    {
+        float max_error = 0.0f;
+        for (size_t y = 0; y < rows.size(); ++y)
+        {
+            for (size_t x = 0; x < rows[y].size(); ++x)
+            {
+                XMFLOAT3 expected = decode_rgbe(rows[y][x]);
+                XMFLOAT4 texel = load_texel(image, y * image.width + x);
+                float max_component = std::max({ expected.x, expected.y, expected.z });
+                std::array<std::pair<float, float>, 3> components = { { { expected.x, texel.x }, { expected.y, texel.y }, { expected.z, texel.z } } };
+                for (auto [value, decoded] : components)
+                {
+                    float bound = image.format == HdrFormat::RGBA16F ? value / 2048.0f + 1.0e-7f : max_component / 256.0f + 1.0e-7f;
+                    max_error = std::max(max_error, std::abs(decoded - value) / bound);
+                }
+                if (image.format == HdrFormat::RGBA16F && texel.w != 1.0f)
+                {
+                    max_error = std::numeric_limits<float>::max();
+                }
+            }
+        }
+        return max_error;
+    }
+}
+
+TOY_TEST(HdrImageRoundTrip)
+{
+    // 37 is run length encoded, 5 is below the minimal width of encoded scanlines
+    for (uint32_t width : { 37u, 5u })
+    {
+        auto rows = make_environment(width, 6);
+        for (bool is_rle : { true, false })
+        {
+            if (is_rle && width < 8)
+            {
+                continue;
+            }
+            auto data = write_radiance(rows, is_rle);
+            TOY_CHECK(is_radiance_image(data));
+            for (HdrFormat format : { HdrFormat::RGBA16F, HdrFormat::RGB9E5 })
+            {
+                auto image = decode_hdr_image(data, format);
+                TOY_REQUIRE(image.has_value());
+                TOY_CHECK(image->format == format);
+                TOY_CHECK(image->width == width && image->height == rows.size());
+                // 8 or 4 bytes per texel instead of 16 of float RGBA
+                TOY_CHECK(image->pixels.size() == static_cast<size_t>(width) * rows.size() * get_texel_byte_width(format));
+                float error = measure_relative_error(rows, *image);
+                DX_INFO("Width {}, {}, format {}: max error {:.3f} of bound", width, is_rle ? "rle" : "flat",
+                        format == HdrFormat::RGBA16F ? "RGBA16F" : "RGB9E5", error);
+                TOY_CHECK(error <= 1.0f);
+            }
+        }
+    }
+    TOY_CHECK(get_dxgi_format(HdrFormat::RGBA16F) == DXGI_FORMAT_R16G16B16A16_FLOAT);
+    TOY_CHECK(get_dxgi_format(HdrFormat::RGB9E5) == DXGI_FORMAT_R9G9B9E5_SHAREDEXP);
+}
+
+TOY_TEST(HdrImageRejects)
+{
+    auto rows = make_environment(37, 4);
+    auto data = write_radiance(rows, true);
+
+    // Truncated scanline, unsupported orientation, missing signature
+    std::vector<uint8_t> truncated(data.begin(), data.end() - 10);
+    TOY_CHECK(!decode_hdr_image(truncated, HdrFormat::RGBA16F).has_value());
+    TOY_CHECK(!decode_hdr_image(write_radiance(rows, true, "+Y"), HdrFormat::RGBA16F).has_value());
+    std::vector<uint8_t> unsigned_data(data.begin() + 11, data.end());
+    TOY_CHECK(!is_radiance_image(unsigned_data));
+    TOY_CHECK(!decode_hdr_image(unsigned_data, HdrFormat::RGB9E5).has_value());
+    TOY_CHECK(!decode_hdr_image({}, HdrFormat::RGB9E5).has_value());
+
+    // Run past the end of scanline, first count byte follows header and scanline marker
+    auto corrupted = data;
+    size_t first_scanline = std::string_view("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\nEXPOSURE=1.0\n\n-Y 4 +X 37\n").size();
+    corrupted[first_scanline + 4] = 128 + 100;
+    TOY_CHECK(!decode_hdr_image(corrupted, HdrFormat::RGBA16F).has_value());
+}
@@ -0,0 +1,54 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+// CPU tests of the asset library, no device is created, every test case is also a ctest entry
+//   ToyTests [name...]
+// Run named test cases, or all of them without arguments, exit code is the number of failed test cases
+
+int main(int argc, char** argv)
+{
+    using namespace toy::test;
+
+    std::vector<std::string_view> names(argv + 1, argv + argc);
+    auto&& test_cases = get_test_cases();
+    for (auto&& name : names)
+    {
+        if (std::none_of(test_cases.begin(), test_cases.end(), [name](const TestCase& test_case) { return test_case.name == name; }))
+        {
+            DX_ERROR("Unknown test case '{}'", name);
+            return 1;
+        }
+    }
+
+    int failed_count = 0;
+    for (auto&& test_case : test_cases)
+    {
+        if (!names.empty() && std::find(names.begin(), names.end(), test_case.name) == names.end())
+        {
+            continue;
+        }
+
+        get_failure_count() = 0;
+        try
+        {
+            test_case.func();
+        } catch (const std::exception& e)
+        {
+            ++get_failure_count();
+            DX_ERROR("Test case '{}' threw: {}", test_case.name, e.what());
+        }
+
+        if (get_failure_count() == 0)
+        {
+            DX_INFO("[PASS] {}", test_case.name);
+        } else
+        {
+            DX_ERROR("[FAIL] {}, {} failed checks", test_case.name, get_failure_count());
+            ++failed_count;
+        }
+    }
+    return failed_count;
+}
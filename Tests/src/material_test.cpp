@@ -0,0 +1,257 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Core/json.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Model/material.h>
+
+// Fixed layout material against the property map it replaced, over the materials of Sponza
+// Every material is filled as model loading fills it, once into Material and once into a map of named properties
+// with texture paths as strings, heap of the map is counted by its allocator. Binding reads what set_material of
+// DeferredPBREffect reads, by name from the map as before, or baked constants and texture handles now, both must agree
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    // Counts bytes held by containers using it, shared by copies and rebinds
+    template <typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        explicit CountingAllocator(size_t* byte_count) : byte_count(byte_count) {}
+        template <typename U>
+        CountingAllocator(const CountingAllocator<U>& other) : byte_count(other.byte_count) {}
+
+        T* allocate(size_t n)
+        {
+            *byte_count += n * sizeof(T);
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            *byte_count -= n * sizeof(T);
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template <typename U>
+        bool operator==(const CountingAllocator<U>& other) const { return byte_count == other.byte_count; }
+
+        size_t* byte_count;
+    };
+
+    using PropertyMap = std::unordered_map<XID, Property, std::hash<XID>, std::equal_to<>, CountingAllocator<std::pair<const XID, Property>>>;
+
+    // Property map with its own byte count, heap of string values is added, as their allocator is not the map's
+    struct LegacyMaterial
+    {
+        size_t byte_count = 0;
+        PropertyMap properties{ PropertyMap::allocator_type(&byte_count) };
+
+        template <typename T>
+        void set(MaterialSemantics semantics, const T& value)
+        {
+            properties[string_to_id(material_semantics_name(semantics))] = value;
+        }
+
+        template <typename T>
+        const T* try_get(MaterialSemantics semantics) const
+        {
+            auto it = properties.find(string_to_id(material_semantics_name(semantics)));
+            return it != properties.end() ? std::get_if<T>(&it->second) : nullptr;
+        }
+
+        [[nodiscard]] size_t get_heap_byte_width() const
+        {
+            size_t string_byte_width = 0;
+            for (auto&& [id, property] : properties)
+            {
+                auto value = std::get_if<std::string>(&property);
+                string_byte_width += value && value->capacity() > std::string().capacity() ? value->capacity() + 1 : 0;
+            }
+            return byte_count + string_byte_width;
+        }
+    };
+
+    // What set_material binds: 4 textures, 0 for the null texture, and material constants
+    struct BoundMaterial
+    {
+        std::array<XID, 4> textures{};
+        MaterialConstants constants{};
+    };
+
+    constexpr std::array<MaterialSemantics, 4> s_bound_maps = {
+        MaterialSemantics::DiffuseMap, MaterialSemantics::NormalMap, MaterialSemantics::MetalnessMap, MaterialSemantics::RoughnessMap
+    };
+
+    // Old set_material, name of every semantics is hashed and looked up, texture name is hashed again by texture manager
+    BoundMaterial bind_legacy(const LegacyMaterial& material)
+    {
+        BoundMaterial bound{};
+        auto color = [&material](MaterialSemantics semantics)
+        {
+            auto value = material.try_get<DirectX::XMFLOAT4>(semantics);
+            return value ? *value : DirectX::XMFLOAT4{};
+        };
+        auto scalar = [&material](MaterialSemantics semantics)
+        {
+            auto value = material.try_get<float>(semantics);
+            return value ? *value : 0.0f;
+        };
+        std::array<uint32_t*, 4> no_srv = { &bound.constants.no_diffuse_srv, &bound.constants.no_normal_srv,
+                                            &bound.constants.no_metalness_srv, &bound.constants.no_roughness_srv };
+        for (size_t i = 0; i < s_bound_maps.size(); ++i)
+        {
+            auto texture_name = material.try_get<std::string>(s_bound_maps[i]);
+            bound.textures[i] = texture_name ? string_to_id(*texture_name) : 0;
+            *no_srv[i] = texture_name ? 0 : 1;
+        }
+        DirectX::XMFLOAT4 specular_color = color(MaterialSemantics::SpecularColor);
+        bound.constants.base_color_opacity = color(MaterialSemantics::DiffuseColor);
+        bound.constants.specular_anisotropic = DirectX::XMFLOAT4{ specular_color.x, specular_color.y, specular_color.z, 0.0f };
+        bound.constants.metalness = scalar(MaterialSemantics::Metalness);
+        bound.constants.roughness = scalar(MaterialSemantics::Roughness);
+        return bound;
+    }
+
+    BoundMaterial bind_fixed(const Material& material)
+    {
+        BoundMaterial bound{};
+        bound.constants = material.get_constants();
+        for (size_t i = 0; i < s_bound_maps.size(); ++i)
+        {
+            bound.textures[i] = material.get_texture(s_bound_maps[i]);
+        }
+        return bound;
+    }
+
+    // Properties model loading sets from a glTF material through Assimp: colors, factors and texture paths
+    void load_sponza_materials(std::vector<Material>& materials, std::deque<LegacyMaterial>& legacy_materials)
+    {
+        using namespace DirectX;
+        const std::filesystem::path gltf_path(DXTOY_HOME "data/models/SponzaPBR/Sponza.gltf");
+        MappedFile file(gltf_path);
+        json::Value root{};
+        if (!file.is_open() || !json::parse(std::string_view(reinterpret_cast<const char*>(file.data()), file.size()), root))
+        {
+            return;
+        }
+
+        for (auto&& gltf_material : root["materials"].array())
+        {
+            auto&& pbr = gltf_material["pbrMetallicRoughness"];
+            auto&& base_color = pbr["baseColorFactor"];
+            XMFLOAT4 diffuse_color{ base_color[0].as_float(1.0f), base_color[1].as_float(1.0f), base_color[2].as_float(1.0f),
+                                    base_color[3].as_float(1.0f) };
+            auto&& emissive = gltf_material["emissiveFactor"];
+            XMFLOAT4 emissive_color{ emissive[0].as_float(), emissive[1].as_float(), emissive[2].as_float(), 1.0f };
+
+            Material& material = materials.emplace_back();
+            LegacyMaterial& legacy = legacy_materials.emplace_back();
+            auto set_color = [&material, &legacy](MaterialSemantics semantics, const XMFLOAT4& color)
+            {
+                material.set_color(semantics, color);
+                legacy.set(semantics, color);
+            };
+            auto set_scalar = [&material, &legacy](MaterialSemantics semantics, float value)
+            {
+                material.set_scalar(semantics, value);
+                legacy.set(semantics, value);
+            };
+            auto set_texture = [&root, &gltf_path, &material, &legacy](const json::Value& texture_info, MaterialSemantics semantics)
+            {
+                auto&& texture = root["textures"][static_cast<size_t>(texture_info["index"].as_integer(-1))];
+                auto&& image = root["images"][static_cast<size_t>(texture["source"].as_integer(-1))];
+                if (image.is_object())
+                {
+                    std::string tex_name = (gltf_path.parent_path() / image["uri"].as_string()).string();
+                    material.set_texture(semantics, string_to_id(tex_name));
+                    legacy.set(semantics, tex_name);
+                }
+            };
+
+            set_color(MaterialSemantics::AmbientColor, XMFLOAT4{ 0.0f, 0.0f, 0.0f, 1.0f });
+            set_color(MaterialSemantics::DiffuseColor, diffuse_color);
+            set_color(MaterialSemantics::SpecularColor, XMFLOAT4{ 0.0f, 0.0f, 0.0f, 1.0f });
+            set_scalar(MaterialSemantics::SpecularFactor, 1.0f);
+            set_scalar(MaterialSemantics::Opacity, diffuse_color.w);
+            set_scalar(MaterialSemantics::Metalness, pbr["metallicFactor"].as_float(0.5f));
+            set_scalar(MaterialSemantics::Roughness, pbr["roughnessFactor"].as_float(0.5f));
+            set_texture(pbr["baseColorTexture"], MaterialSemantics::DiffuseMap);
+            set_texture(pbr["baseColorTexture"], MaterialSemantics::AlbedoMap);
+            set_texture(gltf_material["normalTexture"], MaterialSemantics::NormalMap);
+            set_texture(pbr["metallicRoughnessTexture"], MaterialSemantics::MetalnessMap);
+            set_texture(pbr["metallicRoughnessTexture"], MaterialSemantics::RoughnessMap);
+
+            // Extension property, kept by both
+            material.set("$EmissiveColor"_xid, emissive_color);
+            legacy.properties["$EmissiveColor"_xid] = emissive_color;
+            material.bake();
+        }
+    }
+
+    double milliseconds_since(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    }
+}
+
+TOY_TEST(MaterialSponzaLayout)
+{
+    std::vector<Material> materials{};
+    std::deque<LegacyMaterial> legacy_materials{};
+    load_sponza_materials(materials, legacy_materials);
+    TOY_REQUIRE(!materials.empty() && materials.size() == legacy_materials.size());
+
+    // Footprint, extension properties of Material are counted as a map of their own
+    size_t legacy_byte_width = 0, fixed_byte_width = 0, property_count = 0;
+    for (size_t i = 0; i < materials.size(); ++i)
+    {
+        LegacyMaterial extensions{};
+        extensions.properties["$EmissiveColor"_xid] = DirectX::XMFLOAT4{};
+        fixed_byte_width += sizeof(Material) + extensions.get_heap_byte_width();
+        legacy_byte_width += sizeof(legacy_materials[i].properties) + legacy_materials[i].get_heap_byte_width();
+        property_count += legacy_materials[i].properties.size();
+    }
+    DX_INFO("Sponza {} materials, {:.1f} properties each: property map {:.0f} bytes per material, fixed layout {:.0f} bytes, "
+            "sizeof(Material) {}", materials.size(), static_cast<double>(property_count) / materials.size(),
+            static_cast<double>(legacy_byte_width) / materials.size(), static_cast<double>(fixed_byte_width) / materials.size(), sizeof(Material));
+    TOY_CHECK(fixed_byte_width < legacy_byte_width);
+
+    // Both bind the same textures and constants
+    for (size_t i = 0; i < materials.size(); ++i)
+    {
+        BoundMaterial legacy = bind_legacy(legacy_materials[i]);
+        BoundMaterial fixed = bind_fixed(materials[i]);
+        TOY_CHECK(legacy.textures == fixed.textures);
+        TOY_CHECK(std::memcmp(&legacy.constants, &fixed.constants, sizeof(MaterialConstants)) == 0);
+    }
+
+    // Bind every material as a frame draws them, result is folded so that no bind is optimized away
+    constexpr uint32_t frame_count = 20000;
+    double times[2]{};
+    uint64_t checksums[2]{};
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            for (size_t i = 0; i < materials.size(); ++i)
+            {
+                BoundMaterial bound = pass == 0 ? bind_legacy(legacy_materials[i]) : bind_fixed(materials[i]);
+                checksums[pass] += bound.textures[0] ^ bound.textures[1] ^ bound.constants.no_metalness_srv;
+            }
+        }
+        times[pass] = milliseconds_since(start_time);
+    }
+    TOY_CHECK(checksums[0] == checksums[1]);
+    double bind_count = static_cast<double>(frame_count) * materials.size();
+    DX_INFO("Bind: property map {:.1f} ns, fixed layout {:.1f} ns per material, {:.1f}x", times[0] * 1.0e6 / bind_count,
+            times[1] * 1.0e6 / bind_count, times[1] > 0.0 ? times[0] / times[1] : 0.0);
+}
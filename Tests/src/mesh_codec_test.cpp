@@ -0,0 +1,255 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/mesh_codec.h>
+#include <Toy/Model/mesh_cache.h>
+
+// Mesh streams must decode to exactly the bytes encoded, whatever their content, stride or count,
+// and malformed or truncated streams must be rejected rather than decoded
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    std::vector<uint8_t> decode(std::span<const uint8_t> encoded)
+    {
+        std::vector<uint8_t> decoded(get_decoded_byte_width(encoded));
+        if (!decode_mesh_stream(encoded, decoded))
+        {
+            decoded.clear();
+        }
+        return decoded;
+    }
+
+    template<typename T>
+    bool round_trip_indices(const std::vector<T>& indices, size_t& encoded_byte_width)
+    {
+        auto encoded = encode_index_buffer(indices.data(), indices.size(), sizeof(T));
+        encoded_byte_width = encoded.size();
+        auto decoded = decode(encoded);
+        return !encoded.empty() && decoded.size() == indices.size() * sizeof(T) &&
+               std::memcmp(decoded.data(), indices.data(), decoded.size()) == 0;
+    }
+
+    bool round_trip_vertices(const std::vector<uint8_t>& vertices, uint32_t vertex_stride, size_t& encoded_byte_width)
+    {
+        auto encoded = encode_vertex_stream(vertices.data(), vertices.size() / vertex_stride, vertex_stride);
+        encoded_byte_width = encoded.size();
+        return !encoded.empty() && decode(encoded) == vertices;
+    }
+
+    // Triangle list of a size x size vertex grid, rows of quads as optimize_mesh leaves a regular mesh
+    std::vector<uint32_t> make_grid_indices(uint32_t size)
+    {
+        std::vector<uint32_t> indices{};
+        for (uint32_t row = 0; row + 1 < size; ++row)
+        {
+            for (uint32_t col = 0; col + 1 < size; ++col)
+            {
+                uint32_t i = row * size + col;
+                indices.insert(indices.end(), { i, i + size, i + 1, i + 1, i + size, i + size + 1 });
+            }
+        }
+        return indices;
+    }
+
+    // Vertex stream with smooth floats, counters, constants and noise, so that every bit width of byte planes is used
+    std::vector<uint8_t> make_vertices(size_t vertex_count, uint32_t vertex_stride, std::mt19937& random)
+    {
+        std::vector<uint8_t> vertices(vertex_count * vertex_stride);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            for (uint32_t k = 0; k < vertex_stride; k += 4)
+            {
+                uint32_t value = 0;
+                switch (k / 4 % 4)
+                {
+                    case 0:
+                    {
+                        float smooth = std::sin(0.01f * static_cast<float>(i) + static_cast<float>(k));
+                        std::memcpy(&value, &smooth, sizeof(value));
+                        break;
+                    }
+                    case 1: value = static_cast<uint32_t>(i * 3); break;
+                    case 2: value = 0x3F800000; break;
+                    default: value = random(); break;
+                }
+                std::memcpy(vertices.data() + i * vertex_stride + k, &value, sizeof(value));
+            }
+        }
+        return vertices;
+    }
+}
+
+TOY_TEST(MeshCodecIndices)
+{
+    size_t encoded_byte_width = 0;
+
+    // Regular grid in both index widths, about 2 bytes per triangle
+    auto grid = make_grid_indices(200);
+    TOY_CHECK(round_trip_indices(grid, encoded_byte_width));
+    DX_INFO("Grid of {} triangles: {} bytes encoded, {:.2f} bytes per triangle", grid.size() / 3, encoded_byte_width,
+            static_cast<double>(encoded_byte_width) / static_cast<double>(grid.size() / 3));
+    TOY_CHECK(encoded_byte_width < grid.size() / 3 * 3);
+    std::vector<uint16_t> grid16(grid.begin(), grid.end());
+    TOY_CHECK(round_trip_indices(grid16, encoded_byte_width));
+
+    // Random triangles, degenerate triangles, repeated triangles and indices beyond 16 bits
+    std::mt19937 random(7);
+    std::vector<uint32_t> scattered(3000);
+    for (auto&& index : scattered)
+    {
+        index = random() % 100000;
+    }
+    scattered.insert(scattered.end(), { 5, 5, 5, 1, 2, 1, 0, 0, 1, 0xFFFFFFFF, 0, 0x7FFFFFFF, 9, 8, 7, 9, 8, 7 });
+    TOY_CHECK(round_trip_indices(scattered, encoded_byte_width));
+    std::vector<uint16_t> scattered16(scattered.size());
+    std::transform(scattered.begin(), scattered.end(), scattered16.begin(), [](uint32_t index) { return static_cast<uint16_t>(index); });
+    TOY_CHECK(round_trip_indices(scattered16, encoded_byte_width));
+
+    // Single triangle and empty buffer
+    TOY_CHECK(round_trip_indices(std::vector<uint32_t>{ 2, 1, 0 }, encoded_byte_width));
+    auto empty = encode_index_buffer(nullptr, 0, sizeof(uint32_t));
+    TOY_CHECK(get_decoded_byte_width(empty) == 0);
+    TOY_CHECK(decode_mesh_stream(empty, {}));
+
+    // Not a triangle list or unknown index width
+    TOY_CHECK(encode_index_buffer(grid.data(), 4, sizeof(uint32_t)).empty());
+    TOY_CHECK(encode_index_buffer(grid.data(), 3, 3).empty());
+}
+
+TOY_TEST(MeshCodecVertices)
+{
+    std::mt19937 random(11);
+    size_t encoded_byte_width = 0;
+
+    // Strides of engine layouts and the limits, counts around the group of 16 vertices
+    for (uint32_t vertex_stride : { 4u, 12u, 20u, 48u, 64u, mesh_codec_max_vertex_stride })
+    {
+        for (size_t vertex_count : { size_t{ 1 }, size_t{ 15 }, size_t{ 16 }, size_t{ 17 }, size_t{ 1000 } })
+        {
+            auto vertices = make_vertices(vertex_count, vertex_stride, random);
+            bool is_exact = round_trip_vertices(vertices, vertex_stride, encoded_byte_width);
+            TOY_CHECK(is_exact);
+            if (!is_exact)
+            {
+                DX_ERROR("Stride {}, {} vertices do not round trip", vertex_stride, vertex_count);
+            }
+        }
+    }
+
+    // Smooth stream shrinks, noise does not grow by more than mode bytes
+    std::vector<uint8_t> smooth(4096 * 12);
+    for (size_t i = 0; i < smooth.size() / sizeof(float); ++i)
+    {
+        float value = static_cast<float>(i / 3) * 0.001f;
+        std::memcpy(smooth.data() + i * sizeof(float), &value, sizeof(float));
+    }
+    TOY_CHECK(round_trip_vertices(smooth, 12, encoded_byte_width));
+    DX_INFO("Smooth positions: {} bytes encoded of {}", encoded_byte_width, smooth.size());
+    TOY_CHECK(encoded_byte_width < smooth.size());
+    std::vector<uint8_t> noise(4096 * 16);
+    std::generate(noise.begin(), noise.end(), [&random]() { return static_cast<uint8_t>(random()); });
+    TOY_CHECK(round_trip_vertices(noise, 16, encoded_byte_width));
+    TOY_CHECK(encoded_byte_width <= sizeof(MeshStreamHeader) + noise.size() + noise.size() / 16 / 16 * 4);
+
+    auto empty = encode_vertex_stream(nullptr, 0, 12);
+    TOY_CHECK(get_decoded_byte_width(empty) == 0);
+    TOY_CHECK(decode_mesh_stream(empty, {}));
+
+    // Stride not a multiple of 4 or past the limit
+    TOY_CHECK(encode_vertex_stream(noise.data(), 16, 6).empty());
+    TOY_CHECK(encode_vertex_stream(noise.data(), 16, 0).empty());
+    TOY_CHECK(encode_vertex_stream(noise.data(), 16, mesh_codec_max_vertex_stride + 4).empty());
+}
+
+TOY_TEST(MeshCodecReject)
+{
+    std::mt19937 random(13);
+    auto grid = make_grid_indices(20);
+    auto encoded_indices = encode_index_buffer(grid.data(), grid.size(), sizeof(uint32_t));
+    auto vertices = make_vertices(100, 20, random);
+    auto encoded_vertices = encode_vertex_stream(vertices.data(), 100, 20);
+
+    for (auto* encoded : { &encoded_indices, &encoded_vertices })
+    {
+        std::vector<uint8_t> output(get_decoded_byte_width(*encoded));
+        TOY_REQUIRE(!output.empty());
+
+        // Every truncation, output of another size
+        bool is_rejected = true;
+        for (size_t size = 0; size < encoded->size(); ++size)
+        {
+            is_rejected = is_rejected && !decode_mesh_stream(std::span<const uint8_t>(*encoded).first(size), output);
+        }
+        TOY_CHECK(is_rejected);
+        std::vector<uint8_t> short_output(output.size() - 1);
+        TOY_CHECK(!decode_mesh_stream(*encoded, short_output));
+
+        // Trailing bytes of vertex stream and header of another version
+        auto trailing = *encoded;
+        trailing.push_back(0);
+        if (encoded == &encoded_vertices)
+        {
+            TOY_CHECK(!decode_mesh_stream(trailing, output));
+        }
+        auto other_version = *encoded;
+        other_version[offsetof(MeshStreamHeader, version)] = mesh_codec_version + 1;
+        TOY_CHECK(get_decoded_byte_width(other_version) == 0);
+        TOY_CHECK(!decode_mesh_stream(other_version, output));
+
+        // Corrupted payload either fails or decodes into output, it never reads or writes past the spans it is given
+        for (int i = 0; i < 2000; ++i)
+        {
+            auto corrupted = *encoded;
+            size_t position = sizeof(MeshStreamHeader) + random() % (corrupted.size() - sizeof(MeshStreamHeader));
+            corrupted[position] ^= static_cast<uint8_t>(1u << (random() % 8));
+            [[maybe_unused]] bool is_decoded = decode_mesh_stream(corrupted, output);
+        }
+    }
+    TOY_CHECK(get_decoded_byte_width({}) == 0);
+}
+
+// Streams are only encoded when the cache key opts into encoded storage, plain storage keeps the zero-copy upload
+TOY_TEST(MeshCacheStreamStorage)
+{
+    auto grid = make_grid_indices(200);
+    std::mt19937 random(13);
+    auto vertices = make_vertices(40000, 12, random);
+
+    for (auto stream_storage : { MeshStreamStorage::Plain, MeshStreamStorage::Encoded })
+    {
+        MeshCacheWriter writer(1, stream_storage);
+        MeshCacheBlob indices = writer.append_index_buffer(grid.data(), grid.size(), sizeof(uint32_t));
+        MeshCacheBlob positions = writer.append_vertex_stream(vertices.data(), vertices.size() / 12, 12);
+        auto image = writer.finish();
+
+        bool is_encoded = stream_storage == MeshStreamStorage::Encoded;
+        for (auto [blob, source, byte_width] : { std::tuple(indices, static_cast<const void *>(grid.data()), grid.size() * sizeof(uint32_t)),
+                                                 std::tuple(positions, static_cast<const void *>(vertices.data()), vertices.size()) })
+        {
+            auto stored = std::span<const uint8_t>(image).subspan(blob.offset, blob.byte_width);
+            if (!is_encoded)
+            {
+                TOY_CHECK(blob.decoded_byte_width == 0);
+                TOY_CHECK(stored.size() == byte_width && std::memcmp(stored.data(), source, byte_width) == 0);
+                continue;
+            }
+            TOY_CHECK(blob.decoded_byte_width == byte_width);
+            TOY_CHECK(static_cast<float>(stored.size()) <= static_cast<float>(byte_width) * mesh_cache_max_encoded_ratio);
+            auto decoded = decode(stored);
+            TOY_CHECK(decoded.size() == byte_width && std::memcmp(decoded.data(), source, byte_width) == 0);
+        }
+    }
+
+    // Stream storage is part of cache key
+    auto dir = test::make_test_dir("MeshCacheStreamStorage");
+    auto file_name = (dir / "mesh.bin").string();
+    TOY_REQUIRE(test::write_test_file(file_name, grid.data(), grid.size() * sizeof(uint32_t)));
+    TOY_CHECK(mesh_cache_key(file_name, 0, 0, VertexEncoding::Full, MeshStreamStorage::Plain) !=
+              mesh_cache_key(file_name, 0, 0, VertexEncoding::Full, MeshStreamStorage::Encoded));
+}
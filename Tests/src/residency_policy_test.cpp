@@ -0,0 +1,136 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/residency_policy.h>
+
+// Residency policy is bookkeeping only, so it is driven here with fake IDs and sizes as model manager drives it with models
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    constexpr size_t s_megabyte = 1024 * 1024;
+}
+
+TOY_TEST(ResidencyEvictionOrder)
+{
+    ResidencyPolicy policy(10 * s_megabyte);
+    for (XID id = 1; id <= 5; ++id)
+    {
+        policy.add(id, 2 * s_megabyte);
+    }
+    TOY_CHECK(policy.get_statistics().resident_bytes == 10 * s_megabyte);
+    TOY_CHECK(policy.evict().empty());
+
+    // Used resources move to the back, least recently used go first
+    policy.touch(1);
+    policy.add_reference(2);
+    policy.release_reference(2);
+    auto victims = policy.evict(5 * s_megabyte);
+    TOY_CHECK(victims == std::vector<XID>({ 3, 4, 5 }));
+    TOY_CHECK(policy.get_statistics().resident_bytes == 4 * s_megabyte);
+    TOY_CHECK(policy.get_statistics().eviction_count == 3);
+    TOY_CHECK(policy.get_statistics().evicted_bytes == 6 * s_megabyte);
+    TOY_CHECK(!policy.contains(3) && policy.contains(1) && policy.contains(2));
+    TOY_CHECK(policy.was_evicted(3) && !policy.was_evicted(1));
+
+    // Resource added again after its eviction counts as reload, resize keeps it tracked once
+    policy.add(3, 2 * s_megabyte);
+    policy.add(3, 3 * s_megabyte);
+    TOY_CHECK(policy.get_statistics().reload_count == 1);
+    TOY_CHECK(policy.get_statistics().resident_count == 3);
+    TOY_CHECK(policy.get_statistics().resident_bytes == 7 * s_megabyte);
+    TOY_CHECK(policy.get_statistics().peak_resident_bytes == 10 * s_megabyte);
+
+    // Lower budget evicts down to it, removal is not an eviction
+    policy.set_budget(3 * s_megabyte);
+    TOY_CHECK(policy.evict() == std::vector<XID>({ 1, 2 }));
+    policy.remove(3);
+    TOY_CHECK(policy.get_statistics().resident_count == 0 && policy.get_statistics().resident_bytes == 0);
+    TOY_CHECK(policy.get_statistics().eviction_count == 5 && !policy.was_evicted(3));
+}
+
+TOY_TEST(ResidencyPinned)
+{
+    ResidencyPolicy policy(4 * s_megabyte);
+    for (XID id = 1; id <= 4; ++id)
+    {
+        policy.add(id, s_megabyte);
+    }
+
+    // Referenced resources are never picked, whatever their age or the pressure
+    policy.add_reference(1);
+    policy.add_reference(3);
+    policy.add_reference(3);
+    auto victims = policy.evict(100 * s_megabyte);
+    TOY_CHECK(victims == std::vector<XID>({ 2, 4 }));
+    TOY_CHECK(policy.contains(1) && policy.contains(3));
+    TOY_CHECK(policy.evict(100 * s_megabyte).empty());
+
+    // Resource becomes evictable only once its last reference is released
+    policy.release_reference(3);
+    TOY_CHECK(policy.get_reference_count(3) == 1);
+    TOY_CHECK(policy.evict(100 * s_megabyte).empty());
+    policy.release_reference(3);
+    TOY_CHECK(policy.evict(100 * s_megabyte) == std::vector<XID>({ 3 }));
+    TOY_CHECK(policy.contains(1) && policy.get_reference_count(1) == 1);
+
+    // Touching a referenced resource does not make it evictable
+    policy.touch(1);
+    TOY_CHECK(policy.evict(100 * s_megabyte).empty());
+
+    // Reference to untracked resource and unmatched release are programming errors
+    bool is_thrown = false;
+    try
+    {
+        policy.add_reference(42);
+    } catch (const std::exception&)
+    {
+        is_thrown = true;
+    }
+    TOY_CHECK(is_thrown);
+    is_thrown = false;
+    try
+    {
+        policy.add(5, s_megabyte);
+        policy.release_reference(5);
+    } catch (const std::exception&)
+    {
+        is_thrown = true;
+    }
+    TOY_CHECK(is_thrown);
+}
+
+TOY_TEST(ResidencyOverBudget)
+{
+    ResidencyPolicy policy(8 * s_megabyte);
+    for (XID id = 1; id <= 6; ++id)
+    {
+        policy.add(id, 2 * s_megabyte);
+        policy.add_reference(id);
+    }
+
+    // Everything in use, residency stays over budget and nothing is evicted
+    TOY_CHECK(policy.get_statistics().resident_bytes == 12 * s_megabyte);
+    TOY_CHECK(policy.evict().empty());
+    TOY_CHECK(policy.get_statistics().eviction_count == 0);
+
+    // Releasing some frees only what brings residency back under budget, the rest stays for reuse
+    for (XID id = 1; id <= 3; ++id)
+    {
+        policy.release_reference(id);
+    }
+    TOY_CHECK(policy.evict() == std::vector<XID>({ 1, 2 }));
+    TOY_CHECK(policy.get_statistics().resident_bytes == 8 * s_megabyte);
+    TOY_CHECK(policy.contains(3));
+
+    // Incoming load that can not fit evicts every unreferenced resource and still leaves residency over budget
+    auto victims = policy.evict(4 * s_megabyte);
+    TOY_CHECK(victims == std::vector<XID>({ 3 }));
+    TOY_CHECK(policy.get_statistics().resident_bytes + 4 * s_megabyte > policy.get_budget());
+    TOY_CHECK(policy.get_statistics().resident_count == 3);
+}
@@ -0,0 +1,245 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Runtime/scene_image.h>
+#include <Toy/Core/mapped_file.h>
+
+// Scene image must give back every entity, tag, component and asset reference it was written with,
+// and images with tables or references out of range must be rejected before they are loaded
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::runtime;
+
+    // Components in file layout, as scene graph writes its trivially copyable components
+    struct TestTransform
+    {
+        float position[3];
+        float rotation[4];
+        float scale[3];
+
+        bool operator==(const TestTransform&) const = default;
+    };
+
+    struct TestLight
+    {
+        float direction[3];
+        float intensity;
+        uint32_t color;
+        uint32_t padding;
+
+        bool operator==(const TestLight&) const = default;
+    };
+
+    struct TestModel
+    {
+        XID id;
+        std::string file_name;
+    };
+
+    struct TestScene
+    {
+        std::vector<std::string> tags;
+        std::vector<uint32_t> transform_entities;
+        std::vector<TestTransform> transforms;
+        std::vector<uint32_t> light_entities;
+        std::vector<TestLight> lights;
+        std::vector<uint32_t> static_mesh_entities;
+        std::vector<SceneFileStaticMesh> static_meshes;
+        std::vector<TestModel> models;              // Model of static mesh i is models[i % models.size()]
+    };
+
+    // Every entity has a tag, most a transform, some a light or a model, a few nothing else
+    TestScene make_scene(uint32_t entity_count, std::mt19937& random)
+    {
+        TestScene scene{};
+        for (uint32_t i = 0; i < 50; ++i)
+        {
+            scene.models.push_back({ string_to_id(fmt::format("Model{}", i)), i % 10 == 0 ? "" : fmt::format("Model/model_{}.gltf", i) });
+        }
+
+        std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+        for (uint32_t i = 0; i < entity_count; ++i)
+        {
+            scene.tags.push_back(i % 7 == 0 ? std::string{} : fmt::format("Entity {}", i));
+            if (i % 13 == 0)
+            {
+                continue;
+            }
+
+            auto&& transform = scene.transforms.emplace_back();
+            auto values = reinterpret_cast<float *>(&transform);
+            std::generate(values, values + sizeof(TestTransform) / sizeof(float), [&]() { return distribution(random); });
+            scene.transform_entities.push_back(i);
+            if (i % 5 == 0)
+            {
+                scene.lights.push_back({ { distribution(random), distribution(random), distribution(random) }, distribution(random),
+                                         static_cast<uint32_t>(random()), 0 });
+                scene.light_entities.push_back(i);
+            }
+            if (i % 3 == 0)
+            {
+                scene.static_meshes.push_back({ 0, i % 2, 0, 0 });
+                scene.static_mesh_entities.push_back(i);
+            }
+        }
+        return scene;
+    }
+
+    std::vector<uint8_t> write_scene(const TestScene& scene)
+    {
+        SceneImageWriter writer{};
+        for (auto&& tag : scene.tags)
+        {
+            writer.add_entity(tag);
+        }
+        std::vector<SceneFileStaticMesh> static_meshes = scene.static_meshes;
+        for (size_t i = 0; i < static_meshes.size(); ++i)
+        {
+            auto&& model = scene.models[i % scene.models.size()];
+            static_meshes[i].asset_index = writer.add_asset(model.id, model.file_name);
+        }
+
+        auto&& header = writer.header();
+        header.transforms = writer.append_table<TestTransform>(scene.transform_entities, scene.transforms);
+        header.static_meshes = writer.append_table<SceneFileStaticMesh>(scene.static_mesh_entities, static_meshes);
+        header.directional_lights = writer.append_table<TestLight>(scene.light_entities, scene.lights);
+        return writer.finish();
+    }
+
+    template<typename T>
+    bool is_table_equal(std::span<const uint8_t> image, const SceneFileTable& table, const std::vector<uint32_t>& entities,
+                        const std::vector<T>& components)
+    {
+        auto image_entities = get_scene_array<uint32_t>(image, table.entities);
+        auto image_components = get_scene_array<T>(image, table.components);
+        return table.component_byte_width == sizeof(T) && std::equal(image_entities.begin(), image_entities.end(), entities.begin(), entities.end()) &&
+               std::equal(image_components.begin(), image_components.end(), components.begin(), components.end());
+    }
+
+    SceneFileHeader& get_header(std::vector<uint8_t>& image)
+    {
+        return *reinterpret_cast<SceneFileHeader *>(image.data());
+    }
+}
+
+TOY_TEST(SceneImageRoundTrip)
+{
+    std::mt19937 random(17);
+    auto scene = make_scene(100000, random);
+    auto written = write_scene(scene);
+
+    // Image is read back from a mapped file, as scene graph loads it
+    auto test_dir = test::make_test_dir("SceneImage");
+    auto file_path = test_dir / "round_trip.tscene";
+    TOY_REQUIRE(save_scene_image(file_path, written));
+    MappedFile file(file_path);
+    TOY_REQUIRE(file.is_open());
+    std::span<const uint8_t> image = file.bytes();
+    TOY_REQUIRE(image.size() == written.size());
+
+    auto start_time = std::chrono::steady_clock::now();
+    TOY_REQUIRE(validate_scene_image(image));
+    auto&& header = *reinterpret_cast<const SceneFileHeader *>(image.data());
+
+    // Tags and components are rebuilt in bulk, as load_scene does
+    auto tag_offsets = get_scene_array<uint32_t>(image, header.tag_offsets);
+    std::string_view tags = get_scene_string(image, header.tags);
+    std::vector<std::string> loaded_tags(header.entity_count);
+    for (size_t i = 0; i < loaded_tags.size(); ++i)
+    {
+        loaded_tags[i] = tags.substr(tag_offsets[i], tag_offsets[i + 1] - tag_offsets[i]);
+    }
+    auto transforms = get_scene_array<TestTransform>(image, header.transforms.components);
+    std::vector<TestTransform> loaded_transforms(transforms.begin(), transforms.end());
+    DX_INFO("Scene of {} entities, {:.2f} KB, validated and rebuilt in {:.2f} ms", header.entity_count,
+            static_cast<double>(image.size()) / 1024.0,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+
+    TOY_CHECK(header.entity_count == scene.tags.size());
+    TOY_CHECK(loaded_tags == scene.tags);
+    TOY_CHECK(loaded_transforms == scene.transforms);
+    TOY_CHECK(is_table_equal(image, header.transforms, scene.transform_entities, scene.transforms));
+    TOY_CHECK(is_table_equal(image, header.directional_lights, scene.light_entities, scene.lights));
+    TOY_CHECK(header.cameras.count == 0);
+
+    // Models are written once, every static mesh refers to its own
+    TOY_CHECK(header.asset_count == scene.models.size());
+    auto assets = get_scene_array<SceneFileAsset>(image, header.assets);
+    std::string_view asset_names = get_scene_string(image, header.asset_names);
+    auto static_mesh_entities = get_scene_array<uint32_t>(image, header.static_meshes.entities);
+    auto static_meshes = get_scene_array<SceneFileStaticMesh>(image, header.static_meshes.components);
+    TOY_REQUIRE(static_meshes.size() == scene.static_meshes.size());
+    bool is_resolved = std::equal(static_mesh_entities.begin(), static_mesh_entities.end(), scene.static_mesh_entities.begin(),
+                                  scene.static_mesh_entities.end());
+    for (size_t i = 0; i < static_meshes.size(); ++i)
+    {
+        auto&& asset = assets[static_meshes[i].asset_index];
+        auto&& model = scene.models[i % scene.models.size()];
+        is_resolved = is_resolved && asset.id == model.id && asset_names.substr(asset.name_offset, asset.name_length) == model.file_name &&
+                      static_meshes[i].is_skybox == scene.static_meshes[i].is_skybox;
+    }
+    TOY_CHECK(is_resolved);
+
+    // Empty scene is valid as well
+    TOY_CHECK(validate_scene_image(SceneImageWriter{}.finish()));
+}
+
+TOY_TEST(SceneImageReject)
+{
+    std::mt19937 random(19);
+    auto scene = make_scene(1000, random);
+    auto image = write_scene(scene);
+    TOY_REQUIRE(validate_scene_image(image));
+
+    // Truncations
+    bool is_rejected = true;
+    for (size_t size = 0; size < image.size(); size += 7)
+    {
+        is_rejected = is_rejected && !validate_scene_image(std::span<const uint8_t>(image).first(size));
+    }
+    TOY_CHECK(is_rejected);
+
+    // Each corruption is checked on its own copy of the image
+    auto is_corruption_rejected = [&image](auto&& corrupt)
+    {
+        auto corrupted = image;
+        corrupt(corrupted, get_header(corrupted));
+        return !validate_scene_image(corrupted);
+    };
+    auto get_entities = [](std::vector<uint8_t>& corrupted, const SceneFileTable& table)
+    {
+        return reinterpret_cast<uint32_t *>(corrupted.data() + table.entities.offset);
+    };
+
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.magic = 0; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.version = scene_file_version + 1; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.entity_count += 1; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.transforms.count += 1; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.transforms.components.offset += 1; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.directional_lights.component_byte_width = 0; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.directional_lights.component_byte_width -= 4; }));
+    TOY_CHECK(is_corruption_rejected([](auto&, SceneFileHeader& h) { h.static_meshes.component_byte_width *= 2; }));
+
+    // Entity out of range, entity twice in a table
+    TOY_CHECK(is_corruption_rejected([&](auto& c, SceneFileHeader& h) { get_entities(c, h.transforms)[0] = h.entity_count; }));
+    TOY_CHECK(is_corruption_rejected([&](auto& c, SceneFileHeader& h) { get_entities(c, h.directional_lights)[1] = get_entities(c, h.directional_lights)[0]; }));
+
+    // Static mesh of an asset past the table, asset name past the names
+    TOY_CHECK(is_corruption_rejected([](auto& c, SceneFileHeader& h)
+    {
+        reinterpret_cast<SceneFileStaticMesh *>(c.data() + h.static_meshes.components.offset)->asset_index = h.asset_count;
+    }));
+    TOY_CHECK(is_corruption_rejected([](auto& c, SceneFileHeader& h)
+    {
+        reinterpret_cast<SceneFileAsset *>(c.data() + h.assets.offset)[1].name_offset = static_cast<uint32_t>(h.asset_names.byte_width);
+    }));
+
+    // Tag offsets that go back or past the tags
+    TOY_CHECK(is_corruption_rejected([](auto& c, SceneFileHeader& h) { reinterpret_cast<uint32_t *>(c.data() + h.tag_offsets.offset)[2] = 0xFFFF; }));
+    TOY_CHECK(is_corruption_rejected([](auto& c, SceneFileHeader& h) { reinterpret_cast<uint32_t *>(c.data() + h.tag_offsets.offset)[0] = 1; }));
+}
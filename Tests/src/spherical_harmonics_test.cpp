@@ -0,0 +1,143 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Renderer/spherical_harmonics.h>
+
+// SH9 projection of environments whose coefficients are known in closed form. Projected radiance L_lm is scaled by the
+// clamped cosine factor A_l / pi and the basis constant Y_lm, so a stored coefficient is radiance weight times A_l / pi times Y_lm^2
+// integrated over the sphere:
+//   constant c                 c
+//   c * dot(d, w), unit d      2 c / 3 * d, as coefficients 1 to 3 hold y, z and x
+//   c * (3 z^2 - 1)            c / 4 at coefficient 6
+//   c * x * y                  c / 4 at coefficient 4
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    const DirectX::XMFLOAT3 s_lobe_direction{ 1.0f / 3.0f, 2.0f / 3.0f, -2.0f / 3.0f };
+
+    // Red is constant, green a linear lobe along s_lobe_direction, blue two band 2 terms, each stays positive
+    DirectX::XMFLOAT3 analytic_radiance(float x, float y, float z)
+    {
+        float lobe = s_lobe_direction.x * x + s_lobe_direction.y * y + s_lobe_direction.z * z;
+        return { 1.5f, 1.0f + 0.5f * lobe, 1.0f + 0.5f * (3.0f * z * z - 1.0f) + 0.5f * x * y };
+    }
+
+    std::array<DirectX::XMFLOAT3, 9> analytic_coefficients()
+    {
+        std::array<DirectX::XMFLOAT3, 9> coefficients{};
+        coefficients[0] = { 1.5f, 1.0f, 1.0f };
+        coefficients[1] = { 0.0f, 1.0f / 3.0f * s_lobe_direction.y, 0.0f };
+        coefficients[2] = { 0.0f, 1.0f / 3.0f * s_lobe_direction.z, 0.0f };
+        coefficients[3] = { 0.0f, 1.0f / 3.0f * s_lobe_direction.x, 0.0f };
+        coefficients[4] = { 0.0f, 0.0f, 0.125f };
+        coefficients[6] = { 0.0f, 0.0f, 0.125f };
+        return coefficients;
+    }
+
+    // Texel centers mapped to directions as equirect_to_cube.hlsl and the projection do
+    HdrImage make_equirect(uint32_t width, uint32_t height, HdrFormat format)
+    {
+        using namespace DirectX;
+        HdrImage image{ format, width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height * get_texel_byte_width(format)) };
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            float theta = (static_cast<float>(y) + 0.5f) * XM_PI / static_cast<float>(height);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float phi = (static_cast<float>(x) + 0.5f) * XM_2PI / static_cast<float>(width);
+                XMFLOAT3 radiance = analytic_radiance(std::cos(phi) * std::sin(theta), std::cos(theta), std::sin(phi) * std::sin(theta));
+                size_t index = static_cast<size_t>(y) * width + x;
+                if (format == HdrFormat::RGBA16F)
+                {
+                    PackedVector::XMStoreHalf4(reinterpret_cast<PackedVector::XMHALF4*>(image.pixels.data()) + index,
+                                               XMVectorSetW(XMLoadFloat3(&radiance), 1.0f));
+                } else
+                {
+                    PackedVector::XMStoreFloat3SE(reinterpret_cast<PackedVector::XMFLOAT3SE*>(image.pixels.data()) + index, XMLoadFloat3(&radiance));
+                }
+            }
+        }
+        return image;
+    }
+
+    IblTexture make_cube(uint32_t size)
+    {
+        using namespace DirectX;
+        IblTexture cube{ DXGI_FORMAT_R16G16B16A16_FLOAT, size, size, 1, 6 };
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            auto texels = reinterpret_cast<PackedVector::XMHALF4*>(cube.get_subresource(0, face).data());
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    float u = 2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(size) - 1.0f;
+                    float v = 1.0f - 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+                    const XMVECTOR directions[6] = {
+                        XMVectorSet(1.0f, v, -u, 0.0f), XMVectorSet(-1.0f, v, u, 0.0f), XMVectorSet(u, 1.0f, -v, 0.0f),
+                        XMVectorSet(u, -1.0f, v, 0.0f), XMVectorSet(u, v, 1.0f, 0.0f), XMVectorSet(-u, v, -1.0f, 0.0f)
+                    };
+                    XMFLOAT3 w{};
+                    XMStoreFloat3(&w, XMVector3Normalize(directions[face]));
+                    XMFLOAT3 radiance = analytic_radiance(w.x, w.y, w.z);
+                    PackedVector::XMStoreHalf4(texels + static_cast<size_t>(y) * size + x, XMVectorSetW(XMLoadFloat3(&radiance), 1.0f));
+                }
+            }
+        }
+        return cube;
+    }
+
+    float max_coefficient_error(const IrradianceSH& irradiance_sh)
+    {
+        auto expected = analytic_coefficients();
+        float max_error = 0.0f;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            auto&& coefficient = irradiance_sh.coefficients[i];
+            max_error = std::max({ max_error, std::abs(coefficient.x - expected[i].x), std::abs(coefficient.y - expected[i].y),
+                                   std::abs(coefficient.z - expected[i].z) });
+        }
+        return max_error;
+    }
+}
+
+TOY_TEST(ShProjectionAnalytic)
+{
+    using namespace DirectX;
+
+    // Quantization of texels averages out over the sphere, the bound is about 5 times the error seen
+    for (HdrFormat format : { HdrFormat::RGBA16F, HdrFormat::RGB9E5 })
+    {
+        HdrImage image = make_equirect(256, 128, format);
+        IrradianceSH irradiance_sh = project_irradiance_sh(image);
+        float error = max_coefficient_error(irradiance_sh);
+        DX_INFO("Equirect {}: max coefficient error {:.2e}", format == HdrFormat::RGBA16F ? "RGBA16F" : "RGB9E5", error);
+        TOY_CHECK(error < 2.0e-4f);
+
+        // Evaluation is irradiance over pi in closed form: constant, constant plus two thirds of the lobe, band 2 terms over 4
+        for (XMFLOAT3 n : { XMFLOAT3{ 0.0f, 1.0f, 0.0f }, XMFLOAT3{ 0.0f, 0.0f, -1.0f }, XMFLOAT3{ 0.6f, 0.0f, 0.8f },
+                            XMFLOAT3{ 1.0f / 3.0f, 2.0f / 3.0f, -2.0f / 3.0f } })
+        {
+            float lobe = s_lobe_direction.x * n.x + s_lobe_direction.y * n.y + s_lobe_direction.z * n.z;
+            XMFLOAT3 expected{ 1.5f, 1.0f + 1.0f / 3.0f * lobe, 1.0f + 0.125f * (3.0f * n.z * n.z - 1.0f) + 0.125f * n.x * n.y };
+            XMFLOAT3 irradiance{};
+            XMStoreFloat3(&irradiance, evaluate_irradiance_sh(irradiance_sh, XMLoadFloat3(&n)));
+            TOY_CHECK(std::abs(irradiance.x - expected.x) < 1.0e-3f);
+            TOY_CHECK(std::abs(irradiance.y - expected.y) < 1.0e-3f);
+            TOY_CHECK(std::abs(irradiance.z - expected.z) < 1.0e-3f);
+        }
+    }
+
+    // Cube path, texel centers of every face as equirect_to_cube.hlsl orients them
+    // Note: cube of bake_ibl_maps is not used, it samples at texel corners as the shader does, which is a half texel rotation
+    IblTexture cube = make_cube(64);
+    float error = max_coefficient_error(project_irradiance_sh(cube));
+    DX_INFO("Cube 64: max coefficient error {:.2e}", error);
+    TOY_CHECK(error < 2.0e-4f);
+}
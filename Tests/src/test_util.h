@@ -0,0 +1,89 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::test
+{
+    using TestFunction = void (*)();
+
+    struct TestCase
+    {
+        std::string_view name;
+        TestFunction func = nullptr;
+    };
+
+    // Test cases in registration order, filled by TOY_TEST before main runs
+    inline std::vector<TestCase>& get_test_cases()
+    {
+        static std::vector<TestCase> test_cases{};
+        return test_cases;
+    }
+
+    // Failed checks of test case being run
+    inline size_t& get_failure_count()
+    {
+        static size_t failure_count = 0;
+        return failure_count;
+    }
+
+    struct TestRegistrar
+    {
+        TestRegistrar(std::string_view name, TestFunction func)
+        {
+            get_test_cases().emplace_back(TestCase{ name, func });
+        }
+    };
+
+    inline void report_failure(std::string_view expression, std::string_view file, int line)
+    {
+        ++get_failure_count();
+        DX_ERROR("Check '{}' failed at {}:{}", expression, file, line);
+    }
+
+    // Empty directory for files of a test case under the system temporary directory
+    inline std::filesystem::path make_test_dir(std::string_view name)
+    {
+        auto dir = std::filesystem::temp_directory_path() / "ToyTests" / name;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    inline bool write_test_file(const std::filesystem::path& file_path, const void* data, size_t byte_width)
+    {
+        std::ofstream fout(file_path, std::ios::binary);
+        fout.write(static_cast<const char *>(data), static_cast<std::streamsize>(byte_width));
+        return fout.good();
+    }
+}
+
+// Register test case, it is run by ToyTests <name> or by ToyTests without arguments
+#define TOY_TEST(name)                                                                          \
+    static void toy_test_##name();                                                              \
+    static ::toy::test::TestRegistrar s_toy_test_registrar_##name(#name, &toy_test_##name);     \
+    static void toy_test_##name()
+
+// Failed check is reported and test case goes on, so that one run lists every mismatch
+#define TOY_CHECK(expression)                                                                   \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(expression))                                                                      \
+        {                                                                                       \
+            ::toy::test::report_failure(#expression, __FILE__, __LINE__);                       \
+        }                                                                                       \
+    } while (false)
+
+// Stop test case on failure, for checks that later ones depend on
+#define TOY_REQUIRE(expression)                                                                 \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(expression))                                                                      \
+        {                                                                                       \
+            ::toy::test::report_failure(#expression, __FILE__, __LINE__);                       \
+            return;                                                                             \
+        }                                                                                       \
+    } while (false)
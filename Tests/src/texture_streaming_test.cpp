@@ -0,0 +1,154 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/texture_streaming.h>
+
+// Texture streaming decisions are bookkeeping only, so the policy is checked without a device:
+// mip selection from screen texel density, promotion order, LRU demotion under budget and statistics
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    constexpr uint32_t s_bc1_bits_per_texel = 4;
+    constexpr uint32_t s_rgba8_bits_per_texel = 32;
+
+    // Request large enough for full resolution of any test texture
+    constexpr float s_full_resolution_area = 1.0e9f;
+
+    size_t chain_byte_width(uint32_t size, uint32_t bits_per_texel, uint32_t first_mip)
+    {
+        return TextureStreamingPolicy::get_mip_chain_byte_width(size, size, bits_per_texel, first_mip);
+    }
+
+    bool has_change(const std::vector<MipChange>& changes, XID id, uint32_t resident_mip, bool promotion)
+    {
+        return std::any_of(changes.begin(), changes.end(), [=](const MipChange& change)
+        {
+            return change.id == id && change.resident_mip == resident_mip && change.promotion == promotion;
+        });
+    }
+}
+
+TOY_TEST(TextureStreamingMips)
+{
+    // 2 x 2 world quad mapped to the unit uv square
+    std::vector<DirectX::XMFLOAT3> positions = { { 0.0f, 0.0f, 0.0f }, { 2.0f, 0.0f, 0.0f }, { 2.0f, 2.0f, 0.0f }, { 0.0f, 2.0f, 0.0f } };
+    std::vector<DirectX::XMFLOAT2> texcoords = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+    std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+    TOY_CHECK(std::abs(compute_uv_density(indices, positions, texcoords) - 4.0f) <= 1.0e-5f);
+    TOY_CHECK(compute_uv_density(indices, positions, {}) == 0.0f);
+
+    // Twice the distance is a quarter of the screen area
+    float near_area = compute_screen_uv_area(4.0f, 1.0f, 10.0f, 500.0f);
+    float far_area = compute_screen_uv_area(4.0f, 1.0f, 20.0f, 500.0f);
+    TOY_CHECK(std::abs(near_area - 4.0f * far_area) <= near_area * 1.0e-5f);
+    TOY_CHECK(compute_screen_uv_area(0.0f, 1.0f, 10.0f, 500.0f) == std::numeric_limits<float>::max());
+    TOY_CHECK(compute_screen_uv_area(4.0f, 1.0f, 0.0f, 500.0f) == std::numeric_limits<float>::max());
+
+    // One texel per pixel, every mip quarters texel area
+    float texel_area = 1024.0f * 1024.0f;
+    TOY_CHECK(compute_required_mip(1024, 1024, texel_area) == 0);
+    TOY_CHECK(compute_required_mip(1024, 1024, 2.0f * texel_area) == 0);
+    TOY_CHECK(compute_required_mip(1024, 1024, texel_area / 4.0f) == 1);
+    TOY_CHECK(compute_required_mip(1024, 1024, texel_area / 16.0f) == 2);
+    TOY_CHECK(compute_required_mip(1024, 1024, 1.0f) == 10);
+    TOY_CHECK(compute_required_mip(1024, 1024, 0.0f) == 10);
+    TOY_CHECK(compute_required_mip(1024, 256, 1024.0f * 256.0f / 16.0f) == 2);
+}
+
+TOY_TEST(TextureStreamingPolicy)
+{
+    // Textures start with their mip tail, 2048 down to 64 is 5 mips
+    TextureStreamingPolicy policy{};
+    XID near_id = string_to_id("near"), far_id = string_to_id("far"), small_id = string_to_id("small");
+    policy.add(near_id, 2048, 2048, s_bc1_bits_per_texel);
+    policy.add(far_id, 2048, 2048, s_bc1_bits_per_texel);
+    policy.add(small_id, 32, 32, s_bc1_bits_per_texel);
+    TOY_CHECK(policy.get_tail_mip(near_id) == 5);
+    TOY_CHECK(policy.get_resident_mip(near_id) == 5);
+    TOY_CHECK(policy.get_tail_mip(small_id) == 0);
+    size_t tail_bytes = 2 * chain_byte_width(2048, s_bc1_bits_per_texel, 5) + chain_byte_width(32, s_bc1_bits_per_texel, 0);
+    TOY_CHECK(policy.get_statistics().resident_bytes == tail_bytes);
+    TOY_CHECK(policy.get_statistics().streamed_texture_count == 3);
+
+    // Most detailed of several requests wins, requests do not carry over to the next update
+    policy.request(near_id, 1.0f);
+    policy.request(near_id, 2048.0f * 2048.0f);
+    policy.request(far_id, 512.0f * 512.0f);
+    auto changes = policy.update();
+    TOY_CHECK(changes.size() == 2);
+    TOY_CHECK(has_change(changes, near_id, 0, true));
+    TOY_CHECK(has_change(changes, far_id, 2, true));
+    size_t resident_bytes = chain_byte_width(2048, s_bc1_bits_per_texel, 0) + chain_byte_width(2048, s_bc1_bits_per_texel, 2) +
+                            chain_byte_width(32, s_bc1_bits_per_texel, 0);
+    TOY_CHECK(policy.get_statistics().resident_bytes == resident_bytes);
+    TOY_CHECK(policy.get_statistics().requested_bytes == resident_bytes);
+    TOY_CHECK(policy.get_statistics().promotion_count == 2);
+    TOY_CHECK(policy.update().empty());
+    TOY_CHECK(policy.get_statistics().requested_bytes == tail_bytes);
+
+    // Under budget nothing is demoted even if no longer requested
+    TOY_CHECK(policy.get_resident_mip(near_id) == 0);
+
+    // Budget of one full texture besides tails, least recently requested texture makes room
+    policy.set_budget(tail_bytes + chain_byte_width(2048, s_bc1_bits_per_texel, 0) - chain_byte_width(2048, s_bc1_bits_per_texel, 5));
+    policy.request(far_id, s_full_resolution_area);
+    changes = policy.update();
+    TOY_CHECK(has_change(changes, near_id, 5, false));
+    TOY_CHECK(has_change(changes, far_id, 0, true));
+    TOY_CHECK(policy.get_resident_mip(near_id) == 5);
+    TOY_CHECK(policy.get_resident_mip(far_id) == 0);
+    TOY_CHECK(policy.get_statistics().resident_bytes <= policy.get_budget());
+
+    // Texture requested in this update is not demoted for another one, the request falls back to what fits
+    policy.request(far_id, s_full_resolution_area);
+    policy.request(near_id, s_full_resolution_area * 0.5f);
+    changes = policy.update();
+    TOY_CHECK(policy.get_resident_mip(far_id) == 0);
+    TOY_CHECK(policy.get_resident_mip(near_id) == 5);
+    TOY_CHECK(policy.get_statistics().resident_bytes <= policy.get_budget());
+    TOY_CHECK(policy.get_statistics().requested_bytes > policy.get_budget());
+
+    // Lowered budget demotes on the next update without requests
+    policy.set_budget(tail_bytes);
+    changes = policy.update();
+    TOY_CHECK(has_change(changes, far_id, 5, false));
+    TOY_CHECK(policy.get_statistics().resident_bytes == tail_bytes);
+
+    policy.remove(near_id);
+    policy.remove(far_id);
+    policy.remove(small_id);
+    TOY_CHECK(policy.get_statistics().resident_bytes == 0);
+    TOY_CHECK(policy.get_statistics().streamed_texture_count == 0);
+    TOY_CHECK(!policy.contains(near_id));
+}
+
+TOY_TEST(TextureStreamingUploadLimit)
+{
+    // Full chain of a 4096 RGBA8 texture is over the upload limit of one update, the second request waits
+    TextureStreamingPolicy policy{};
+    XID first_id = string_to_id("first"), second_id = string_to_id("second");
+    policy.add(first_id, 4096, 4096, s_rgba8_bits_per_texel);
+    policy.add(second_id, 4096, 4096, s_rgba8_bits_per_texel);
+    TOY_REQUIRE(chain_byte_width(4096, s_rgba8_bits_per_texel, 0) > streaming_upload_bytes_per_update);
+
+    // Largest on screen is promoted first
+    policy.request(first_id, s_full_resolution_area * 0.5f);
+    policy.request(second_id, s_full_resolution_area);
+    auto changes = policy.update();
+    TOY_CHECK(changes.size() == 1);
+    TOY_CHECK(has_change(changes, second_id, 0, true));
+
+    policy.request(first_id, s_full_resolution_area * 0.5f);
+    policy.request(second_id, s_full_resolution_area);
+    changes = policy.update();
+    TOY_CHECK(changes.size() == 1);
+    TOY_CHECK(has_change(changes, first_id, 0, true));
+    TOY_CHECK(policy.get_statistics().promoted_bytes == 2 * (chain_byte_width(4096, s_rgba8_bits_per_texel, 0) -
+                                                             chain_byte_width(4096, s_rgba8_bits_per_texel, 6)));
+}
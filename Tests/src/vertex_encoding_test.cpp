@@ -0,0 +1,180 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include "test_util.h"
+
+#include <Toy/Model/vertex_encoding.h>
+
+// Quantized vertex streams must decode within the error bounds of vertex_encoding.h, and a mesh over 65536 vertices
+// must be split into 16-bit chunks that together still draw every source triangle
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+    using namespace DirectX;
+
+    // Wavy grid with tangents of both handedness and a second uv set beyond [0, 1]
+    struct TestMesh
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT3> normals;
+        std::vector<XMFLOAT4> tangents;
+        std::vector<XMFLOAT2> texcoords;
+        std::vector<XMFLOAT2> tiled_texcoords;
+        std::vector<uint32_t> indices;
+        BoundingBox bounding_box;
+
+        [[nodiscard]] VertexStreams get_streams() const
+        {
+            return { positions, normals, tangents, { texcoords, tiled_texcoords }, indices };
+        }
+    };
+
+    TestMesh make_grid(uint32_t size)
+    {
+        TestMesh mesh{};
+        for (uint32_t row = 0; row < size; ++row)
+        {
+            for (uint32_t col = 0; col < size; ++col)
+            {
+                float u = static_cast<float>(col) / static_cast<float>(size - 1);
+                float v = static_cast<float>(row) / static_cast<float>(size - 1);
+                float x = -50.0f + 100.0f * u;
+                float z = -20.0f + 50.0f * v;
+                float y = 3.0f * std::sin(0.2f * x) * std::cos(0.3f * z) + 10.0f;
+                float dy_dx = 0.6f * std::cos(0.2f * x) * std::cos(0.3f * z);
+                float dy_dz = -0.9f * std::sin(0.2f * x) * std::sin(0.3f * z);
+
+                XMFLOAT3 normal{}, tangent{};
+                XMFLOAT3 unnormalized_normal{ -dy_dx, 1.0f, -dy_dz };
+                XMFLOAT3 unnormalized_tangent{ 1.0f, dy_dx, 0.0f };
+                XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&unnormalized_normal)));
+                XMStoreFloat3(&tangent, XMVector3Normalize(XMLoadFloat3(&unnormalized_tangent)));
+
+                mesh.positions.push_back({ x, y, z });
+                mesh.normals.push_back(normal);
+                mesh.tangents.push_back({ tangent.x, tangent.y, tangent.z, (row + col) % 2 ? -1.0f : 1.0f });
+                mesh.texcoords.push_back({ u, v });
+                mesh.tiled_texcoords.push_back({ 12.0f * u - 3.0f, 7.0f * v });
+            }
+        }
+        for (uint32_t row = 0; row + 1 < size; ++row)
+        {
+            for (uint32_t col = 0; col + 1 < size; ++col)
+            {
+                uint32_t i = row * size + col;
+                mesh.indices.insert(mesh.indices.end(), { i, i + size, i + 1, i + 1, i + size, i + size + 1 });
+            }
+        }
+        BoundingBox::CreateFromPoints(mesh.bounding_box, mesh.positions.size(), mesh.positions.data(), sizeof(XMFLOAT3));
+        return mesh;
+    }
+
+    float angle_between(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        XMVECTOR va = XMVector3Normalize(XMLoadFloat3(&a));
+        XMVECTOR vb = XMVector3Normalize(XMLoadFloat3(&b));
+        return std::atan2(XMVectorGetX(XMVector3Length(XMVector3Cross(va, vb))), XMVectorGetX(XMVector3Dot(va, vb)));
+    }
+}
+
+TOY_TEST(VertexEncodingBounds)
+{
+    // Corners of bounding box are on the grid, a flat axis decodes to its offset
+    BoundingBox bounding_box(XMFLOAT3{ 1.0f, -2.0f, 3.0f }, XMFLOAT3{ 4.0f, 0.0f, 0.5f });
+    for (XMFLOAT3 corner : { XMFLOAT3{ -3.0f, -2.0f, 2.5f }, XMFLOAT3{ 5.0f, -2.0f, 3.5f }, XMFLOAT3{ -3.0f, -2.0f, 3.5f } })
+    {
+        for (float handedness : { 1.0f, -1.0f })
+        {
+            auto encoded = encode_position(corner, bounding_box, handedness);
+            XMFLOAT3 decoded = decode_position(encoded, bounding_box);
+            TOY_CHECK(std::abs(decoded.x - corner.x) <= 1.0e-5f);
+            TOY_CHECK(decoded.y == corner.y);
+            TOY_CHECK(std::abs(decoded.z - corner.z) <= 1.0e-5f);
+            TOY_CHECK(decode_handedness(encoded) == handedness);
+        }
+    }
+
+    // Axes, octahedron folds and random directions, fixed seed so that failures reproduce
+    std::vector<XMFLOAT3> directions = {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+        { 0.0f, 0.0f, -1.0f }, { 0.577f, -0.577f, -0.577f }, { -0.707f, 0.0f, -0.707f }, { 0.0f, 0.707f, -0.707f }
+    };
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for (int i = 0; i < 100000; ++i)
+    {
+        directions.push_back({ distribution(random), distribution(random), distribution(random) });
+    }
+    float max_angle = 0.0f;
+    for (auto&& direction : directions)
+    {
+        if (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) < 1.0e-3f)
+        {
+            continue;
+        }
+        max_angle = std::max(max_angle, angle_between(direction, decode_octahedral(encode_octahedral(direction))));
+    }
+    DX_INFO("Max octahedral error {:.3e} rad, bound {:.3e} rad", max_angle, quantized_direction_error_bound);
+    TOY_CHECK(max_angle <= quantized_direction_error_bound);
+
+    // Handedness is the side of bitangent relative to cross(normal, tangent)
+    std::vector<XMFLOAT3> normals = { { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } };
+    std::vector<XMFLOAT4> tangents = { { 1.0f, 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.0f } };
+    std::vector<XMFLOAT4> bitangents = { { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f, 0.0f } };
+    auto handed_tangents = make_handed_tangents(normals, tangents, bitangents);
+    TOY_REQUIRE(handed_tangents.size() == 2);
+    TOY_CHECK(handed_tangents[0].w == 1.0f);
+    TOY_CHECK(handed_tangents[1].w == -1.0f);
+}
+
+TOY_TEST(VertexQuantization)
+{
+    // 300 x 300 grid is over the 65536 vertices of one 16-bit chunk
+    TestMesh mesh = make_grid(300);
+    VertexStreams streams = mesh.get_streams();
+    auto chunks = quantize_vertex_streams(streams);
+    TOY_CHECK(chunks.size() >= 2);
+
+    // Chunks draw the source triangles in source order, with the same winding
+    std::vector<uint32_t> indices{};
+    std::vector<uint32_t> chunk_counts(mesh.positions.size(), 0);
+    for (auto&& chunk : chunks)
+    {
+        size_t num_vertices = chunk.source_vertices.size();
+        TOY_CHECK(num_vertices <= quantized_chunk_max_vertices);
+        TOY_REQUIRE(chunk.positions.size() == num_vertices && chunk.normals.size() == num_vertices &&
+                    chunk.tangents.size() == num_vertices && chunk.texcoords.size() == streams.texcoords.size());
+        for (auto&& texcoords : chunk.texcoords)
+        {
+            TOY_REQUIRE(texcoords.size() == num_vertices);
+        }
+        for (auto index : chunk.indices)
+        {
+            TOY_REQUIRE(index < num_vertices);
+            indices.push_back(chunk.source_vertices[index]);
+        }
+        for (size_t i = 0; i < num_vertices; ++i)
+        {
+            uint32_t source_vertex = chunk.source_vertices[i];
+            ++chunk_counts[source_vertex];
+            TOY_CHECK(decode_handedness(chunk.positions[i]) == mesh.tangents[source_vertex].w);
+        }
+    }
+    TOY_CHECK(indices == mesh.indices);
+    // Only vertices on chunk borders are duplicated
+    TOY_CHECK(std::all_of(chunk_counts.begin(), chunk_counts.end(), [](uint32_t count) { return count >= 1 && count <= 2; }));
+
+    QuantizationError error = measure_quantization_error(streams, chunks);
+    DX_INFO("Quantization error: position {:.3e}, normal {:.3e} rad, tangent {:.3e} rad, texcoord {:.3e}",
+            error.position, error.normal, error.tangent, error.texcoord);
+    TOY_CHECK(within_error_bounds(error, mesh.bounding_box));
+
+    TOY_CHECK(quantized_byte_width(chunks) < full_precision_byte_width(mesh.positions.size(), mesh.indices.size(), streams.texcoords.size()));
+
+    // Nothing to draw, nothing to encode
+    TestMesh empty_mesh{};
+    TOY_CHECK(quantize_vertex_streams(empty_mesh.get_streams()).empty());
+}
@@ -0,0 +1,1705 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Core/parallel.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Core/virtual_file_system.h>
+#include <Toy/Model/mesh_import.h>
+#include <Toy/Model/mesh_codec.h>
+#include <Toy/Model/gltf_import.h>
+#include <Toy/Model/dds_file.h>
+#include <Toy/Model/hdr_image.h>
+#include <Toy/Model/mip_generator.h>
+#include <Toy/Model/texture_decoder.h>
+#include <Toy/Renderer/ibl_cache.h>
+#include <Toy/Renderer/shader_reflection.h>
+#include <Toy/Renderer/spherical_harmonics.h>
+
+#include <stb_image.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Offline asset baker
+//   ToyBake [--force] [--quantized] [--encoded] [--jobs n]
+//   ToyBake bench <model> [--quantized] [--encoded] [--rounds n]
+//   ToyBake bench-codec <model> [--quantized] [--rounds n]
+//   ToyBake bench-decode [--threads n] [--rounds n]
+//   ToyBake bench-hdr [file.hdr] [--size width height] [--rounds n]
+//   ToyBake bench-dds [--size n] [--rounds n]
+//   ToyBake bench-ibl [file.hdr] [--size n] [--rounds n]
+// Walk data directory of project root and bake derived assets into the content addressed caches the engine loads from,
+// no device is created, so it runs on build machines without GPU
+//   mesh       processed mesh cache of every model imported via Assimp
+//   texture    texture cache of every block compressed texture those models reference
+//   ibl        environment map of every Radiance image, and the BRDF LUT
+//   shader     manifest of bindings and signatures of every compiled shader, reflected from the bytecode effects cache
+//              HLSL is compiled by D3DCompiler on Windows only, so the stage reflects existing .cso files instead of compiling
+// Bake graph of the last run is kept with the caches, a node whose inputs are unchanged and whose outputs exist is not baked again
+// --force ignores the bake graph, --quantized bakes quantized instead of full precision vertex streams, --encoded stores mesh streams
+// encoded by mesh_codec, see MeshStreamStorage, --jobs limits worker threads
+// bench times cold load, Assimp import writing processed mesh cache, against warm load, cache validation and stream decoding,
+// which is the CPU work of a model load before its buffers are created
+// bench-codec encodes the streams of a model as the cache would store them, times decoding per stream kind and reports the disk read
+// rate below which encoded storage loads faster than plain storage, glTF streams are taken from the native importer at full precision
+// bench-decode runs the decode stage of texture batches over every image of data directory on 1, 2, 4 ... n threads, default every
+// hardware thread, and reports speedup against one thread
+// bench-hdr decodes a Radiance image by stb image to RGBA32F and by hdr_image to RGBA16F and RGB9E5, without file an RLE encoded
+// sky of size, default 8192 x 4096, is synthesized in memory
+// bench-dds loads every DDS of data directory by whole file read into heap, as DDSTextureLoader does, against mapping, both parse
+// and copy every subresource as the driver would, cold after dropping the file from page cache, where the platform allows, and warm,
+// --size adds a synthesized BC7 n x n texture with full mip chain
+// bench-ibl times the CPU side of an environment switch, as PreProcessEffect::compute_ibl does it, on IBL cache miss, baking maps of
+// size, default 128, on CPU, and on hit, cold and warm, loading an environment cache of engine size, nothing is uploaded
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::model;
+
+    const std::array<std::string, 6> s_model_extensions = { ".obj", ".fbx", ".dae", ".3ds", ".ply", ".stl" };
+    const std::array<std::string, 5> s_image_extensions = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+    const std::filesystem::path s_data_dir(DXTOY_HOME "data");
+    const std::filesystem::path s_excluded_dir(DXTOY_HOME "data/cache");
+    const std::filesystem::path s_graph_path(DXTOY_HOME "data/cache/bake.graph");
+    const std::filesystem::path s_shader_manifest_path(DXTOY_HOME "data/cache/shaders.json");
+
+    constexpr uint32_t s_graph_magic = 0x4B425454;         // "TTBK"
+    constexpr uint32_t s_graph_version = 2;                 // Bump when node layout or cache versions change
+
+    enum class Stage : uint32_t
+    {
+        Mesh,
+        Texture,
+        Ibl,
+        Shader,                                 // Not kept in bake graph, reflection is cheap and manifest is written whole
+        Count
+    };
+
+    constexpr std::array<std::string_view, static_cast<size_t>(Stage::Count)> s_stage_names = { "mesh", "texture", "ibl", "shader" };
+
+    // Input file as it was when node was baked, unchanged size and write time spare hashing the file again
+    struct BakeInput
+    {
+        std::string path;
+        uint64_t size = 0;
+        int64_t write_time = 0;
+        XID content_id = 0;
+    };
+
+    struct BakeNode
+    {
+        Stage stage = Stage::Mesh;
+        std::string source;                     // Model, texture or Radiance image, model holding an embedded texture
+        std::string name;                       // Texture name, name of embedded texture differs from source
+        uint32_t options = 0;                   // Vertex encoding and stream storage of mesh, usage of texture
+        uint32_t enable_mips = 0;
+        uint32_t force_SRGB = 0;
+        std::vector<BakeInput> inputs;
+        std::vector<std::string> outputs;
+        std::vector<std::string> children;      // Texture nodes found in model
+
+        [[nodiscard]] bool is_embedded() const { return name != source; }
+    };
+
+    using BakeGraph = std::unordered_map<std::string, BakeNode>;
+
+    std::string get_node_key(Stage stage, std::string_view name, uint32_t options, uint32_t enable_mips = 0, uint32_t force_SRGB = 0)
+    {
+        return fmt::format("{}:{}:{}:{}:{}", s_stage_names[static_cast<size_t>(stage)], options, enable_mips, force_SRGB, name);
+    }
+
+    double milliseconds_since(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    std::string get_lower_extension(const std::filesystem::path& file_path)
+    {
+        std::string extension = file_path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+
+    // Bake graph file, nodes of the last run with their input records
+    class GraphWriter
+    {
+    public:
+        template <typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto bytes = reinterpret_cast<const uint8_t *>(&value);
+            m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+        }
+
+        void write_string(std::string_view str)
+        {
+            write(static_cast<uint32_t>(str.size()));
+            m_data.insert(m_data.end(), str.begin(), str.end());
+        }
+
+        [[nodiscard]] std::span<const uint8_t> data() const { return m_data; }
+
+    private:
+        std::vector<uint8_t> m_data;
+    };
+
+    // Reads past the end leave reader failed and return zero values
+    class GraphReader
+    {
+    public:
+        explicit GraphReader(std::span<const uint8_t> data) : m_data(data) {}
+
+        template <typename T>
+        T read()
+        {
+            T value{};
+            if (!m_failed && sizeof(T) <= m_data.size() - m_offset)
+            {
+                std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+                m_offset += sizeof(T);
+            } else
+            {
+                m_failed = true;
+            }
+            return value;
+        }
+
+        std::string read_string()
+        {
+            auto size = read<uint32_t>();
+            if (m_failed || size > m_data.size() - m_offset)
+            {
+                m_failed = true;
+                return {};
+            }
+            std::string str(reinterpret_cast<const char *>(m_data.data() + m_offset), size);
+            m_offset += size;
+            return str;
+        }
+
+        // Every element takes at least min_byte_width bytes, so a corrupt count fails instead of allocating
+        size_t read_count(size_t min_byte_width)
+        {
+            auto count = read<uint32_t>();
+            if (m_failed || count > (m_data.size() - m_offset) / min_byte_width)
+            {
+                m_failed = true;
+                return 0;
+            }
+            return count;
+        }
+
+        [[nodiscard]] bool failed() const { return m_failed; }
+
+    private:
+        std::span<const uint8_t> m_data;
+        size_t m_offset = 0;
+        bool m_failed = false;
+    };
+
+    // Missing, outdated or malformed graph bakes everything again
+    BakeGraph load_graph(const std::filesystem::path& graph_path)
+    {
+        MappedFile file(graph_path);
+        if (!file.is_open())
+        {
+            return {};
+        }
+
+        GraphReader reader(file.bytes());
+        if (reader.read<uint32_t>() != s_graph_magic || reader.read<uint32_t>() != s_graph_version)
+        {
+            return {};
+        }
+        BakeGraph graph{};
+        size_t node_count = reader.read_count(sizeof(uint32_t));
+        for (size_t i = 0; i < node_count && !reader.failed(); ++i)
+        {
+            std::string key = reader.read_string();
+            BakeNode node{};
+            node.stage = static_cast<Stage>(reader.read<uint32_t>());
+            node.source = reader.read_string();
+            node.name = reader.read_string();
+            node.options = reader.read<uint32_t>();
+            node.enable_mips = reader.read<uint32_t>();
+            node.force_SRGB = reader.read<uint32_t>();
+            node.inputs.resize(reader.read_count(sizeof(uint32_t) + sizeof(uint64_t) + sizeof(int64_t) + sizeof(XID)));
+            for (auto&& input : node.inputs)
+            {
+                input.path = reader.read_string();
+                input.size = reader.read<uint64_t>();
+                input.write_time = reader.read<int64_t>();
+                input.content_id = reader.read<XID>();
+            }
+            node.outputs.resize(reader.read_count(sizeof(uint32_t)));
+            for (auto&& output : node.outputs)
+            {
+                output = reader.read_string();
+            }
+            node.children.resize(reader.read_count(sizeof(uint32_t)));
+            for (auto&& child : node.children)
+            {
+                child = reader.read_string();
+            }
+            if (node.stage >= Stage::Count)
+            {
+                return {};
+            }
+            graph.emplace(std::move(key), std::move(node));
+        }
+        return reader.failed() ? BakeGraph{} : std::move(graph);
+    }
+
+    // Written atomically, an interrupted run leaves the previous file
+    bool write_file(const std::filesystem::path& file_path, std::span<const uint8_t> data)
+    {
+        std::error_code error_code{};
+        std::filesystem::create_directories(file_path.parent_path(), error_code);
+        std::filesystem::path temp_path = file_path;
+        temp_path += ".tmp";
+        {
+            std::ofstream file_stream(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file_stream.is_open())
+            {
+                return false;
+            }
+            file_stream.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file_stream.good())
+            {
+                return false;
+            }
+        }
+        std::filesystem::rename(temp_path, file_path, error_code);
+        return !error_code;
+    }
+
+    bool save_graph(const std::filesystem::path& graph_path, const BakeGraph& graph)
+    {
+        GraphWriter writer{};
+        writer.write(s_graph_magic);
+        writer.write(s_graph_version);
+        writer.write(static_cast<uint32_t>(graph.size()));
+        for (auto&& [key, node] : graph)
+        {
+            writer.write_string(key);
+            writer.write(static_cast<uint32_t>(node.stage));
+            writer.write_string(node.source);
+            writer.write_string(node.name);
+            writer.write(node.options);
+            writer.write(node.enable_mips);
+            writer.write(node.force_SRGB);
+            writer.write(static_cast<uint32_t>(node.inputs.size()));
+            for (auto&& input : node.inputs)
+            {
+                writer.write_string(input.path);
+                writer.write(input.size);
+                writer.write(input.write_time);
+                writer.write(input.content_id);
+            }
+            writer.write(static_cast<uint32_t>(node.outputs.size()));
+            for (auto&& output : node.outputs)
+            {
+                writer.write_string(output);
+            }
+            writer.write(static_cast<uint32_t>(node.children.size()));
+            for (auto&& child : node.children)
+            {
+                writer.write_string(child);
+            }
+        }
+        return write_file(graph_path, writer.data());
+    }
+
+    // Record input before it is baked, so that an edit during the bake is seen by the next run
+    BakeInput record_input(const std::string& path)
+    {
+        BakeInput input{ path };
+        std::error_code error_code{};
+        input.size = std::filesystem::file_size(path, error_code);
+        input.write_time = std::filesystem::last_write_time(path, error_code).time_since_epoch().count();
+        input.content_id = VirtualFileSystem::get().get_content_id(path);
+        return input;
+    }
+
+    // Touched file is hashed again, a file saved with the same content is still unchanged
+    bool is_input_unchanged(BakeInput& input)
+    {
+        std::error_code error_code{};
+        uint64_t size = std::filesystem::file_size(input.path, error_code);
+        if (error_code || size != input.size)
+        {
+            return false;
+        }
+        int64_t write_time = std::filesystem::last_write_time(input.path, error_code).time_since_epoch().count();
+        if (error_code)
+        {
+            return false;
+        }
+        if (write_time != input.write_time)
+        {
+            if (VirtualFileSystem::get().get_content_id(input.path) != input.content_id)
+            {
+                return false;
+            }
+            input.write_time = write_time;
+        }
+        return true;
+    }
+
+    bool is_up_to_date(BakeNode& node)
+    {
+        return std::all_of(node.outputs.begin(), node.outputs.end(), [](const std::string& output) { return std::filesystem::exists(output); }) &&
+               std::all_of(node.inputs.begin(), node.inputs.end(), [](BakeInput& input) { return is_input_unchanged(input); });
+    }
+
+    struct StageStatistics
+    {
+        std::atomic<size_t> up_to_date = 0;         // Not baked since bake graph has it
+        std::atomic<size_t> cached = 0;             // Cache entry of the same content already existed
+        std::atomic<size_t> baked = 0;
+        std::atomic<size_t> skipped = 0;
+        std::atomic<size_t> failed = 0;
+        std::atomic<int64_t> time_us = 0;           // Summed over workers
+    };
+
+    struct ShaderEntry
+    {
+        std::string path;
+        ShaderReflection reflection;
+    };
+
+    class Baker
+    {
+    public:
+        Baker(BakeGraph&& previous_graph, size_t num_threads, VertexEncoding vertex_encoding, MeshStreamStorage stream_storage)
+            : m_previous_graph(std::move(previous_graph)), m_pool(num_threads), m_vertex_encoding(vertex_encoding), m_stream_storage(stream_storage) {}
+
+        void bake(std::span<const std::string> model_files, std::span<const std::string> hdr_files, std::span<const std::string> shader_files)
+        {
+            for (auto&& model_file : model_files)
+            {
+                m_pool.submit([this, model_file]() { bake_model(model_file); });
+            }
+            for (auto&& hdr_file : hdr_files)
+            {
+                m_pool.submit([this, hdr_file]() { bake_ibl(hdr_file); });
+            }
+            for (auto&& shader_file : shader_files)
+            {
+                m_pool.submit([this, shader_file]() { bake_shader(shader_file); });
+            }
+            m_pool.wait();
+        }
+
+        [[nodiscard]] const BakeGraph& get_graph() const { return m_graph; }
+        [[nodiscard]] const std::vector<ShaderEntry>& get_shaders() const { return m_shaders; }
+        [[nodiscard]] const StageStatistics& get_statistics(Stage stage) const { return m_statistics[static_cast<size_t>(stage)]; }
+        [[nodiscard]] size_t get_thread_count() const { return m_pool.get_thread_count(); }
+        [[nodiscard]] size_t get_steal_count() const { return m_pool.get_steal_count(); }
+
+    private:
+        // Node of the last run, copied since its input records are refreshed
+        std::optional<BakeNode> find_previous(const std::string& key) const
+        {
+            auto it = m_previous_graph.find(key);
+            return it != m_previous_graph.end() ? std::optional<BakeNode>(it->second) : std::nullopt;
+        }
+
+        // Texture shared by several models is only visited by the first
+        bool claim(const std::string& key)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_visited.insert(key).second;
+        }
+
+        void record(const std::string& key, BakeNode&& node)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_graph.insert_or_assign(key, std::move(node));
+        }
+
+        void finish(Stage stage, std::optional<BakeStatus> status, std::chrono::steady_clock::time_point start_time)
+        {
+            auto&& statistics = m_statistics[static_cast<size_t>(stage)];
+            if (!status)
+            {
+                ++statistics.up_to_date;
+            } else if (*status == BakeStatus::Cached)
+            {
+                ++statistics.cached;
+            } else if (*status == BakeStatus::Baked)
+            {
+                ++statistics.baked;
+            } else if (*status == BakeStatus::Skipped)
+            {
+                ++statistics.skipped;
+            } else
+            {
+                ++statistics.failed;
+            }
+            statistics.time_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+        }
+
+        // Failed node is left out of the graph, so that it is baked again next time
+        void record_result(const std::string& key, BakeNode&& node, const BakeResult& result)
+        {
+            if (result.status == BakeStatus::Failed)
+            {
+                return;
+            }
+            for (auto&& output : result.outputs)
+            {
+                node.outputs.push_back(output.string());
+            }
+            record(key, std::move(node));
+        }
+
+        void bake_model(const std::string& file_name)
+        {
+            auto start_time = std::chrono::steady_clock::now();
+            // Stream storage in the high half, so that plain nodes keep the keys of earlier graphs
+            uint32_t mesh_options = static_cast<uint32_t>(m_vertex_encoding) | (static_cast<uint32_t>(m_stream_storage) << 16);
+            std::string key = get_node_key(Stage::Mesh, file_name, mesh_options);
+
+            // Embedded textures are only baked along with their model, so a missing one makes the model out of date
+            if (auto node = find_previous(key); node && is_up_to_date(*node) &&
+                std::all_of(node->children.begin(), node->children.end(), [this](const std::string& child_key)
+                {
+                    auto child = find_previous(child_key);
+                    return child && (!child->is_embedded() || is_up_to_date(*child));
+                }))
+            {
+                for (auto&& child_key : node->children)
+                {
+                    if (claim(child_key))
+                    {
+                        auto previous_child = find_previous(child_key);
+                        m_pool.submit([this, child_key, child = std::move(*previous_child)]() mutable
+                        {
+                            bake_texture(child_key, std::move(child), {}, nullptr);
+                        });
+                    }
+                }
+                record(key, std::move(*node));
+                finish(Stage::Mesh, std::nullopt, start_time);
+                return;
+            }
+
+            BakeNode node{ Stage::Mesh, file_name, file_name, mesh_options };
+            node.inputs.push_back(record_input(file_name));
+            BakeResult result{ BakeStatus::Failed, {} };
+            try
+            {
+                result = bake_mesh_cache(file_name, m_vertex_encoding, m_stream_storage);
+            } catch (const std::exception& exception)
+            {
+                DX_ERROR("Fail to bake model '{}': {}", file_name, exception.what());
+            }
+
+            // Textures are found in the cache image, embedded ones point into the mapping which lives until their tasks finish
+            if (!result.outputs.empty())
+            {
+                auto cache_file = std::make_shared<MappedFile>(result.outputs.front());
+                // Material libraries read by import are inputs as well
+                for (auto dependency : cache_file->is_open() ? get_mesh_cache_dependencies(cache_file->bytes()) : std::vector<std::string_view>{})
+                {
+                    if (std::filesystem::exists(dependency))
+                    {
+                        node.inputs.push_back(record_input(std::string(dependency)));
+                    }
+                }
+                auto texture_sources = cache_file->is_open() ? get_mesh_cache_textures(cache_file->bytes()) : std::vector<TextureSource>{};
+                for (auto&& texture_source : texture_sources)
+                {
+                    auto usage = static_cast<uint32_t>(texture_source.usage);
+                    uint32_t enable_mips = texture_source.enable_mips ? 1 : 0;
+                    std::string child_key = get_node_key(Stage::Texture, texture_source.name, usage, enable_mips, texture_source.force_SRGB);
+                    node.children.push_back(child_key);
+                    if (!claim(child_key))
+                    {
+                        continue;
+                    }
+
+                    BakeNode child{ Stage::Texture, texture_source.data.empty() ? texture_source.name : file_name, texture_source.name,
+                                    usage, enable_mips, texture_source.force_SRGB };
+                    m_pool.submit([this, child_key, child = std::move(child), data = texture_source.data, cache_file]() mutable
+                    {
+                        bake_texture(child_key, std::move(child), data, cache_file);
+                    });
+                }
+            }
+            record_result(key, std::move(node), result);
+            finish(Stage::Mesh, result.status, start_time);
+        }
+
+        // Node of the last run is baked again only when out of date, new node has no inputs recorded yet
+        void bake_texture(const std::string& key, BakeNode&& node, std::span<const uint8_t> data, const std::shared_ptr<MappedFile>& owner)
+        {
+            auto start_time = std::chrono::steady_clock::now();
+            if (!node.inputs.empty() && is_up_to_date(node))
+            {
+                record(key, std::move(node));
+                finish(Stage::Texture, std::nullopt, start_time);
+                return;
+            }
+
+            // File texture out of date with its model up to date is rebuilt from the node alone
+            node.inputs = { record_input(node.source) };
+            node.outputs.clear();
+            TextureSource source{ node.name, data, node.enable_mips != 0, node.force_SRGB, static_cast<TextureUsage>(node.options) };
+            BakeResult result{ BakeStatus::Failed, {} };
+            if (node.is_embedded() && !owner)
+            {
+                DX_ERROR("Embedded texture '{}' is missing its model", node.name);
+            } else
+            {
+                try
+                {
+                    result = bake_texture_cache(source);
+                } catch (const std::exception& exception)
+                {
+                    DX_ERROR("Fail to bake texture '{}': {}", node.name, exception.what());
+                }
+            }
+            record_result(key, std::move(node), result);
+            finish(Stage::Texture, result.status, start_time);
+        }
+
+        void bake_ibl(const std::string& file_name)
+        {
+            auto start_time = std::chrono::steady_clock::now();
+            std::string key = get_node_key(Stage::Ibl, file_name, 0);
+            if (auto node = find_previous(key); node && is_up_to_date(*node))
+            {
+                record(key, std::move(*node));
+                finish(Stage::Ibl, std::nullopt, start_time);
+                return;
+            }
+
+            BakeNode node{ Stage::Ibl, file_name, file_name };
+            node.inputs.push_back(record_input(file_name));
+            std::filesystem::path environment_path = ibl_environment_cache_path(ibl_cache_key(node.inputs.front().content_id));
+            BakeResult result{ BakeStatus::Failed, {} };
+            if (node.inputs.front().content_id != 0)
+            {
+                bool cached = std::filesystem::exists(environment_path) && std::filesystem::exists(ibl_brdf_lut_cache_path());
+                if (cached || bake_ibl_cache(file_name))
+                {
+                    result = { cached ? BakeStatus::Cached : BakeStatus::Baked, { environment_path, ibl_brdf_lut_cache_path() } };
+                }
+            }
+            record_result(key, std::move(node), result);
+            finish(Stage::Ibl, result.status, start_time);
+        }
+
+        void bake_shader(const std::string& file_name)
+        {
+            auto start_time = std::chrono::steady_clock::now();
+            MappedFile file(file_name);
+            auto reflection = file.is_open() ? reflect_shader(file.bytes()) : std::nullopt;
+            if (!reflection)
+            {
+                DX_ERROR("Fail to reflect shader '{}', bytecode is missing or malformed", file_name);
+                finish(Stage::Shader, BakeStatus::Failed, start_time);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_shaders.push_back({ file_name, std::move(*reflection) });
+            }
+            finish(Stage::Shader, BakeStatus::Baked, start_time);
+        }
+
+        BakeGraph m_previous_graph;
+        BakeGraph m_graph;
+        std::unordered_set<std::string> m_visited;
+        std::vector<ShaderEntry> m_shaders;
+        std::mutex m_mutex;
+        std::array<StageStatistics, static_cast<size_t>(Stage::Count)> m_statistics;
+        TaskPool m_pool;
+        VertexEncoding m_vertex_encoding;
+        MeshStreamStorage m_stream_storage;
+    };
+
+    // Sorted, so that the order of submission does not depend on the file system
+    void collect_sources(std::vector<std::string>& model_files, std::vector<std::string>& hdr_files, std::vector<std::string>& shader_files)
+    {
+        std::error_code error_code{};
+        for (auto it = std::filesystem::recursive_directory_iterator(s_data_dir, error_code);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error_code))
+        {
+            if (error_code)
+            {
+                break;
+            }
+            if (it->is_directory() && it->path() == s_excluded_dir)
+            {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (!it->is_regular_file())
+            {
+                continue;
+            }
+
+            std::string extension = get_lower_extension(it->path());
+            if (std::find(s_model_extensions.begin(), s_model_extensions.end(), extension) != s_model_extensions.end())
+            {
+                model_files.push_back(it->path().generic_string());
+            } else if (extension == ".hdr")
+            {
+                hdr_files.push_back(it->path().generic_string());
+            } else if (extension == ".cso")
+            {
+                shader_files.push_back(it->path().generic_string());
+            }
+        }
+        std::sort(model_files.begin(), model_files.end());
+        std::sort(hdr_files.begin(), hdr_files.end());
+        std::sort(shader_files.begin(), shader_files.end());
+    }
+
+    std::string quote_json(std::string_view str)
+    {
+        std::string quoted = "\"";
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+                quoted += c;
+            } else if (static_cast<uint8_t>(c) < 0x20)
+            {
+                quoted += fmt::format("\\u{:04x}", static_cast<uint32_t>(c));
+            } else
+            {
+                quoted += c;
+            }
+        }
+        quoted += '"';
+        return quoted;
+    }
+
+    void format_parameters(std::string& text, std::string_view key, std::span<const ShaderParameter> parameters)
+    {
+        fmt::format_to(std::back_inserter(text), ",\n      \"{}\": [", key);
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto&& parameter = parameters[i];
+            fmt::format_to(std::back_inserter(text), "{}\n        {{ \"semantic\": {}, \"index\": {}, \"register\": {}, \"mask\": {} }}",
+                           i ? "," : "", quote_json(parameter.semantic), parameter.semantic_index, parameter.reg, parameter.mask);
+        }
+        text += parameters.empty() ? "]" : "\n      ]";
+    }
+
+    // Manifest of shaders sorted by path, file is only replaced when its content changes, so that its write time means something
+    bool save_shader_manifest(const std::filesystem::path& manifest_path, std::vector<ShaderEntry> shaders)
+    {
+        std::sort(shaders.begin(), shaders.end(), [](const ShaderEntry& a, const ShaderEntry& b) { return a.path < b.path; });
+        std::string text = "{\n  \"shaders\": [";
+        for (size_t i = 0; i < shaders.size(); ++i)
+        {
+            auto&& [path, reflection] = shaders[i];
+            fmt::format_to(std::back_inserter(text), "{}\n    {{\n      \"path\": {},\n      \"profile\": \"{}_{}_{}\",\n      \"content_id\": \"{:016x}\"",
+                           i ? "," : "", quote_json(path), get_shader_stage_name(reflection.stage), reflection.major_version,
+                           reflection.minor_version, reflection.content_id);
+
+            text += ",\n      \"constant_buffers\": [";
+            for (size_t j = 0; j < reflection.constant_buffers.size(); ++j)
+            {
+                auto&& constant_buffer = reflection.constant_buffers[j];
+                fmt::format_to(std::back_inserter(text), "{}\n        {{ \"name\": {}, \"byte_width\": {}, \"variables\": {} }}",
+                               j ? "," : "", quote_json(constant_buffer.name), constant_buffer.byte_width, constant_buffer.variable_count);
+            }
+            text += reflection.constant_buffers.empty() ? "]" : "\n      ]";
+
+            text += ",\n      \"bindings\": [";
+            for (size_t j = 0; j < reflection.bindings.size(); ++j)
+            {
+                auto&& binding = reflection.bindings[j];
+                fmt::format_to(std::back_inserter(text), "{}\n        {{ \"name\": {}, \"type\": \"{}\", \"bind_point\": {}, \"bind_count\": {}, \"space\": {} }}",
+                               j ? "," : "", quote_json(binding.name), get_shader_binding_type_name(binding.type), binding.bind_point,
+                               binding.bind_count, binding.space);
+            }
+            text += reflection.bindings.empty() ? "]" : "\n      ]";
+
+            format_parameters(text, "inputs", reflection.inputs);
+            format_parameters(text, "outputs", reflection.outputs);
+            text += "\n    }";
+        }
+        text += shaders.empty() ? "]\n}\n" : "\n  ]\n}\n";
+
+        MappedFile previous(manifest_path);
+        if (previous.is_open() && std::string_view(reinterpret_cast<const char *>(previous.bytes().data()), previous.size()) == text)
+        {
+            return true;
+        }
+        previous = {};
+        return write_file(manifest_path, { reinterpret_cast<const uint8_t *>(text.data()), text.size() });
+    }
+
+    // Decode every encoded stream of cache image, as load_mesh_cache does before creating buffers
+    bool decode_mesh_cache_streams(std::span<const uint8_t> image, std::vector<uint8_t>& decoded)
+    {
+        auto&& header = *reinterpret_cast<const MeshCacheHeader *>(image.data());
+        auto meshes = std::span(reinterpret_cast<const MeshCacheMesh *>(image.data() + header.meshes.offset), header.mesh_count);
+        auto decode = [&image, &decoded](const MeshCacheBlob& blob)
+        {
+            if (blob.decoded_byte_width == 0)
+            {
+                return true;
+            }
+            decoded.resize(blob.decoded_byte_width);
+            return decode_mesh_stream(image.subspan(blob.offset, blob.byte_width), decoded);
+        };
+        for (auto&& mesh : meshes)
+        {
+            bool decoded_all = decode(mesh.positions) && decode(mesh.normals) && decode(mesh.tangents) && decode(mesh.bitangents) &&
+                               decode(mesh.indices);
+            for (uint32_t row = 0; row < mesh.texcoord_count; ++row)
+            {
+                decoded_all = decoded_all && decode(mesh.texcoords[row]);
+            }
+            if (!decoded_all)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Cold round removes the cache of model first, so that every cold round imports
+    int bench(const std::string& file_name, VertexEncoding vertex_encoding, MeshStreamStorage stream_storage, uint32_t rounds)
+    {
+        double cold_time = 0.0, warm_time = 0.0;
+        size_t cache_size = 0;
+        std::vector<uint8_t> decoded{};
+        for (uint32_t round = 0; round < rounds; ++round)
+        {
+            BakeResult result = bake_mesh_cache(file_name, vertex_encoding, stream_storage);
+            if (result.outputs.empty())
+            {
+                DX_ERROR("Model '{}' has no processed mesh cache, glTF is loaded natively", file_name);
+                return 1;
+            }
+            std::error_code error_code{};
+            std::filesystem::remove(result.outputs.front(), error_code);
+
+            auto start_time = std::chrono::steady_clock::now();
+            result = bake_mesh_cache(file_name, vertex_encoding, stream_storage);
+            cold_time += milliseconds_since(start_time);
+            if (result.status != BakeStatus::Baked)
+            {
+                DX_ERROR("Fail to import model '{}'", file_name);
+                return 1;
+            }
+
+            start_time = std::chrono::steady_clock::now();
+            result = bake_mesh_cache(file_name, vertex_encoding, stream_storage);
+            MappedFile cache_file(result.outputs.front());
+            bool is_loaded = result.status == BakeStatus::Cached && cache_file.is_open() && decode_mesh_cache_streams(cache_file.bytes(), decoded);
+            warm_time += milliseconds_since(start_time);
+            if (!is_loaded)
+            {
+                DX_ERROR("Fail to load processed mesh cache of model '{}'", file_name);
+                return 1;
+            }
+            cache_size = cache_file.size();
+        }
+
+        DX_INFO("Model '{}', {} rounds, cache {:.2f} MB, cold {:.2f} ms, warm {:.2f} ms, {:.1f}x", file_name, rounds,
+                static_cast<double>(cache_size) / (1024.0 * 1024.0), cold_time / rounds, warm_time / rounds,
+                warm_time > 0.0 ? cold_time / warm_time : 0.0);
+        return 0;
+    }
+
+    // Mesh stream as load_mesh_cache uploads it
+    struct CodecStream
+    {
+        std::vector<uint8_t> data;
+        uint32_t stride = 0;
+        bool is_index = false;
+    };
+
+    // glTF primitives are converted as load_gltf does, other models are read back from their plain processed mesh cache
+    bool collect_codec_streams(const std::string& file_name, VertexEncoding vertex_encoding, std::vector<CodecStream>& streams)
+    {
+        auto add_stream = [&streams](const void* data, size_t count, uint32_t stride, bool is_index)
+        {
+            if (count > 0)
+            {
+                auto bytes = static_cast<const uint8_t *>(data);
+                streams.push_back({ std::vector<uint8_t>(bytes, bytes + count * stride), stride, is_index });
+            }
+        };
+
+        if (is_gltf_file(file_name))
+        {
+            GltfModel gltf_model{};
+            if (!import_gltf(file_name, gltf_model))
+            {
+                return false;
+            }
+            for (auto&& mesh : gltf_model.meshes)
+            {
+                add_stream(mesh.positions.data(), mesh.positions.size(), sizeof(DirectX::XMFLOAT3), false);
+                add_stream(mesh.normals.data(), mesh.normals.size(), sizeof(DirectX::XMFLOAT3), false);
+                add_stream(mesh.tangents.data(), mesh.tangents.size(), sizeof(DirectX::XMFLOAT4), false);
+                add_stream(mesh.bitangents.data(), mesh.bitangents.size(), sizeof(DirectX::XMFLOAT4), false);
+                for (auto&& texcoords : mesh.texcoords)
+                {
+                    add_stream(texcoords.data(), texcoords.size(), sizeof(DirectX::XMFLOAT2), false);
+                }
+                if (mesh.positions.size() <= 65536)
+                {
+                    std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+                    add_stream(indices.data(), indices.size(), sizeof(uint16_t), true);
+                } else
+                {
+                    add_stream(mesh.indices.data(), mesh.indices.size(), sizeof(uint32_t), true);
+                }
+            }
+            return true;
+        }
+
+        BakeResult result = bake_mesh_cache(file_name, vertex_encoding, MeshStreamStorage::Plain);
+        MappedFile cache_file(result.outputs.empty() ? std::filesystem::path{} : result.outputs.front());
+        if (!cache_file.is_open())
+        {
+            return false;
+        }
+        auto image = cache_file.bytes();
+        auto&& header = *reinterpret_cast<const MeshCacheHeader *>(image.data());
+        for (auto&& mesh : get_mesh_cache_blob<MeshCacheMesh>(image, header.meshes))
+        {
+            auto add_blob = [&image, &add_stream, &mesh](const MeshCacheBlob& blob, bool is_index)
+            {
+                uint32_t count = is_index ? mesh.index_count : mesh.vertex_count;
+                if (blob.byte_width > 0 && count > 0)
+                {
+                    add_stream(image.data() + blob.offset, count, static_cast<uint32_t>(blob.byte_width / count), is_index);
+                }
+            };
+            add_blob(mesh.positions, false);
+            add_blob(mesh.normals, false);
+            add_blob(mesh.tangents, false);
+            add_blob(mesh.bitangents, false);
+            for (uint32_t row = 0; row < mesh.texcoord_count; ++row)
+            {
+                add_blob(mesh.texcoords[row], false);
+            }
+            add_blob(mesh.indices, true);
+        }
+        return true;
+    }
+
+    // Streams are encoded under the rule of MeshCacheWriter, a stream left plain costs nothing to load and is not timed
+    // Encoded storage reads fewer bytes but decodes all of them, it loads faster once disk reads are slower than
+    // decode rate * saved bytes / plain bytes, which is the break-even rate reported
+    int bench_codec(const std::string& file_name, VertexEncoding vertex_encoding, uint32_t rounds)
+    {
+        std::vector<CodecStream> streams{};
+        if (!collect_codec_streams(file_name, vertex_encoding, streams))
+        {
+            DX_ERROR("Fail to read mesh streams of model '{}'", file_name);
+            return 1;
+        }
+
+        struct KindStatistics
+        {
+            size_t plain_bytes = 0;
+            size_t stored_bytes = 0;
+            size_t decoded_bytes = 0;
+            double decode_time = 0.0;
+        };
+        std::array<KindStatistics, 2> statistics{};
+        std::vector<uint8_t> decoded{};
+        for (auto&& stream : streams)
+        {
+            size_t count = stream.data.size() / stream.stride;
+            auto encoded = stream.is_index ? encode_index_buffer(stream.data.data(), count, stream.stride) :
+                           encode_vertex_stream(stream.data.data(), count, stream.stride);
+            auto&& kind = statistics[stream.is_index ? 1 : 0];
+            kind.plain_bytes += stream.data.size();
+            if (encoded.empty() || static_cast<float>(encoded.size()) > static_cast<float>(stream.data.size()) * mesh_cache_max_encoded_ratio)
+            {
+                kind.stored_bytes += stream.data.size();
+                continue;
+            }
+            kind.stored_bytes += encoded.size();
+            kind.decoded_bytes += stream.data.size();
+
+            decoded.resize(stream.data.size());
+            auto start_time = std::chrono::steady_clock::now();
+            for (uint32_t round = 0; round < rounds; ++round)
+            {
+                if (!decode_mesh_stream(encoded, decoded))
+                {
+                    DX_ERROR("Fail to decode mesh stream of model '{}'", file_name);
+                    return 1;
+                }
+            }
+            kind.decode_time += milliseconds_since(start_time) / rounds;
+            if (std::memcmp(decoded.data(), stream.data.data(), decoded.size()) != 0)
+            {
+                DX_ERROR("Decoded mesh stream of model '{}' differs from source", file_name);
+                return 1;
+            }
+        }
+
+        auto to_mb = [](size_t byte_width) { return static_cast<double>(byte_width) / (1024.0 * 1024.0); };
+        auto to_gbps = [](size_t byte_width, double time) { return time > 0.0 ? static_cast<double>(byte_width) / (time * 1.0e6) : 0.0; };
+        constexpr std::array<std::string_view, 2> kind_names = { "vertex", "index" };
+        KindStatistics total{};
+        for (size_t i = 0; i < statistics.size(); ++i)
+        {
+            auto&& kind = statistics[i];
+            DX_INFO("{:<6} plain {:.2f} MB, stored {:.2f} MB ({:.1f}%), decode {:.2f} ms, {:.2f} GB/s", kind_names[i], to_mb(kind.plain_bytes),
+                    to_mb(kind.stored_bytes), kind.plain_bytes > 0 ? 100.0 * static_cast<double>(kind.stored_bytes) / static_cast<double>(kind.plain_bytes) : 0.0,
+                    kind.decode_time, to_gbps(kind.decoded_bytes, kind.decode_time));
+            total.plain_bytes += kind.plain_bytes;
+            total.stored_bytes += kind.stored_bytes;
+            total.decoded_bytes += kind.decoded_bytes;
+            total.decode_time += kind.decode_time;
+        }
+
+        // Seconds per byte: stored / rate + decode_time = plain / rate at break-even
+        double saved_bytes = static_cast<double>(total.plain_bytes - total.stored_bytes);
+        double break_even_rate = total.decode_time > 0.0 ? saved_bytes / (total.decode_time * 1.0e-3) / (1024.0 * 1024.0) : 0.0;
+        DX_INFO("Model '{}', {} streams, {} rounds, encoded storage loads faster below {:.0f} MB/s disk reads, plain storage above",
+                file_name, streams.size(), rounds, break_even_rate);
+        return 0;
+    }
+
+    // Images decoded by stb, DDS files are parsed in place and Radiance images are baked by the ibl stage
+    std::vector<TextureSource> collect_images()
+    {
+        std::vector<TextureSource> sources{};
+        std::error_code error_code{};
+        for (auto it = std::filesystem::recursive_directory_iterator(s_data_dir, error_code);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error_code))
+        {
+            if (error_code)
+            {
+                break;
+            }
+            if (it->is_directory() && it->path() == s_excluded_dir)
+            {
+                it.disable_recursion_pending();
+                continue;
+            }
+            std::string extension = get_lower_extension(it->path());
+            if (it->is_regular_file() && std::find(s_image_extensions.begin(), s_image_extensions.end(), extension) != s_image_extensions.end())
+            {
+                sources.push_back({ it->path().generic_string(), {}, false, 0, TextureUsage::Generic });
+            }
+        }
+        std::sort(sources.begin(), sources.end(), [](const TextureSource& a, const TextureSource& b) { return a.name < b.name; });
+        return sources;
+    }
+
+    // Decoded images are consumed on calling thread through a queue of 8, as TextureManager::create_batch uploads them
+    // Files are read once before timing, so that rounds measure decoding rather than the first read from disk
+    int bench_decode(size_t max_threads, uint32_t rounds)
+    {
+        std::vector<TextureSource> sources = collect_images();
+        if (sources.empty())
+        {
+            DX_ERROR("No image found in {}", s_data_dir.string());
+            return 1;
+        }
+        std::vector<XID> content_keys(sources.size());
+        parallel_for(sources.size(), [&sources, &content_keys](size_t i) { content_keys[i] = source_content_key(sources[i]).first; });
+
+        double single_thread_time = 0.0;
+        for (size_t num_threads = 1; ; num_threads = std::min(num_threads * 2, max_threads))
+        {
+            size_t decoded_bytes = 0, failed_count = 0;
+            auto start_time = std::chrono::steady_clock::now();
+            for (uint32_t round = 0; round < rounds; ++round)
+            {
+                decoded_bytes = 0;
+                failed_count = 0;
+                parallel_pipeline(sources.size(), num_threads, 8,
+                    [&sources, &content_keys](size_t i) { return decode_image(sources[i], content_keys[i], false); },
+                    [&decoded_bytes, &failed_count](DecodedImage&& image)
+                    {
+                        decoded_bytes += static_cast<size_t>(image.width) * image.height * 4;
+                        failed_count += image.pixels ? 0 : 1;
+                    });
+            }
+            double time = milliseconds_since(start_time) / rounds;
+            single_thread_time = num_threads == 1 ? time : single_thread_time;
+            double speedup = time > 0.0 ? single_thread_time / time : 0.0;
+            DX_INFO("{:>2} threads: {} images, {:.1f} MB decoded in {:.1f} ms, {:.2f}x, efficiency {:.0f}%{}", num_threads, sources.size(),
+                    static_cast<double>(decoded_bytes) / (1024.0 * 1024.0), time, speedup, 100.0 * speedup / static_cast<double>(num_threads),
+                    failed_count ? fmt::format(", {} failed", failed_count) : std::string{});
+            if (num_threads >= max_threads)
+            {
+                break;
+            }
+        }
+        return 0;
+    }
+
+    // RGBE texel of linear RGB, exponent shared by the largest channel
+    std::array<uint8_t, 4> to_rgbe(float r, float g, float b)
+    {
+        float max_value = std::max({ r, g, b });
+        if (max_value < 1.0e-32f)
+        {
+            return { 0, 0, 0, 0 };
+        }
+        int32_t exponent = 0;
+        float scale = std::frexp(max_value, &exponent) * 256.0f / max_value;
+        return { static_cast<uint8_t>(r * scale), static_cast<uint8_t>(g * scale), static_cast<uint8_t>(b * scale),
+                 static_cast<uint8_t>(exponent + 128) };
+    }
+
+    // New style RLE Radiance image of a sky, noisy gradient from horizon to zenith, dark ground and a saturated sun,
+    // so that exponents decode mostly as runs and mantissas mostly as literals, as in captured environment maps
+    std::vector<uint8_t> make_radiance_sky(uint32_t width, uint32_t height)
+    {
+        std::string header = fmt::format("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y {} +X {}\n", height, width);
+        std::vector<uint8_t> output(header.begin(), header.end());
+        std::vector<std::array<uint8_t, 4>> scanline(width);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            float elevation = 0.5f - (static_cast<float>(y) + 0.5f) / static_cast<float>(height);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float azimuth = (static_cast<float>(x) + 0.5f) / static_cast<float>(width) - 0.5f;
+                float sun = std::max(0.0f, 1.0f - (azimuth * azimuth + (elevation - 0.2f) * (elevation - 0.2f)) * 4000.0f);
+                // Sensor noise of about 2%, captured skies rarely repeat a mantissa across neighbours
+                uint32_t hash = (x * 0x9E3779B1u) ^ (y * 0x85EBCA77u);
+                hash = (hash ^ (hash >> 15)) * 0x2C1B3C6Du;
+                float noise = 1.0f + 0.02f * (static_cast<float>(hash >> 8) / 16777216.0f - 0.5f);
+                float sky = (elevation > 0.0f ? std::exp2(6.0f * elevation) : 0.05f) * noise;
+                scanline[x] = to_rgbe(0.4f * sky + 16384.0f * sun, 0.6f * sky + 16384.0f * sun, sky + 15000.0f * sun);
+            }
+
+            output.insert(output.end(), { 2, 2, static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width & 0xff) });
+            for (uint32_t component = 0; component < 4; ++component)
+            {
+                for (uint32_t x = 0; x < width; )
+                {
+                    uint32_t run = 1;
+                    while (x + run < width && run < 127 && scanline[x + run][component] == scanline[x][component])
+                    {
+                        run++;
+                    }
+                    if (run >= 3)
+                    {
+                        output.push_back(static_cast<uint8_t>(128 + run));
+                        output.push_back(scanline[x][component]);
+                        x += run;
+                        continue;
+                    }
+                    uint32_t literal = 0;
+                    while (x + literal < width && literal < 128 &&
+                           !(x + literal + 2 < width && scanline[x + literal][component] == scanline[x + literal + 1][component] &&
+                             scanline[x + literal][component] == scanline[x + literal + 2][component]))
+                    {
+                        literal++;
+                    }
+                    literal = std::max(literal, 1u);
+                    output.push_back(static_cast<uint8_t>(literal));
+                    for (uint32_t i = 0; i < literal; ++i)
+                    {
+                        output.push_back(scanline[x + i][component]);
+                    }
+                    x += literal;
+                }
+            }
+        }
+        return output;
+    }
+
+    // Source is read or synthesized before timing, so that rounds measure decoding only
+    int bench_hdr(const std::string& file_name, uint32_t width, uint32_t height, uint32_t rounds)
+    {
+        std::vector<uint8_t> data{};
+        if (file_name.empty())
+        {
+            data = make_radiance_sky(width, height);
+        } else
+        {
+            MappedFile file(file_name);
+            if (!file.is_open() || !is_radiance_image(file.bytes()))
+            {
+                DX_ERROR("Fail to open Radiance image {}", file_name);
+                return 1;
+            }
+            data.assign(file.data(), file.data() + file.size());
+        }
+
+        struct Decoder
+        {
+            std::string_view name;
+            uint32_t texel_byte_width;
+            std::function<bool(uint32_t&, uint32_t&)> decode;
+        };
+        const std::array<Decoder, 3> decoders = { {
+            { "stb RGBA32F", 16, [&data](uint32_t& width, uint32_t& height)
+                {
+                    int32_t x = 0, y = 0, comp = 0;
+                    float* pixels = stbi_loadf_from_memory(data.data(), static_cast<int32_t>(data.size()), &x, &y, &comp, STBI_rgb_alpha);
+                    stbi_image_free(pixels);
+                    width = static_cast<uint32_t>(x);
+                    height = static_cast<uint32_t>(y);
+                    return pixels != nullptr;
+                } },
+            { "RGBA16F", get_texel_byte_width(HdrFormat::RGBA16F), [&data](uint32_t& width, uint32_t& height)
+                {
+                    auto image = decode_hdr_image(data, HdrFormat::RGBA16F);
+                    width = image ? image->width : 0;
+                    height = image ? image->height : 0;
+                    return image.has_value();
+                } },
+            { "RGB9E5", get_texel_byte_width(HdrFormat::RGB9E5), [&data](uint32_t& width, uint32_t& height)
+                {
+                    auto image = decode_hdr_image(data, HdrFormat::RGB9E5);
+                    width = image ? image->width : 0;
+                    height = image ? image->height : 0;
+                    return image.has_value();
+                } }
+        } };
+
+        DX_INFO("Radiance image '{}', {:.1f} MB encoded, {} rounds", file_name.empty() ? "synthesized sky" : file_name,
+                static_cast<double>(data.size()) / (1024.0 * 1024.0), rounds);
+        for (auto&& [name, texel_byte_width, decode] : decoders)
+        {
+            uint32_t image_width = 0, image_height = 0;
+            double min_time = std::numeric_limits<double>::max(), total_time = 0.0;
+            for (uint32_t round = 0; round < rounds; ++round)
+            {
+                auto start_time = std::chrono::steady_clock::now();
+                if (!decode(image_width, image_height))
+                {
+                    DX_ERROR("{} fails to decode", name);
+                    return 1;
+                }
+                double time = milliseconds_since(start_time);
+                min_time = std::min(min_time, time);
+                total_time += time;
+            }
+            double texel_count = static_cast<double>(image_width) * image_height;
+            DX_INFO("{:<12} {} x {}, {:>6.1f} MB image, {:>7.1f} ms mean, {:>7.1f} ms min, {:.1f} Mtexel/s", name, image_width, image_height,
+                    texel_count * texel_byte_width / (1024.0 * 1024.0), total_time / rounds, min_time, texel_count / (min_time * 1.0e3));
+        }
+        return 0;
+    }
+
+    // Evict file from page cache so that next read goes to disk, false if platform has no way to
+    bool drop_page_cache(const std::filesystem::path& file_path)
+    {
+#if defined(_WIN32)
+        (void)file_path;
+        return false;
+#else
+        int file = ::open(file_path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+        // Dirty pages of a file just written are not dropped, write them back first
+        ::fdatasync(file);
+        bool is_dropped = ::posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        ::close(file);
+        return is_dropped;
+#endif
+    }
+
+    // Subresources copied out as CreateTexture2D copies initial data, bytes copied, 0 if malformed
+    size_t copy_subresources(std::span<const uint8_t> bytes, std::vector<uint8_t>& staging)
+    {
+        auto view = parse_dds(bytes);
+        if (!view)
+        {
+            return 0;
+        }
+        size_t copied_bytes = 0;
+        for (auto&& subresource : view->subresources)
+        {
+            if (staging.size() < subresource.bytes.size())
+            {
+                staging.resize(subresource.bytes.size());
+            }
+            std::memcpy(staging.data(), subresource.bytes.data(), subresource.bytes.size());
+            copied_bytes += subresource.bytes.size();
+        }
+        return copied_bytes;
+    }
+
+    size_t load_dds_heap(const std::filesystem::path& file_path, std::vector<uint8_t>& staging)
+    {
+        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return 0;
+        }
+        std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        return file ? copy_subresources(data, staging) : 0;
+    }
+
+    size_t load_dds_mapped(const std::filesystem::path& file_path, std::vector<uint8_t>& staging)
+    {
+        MappedFile file(file_path);
+        return file.is_open() ? copy_subresources(file.bytes(), staging) : 0;
+    }
+
+    // BC7 with full mip chain, block contents do not matter to loading
+    bool write_bc7_texture(const std::filesystem::path& file_path, uint32_t size)
+    {
+        DdsDesc desc{ DXGI_FORMAT_BC7_UNORM, size, size, static_cast<uint32_t>(std::bit_width(size)), 1, false, 0 };
+        size_t byte_width = 0;
+        for (uint32_t mip = 0; mip < desc.mip_count; ++mip)
+        {
+            uint32_t blocks = std::max((std::max(size >> mip, 1u) + 3) / 4, 1u);
+            byte_width += static_cast<size_t>(blocks) * blocks * 16;
+        }
+        desc.pitch_or_linear_size = std::max((size + 3) / 4, 1u) * std::max((size + 3) / 4, 1u) * 16;
+
+        std::vector<uint8_t> data(byte_width);
+        std::mt19937 random(7);
+        std::generate(data.begin(), data.end(), [&random] { return static_cast<uint8_t>(random()); });
+        return write_dds_file(file_path, desc, data);
+    }
+
+    struct DdsLoadTime
+    {
+        double cold_time = 0.0;
+        double warm_time = 0.0;
+        size_t copied_bytes = 0;
+        size_t failed_count = 0;
+    };
+
+    // Cold rounds evict every file before the first loads it, warm rounds load twice and time the second
+    DdsLoadTime time_dds_loads(std::span<const std::filesystem::path> files, uint32_t rounds, bool is_cold,
+                               size_t (*load)(const std::filesystem::path&, std::vector<uint8_t>&))
+    {
+        DdsLoadTime load_time{};
+        std::vector<uint8_t> staging{};
+        for (uint32_t round = 0; round < rounds; ++round)
+        {
+            for (auto&& file_path : files)
+            {
+                if (is_cold)
+                {
+                    drop_page_cache(file_path);
+                    auto start_time = std::chrono::steady_clock::now();
+                    size_t copied_bytes = load(file_path, staging);
+                    load_time.cold_time += milliseconds_since(start_time);
+                    load_time.failed_count += copied_bytes == 0 ? 1 : 0;
+                }
+                load(file_path, staging);
+                auto start_time = std::chrono::steady_clock::now();
+                size_t copied_bytes = load(file_path, staging);
+                load_time.warm_time += milliseconds_since(start_time);
+                load_time.copied_bytes += copied_bytes;
+                load_time.failed_count += copied_bytes == 0 ? 1 : 0;
+            }
+        }
+        load_time.cold_time /= rounds;
+        load_time.warm_time /= rounds;
+        load_time.copied_bytes /= rounds;
+        load_time.failed_count /= rounds;
+        return load_time;
+    }
+
+    int bench_dds(uint32_t size, uint32_t rounds)
+    {
+        std::vector<std::filesystem::path> files{};
+        std::error_code error_code{};
+        for (auto it = std::filesystem::recursive_directory_iterator(s_data_dir, error_code);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error_code))
+        {
+            if (error_code)
+            {
+                break;
+            }
+            if (it->is_directory() && it->path() == s_excluded_dir)
+            {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_regular_file() && get_lower_extension(it->path()) == ".dds")
+            {
+                files.push_back(it->path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        std::vector<std::pair<std::string, std::vector<std::filesystem::path>>> sets{};
+        sets.emplace_back(fmt::format("{} DDS of data", files.size()), files);
+        std::filesystem::path synthesized_path = std::filesystem::temp_directory_path() / "ToyBake_bench.dds";
+        if (size > 0)
+        {
+            if (!write_bc7_texture(synthesized_path, size))
+            {
+                DX_ERROR("Fail to write {}", synthesized_path.string());
+                return 1;
+            }
+            sets.emplace_back(fmt::format("BC7 {0} x {0}", size), std::vector{ synthesized_path });
+        }
+
+        bool is_cold = files.empty() || drop_page_cache(files.front());
+        DX_INFO("{} rounds, cold loads {}", rounds, is_cold ? "after dropping page cache" : "not measured, page cache cannot be dropped");
+        size_t failed_count = 0;
+        for (auto&& [name, set_files] : sets)
+        {
+            auto heap = time_dds_loads(set_files, rounds, is_cold, load_dds_heap);
+            auto mapped = time_dds_loads(set_files, rounds, is_cold, load_dds_mapped);
+            double copied_mb = static_cast<double>(mapped.copied_bytes) / (1024.0 * 1024.0);
+            DX_INFO("{:<16} {:>7.2f} MB, heap read cold {:>7.2f} ms, warm {:>7.2f} ms, {:>6.0f} MB/s, mapped cold {:>7.2f} ms, "
+                    "warm {:>7.2f} ms, {:>6.0f} MB/s", name, copied_mb, heap.cold_time, heap.warm_time,
+                    heap.warm_time > 0.0 ? copied_mb / (heap.warm_time * 1.0e-3) : 0.0, mapped.cold_time, mapped.warm_time,
+                    mapped.warm_time > 0.0 ? copied_mb / (mapped.warm_time * 1.0e-3) : 0.0);
+            failed_count += heap.failed_count + mapped.failed_count;
+        }
+
+        // Parsing alone, over files mapped once
+        std::vector<MappedFile> mapped_files{};
+        for (auto&& file_path : files)
+        {
+            mapped_files.emplace_back(file_path);
+        }
+        constexpr uint32_t parse_rounds = 1000;
+        auto start_time = std::chrono::steady_clock::now();
+        size_t subresource_count = 0;
+        for (uint32_t round = 0; round < parse_rounds; ++round)
+        {
+            for (auto&& file : mapped_files)
+            {
+                auto view = parse_dds(file.bytes());
+                subresource_count += view ? view->subresources.size() : 0;
+            }
+        }
+        double parse_time = milliseconds_since(start_time) / parse_rounds;
+        DX_INFO("parse_dds       {} files, {} subresources in {:.3f} ms, {:.2f} us per file", mapped_files.size(),
+                subresource_count / parse_rounds, parse_time, mapped_files.empty() ? 0.0 : parse_time * 1.0e3 / mapped_files.size());
+
+        std::filesystem::remove(synthesized_path, error_code);
+        if (failed_count > 0)
+        {
+            DX_ERROR("{} loads failed", failed_count);
+        }
+        return failed_count == 0 ? 0 : 1;
+    }
+
+    struct IblHitTime
+    {
+        double hash_time = 0.0;
+        double load_time = 0.0;
+        double project_time = 0.0;
+        double lut_time = 0.0;
+
+        [[nodiscard]] double get_total() const { return hash_time + load_time + project_time + lut_time; }
+    };
+
+    // Hit path of compute_ibl: content key of HDR image, environment cache, SH9 projection of it and BRDF LUT, false if a cache is rejected
+    bool time_ibl_hit(const std::filesystem::path& hdr_path, const std::filesystem::path& environment_path,
+                      const std::filesystem::path& lut_path, IblHitTime& hit_time)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        XID content_key = file_content_to_id(hdr_path.string());
+        hit_time.hash_time += milliseconds_since(start_time);
+
+        start_time = std::chrono::steady_clock::now();
+        auto environment = load_ibl_cache(environment_path);
+        bool is_valid = content_key != 0 && environment &&
+                        environment->matches(DXGI_FORMAT_R16G16B16A16_FLOAT, ibl_environment_size, get_mip_count(ibl_environment_size, ibl_environment_size), 6);
+        hit_time.load_time += milliseconds_since(start_time);
+
+        start_time = std::chrono::steady_clock::now();
+        if (is_valid)
+        {
+            project_irradiance_sh(*environment);
+        }
+        hit_time.project_time += milliseconds_since(start_time);
+
+        start_time = std::chrono::steady_clock::now();
+        auto brdf_lut = load_ibl_cache(lut_path);
+        is_valid = is_valid && brdf_lut && brdf_lut->matches(DXGI_FORMAT_R16G16_FLOAT, ibl_brdf_lut_size, 1, 1);
+        hit_time.lut_time += milliseconds_since(start_time);
+        return is_valid;
+    }
+
+    // Caches are written to a temporary directory, the ones of data directory are left alone
+    // Miss bakes at size since CPU bake of engine size takes minutes, hit loads a cube of engine layout, whose texels do not
+    // change the time of loading or projecting it
+    int bench_ibl(const std::string& file_name, uint32_t size, uint32_t rounds)
+    {
+        std::error_code error_code{};
+        std::filesystem::path temp_dir = std::filesystem::temp_directory_path() / "ToyBake_ibl";
+        std::filesystem::create_directories(temp_dir, error_code);
+        std::filesystem::path hdr_path = file_name.empty() ? temp_dir / "sky.hdr" : std::filesystem::path(file_name);
+        if (file_name.empty())
+        {
+            auto data = make_radiance_sky(2048, 1024);
+            std::ofstream file(hdr_path, std::ios::binary);
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+        std::filesystem::path environment_path = temp_dir / "environment.dds";
+        std::filesystem::path lut_path = temp_dir / "brdf_lut.dds";
+
+        auto start_time = std::chrono::steady_clock::now();
+        XID content_key = file_content_to_id(hdr_path.string());
+        auto image = load_hdr_image(hdr_path, HdrFormat::RGB9E5);
+        if (content_key == 0 || !image)
+        {
+            DX_ERROR("Fail to decode HDR image {}", hdr_path.string());
+            return 1;
+        }
+        double decode_time = milliseconds_since(start_time);
+        start_time = std::chrono::steady_clock::now();
+        IblMaps maps = bake_ibl_maps(*image, size);
+        double bake_time = milliseconds_since(start_time);
+        start_time = std::chrono::steady_clock::now();
+        bool is_saved = save_ibl_cache(temp_dir / "baked.dds", maps.environment);
+        project_irradiance_sh(maps.environment);
+        double save_time = milliseconds_since(start_time);
+        start_time = std::chrono::steady_clock::now();
+        is_saved = is_saved && save_ibl_cache(lut_path, bake_brdf_lut());
+        double lut_time = milliseconds_since(start_time);
+        DX_INFO("Miss, environment {0} x {0}: {1:.1f} ms, decode {2:.1f} ms, bake {3:.1f} ms, save and project {4:.1f} ms, "
+                "BRDF LUT {5:.1f} ms once per cache", size, decode_time + bake_time + save_time, decode_time, bake_time, save_time, lut_time);
+
+        IblTexture environment{ DXGI_FORMAT_R16G16B16A16_FLOAT, ibl_environment_size, ibl_environment_size,
+                                get_mip_count(ibl_environment_size, ibl_environment_size), 6 };
+        if (!is_saved || !save_ibl_cache(environment_path, environment))
+        {
+            DX_ERROR("Fail to write IBL caches to {}", temp_dir.string());
+            return 1;
+        }
+
+        bool is_cold = drop_page_cache(environment_path);
+        for (bool cold : { true, false })
+        {
+            if (cold && !is_cold)
+            {
+                DX_INFO("Hit, cold: not measured, page cache cannot be dropped");
+                continue;
+            }
+            // Warm rounds load once untimed, so that files are in page cache
+            IblHitTime hit_time{}, warm_up_time{};
+            for (uint32_t round = 0; round < rounds; ++round)
+            {
+                bool is_valid = true;
+                if (cold)
+                {
+                    for (auto&& file_path : { hdr_path, environment_path, lut_path })
+                    {
+                        drop_page_cache(file_path);
+                    }
+                } else
+                {
+                    is_valid = time_ibl_hit(hdr_path, environment_path, lut_path, warm_up_time);
+                }
+                if (!is_valid || !time_ibl_hit(hdr_path, environment_path, lut_path, hit_time))
+                {
+                    DX_ERROR("IBL cache rejected");
+                    return 1;
+                }
+            }
+            DX_INFO("Hit, {}, environment {} x {}, {:.1f} MB: {:.1f} ms, content key {:.1f} ms, load {:.1f} ms, SH9 {:.1f} ms, BRDF LUT {:.1f} ms",
+                    cold ? "cold" : "warm", ibl_environment_size, ibl_environment_size,
+                    static_cast<double>(environment.data.size()) / (1024.0 * 1024.0), hit_time.get_total() / rounds,
+                    hit_time.hash_time / rounds, hit_time.load_time / rounds, hit_time.project_time / rounds, hit_time.lut_time / rounds);
+        }
+
+        std::filesystem::remove_all(temp_dir, error_code);
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "bench-ibl")
+    {
+        std::string file_name{};
+        uint32_t size = 128, rounds = 3;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            if (args[i] == "--size" && i + 1 < args.size())
+            {
+                size = std::clamp(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u, ibl_environment_size);
+            } else if (args[i] == "--rounds" && i + 1 < args.size())
+            {
+                rounds = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+            } else if (i == 1 && !args[i].starts_with("--"))
+            {
+                file_name = std::string(args[i]);
+            } else
+            {
+                DX_INFO("Usage: ToyBake bench-ibl [file.hdr] [--size n] [--rounds n]");
+                return 1;
+            }
+        }
+        return bench_ibl(file_name, size, rounds);
+    }
+    if (!args.empty() && args[0] == "bench-dds")
+    {
+        uint32_t size = 0, rounds = 3;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            if (args[i] == "--size" && i + 1 < args.size())
+            {
+                size = std::min(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 16384u);
+            } else if (args[i] == "--rounds" && i + 1 < args.size())
+            {
+                rounds = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+            } else
+            {
+                DX_INFO("Usage: ToyBake bench-dds [--size n] [--rounds n]");
+                return 1;
+            }
+        }
+        return bench_dds(size, rounds);
+    }
+    if (!args.empty() && args[0] == "bench-hdr")
+    {
+        std::string file_name{};
+        uint32_t width = 8192, height = 4096, rounds = 3;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            if (args[i] == "--size" && i + 2 < args.size())
+            {
+                width = std::clamp(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 8u, 32767u);
+                height = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+            } else if (args[i] == "--rounds" && i + 1 < args.size())
+            {
+                rounds = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+            } else if (i == 1 && !args[i].starts_with("--"))
+            {
+                file_name = std::string(args[i]);
+            } else
+            {
+                DX_INFO("Usage: ToyBake bench-hdr [file.hdr] [--size width height] [--rounds n]");
+                return 1;
+            }
+        }
+        return bench_hdr(file_name, width, height, rounds);
+    }
+    if (!args.empty() && args[0] == "bench-decode")
+    {
+        size_t max_threads = get_worker_count();
+        uint32_t rounds = 3;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            if (args[i] == "--threads" && i + 1 < args.size())
+            {
+                max_threads = std::max(static_cast<size_t>(std::stoul(std::string(args[++i]))), size_t{ 1 });
+            } else if (args[i] == "--rounds" && i + 1 < args.size())
+            {
+                rounds = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+            } else
+            {
+                DX_INFO("Usage: ToyBake bench-decode [--threads n] [--rounds n]");
+                return 1;
+            }
+        }
+        return bench_decode(max_threads, rounds);
+    }
+    if (args.size() >= 2 && (args[0] == "bench" || args[0] == "bench-codec"))
+    {
+        bool is_codec = args[0] == "bench-codec";
+        VertexEncoding vertex_encoding = VertexEncoding::Full;
+        MeshStreamStorage stream_storage = MeshStreamStorage::Plain;
+        uint32_t rounds = 5;
+        for (size_t i = 2; i < args.size(); ++i)
+        {
+            if (args[i] == "--quantized")
+            {
+                vertex_encoding = VertexEncoding::Quantized;
+            } else if (args[i] == "--encoded" && !is_codec)
+            {
+                stream_storage = MeshStreamStorage::Encoded;
+            } else if (args[i] == "--rounds" && i + 1 < args.size())
+            {
+                rounds = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+            } else
+            {
+                DX_INFO("Usage: ToyBake bench <model> [--quantized] [--encoded] [--rounds n] | bench-codec <model> [--quantized] [--rounds n]");
+                return 1;
+            }
+        }
+        return is_codec ? bench_codec(std::string(args[1]), vertex_encoding, rounds) :
+                          bench(std::string(args[1]), vertex_encoding, stream_storage, rounds);
+    }
+
+    bool force = false;
+    VertexEncoding vertex_encoding = VertexEncoding::Full;
+    MeshStreamStorage stream_storage = MeshStreamStorage::Plain;
+    size_t num_threads = 0;
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        if (args[i] == "--force")
+        {
+            force = true;
+        } else if (args[i] == "--quantized")
+        {
+            vertex_encoding = VertexEncoding::Quantized;
+        } else if (args[i] == "--encoded")
+        {
+            stream_storage = MeshStreamStorage::Encoded;
+        } else if (args[i] == "--jobs" && i + 1 < args.size())
+        {
+            num_threads = static_cast<size_t>(std::stoul(std::string(args[++i])));
+        } else
+        {
+            DX_INFO("Usage: ToyBake [--force] [--quantized] [--encoded] [--jobs n] | bench <model> [--quantized] [--encoded] [--rounds n] | "
+                    "bench-codec <model> [--quantized] [--rounds n] | bench-decode [--threads n] [--rounds n] | "
+                    "bench-hdr [file.hdr] [--size width height] [--rounds n] | bench-dds [--size n] [--rounds n] | "
+                    "bench-ibl [file.hdr] [--size n] [--rounds n]");
+            return 1;
+        }
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::string> model_files{}, hdr_files{}, shader_files{};
+    collect_sources(model_files, hdr_files, shader_files);
+    BakeGraph previous_graph = force ? BakeGraph{} : load_graph(s_graph_path);
+    DX_INFO("Found {} models, {} Radiance images and {} shaders, bake graph has {} nodes, {:.1f} ms", model_files.size(), hdr_files.size(),
+            shader_files.size(), previous_graph.size(), milliseconds_since(start_time));
+
+    Baker baker(std::move(previous_graph), num_threads, vertex_encoding, stream_storage);
+    auto bake_start_time = std::chrono::steady_clock::now();
+    baker.bake(model_files, hdr_files, shader_files);
+    double bake_time = milliseconds_since(bake_start_time);
+
+    // Hit rate counts nodes not baked, either through bake graph or through a cache entry of the same content
+    size_t failed_count = 0;
+    for (size_t i = 0; i < s_stage_names.size(); ++i)
+    {
+        auto&& statistics = baker.get_statistics(static_cast<Stage>(i));
+        size_t hit_count = statistics.up_to_date + statistics.cached;
+        size_t bakeable_count = hit_count + statistics.baked + statistics.failed;
+        DX_INFO("{:<8} {:>5} up to date, {:>5} cached, {:>5} baked, {:>5} skipped, {:>5} failed, hit rate {:5.1f}%, {:>9.1f} ms", s_stage_names[i],
+                statistics.up_to_date.load(), statistics.cached.load(), statistics.baked.load(), statistics.skipped.load(), statistics.failed.load(),
+                bakeable_count > 0 ? 100.0 * static_cast<double>(hit_count) / static_cast<double>(bakeable_count) : 100.0,
+                static_cast<double>(statistics.time_us.load()) / 1000.0);
+        failed_count += statistics.failed;
+    }
+
+    if (!save_graph(s_graph_path, baker.get_graph()))
+    {
+        DX_ERROR("Fail to write bake graph {}", s_graph_path.string());
+    }
+    if (!save_shader_manifest(s_shader_manifest_path, baker.get_shaders()))
+    {
+        DX_ERROR("Fail to write shader manifest {}", s_shader_manifest_path.string());
+        ++failed_count;
+    }
+    DX_INFO("Baked on {} threads in {:.1f} ms, {} tasks stolen, {:.1f} ms in total", baker.get_thread_count(), bake_time,
+            baker.get_steal_count(), milliseconds_since(start_time));
+    return failed_count == 0 ? 0 : 1;
+}
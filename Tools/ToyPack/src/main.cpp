@@ -0,0 +1,173 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Core/virtual_file_system.h>
+
+// Asset pack tool
+//   ToyPack pack [--store] [root]      pack data directory of root into root/data.pak, runtime caches are left out
+//   ToyPack list <pack>                list entries with stored and original size
+//   ToyPack verify <pack>              check every entry against its checksum
+//   ToyPack bench <pack> [root] [n]    read every packed file n times from loose files and from pack
+// Root defaults to project root, where the engine mounts data.pak at startup
+
+namespace
+{
+    using namespace toy;
+
+    const std::array<std::string, 1> s_packed_directories = { "data" };
+    const std::array<std::string, 1> s_excluded_directories = { "data/cache" };
+
+    double milliseconds_since(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    int pack(const std::filesystem::path& root_dir, bool compress)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        auto sources = collect_asset_pack_sources(root_dir, s_packed_directories, s_excluded_directories);
+        std::filesystem::path pack_path = root_dir / default_asset_pack_name;
+        AssetPackOptions options{};
+        options.compress = compress;
+        if (!write_asset_pack(pack_path, sources, options))
+        {
+            return 1;
+        }
+
+        AssetPack asset_pack(pack_path);
+        uint64_t original_size = 0, stored_size = 0;
+        size_t compressed_count = 0;
+        for (auto&& entry : asset_pack.get_entries())
+        {
+            original_size += entry.size;
+            stored_size += entry.stored_size;
+            compressed_count += entry.compression != AssetCompression::None ? 1 : 0;
+        }
+        DX_INFO("Packed {} files ({} compressed) of {:.1f} MB into {} of {:.1f} MB in {:.0f} ms", sources.size(), compressed_count,
+                original_size / 1048576.0, pack_path.string(), stored_size / 1048576.0, milliseconds_since(start_time));
+        return 0;
+    }
+
+    int list(const std::filesystem::path& pack_path)
+    {
+        AssetPack asset_pack(pack_path);
+        if (!asset_pack.is_open())
+        {
+            DX_ERROR("Fail to open asset pack {}", pack_path.string());
+            return 1;
+        }
+        for (auto&& entry : asset_pack.get_entries())
+        {
+            DX_INFO("{:>12} {:>12} {} {}", entry.stored_size, entry.size, entry.compression == AssetCompression::LZ ? "lz" : "  ",
+                    asset_pack.get_name(entry));
+        }
+        return 0;
+    }
+
+    int verify(const std::filesystem::path& pack_path)
+    {
+        AssetPack asset_pack(pack_path);
+        if (!asset_pack.is_open())
+        {
+            DX_ERROR("Fail to open asset pack {}", pack_path.string());
+            return 1;
+        }
+        size_t corrupt_count = 0;
+        for (auto&& entry : asset_pack.get_entries())
+        {
+            if (!asset_pack.verify(entry))
+            {
+                DX_ERROR("Entry '{}' is corrupt", asset_pack.get_name(entry));
+                ++corrupt_count;
+            }
+        }
+        DX_INFO("{} of {} entries are intact", asset_pack.get_entries().size() - corrupt_count, asset_pack.get_entries().size());
+        return corrupt_count == 0 ? 0 : 1;
+    }
+
+    // Every packed file is opened and hashed, so that each of its pages is touched once
+    // Note: first round is only cold when file cache is, e.g. after reboot or clearing standby list
+    int bench(const std::filesystem::path& pack_path, const std::filesystem::path& root_dir, uint32_t rounds)
+    {
+        std::vector<std::filesystem::path> file_paths{};
+        {
+            AssetPack asset_pack(pack_path);
+            if (!asset_pack.is_open())
+            {
+                DX_ERROR("Fail to open asset pack {}", pack_path.string());
+                return 1;
+            }
+            for (auto&& entry : asset_pack.get_entries())
+            {
+                file_paths.push_back(root_dir / asset_pack.get_name(entry));
+            }
+        }
+
+        auto&& file_system = VirtualFileSystem::get();
+        auto read_all = [&file_system, &file_paths]()
+        {
+            uint64_t byte_width = 0;
+            XID checksum = 0;
+            for (auto&& file_path : file_paths)
+            {
+                auto file = file_system.open(file_path);
+                byte_width += file.size();
+                checksum ^= content_to_id(file.data(), file.size());
+            }
+            return std::make_pair(byte_width, checksum);
+        };
+
+        for (uint32_t round = 0; round < rounds; ++round)
+        {
+            file_system.unmount_all();
+            auto start_time = std::chrono::steady_clock::now();
+            auto [loose_bytes, loose_checksum] = read_all();
+            double loose_time = milliseconds_since(start_time);
+
+            start_time = std::chrono::steady_clock::now();
+            file_system.mount(pack_path, root_dir);
+            auto [packed_bytes, packed_checksum] = read_all();
+            double packed_time = milliseconds_since(start_time);
+            file_system.unmount_all();
+
+            DX_INFO("Round {}: {} files, {:.1f} MB, loose {:.1f} ms, pack {:.1f} ms{}", round, file_paths.size(), loose_bytes / 1048576.0,
+                    loose_time, packed_time, loose_checksum == packed_checksum && loose_bytes == packed_bytes ? "" : ", content differs");
+        }
+        auto statistics = file_system.get_statistics();
+        DX_INFO("Opened {} loose and {} packed files, {:.1f} MB decompressed", statistics.loose_opens, statistics.packed_opens,
+                statistics.decompressed_bytes / 1048576.0);
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+    std::string_view command = args.empty() ? std::string_view{} : args[0];
+    std::filesystem::path default_root(DXTOY_HOME);
+
+    if (command == "pack")
+    {
+        bool compress = std::find(args.begin(), args.end(), "--store") == args.end();
+        auto root = std::find_if(args.begin() + 1, args.end(), [](std::string_view arg) { return !arg.starts_with("--"); });
+        return pack(root != args.end() ? std::filesystem::path(*root) : default_root, compress);
+    }
+    if (command == "list" && args.size() >= 2)
+    {
+        return list(args[1]);
+    }
+    if (command == "verify" && args.size() >= 2)
+    {
+        return verify(args[1]);
+    }
+    if (command == "bench" && args.size() >= 2)
+    {
+        std::filesystem::path root_dir = args.size() >= 3 ? std::filesystem::path(args[2]) : default_root;
+        uint32_t rounds = args.size() >= 4 ? static_cast<uint32_t>(std::stoul(std::string(args[3]))) : 3;
+        return bench(args[1], root_dir, rounds);
+    }
+
+    DX_INFO("Usage: ToyPack pack [--store] [root] | list <pack> | verify <pack> | bench <pack> [root] [rounds]");
+    return command.empty() ? 0 : 1;
+}
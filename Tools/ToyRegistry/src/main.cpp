@@ -0,0 +1,385 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Core/concurrent_registry.h>
+#include <Toy/Core/hash.h>
+
+// Concurrent asset registry checks, CPU only, no device is created, stress runs as a test of the build
+//   ToyRegistry bench [--threads n] [--ids n] [--ops n] [--write-permille n]
+// Throughput of lookups mixed with a few replacements, as render and loading threads would use asset managers,
+// for the sharded registry against one map behind a mutex or a reader-writer lock, on 1 thread up to n threads
+//   ToyRegistry stress [--threads n] [--rounds n]
+// Threads request the same assets at once and check that each is created once and shared, that a failed creation
+// reaches every caller waiting for it and is retried by the next one, then churn every operation on a few IDs
+
+namespace
+{
+    using namespace toy;
+
+    struct Asset
+    {
+        XID id = 0;
+        uint32_t revision = 0;
+    };
+
+    using AssetRef = std::shared_ptr<const Asset>;
+
+    // One map for every ID, as the asset managers were before sharding
+    template <typename Mutex>
+    class SingleLockRegistry
+    {
+    public:
+        std::optional<AssetRef> find(XID id) const
+        {
+            if constexpr (std::is_same_v<Mutex, std::shared_mutex>)
+            {
+                std::shared_lock<Mutex> lock(m_mutex);
+                return find_unlocked(id);
+            } else
+            {
+                std::lock_guard<Mutex> lock(m_mutex);
+                return find_unlocked(id);
+            }
+        }
+
+        void insert_or_assign(XID id, AssetRef value)
+        {
+            std::lock_guard<Mutex> lock(m_mutex);
+            m_values.insert_or_assign(id, std::move(value));
+        }
+
+    private:
+        std::optional<AssetRef> find_unlocked(XID id) const
+        {
+            auto it = m_values.find(id);
+            return it != m_values.end() ? std::optional<AssetRef>(it->second) : std::nullopt;
+        }
+
+        mutable Mutex m_mutex;
+        std::unordered_map<XID, AssetRef> m_values;
+    };
+
+    // IDs of asset names, as managers key them
+    std::vector<XID> make_ids(size_t count)
+    {
+        std::vector<XID> ids(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ids[i] = string_to_id("data/models/asset_" + std::to_string(i) + ".gltf");
+        }
+        return ids;
+    }
+
+    uint64_t next_random(uint64_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // Million operations per second over every thread
+    template <typename Registry>
+    double measure(Registry& registry, const std::vector<XID>& ids, size_t thread_count, size_t op_count, uint32_t write_permille)
+    {
+        for (auto id : ids)
+        {
+            registry.insert_or_assign(id, std::make_shared<const Asset>(Asset{ id, 0 }));
+        }
+
+        std::atomic<size_t> ready_count = 0;
+        std::atomic<bool> is_started = false;
+        std::atomic<size_t> miss_count = 0;
+        std::vector<std::thread> threads{};
+        for (size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+                size_t misses = 0;
+                ready_count++;
+                while (!is_started.load())
+                {
+                    std::this_thread::yield();
+                }
+                for (size_t i = 0; i < op_count; ++i)
+                {
+                    uint64_t random = next_random(state);
+                    XID id = ids[random % ids.size()];
+                    if ((random >> 32) % 1000 < write_permille)
+                    {
+                        registry.insert_or_assign(id, std::make_shared<const Asset>(Asset{ id, static_cast<uint32_t>(i) }));
+                    } else if (auto asset = registry.find(id); !asset || (*asset)->id != id)
+                    {
+                        misses++;
+                    }
+                }
+                miss_count += misses;
+            });
+        }
+        while (ready_count.load() < thread_count)
+        {
+            std::this_thread::yield();
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        is_started = true;
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        if (miss_count.load() != 0)
+        {
+            DX_ERROR("{} lookups found no asset or a wrong one", miss_count.load());
+        }
+        return static_cast<double>(thread_count * op_count) / seconds / 1.0e6;
+    }
+
+    int bench(size_t max_thread_count, size_t id_count, size_t op_count, uint32_t write_permille)
+    {
+        auto ids = make_ids(id_count);
+        DX_INFO("{} IDs, {} operations per thread, {:.1f}% replacements, {} hardware threads", id_count, op_count,
+                write_permille / 10.0, std::thread::hardware_concurrency());
+        DX_INFO("{:>8} {:>14} {:>14} {:>14} {:>9}", "threads", "mutex Mops/s", "rwlock Mops/s", "sharded Mops/s", "speedup");
+        for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+        {
+            SingleLockRegistry<std::mutex> mutex_registry{};
+            SingleLockRegistry<std::shared_mutex> rwlock_registry{};
+            ConcurrentRegistry<AssetRef> sharded_registry{};
+            double mutex_mops = measure(mutex_registry, ids, thread_count, op_count, write_permille);
+            double rwlock_mops = measure(rwlock_registry, ids, thread_count, op_count, write_permille);
+            double sharded_mops = measure(sharded_registry, ids, thread_count, op_count, write_permille);
+            DX_INFO("{:>8} {:>14.2f} {:>14.2f} {:>14.2f} {:>8.2f}x", thread_count, mutex_mops, rwlock_mops, sharded_mops,
+                    sharded_mops / std::max(mutex_mops, rwlock_mops));
+        }
+        return 0;
+    }
+
+    // Every thread requests every ID in its own order, creation is slow enough for requests to overlap
+    bool stress_load_once(size_t thread_count, const std::vector<XID>& ids)
+    {
+        ConcurrentRegistry<AssetRef> registry{};
+        std::vector<std::atomic<uint32_t>> create_counts(ids.size());
+        std::vector<std::vector<AssetRef>> results(thread_count, std::vector<AssetRef>(ids.size()));
+
+        std::vector<std::thread> threads{};
+        for (size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                // Half of threads walk the same order, so that they collide on every ID
+                std::vector<size_t> order(ids.size());
+                std::iota(order.begin(), order.end(), 0);
+                if (t % 2 == 1)
+                {
+                    std::shuffle(order.begin(), order.end(), std::mt19937(static_cast<uint32_t>(t)));
+                }
+                for (size_t i : order)
+                {
+                    results[t][i] = registry.get_or_create(ids[i], [&create_counts, &ids, i]()
+                    {
+                        create_counts[i]++;
+                        std::this_thread::sleep_for(std::chrono::microseconds(50));
+                        return std::make_shared<const Asset>(Asset{ ids[i], 0 });
+                    });
+                }
+            });
+        }
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+
+        bool is_passed = registry.size() == ids.size();
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            is_passed &= create_counts[i].load() == 1;
+            for (size_t t = 0; t < thread_count; ++t)
+            {
+                is_passed &= results[t][i] && results[t][i] == results[0][i] && results[t][i]->id == ids[i];
+            }
+        }
+        return is_passed;
+    }
+
+    // First creation of each ID fails, its waiters see the failure and the next request creates it
+    bool stress_failure(size_t thread_count, const std::vector<XID>& ids)
+    {
+        ConcurrentRegistry<AssetRef> registry{};
+        std::vector<std::atomic<uint32_t>> create_counts(ids.size());
+        std::atomic<size_t> failure_count = 0;
+
+        std::vector<std::thread> threads{};
+        for (size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&]()
+            {
+                for (size_t i = 0; i < ids.size(); ++i)
+                {
+                    auto create = [&create_counts, &ids, i]()
+                    {
+                        uint32_t attempt = create_counts[i]++;
+                        std::this_thread::sleep_for(std::chrono::microseconds(50));
+                        if (attempt == 0)
+                        {
+                            throw std::runtime_error("first creation fails");
+                        }
+                        return std::make_shared<const Asset>(Asset{ ids[i], attempt });
+                    };
+                    try
+                    {
+                        registry.get_or_create(ids[i], create);
+                    } catch (const std::runtime_error&)
+                    {
+                        failure_count++;
+                        registry.get_or_create(ids[i], create);
+                    }
+                }
+            });
+        }
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+
+        bool is_passed = failure_count.load() >= ids.size() && failure_count.load() <= ids.size() * thread_count;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            auto asset = registry.find(ids[i]);
+            is_passed &= create_counts[i].load() == 2 && asset && (*asset)->id == ids[i] && (*asset)->revision == 1;
+        }
+        return is_passed;
+    }
+
+    // Every operation at once on a few IDs, values found must always belong to their ID
+    bool stress_churn(size_t thread_count, const std::vector<XID>& ids)
+    {
+        constexpr size_t op_count = 20000;
+        ConcurrentRegistry<AssetRef> registry{};
+        std::atomic<size_t> error_count = 0;
+
+        std::vector<std::thread> threads{};
+        for (size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                uint64_t state = 0xD1B54A32D192ED03ull * (t + 1);
+                for (size_t i = 0; i < op_count; ++i)
+                {
+                    uint64_t random = next_random(state);
+                    XID id = ids[random % ids.size()];
+                    auto make_asset = [id, i]() { return std::make_shared<const Asset>(Asset{ id, static_cast<uint32_t>(i) }); };
+                    switch ((random >> 32) % 8)
+                    {
+                        case 0:
+                            registry.erase(id);
+                            break;
+                        case 1:
+                            registry.insert_or_assign(id, make_asset());
+                            break;
+                        case 2:
+                            registry.insert(id, make_asset());
+                            break;
+                        case 3:
+                            registry.for_each([&error_count](XID key, const AssetRef& asset) { error_count += asset->id != key ? 1 : 0; });
+                            break;
+                        case 4:
+                            registry.erase_if([](XID, const AssetRef& asset) { return asset->revision % 2 == 1; });
+                            break;
+                        case 5:
+                            error_count += registry.get_or_create(id, make_asset)->id != id ? 1 : 0;
+                            break;
+                        default:
+                            if (auto asset = registry.find(id))
+                            {
+                                error_count += (*asset)->id != id ? 1 : 0;
+                            }
+                            break;
+                    }
+                }
+            });
+        }
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+        return error_count.load() == 0 && registry.size() <= ids.size();
+    }
+
+    int stress(size_t thread_count, uint32_t round_count)
+    {
+        auto ids = make_ids(256);
+        std::vector<XID> few_ids(ids.begin(), ids.begin() + 8);
+        DX_INFO("{} threads, {} rounds", thread_count, round_count);
+
+        uint32_t failed_count = 0;
+        for (uint32_t round = 0; round < round_count; ++round)
+        {
+            bool is_load_once = stress_load_once(thread_count, ids);
+            bool is_failure_shared = stress_failure(thread_count, few_ids);
+            bool is_churn_consistent = stress_churn(thread_count, few_ids);
+            if (!is_load_once || !is_failure_shared || !is_churn_consistent)
+            {
+                DX_ERROR("Round {}: load once {}, failure {}, churn {}", round, is_load_once ? "passed" : "FAILED",
+                         is_failure_shared ? "passed" : "FAILED", is_churn_consistent ? "passed" : "FAILED");
+                failed_count++;
+            }
+        }
+
+        if (failed_count != 0)
+        {
+            DX_ERROR("{} of {} rounds failed", failed_count, round_count);
+            return 1;
+        }
+        DX_INFO("All {} rounds passed", round_count);
+        return 0;
+    }
+
+    void print_usage()
+    {
+        DX_INFO("Usage: ToyRegistry bench [--threads n] [--ids n] [--ops n] [--write-permille n]");
+        DX_INFO("       ToyRegistry stress [--threads n] [--rounds n]");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+    if (args.empty() || (args[0] != "bench" && args[0] != "stress"))
+    {
+        print_usage();
+        return args.empty() ? 0 : 1;
+    }
+
+    size_t thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    size_t id_count = 4096;
+    size_t op_count = 1000000;
+    uint32_t write_permille = 10;
+    uint32_t round_count = 20;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "--threads" && i + 1 < args.size())
+        {
+            thread_count = std::max<size_t>(std::stoul(std::string(args[++i])), 1);
+        } else if (args[i] == "--ids" && i + 1 < args.size())
+        {
+            id_count = std::max<size_t>(std::stoul(std::string(args[++i])), 1);
+        } else if (args[i] == "--ops" && i + 1 < args.size())
+        {
+            op_count = std::max<size_t>(std::stoul(std::string(args[++i])), 1);
+        } else if (args[i] == "--write-permille" && i + 1 < args.size())
+        {
+            write_permille = std::min(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1000u);
+        } else if (args[i] == "--rounds" && i + 1 < args.size())
+        {
+            round_count = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+        } else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+    return args[0] == "bench" ? bench(thread_count, id_count, op_count, write_permille) : stress(thread_count, round_count);
+}
@@ -0,0 +1,248 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Runtime/world_partition.h>
+
+// World streaming benchmark
+//   ToyStream bench [--frames n] [--speed m/s] [--io-mbps x] [--sync]
+// Fly a camera over a synthetic world at a fixed 60 Hz and stream its cells by world partition, no device is created
+// Cells hold a ground tile, houses and trees sized like the models of data directory, loads sleep as long as a disk of
+// given bandwidth would take and activations spin as long as creating their entities would, so that frame cost is
+// measured the same way on every machine
+// --sync loads cells on the updating thread, the baseline streaming is compared against
+
+namespace
+{
+    using namespace toy;
+    using namespace toy::runtime;
+
+    constexpr int32_t s_world_cells = 64;                   // World is s_world_cells x s_world_cells cells
+    constexpr float s_frame_ms = 1000.0f / 60.0f;
+    constexpr float s_hitch_ms = 4.0f;                      // Share of a frame streaming may take
+    constexpr float s_seek_ms = 0.5f;                       // Cost of opening a file, on top of bandwidth
+    constexpr float s_activate_us_per_item = 40.0f;         // Entity creation and buffer upload of an item
+    constexpr size_t s_item_bytes = 256;                    // Entity and transform of an item
+
+    struct Asset
+    {
+        std::string_view file_name;
+        size_t byte_width;
+    };
+
+    // Sizes of files missing from data directory are those at the time of writing
+    std::vector<Asset> load_assets()
+    {
+        std::vector<Asset> assets = { { "ground_19.obj", 228 }, { "grass.dds", 349680 }, { "house.obj", 239134 },
+                                      { "house.png", 1873945 }, { "tree.obj", 622506 }, { "tree_00.dds", 65664 } };
+        for (auto&& asset : assets)
+        {
+            std::error_code error_code;
+            auto byte_width = std::filesystem::file_size(std::filesystem::path(DXTOY_HOME "data/models") / asset.file_name, error_code);
+            asset.byte_width = error_code ? asset.byte_width : static_cast<size_t>(byte_width);
+        }
+        return assets;
+    }
+
+    enum class ItemKind : uint32_t
+    {
+        Ground,
+        House,
+        Tree,
+    };
+
+    // Assets of an item kind, as indices into load_assets
+    const std::array<std::vector<uint32_t>, 3> s_item_assets = { std::vector<uint32_t>{ 0, 1 }, { 2, 3 }, { 4, 5 } };
+
+    void spin_for(float microseconds)
+    {
+        auto end_time = std::chrono::steady_clock::now() + std::chrono::duration<float, std::micro>(microseconds);
+        while (std::chrono::steady_clock::now() < end_time)
+        {
+        }
+    }
+
+    class SimulatedLoader : public IWorldCellLoader
+    {
+    public:
+        SimulatedLoader(std::vector<Asset> assets, float io_bytes_per_ms)
+            : m_assets(std::move(assets)), m_io_bytes_per_ms(io_bytes_per_ms)
+        {
+
+        }
+
+        // Item kinds are set before the first update
+        std::vector<ItemKind> items;
+
+        size_t load_cell(const WorldCell& cell) override
+        {
+            std::unordered_set<uint32_t> assets{};
+            for (uint32_t item : cell.items)
+            {
+                auto&& item_assets = s_item_assets[static_cast<size_t>(items[item])];
+                assets.insert(item_assets.begin(), item_assets.end());
+            }
+
+            size_t byte_width = cell.items.size() * s_item_bytes;
+            for (uint32_t asset : assets)
+            {
+                byte_width += m_assets[asset].byte_width;
+            }
+            auto io_ms = static_cast<float>(assets.size()) * s_seek_ms + static_cast<float>(byte_width) / m_io_bytes_per_ms;
+            std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(io_ms));
+            return byte_width;
+        }
+
+        void activate_cell(const WorldCell& cell) override
+        {
+            spin_for(s_activate_us_per_item * static_cast<float>(cell.items.size()));
+        }
+
+        void unload_cell(const WorldCell&) override
+        {
+        }
+
+    private:
+        std::vector<Asset> m_assets;
+        float m_io_bytes_per_ms;
+    };
+
+    // Ground tile per cell, houses and trees scattered with a fixed seed
+    void build_world(WorldPartition& partition, SimulatedLoader& loader)
+    {
+        std::mt19937 generator(0x746f79);
+        std::uniform_real_distribution<float> offset(0.0f, default_world_cell_size);
+        std::uniform_int_distribution<uint32_t> house_count(0, 3);
+        std::uniform_int_distribution<uint32_t> tree_count(4, 24);
+
+        auto add_item = [&partition, &loader](ItemKind kind, float x, float z)
+        {
+            partition.add_item({ x, 0.0f, z }, static_cast<uint32_t>(loader.items.size()));
+            loader.items.push_back(kind);
+        };
+        for (int32_t cell_z = 0; cell_z < s_world_cells; ++cell_z)
+        {
+            for (int32_t cell_x = 0; cell_x < s_world_cells; ++cell_x)
+            {
+                float min_x = static_cast<float>(cell_x) * default_world_cell_size;
+                float min_z = static_cast<float>(cell_z) * default_world_cell_size;
+                add_item(ItemKind::Ground, min_x + 0.5f * default_world_cell_size, min_z + 0.5f * default_world_cell_size);
+                for (uint32_t i = house_count(generator); i > 0; --i)
+                {
+                    add_item(ItemKind::House, min_x + offset(generator), min_z + offset(generator));
+                }
+                for (uint32_t i = tree_count(generator); i > 0; --i)
+                {
+                    add_item(ItemKind::Tree, min_x + offset(generator), min_z + offset(generator));
+                }
+            }
+        }
+    }
+
+    // Circle around world center, with a slow wobble of radius, so that the camera crosses cells diagonally as well
+    void get_camera_path(float distance, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& direction)
+    {
+        constexpr float world_extent = s_world_cells * default_world_cell_size;
+        constexpr float radius = 0.35f * world_extent;
+        float angle = distance / radius;
+        float wobble = 1.0f + 0.25f * std::sin(3.0f * angle);
+        position = { 0.5f * world_extent + radius * wobble * std::cos(angle), 2.0f, 0.5f * world_extent + radius * wobble * std::sin(angle) };
+        direction = { -std::sin(angle), 0.0f, std::cos(angle) };
+    }
+
+    int bench(uint32_t frame_count, float speed, float io_mbps, bool is_sync)
+    {
+        WorldStreamingSettings settings{};
+        settings.io_thread_count = is_sync ? 0 : settings.io_thread_count;
+
+        SimulatedLoader loader(load_assets(), io_mbps * 1024.0f * 1024.0f / 1000.0f);
+        WorldPartition partition(loader, settings);
+        build_world(partition, loader);
+        DX_INFO("{} cells, {} items, {} I/O threads, {:.0f} MB/s, {:.0f} m/s", partition.get_cell_count(), loader.items.size(),
+                settings.io_thread_count, io_mbps, speed);
+
+        // Pop-in is a frame where a cell within one cell of camera is not active
+        std::vector<float> update_times{};
+        update_times.reserve(frame_count);
+        uint32_t hitch_count = 0, pop_in_frames = 0;
+        double resident_bytes_sum = 0.0;
+        auto next_frame_time = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            DirectX::XMFLOAT3 position{}, direction{};
+            get_camera_path(speed * static_cast<float>(frame) * s_frame_ms / 1000.0f, position, direction);
+
+            auto start_time = std::chrono::steady_clock::now();
+            partition.update(position, direction);
+            float update_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+            update_times.push_back(update_ms);
+            hitch_count += update_ms > s_hitch_ms ? 1 : 0;
+
+            // First frames load the start area, that is a loading screen rather than pop-in
+            WorldCellCoord center = partition.get_cell_coord(position);
+            bool is_pop_in = false;
+            for (uint32_t cell_index = 0; cell_index < partition.get_cell_count() && frame >= 60; ++cell_index)
+            {
+                auto&& cell = partition.get_cell(cell_index);
+                is_pop_in |= std::abs(cell.coord.x - center.x) <= 1 && std::abs(cell.coord.z - center.z) <= 1 &&
+                             cell.state != WorldCellState::Active;
+            }
+            pop_in_frames += is_pop_in ? 1 : 0;
+            resident_bytes_sum += static_cast<double>(partition.get_statistics().resident_bytes);
+
+            next_frame_time += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(s_frame_ms));
+            std::this_thread::sleep_until(next_frame_time);
+        }
+
+        auto&& statistics = partition.get_statistics();
+        std::vector<float> sorted_times = update_times;
+        std::sort(sorted_times.begin(), sorted_times.end());
+        float average_ms = std::accumulate(sorted_times.begin(), sorted_times.end(), 0.0f) / static_cast<float>(sorted_times.size());
+        DX_INFO("update {:.3f} ms average, {:.3f} ms p99, {:.3f} ms max, {} hitches over {:.0f} ms", average_ms,
+                sorted_times[sorted_times.size() * 99 / 100], sorted_times.back(), hitch_count, s_hitch_ms);
+        DX_INFO("{} pop-in frames of {}, resident {:.1f} MB average, {:.1f} MB peak", pop_in_frames, frame_count,
+                resident_bytes_sum / static_cast<double>(frame_count) / (1024.0 * 1024.0),
+                static_cast<double>(statistics.peak_resident_bytes) / (1024.0 * 1024.0));
+        DX_INFO("{} loads, {} unloads, {} cancels, {} cells active", statistics.load_count, statistics.unload_count,
+                statistics.cancel_count, statistics.active_cell_count);
+
+        partition.unload_all();
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+    if (args.empty() || args[0] != "bench")
+    {
+        DX_INFO("Usage: ToyStream bench [--frames n] [--speed m/s] [--io-mbps x] [--sync]");
+        return args.empty() ? 0 : 1;
+    }
+
+    uint32_t frame_count = 1200;
+    float speed = 40.0f;
+    float io_mbps = 100.0f;
+    bool is_sync = false;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "--sync")
+        {
+            is_sync = true;
+        } else if (args[i] == "--frames" && i + 1 < args.size())
+        {
+            frame_count = std::max(static_cast<uint32_t>(std::stoul(std::string(args[++i]))), 1u);
+        } else if (args[i] == "--speed" && i + 1 < args.size())
+        {
+            speed = std::stof(std::string(args[++i]));
+        } else if (args[i] == "--io-mbps" && i + 1 < args.size())
+        {
+            io_mbps = std::max(std::stof(std::string(args[++i])), 1.0f);
+        } else
+        {
+            DX_INFO("Usage: ToyStream bench [--frames n] [--speed m/s] [--io-mbps x] [--sync]");
+            return 1;
+        }
+    }
+    return bench(frame_count, speed, io_mbps, is_sync);
+}
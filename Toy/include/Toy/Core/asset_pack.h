@@ -0,0 +1,104 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+#include <Toy/Core/mapped_file.h>
+
+namespace toy
+{
+    // Asset pack, loose asset files stored in one file that is opened with a single mapping
+    // Layout: header, entry data each aligned to asset_pack_alignment, index sorted by path ID, path names
+    inline constexpr uint32_t asset_pack_version = 1;
+    inline constexpr size_t asset_pack_alignment = 64;
+
+    enum class AssetCompression : uint32_t
+    {
+        None = 0,
+        LZ = 1,             // See lz_compression.h
+    };
+
+    struct AssetPackHeader
+    {
+        uint32_t magic = 0x4B415054;        // "TPAK"
+        uint32_t version = asset_pack_version;
+        uint64_t entry_count = 0;
+        uint64_t index_offset = 0;
+        uint64_t names_offset = 0;
+        uint64_t names_size = 0;
+        uint64_t reserved = 0;
+    };
+
+    struct AssetPackEntry
+    {
+        XID path_id = 0;                    // See asset_pack_path_id
+        uint64_t offset = 0;                // From start of pack
+        uint64_t stored_size = 0;           // Bytes in pack, compressed size when compressed
+        uint64_t size = 0;                  // Original file size
+        XID checksum = 0;                   // content_to_id of original file content
+        AssetCompression compression = AssetCompression::None;
+        uint32_t name_offset = 0;           // Path relative to pack root in name table, for listing and diagnostics
+        uint32_t name_size = 0;
+        uint32_t reserved = 0;
+    };
+
+    static_assert(sizeof(AssetPackHeader) == 48 && sizeof(AssetPackEntry) == 56);
+
+    // ID of path relative to pack root, normalized and case-insensitive as Windows paths are
+    XID asset_pack_path_id(std::string_view relative_path);
+
+    // Read-only asset pack, index and data are used in place from the mapped view
+    class AssetPack
+    {
+    public:
+        AssetPack() = default;
+        explicit AssetPack(const std::filesystem::path& pack_path);
+
+        // Map pack and validate header and every index entry, false if pack is missing or malformed
+        bool open(const std::filesystem::path& pack_path);
+        void close();
+
+        [[nodiscard]] bool is_open() const { return m_file.is_open(); }
+        [[nodiscard]] std::span<const AssetPackEntry> get_entries() const { return m_entries; }
+        [[nodiscard]] const AssetPackEntry* find(XID path_id) const;
+        [[nodiscard]] std::string_view get_name(const AssetPackEntry& entry) const;
+
+        // Bytes as stored, original content unless entry is compressed
+        [[nodiscard]] std::span<const uint8_t> get_stored_bytes(const AssetPackEntry& entry) const;
+        // Decompress or copy into output of entry size, false if data is corrupt
+        // Note: decompressed content is always checked against checksum, stored content only in debug builds
+        bool read(const AssetPackEntry& entry, std::span<uint8_t> output) const;
+        // Check content of entry against its checksum
+        [[nodiscard]] bool verify(const AssetPackEntry& entry) const;
+
+    private:
+        MappedFile m_file;
+        std::span<const AssetPackEntry> m_entries;
+        std::string_view m_names;
+    };
+
+    // File to be packed, name is its path relative to pack root
+    struct AssetPackSource
+    {
+        std::string name;
+        std::filesystem::path file_path;
+    };
+
+    struct AssetPackOptions
+    {
+        bool compress = true;
+        float max_compression_ratio = 0.9f;     // Entry is stored uncompressed unless compressed size is at most this ratio of original
+    };
+
+    // Every regular file under directories of root, recursively, except those under excluded directories
+    // Note: directories are relative to root, sources are sorted by name so that packs are reproducible
+    std::vector<AssetPackSource> collect_asset_pack_sources(const std::filesystem::path& root_dir, std::span<const std::string> directories,
+                                                            std::span<const std::string> excluded_directories = {});
+
+    // Write pack of sources, files are compressed on worker threads
+    // Return false if a source can not be read, two sources share an ID or pack can not be written
+    bool write_asset_pack(const std::filesystem::path& pack_path, std::span<const AssetPackSource> sources,
+                          const AssetPackOptions& options = {});
+}
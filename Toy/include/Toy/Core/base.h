@@ -20,6 +20,7 @@
 #define DXTOY_HOME
 #endif
 
+#if !defined(DXTOY_HEADLESS)
 namespace toy
 {
     template<typename T>
@@ -32,3 +33,4 @@ namespace toy
         object->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<uint32_t>(name.size()), name.data());
     }
 }
+#endif
@@ -0,0 +1,201 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+
+namespace toy
+{
+    inline constexpr size_t default_registry_shard_count = 32;
+
+    // Map of asset ID to value, safe to use from any thread
+    // IDs are spread over shards that each have their own reader-writer lock, so that lookups only share a lock and
+    // writers block nothing but the shard of their ID
+    // Values are returned by copy, T is a cheap shared reference such as std::shared_ptr or com_ptr
+    template <typename T, size_t ShardCount = default_registry_shard_count>
+    class ConcurrentRegistry
+    {
+    public:
+        ConcurrentRegistry() = default;
+
+        ConcurrentRegistry(const ConcurrentRegistry&) = delete;
+        ConcurrentRegistry& operator=(const ConcurrentRegistry&) = delete;
+
+        [[nodiscard]] std::optional<T> find(XID id) const
+        {
+            auto&& shard = get_shard(id);
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.values.find(id);
+            return it != shard.values.end() ? std::optional<T>(it->second) : std::nullopt;
+        }
+
+        [[nodiscard]] bool contains(XID id) const
+        {
+            auto&& shard = get_shard(id);
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            return shard.values.count(id) != 0;
+        }
+
+        // Return false if ID is present already, value is then left as is
+        bool insert(XID id, T value)
+        {
+            auto&& shard = get_shard(id);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            return shard.values.try_emplace(id, std::move(value)).second;
+        }
+
+        void insert_or_assign(XID id, T value)
+        {
+            auto&& shard = get_shard(id);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.values.insert_or_assign(id, std::move(value));
+        }
+
+        // Value is released outside of lock, so that its destructor may use the registry
+        bool erase(XID id)
+        {
+            T value{};
+            auto&& shard = get_shard(id);
+            {
+                std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                auto it = shard.values.find(id);
+                if (it == shard.values.end())
+                {
+                    return false;
+                }
+                value = std::move(it->second);
+                shard.values.erase(it);
+            }
+            return true;
+        }
+
+        // Value of ID, created by create() if absent
+        // Load once, concurrent callers for an ID that is being created wait for that creation and share its value
+        // Note: exception thrown by create is rethrown to every waiting caller, the next call creates again
+        template <typename Create>
+        T get_or_create(XID id, Create&& create)
+        {
+            auto&& shard = get_shard(id);
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                if (auto it = shard.values.find(id); it != shard.values.end())
+                {
+                    return it->second;
+                }
+            }
+
+            std::promise<T> promise{};
+            std::shared_future<T> future{};
+            {
+                std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                if (auto it = shard.values.find(id); it != shard.values.end())
+                {
+                    return it->second;
+                }
+                if (auto it = shard.creating.find(id); it != shard.creating.end())
+                {
+                    future = it->second;
+                } else
+                {
+                    shard.creating.emplace(id, promise.get_future().share());
+                }
+            }
+            if (future.valid())
+            {
+                return future.get();
+            }
+
+            // Creation runs without lock, so that it may use this registry for other IDs
+            try
+            {
+                T value = create();
+                {
+                    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                    shard.values.insert_or_assign(id, value);
+                    shard.creating.erase(id);
+                }
+                promise.set_value(value);
+                return value;
+            } catch (...)
+            {
+                {
+                    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                    shard.creating.erase(id);
+                }
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        // Visit values shard by shard under a shared lock, func must not write to the registry
+        template <typename Func>
+        void for_each(Func&& func) const
+        {
+            for (auto&& shard : m_shards)
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                for (auto&& [id, value] : shard.values)
+                {
+                    func(id, value);
+                }
+            }
+        }
+
+        // Remove values for which pred(id, value) holds, return their count
+        // Like erase, removed values are released outside of lock
+        template <typename Pred>
+        size_t erase_if(Pred&& pred)
+        {
+            size_t count = 0;
+            std::vector<T> removed{};
+            for (auto&& shard : m_shards)
+            {
+                {
+                    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                    for (auto it = shard.values.begin(); it != shard.values.end();)
+                    {
+                        if (pred(it->first, it->second))
+                        {
+                            removed.emplace_back(std::move(it->second));
+                            it = shard.values.erase(it);
+                        } else
+                        {
+                            ++it;
+                        }
+                    }
+                }
+                count += removed.size();
+                removed.clear();
+            }
+            return count;
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            size_t count = 0;
+            for (auto&& shard : m_shards)
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                count += shard.values.size();
+            }
+            return count;
+        }
+
+    private:
+        // Own cache line per shard, so that locking one shard does not slow down readers of its neighbours
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<XID, T> values;
+            std::unordered_map<XID, std::shared_future<T>> creating;      // IDs being created, shared with waiting callers
+        };
+
+        // IDs are FNV hashes, low bits are mixed with high ones so that shards are evenly used
+        [[nodiscard]] const Shard& get_shard(XID id) const { return m_shards[(id ^ (id >> 32)) % ShardCount]; }
+        Shard& get_shard(XID id) { return m_shards[(id ^ (id >> 32)) % ShardCount]; }
+
+        std::array<Shard, ShardCount> m_shards;
+    };
+}
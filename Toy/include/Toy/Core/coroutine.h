@@ -0,0 +1,74 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/parallel.h>
+
+namespace toy
+{
+    // Coroutine owned by its caller, it starts at once and stays suspended at its end until the task is destroyed,
+    // so that owner decides when a coroutine suspended in a queue or on another thread may be freed
+    // Note: coroutine handles its own exceptions, one escaping it terminates as it would from a thread
+    class AsyncTask
+    {
+    public:
+        struct promise_type
+        {
+            AsyncTask get_return_object() { return AsyncTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        AsyncTask() = default;
+        ~AsyncTask() { reset(); }
+
+        AsyncTask(const AsyncTask&) = delete;
+        AsyncTask& operator=(const AsyncTask&) = delete;
+        AsyncTask(AsyncTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        AsyncTask& operator=(AsyncTask&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        // Only safe on the thread that resumes coroutine, or once nothing else can resume it
+        [[nodiscard]] bool is_done() const { return !m_handle || m_handle.done(); }
+
+    private:
+        explicit AsyncTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+        void reset()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+                m_handle = nullptr;
+            }
+        }
+
+        std::coroutine_handle<promise_type> m_handle = nullptr;
+    };
+
+    // co_await resume_on(pool) continues coroutine on a worker of pool
+    struct ResumeOnPool
+    {
+        TaskPool& pool;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { pool.submit([handle]() { handle.resume(); }); }
+        void await_resume() const noexcept {}
+    };
+
+    inline ResumeOnPool resume_on(TaskPool& pool)
+    {
+        return { pool };
+    }
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <Toy/Core/base.h>
+#include <Toy/Core/hash.h>
 
 namespace toy
 {
@@ -44,6 +45,7 @@ namespace toy
         }
     }
 
+#if !defined(DXTOY_HEADLESS)
     // ------------------------------
     // create_shader_from_file function
     // ------------------------------
@@ -80,14 +82,7 @@ namespace toy
         WideCharToMultiByte(65001, 0, wstr.data(), cbMultiByte, &res[0], req, nullptr, nullptr);
         return res;
     }
-
-    // string convert to hash ID
-    using XID = size_t;
-    inline XID string_to_id(std::string_view str)
-    {
-        static std::hash<std::string_view> hash;
-        return hash(str);
-    }
+#endif
 
     namespace XMath
     {
@@ -0,0 +1,78 @@
+//
+// Created by ZZK on 2024/4/2.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy
+{
+    // 64-bit identifier, stable across platforms, standard libraries and runs
+    // Note: can be persisted and used to key on-disk caches
+    using XID = uint64_t;
+
+    namespace hash
+    {
+        inline constexpr uint64_t fnv1a_offset_basis = 14695981039346656037ull;
+        inline constexpr uint64_t fnv1a_prime = 1099511628211ull;
+
+        // FNV-1a 64-bit, used for names and literals
+        constexpr uint64_t fnv1a_64(std::string_view str, uint64_t seed = fnv1a_offset_basis)
+        {
+            uint64_t result = seed;
+            for (char c : str)
+            {
+                result ^= static_cast<uint8_t>(c);
+                result *= fnv1a_prime;
+            }
+            return result;
+        }
+
+        // xxHash64, used for asset content
+        uint64_t xxhash_64(const void *data, size_t byte_width, uint64_t seed = 0);
+
+        // Combine hash value into seed
+        constexpr uint64_t combine(uint64_t seed, uint64_t value)
+        {
+            return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 12) + (seed >> 4));
+        }
+    }
+
+    // String convert to hash ID, can be evaluated at compile time
+    constexpr XID string_to_id(std::string_view str)
+    {
+        return hash::fnv1a_64(str);
+    }
+
+    // Asset path convert to hash ID
+    // Path is normalized first, so that "a/./b.obj" and "a\\b.obj" share the same ID
+    XID path_to_id(std::string_view path);
+
+    // Asset bytes convert to content hash ID
+    XID content_to_id(const void *data, size_t byte_width);
+
+    // Asset file content convert to content hash ID, return 0 if file can not be read
+    XID file_content_to_id(std::string_view file_name);
+
+    // Record source names of hashed IDs and report collisions
+    // Callers refuse the name on collision, otherwise the asset would silently resolve to the one registered first
+    class IdCollisionChecker
+    {
+    public:
+        // Return false and log error if ID has been registered by another name
+        [[nodiscard]] bool check(XID id, std::string_view name);
+
+        void remove(XID id);
+
+    private:
+        std::unordered_map<XID, std::string> m_names;
+    };
+
+    // Compile-time ID of literal, usable as template argument
+    // e.g. material.try_get<std::string>("$Skybox"_xid)
+    consteval XID operator""_xid(const char *str, size_t len)
+    {
+        return hash::fnv1a_64(std::string_view{ str, len });
+    }
+}
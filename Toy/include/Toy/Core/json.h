@@ -0,0 +1,58 @@
+//
+// Created by ZZK on 2024/4/8.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::json
+{
+    class Value;
+    using Array = std::vector<Value>;
+    // Members keep document order, lookup is linear which is fine for small asset descriptions
+    using Object = std::vector<std::pair<std::string, Value>>;
+
+    // Minimal JSON DOM, enough for asset descriptions such as glTF
+    class Value
+    {
+    public:
+        Value() = default;
+        explicit Value(bool boolean) : m_data(boolean) {}
+        explicit Value(double number) : m_data(number) {}
+        explicit Value(std::string&& str) : m_data(std::move(str)) {}
+        explicit Value(Array&& array) : m_data(std::move(array)) {}
+        explicit Value(Object&& object) : m_data(std::move(object)) {}
+
+        [[nodiscard]] bool is_null() const { return std::holds_alternative<std::nullptr_t>(m_data); }
+        [[nodiscard]] bool is_boolean() const { return std::holds_alternative<bool>(m_data); }
+        [[nodiscard]] bool is_number() const { return std::holds_alternative<double>(m_data); }
+        [[nodiscard]] bool is_string() const { return std::holds_alternative<std::string>(m_data); }
+        [[nodiscard]] bool is_array() const { return std::holds_alternative<Array>(m_data); }
+        [[nodiscard]] bool is_object() const { return std::holds_alternative<Object>(m_data); }
+
+        // Typed access, return default value on type mismatch
+        [[nodiscard]] bool as_boolean(bool default_value = false) const;
+        [[nodiscard]] double as_number(double default_value = 0.0) const;
+        [[nodiscard]] float as_float(float default_value = 0.0f) const;
+        [[nodiscard]] int64_t as_integer(int64_t default_value = 0) const;
+        [[nodiscard]] std::string_view as_string(std::string_view default_value = {}) const;
+
+        // Element count of array or member count of object, 0 otherwise
+        [[nodiscard]] size_t size() const;
+        [[nodiscard]] bool contains(std::string_view key) const;
+
+        // Return null value if index or key does not exist
+        const Value& operator[](size_t index) const;
+        const Value& operator[](std::string_view key) const;
+
+        [[nodiscard]] const Array& array() const;
+        [[nodiscard]] const Object& object() const;
+
+    private:
+        std::variant<std::nullptr_t, bool, double, std::string, Array, Object> m_data = nullptr;
+    };
+
+    // Parse UTF-8 JSON text, return false and fill error message if text is malformed
+    bool parse(std::string_view text, Value& value, std::string* error = nullptr);
+}
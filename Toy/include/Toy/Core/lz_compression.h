@@ -0,0 +1,23 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy
+{
+    // Fast byte-oriented LZ compression, stream is a raw LZ4 block so any LZ4 tool can inspect it
+    // Compression is greedy with a single hash probe, decompression is a few hundred MB/s to GB/s per thread
+
+    // Worst case compressed size of byte_width bytes
+    size_t lz_compress_bound(size_t byte_width);
+
+    // Compress into output, which is resized to the compressed size
+    void lz_compress(std::span<const uint8_t> input, std::vector<uint8_t>& output);
+
+    // Decompress into output of exactly the original size, false if stream is malformed or size does not match
+    // Note: never reads or writes out of bounds, corrupt data is rejected rather than trusted
+    bool lz_decompress(std::span<const uint8_t> input, std::span<uint8_t> output);
+}
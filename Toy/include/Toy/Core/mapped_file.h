@@ -0,0 +1,48 @@
+//
+// Created by ZZK on 2024/4/6.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy
+{
+    // Read-only memory mapped file, the whole file is mapped as one view
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& file_path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool open(const std::filesystem::path& file_path);
+        void close();
+
+        [[nodiscard]] bool is_open() const { return m_data != nullptr || m_file != s_invalid_file; }
+        [[nodiscard]] const uint8_t* data() const { return m_data; }
+        [[nodiscard]] size_t size() const { return m_size; }
+        [[nodiscard]] std::span<const uint8_t> bytes() const { return { m_data, m_size }; }
+
+    private:
+#if defined(_WIN32)
+        using FileHandle = void*;                                   // HANDLE
+        static inline FileHandle const s_invalid_file = reinterpret_cast<FileHandle>(static_cast<intptr_t>(-1));
+        void* m_mapping = nullptr;
+#else
+        using FileHandle = int;                                     // POSIX file descriptor, view is mapped by mmap
+        static constexpr FileHandle s_invalid_file = -1;
+#endif
+        FileHandle m_file = s_invalid_file;
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    // Temporary file next to file_path, unique per process, thread and call, to be renamed to file_path once written
+    std::filesystem::path make_temp_path(const std::filesystem::path& file_path);
+}
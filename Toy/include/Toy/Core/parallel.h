@@ -0,0 +1,200 @@
+//
+// Created by ZZK on 2024/4/12.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy
+{
+    // Number of worker threads used when caller does not choose, at least 1
+    size_t get_worker_count();
+
+    // Run func(i) for i in [0, count) on worker threads, block until all are done
+    // Items are claimed one by one, so uneven work such as meshes of different size is balanced
+    // Note: the first exception thrown by func is rethrown on calling thread
+    void parallel_for(size_t count, const std::function<void(size_t)>& func);
+
+    // Work-stealing pool for tasks that spawn further tasks, such as an asset bake whose models discover their textures
+    // Every worker owns a deque, tasks submitted from a worker go to the back of its own deque and it pops from the back,
+    // so that spawned work stays on the same core, idle workers steal the oldest task from the front of other deques
+    // Note: the first exception thrown by a task is rethrown by wait
+    class TaskPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // 0 uses get_worker_count threads
+        explicit TaskPool(size_t num_threads = 0);
+        // Finish every submitted task, then join workers
+        ~TaskPool();
+
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator=(const TaskPool&) = delete;
+
+        // From a task of this pool the task goes to the deque of current worker, otherwise deques are filled in turn
+        void submit(Task&& task);
+        // Block until every submitted task, including tasks spawned by them, is done
+        void wait();
+
+        [[nodiscard]] size_t get_thread_count() const { return m_threads.size(); }
+        // Tasks run by another worker than the one whose deque they were pushed to
+        [[nodiscard]] size_t get_steal_count() const { return m_steal_count.load(); }
+
+    private:
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void run_worker(size_t index);
+        // Back of own deque first, then front of others starting next to it
+        bool take_task(size_t index, Task& task);
+
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::atomic<size_t> m_queued_count = 0;         // Tasks waiting in deques
+        std::atomic<size_t> m_pending_count = 0;        // Tasks submitted and not finished
+        std::atomic<size_t> m_next_queue = 0;
+        std::atomic<size_t> m_steal_count = 0;
+        std::mutex m_mutex;                             // Guards sleeping, waking and exception
+        std::condition_variable m_work_available;
+        std::condition_variable m_all_done;
+        bool m_stopping = false;
+        std::exception_ptr m_exception = nullptr;
+    };
+
+    // Blocking queue of limited capacity between producer and consumer threads
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity) : m_capacity(std::max<size_t>(capacity, 1)) {}
+
+        // Wait for free slot, return false if queue has been closed
+        bool push(T&& value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_full.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+            if (m_closed)
+            {
+                return false;
+            }
+            m_items.push_back(std::move(value));
+            m_not_empty.notify_one();
+            return true;
+        }
+
+        // Wait for an item, return empty once queue is closed and drained
+        std::optional<T> pop()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+            if (m_items.empty())
+            {
+                return std::nullopt;
+            }
+            T value = std::move(m_items.front());
+            m_items.pop_front();
+            m_not_full.notify_one();
+            return value;
+        }
+
+        // Wake every waiting thread, pending items can still be popped
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_not_empty.notify_all();
+            m_not_full.notify_all();
+        }
+
+    private:
+        std::deque<T> m_items;
+        size_t m_capacity;
+        bool m_closed = false;
+        std::mutex m_mutex;
+        std::condition_variable m_not_empty;
+        std::condition_variable m_not_full;
+    };
+
+    // Run produce(i) for i in [0, count) on num_threads worker threads and consume every result on calling thread,
+    // in completion order, through a queue of queue_capacity results, so that at most that many results wait in memory
+    // Used when the consuming step must stay on one thread, such as device context work
+    // Note: the first exception thrown by produce or consume is rethrown on calling thread
+    template <typename Produce, typename Consume>
+    void parallel_pipeline(size_t count, size_t num_threads, size_t queue_capacity, Produce&& produce, Consume&& consume)
+    {
+        using Result = std::invoke_result_t<Produce&, size_t>;
+        num_threads = std::clamp<size_t>(num_threads, 1, std::max<size_t>(count, 1));
+
+        BoundedQueue<Result> queue(queue_capacity);
+        std::atomic<size_t> next_item = 0;
+        std::atomic<size_t> running_threads = num_threads;
+        std::exception_ptr exception = nullptr;
+        std::mutex exception_mutex;
+        auto store_exception = [&]()
+        {
+            std::lock_guard<std::mutex> lock(exception_mutex);
+            if (!exception)
+            {
+                exception = std::current_exception();
+            }
+        };
+
+        auto worker = [&]()
+        {
+            for (size_t i = next_item++; i < count; i = next_item++)
+            {
+                try
+                {
+                    if (!queue.push(produce(i)))
+                    {
+                        break;
+                    }
+                } catch (...)
+                {
+                    store_exception();
+                    queue.close();
+                    break;
+                }
+            }
+            // Last producer lets consumer finish
+            if (--running_threads == 0)
+            {
+                queue.close();
+            }
+        };
+
+        std::vector<std::thread> threads{};
+        threads.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+
+        while (auto result = queue.pop())
+        {
+            try
+            {
+                consume(std::move(*result));
+            } catch (...)
+            {
+                store_exception();
+                queue.close();
+                break;
+            }
+        }
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+}
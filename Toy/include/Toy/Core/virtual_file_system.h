@@ -0,0 +1,92 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/asset_pack.h>
+
+namespace toy
+{
+    // Default asset pack, entries are paths relative to project root, see ToyPack
+    inline constexpr std::string_view default_asset_pack_name = "data.pak";
+
+    // Content of file opened through virtual file system, read-only
+    // Packed content is used in place from the pack mapping unless compressed, loose file is memory mapped
+    class VirtualFile
+    {
+    public:
+        VirtualFile() = default;
+
+        [[nodiscard]] bool is_open() const { return m_is_open; }
+        [[nodiscard]] bool is_packed() const { return m_pack != nullptr; }
+        [[nodiscard]] const uint8_t* data() const { return m_bytes.data(); }
+        [[nodiscard]] size_t size() const { return m_bytes.size(); }
+        [[nodiscard]] std::span<const uint8_t> bytes() const { return m_bytes; }
+
+    private:
+        friend class VirtualFileSystem;
+
+        std::shared_ptr<const AssetPack> m_pack;       // Keeps pack mapped while its bytes are in use, even after unmount
+        MappedFile m_file;
+        std::vector<uint8_t> m_buffer;                 // Decompressed content
+        std::span<const uint8_t> m_bytes;
+        bool m_is_open = false;
+    };
+
+    struct VirtualFileStatistics
+    {
+        uint64_t packed_opens = 0;
+        uint64_t loose_opens = 0;
+        uint64_t failed_opens = 0;
+        uint64_t decompressed_bytes = 0;
+    };
+
+    // Asset file reads prefer mounted packs and fall back to loose files
+    // Note: safe to use from worker threads, mounting while files are being opened is allowed as well
+    class VirtualFileSystem
+    {
+    public:
+        VirtualFileSystem() = default;
+
+        VirtualFileSystem(const VirtualFileSystem&) = delete;
+        VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+        // Mount pack whose entry names are relative to root directory, packs mounted later are searched first
+        // Return false if pack is missing or malformed
+        bool mount(const std::filesystem::path& pack_path, const std::filesystem::path& root_dir);
+        void unmount_all();
+        [[nodiscard]] size_t get_mounted_count() const;
+
+        [[nodiscard]] VirtualFile open(const std::filesystem::path& file_path) const;
+        [[nodiscard]] bool exists(const std::filesystem::path& file_path) const;
+        // Size of file content, 0 if file does not exist
+        [[nodiscard]] uint64_t get_file_size(const std::filesystem::path& file_path) const;
+        // Content ID of file, taken from pack index without reading when packed, 0 if file can not be read
+        [[nodiscard]] XID get_content_id(const std::filesystem::path& file_path) const;
+
+        [[nodiscard]] VirtualFileStatistics get_statistics() const;
+
+        // Singleton
+        static VirtualFileSystem& get();
+
+    private:
+        struct MountedPack
+        {
+            std::shared_ptr<const AssetPack> pack;
+            std::filesystem::path root_dir;
+        };
+
+        // Pack holding file and its entry, null if no mounted pack does
+        [[nodiscard]] std::pair<std::shared_ptr<const AssetPack>, const AssetPackEntry*> find(const std::filesystem::path& file_path) const;
+
+    private:
+        mutable std::shared_mutex m_mutex;
+        std::vector<MountedPack> m_packs;
+
+        mutable std::atomic<uint64_t> m_packed_opens = 0;
+        mutable std::atomic<uint64_t> m_loose_opens = 0;
+        mutable std::atomic<uint64_t> m_failed_opens = 0;
+        mutable std::atomic<uint64_t> m_decompressed_bytes = 0;
+    };
+}
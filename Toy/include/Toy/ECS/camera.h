@@ -136,6 +136,10 @@ namespace toy
         // Get the distance from the current tracked target
         [[nodiscard]] float get_distance() const;
 
+        // Get minimum and maximum allowed distances
+        [[nodiscard]] float get_min_distance() const;
+        [[nodiscard]] float get_max_distance() const;
+
         // Vertical rotation around target(x-axis rotation euler radian is clamped to [0, pi/3])
         void rotate_x(float radian);
 
@@ -7,11 +7,7 @@
 #include <Toy/ECS/transform.h>
 #include <Toy/Renderer/effect_interface.h>
 #include <Toy/ECS/camera.h>
-
-namespace toy::model
-{
-    struct Model;
-}
+#include <Toy/Model/model_handle.h>
 
 namespace toy
 {
@@ -20,6 +16,12 @@ namespace toy
         std::string tag = {};
     };
 
+    // Entity owned by a subsystem such as world streamer or model loader, which creates it again, not saved with scene
+    struct TransientComponent
+    {
+        std::string_view owner = {};            // Name of owning subsystem
+    };
+
     struct TransformComponent
     {
         Transform transform = {};
@@ -46,7 +48,7 @@ namespace toy
 
     struct StaticMeshComponent
     {
-        model::Model* model_asset = nullptr;
+        model::ModelHandle model_asset = {};            // Keeps model resident while component exists
         std::vector<bool> submodel_in_frustum = {};
         bool in_frustum = true;
         bool is_skybox = false;
@@ -58,7 +60,11 @@ namespace toy
 
         // Render
         // Note: transform belongs to model asset
-        void render(ID3D11DeviceContext *device_context, IEffect& effect, const Transform& transform);
+        void render(ID3D11DeviceContext *device_context, IEffect& effect, const Transform& transform, uint32_t entity_id = 1);
+
+        // Request texture detail of visible sub-meshes from view at given position
+        // Note: projection_scale is screen height / (2 * tan(fov_y / 2))
+        void request_textures(const Transform& transform, const DirectX::XMFLOAT3& view_position, float projection_scale) const;
 
         // Bounding box
         [[nodiscard]] DirectX::BoundingBox get_local_bounding_box() const;
@@ -16,7 +16,8 @@ namespace toy
         DockResize,
         KeyTyped,
         MouseMoved, MouseScrolled, MouseButton,
-        Drop
+        Drop,
+        Completion
     };
 
     enum class EventPriority : uint8_t
@@ -42,8 +43,9 @@ namespace toy
     class MouseScrolledEvent;
     class MouseButtonEvent;
     class DropEvent;
+    class CompletionEvent;
 
     using EngineEventVariant = std::variant<NoneEvent, WindowCloseEvent, WindowResizeEvent, DockResizeEvent,
                                 KeyTypedEvent, MouseMovedEvent, MouseScrolledEvent,
-                                MouseButtonEvent, DropEvent>;
+                                MouseButtonEvent, DropEvent, CompletionEvent>;
 }
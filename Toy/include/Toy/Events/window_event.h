@@ -150,6 +150,22 @@ namespace toy
         std::string drop_filename;
         EventPriority event_priority;
     };
+
+    // Work posted from another thread to finish on main thread, such as the rest of a coroutine
+    class CompletionEvent
+    {
+    public:
+        explicit CompletionEvent(std::function<void()> &&func, EventPriority priority = EventPriority::Fourth)
+        : continuation(std::move(func)), event_priority(priority)
+        {
+
+        }
+
+        EVENT_CLASS_TYPE(Completion)
+
+        std::function<void()> continuation;
+        EventPriority event_priority;
+    };
 }
 
 
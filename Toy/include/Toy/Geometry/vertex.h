@@ -50,14 +50,14 @@ namespace toy
         static const std::array<D3D11_INPUT_ELEMENT_DESC, 4> &get_input_layout();
     };
 
-    struct VertexPosNormalTangentTexEntity
+    // Quantized streams, decoded in vertex shader
+    struct VertexPosNormalTangentTexQuantized
     {
-        DirectX::XMFLOAT3 pos;
-        DirectX::XMFLOAT3 normal;
-        DirectX::XMFLOAT4 tangent;
-        DirectX::XMFLOAT2 tex;
-        uint32_t          entity_id;
+        DirectX::PackedVector::XMUSHORTN4 pos;          // Relative to mesh bounding box, w is tangent handedness
+        DirectX::PackedVector::XMSHORTN2  normal;       // Octahedral
+        DirectX::PackedVector::XMSHORTN2  tangent;      // Octahedral
+        DirectX::PackedVector::XMHALF2    tex;
 
-        static const std::array<D3D11_INPUT_ELEMENT_DESC , 5> &get_input_layout();
+        static const std::array<D3D11_INPUT_ELEMENT_DESC, 4> &get_input_layout();
     };
 }
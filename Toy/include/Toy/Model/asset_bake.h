@@ -0,0 +1,25 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // Offline baking of derived assets into their content addressed caches, without a device, see ToyBake
+    enum class BakeStatus
+    {
+        Cached,         // Cache entry of current content already existed
+        Baked,          // Cache entry has been written
+        Skipped,        // Nothing to bake, such as a DDS, a glTF or an image that can not be block compressed
+        Failed
+    };
+
+    struct BakeResult
+    {
+        BakeStatus status = BakeStatus::Skipped;
+        std::vector<std::filesystem::path> outputs;     // Cache files holding the result, empty unless cached or baked
+    };
+}
@@ -0,0 +1,35 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#pragma once
+
+#include <Toy/Model/mip_generator.h>
+
+namespace toy::model
+{
+    // Block compressed formats of 4 x 4 texel blocks
+    enum class BlockFormat : uint32_t
+    {
+        BC1,            // RGB, 4 bits per texel
+        BC3,            // RGB and interpolated alpha, 8 bits per texel
+        BC4,            // R, 4 bits per texel
+        BC5,            // RG, 8 bits per texel, tangent space normal with reconstructed Z
+        BC7             // RGBA, 8 bits per texel, only mode 6 is encoded
+    };
+
+    [[nodiscard]] uint32_t get_block_byte_width(BlockFormat format);
+    [[nodiscard]] DXGI_FORMAT get_dxgi_format(BlockFormat format, bool srgb);
+    // Channels of RGBA stored by format
+    [[nodiscard]] uint32_t get_channel_count(BlockFormat format);
+    // Bytes of one image, dimensions are rounded up to whole blocks
+    [[nodiscard]] size_t get_compressed_byte_width(uint32_t width, uint32_t height, BlockFormat format);
+
+    // Compress RGBA8 image, rows of blocks are compressed on worker threads
+    std::vector<uint8_t> compress_image(const ImageMip& image, BlockFormat format);
+    // Decode blocks to RGBA8, channels not stored by format are 0 and alpha is 255
+    ImageMip decompress_image(std::span<const uint8_t> blocks, uint32_t width, uint32_t height, BlockFormat format);
+
+    // Peak signal to noise ratio in dB over channels stored by format, infinity for identical images
+    double compute_psnr(const ImageMip& reference, const ImageMip& image, BlockFormat format);
+}
@@ -0,0 +1,70 @@
+//
+// Created by ZZK on 2024/4/13.
+//
+
+#pragma once
+
+#include <Toy/Core/d3d_util.h>
+
+namespace toy::model
+{
+    // Requests served by content de-duplication, bytes are those not uploaded again
+    struct DeduplicationStatistics
+    {
+        size_t request_count = 0;
+        size_t shared_count = 0;            // Requests served by an existing resource
+        size_t requested_bytes = 0;
+        size_t saved_bytes = 0;
+    };
+
+    // Immutable vertex and index buffers shared by content
+    // Identical streams of sub-meshes, within one model or across models loaded from different paths, map to one buffer
+    // Every model counts its uses of cached buffers explicitly and releases them when destroyed,
+    // a buffer whose uses dropped to 0 is released by release_unused
+    class BufferCache
+    {
+    public:
+        BufferCache();
+        ~BufferCache();
+
+        BufferCache(BufferCache&) = delete;
+        BufferCache& operator=(const BufferCache&) = delete;
+        BufferCache(BufferCache&&) = delete;
+        BufferCache& operator=(BufferCache&&) = delete;
+
+        // Return existing buffer with identical content and bind flags, or create one
+        // Key of cached buffer is appended to uses, which then holds one use of it until passed to release
+        // Safe from any thread, buffer is created outside of lock
+        com_ptr<ID3D11Buffer> create(ID3D11Device* device, const void* data, size_t byte_width, uint32_t bind_flags, std::vector<XID>& uses);
+        // Drop one use of each buffer, see create
+        void release(std::span<const XID> uses);
+
+        // Drop buffers no longer used, return released bytes
+        size_t release_unused();
+
+        [[nodiscard]] size_t get_resident_bytes() const;
+        [[nodiscard]] DeduplicationStatistics get_statistics() const;
+
+        // Singleton
+        static BufferCache &get();
+        // False once singleton has been destroyed, models outliving it no longer release their uses
+        static bool is_alive();
+
+    private:
+        struct Entry
+        {
+            com_ptr<ID3D11Buffer> buffer;
+            size_t byte_width = 0;
+            XID check = 0;                  // Hash with another seed, guards against key collision
+            uint32_t use_count = 0;
+        };
+
+        mutable std::mutex m_mutex;
+        std::unordered_map<XID, Entry> m_buffers;
+        DeduplicationStatistics m_statistics;
+        size_t m_resident_bytes = 0;
+    };
+
+    // Reference count of COM object, used to find resources only held by a cache
+    uint32_t get_reference_count(IUnknown* object);
+}
@@ -0,0 +1,62 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // DDS of 2D texture, array or cube, with DX10 header as written by on-disk caches or with legacy header of older tools
+    // Data holds mip chains of every array slice one after another, the order of Direct3D subresources
+    struct DdsDesc
+    {
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mip_count = 1;
+        uint32_t array_size = 1;            // 2D slices, 6 per cube
+        bool is_cube = false;
+        uint32_t pitch_or_linear_size = 0;  // Row pitch of uncompressed or byte width of block compressed top mip
+    };
+
+    struct DdsFile
+    {
+        DdsDesc desc;
+        std::vector<uint8_t> data;
+    };
+
+    // Rows of texels, or of 4 x 4 blocks for block compressed formats, tightly packed
+    struct DdsSubresource
+    {
+        std::span<const uint8_t> bytes;
+        uint32_t row_pitch = 0;
+        uint32_t slice_pitch = 0;
+    };
+
+    // DDS parsed in place, subresources point into the bytes it was parsed from, such as a memory mapped file
+    struct DdsView
+    {
+        DdsDesc desc;
+        std::vector<DdsSubresource> subresources;      // Index is mip + slice * mip_count, as D3D11CalcSubresource
+
+        [[nodiscard]] const DdsSubresource& get_subresource(uint32_t mip, uint32_t slice = 0) const
+        {
+            return subresources[mip + slice * desc.mip_count];
+        }
+    };
+
+    // Bytes of a 4 x 4 block, 0 if format is not block compressed
+    [[nodiscard]] uint32_t get_block_byte_width(DXGI_FORMAT format);
+
+    // Validate header and locate every subresource, nothing is copied
+    // Empty if malformed, truncated, of 1D or volume texture, or of a format whose layout is unknown here
+    std::optional<DdsView> parse_dds(std::span<const uint8_t> bytes);
+
+    // Read header and data, empty if missing or malformed
+    // Note: format is not checked against what caller expects, data holds at least every subresource
+    std::optional<DdsFile> read_dds_file(const std::filesystem::path& file_path);
+    // Write atomically, a partially written file is never visible under the final name
+    bool write_dds_file(const std::filesystem::path& file_path, const DdsDesc& desc, std::span<const uint8_t> data);
+}
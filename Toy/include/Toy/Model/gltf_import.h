@@ -0,0 +1,44 @@
+//
+// Created by ZZK on 2024/4/8.
+//
+
+#pragma once
+
+#include <Toy/Model/texture_decoder.h>
+#include <Toy/Model/material.h>
+
+namespace toy::model
+{
+    class GltfDocument;
+
+    // Triangle primitive converted into engine layout and optimised, as Assimp import leaves a mesh
+    struct GltfMesh
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT4> tangents;
+        std::vector<DirectX::XMFLOAT4> bitangents;
+        std::vector<std::vector<DirectX::XMFLOAT2>> texcoords;
+        std::vector<uint32_t> indices;
+        uint32_t material_index = 0;
+        float uv_density = 0.0f;
+        DirectX::BoundingBox bounding_box;
+    };
+
+    // glTF model on CPU, before any resource is created
+    struct GltfModel
+    {
+        std::vector<GltfMesh> meshes;
+        std::vector<Material> materials;                    // Default material is appended for primitives without one
+        DirectX::BoundingBox bounding_box;
+        std::vector<TextureSource> texture_sources;
+        std::deque<std::vector<uint8_t>> decoded_images;    // Data URI images, texture sources point into them
+        std::shared_ptr<const GltfDocument> document;       // Mapped buffers, embedded texture sources point into them
+    };
+
+    // CPU stage of load_gltf, parse JSON once and convert accessors in a single pass from the mapped buffer,
+    // then optimise primitives in parallel, see mesh_optimizer.h
+    // Output matches the Assimp import path: one mesh per triangle primitive, left-handed, node transforms ignored
+    // Return false if file uses unsupported features (sparse accessors, required extensions), so that caller can fall back to Assimp
+    bool import_gltf(std::string_view file_name, GltfModel& model);
+}
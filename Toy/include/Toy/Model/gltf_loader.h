@@ -0,0 +1,19 @@
+//
+// Created by ZZK on 2024/4/8.
+//
+
+#pragma once
+
+#include <Toy/Model/mesh_data.h>
+
+namespace toy::model
+{
+    struct Model;
+
+    // Native glTF 2.0 loader for .gltf and .glb, bypasses Assimp since glTF buffers are already typed arrays
+    // Primitives are converted on CPU by import_gltf first, see gltf_import.h
+    // Return false without touching device if file uses unsupported features (sparse accessors, required extensions),
+    // so that caller can fall back to Assimp
+    // Quantized encoding splits primitives into 16-bit indexable chunks, see vertex_encoding.h
+    bool load_gltf(Model& model, ID3D11Device* device, std::string_view file_name, VertexEncoding vertex_encoding = VertexEncoding::Full);
+}
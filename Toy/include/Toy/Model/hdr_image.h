@@ -0,0 +1,36 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // Texel layout of decoded Radiance image, both formats are sampled as float RGB
+    enum class HdrFormat : uint32_t
+    {
+        RGBA16F,        // 8 bytes, alpha is 1, supported by CPU mip generator
+        RGB9E5          // 4 bytes, shared exponent, no alpha
+    };
+
+    [[nodiscard]] uint32_t get_texel_byte_width(HdrFormat format);
+    [[nodiscard]] DXGI_FORMAT get_dxgi_format(HdrFormat format);
+
+    struct HdrImage
+    {
+        HdrFormat format = HdrFormat::RGBA16F;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Radiance RGBE header, "#?RADIANCE" or "#?RGBE"
+    [[nodiscard]] bool is_radiance_image(std::span<const uint8_t> data);
+
+    // Decode RGBE scanlines one at a time straight into format, no float image is held at any point
+    // Only the common "-Y height +X width" orientation is supported, as with stb image
+    std::optional<HdrImage> decode_hdr_image(std::span<const uint8_t> data, HdrFormat format);
+    std::optional<HdrImage> load_hdr_image(const std::filesystem::path& file_path, HdrFormat format);
+}
@@ -0,0 +1,57 @@
+//
+// Created by ZZK on 2024/4/7.
+//
+
+#pragma once
+
+#include <Toy/Core/virtual_file_system.h>
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+namespace toy::model
+{
+    // Read-only Assimp stream over a memory mapped file or asset pack entry
+    // Note: Read() copies straight from the mapped view, no stdio buffering in between
+    class MappedIOStream : public Assimp::IOStream
+    {
+    public:
+        explicit MappedIOStream(VirtualFile&& file);
+        ~MappedIOStream() override = default;
+
+        size_t Read(void* buffer, size_t size, size_t count) override;
+        size_t Write(const void* buffer, size_t size, size_t count) override;
+        aiReturn Seek(size_t offset, aiOrigin origin) override;
+        [[nodiscard]] size_t Tell() const override;
+        [[nodiscard]] size_t FileSize() const override;
+        void Flush() override;
+
+    private:
+        VirtualFile m_file;
+        size_t m_position = 0;
+    };
+
+    // Assimp IO system backed by virtual file system, files come from mounted asset packs or are memory mapped
+    // Relative paths, e.g. sibling .mtl/.bin/texture files, resolve against directory of the imported model first
+    class MappedIOSystem : public Assimp::IOSystem
+    {
+    public:
+        explicit MappedIOSystem(std::string_view model_file_name);
+        ~MappedIOSystem() override = default;
+
+        bool Exists(const char* file_name) const override;
+        [[nodiscard]] char getOsSeparator() const override;
+        Assimp::IOStream* Open(const char* file_name, const char* mode = "rb") override;
+        void Close(Assimp::IOStream* stream) override;
+
+        // Resolved path of every file opened so far, source file included
+        [[nodiscard]] const std::vector<std::string>& get_opened_files() const { return m_opened_files; }
+
+    private:
+        [[nodiscard]] std::filesystem::path resolve(const char* file_name) const;
+
+    private:
+        std::filesystem::path m_base_dir;
+        std::vector<std::string> m_opened_files;
+    };
+}
@@ -44,6 +44,35 @@ namespace toy::model
         }
     }
 
+    inline constexpr uint32_t material_semantics_count = 0
+#define MATERIAL_SEMANTICS_COUNT_FUNCTION(name) + 1
+        FOREACH_MATERIAL_SEMANTICS(MATERIAL_SEMANTICS_COUNT_FUNCTION);
+#undef MATERIAL_SEMANTICS_COUNT_FUNCTION
+
+    // Semantics are grouped by value type: texture maps, then colors, then scalars
+    inline constexpr uint32_t material_texture_count = static_cast<uint32_t>(MaterialSemantics::DiffuseColor);
+    inline constexpr uint32_t material_color_count = static_cast<uint32_t>(MaterialSemantics::SpecularFactor) - material_texture_count;
+    inline constexpr uint32_t material_scalar_count = material_semantics_count - material_texture_count - material_color_count;
+    static_assert(material_semantics_count <= 32, "Presence mask of material only holds 32 semantics");
+
+    // Material constants, must match CBMaterial in data/pbr/material_cb.hlsl
+    struct MaterialConstants
+    {
+        DirectX::XMFLOAT4 base_color_opacity = { 0.8f, 0.8f, 0.8f, 1.0f };
+        DirectX::XMFLOAT4 specular_anisotropic = { 0.2f, 0.2f, 0.2f, 0.0f };
+
+        float metalness = 0.5f;
+        float roughness = 0.5f;
+        float specular_strength = 0.0f;
+        float specular_tint = 0.0f;
+
+        uint32_t no_diffuse_srv = 1;
+        uint32_t no_normal_srv = 1;
+        uint32_t no_metalness_srv = 1;
+        uint32_t no_roughness_srv = 1;
+    };
+    static_assert(sizeof(MaterialConstants) == 64, "MaterialConstants does not match CBMaterial");
+
     class Material
     {
     public:
@@ -51,34 +80,135 @@ namespace toy::model
 
         void clear()
         {
+            m_textures.fill(0);
+            m_colors.fill(DirectX::XMFLOAT4{});
+            m_scalars.fill(0.0f);
+            m_presence_mask = 0;
+            m_constants = MaterialConstants{};
+            m_constants_dirty = true;
             m_Properties.clear();
         }
 
+        // Known semantics - fixed layout access
+        // Texture handle is the interned texture name id, 0 refers to the null texture of texture manager
+        void set_texture(MaterialSemantics semantics, XID texture_handle)
+        {
+            m_textures[texture_slot(semantics)] = texture_handle;
+            mark_present(semantics);
+        }
+
+        void set_color(MaterialSemantics semantics, const DirectX::XMFLOAT4& color)
+        {
+            m_colors[color_slot(semantics)] = color;
+            mark_present(semantics);
+        }
+
+        void set_scalar(MaterialSemantics semantics, float value)
+        {
+            m_scalars[scalar_slot(semantics)] = value;
+            mark_present(semantics);
+        }
+
+        [[nodiscard]] XID get_texture(MaterialSemantics semantics) const
+        {
+            return m_textures[texture_slot(semantics)];
+        }
+
+        [[nodiscard]] const DirectX::XMFLOAT4& get_color(MaterialSemantics semantics) const
+        {
+            return m_colors[color_slot(semantics)];
+        }
+
+        // Note: mutable access invalidates baked constants
+        DirectX::XMFLOAT4& get_color(MaterialSemantics semantics)
+        {
+            m_constants_dirty = true;
+            return m_colors[color_slot(semantics)];
+        }
+
+        [[nodiscard]] float get_scalar(MaterialSemantics semantics) const
+        {
+            return m_scalars[scalar_slot(semantics)];
+        }
+
+        // Note: mutable access invalidates baked constants
+        float& get_scalar(MaterialSemantics semantics)
+        {
+            m_constants_dirty = true;
+            return m_scalars[scalar_slot(semantics)];
+        }
+
+        [[nodiscard]] bool has(MaterialSemantics semantics) const
+        {
+            return (m_presence_mask >> static_cast<uint32_t>(semantics)) & 1u;
+        }
+
+        [[nodiscard]] uint32_t get_presence_mask() const
+        {
+            return m_presence_mask;
+        }
+
+        // Bake material constants from fixed layout, invoked once after loading
+        void bake()
+        {
+            bake_constants();
+        }
+
+        // Baked material constants, only re-baked after fixed layout has been modified
+        [[nodiscard]] const MaterialConstants& get_constants() const
+        {
+            if (m_constants_dirty)
+            {
+                bake_constants();
+            }
+            return m_constants;
+        }
+
+        // Extension properties - generic map access
+        // Note: prefer XID overloads with compile-time ids for constant names, e.g. "$Skybox"_xid
         template<typename T>
-        void set(std::string_view name, const T& value)
+        void set(XID id, const T& value)
         {
             static_assert(is_variant_member_v<T, Property>, "Type T is not one of the Property types");
-            m_Properties[string_to_id(name)] = value;
+            m_Properties[id] = value;
+        }
+
+        template<typename T>
+        void set(std::string_view name, const T& value)
+        {
+            set<T>(string_to_id(name), value);
+        }
+
+        template<typename T>
+        const T& get(XID id) const
+        {
+            auto it = m_Properties.find(id);
+            return std::get<T>(it->second);
         }
 
         template<typename T>
         const T& get(std::string_view name) const
         {
-            auto it = m_Properties.find(string_to_id(name));
+            return get<T>(string_to_id(name));
+        }
+
+        template<typename T>
+        T& get(XID id)
+        {
+            auto it = m_Properties.find(id);
             return std::get<T>(it->second);
         }
 
         template<typename T>
         T& get(std::string_view name)
         {
-            auto it = m_Properties.find(string_to_id(name));
-            return std::get<T>(it->second);
+            return get<T>(string_to_id(name));
         }
 
         template<typename T>
-        [[nodiscard]] bool has(std::string_view name) const
+        [[nodiscard]] bool has(XID id) const
         {
-            auto it = m_Properties.find(string_to_id(name));
+            auto it = m_Properties.find(id);
             if (it == m_Properties.end() || !std::holds_alternative<T>(it->second))
             {
                 return false;
@@ -87,9 +217,15 @@ namespace toy::model
         }
 
         template<typename T>
-        const T* try_get(std::string_view name) const
+        [[nodiscard]] bool has(std::string_view name) const
+        {
+            return has<T>(string_to_id(name));
+        }
+
+        template<typename T>
+        const T* try_get(XID id) const
         {
-            auto it = m_Properties.find(string_to_id(name));
+            auto it = m_Properties.find(id);
             if (it != m_Properties.end())
             {
                 return &std::get<T>(it->second);
@@ -99,18 +235,77 @@ namespace toy::model
             }
         }
 
+        template<typename T>
+        const T* try_get(std::string_view name) const
+        {
+            return try_get<T>(string_to_id(name));
+        }
+
+        template<typename T>
+        T* try_get(XID id)
+        {
+            return const_cast<T *>(std::as_const(*this).template try_get<T>(id));
+        }
+
         template<typename T>
         T* try_get(std::string_view name)
         {
-            return const_cast<T *>(this->try_get<T>(name));
+            return try_get<T>(string_to_id(name));
+        }
+
+        [[nodiscard]] bool has_property(XID id) const
+        {
+            return m_Properties.find(id) != m_Properties.end();
         }
 
         [[nodiscard]] bool has_property(std::string_view name) const
         {
-            return m_Properties.find(string_to_id(name)) != m_Properties.end();
+            return has_property(string_to_id(name));
+        }
+
+    private:
+        static constexpr uint32_t texture_slot(MaterialSemantics semantics)
+        {
+            return static_cast<uint32_t>(semantics);
+        }
+
+        static constexpr uint32_t color_slot(MaterialSemantics semantics)
+        {
+            return static_cast<uint32_t>(semantics) - material_texture_count;
+        }
+
+        static constexpr uint32_t scalar_slot(MaterialSemantics semantics)
+        {
+            return static_cast<uint32_t>(semantics) - material_texture_count - material_color_count;
+        }
+
+        void bake_constants() const
+        {
+            const DirectX::XMFLOAT4 &specular_color = m_colors[color_slot(MaterialSemantics::SpecularColor)];
+            m_constants.base_color_opacity = m_colors[color_slot(MaterialSemantics::DiffuseColor)];
+            m_constants.specular_anisotropic = DirectX::XMFLOAT4{ specular_color.x, specular_color.y, specular_color.z, 0.0f };
+            m_constants.metalness = m_scalars[scalar_slot(MaterialSemantics::Metalness)];
+            m_constants.roughness = m_scalars[scalar_slot(MaterialSemantics::Roughness)];
+            m_constants.no_diffuse_srv = !has(MaterialSemantics::DiffuseMap);
+            m_constants.no_normal_srv = !has(MaterialSemantics::NormalMap);
+            m_constants.no_metalness_srv = !has(MaterialSemantics::MetalnessMap);
+            m_constants.no_roughness_srv = !has(MaterialSemantics::RoughnessMap);
+            m_constants_dirty = false;
+        }
+
+        void mark_present(MaterialSemantics semantics)
+        {
+            m_presence_mask |= 1u << static_cast<uint32_t>(semantics);
+            m_constants_dirty = true;
         }
 
     private:
+        std::array<XID, material_texture_count> m_textures = {};
+        std::array<DirectX::XMFLOAT4, material_color_count> m_colors = {};
+        std::array<float, material_scalar_count> m_scalars = {};
+        uint32_t m_presence_mask = 0;
+        mutable bool m_constants_dirty = true;
+        mutable MaterialConstants m_constants = {};
         std::unordered_map<XID, Property> m_Properties;
     };
 }
@@ -0,0 +1,186 @@
+//
+// Created by ZZK on 2024/4/6.
+//
+
+#pragma once
+
+#include <Toy/Model/material.h>
+#include <Toy/Model/vertex_encoding.h>
+
+namespace toy::model
+{
+    struct TextureSource;
+
+    // Processed mesh cache
+    // Versioned binary image of the post-processed model import, streams are stored in upload-ready layout
+    // so that a warm load maps the cache file and creates buffers straight from the mapped view
+    // Vertex and index streams are stored as is by default, see MeshStreamStorage for encoding them with mesh_codec
+    // Files read by import besides the source, e.g. .mtl material libraries, are recorded with their content ID,
+    // cache is stale once one of them changes
+    inline constexpr uint32_t mesh_cache_magic = 0x48534D54;        // "TMSH"
+    inline constexpr uint32_t mesh_cache_version = 7;               // Bump when layout or import processing changes
+    inline constexpr uint32_t mesh_cache_alignment = 16;
+    inline constexpr uint32_t mesh_cache_max_texcoords = 8;
+    inline constexpr float mesh_cache_max_encoded_ratio = 0.9f;     // Encoded stream is only kept if it saves more than 10%
+
+    // Storage of vertex and index streams, part of cache key
+    // Plain streams upload straight from the mapped cache file, encoded ones are decoded into a scratch buffer first,
+    // which is the copy plain storage avoids. Vertex streams decode at about 3.5 GB/s, index buffers at 0.7 - 1 GB/s,
+    // so encoded storage only loads faster where the file is read below roughly 750 MB/s, e.g. cold reads from HDD, SATA
+    // or network, or where cache size on disk matters more than load time. Measure with ToyBake bench-codec
+    enum class MeshStreamStorage : uint32_t
+    {
+        Plain,
+        Encoded         // Stream is encoded by mesh_codec if that saves more than 10%, see mesh_cache_max_encoded_ratio
+    };
+
+    // Location of data inside cache image, offset is relative to the beginning of image
+    struct MeshCacheBlob
+    {
+        uint64_t offset = 0;
+        uint64_t byte_width = 0;
+        uint64_t decoded_byte_width = 0;        // Byte width of stream encoded by mesh_codec, 0 if stored as is
+    };
+
+    struct MeshCacheHeader
+    {
+        uint32_t magic = mesh_cache_magic;
+        uint32_t version = mesh_cache_version;
+        XID key = 0;
+        uint64_t byte_width = 0;
+        uint32_t mesh_count = 0;
+        uint32_t material_count = 0;
+        uint32_t dependency_count = 0;
+        uint32_t padding = 0;
+        MeshCacheBlob meshes;
+        MeshCacheBlob materials;
+        MeshCacheBlob dependencies;             // MeshCacheDependency array
+        DirectX::BoundingBox bounding_box;
+    };
+
+    struct MeshCacheDependency
+    {
+        XID content_id = 0;                     // 0 if file could not be read during import
+        MeshCacheBlob path;
+    };
+
+    struct MeshCacheMesh
+    {
+        uint32_t vertex_count = 0;
+        uint32_t index_count = 0;
+        uint32_t index_stride = 0;              // 2 or 4 bytes
+        uint32_t texcoord_count = 0;
+        uint32_t material_index = 0;
+        uint32_t vertex_encoding = 0;           // VertexEncoding
+        float uv_density = 0.0f;                // See MeshData::uv_density
+        DirectX::BoundingBox bounding_box;      // Also quantization range of quantized mesh
+
+        // Full precision / quantized layout
+        MeshCacheBlob positions;                // XMFLOAT3 / XMUSHORTN4
+        MeshCacheBlob normals;                  // XMFLOAT3 / XMSHORTN2
+        MeshCacheBlob tangents;                 // XMFLOAT4 / XMSHORTN2
+        MeshCacheBlob bitangents;               // XMFLOAT4 / none
+        MeshCacheBlob indices;                  // uint16_t or uint32_t / uint16_t
+        std::array<MeshCacheBlob, mesh_cache_max_texcoords> texcoords;  // XMFLOAT2 / XMHALF2
+    };
+
+    enum class MeshCacheTextureSource : uint32_t
+    {
+        None,
+        File,
+        Embedded
+    };
+
+    struct MeshCacheTexture
+    {
+        MeshCacheTextureSource source = MeshCacheTextureSource::None;
+        uint32_t gen_mips = 0;
+        uint32_t force_SRGB = 0;
+        uint32_t padding = 0;
+        MeshCacheBlob name;                     // Texture name, file path or embedded texture name
+        MeshCacheBlob data;                     // Compressed embedded texture data
+    };
+
+    // Extension color property of material
+    struct MeshCacheProperty
+    {
+        XID id = 0;
+        DirectX::XMFLOAT4 value;
+    };
+
+    struct MeshCacheMaterial
+    {
+        uint32_t presence_mask = 0;
+        uint32_t property_count = 0;
+        std::array<DirectX::XMFLOAT4, material_color_count> colors = {};
+        std::array<float, material_scalar_count> scalars = {};
+        std::array<MeshCacheTexture, material_texture_count> textures = {};
+        MeshCacheBlob properties;               // MeshCacheProperty array
+    };
+
+    // Build cache image while importing
+    class MeshCacheWriter
+    {
+    public:
+        explicit MeshCacheWriter(XID key, MeshStreamStorage stream_storage = MeshStreamStorage::Plain);
+
+        // Append data aligned to mesh_cache_alignment
+        MeshCacheBlob append(const void* data, size_t byte_width);
+        MeshCacheBlob append_string(std::string_view str);
+        // Append mesh stream, encoded by mesh_codec under MeshStreamStorage::Encoded when that pays off, as is otherwise
+        MeshCacheBlob append_vertex_stream(const void* data, size_t vertex_count, uint32_t vertex_stride);
+        MeshCacheBlob append_index_buffer(const void* data, size_t index_count, uint32_t index_stride);
+        // Embedded texture referenced by several materials is only stored once
+        MeshCacheBlob append_embedded_texture(std::string_view name, const void* data, size_t byte_width);
+        // Record file read by import, its current content ID is taken
+        void add_dependency(std::string_view file_name);
+
+        std::vector<MeshCacheMesh>& meshes() { return m_meshes; }
+        std::vector<MeshCacheMaterial>& materials() { return m_materials; }
+        void set_bounding_box(const DirectX::BoundingBox& bounding_box) { m_header.bounding_box = bounding_box; }
+
+        // Append mesh and material tables and patch header, writer is left empty
+        std::vector<uint8_t> finish();
+
+    private:
+        MeshCacheHeader m_header;
+        MeshStreamStorage m_stream_storage;
+        std::vector<uint8_t> m_image;
+        std::vector<MeshCacheMesh> m_meshes;
+        std::vector<MeshCacheMaterial> m_materials;
+        std::vector<MeshCacheDependency> m_dependencies;
+        std::unordered_map<XID, MeshCacheBlob> m_embedded_textures;
+    };
+
+    // Cache key, combination of source content hash, import flags, vertex encoding, stream storage and cache version,
+    // 0 if source can not be read
+    // Note: other files read by import are not part of key, they are checked against the header by validate_mesh_cache
+    XID mesh_cache_key(std::string_view file_name, uint32_t import_flags, uint32_t import_properties, VertexEncoding vertex_encoding,
+                       MeshStreamStorage stream_storage);
+    std::filesystem::path mesh_cache_path(XID key);
+
+    // Check header, version, key, that every table and blob lies inside the image and that no dependency has changed
+    bool validate_mesh_cache(std::span<const uint8_t> image, XID key);
+
+    // Typed view of blob of a validated cache image, an encoded stream is viewed as its encoded bytes
+    template<typename T>
+    std::span<const T> get_mesh_cache_blob(std::span<const uint8_t> image, const MeshCacheBlob& blob)
+    {
+        return { reinterpret_cast<const T *>(image.data() + blob.offset), static_cast<size_t>(blob.byte_width / sizeof(T)) };
+    }
+
+    std::string_view get_mesh_cache_string(std::span<const uint8_t> image, const MeshCacheBlob& blob);
+
+    // Texture of material slot, embedded data points into image
+    TextureSource get_mesh_cache_texture(std::span<const uint8_t> image, const MeshCacheTexture& texture, uint32_t slot);
+
+    // Textures of every material of a validated cache image, in material and slot order, embedded data points into image
+    std::vector<TextureSource> get_mesh_cache_textures(std::span<const uint8_t> image);
+
+    // Files read by import besides the source, paths point into a validated cache image
+    std::vector<std::string_view> get_mesh_cache_dependencies(std::span<const uint8_t> image);
+
+    // Write cache image atomically, a partially written cache is never visible under the final name
+    // Temporary file is unique per writer, so that processes and threads baking the same cache do not write into each other
+    bool save_mesh_cache(const std::filesystem::path& cache_path, std::span<const uint8_t> image);
+}
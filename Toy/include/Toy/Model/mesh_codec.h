@@ -0,0 +1,43 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // Lossless codec of mesh streams for on-disk assets, streams decode to exactly the bytes encoded
+    // * Index buffer - every triangle is coded against FIFOs of recent edges and vertices, a triangle list
+    //   reordered by optimize_mesh takes about 2 bytes per triangle
+    // * Vertex stream - every byte of a vertex is delta coded against the same byte of previous vertex, deltas of a byte plane
+    //   are bit packed at 0, 2, 4 or 8 bits per group of 16 vertices, decoder unpacks and transposes 16 vertices at a time with SSE2
+    // Encoded stream starts with MeshStreamHeader, so decoding needs nothing but the stream
+    inline constexpr uint8_t mesh_codec_version = 1;
+    inline constexpr uint32_t mesh_codec_max_vertex_stride = 256;
+
+    enum class MeshStreamKind : uint8_t
+    {
+        Index,
+        Vertex
+    };
+
+    struct MeshStreamHeader
+    {
+        MeshStreamKind kind = MeshStreamKind::Vertex;
+        uint8_t version = mesh_codec_version;
+        uint16_t stride = 0;                // Bytes of an index or a vertex
+        uint32_t count = 0;                 // Indices or vertices
+    };
+
+    // Empty if index count is not a multiple of 3 or index stride is neither 2 nor 4
+    std::vector<uint8_t> encode_index_buffer(const void* indices, size_t index_count, uint32_t index_stride);
+    // Empty if vertex stride is not a multiple of 4 up to mesh_codec_max_vertex_stride
+    std::vector<uint8_t> encode_vertex_stream(const void* vertices, size_t vertex_count, uint32_t vertex_stride);
+
+    // Bytes of decoded stream, 0 if header is malformed
+    [[nodiscard]] size_t get_decoded_byte_width(std::span<const uint8_t> encoded);
+    // Decode into output of get_decoded_byte_width bytes, false if stream is malformed or truncated
+    bool decode_mesh_stream(std::span<const uint8_t> encoded, std::span<uint8_t> output);
+}
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <Toy/Core/base.h>
+#include <Toy/Model/vertex_encoding.h>
 
 namespace toy::model
 {
@@ -18,13 +18,15 @@ namespace toy::model
         com_ptr<ID3D11Buffer> colors;
 
         com_ptr<ID3D11Buffer> indices;
-        com_ptr<ID3D11Buffer> entity_id_buffer;
 
         uint32_t vertex_count = 0;
         uint32_t index_count = 0;
         uint32_t material_index = 0;
+        DXGI_FORMAT index_format = DXGI_FORMAT_R16_UINT;
+        VertexEncoding vertex_encoding = VertexEncoding::Full;
 
         DirectX::BoundingBox bounding_box;
+        float uv_density = 0.0f;        // World space area per area of first texture coordinates, 0 if unknown
         bool in_frustum = true;
     };
 }
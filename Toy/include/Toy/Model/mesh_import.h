@@ -0,0 +1,27 @@
+//
+// Created by ZZK on 2023/5/31.
+//
+
+#pragma once
+
+#include <Toy/Model/mesh_cache.h>
+#include <Toy/Model/asset_bake.h>
+
+namespace toy::model
+{
+    // Processed mesh cache key of model file, covering import post processing, 0 if file can not be read
+    XID import_cache_key(std::string_view file_name, VertexEncoding vertex_encoding, MeshStreamStorage stream_storage = MeshStreamStorage::Plain);
+
+    // Import model file via Assimp, post-processed result is packed into a processed mesh cache image
+    // Note: model that can not be imported throws
+    std::vector<uint8_t> import_model(std::string_view file_name, XID cache_key, VertexEncoding vertex_encoding,
+                                      MeshStreamStorage stream_storage = MeshStreamStorage::Plain);
+
+    bool is_gltf_file(std::string_view file_name);
+
+    // Import model into its processed mesh cache without a device, as Model::create_from_file would on first load
+    // glTF is skipped since it is loaded natively, textures of the model are found through get_mesh_cache_textures of output
+    // Note: model that can not be imported throws like create_from_file
+    BakeResult bake_mesh_cache(std::string_view file_name, VertexEncoding vertex_encoding = VertexEncoding::Full,
+                               MeshStreamStorage stream_storage = MeshStreamStorage::Plain);
+}
@@ -0,0 +1,88 @@
+//
+// Created by ZZK on 2024/4/12.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // Mesh optimisation stage, run on triangle lists before upload
+    // 0. Vertex welding, vertices with identical attributes are merged
+    // 1. Vertex cache reordering (Tipsify), also produces clusters of triangles
+    // 2. Overdraw reordering, clusters facing outward are drawn first
+    // 3. Vertex fetch remapping, vertex order follows first use in index buffer
+    inline constexpr uint32_t vertex_cache_size = 16;           // Post-transform cache size assumed by reordering and statistics
+    inline constexpr float overdraw_cluster_threshold = 1.05f;  // Cluster split allowed while cluster ACMR stays under threshold * mesh ACMR
+    inline constexpr uint32_t overdraw_grid_size = 256;         // Resolution of overdraw analysis
+
+    struct MeshStatistics
+    {
+        size_t triangle_count = 0;
+        size_t vertex_count = 0;                // Referenced vertices
+        size_t transformed_vertex_count = 0;    // Post-transform cache misses in FIFO cache of vertex_cache_size
+        size_t shaded_pixel_count = 0;          // Pixels passing depth test, over 6 axis-aligned views
+        size_t covered_pixel_count = 0;
+
+        // Average cache miss ratio, transformed vertices per triangle
+        [[nodiscard]] float acmr() const { return triangle_count ? static_cast<float>(transformed_vertex_count) / static_cast<float>(triangle_count) : 0.0f; }
+        // Average transform to vertex ratio, 1 is optimal
+        [[nodiscard]] float atvr() const { return vertex_count ? static_cast<float>(transformed_vertex_count) / static_cast<float>(vertex_count) : 0.0f; }
+        // Shaded pixels per covered pixel, 1 is optimal
+        [[nodiscard]] float overdraw() const { return covered_pixel_count ? static_cast<float>(shaded_pixel_count) / static_cast<float>(covered_pixel_count) : 0.0f; }
+
+        MeshStatistics& operator+=(const MeshStatistics& other);
+    };
+
+    // Strided attribute stream, compared byte-wise when welding
+    struct VertexStreamView
+    {
+        const void* data = nullptr;
+        size_t stride = 0;
+        size_t byte_width = 0;          // Compared bytes of every element, not larger than stride
+    };
+
+    template<typename T>
+    VertexStreamView make_stream_view(std::span<const T> stream, size_t byte_width = sizeof(T))
+    {
+        return { stream.data(), sizeof(T), byte_width };
+    }
+
+    MeshStatistics analyze_mesh(std::span<const uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions);
+
+    // Point indices of duplicate vertices to first vertex with identical bytes in every stream, return number of unique vertices
+    // Note: duplicates are left unreferenced, optimize_vertex_fetch drops them
+    size_t weld_vertices(std::span<uint32_t> indices, size_t vertex_count, std::span<const VertexStreamView> streams);
+
+    // Reorder triangles for post-transform vertex cache, return offsets of triangle clusters separated by cache flushes
+    std::vector<uint32_t> optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count);
+
+    // Reorder clusters of triangles so that outward facing clusters are drawn first
+    // Hard clusters from optimize_vertex_cache are split further while vertex cache efficiency stays under threshold
+    void optimize_overdraw(std::span<uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions,
+                           std::span<const uint32_t> clusters, float threshold = overdraw_cluster_threshold);
+
+    // Rewrite indices so that vertices are numbered by first use, return remap table from new vertex to old vertex
+    // Note: unreferenced vertices are dropped
+    std::vector<uint32_t> optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count);
+
+    // Run all stages, return vertex fetch remap table, see remap_vertex_stream
+    // Attributes are the streams other than position that must match for vertices to be welded
+    std::vector<uint32_t> optimize_mesh(std::span<uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions,
+                                        std::span<const VertexStreamView> attributes = {});
+
+    // Report metrics of a mesh or a whole model before and after optimisation
+    void log_mesh_statistics(std::string_view name, const MeshStatistics& before, const MeshStatistics& after);
+
+    template<typename T>
+    std::vector<T> remap_vertex_stream(std::span<const T> stream, std::span<const uint32_t> remap)
+    {
+        std::vector<T> result(stream.empty() ? 0 : remap.size());
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            result[i] = stream[remap[i]];
+        }
+        return result;
+    }
+}
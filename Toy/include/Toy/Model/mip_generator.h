@@ -0,0 +1,56 @@
+//
+// Created by ZZK on 2024/4/15.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // Texel layout of ImageMip, every format has 4 channels
+    enum class MipFormat : uint32_t
+    {
+        RGBA8,
+        RGBA16F,
+        RGBA32F
+    };
+
+    enum class MipFilter : uint32_t
+    {
+        Box,            // 2 x 2 average
+        Kaiser          // Kaiser windowed sinc over 6 x 6 texels, keeps distant detail sharper than box
+    };
+
+    struct MipOptions
+    {
+        MipFormat format = MipFormat::RGBA8;
+        MipFilter filter = MipFilter::Box;
+        bool srgb = false;              // RGBA8 color channels are sRGB encoded and filtered in linear space
+        bool normal_map = false;        // RGB is a unit vector, scale-biased to [0, 1] in RGBA8, renormalized on every mip
+    };
+
+    // One level of a tightly packed image
+    struct ImageMip
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    [[nodiscard]] uint32_t get_mip_count(uint32_t width, uint32_t height);
+    [[nodiscard]] uint32_t get_texel_byte_width(MipFormat format);
+
+    // Mip chain down to 1 x 1, each level is filtered from the previous one in linear space with 4-wide vector math,
+    // rows of a level are filtered on worker threads
+    // Linear RGBA8 box filter averages 8-bit texels directly, rounding like an integer 2 x 2 average on every level
+    // Levels more detailed than first_mip are only computed on the way down and not returned
+    std::vector<ImageMip> generate_mip_chain(const uint8_t* pixels, uint32_t width, uint32_t height, const MipOptions& options,
+        uint32_t first_mip = 0);
+
+    // 2 x 2 box filtered RGBA8 mip chain
+    inline std::vector<ImageMip> generate_mip_chain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, uint32_t first_mip = 0)
+    {
+        return generate_mip_chain(pixels, width, height, MipOptions{ MipFormat::RGBA8, MipFilter::Box, srgb, false }, first_mip);
+    }
+}
@@ -0,0 +1,45 @@
+//
+// Created by ZZK on 2024/4/14.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+
+namespace toy::model
+{
+    struct Model;
+
+    // Counted reference to a model of ModelManager, a referenced model is never evicted
+    // Obtained from ModelManager::acquire, copies share the reference count
+    // Handle owns the model it refers to, so it stays valid while manager is used from other threads
+    class ModelHandle
+    {
+    public:
+        ModelHandle() = default;
+        ~ModelHandle();
+
+        ModelHandle(const ModelHandle& other);
+        ModelHandle& operator=(const ModelHandle& other);
+        ModelHandle(ModelHandle&& other) noexcept;
+        ModelHandle& operator=(ModelHandle&& other) noexcept;
+
+        [[nodiscard]] Model* get() const { return m_model.get(); }
+        Model* operator->() const { return m_model.get(); }
+        Model& operator*() const { return *m_model; }
+        explicit operator bool() const { return m_model != nullptr; }
+
+        [[nodiscard]] XID get_id() const { return m_id; }
+
+        // Drop reference, handle becomes empty
+        void reset();
+
+    private:
+        friend class ModelManager;
+        // Reference has been counted by manager already
+        ModelHandle(XID id, std::shared_ptr<Model> model);
+
+        XID m_id = 0;
+        std::shared_ptr<Model> m_model;
+    };
+}
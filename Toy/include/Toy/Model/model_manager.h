@@ -6,6 +6,10 @@
 
 #include <Toy/Model/mesh_data.h>
 #include <Toy/Model/material.h>
+#include <Toy/Model/model_handle.h>
+#include <Toy/Model/residency_policy.h>
+#include <Toy/Model/mesh_import.h>
+#include <Toy/Core/concurrent_registry.h>
 #include <Toy/Geometry/geometry.h>
 
 namespace toy::model
@@ -13,50 +17,114 @@ namespace toy::model
     struct Model
     {
         Model() = default;
-        ~Model() = default;
+        ~Model();
 
         Model(const Model&) = delete;
         Model& operator=(const Model&) = delete;
         Model(Model&&) noexcept = default;
-        Model& operator=(Model&&) = default;
+        Model& operator=(Model&& other) noexcept;
 
         std::vector<Material> materials;
         std::vector<MeshData> meshes;
         DirectX::BoundingBox bounding_box;
+        std::vector<XID> cached_buffers;        // Uses of BufferCache buffers by meshes, released with model
 
-        static void create_from_file(Model& model, ID3D11Device* device, std::string_view file_name, uint32_t entity_id = 1);
+        // Drop meshes and materials, and release uses of cached buffers
+        void clear();
+
+        static void create_from_file(Model& model, ID3D11Device* device, std::string_view file_name, VertexEncoding vertex_encoding = VertexEncoding::Full,
+                                     MeshStreamStorage stream_storage = MeshStreamStorage::Plain);
         static void create_from_geometry(Model& model, ID3D11Device* device, const geometry::GeometryData& data, bool is_dynamic = false);
 
+        // Bytes of vertex and index buffers, buffers shared with other models are counted by each of them
+        [[nodiscard]] size_t get_byte_width() const;
+
         void set_debug_object_name(std::string_view name);
     };
 
+    // Models are owned through ModelHandle, unreferenced models stay resident until memory budget is exceeded,
+    // then they are evicted in least recently used order, see ResidencyPolicy
+    // Safe from any thread, lookups only lock a shard of the registry and a model requested by several threads at once is
+    // loaded once, reference counts and residency are kept under one lock that is never held while loading
     class ModelManager
     {
     public:
-        ModelManager() = default;
-        ~ModelManager() = default;
+        ModelManager();
+        ~ModelManager();
 
         ModelManager(ModelManager&) = delete;
         ModelManager& operator=(const ModelManager&) = delete;
-        ModelManager(ModelManager&&) noexcept = default;
-        ModelManager& operator=(ModelManager&&) = default;
+        ModelManager(ModelManager&&) = delete;
+        ModelManager& operator=(ModelManager&&) = delete;
 
         void init(ID3D11Device* device);
 
-        Model* create_from_file(std::string_view file_name, uint32_t entity_id = 1);
-        Model* create_from_file(std::string_view name, std::string_view file_name, uint32_t entity_id = 1);
-        Model* create_from_geometry(std::string_view name, const geometry::GeometryData& data, bool is_dynamic = false);
-
-        [[nodiscard]] const Model* get_model(std::string_view name) const;
-        Model* get_model(std::string_view name);
+        // Load once, model already resident under name is returned as is
+        // Note: throws if ID of name belongs to another model, as create_from_geometry does
+        ModelHandle create_from_file(std::string_view file_name);
+        ModelHandle create_from_file(std::string_view name, std::string_view file_name);
+        // Model created before under name is replaced, handles to it keep the former model
+        ModelHandle create_from_geometry(std::string_view name, const geometry::GeometryData& data, bool is_dynamic = false);
+        // Counted reference to model, model loaded from file is reloaded if it has been evicted
+        // Return empty handle if model is unknown
+        ModelHandle acquire(std::string_view name);
+        // Counted reference to model by its stable ID, as saved scenes refer to models
+        // Model unknown to manager is loaded from file under that ID, if a file is given
+        ModelHandle acquire(XID model_id, std::string_view file_name = {});
+
+        // Remove unreferenced model, buffers shared with other models stay alive until every model using them is removed
+        void remove_model(std::string_view name);
+
+        // Budget of vertex and index buffers of all models, unreferenced models are evicted once exceeded
+        void set_memory_budget(size_t budget);
+        [[nodiscard]] size_t get_memory_budget() const;
+        [[nodiscard]] ResidencyStatistics get_residency_statistics() const;
+
+        // Vertex encoding of models imported from file afterwards
+        void set_vertex_encoding(VertexEncoding vertex_encoding) { m_vertex_encoding = vertex_encoding; }
+        [[nodiscard]] VertexEncoding get_vertex_encoding() const { return m_vertex_encoding.load(); }
+        // Stream storage of processed mesh caches written and read afterwards, plain unless load is bound by disk reads
+        void set_stream_storage(MeshStreamStorage stream_storage) { m_stream_storage = stream_storage; }
+        [[nodiscard]] MeshStreamStorage get_stream_storage() const { return m_stream_storage.load(); }
+
+        // Resident model without counting a reference, it stays alive while held but may be evicted from manager
+        [[nodiscard]] std::shared_ptr<Model> get_model(std::string_view name) const;
+        // Source file of model loaded from file, empty for models created from geometry
+        [[nodiscard]] std::string get_model_file(XID model_id) const;
+
+        // Log bytes saved by buffer and texture de-duplication
+        void report_deduplication() const;
 
         // Singleton
         static ModelManager &get();
 
     private:
+        friend class ModelHandle;
+        // False once singleton has been destroyed, handles outliving it no longer count references
+        static bool is_alive();
+        ModelHandle create_from_file(XID model_id, std::string_view name, std::string_view file_name);
+        void add_reference(XID model_id);
+        void release_reference(XID model_id);
+
+        // Track model after (re)creation and return a counted reference to it, then evict other models if over budget
+        // Model found in registry but evicted meanwhile is tracked again, so that registry and residency always agree
+        ModelHandle register_model(XID model_id, const std::shared_ptr<Model>& model, bool is_created);
+        // Throw if ID of name has been registered by another model
+        void check_model_id(XID model_id, std::string_view name);
+        // Caller holds m_mutex
+        void evict_unused();
+
         com_ptr<ID3D11Device> m_device_;
         com_ptr<ID3D11DeviceContext> m_device_context_;
-        std::unordered_map<size_t, Model> m_models;
+        ConcurrentRegistry<std::shared_ptr<Model>> m_models;
+        std::atomic<VertexEncoding> m_vertex_encoding = VertexEncoding::Full;
+        std::atomic<MeshStreamStorage> m_stream_storage = MeshStreamStorage::Plain;
+
+        // Bookkeeping, locked before any shard of m_models
+        mutable std::mutex m_mutex;
+        IdCollisionChecker m_id_checker;
+        ResidencyPolicy m_residency;
+        std::unordered_map<XID, std::string> m_model_files;     // Source of models loaded from file, used to reload after eviction
     };
 }
 
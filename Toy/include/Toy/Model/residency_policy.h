@@ -0,0 +1,76 @@
+//
+// Created by ZZK on 2024/4/14.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+
+namespace toy::model
+{
+    inline constexpr size_t default_residency_budget = 1024ull * 1024ull * 1024ull;
+    inline constexpr size_t residency_eviction_history = 4096;     // Evicted IDs remembered to count reloads
+
+    struct ResidencyStatistics
+    {
+        size_t resident_bytes = 0;
+        size_t peak_resident_bytes = 0;
+        size_t resident_count = 0;
+        size_t eviction_count = 0;
+        size_t evicted_bytes = 0;
+        size_t reload_count = 0;            // Resources added again after one of the last evictions, see residency_eviction_history
+    };
+
+    // Reference counted residency under a memory budget
+    // Only bookkeeping by ID and byte width, owner of resources releases what evict returns,
+    // so that policy runs without a device and can be driven with fake sizes
+    // Unreferenced resources stay resident for reuse and are evicted in least recently used order once over budget
+    class ResidencyPolicy
+    {
+    public:
+        explicit ResidencyPolicy(size_t budget = default_residency_budget) : m_budget(budget) {}
+
+        void set_budget(size_t budget) { m_budget = budget; }
+        [[nodiscard]] size_t get_budget() const { return m_budget; }
+
+        // Track resource as unreferenced and most recently used, or update size of tracked resource
+        void add(XID id, size_t byte_width);
+        // Stop tracking resource without counting an eviction
+        void remove(XID id);
+
+        void add_reference(XID id);
+        void release_reference(XID id);
+        // Mark unreferenced resource as most recently used
+        void touch(XID id);
+
+        [[nodiscard]] bool contains(XID id) const { return m_entries.count(id) != 0; }
+        [[nodiscard]] uint32_t get_reference_count(XID id) const;
+        // Only the last residency_eviction_history evictions are remembered
+        [[nodiscard]] bool was_evicted(XID id) const { return m_evicted.count(id) != 0; }
+
+        // Pick unreferenced resources in LRU order until incoming bytes fit in budget, picked resources are no longer tracked
+        // Note: referenced resources are never picked, so residency may stay over budget
+        std::vector<XID> evict(size_t incoming_byte_width = 0);
+
+        [[nodiscard]] const ResidencyStatistics& get_statistics() const { return m_statistics; }
+
+    private:
+        struct Entry
+        {
+            size_t byte_width = 0;
+            uint32_t reference_count = 0;
+            std::list<XID>::iterator lru_position;      // Valid while unreferenced
+        };
+
+        void untrack(std::unordered_map<XID, Entry>::iterator it);
+        void remember_eviction(XID id);
+
+        std::unordered_map<XID, Entry> m_entries;
+        std::list<XID> m_lru;                           // Unreferenced resources, least recently used first
+        std::unordered_map<XID, uint64_t> m_evicted;                // Evicted ID to its eviction number
+        std::deque<std::pair<XID, uint64_t>> m_eviction_order;      // Oldest eviction first, may hold reloaded IDs
+        uint64_t m_eviction_number = 0;
+        size_t m_budget;
+        ResidencyStatistics m_statistics;
+    };
+}
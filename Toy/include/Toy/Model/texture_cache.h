@@ -0,0 +1,61 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#pragma once
+
+#include <Toy/Model/block_compression.h>
+#include <Toy/Model/material.h>
+
+namespace toy::model
+{
+    // Texture cache
+    // Source images of material textures are mipmapped and block compressed once at import, by what they hold,
+    // and stored as DDS named by content so that later loads upload compressed mips straight from the cache
+    inline constexpr uint32_t texture_cache_version = 2;           // Bump when mip generation or encoders change
+
+    // What texture holds, selects its block format
+    enum class TextureUsage : uint32_t
+    {
+        Generic,            // Not compressed, such as UI and HDR images
+        Albedo,             // BC7
+        Specular,           // BC1
+        Normal,             // BC5, tangent space XY, Z is reconstructed in shader
+        Mask                // BC4, single channel such as metalness, roughness and occlusion
+    };
+
+    [[nodiscard]] TextureUsage get_texture_usage(MaterialSemantics semantics);
+    [[nodiscard]] std::optional<BlockFormat> get_block_format(TextureUsage usage);
+
+    // Block compressed mip chain, mips are stored contiguously from most detailed
+    struct CompressedTexture
+    {
+        BlockFormat block_format = BlockFormat::BC7;
+        bool srgb = false;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mip_count = 0;
+        std::vector<uint8_t> data;
+
+        [[nodiscard]] DXGI_FORMAT get_format() const { return get_dxgi_format(block_format, srgb); }
+        [[nodiscard]] uint32_t get_mip_width(uint32_t mip) const { return std::max(width >> mip, 1u); }
+        [[nodiscard]] uint32_t get_mip_height(uint32_t mip) const { return std::max(height >> mip, 1u); }
+        // Bytes between rows of blocks
+        [[nodiscard]] uint32_t get_row_pitch(uint32_t mip) const;
+        [[nodiscard]] std::span<const uint8_t> get_mip(uint32_t mip) const;
+    };
+
+    // Cache key, combination of source content key, usage and cache version
+    XID texture_cache_key(XID content_key, TextureUsage usage);
+    std::filesystem::path texture_cache_path(XID key);
+
+    // Generate Kaiser filtered mips of RGBA8 image and compress them, report quality and saved memory through log
+    // Note: dimensions must be multiples of 4, as Direct3D requires of block compressed textures
+    CompressedTexture compress_texture(std::string_view name, const uint8_t* pixels, uint32_t width, uint32_t height,
+        TextureUsage usage, bool srgb);
+
+    // Read DDS written by save_texture_cache, empty if missing or malformed
+    std::optional<CompressedTexture> load_texture_cache(const std::filesystem::path& cache_path);
+    // Write DDS atomically, a partially written cache is never visible under the final name
+    bool save_texture_cache(const std::filesystem::path& cache_path, const CompressedTexture& texture);
+}
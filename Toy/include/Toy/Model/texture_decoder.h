@@ -0,0 +1,59 @@
+//
+// Created by ZZK on 2023/5/31.
+//
+
+#pragma once
+
+#include <Toy/Model/texture_cache.h>
+#include <Toy/Model/asset_bake.h>
+#include <Toy/Model/dds_file.h>
+#include <Toy/Model/hdr_image.h>
+#include <Toy/Core/virtual_file_system.h>
+
+namespace toy::model
+{
+    // Texture to create by TextureManager::create_batch
+    struct TextureSource
+    {
+        std::string name;                   // File path, or name of embedded image
+        std::span<const uint8_t> data;      // Encoded embedded image, empty for file, must stay valid during creation
+        bool enable_mips = false;
+        uint32_t force_SRGB = 0;
+        TextureUsage usage = TextureUsage::Generic;     // Block compressed through texture cache unless generic
+    };
+
+    struct StbImageDeleter
+    {
+        void operator()(uint8_t *pixel_data) const;
+    };
+
+    // Pixels decoded off the owning thread, DDS files are parsed in place and only need the device for upload
+    struct DecodedImage
+    {
+        std::unique_ptr<uint8_t, StbImageDeleter> pixels;
+        int32_t width = 0;
+        int32_t height = 0;
+        bool is_dds = false;                            // Left to DDS loader, for layouts parse_dds does not handle
+        VirtualFile dds_file;                           // Mapped or packed DDS, subresources of dds point into it
+        std::optional<DdsView> dds;
+        std::optional<HdrImage> hdr;                    // Replaces pixels for Radiance image
+        std::vector<ImageMip> mips;                     // Replaces pixels when mips are enabled
+        std::optional<CompressedTexture> compressed;    // Replaces pixels when texture is block compressed
+        std::filesystem::path cache_path;               // Texture cache holding compressed, empty if it could not be written
+    };
+
+    // Content key covers creation options, the same bytes created with other options are another texture
+    XID texture_content_key(XID content_id, bool enable_mips, uint32_t force_SRGB);
+    // Content key and byte width of source, unreadable file is not shared and loader reports the error
+    std::pair<XID, size_t> source_content_key(const TextureSource& source);
+
+    bool is_dds_file(std::string_view filename);
+
+    // Only touches source and texture cache, safe on worker threads
+    // DDS files are left to upload unless allow_dds, which then only has their header validated
+    DecodedImage decode_image(const TextureSource& source, XID content_key, bool allow_dds);
+
+    // Compress source into texture cache without a device, as create_batch would on first load
+    // Generic textures, DDS files, Radiance images and sizes that are not whole blocks are skipped
+    BakeResult bake_texture_cache(const TextureSource& source);
+}
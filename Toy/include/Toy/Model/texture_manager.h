@@ -4,10 +4,32 @@
 
 #pragma once
 
-#include <Toy/Core/d3d_util.h>
+#include <Toy/Model/buffer_cache.h>
+#include <Toy/Model/texture_streaming.h>
+#include <Toy/Model/texture_decoder.h>
+#include <Toy/Core/concurrent_registry.h>
 
 namespace toy::model
 {
+    // Reference to a texture of TextureManager by its ID, resolved on use
+    // View of streamed texture is replaced whenever its resident mips change, handle always resolves to the current one
+    class TextureHandle
+    {
+    public:
+        TextureHandle() = default;
+        explicit TextureHandle(XID id) : m_id(id) {}
+
+        [[nodiscard]] XID get_id() const { return m_id; }
+        // Current view, null if texture has been removed
+        [[nodiscard]] com_ptr<ID3D11ShaderResourceView> get() const;
+
+    private:
+        XID m_id = 0;
+    };
+
+    // Safe from any thread, lookups only lock a shard of the registry and a texture requested by several threads at once
+    // is created once, other bookkeeping is kept under one lock that is never held while decoding
+    // Note: streaming, and mip generation of DDS files by the DDS library, only run on the thread that called init
     class TextureManager
     {
     public:
@@ -16,27 +38,101 @@ namespace toy::model
 
         TextureManager(TextureManager&) = delete;
         TextureManager& operator=(const TextureManager&) = delete;
-        TextureManager(TextureManager&&) noexcept = default;
-        TextureManager& operator=(TextureManager&&) = default;
+        TextureManager(TextureManager&&) = delete;
+        TextureManager& operator=(TextureManager&&) = delete;
 
         void init(ID3D11Device* device);
 
-        ID3D11ShaderResourceView* create_from_file(std::string_view filename, bool enable_mips = false, uint32_t force_SRGB = 0);
-        ID3D11ShaderResourceView* create_from_memory(std::string_view name, void* data, size_t byte_width, bool enable_mips = false, uint32_t force_SRGB = 0);
+        // Textures of other than generic usage are created with every mip from texture cache, whatever enable_mips is
+        // Load once, texture already created under name is returned as is
+        // Note: throws if ID of name belongs to another texture, create_batch skips such names and add_texture returns false
+        TextureHandle create_from_file(std::string_view filename, bool enable_mips = false, uint32_t force_SRGB = 0,
+                                       TextureUsage usage = TextureUsage::Generic);
+        TextureHandle create_from_memory(std::string_view name, void* data, size_t byte_width, bool enable_mips = false,
+                                         uint32_t force_SRGB = 0, TextureUsage usage = TextureUsage::Generic);
+        // Decode images on worker threads while uploading decoded ones on calling thread
+        // Textures already loaded, or sharing content with a loaded texture, are not decoded
+        // Note: a texture created by another thread during decode is kept, the decoded duplicate is dropped before upload
+        void create_batch(std::span<const TextureSource> sources);
+        // Worker threads of create_batch, 0 uses every hardware thread
+        void set_decode_thread_count(size_t thread_count) { m_decode_thread_count = thread_count; }
 
         bool add_texture(std::string_view name, ID3D11ShaderResourceView* texture);
+        // Texture shared by content with other names stays alive until every name is removed
         void remove_texture(std::string_view name);
 
-        ID3D11ShaderResourceView* get_texture(std::string_view filename);
-        ID3D11ShaderResourceView* get_null_texture();
+        // Note: view of streamed texture is replaced whenever its resident mips change, look it up by id every frame
+        // Raw view is held by manager, off the thread that called init hold get_texture_view or a TextureHandle instead
+        ID3D11ShaderResourceView* get_texture(std::string_view filename) const;
+        // Obtain texture by interned name id, 0 refers to null texture
+        ID3D11ShaderResourceView* get_texture(XID texture_id) const;
+        ID3D11ShaderResourceView* get_null_texture() const;
+        [[nodiscard]] com_ptr<ID3D11ShaderResourceView> get_texture_view(XID texture_id) const;
+
+        // Saved bytes are source image bytes not decoded and uploaded again
+        [[nodiscard]] DeduplicationStatistics get_statistics() const;
+
+        // Mipmapped 8-bit images loaded from file and block compressed images loaded afterwards start with their mip tail resident,
+        // more detailed mips are streamed in on request within budget
+        void enable_streaming(size_t budget = default_texture_budget);
+        [[nodiscard]] bool is_streaming_enabled() const { return m_streaming_enabled.load(); }
+        // Ask for texture detail of this frame, see compute_screen_uv_area, ignored for textures not streamed
+        void request_texture(XID texture_id, float screen_uv_area);
+        // Apply requests of this frame, called once per frame after every view requested
+        void update_streaming();
+        [[nodiscard]] TextureStreamingStatistics get_streaming_statistics() const;
 
         // Singleton
         static TextureManager &get();
 
     private:
+        // Same image bytes loaded under another name, with the same creation options, share one texture
+        com_ptr<ID3D11ShaderResourceView> share_texture(std::string_view name, XID content_key, size_t byte_width);
+        void register_texture_content(XID content_key, ID3D11ShaderResourceView* texture);
+        // Return false if ID of name has been registered by another texture
+        bool check_texture_id(XID name_id, std::string_view name);
+
+        // Single texture path of create_from_file and create_from_memory
+        TextureHandle create_texture(const TextureSource& source);
+        // Device stage of creation, runs on calling thread, caller registers returned view under name
+        com_ptr<ID3D11ShaderResourceView> upload_image(XID name_id, const TextureSource& source, XID content_key, DecodedImage& image);
+        com_ptr<ID3D11ShaderResourceView> upload_dds(XID name_id, const TextureSource& source, XID content_key, const DecodedImage& image);
+        com_ptr<ID3D11ShaderResourceView> upload_compressed(XID name_id, const TextureSource& source, XID content_key, const DecodedImage& image);
+
+        // Source of streamed texture, mips are decoded again from file or read again from DDS on promotion
+        struct StreamedTexture
+        {
+            std::string file_name;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            std::filesystem::path dds_path;         // Compressed mips in texture cache or source DDS, empty for RGBA8 image
+        };
+
+        // Create texture holding mips from first_mip down
+        com_ptr<ID3D11ShaderResourceView> upload_streamed_mips(const StreamedTexture& streamed_texture, uint32_t first_mip,
+                                                               std::span<const D3D11_SUBRESOURCE_DATA> mips);
+        // Replace texture of name, caller holds m_mutex
+        void promote_texture(XID texture_id, uint32_t resident_mip);
+        void demote_texture(XID texture_id, uint32_t resident_mip);
+
+        // Immediate context is not thread safe, other threads create textures through the device only
+        [[nodiscard]] bool is_owner_thread() const { return std::this_thread::get_id() == m_owner_thread; }
+
         com_ptr<ID3D11Device> m_device;
         com_ptr<ID3D11DeviceContext> m_device_context;
-        std::unordered_map<XID, com_ptr<ID3D11ShaderResourceView>> m_texture_srvs;
+        std::thread::id m_owner_thread;
+        ConcurrentRegistry<com_ptr<ID3D11ShaderResourceView>> m_texture_srvs;
+        ConcurrentRegistry<com_ptr<ID3D11ShaderResourceView>> m_content_srvs;      // Content key to texture
+        std::atomic<bool> m_streaming_enabled = false;
+        std::atomic<size_t> m_decode_thread_count = 0;
+
+        // Bookkeeping, locked before any shard of registries
+        mutable std::mutex m_mutex;
+        IdCollisionChecker m_id_checker;
+        DeduplicationStatistics m_statistics;
+        TextureStreamingPolicy m_streaming;
+        std::unordered_map<XID, StreamedTexture> m_streamed_textures;
     };
 }
 
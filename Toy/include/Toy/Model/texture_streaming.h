@@ -0,0 +1,96 @@
+//
+// Created by ZZK on 2024/4/15.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+
+namespace toy::model
+{
+    inline constexpr size_t default_texture_budget = 512ull * 1024ull * 1024ull;
+    inline constexpr uint32_t streaming_mip_tail_size = 64;                             // Mips up to this size are always resident
+    inline constexpr size_t streaming_upload_bytes_per_update = 32ull * 1024ull * 1024ull;  // At least one promotion per update
+
+    // World space area per texture coordinate area, 0 if texture coordinates span no area
+    float compute_uv_density(std::span<const uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions,
+                             std::span<const DirectX::XMFLOAT2> texcoords);
+
+    // Screen pixel area per texture coordinate area of a mesh at given distance
+    // projection_scale is screen height / (2 * tan(fov_y / 2)), that is pixels per world unit at unit distance
+    float compute_screen_uv_area(float uv_density, float world_scale, float distance, float projection_scale);
+
+    // Most detailed mip keeping about one texel per pixel, 0 is full resolution
+    uint32_t compute_required_mip(uint32_t width, uint32_t height, float screen_uv_area);
+
+    struct TextureStreamingStatistics
+    {
+        size_t resident_bytes = 0;
+        size_t requested_bytes = 0;         // Bytes if every request of last update were satisfied
+        size_t streamed_texture_count = 0;
+        size_t promotion_count = 0;
+        size_t demotion_count = 0;
+        size_t promoted_bytes = 0;          // Uploaded by promotions
+    };
+
+    // New most detailed resident mip of a texture
+    struct MipChange
+    {
+        XID id = 0;
+        uint32_t resident_mip = 0;
+        bool promotion = false;
+    };
+
+    // Mip residency of streamed textures under a memory budget
+    // Textures start with mip tail resident, update promotes requested textures, largest on screen first,
+    // and demotes least recently requested textures back to their tail when budget is exceeded
+    // Only bookkeeping, texture owner uploads or drops mips of returned changes, so policy runs without a device
+    class TextureStreamingPolicy
+    {
+    public:
+        explicit TextureStreamingPolicy(size_t budget = default_texture_budget) : m_budget(budget) {}
+
+        void set_budget(size_t budget) { m_budget = budget; }
+        [[nodiscard]] size_t get_budget() const { return m_budget; }
+
+        // Track texture with mip tail resident, block compressed textures have 4 or 8 bits per texel
+        void add(XID id, uint32_t width, uint32_t height, uint32_t bits_per_texel);
+        void remove(XID id);
+
+        // Request texture for this update, most detailed of several requests wins
+        void request(XID id, float screen_uv_area);
+
+        // Decide resident mips and clear requests
+        std::vector<MipChange> update();
+
+        [[nodiscard]] bool contains(XID id) const { return m_textures.count(id) != 0; }
+        [[nodiscard]] uint32_t get_resident_mip(XID id) const;
+        [[nodiscard]] uint32_t get_tail_mip(XID id) const;
+        [[nodiscard]] const TextureStreamingStatistics& get_statistics() const { return m_statistics; }
+
+        // Bytes of mips from first_mip down to 1 x 1
+        static size_t get_mip_chain_byte_width(uint32_t width, uint32_t height, uint32_t bits_per_texel, uint32_t first_mip);
+
+    private:
+        struct StreamedTexture
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t bits_per_texel = 0;
+            uint32_t tail_mip = 0;
+            uint32_t resident_mip = 0;
+            uint32_t requested_mip = 0;
+            float screen_uv_area = 0.0f;        // Largest requested this update, 0 if not requested
+            uint64_t last_request = 0;          // Update index of last request
+        };
+
+        [[nodiscard]] size_t byte_width(const StreamedTexture& texture, uint32_t mip) const;
+        // Drop mips more detailed than given mip
+        void demote(XID id, StreamedTexture& texture, uint32_t mip, std::vector<MipChange>& changes);
+
+        std::unordered_map<XID, StreamedTexture> m_textures;
+        size_t m_budget;
+        uint64_t m_update_index = 0;
+        TextureStreamingStatistics m_statistics;
+    };
+}
@@ -0,0 +1,88 @@
+//
+// Created by ZZK on 2024/4/10.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::model
+{
+    // Vertex stream encoding chosen at import time
+    enum class VertexEncoding : uint32_t
+    {
+        Full,           // 32-bit float streams
+        Quantized       // Normalized position, octahedral normal and tangent, half float texture coordinates
+    };
+
+    // Quantized vertex layout, 20 bytes per vertex instead of 48 in full precision
+    // * Position - 16-bit unorm relative to mesh bounding box, w holds tangent handedness
+    // * Normal and tangent - octahedral 16-bit snorm
+    // * Texture coordinates - half float
+    // Quantized meshes are split into chunks of at most 65536 vertices, so that indices are always 16-bit
+    inline constexpr uint32_t quantized_chunk_max_vertices = 65536;
+    inline constexpr uint32_t full_precision_vertex_byte_width = 48;       // VertexPosNormalTangentTex
+    inline constexpr uint32_t quantized_vertex_byte_width = 20;            // VertexPosNormalTangentTexQuantized
+
+    // Full precision streams of one mesh, source of encoding
+    struct VertexStreams
+    {
+        std::span<const DirectX::XMFLOAT3> positions;
+        std::span<const DirectX::XMFLOAT3> normals;                 // Optional
+        std::span<const DirectX::XMFLOAT4> tangents;                // Optional, w is handedness
+        std::vector<std::span<const DirectX::XMFLOAT2>> texcoords;
+        std::span<const uint32_t> indices;                          // Triangle list
+    };
+
+    struct QuantizedChunk
+    {
+        DirectX::BoundingBox bounding_box;                          // Quantization range, also bounding box of chunk mesh
+        std::vector<DirectX::PackedVector::XMUSHORTN4> positions;
+        std::vector<DirectX::PackedVector::XMSHORTN2> normals;
+        std::vector<DirectX::PackedVector::XMSHORTN2> tangents;
+        std::vector<std::vector<DirectX::PackedVector::XMHALF2>> texcoords;
+        std::vector<uint16_t> indices;
+        std::vector<uint32_t> source_vertices;                      // Chunk vertex to source vertex
+    };
+
+    // Largest decode error of a quantized mesh against its source
+    struct QuantizationError
+    {
+        float position = 0.0f;          // Max per-axis distance
+        float normal = 0.0f;            // Max angle in radians
+        float tangent = 0.0f;           // Max angle in radians
+        float texcoord = 0.0f;          // Max per-component distance relative to magnitude
+    };
+
+    // Error bounds of encoders, position bound is relative to bounding box extents
+    inline constexpr float quantized_position_error_bound = 1.0f / 65535.0f;
+    inline constexpr float quantized_direction_error_bound = 1.0e-4f;
+    inline constexpr float quantized_texcoord_error_bound = 1.0f / 2048.0f;
+
+    // Single value encoders and decoders, shaders decode with the same math
+    DirectX::PackedVector::XMUSHORTN4 encode_position(const DirectX::XMFLOAT3& position, const DirectX::BoundingBox& bounding_box, float handedness);
+    DirectX::XMFLOAT3 decode_position(const DirectX::PackedVector::XMUSHORTN4& position, const DirectX::BoundingBox& bounding_box);
+    float decode_handedness(const DirectX::PackedVector::XMUSHORTN4& position);
+    DirectX::PackedVector::XMSHORTN2 encode_octahedral(const DirectX::XMFLOAT3& direction);
+    DirectX::XMFLOAT3 decode_octahedral(const DirectX::PackedVector::XMSHORTN2& direction);
+
+    // Tangents with handedness in w, the side of bitangent relative to cross(normal, tangent)
+    // Quantized streams drop bitangent, shaders rebuild it as cross(normal, tangent) * w
+    std::vector<DirectX::XMFLOAT4> make_handed_tangents(std::span<const DirectX::XMFLOAT3> normals,
+                                                        std::span<const DirectX::XMFLOAT4> tangents,
+                                                        std::span<const DirectX::XMFLOAT4> bitangents);
+
+    // Position decode as scale and offset, decoded = offset + encoded * scale
+    void get_position_dequantization(const DirectX::BoundingBox& bounding_box, DirectX::XMFLOAT3& scale, DirectX::XMFLOAT3& offset);
+
+    // Split mesh into 16-bit indexable chunks and encode every stream
+    std::vector<QuantizedChunk> quantize_vertex_streams(const VertexStreams& streams);
+
+    // Decode chunks and compare with source, used to check encoder error bounds
+    QuantizationError measure_quantization_error(const VertexStreams& streams, std::span<const QuantizedChunk> chunks);
+    bool within_error_bounds(const QuantizationError& error, const DirectX::BoundingBox& bounding_box);
+
+    // Bytes of vertex and index streams, used to report memory and bandwidth reduction
+    size_t full_precision_byte_width(size_t vertex_count, size_t index_count, size_t texcoord_count);
+    size_t quantized_byte_width(std::span<const QuantizedChunk> chunks);
+}
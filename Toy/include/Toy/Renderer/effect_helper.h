@@ -178,6 +178,11 @@ namespace toy
         // Obtain constant buffer and set value
         std::shared_ptr<IEffectConstantBufferVariable> get_constant_buffer_variable(std::string_view name);
 
+        // Set whole constant buffer data by slot, byte width must not exceed constant buffer size
+        void set_constant_buffer_by_slot(uint32_t slot, const void* data, uint32_t byte_width);
+        // Obtain constant buffer slot, return -1 if no found
+        int32_t map_constant_buffer_slot(std::string_view name);
+
         // Set sampler state by slot
         void set_sampler_state_by_slot(uint32_t slot, ID3D11SamplerState* sampler_state);
         // Set sampler state by name
@@ -25,6 +25,7 @@ namespace toy
         std::vector<uint32_t> strides;
         std::vector<uint32_t> offsets;
         uint32_t index_count = 0;
+        DXGI_FORMAT index_format = DXGI_FORMAT_R16_UINT;
     };
 
     class IEffect
@@ -57,6 +58,13 @@ namespace toy
         virtual void set_material(const model::Material& material) = 0;
     };
 
+    // Entity id is per-draw data, so that one model asset can be shared by several entities
+    class IEffectEntity
+    {
+    public:
+        virtual void set_entity_id(uint32_t entity_id) = 0;
+    };
+
     class IEffectMeshData
     {
     public:
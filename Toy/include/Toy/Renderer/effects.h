@@ -269,6 +269,8 @@ namespace toy
         std::unique_ptr<EffectImpl> m_effect_impl;
     };
 
+    struct IrradianceSH;
+
     // PBR pre-processing effect
     class PreProcessEffect
     {
@@ -287,15 +289,17 @@ namespace toy
 
         void compute_sp_env_map(ID3D11Device *device, ID3D11DeviceContext *device_context);
 
-        void compute_irradiance_map(ID3D11Device *device, ID3D11DeviceContext *device_context);
-
         void compute_brdf_lut(ID3D11Device *device, ID3D11DeviceContext *device_context);
 
+        // * Load image based lighting maps of HDR image from IBL cache, computing and caching those missing
+        // * Note: BRDF LUT is loaded or computed only once, maps are baked on CPU into cache when device is null
+        void compute_ibl(ID3D11Device *device, ID3D11DeviceContext *device_context, std::string_view file_path);
+
         // * Get environment map shader resource view
         [[nodiscard]] ID3D11ShaderResourceView* get_environment_srv() const;
 
-        // * Get irradiance map shader resource view
-        [[nodiscard]] ID3D11ShaderResourceView* get_irradiance_srv() const;
+        // * Get SH9 diffuse irradiance projected from environment map
+        [[nodiscard]] const IrradianceSH* get_irradiance_sh() const;
 
         // * Get BRDF shader resource view
         [[nodiscard]] ID3D11ShaderResourceView* get_brdf_srv() const;
@@ -315,7 +319,7 @@ namespace toy
     struct GBufferDefinition;
 
     // Deferred PBR effect
-    class DeferredPBREffect final : public IEffect, public IEffectTransform, public IEffectMaterial, public IEffectMeshData
+    class DeferredPBREffect final : public IEffect, public IEffectTransform, public IEffectMaterial, public IEffectEntity, public IEffectMeshData
     {
     public:
         DeferredPBREffect();
@@ -331,6 +335,10 @@ namespace toy
         // * Note: called by render object automatically
         void set_material(const model::Material& material) override;
 
+        // * Set entity id written to GBuffer for picking
+        // * Note: called by render object automatically
+        void set_entity_id(uint32_t entity_id) override;
+
         // * Get mesh data
         // * Note: called by render object automatically
         MeshDataInput get_input_data(const model::MeshData& mesh_data) override;
@@ -0,0 +1,68 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+#include <Toy/Model/hdr_image.h>
+
+namespace toy
+{
+    // IBL cache
+    // Prefiltered specular environment cube is stored as DDS named by content of HDR image,
+    // BRDF LUT depends on nothing but the integration and is stored once
+    // Diffuse irradiance is not cached, SH9 projected from the environment replaces the irradiance cube
+    inline constexpr uint32_t ibl_cache_version = 1;                // Bump when prefilter shaders or sizes change
+
+    inline constexpr uint32_t ibl_environment_size = 1024;          // Full mip chain, roughness grows with mip
+    inline constexpr uint32_t ibl_brdf_lut_size = 256;
+
+    // Float cube or 2D texture, mip chains of every slice are stored one after another as Direct3D orders subresources
+    struct IblTexture
+    {
+        DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT;     // R16G16B16A16_FLOAT or R16G16_FLOAT
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mip_count = 1;
+        uint32_t array_size = 1;                                 // 6 for cube
+        std::vector<uint8_t> data;
+
+        IblTexture() = default;
+        IblTexture(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t mip_count, uint32_t array_size);
+
+        [[nodiscard]] uint32_t get_texel_byte_width() const;
+        [[nodiscard]] uint32_t get_mip_width(uint32_t mip) const { return std::max(width >> mip, 1u); }
+        [[nodiscard]] uint32_t get_mip_height(uint32_t mip) const { return std::max(height >> mip, 1u); }
+        [[nodiscard]] uint32_t get_row_pitch(uint32_t mip) const { return get_mip_width(mip) * get_texel_byte_width(); }
+        [[nodiscard]] std::span<uint8_t> get_subresource(uint32_t mip, uint32_t slice);
+        [[nodiscard]] std::span<const uint8_t> get_subresource(uint32_t mip, uint32_t slice) const;
+        // Whether texture has the layout GPU passes produce, cache written by older code is rejected
+        [[nodiscard]] bool matches(DXGI_FORMAT format, uint32_t size, uint32_t mip_count, uint32_t array_size) const;
+    };
+
+    // Cache key, combination of HDR image content key and cache version
+    XID ibl_cache_key(XID content_key);
+    std::filesystem::path ibl_environment_cache_path(XID key);
+    std::filesystem::path ibl_brdf_lut_cache_path();
+
+    // Read DDS written by save_ibl_cache, empty if missing or malformed
+    std::optional<IblTexture> load_ibl_cache(const std::filesystem::path& cache_path);
+    bool save_ibl_cache(const std::filesystem::path& cache_path, const IblTexture& texture);
+
+    // CPU reference of the IBL compute shaders, same sample sets and sizes, rows are filtered on worker threads
+    // Used to bake caches where no device is available, such as headless tools
+    // Note: irradiance cube is only baked when irradiance_size is not 0, it serves as reference of SH9
+    struct IblMaps
+    {
+        IblTexture environment;
+        IblTexture irradiance;
+    };
+
+    IblMaps bake_ibl_maps(const model::HdrImage& equirect_image, uint32_t environment_size = ibl_environment_size,
+        uint32_t irradiance_size = 0);
+    IblTexture bake_brdf_lut(uint32_t size = ibl_brdf_lut_size);
+
+    // Bake maps of HDR image and BRDF LUT on CPU into caches missing them, return false if image can not be read
+    bool bake_ibl_cache(std::string_view file_path);
+}
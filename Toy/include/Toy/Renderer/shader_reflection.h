@@ -0,0 +1,71 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+
+namespace toy
+{
+    // Reflection of compiled shader bytecode (DXBC) read from its chunks, without D3DReflect
+    // so that headless tools can list what shaders bind on machines without the D3D compiler
+    enum class ShaderStage : uint32_t
+    {
+        Pixel,
+        Vertex,
+        Geometry,
+        Hull,
+        Domain,
+        Compute,
+        Unknown
+    };
+
+    // Resource bound by shader, type is D3D_SHADER_INPUT_TYPE
+    struct ShaderBinding
+    {
+        std::string name;
+        uint32_t type = 0;
+        uint32_t bind_point = 0;
+        uint32_t bind_count = 1;
+        uint32_t space = 0;                 // Register space of shader model 5.1, 0 before
+    };
+
+    struct ShaderConstantBuffer
+    {
+        std::string name;
+        uint32_t byte_width = 0;
+        uint32_t variable_count = 0;
+    };
+
+    // Element of input or output signature
+    struct ShaderParameter
+    {
+        std::string semantic;
+        uint32_t semantic_index = 0;
+        uint32_t reg = 0;
+        uint32_t system_value = 0;          // D3D_NAME, 0 for user semantic
+        uint32_t component_type = 0;        // D3D_REGISTER_COMPONENT_TYPE
+        uint32_t mask = 0;                  // Components of register, bit 0 is x
+    };
+
+    struct ShaderReflection
+    {
+        ShaderStage stage = ShaderStage::Unknown;
+        uint32_t major_version = 0;
+        uint32_t minor_version = 0;
+        XID content_id = 0;
+        std::vector<ShaderBinding> bindings;
+        std::vector<ShaderConstantBuffer> constant_buffers;
+        std::vector<ShaderParameter> inputs;
+        std::vector<ShaderParameter> outputs;
+    };
+
+    // Empty if bytes are not DXBC or a chunk is malformed, chunks reflection does not know are skipped
+    std::optional<ShaderReflection> reflect_shader(std::span<const uint8_t> bytecode);
+
+    // Profile prefix such as "vs", "cs" for unknown stage is "??"
+    std::string_view get_shader_stage_name(ShaderStage stage);
+    // Name of D3D_SHADER_INPUT_TYPE such as "texture", "cbuffer"
+    std::string_view get_shader_binding_type_name(uint32_t type);
+}
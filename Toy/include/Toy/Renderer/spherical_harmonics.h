@@ -0,0 +1,30 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#pragma once
+
+#include <Toy/Renderer/ibl_cache.h>
+
+namespace toy
+{
+    // Diffuse irradiance as 9 RGB spherical harmonic coefficients of bands 0 to 2, 108 bytes in place of an irradiance cube
+    // Coefficients are convolved with the clamped cosine lobe, divided by pi and have basis constants folded in,
+    // so evaluation is a polynomial of the normal and matches the irradiance cube baked by bake_ibl_maps
+    struct IrradianceSH
+    {
+        std::array<DirectX::XMFLOAT3, 9> coefficients{};
+    };
+
+    // Project mip 0 of RGBA16F environment cube, every texel weighted by its solid angle
+    // Note: 4 texels are projected at once with vector math, rows are summed on worker threads
+    IrradianceSH project_irradiance_sh(const IblTexture& environment_cube);
+    // Project equirectangular image, every texel weighted by its solid angle
+    IrradianceSH project_irradiance_sh(const model::HdrImage& equirect_image);
+
+    // Irradiance over pi in direction of unit normal, never negative, same as evaluate_irradiance_sh of deferred_pbr.hlsl
+    DirectX::XMVECTOR evaluate_irradiance_sh(const IrradianceSH& irradiance_sh, DirectX::FXMVECTOR normal);
+
+    // Coefficients padded to float4, as constant buffer arrays are laid out
+    std::array<DirectX::XMFLOAT4, 9> get_constant_data(const IrradianceSH& irradiance_sh);
+}
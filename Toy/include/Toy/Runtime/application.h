@@ -32,6 +32,10 @@ namespace toy::runtime
 
         void quit();
 
+        // Stream world of description around the first camera, see world_streamer.h
+        // Only one world per session, return false if description can not be read or a world is open already
+        bool open_world(const std::filesystem::path &file_path);
+
     private:
         void process_events();
 
@@ -0,0 +1,102 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/coroutine.h>
+#include <Toy/ECS/entity_wrapper.h>
+#include <Toy/ECS/transform.h>
+#include <Toy/Model/mesh_data.h>
+
+namespace toy::runtime
+{
+    struct SceneGraph;
+    struct TaskSystem;
+
+    inline constexpr size_t default_model_loader_thread_count = 2;
+    inline constexpr std::string_view model_placeholder_name = "LoadingPlaceholder";
+
+    enum class ModelLoadStage : uint32_t
+    {
+        Importing,      // Parse, process and encode model into its processed mesh cache, on a worker
+        Textures,       // Decode and compress textures of model into texture cache, on a worker
+        Uploading,      // Create model from warm caches, on main thread
+        Finished,
+        Cancelled,
+        Failed
+    };
+
+    // Progress of one load, shared by its coroutine and whoever shows or cancels it
+    class ModelLoad
+    {
+    public:
+        ModelLoad(std::string_view file_name, const EntityWrapper& entity) : m_file_name(file_name), m_entity(entity) {}
+
+        [[nodiscard]] const std::string& get_file_name() const { return m_file_name; }
+        [[nodiscard]] const EntityWrapper& get_entity() const { return m_entity; }
+        [[nodiscard]] ModelLoadStage get_stage() const { return m_stage.load(); }
+        // From 0 to 1, stages of worker advance it coarsely, since an import can not report inside itself
+        [[nodiscard]] float get_progress() const { return m_progress.load(); }
+        [[nodiscard]] bool is_finished() const { return m_stage.load() >= ModelLoadStage::Finished; }
+
+        // Load stops at its next stage and its entity is destroyed, an import already running is waited for
+        void cancel() { m_is_cancelled = true; }
+        [[nodiscard]] bool is_cancelled() const { return m_is_cancelled.load(); }
+
+    private:
+        friend class AsyncModelLoader;
+
+        std::string m_file_name;
+        EntityWrapper m_entity;
+        std::atomic<ModelLoadStage> m_stage = ModelLoadStage::Importing;
+        std::atomic<float> m_progress = 0.0f;
+        std::atomic<bool> m_is_cancelled = false;
+    };
+
+    // Loads models dropped into scene without stalling frames
+    // The entity is created at once with a placeholder mesh, a coroutine bakes mesh and texture caches of model on worker
+    // threads, then returns to main thread through a completion event of task system, creates model from the warm caches
+    // and swaps it into the entity
+    // Note: glTF is loaded natively from its buffers on main thread, workers only read its file ahead
+    class AsyncModelLoader
+    {
+    public:
+        AsyncModelLoader(SceneGraph& scene_graph, TaskSystem& task_system, size_t num_threads = default_model_loader_thread_count);
+        // Cancel every load and wait for workers, loads waiting for main thread are dropped with their placeholder left as is
+        ~AsyncModelLoader();
+
+        AsyncModelLoader(const AsyncModelLoader&) = delete;
+        AsyncModelLoader& operator=(const AsyncModelLoader&) = delete;
+
+        std::shared_ptr<ModelLoad> load(std::string_view file_name, const Transform& transform = {});
+        void cancel_all();
+
+        // Release finished loads, called once per frame on main thread
+        void update();
+
+        // Loads not released yet, in start order
+        [[nodiscard]] std::vector<std::shared_ptr<ModelLoad>> get_loads() const;
+
+    private:
+        struct LoadTask
+        {
+            std::shared_ptr<ModelLoad> load;
+            AsyncTask task;
+        };
+
+        AsyncTask run_load(std::shared_ptr<ModelLoad> load);
+        // Create model from warm caches and swap it into entity, on main thread
+        void finish_load(ModelLoad& load);
+        void remove_entity(ModelLoad& load);
+
+        SceneGraph& m_scene_graph;
+        TaskSystem& m_task_system;
+        model::VertexEncoding m_vertex_encoding;
+        model::MeshStreamStorage m_stream_storage;
+        std::vector<LoadTask> m_loads;
+
+        // Declared last, so that workers finish before loads are destroyed
+        TaskPool m_pool;
+    };
+}
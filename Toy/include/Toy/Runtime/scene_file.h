@@ -0,0 +1,34 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/ECS/components.h>
+#include <Toy/Runtime/scene_image.h>
+
+namespace toy::runtime
+{
+    // Components of scene file tables, layout of the image itself is in scene_image.h
+    // Note: material changes made at runtime are not saved, models are reloaded as imported
+    struct SceneFileCamera
+    {
+        uint32_t camera_type = 0;               // CameraType
+        Transform transform;
+        float fov_y = 0.0f;
+        float aspect = 0.0f;
+        float near_z = 0.0f;
+        float far_z = 0.0f;
+        D3D11_VIEWPORT viewport = {};
+        DirectX::XMFLOAT3 target = {};          // Third person camera only
+        float distance = 0.0f;
+        float min_distance = 0.0f;
+        float max_distance = 0.0f;
+    };
+
+    // Components stored as they are in memory
+    static_assert(std::is_trivially_copyable_v<TransformComponent> && std::is_trivially_copyable_v<DirectionalLightComponent>);
+
+    // Check image, see validate_scene_image, that component byte widths match these types and that camera types are known
+    bool validate_scene_file(std::span<const uint8_t> image);
+}
@@ -29,11 +29,31 @@ namespace toy::runtime
         EntityWrapper create_entity(std::string_view entity_name);
         void destroy_entity(EntityWrapper &entity_wrapper);
 
+        // Entity of this scene that has not been destroyed, clear and load_scene destroy every entity
+        [[nodiscard]] bool contains(const EntityWrapper &entity_wrapper) const;
+
+        // First entity of given name, invalid if there is none
+        EntityWrapper find_entity(std::string_view entity_name);
+
+        // Destroy every entity
+        void clear();
+        // Incremented by clear and load_scene, so that owners of entities notice that their entities are gone
+        [[nodiscard]] uint64_t get_generation() const { return generation; }
+
+        // Write every entity but transient ones to binary scene file, see scene_file.h
+        bool save_scene(const std::filesystem::path &file_path);
+
+        // Replace every entity by those of binary scene file, scene is left as is if file is invalid
+        bool load_scene(const std::filesystem::path &file_path);
+
         template <typename ... Components>
         void for_each(std::function<void(Components& ...)> &&func);
 
         void frustum_culling(const DirectX::BoundingFrustum &frustum_in_world);
 
+        // Request texture detail of static meshes in frustum, called after frustum culling
+        void request_textures(const Camera &camera);
+
         void render_skybox(ID3D11DeviceContext *device_context, IEffect &effect);
 
         void render_static_mesh_shadow(ID3D11DeviceContext *device_context, IEffect &effect);
@@ -56,6 +76,7 @@ namespace toy::runtime
         std::vector<entt::entity> entities_in_frustum;
         entt::entity skybox_entity = entt::null;
         DirectX::BoundingBox scene_bounding_box = {};
+        uint64_t generation = 0;
     };
 
     template <typename ... Components>
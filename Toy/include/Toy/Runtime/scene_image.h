@@ -0,0 +1,125 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#pragma once
+
+#include <Toy/Core/hash.h>
+
+namespace toy::runtime
+{
+    // Binary scene file
+    // Versioned image of the entity registry, every component type is a table of entity indices and a packed array of
+    // components in file layout, so that load creates every entity in one call and constructs each component type in bulk
+    // straight from the mapped file
+    // Models are referenced by stable asset ID, the asset table keeps the source file of each model, so that a model the
+    // session does not know is loaded from it; references are resolved after entities are created, once per distinct model
+    // Image layout is independent of the registry and of Direct3D, component types are only known by byte width here,
+    // see scene_file.h for the component types of each table
+    inline constexpr uint32_t scene_file_magic = 0x4E435354;            // "TSCN"
+    inline constexpr uint32_t scene_file_version = 2;                   // Bump when layout of header or a component changes
+    inline constexpr uint32_t scene_file_alignment = 16;
+    inline constexpr std::string_view scene_file_extension = ".tscene";
+
+    // Location of data inside scene image, offset is relative to the beginning of image
+    struct SceneFileBlob
+    {
+        uint64_t offset = 0;
+        uint64_t byte_width = 0;
+    };
+
+    // Components of one type, entity indices and components in the same order
+    struct SceneFileTable
+    {
+        uint32_t count = 0;
+        uint32_t component_byte_width = 0;      // Checked against component type on load
+        SceneFileBlob entities;                 // uint32_t
+        SceneFileBlob components;
+    };
+
+    struct SceneFileHeader
+    {
+        uint32_t magic = scene_file_magic;
+        uint32_t version = scene_file_version;
+        uint64_t byte_width = 0;
+        uint32_t entity_count = 0;
+        uint32_t asset_count = 0;
+        SceneFileBlob assets;                   // SceneFileAsset
+        SceneFileBlob asset_names;              // Source files of assets
+        SceneFileBlob tag_offsets;              // uint32_t per entity and one past the last, into tags
+        SceneFileBlob tags;
+        SceneFileTable transforms;              // TransformComponent
+        SceneFileTable static_meshes;           // SceneFileStaticMesh
+        SceneFileTable directional_lights;      // DirectionalLightComponent
+        SceneFileTable cameras;                 // SceneFileCamera
+    };
+
+    struct SceneFileAsset
+    {
+        XID id = 0;                             // Model ID, see ModelManager::acquire
+        uint32_t name_offset = 0;               // Source file in asset names, empty for models created from geometry
+        uint32_t name_length = 0;
+    };
+
+    struct SceneFileStaticMesh
+    {
+        uint32_t asset_index = 0;
+        uint32_t is_skybox = 0;
+        uint32_t is_camera = 0;
+        uint32_t padding = 0;
+    };
+
+    // Build scene image, entities are numbered in the order they are added
+    class SceneImageWriter
+    {
+    public:
+        SceneImageWriter();
+
+        uint32_t add_entity(std::string_view tag);
+        // Asset is written once, later calls with its ID return its first index
+        uint32_t add_asset(XID id, std::string_view file_name);
+
+        // Append table of trivially copyable components, assign it to its header table
+        template<typename T>
+        SceneFileTable append_table(std::span<const uint32_t> entities, std::span<const T> components)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Scene file components are stored as they are in memory");
+            return append_table(entities, components.data(), components.size(), sizeof(T));
+        }
+        SceneFileTable append_table(std::span<const uint32_t> entities, const void* components, size_t count, uint32_t component_byte_width);
+
+        SceneFileHeader& header() { return m_header; }
+
+        // Append assets and tags and patch header, header keeps the final counts but nothing is added after
+        std::vector<uint8_t> finish();
+
+    private:
+        // Append data aligned to scene_file_alignment
+        SceneFileBlob append(const void* data, size_t byte_width);
+
+        SceneFileHeader m_header;
+        std::vector<uint8_t> m_image;
+        std::vector<SceneFileAsset> m_assets;
+        std::string m_asset_names;
+        std::unordered_map<XID, uint32_t> m_asset_indices;
+        std::vector<uint32_t> m_tag_offsets;
+        std::string m_tags;
+    };
+
+    // Check header, version, that every table and blob lies inside the image, that entity indices are in range and unique
+    // per table and that static meshes refer to assets of the image
+    // Note: component byte widths are left to caller, which knows the component types, see validate_scene_file
+    bool validate_scene_image(std::span<const uint8_t> image);
+
+    // Typed view of blob of a validated scene image
+    template<typename T>
+    std::span<const T> get_scene_array(std::span<const uint8_t> image, const SceneFileBlob& blob)
+    {
+        return { reinterpret_cast<const T *>(image.data() + blob.offset), static_cast<size_t>(blob.byte_width / sizeof(T)) };
+    }
+
+    std::string_view get_scene_string(std::span<const uint8_t> image, const SceneFileBlob& blob);
+
+    // Write image to a temporary file first, so that a failed save keeps the previous scene file
+    bool save_scene_image(const std::filesystem::path& file_path, std::span<const uint8_t> image);
+}
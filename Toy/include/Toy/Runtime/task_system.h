@@ -10,6 +10,8 @@
 
 namespace toy::runtime
 {
+    // Queue of events handled on main thread by Renderer::process_pending_events
+    // Note: events may be pushed from any thread, such as completion of a load running on workers
     struct TaskSystem
     {
     public:
@@ -31,13 +33,41 @@ namespace toy::runtime
         [[nodiscard]] bool empty() const;
 
     private:
+        mutable std::mutex m_mutex;
         std::deque<EngineEventVariant> m_pending_events;
     };
 
+    // co_await resume_on_main_thread(task_system, owner) continues coroutine on main thread through a completion event
+    // Coroutine is not resumed once owner has expired, so that whoever owns it can destroy it while the event is queued
+    struct ResumeOnMainThread
+    {
+        TaskSystem& task_system;
+        std::weak_ptr<void> owner;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            task_system.push(CompletionEvent{ [handle, owner = std::move(owner)]()
+            {
+                if (!owner.expired())
+                {
+                    handle.resume();
+                }
+            } });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    inline ResumeOnMainThread resume_on_main_thread(TaskSystem& task_system, std::weak_ptr<void> owner)
+    {
+        return { task_system, std::move(owner) };
+    }
+
 
     template <std::input_iterator InputIt>
     void TaskSystem::assign(InputIt first, InputIt last)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_pending_events.assign(first, last);
     }
 
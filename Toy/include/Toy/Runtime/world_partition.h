@@ -0,0 +1,139 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Core/base.h>
+
+namespace toy::runtime
+{
+    // World partition
+    // Items of a large world are placed into square cells of the XZ plane, cells near the view are loaded on I/O threads,
+    // nearest and in front of view first, and activated on the updating thread within a per-update budget,
+    // so that update never waits for I/O
+    // Cells are loaded inside load radius and kept until beyond unload radius, so that a view moving along a cell border does not
+    // load and unload the same cells over and over
+    inline constexpr float default_world_cell_size = 64.0f;
+
+    struct WorldStreamingSettings
+    {
+        float cell_size = default_world_cell_size;
+        float load_radius = 192.0f;                 // Distance to cell bounds below which cell is loaded
+        float unload_radius = 256.0f;               // Distance to cell bounds beyond which cell is unloaded, at least load radius
+        float behind_priority_scale = 2.0f;         // Cells behind view are loaded as if this much farther
+        uint32_t io_thread_count = 2;               // 0 loads cells on updating thread, which stalls update, kept as baseline
+        uint32_t max_activations_per_update = 4;
+        float activation_budget_ms = 2.0f;          // No further activation once update has taken this long, at least one per update
+    };
+
+    enum class WorldCellState : uint8_t
+    {
+        Unloaded,
+        Queued,             // Waiting for an I/O thread
+        Loading,
+        Loaded,             // Waiting for activation
+        Active
+    };
+
+    struct WorldCellCoord
+    {
+        int32_t x = 0;
+        int32_t z = 0;
+
+        bool operator==(const WorldCellCoord& other) const { return x == other.x && z == other.z; }
+    };
+
+    struct WorldCell
+    {
+        uint32_t index = 0;
+        WorldCellCoord coord;
+        std::vector<uint32_t> items;                // Indices of items placed in cell, meaning is left to cell loader
+        std::atomic<WorldCellState> state = WorldCellState::Unloaded;     // I/O threads mark cells they start loading
+        size_t resident_bytes = 0;                  // Reported by cell loader, while loaded or active
+    };
+
+    // Owner of cell contents
+    // Note: load_cell runs on I/O threads, and may run for one cell while another is activated or unloaded
+    class IWorldCellLoader
+    {
+    public:
+        virtual ~IWorldCellLoader() = default;
+
+        // Read and prepare assets of cell, return bytes held for cell
+        virtual size_t load_cell(const WorldCell& cell) = 0;
+        // Make prepared cell part of the world, on updating thread
+        virtual void activate_cell(const WorldCell& cell) = 0;
+        // Remove cell from the world if active and release what load prepared, on updating thread
+        virtual void unload_cell(const WorldCell& cell) = 0;
+    };
+
+    struct WorldStreamingStatistics
+    {
+        size_t cell_count = 0;
+        size_t active_cell_count = 0;
+        size_t pending_cell_count = 0;              // Queued, loading or waiting for activation
+        size_t resident_bytes = 0;
+        size_t peak_resident_bytes = 0;
+        size_t load_count = 0;
+        size_t unload_count = 0;
+        size_t cancel_count = 0;                    // Queued loads dropped since view moved away
+        float last_update_ms = 0.0f;
+        float max_update_ms = 0.0f;
+    };
+
+    class WorldPartition
+    {
+    public:
+        // Loader must outlive partition
+        WorldPartition(IWorldCellLoader& loader, const WorldStreamingSettings& settings = {});
+        // Wait for loads in flight, cells are not unloaded
+        ~WorldPartition();
+
+        WorldPartition(const WorldPartition&) = delete;
+        WorldPartition& operator=(const WorldPartition&) = delete;
+
+        [[nodiscard]] WorldCellCoord get_cell_coord(const DirectX::XMFLOAT3& position) const;
+
+        // Place item at position, return index of its cell
+        // Note: items are placed before the first update, I/O threads read items of cells without locking
+        uint32_t add_item(const DirectX::XMFLOAT3& position, uint32_t item);
+
+        // Stream cells around view, view direction is only used for load priority
+        void update(const DirectX::XMFLOAT3& view_position, const DirectX::XMFLOAT3& view_direction);
+        // Unload every loaded and active cell, waiting for loads in flight
+        void unload_all();
+
+        [[nodiscard]] const WorldCell& get_cell(uint32_t cell_index) const { return *m_cells[cell_index]; }
+        [[nodiscard]] size_t get_cell_count() const { return m_cells.size(); }
+        [[nodiscard]] const WorldStreamingSettings& get_settings() const { return m_settings; }
+        [[nodiscard]] const WorldStreamingStatistics& get_statistics() const { return m_statistics; }
+
+    private:
+        // Distance from view to cell bounds in XZ plane
+        [[nodiscard]] float get_cell_distance(const WorldCell& cell, const DirectX::XMFLOAT3& view_position) const;
+        size_t load_cell(const WorldCell& cell);
+        void run_io_thread();
+        // Called with mutex held
+        void finish_load(WorldCell& cell, size_t resident_bytes);
+        void set_state(WorldCell& cell, WorldCellState state);
+
+        IWorldCellLoader& m_loader;
+        WorldStreamingSettings m_settings;
+        // Cells are never removed, so that I/O threads keep references while cells are added
+        std::vector<std::unique_ptr<WorldCell>> m_cells;
+        std::unordered_map<uint64_t, uint32_t> m_cell_lookup;
+        std::unordered_set<uint32_t> m_streaming_cells;            // Cells not unloaded
+
+        std::mutex m_mutex;                                         // Guards cell states, queue and completed loads
+        std::condition_variable m_queue_not_empty;
+        std::condition_variable m_load_finished;
+        std::vector<std::pair<float, uint32_t>> m_load_queue;       // Priority and cell, nearest last
+        std::vector<std::pair<uint32_t, size_t>> m_completed_loads;
+        size_t m_loads_in_flight = 0;
+        bool m_stopping = false;
+        std::vector<std::thread> m_io_threads;
+
+        WorldStreamingStatistics m_statistics;
+    };
+}
@@ -0,0 +1,81 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#pragma once
+
+#include <Toy/Runtime/world_partition.h>
+#include <Toy/ECS/entity_wrapper.h>
+#include <Toy/ECS/transform.h>
+#include <Toy/Model/mesh_data.h>
+
+namespace toy
+{
+    class Camera;
+}
+namespace toy::runtime
+{
+    struct SceneGraph;
+
+    // Static mesh entity of a streamed world, created while its cell is active
+    struct WorldEntityDesc
+    {
+        std::string name;
+        std::string model_file;
+        Transform transform;
+    };
+
+    // World description, JSON placing a ground tile on every square of a grid and scattering props over each tile with a fixed seed
+    // {
+    //   "size": [x, z], "tile_size": 64, "seed": 1,
+    //   "tiles": [ { "model": "data/models/ground_19.obj", "scale": [3.2, 1, 3.2] } ],        picked at random per tile
+    //   "props": [ { "name": "Tree", "model": "data/models/tree.obj", "scale": 0.008, "per_tile": 2.5 } ]
+    // }
+    // Grid is centered on origin, model files are relative to project root, props get a random yaw
+    // per_tile is the mean count of a prop on a tile, count is its integer part plus one more with probability of its fraction
+
+    // Streams static mesh entities of a large world into scene graph by world partition
+    // Loading a cell bakes and reads mesh and texture caches of its models on I/O threads, so that activation creates
+    // device resources from warm caches, activation and unloading create and destroy entities
+    // Entities of the world are not part of the scene, scene clear or load makes every cell stream in again around the camera
+    // Note: models of unloaded cells stay resident until model manager evicts them under its memory budget
+    class WorldStreamer : public IWorldCellLoader
+    {
+    public:
+        explicit WorldStreamer(SceneGraph& scene_graph, const WorldStreamingSettings& settings = {});
+        ~WorldStreamer() override;
+
+        WorldStreamer(const WorldStreamer&) = delete;
+        WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+        // Entities are added before the first update
+        void add_entity(WorldEntityDesc&& entity_desc);
+        // Add every entity of world description, return false if it can not be read or entities have been added already
+        bool load_world(const std::filesystem::path& file_path);
+
+        void update(const Camera& camera);
+
+        [[nodiscard]] const WorldPartition& get_partition() const { return m_partition; }
+
+        size_t load_cell(const WorldCell& cell) override;
+        void activate_cell(const WorldCell& cell) override;
+        void unload_cell(const WorldCell& cell) override;
+
+    private:
+        // Every cell is unloaded and streamed in again, as scene graph has destroyed their entities
+        void reset_cells();
+
+        SceneGraph& m_scene_graph;
+        uint64_t m_scene_generation;
+        model::VertexEncoding m_vertex_encoding;
+        model::MeshStreamStorage m_stream_storage;
+        std::vector<WorldEntityDesc> m_entities;
+        std::unordered_map<uint32_t, std::vector<EntityWrapper>> m_cell_entities;     // Entities of active cells
+
+        std::mutex m_mutex;                                                                 // Guards cache files of models
+        std::unordered_map<std::string, std::vector<std::filesystem::path>> m_model_caches;    // Mesh and texture caches, empty while being baked
+
+        // Declared last, so that I/O threads stop before the rest is destroyed
+        WorldPartition m_partition;
+    };
+}
@@ -7,17 +7,25 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <fstream>
 #include <filesystem>
 #include <array>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
 #include <map>
+#include <list>
 #include <memory>
+#include <functional>
+#include <atomic>
+#include <utility>
 #include <algorithm>
+#include <numeric>
 #include <variant>
+#include <optional>
 #include <chrono>
 #include <thread>
 #include <mutex>
@@ -26,22 +34,37 @@
 #include <stdexcept>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
+#include <cctype>
 #include <span>
 #include <concepts>
+#include <bit>
+#include <random>
+#include <shared_mutex>
+#include <coroutine>
+#include <future>
 
+// Headless build, such as the asset library shared with tools and tests, has neither window nor device
+// Note: only formats and math are available then, DirectXMath and dxgiformat.h come from their packages off Windows
+#if !defined(DXTOY_HEADLESS)
 #include <Windows.h>
 #include <wrl/client.h>
 #include <d3d11_1.h>
 #include <d3dcompiler.h>
+#else
+#include <dxgiformat.h>
+#endif
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 #include <DirectXPackedVector.h>
 #include <DirectXColors.h>
 
+#if !defined(DXTOY_HEADLESS)
 // glfw
 #include <GLFW/glfw3.h>
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
 
 // spdlog
 #include <spdlog/spdlog.h>
@@ -49,9 +72,11 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
+#if !defined(DXTOY_HEADLESS)
 // DirectXTex
 #include <DDSTextureLoader/DDSTextureLoader11.h>
 #include <WICTextureLoader/WICTextureLoader11.h>
+#endif
 
 
 
@@ -0,0 +1,344 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Core/asset_pack.h>
+#include <Toy/Core/lz_compression.h>
+#include <Toy/Core/parallel.h>
+
+namespace toy
+{
+    static constexpr uint32_t s_asset_pack_magic = 0x4B415054;
+
+    // Files compressed at once per worker while writing, bounds memory held by compressed data
+    static constexpr size_t s_files_per_worker = 4;
+
+    static uint64_t align_offset(uint64_t offset)
+    {
+        return (offset + asset_pack_alignment - 1) / asset_pack_alignment * asset_pack_alignment;
+    }
+
+    static void write_padding(std::ofstream& file_stream, uint64_t& offset)
+    {
+        static constexpr std::array<char, asset_pack_alignment> s_zeros{};
+        uint64_t aligned_offset = align_offset(offset);
+        file_stream.write(s_zeros.data(), static_cast<std::streamsize>(aligned_offset - offset));
+        offset = aligned_offset;
+    }
+
+    XID asset_pack_path_id(std::string_view relative_path)
+    {
+        std::string normalized_path = std::filesystem::path(relative_path).lexically_normal().generic_string();
+        std::transform(normalized_path.begin(), normalized_path.end(), normalized_path.begin(),
+                       [](char c) { return static_cast<char>(std::tolower(static_cast<uint8_t>(c))); });
+        return hash::fnv1a_64(normalized_path);
+    }
+
+    AssetPack::AssetPack(const std::filesystem::path& pack_path)
+    {
+        open(pack_path);
+    }
+
+    bool AssetPack::open(const std::filesystem::path& pack_path)
+    {
+        close();
+        if (!m_file.open(pack_path))
+        {
+            return false;
+        }
+
+        auto reject = [this, &pack_path](std::string_view reason)
+        {
+            DX_CORE_WARN("Asset pack {} is rejected, {}", pack_path.string(), reason);
+            close();
+            return false;
+        };
+
+        AssetPackHeader header{};
+        if (m_file.size() < sizeof(header))
+        {
+            return reject("file is truncated");
+        }
+        std::memcpy(&header, m_file.data(), sizeof(header));
+        if (header.magic != s_asset_pack_magic || header.version != asset_pack_version)
+        {
+            return reject("format or version does not match");
+        }
+
+        // Index is used in place, so it has to lie within the view and be aligned
+        uint64_t file_size = m_file.size();
+        if (header.index_offset % alignof(AssetPackEntry) != 0 || header.index_offset > file_size ||
+            header.entry_count > (file_size - header.index_offset) / sizeof(AssetPackEntry) ||
+            header.names_offset > file_size || header.names_size > file_size - header.names_offset)
+        {
+            return reject("index is out of range");
+        }
+        m_entries = { reinterpret_cast<const AssetPackEntry*>(m_file.data() + header.index_offset), static_cast<size_t>(header.entry_count) };
+        m_names = { reinterpret_cast<const char*>(m_file.data() + header.names_offset), static_cast<size_t>(header.names_size) };
+
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+            auto&& entry = m_entries[i];
+            bool is_valid = entry.offset <= file_size && entry.stored_size <= file_size - entry.offset &&
+                            static_cast<uint64_t>(entry.name_offset) + entry.name_size <= m_names.size() &&
+                            (entry.compression == AssetCompression::LZ ||
+                             (entry.compression == AssetCompression::None && entry.stored_size == entry.size));
+            if (!is_valid)
+            {
+                return reject("entry is out of range");
+            }
+            if (i > 0 && m_entries[i - 1].path_id >= entry.path_id)
+            {
+                return reject("index is not sorted");
+            }
+        }
+        return true;
+    }
+
+    void AssetPack::close()
+    {
+        m_file.close();
+        m_entries = {};
+        m_names = {};
+    }
+
+    const AssetPackEntry* AssetPack::find(XID path_id) const
+    {
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), path_id,
+                                   [](const AssetPackEntry& entry, XID id) { return entry.path_id < id; });
+        if (it == m_entries.end() || it->path_id != path_id)
+        {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    std::string_view AssetPack::get_name(const AssetPackEntry& entry) const
+    {
+        return m_names.substr(entry.name_offset, entry.name_size);
+    }
+
+    std::span<const uint8_t> AssetPack::get_stored_bytes(const AssetPackEntry& entry) const
+    {
+        return m_file.bytes().subspan(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.stored_size));
+    }
+
+    bool AssetPack::read(const AssetPackEntry& entry, std::span<uint8_t> output) const
+    {
+        if (output.size() != entry.size)
+        {
+            return false;
+        }
+
+        auto stored_bytes = get_stored_bytes(entry);
+        if (entry.compression == AssetCompression::LZ)
+        {
+            if (!lz_decompress(stored_bytes, output) || content_to_id(output.data(), output.size()) != entry.checksum)
+            {
+                DX_CORE_ERROR("Asset pack entry '{}' is corrupt", get_name(entry));
+                return false;
+            }
+            return true;
+        }
+
+        std::memcpy(output.data(), stored_bytes.data(), stored_bytes.size());
+#if defined(_DEBUG)
+        if (content_to_id(output.data(), output.size()) != entry.checksum)
+        {
+            DX_CORE_ERROR("Asset pack entry '{}' is corrupt", get_name(entry));
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    bool AssetPack::verify(const AssetPackEntry& entry) const
+    {
+        auto stored_bytes = get_stored_bytes(entry);
+        if (entry.compression == AssetCompression::None)
+        {
+            return content_to_id(stored_bytes.data(), stored_bytes.size()) == entry.checksum;
+        }
+
+        std::vector<uint8_t> content(static_cast<size_t>(entry.size));
+        return lz_decompress(stored_bytes, content) && content_to_id(content.data(), content.size()) == entry.checksum;
+    }
+
+    std::vector<AssetPackSource> collect_asset_pack_sources(const std::filesystem::path& root_dir, std::span<const std::string> directories,
+                                                            std::span<const std::string> excluded_directories)
+    {
+        auto is_excluded = [excluded_directories](const std::string& name)
+        {
+            return std::any_of(excluded_directories.begin(), excluded_directories.end(), [&name](const std::string& directory)
+            {
+                std::string prefix = std::filesystem::path(directory).lexically_normal().generic_string();
+                if (!prefix.ends_with('/'))
+                {
+                    prefix.push_back('/');
+                }
+                return name.starts_with(prefix);
+            });
+        };
+
+        std::vector<AssetPackSource> sources{};
+        for (auto&& directory : directories)
+        {
+            std::error_code error_code{};
+            auto iterator = std::filesystem::recursive_directory_iterator(root_dir / directory,
+                                                                          std::filesystem::directory_options::skip_permission_denied, error_code);
+            if (error_code)
+            {
+                DX_CORE_WARN("Fail to list asset directory {}", (root_dir / directory).string());
+                continue;
+            }
+
+            for (auto&& dir_entry : iterator)
+            {
+                if (!dir_entry.is_regular_file(error_code))
+                {
+                    continue;
+                }
+                std::string name = dir_entry.path().lexically_relative(root_dir).generic_string();
+                if (!is_excluded(name))
+                {
+                    sources.push_back(AssetPackSource{ std::move(name), dir_entry.path() });
+                }
+            }
+        }
+
+        std::sort(sources.begin(), sources.end(), [](const AssetPackSource& a, const AssetPackSource& b) { return a.name < b.name; });
+        sources.erase(std::unique(sources.begin(), sources.end(), [](const AssetPackSource& a, const AssetPackSource& b) { return a.name == b.name; }),
+                      sources.end());
+        return sources;
+    }
+
+    bool write_asset_pack(const std::filesystem::path& pack_path, std::span<const AssetPackSource> sources, const AssetPackOptions& options)
+    {
+        // Names and IDs first, a collision fails before any data is written
+        std::vector<AssetPackEntry> entries(sources.size());
+        std::string names{};
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            std::string name = std::filesystem::path(sources[i].name).lexically_normal().generic_string();
+            entries[i].path_id = asset_pack_path_id(name);
+            entries[i].name_offset = static_cast<uint32_t>(names.size());
+            entries[i].name_size = static_cast<uint32_t>(name.size());
+            names += name;
+        }
+
+        std::vector<size_t> order(entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b) { return entries[a].path_id < entries[b].path_id; });
+        for (size_t i = 1; i < order.size(); ++i)
+        {
+            if (entries[order[i - 1]].path_id == entries[order[i]].path_id)
+            {
+                DX_CORE_ERROR("Asset pack sources '{}' and '{}' share ID", sources[order[i - 1]].name, sources[order[i]].name);
+                return false;
+            }
+        }
+
+        std::error_code error_code{};
+        std::filesystem::create_directories(pack_path.parent_path(), error_code);
+        std::filesystem::path temp_path = pack_path;
+        temp_path += ".tmp";
+        std::ofstream file_stream(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file_stream.is_open())
+        {
+            DX_CORE_ERROR("Fail to create asset pack {}", pack_path.string());
+            return false;
+        }
+        auto abort = [&file_stream, &temp_path]()
+        {
+            file_stream.close();
+            std::error_code remove_error{};
+            std::filesystem::remove(temp_path, remove_error);
+            return false;
+        };
+
+        // Header is written again once index is placed
+        AssetPackHeader header{};
+        file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t offset = sizeof(header);
+        write_padding(file_stream, offset);
+
+        // Files are compressed in batches on worker threads, then written in source order
+        struct PackedFile
+        {
+            MappedFile file;
+            std::vector<uint8_t> compressed;
+            bool is_read = false;
+        };
+        size_t batch_size = get_worker_count() * s_files_per_worker;
+        for (size_t batch_begin = 0; batch_begin < sources.size(); batch_begin += batch_size)
+        {
+            size_t batch_count = std::min(batch_size, sources.size() - batch_begin);
+            std::vector<PackedFile> packed_files(batch_count);
+            parallel_for(batch_count, [&](size_t i)
+            {
+                auto&& packed_file = packed_files[i];
+                auto&& entry = entries[batch_begin + i];
+                if (!packed_file.file.open(sources[batch_begin + i].file_path))
+                {
+                    return;
+                }
+
+                auto bytes = packed_file.file.bytes();
+                entry.size = bytes.size();
+                entry.checksum = content_to_id(bytes.data(), bytes.size());
+                if (options.compress && !bytes.empty())
+                {
+                    lz_compress(bytes, packed_file.compressed);
+                    if (static_cast<float>(packed_file.compressed.size()) <= static_cast<float>(bytes.size()) * options.max_compression_ratio)
+                    {
+                        entry.compression = AssetCompression::LZ;
+                    } else
+                    {
+                        packed_file.compressed = {};
+                    }
+                }
+                packed_file.is_read = true;
+            });
+
+            for (size_t i = 0; i < batch_count; ++i)
+            {
+                auto&& packed_file = packed_files[i];
+                auto&& entry = entries[batch_begin + i];
+                if (!packed_file.is_read)
+                {
+                    DX_CORE_ERROR("Fail to read asset {} into pack", sources[batch_begin + i].file_path.string());
+                    return abort();
+                }
+
+                auto bytes = entry.compression == AssetCompression::LZ ? std::span<const uint8_t>(packed_file.compressed) : packed_file.file.bytes();
+                entry.offset = offset;
+                entry.stored_size = bytes.size();
+                file_stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                offset += bytes.size();
+                write_padding(file_stream, offset);
+            }
+        }
+
+        // Index sorted by ID for binary search, followed by names
+        std::sort(entries.begin(), entries.end(), [](const AssetPackEntry& a, const AssetPackEntry& b) { return a.path_id < b.path_id; });
+        header.entry_count = entries.size();
+        header.index_offset = offset;
+        file_stream.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+        offset += entries.size() * sizeof(AssetPackEntry);
+        header.names_offset = offset;
+        header.names_size = names.size();
+        file_stream.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        file_stream.seekp(0);
+        file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!file_stream.good())
+        {
+            DX_CORE_ERROR("Fail to write asset pack {}", pack_path.string());
+            return abort();
+        }
+        file_stream.close();
+
+        std::filesystem::rename(temp_path, pack_path, error_code);
+        return !error_code;
+    }
+}
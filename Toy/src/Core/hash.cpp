@@ -0,0 +1,147 @@
+//
+// Created by ZZK on 2024/4/2.
+//
+
+#include <Toy/Core/hash.h>
+#include <Toy/Core/virtual_file_system.h>
+
+namespace toy
+{
+    namespace hash
+    {
+        static constexpr uint64_t s_xxh_prime_1 = 0x9E3779B185EBCA87ull;
+        static constexpr uint64_t s_xxh_prime_2 = 0xC2B2AE3D27D4EB4Full;
+        static constexpr uint64_t s_xxh_prime_3 = 0x165667B19E3779F9ull;
+        static constexpr uint64_t s_xxh_prime_4 = 0x85EBCA77C2B2AE63ull;
+        static constexpr uint64_t s_xxh_prime_5 = 0x27D4EB2F165667C5ull;
+
+        static inline uint64_t rotl_64(uint64_t value, int32_t bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        static inline uint64_t read_64(const uint8_t *ptr)
+        {
+            uint64_t value = 0;
+            std::memcpy(&value, ptr, sizeof(uint64_t));
+            return value;
+        }
+
+        static inline uint32_t read_32(const uint8_t *ptr)
+        {
+            uint32_t value = 0;
+            std::memcpy(&value, ptr, sizeof(uint32_t));
+            return value;
+        }
+
+        static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+        {
+            acc += input * s_xxh_prime_2;
+            acc = rotl_64(acc, 31);
+            return acc * s_xxh_prime_1;
+        }
+
+        static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t value)
+        {
+            acc ^= xxh_round(0, value);
+            return acc * s_xxh_prime_1 + s_xxh_prime_4;
+        }
+
+        uint64_t xxhash_64(const void *data, size_t byte_width, uint64_t seed)
+        {
+            auto ptr = static_cast<const uint8_t *>(data);
+            const uint8_t *end = ptr + byte_width;
+            uint64_t result = 0;
+
+            if (byte_width >= 32)
+            {
+                const uint8_t *limit = end - 32;
+                uint64_t v1 = seed + s_xxh_prime_1 + s_xxh_prime_2;
+                uint64_t v2 = seed + s_xxh_prime_2;
+                uint64_t v3 = seed;
+                uint64_t v4 = seed - s_xxh_prime_1;
+                do
+                {
+                    v1 = xxh_round(v1, read_64(ptr)); ptr += 8;
+                    v2 = xxh_round(v2, read_64(ptr)); ptr += 8;
+                    v3 = xxh_round(v3, read_64(ptr)); ptr += 8;
+                    v4 = xxh_round(v4, read_64(ptr)); ptr += 8;
+                } while (ptr <= limit);
+
+                result = rotl_64(v1, 1) + rotl_64(v2, 7) + rotl_64(v3, 12) + rotl_64(v4, 18);
+                result = xxh_merge_round(result, v1);
+                result = xxh_merge_round(result, v2);
+                result = xxh_merge_round(result, v3);
+                result = xxh_merge_round(result, v4);
+            } else
+            {
+                result = seed + s_xxh_prime_5;
+            }
+
+            result += static_cast<uint64_t>(byte_width);
+
+            while (ptr + 8 <= end)
+            {
+                result ^= xxh_round(0, read_64(ptr));
+                result = rotl_64(result, 27) * s_xxh_prime_1 + s_xxh_prime_4;
+                ptr += 8;
+            }
+            if (ptr + 4 <= end)
+            {
+                result ^= static_cast<uint64_t>(read_32(ptr)) * s_xxh_prime_1;
+                result = rotl_64(result, 23) * s_xxh_prime_2 + s_xxh_prime_3;
+                ptr += 4;
+            }
+            while (ptr < end)
+            {
+                result ^= (*ptr) * s_xxh_prime_5;
+                result = rotl_64(result, 11) * s_xxh_prime_1;
+                ++ptr;
+            }
+
+            // Avalanche
+            result ^= result >> 33;
+            result *= s_xxh_prime_2;
+            result ^= result >> 29;
+            result *= s_xxh_prime_3;
+            result ^= result >> 32;
+            return result;
+        }
+    }
+
+    XID path_to_id(std::string_view path)
+    {
+        // Backslash is only a separator on Windows, it is replaced first so that every platform hashes a path alike
+        std::string separated_path(path);
+        std::replace(separated_path.begin(), separated_path.end(), '\\', '/');
+        std::string normalized_path = std::filesystem::path(separated_path).lexically_normal().generic_string();
+        return hash::fnv1a_64(normalized_path);
+    }
+
+    XID content_to_id(const void *data, size_t byte_width)
+    {
+        return hash::xxhash_64(data, byte_width);
+    }
+
+    XID file_content_to_id(std::string_view file_name)
+    {
+        // Packed file has its content ID in pack index, loose file is hashed from the mapped view
+        return VirtualFileSystem::get().get_content_id(std::filesystem::path(file_name));
+    }
+
+    bool IdCollisionChecker::check(XID id, std::string_view name)
+    {
+        auto [it, inserted] = m_names.try_emplace(id, name);
+        if (!inserted && it->second != name)
+        {
+            DX_CORE_ERROR("ID collision: '{}' and '{}' share ID {:#018x}", it->second, name, id);
+            return false;
+        }
+        return true;
+    }
+
+    void IdCollisionChecker::remove(XID id)
+    {
+        m_names.erase(id);
+    }
+}
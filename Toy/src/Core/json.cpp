@@ -0,0 +1,425 @@
+//
+// Created by ZZK on 2024/4/8.
+//
+
+#include <Toy/Core/json.h>
+
+namespace toy::json
+{
+    static const Value s_null_value{};
+    static const Array s_empty_array{};
+    static const Object s_empty_object{};
+
+    bool Value::as_boolean(bool default_value) const
+    {
+        auto value = std::get_if<bool>(&m_data);
+        return value ? *value : default_value;
+    }
+
+    double Value::as_number(double default_value) const
+    {
+        auto value = std::get_if<double>(&m_data);
+        return value ? *value : default_value;
+    }
+
+    float Value::as_float(float default_value) const
+    {
+        auto value = std::get_if<double>(&m_data);
+        return value ? static_cast<float>(*value) : default_value;
+    }
+
+    int64_t Value::as_integer(int64_t default_value) const
+    {
+        auto value = std::get_if<double>(&m_data);
+        return value ? static_cast<int64_t>(*value) : default_value;
+    }
+
+    std::string_view Value::as_string(std::string_view default_value) const
+    {
+        auto value = std::get_if<std::string>(&m_data);
+        return value ? std::string_view{ *value } : default_value;
+    }
+
+    size_t Value::size() const
+    {
+        if (auto array = std::get_if<Array>(&m_data))
+        {
+            return array->size();
+        }
+        if (auto object = std::get_if<Object>(&m_data))
+        {
+            return object->size();
+        }
+        return 0;
+    }
+
+    bool Value::contains(std::string_view key) const
+    {
+        return !(*this)[key].is_null();
+    }
+
+    const Value& Value::operator[](size_t index) const
+    {
+        auto array = std::get_if<Array>(&m_data);
+        if (!array || index >= array->size())
+        {
+            return s_null_value;
+        }
+        return (*array)[index];
+    }
+
+    const Value& Value::operator[](std::string_view key) const
+    {
+        if (auto object = std::get_if<Object>(&m_data))
+        {
+            for (auto&& [member_key, member_value] : *object)
+            {
+                if (member_key == key)
+                {
+                    return member_value;
+                }
+            }
+        }
+        return s_null_value;
+    }
+
+    const Array& Value::array() const
+    {
+        auto array = std::get_if<Array>(&m_data);
+        return array ? *array : s_empty_array;
+    }
+
+    const Object& Value::object() const
+    {
+        auto object = std::get_if<Object>(&m_data);
+        return object ? *object : s_empty_object;
+    }
+
+    // Recursive descent parser
+    class Parser
+    {
+    public:
+        explicit Parser(std::string_view text) : m_text(text) {}
+
+        bool parse_document(Value& value)
+        {
+            if (!parse_value(value, 0))
+            {
+                return false;
+            }
+            skip_whitespace();
+            if (m_pos != m_text.size())
+            {
+                return fail("Unexpected trailing characters");
+            }
+            return true;
+        }
+
+        [[nodiscard]] const std::string& error() const { return m_error; }
+
+    private:
+        // Guard against stack overflow on malicious input
+        static constexpr uint32_t s_max_depth = 256;
+
+        bool fail(std::string_view message)
+        {
+            if (m_error.empty())
+            {
+                m_error = fmt::format("{} at offset {}", message, m_pos);
+            }
+            return false;
+        }
+
+        void skip_whitespace()
+        {
+            while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r'))
+            {
+                ++m_pos;
+            }
+        }
+
+        bool consume(std::string_view token)
+        {
+            if (m_text.substr(m_pos, token.size()) != token)
+            {
+                return false;
+            }
+            m_pos += token.size();
+            return true;
+        }
+
+        bool parse_value(Value& value, uint32_t depth)
+        {
+            if (depth > s_max_depth)
+            {
+                return fail("Nesting too deep");
+            }
+
+            skip_whitespace();
+            if (m_pos >= m_text.size())
+            {
+                return fail("Unexpected end of text");
+            }
+
+            switch (m_text[m_pos])
+            {
+                case '{': return parse_object(value, depth);
+                case '[': return parse_array(value, depth);
+                case '"':
+                {
+                    std::string str{};
+                    if (!parse_string(str))
+                    {
+                        return false;
+                    }
+                    value = Value{ std::move(str) };
+                    return true;
+                }
+                case 't':
+                    value = Value{ true };
+                    return consume("true") || fail("Invalid literal");
+                case 'f':
+                    value = Value{ false };
+                    return consume("false") || fail("Invalid literal");
+                case 'n':
+                    value = Value{};
+                    return consume("null") || fail("Invalid literal");
+                default:
+                    return parse_number(value);
+            }
+        }
+
+        bool parse_object(Value& value, uint32_t depth)
+        {
+            Object object{};
+            ++m_pos;
+            skip_whitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == '}')
+            {
+                ++m_pos;
+                value = Value{ std::move(object) };
+                return true;
+            }
+
+            while (true)
+            {
+                skip_whitespace();
+                std::string key{};
+                if (m_pos >= m_text.size() || m_text[m_pos] != '"' || !parse_string(key))
+                {
+                    return fail("Expected object key");
+                }
+                skip_whitespace();
+                if (!consume(":"))
+                {
+                    return fail("Expected ':'");
+                }
+                Value member{};
+                if (!parse_value(member, depth + 1))
+                {
+                    return false;
+                }
+                object.emplace_back(std::move(key), std::move(member));
+
+                skip_whitespace();
+                if (consume(","))
+                {
+                    continue;
+                }
+                if (consume("}"))
+                {
+                    break;
+                }
+                return fail("Expected ',' or '}'");
+            }
+            value = Value{ std::move(object) };
+            return true;
+        }
+
+        bool parse_array(Value& value, uint32_t depth)
+        {
+            Array array{};
+            ++m_pos;
+            skip_whitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ']')
+            {
+                ++m_pos;
+                value = Value{ std::move(array) };
+                return true;
+            }
+
+            while (true)
+            {
+                Value element{};
+                if (!parse_value(element, depth + 1))
+                {
+                    return false;
+                }
+                array.emplace_back(std::move(element));
+
+                skip_whitespace();
+                if (consume(","))
+                {
+                    continue;
+                }
+                if (consume("]"))
+                {
+                    break;
+                }
+                return fail("Expected ',' or ']'");
+            }
+            value = Value{ std::move(array) };
+            return true;
+        }
+
+        bool parse_hex4(uint32_t& code_point)
+        {
+            if (m_pos + 4 > m_text.size())
+            {
+                return fail("Truncated unicode escape");
+            }
+            code_point = 0;
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                char c = m_text[m_pos++];
+                code_point <<= 4;
+                if (c >= '0' && c <= '9') code_point |= static_cast<uint32_t>(c - '0');
+                else if (c >= 'a' && c <= 'f') code_point |= static_cast<uint32_t>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F') code_point |= static_cast<uint32_t>(c - 'A' + 10);
+                else return fail("Invalid unicode escape");
+            }
+            return true;
+        }
+
+        static void append_utf8(std::string& str, uint32_t code_point)
+        {
+            if (code_point < 0x80)
+            {
+                str += static_cast<char>(code_point);
+            } else if (code_point < 0x800)
+            {
+                str += static_cast<char>(0xC0 | (code_point >> 6));
+                str += static_cast<char>(0x80 | (code_point & 0x3F));
+            } else if (code_point < 0x10000)
+            {
+                str += static_cast<char>(0xE0 | (code_point >> 12));
+                str += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                str += static_cast<char>(0x80 | (code_point & 0x3F));
+            } else
+            {
+                str += static_cast<char>(0xF0 | (code_point >> 18));
+                str += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                str += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                str += static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+        }
+
+        bool parse_string(std::string& str)
+        {
+            // Skip opening quote
+            ++m_pos;
+            while (m_pos < m_text.size())
+            {
+                char c = m_text[m_pos++];
+                if (c == '"')
+                {
+                    return true;
+                }
+                if (c != '\\')
+                {
+                    str += c;
+                    continue;
+                }
+
+                if (m_pos >= m_text.size())
+                {
+                    break;
+                }
+                char escape = m_text[m_pos++];
+                switch (escape)
+                {
+                    case '"': str += '"'; break;
+                    case '\\': str += '\\'; break;
+                    case '/': str += '/'; break;
+                    case 'b': str += '\b'; break;
+                    case 'f': str += '\f'; break;
+                    case 'n': str += '\n'; break;
+                    case 'r': str += '\r'; break;
+                    case 't': str += '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t code_point = 0;
+                        if (!parse_hex4(code_point))
+                        {
+                            return false;
+                        }
+                        // Surrogate pair
+                        if (code_point >= 0xD800 && code_point <= 0xDBFF && consume("\\u"))
+                        {
+                            uint32_t low = 0;
+                            if (!parse_hex4(low))
+                            {
+                                return false;
+                            }
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        append_utf8(str, code_point);
+                        break;
+                    }
+                    default: return fail("Invalid escape character");
+                }
+            }
+            return fail("Unterminated string");
+        }
+
+        bool parse_number(Value& value)
+        {
+            size_t start = m_pos;
+            if (m_pos < m_text.size() && m_text[m_pos] == '-')
+            {
+                ++m_pos;
+            }
+            while (m_pos < m_text.size() && ((m_text[m_pos] >= '0' && m_text[m_pos] <= '9') || m_text[m_pos] == '.' ||
+                    m_text[m_pos] == 'e' || m_text[m_pos] == 'E' || m_text[m_pos] == '+' || m_text[m_pos] == '-'))
+            {
+                ++m_pos;
+            }
+            if (start == m_pos)
+            {
+                return fail("Unexpected character");
+            }
+
+            // strtod needs a null terminated string
+            std::string number_str{ m_text.substr(start, m_pos - start) };
+            char* end_str = nullptr;
+            double number = std::strtod(number_str.c_str(), &end_str);
+            if (end_str != number_str.c_str() + number_str.size())
+            {
+                m_pos = start;
+                return fail("Invalid number");
+            }
+            value = Value{ number };
+            return true;
+        }
+
+    private:
+        std::string_view m_text;
+        size_t m_pos = 0;
+        std::string m_error;
+    };
+
+    bool parse(std::string_view text, Value& value, std::string* error)
+    {
+        Parser parser(text);
+        if (!parser.parse_document(value))
+        {
+            if (error)
+            {
+                *error = parser.error();
+            }
+            value = Value{};
+            return false;
+        }
+        return true;
+    }
+}
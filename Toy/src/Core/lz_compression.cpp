@@ -0,0 +1,229 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Core/lz_compression.h>
+
+namespace toy
+{
+    // LZ4 block format, see lz4_Block_format.md of LZ4 project
+    static constexpr size_t s_min_match = 4;
+    static constexpr size_t s_last_literals = 5;         // Block always ends with at least 5 literals
+    static constexpr size_t s_match_start_limit = 12;    // Last match starts at least 12 bytes before end of block
+    static constexpr size_t s_max_offset = 65535;
+    static constexpr uint32_t s_hash_bits = 16;
+    static constexpr uint32_t s_skip_trigger = 6;        // Step grows by 1 for every 64 bytes without match
+
+    static inline uint32_t read_32(const uint8_t *ptr)
+    {
+        uint32_t value = 0;
+        std::memcpy(&value, ptr, sizeof(uint32_t));
+        return value;
+    }
+
+    static inline uint64_t read_64(const uint8_t *ptr)
+    {
+        uint64_t value = 0;
+        std::memcpy(&value, ptr, sizeof(uint64_t));
+        return value;
+    }
+
+    static inline uint32_t hash_sequence(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - s_hash_bits);
+    }
+
+    // Length beyond what fits in token, as a run of 255 followed by the remainder
+    static inline uint8_t* write_length(uint8_t *op, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            *op++ = 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+        return op;
+    }
+
+    static inline bool read_length(const uint8_t *&ip, const uint8_t *end, size_t& length)
+    {
+        uint8_t byte = 255;
+        while (byte == 255)
+        {
+            if (ip >= end)
+            {
+                return false;
+            }
+            byte = *ip++;
+            length += byte;
+        }
+        return true;
+    }
+
+    // Count equal bytes of a and b, b is before a and comparison stops at limit
+    static inline size_t count_match(const uint8_t *a, const uint8_t *b, const uint8_t *limit)
+    {
+        const uint8_t *start = a;
+        while (a + 8 <= limit)
+        {
+            uint64_t diff = read_64(a) ^ read_64(b);
+            if (diff != 0)
+            {
+                return static_cast<size_t>(a - start) + std::countr_zero(diff) / 8;
+            }
+            a += 8;
+            b += 8;
+        }
+        while (a < limit && *a == *b)
+        {
+            ++a;
+            ++b;
+        }
+        return static_cast<size_t>(a - start);
+    }
+
+    size_t lz_compress_bound(size_t byte_width)
+    {
+        return byte_width + byte_width / 255 + 16;
+    }
+
+    void lz_compress(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+    {
+        output.resize(lz_compress_bound(input.size()));
+        const uint8_t *src = input.data();
+        size_t size = input.size();
+        uint8_t *op = output.data();
+
+        auto emit_sequence = [&op](const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length)
+        {
+            uint8_t *token = op++;
+            *token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+            if (literal_length >= 15)
+            {
+                op = write_length(op, literal_length - 15);
+            }
+            if (literal_length > 0)
+            {
+                std::memcpy(op, literals, literal_length);
+                op += literal_length;
+            }
+            if (match_length == 0)
+            {
+                return;
+            }
+
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            size_t length_code = match_length - s_min_match;
+            *token |= static_cast<uint8_t>(std::min<size_t>(length_code, 15));
+            if (length_code >= 15)
+            {
+                op = write_length(op, length_code - 15);
+            }
+        };
+
+        size_t anchor = 0;
+        if (size > s_match_start_limit)
+        {
+            // Positions are offset by 1 so that zero marks an empty slot
+            std::vector<uint32_t> hash_table(size_t(1) << s_hash_bits, 0);
+            const uint8_t *match_limit = src + size - s_last_literals;
+            size_t search_end = size - s_match_start_limit;
+            size_t i = 0;
+            uint32_t misses = 0;
+            while (i < search_end)
+            {
+                uint32_t sequence = read_32(src + i);
+                uint32_t& slot = hash_table[hash_sequence(sequence)];
+                size_t candidate = slot;
+                slot = static_cast<uint32_t>(i + 1);
+                if (candidate == 0 || i + 1 - candidate > s_max_offset || read_32(src + candidate - 1) != sequence)
+                {
+                    i += 1 + (misses++ >> s_skip_trigger);
+                    continue;
+                }
+
+                candidate -= 1;
+                size_t match_length = s_min_match + count_match(src + i + s_min_match, src + candidate + s_min_match, match_limit);
+                emit_sequence(src + anchor, i - anchor, i - candidate, match_length);
+                i += match_length;
+                anchor = i;
+                misses = 0;
+
+                // Position just before match end is likely to start the next one
+                if (i < search_end)
+                {
+                    hash_table[hash_sequence(read_32(src + i - 2))] = static_cast<uint32_t>(i - 1);
+                }
+            }
+        }
+
+        emit_sequence(src + anchor, size - anchor, 0, 0);
+        output.resize(static_cast<size_t>(op - output.data()));
+    }
+
+    bool lz_decompress(std::span<const uint8_t> input, std::span<uint8_t> output)
+    {
+        const uint8_t *ip = input.data();
+        const uint8_t *input_end = ip + input.size();
+        uint8_t *op = output.data();
+        uint8_t *output_end = op + output.size();
+
+        while (ip < input_end)
+        {
+            uint8_t token = *ip++;
+            size_t literal_length = token >> 4;
+            if (literal_length == 15 && !read_length(ip, input_end, literal_length))
+            {
+                return false;
+            }
+            if (literal_length > static_cast<size_t>(input_end - ip) || literal_length > static_cast<size_t>(output_end - op))
+            {
+                return false;
+            }
+            if (literal_length > 0)
+            {
+                std::memcpy(op, ip, literal_length);
+                ip += literal_length;
+                op += literal_length;
+            }
+
+            // Last sequence has literals only
+            if (ip == input_end)
+            {
+                break;
+            }
+
+            if (input_end - ip < 2)
+            {
+                return false;
+            }
+            size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            size_t match_length = token & 15;
+            if (match_length == 15 && !read_length(ip, input_end, match_length))
+            {
+                return false;
+            }
+            match_length += s_min_match;
+            if (offset == 0 || offset > static_cast<size_t>(op - output.data()) || match_length > static_cast<size_t>(output_end - op))
+            {
+                return false;
+            }
+
+            // Overlapping match repeats the last offset bytes, so it is copied forward byte by byte
+            const uint8_t *match = op - offset;
+            if (offset >= match_length)
+            {
+                std::memcpy(op, match, match_length);
+                op += match_length;
+            } else
+            {
+                for (size_t i = 0; i < match_length; ++i)
+                {
+                    *op++ = *match++;
+                }
+            }
+        }
+        return op == output_end;
+    }
+}
@@ -0,0 +1,174 @@
+//
+// Created by ZZK on 2024/4/6.
+//
+
+#include <Toy/Core/mapped_file.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace toy
+{
+    MappedFile::MappedFile(const std::filesystem::path& file_path)
+    {
+        open(file_path);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_file = std::exchange(other.m_file, s_invalid_file);
+#if defined(_WIN32)
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+#if defined(_WIN32)
+    bool MappedFile::open(const std::filesystem::path& file_path)
+    {
+        close();
+
+        m_file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == s_invalid_file)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER file_size{};
+        if (!GetFileSizeEx(m_file, &file_size))
+        {
+            close();
+            return false;
+        }
+
+        // Empty file can not be mapped, keep handle so that it still counts as opened
+        m_size = static_cast<size_t>(file_size.QuadPart);
+        if (m_size == 0)
+        {
+            return true;
+        }
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping)
+        {
+            close();
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data)
+        {
+            UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+        if (m_mapping)
+        {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != s_invalid_file)
+        {
+            CloseHandle(m_file);
+            m_file = s_invalid_file;
+        }
+        m_size = 0;
+    }
+#else
+    bool MappedFile::open(const std::filesystem::path& file_path)
+    {
+        close();
+
+        m_file = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_file == s_invalid_file)
+        {
+            return false;
+        }
+
+        struct stat file_stat{};
+        if (::fstat(m_file, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+        {
+            close();
+            return false;
+        }
+
+        // Empty file can not be mapped, keep descriptor so that it still counts as opened
+        m_size = static_cast<size_t>(file_stat.st_size);
+        if (m_size == 0)
+        {
+            return true;
+        }
+
+        void* view = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+        if (view == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        m_data = static_cast<const uint8_t *>(view);
+        ::posix_madvise(view, m_size, POSIX_MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data)
+        {
+            ::munmap(const_cast<uint8_t *>(m_data), m_size);
+            m_data = nullptr;
+        }
+        if (m_file != s_invalid_file)
+        {
+            ::close(m_file);
+            m_file = s_invalid_file;
+        }
+        m_size = 0;
+    }
+#endif
+
+    std::filesystem::path make_temp_path(const std::filesystem::path& file_path)
+    {
+        static std::atomic<uint64_t> s_temp_count = 0;
+        std::filesystem::path temp_path = file_path;
+#if defined(_WIN32)
+        auto process_id = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+        auto process_id = static_cast<uint32_t>(::getpid());
+#endif
+        temp_path += fmt::format(".{}.{:x}.{}.tmp", process_id, std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                                 s_temp_count.fetch_add(1, std::memory_order_relaxed));
+        return temp_path;
+    }
+}
@@ -0,0 +1,196 @@
+//
+// Created by ZZK on 2024/4/12.
+//
+
+#include <Toy/Core/parallel.h>
+
+namespace toy
+{
+    size_t get_worker_count()
+    {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    void parallel_for(size_t count, const std::function<void(size_t)> &func)
+    {
+        size_t num_threads = std::min<size_t>(count, get_worker_count());
+        if (num_threads <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next_item = 0;
+        std::exception_ptr exception = nullptr;
+        std::mutex exception_mutex;
+        auto worker = [&]()
+        {
+            for (size_t i = next_item++; i < count; i = next_item++)
+            {
+                try
+                {
+                    func(i);
+                } catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(exception_mutex);
+                    if (!exception)
+                    {
+                        exception = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        // Calling thread is one of the workers
+        std::vector<std::thread> threads{};
+        threads.reserve(num_threads - 1);
+        for (size_t i = 0; i + 1 < num_threads; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto&& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // Worker running on current thread, tasks submitted from it are pushed to its own deque
+    static thread_local const TaskPool* s_current_pool = nullptr;
+    static thread_local size_t s_current_worker = 0;
+
+    TaskPool::TaskPool(size_t num_threads)
+    {
+        num_threads = num_threads == 0 ? get_worker_count() : num_threads;
+        m_queues.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i)
+        {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        m_threads.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i)
+        {
+            m_threads.emplace_back([this, i]() { run_worker(i); });
+        }
+    }
+
+    TaskPool::~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work_available.notify_all();
+        for (auto&& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void TaskPool::submit(Task&& task)
+    {
+        size_t index = s_current_pool == this ? s_current_worker : m_next_queue++ % m_queues.size();
+        ++m_pending_count;
+        {
+            // Count is raised with the push under pool mutex, so a worker going to sleep never misses the task
+            std::lock_guard<std::mutex> lock(m_mutex);
+            {
+                std::lock_guard<std::mutex> queue_lock(m_queues[index]->mutex);
+                m_queues[index]->tasks.push_back(std::move(task));
+            }
+            ++m_queued_count;
+        }
+        m_work_available.notify_one();
+    }
+
+    void TaskPool::wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_all_done.wait(lock, [this]() { return m_pending_count.load() == 0; });
+        if (m_exception)
+        {
+            std::exception_ptr exception = nullptr;
+            std::swap(exception, m_exception);
+            std::rethrow_exception(exception);
+        }
+    }
+
+    bool TaskPool::take_task(size_t index, Task& task)
+    {
+        {
+            auto&& own_queue = *m_queues[index];
+            std::lock_guard<std::mutex> lock(own_queue.mutex);
+            if (!own_queue.tasks.empty())
+            {
+                task = std::move(own_queue.tasks.back());
+                own_queue.tasks.pop_back();
+                --m_queued_count;
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < m_queues.size(); ++i)
+        {
+            auto&& victim_queue = *m_queues[(index + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim_queue.mutex);
+            if (!victim_queue.tasks.empty())
+            {
+                task = std::move(victim_queue.tasks.front());
+                victim_queue.tasks.pop_front();
+                --m_queued_count;
+                ++m_steal_count;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TaskPool::run_worker(size_t index)
+    {
+        s_current_pool = this;
+        s_current_worker = index;
+        while (true)
+        {
+            Task task{};
+            if (take_task(index, task))
+            {
+                try
+                {
+                    task();
+                } catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_exception)
+                    {
+                        m_exception = std::current_exception();
+                    }
+                }
+                task = nullptr;
+
+                if (--m_pending_count == 0)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_all_done.notify_all();
+                }
+                continue;
+            }
+
+            // Pending tasks are drained before stopping
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_available.wait(lock, [this]() { return m_stopping || m_queued_count.load() > 0; });
+            if (m_stopping && m_queued_count.load() == 0)
+            {
+                break;
+            }
+        }
+        s_current_pool = nullptr;
+    }
+}
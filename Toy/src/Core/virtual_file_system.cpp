@@ -0,0 +1,160 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Core/virtual_file_system.h>
+
+namespace toy
+{
+    // Path relative to root, empty if file lies outside of root
+    static std::string get_relative_path(const std::filesystem::path& file_path, const std::filesystem::path& root_dir)
+    {
+        std::error_code error_code{};
+        std::filesystem::path absolute_path = file_path.is_absolute() ? file_path : std::filesystem::absolute(file_path, error_code);
+        std::filesystem::path relative_path = absolute_path.lexically_normal().lexically_relative(root_dir);
+        if (error_code || relative_path.empty() || *relative_path.begin() == "..")
+        {
+            return {};
+        }
+        return relative_path.generic_string();
+    }
+
+    bool VirtualFileSystem::mount(const std::filesystem::path& pack_path, const std::filesystem::path& root_dir)
+    {
+        auto pack = std::make_shared<AssetPack>();
+        if (!pack->open(pack_path))
+        {
+            return false;
+        }
+
+        std::error_code error_code{};
+        std::filesystem::path absolute_root = std::filesystem::absolute(root_dir, error_code).lexically_normal();
+        DX_CORE_INFO("Mount asset pack {} of {} files at {}", pack_path.string(), pack->get_entries().size(), absolute_root.string());
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_packs.insert(m_packs.begin(), MountedPack{ std::move(pack), std::move(absolute_root) });
+        return true;
+    }
+
+    void VirtualFileSystem::unmount_all()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_packs.clear();
+    }
+
+    size_t VirtualFileSystem::get_mounted_count() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_packs.size();
+    }
+
+    std::pair<std::shared_ptr<const AssetPack>, const AssetPackEntry*> VirtualFileSystem::find(const std::filesystem::path& file_path) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        for (auto&& mounted_pack : m_packs)
+        {
+            std::string relative_path = get_relative_path(file_path, mounted_pack.root_dir);
+            if (relative_path.empty())
+            {
+                continue;
+            }
+            if (auto entry = mounted_pack.pack->find(asset_pack_path_id(relative_path)))
+            {
+                return { mounted_pack.pack, entry };
+            }
+        }
+        return { nullptr, nullptr };
+    }
+
+    VirtualFile VirtualFileSystem::open(const std::filesystem::path& file_path) const
+    {
+        VirtualFile file{};
+        if (auto [pack, entry] = find(file_path); entry)
+        {
+            if (entry->compression == AssetCompression::None)
+            {
+                file.m_bytes = pack->get_stored_bytes(*entry);
+#if defined(_DEBUG)
+                if (!pack->verify(*entry))
+                {
+                    DX_CORE_ERROR("Asset pack entry '{}' is corrupt", pack->get_name(*entry));
+                    ++m_failed_opens;
+                    return {};
+                }
+#endif
+            } else
+            {
+                file.m_buffer.resize(static_cast<size_t>(entry->size));
+                if (!pack->read(*entry, file.m_buffer))
+                {
+                    ++m_failed_opens;
+                    return {};
+                }
+                file.m_bytes = file.m_buffer;
+                m_decompressed_bytes += entry->size;
+            }
+            file.m_pack = std::move(pack);
+            file.m_is_open = true;
+            ++m_packed_opens;
+            return file;
+        }
+
+        if (!file.m_file.open(file_path))
+        {
+            ++m_failed_opens;
+            return {};
+        }
+        file.m_bytes = file.m_file.bytes();
+        file.m_is_open = true;
+        ++m_loose_opens;
+        return file;
+    }
+
+    bool VirtualFileSystem::exists(const std::filesystem::path& file_path) const
+    {
+        if (find(file_path).second)
+        {
+            return true;
+        }
+        std::error_code error_code{};
+        return std::filesystem::is_regular_file(file_path, error_code);
+    }
+
+    uint64_t VirtualFileSystem::get_file_size(const std::filesystem::path& file_path) const
+    {
+        if (auto entry = find(file_path).second)
+        {
+            return entry->size;
+        }
+        std::error_code error_code{};
+        auto file_size = std::filesystem::file_size(file_path, error_code);
+        return error_code ? 0 : file_size;
+    }
+
+    XID VirtualFileSystem::get_content_id(const std::filesystem::path& file_path) const
+    {
+        if (auto entry = find(file_path).second)
+        {
+            return entry->checksum;
+        }
+
+        // Hash straight from the mapped view, no intermediate copy of file content
+        MappedFile file{ file_path };
+        if (!file.is_open())
+        {
+            return 0;
+        }
+        return content_to_id(file.data(), file.size());
+    }
+
+    VirtualFileStatistics VirtualFileSystem::get_statistics() const
+    {
+        return VirtualFileStatistics{ m_packed_opens.load(), m_loose_opens.load(), m_failed_opens.load(), m_decompressed_bytes.load() };
+    }
+
+    VirtualFileSystem& VirtualFileSystem::get()
+    {
+        static VirtualFileSystem virtual_file_system{};
+        return virtual_file_system;
+    }
+}
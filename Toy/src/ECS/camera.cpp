@@ -249,6 +249,16 @@ namespace toy
         return m_distance;
     }
 
+    float ThirdPersonCamera::get_min_distance() const
+    {
+        return m_min_distance;
+    }
+
+    float ThirdPersonCamera::get_max_distance() const
+    {
+        return m_max_distance;
+    }
+
     void ThirdPersonCamera::rotate_x(float radian)
     {
         using namespace DirectX;
@@ -4,6 +4,7 @@
 
 #include <Toy/ECS/components.h>
 #include <Toy/Model/model_manager.h>
+#include <Toy/Model/texture_manager.h>
 
 namespace toy
 {
@@ -22,7 +23,7 @@ namespace toy
         }
     }
 
-    void StaticMeshComponent::render(ID3D11DeviceContext *device_context, IEffect &effect, const Transform &transform)
+    void StaticMeshComponent::render(ID3D11DeviceContext *device_context, IEffect &effect, const Transform &transform, uint32_t entity_id)
     {
         size_t sz = model_asset->meshes.size();
         size_t fsz = submodel_in_frustum.size();
@@ -51,20 +52,64 @@ namespace toy
                 pEffectTransform->set_world_matrix(transform.get_local_to_world_matrix_xm());
             }
 
-            effect.apply(device_context);
+            auto* pEffectEntity = dynamic_cast<IEffectEntity *>(&effect);
+            if (pEffectEntity)
+            {
+                pEffectEntity->set_entity_id(entity_id);
+            }
 
+            // Input data is queried before apply, effect may select shaders by vertex encoding
             MeshDataInput input = pEffectMeshData->get_input_data(model_asset->meshes[i]);
+            effect.apply(device_context);
             {
                 device_context->IASetInputLayout(input.input_layout);
                 device_context->IASetPrimitiveTopology(input.topology);
                 device_context->IASetVertexBuffers(0, (uint32_t)input.vertex_buffers.size(),
                                                     input.vertex_buffers.data(), input.strides.data(), input.offsets.data());
-                device_context->IASetIndexBuffer(input.index_buffer, input.index_count > 65535 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT, 0);
+                device_context->IASetIndexBuffer(input.index_buffer, input.index_format, 0);
                 device_context->DrawIndexed(input.index_count, 0, 0);
             }
         }
     }
 
+    void StaticMeshComponent::request_textures(const Transform &transform, const DirectX::XMFLOAT3 &view_position, float projection_scale) const
+    {
+        using namespace DirectX;
+        auto&& texture_manager = model::TextureManager::get();
+        float world_scale = std::max({ std::abs(transform.scale.x), std::abs(transform.scale.y), std::abs(transform.scale.z) });
+        XMVECTOR view_pos = XMLoadFloat3(&view_position);
+
+        size_t sz = model_asset->meshes.size();
+        size_t fsz = submodel_in_frustum.size();
+        for (size_t i = 0; i < sz; ++i)
+        {
+            if (i < fsz && !submodel_in_frustum[i])
+            {
+                continue;
+            }
+
+            // Distance to nearest point of bounding box, 0 inside
+            auto&& mesh = model_asset->meshes[i];
+            BoundingBox box{};
+            mesh.bounding_box.Transform(box, transform.get_local_to_world_matrix_xm());
+            XMVECTOR center = XMLoadFloat3(&box.Center);
+            XMVECTOR extents = XMLoadFloat3(&box.Extents);
+            XMVECTOR nearest = XMVectorClamp(view_pos, XMVectorSubtract(center, extents), XMVectorAdd(center, extents));
+            float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(view_pos, nearest)));
+
+            float screen_uv_area = model::compute_screen_uv_area(mesh.uv_density, world_scale, distance, projection_scale);
+            auto&& material = model_asset->materials[mesh.material_index];
+            for (uint32_t slot = 0; slot < model::material_texture_count; ++slot)
+            {
+                auto semantics = static_cast<model::MaterialSemantics>(slot);
+                if (material.has(semantics))
+                {
+                    texture_manager.request_texture(material.get_texture(semantics), screen_uv_area);
+                }
+            }
+        }
+    }
+
     // Bounding box
     DirectX::BoundingBox StaticMeshComponent::get_local_bounding_box() const
     {
@@ -3,9 +3,14 @@
 //
 
 #include <Toy/Geometry/vertex.h>
+#include <Toy/Model/vertex_encoding.h>
 
 namespace toy
 {
+    // Headless import reports vertex fetch without these layouts
+    static_assert(sizeof(VertexPosNormalTangentTex) == model::full_precision_vertex_byte_width);
+    static_assert(sizeof(VertexPosNormalTangentTexQuantized) == model::quantized_vertex_byte_width);
+
     const std::array<D3D11_INPUT_ELEMENT_DESC, 1>& VertexPos::get_input_layout()
     {
         static const std::array<D3D11_INPUT_ELEMENT_DESC, 1> input_layout{
@@ -58,14 +63,13 @@ namespace toy
         return input_layout;
     }
 
-    const std::array<D3D11_INPUT_ELEMENT_DESC, 5>& VertexPosNormalTangentTexEntity::get_input_layout()
+    const std::array<D3D11_INPUT_ELEMENT_DESC, 4>& VertexPosNormalTangentTexQuantized::get_input_layout()
     {
-        static const std::array<D3D11_INPUT_ELEMENT_DESC, 5> input_layout{
-            D3D11_INPUT_ELEMENT_DESC{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            D3D11_INPUT_ELEMENT_DESC{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            D3D11_INPUT_ELEMENT_DESC{"TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            D3D11_INPUT_ELEMENT_DESC{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 3, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            D3D11_INPUT_ELEMENT_DESC{"ENTITY_ID", 0, DXGI_FORMAT_R32_UINT, 4, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
+        static const std::array<D3D11_INPUT_ELEMENT_DESC, 4> input_layout{
+            D3D11_INPUT_ELEMENT_DESC{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            D3D11_INPUT_ELEMENT_DESC{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            D3D11_INPUT_ELEMENT_DESC{"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 2, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            D3D11_INPUT_ELEMENT_DESC{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 3, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
         };
 
         return input_layout;
@@ -0,0 +1,712 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#include <Toy/Model/block_compression.h>
+#include <Toy/Core/parallel.h>
+
+namespace toy::model
+{
+    // 4 x 4 RGBA8 texels of a block, row major
+    using BlockTexels = std::array<std::array<uint8_t, 4>, 16>;
+
+    // Interpolation weights of 4-bit BC7 indices, in 64ths
+    static constexpr std::array<uint32_t, 16> s_bc7_weights = {
+        0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+    };
+
+    // Texels outside image repeat the last row and column
+    static BlockTexels load_block(const ImageMip& image, uint32_t block_x, uint32_t block_y)
+    {
+        BlockTexels texels{};
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            uint32_t image_y = std::min(block_y * 4 + y, image.height - 1);
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                uint32_t image_x = std::min(block_x * 4 + x, image.width - 1);
+                const uint8_t* texel = image.pixels.data() + (static_cast<size_t>(image_y) * image.width + image_x) * 4;
+                std::copy_n(texel, 4, texels[y * 4 + x].data());
+            }
+        }
+        return texels;
+    }
+
+    static void store_block(ImageMip& image, uint32_t block_x, uint32_t block_y, const BlockTexels& texels)
+    {
+        for (uint32_t y = 0; y < 4 && block_y * 4 + y < image.height; ++y)
+        {
+            for (uint32_t x = 0; x < 4 && block_x * 4 + x < image.width; ++x)
+            {
+                size_t offset = (static_cast<size_t>(block_y * 4 + y) * image.width + block_x * 4 + x) * 4;
+                std::copy_n(texels[y * 4 + x].data(), 4, image.pixels.data() + offset);
+            }
+        }
+    }
+
+    // Direction of largest variance of first channel_count channels, by power iteration on covariance
+    static std::array<float, 4> principal_axis(const BlockTexels& texels, uint32_t channel_count, std::array<float, 4>& mean)
+    {
+        mean = {};
+        for (auto&& texel : texels)
+        {
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                mean[c] += texel[c] / 16.0f;
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (auto&& texel : texels)
+        {
+            for (uint32_t i = 0; i < channel_count; ++i)
+            {
+                for (uint32_t j = 0; j < channel_count; ++j)
+                {
+                    covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+                }
+            }
+        }
+
+        std::array<float, 4> axis = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            std::array<float, 4> next{};
+            float length = 0.0f;
+            for (uint32_t i = 0; i < channel_count; ++i)
+            {
+                for (uint32_t j = 0; j < channel_count; ++j)
+                {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                length = std::max(length, std::abs(next[i]));
+            }
+            // Uniform block, any axis works
+            if (length < 1e-6f)
+            {
+                break;
+            }
+            for (uint32_t i = 0; i < channel_count; ++i)
+            {
+                axis[i] = next[i] / length;
+            }
+        }
+        return axis;
+    }
+
+    // Endpoints at extreme projections of texels onto principal axis
+    static void find_endpoints(const BlockTexels& texels, uint32_t channel_count, std::array<float, 4>& low, std::array<float, 4>& high)
+    {
+        std::array<float, 4> mean{};
+        auto axis = principal_axis(texels, channel_count, mean);
+
+        float min_t = std::numeric_limits<float>::max();
+        float max_t = std::numeric_limits<float>::lowest();
+        float axis_length_sq = 0.0f;
+        for (uint32_t c = 0; c < channel_count; ++c)
+        {
+            axis_length_sq += axis[c] * axis[c];
+        }
+        for (auto&& texel : texels)
+        {
+            float t = 0.0f;
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                t += (texel[c] - mean[c]) * axis[c];
+            }
+            min_t = std::min(min_t, t);
+            max_t = std::max(max_t, t);
+        }
+        if (axis_length_sq > 0.0f)
+        {
+            min_t /= axis_length_sq;
+            max_t /= axis_length_sq;
+        }
+
+        for (uint32_t c = 0; c < channel_count; ++c)
+        {
+            low[c] = std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f);
+            high[c] = std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f);
+        }
+    }
+
+    static uint32_t squared_distance(const std::array<uint8_t, 4>& a, const std::array<uint8_t, 4>& b, uint32_t channel_count)
+    {
+        uint32_t distance = 0;
+        for (uint32_t c = 0; c < channel_count; ++c)
+        {
+            int32_t delta = static_cast<int32_t>(a[c]) - static_cast<int32_t>(b[c]);
+            distance += static_cast<uint32_t>(delta * delta);
+        }
+        return distance;
+    }
+
+    // Pick nearest palette entry for every texel, return total squared error
+    template <size_t N>
+    static uint32_t assign_indices(const BlockTexels& texels, const std::array<std::array<uint8_t, 4>, N>& palette,
+        uint32_t palette_size, uint32_t channel_count, std::array<uint8_t, 16>& indices)
+    {
+        uint32_t total_error = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t best_error = std::numeric_limits<uint32_t>::max();
+            for (uint32_t p = 0; p < palette_size; ++p)
+            {
+                uint32_t error = squared_distance(texels[i], palette[p], channel_count);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            total_error += best_error;
+        }
+        return total_error;
+    }
+
+    // BC1
+
+    static uint16_t pack_565(const std::array<float, 4>& color)
+    {
+        auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+        auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+        auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    static std::array<uint8_t, 4> unpack_565(uint16_t color)
+    {
+        uint32_t r = (color >> 11) & 31;
+        uint32_t g = (color >> 5) & 63;
+        uint32_t b = color & 31;
+        return {
+            static_cast<uint8_t>((r << 3) | (r >> 2)),
+            static_cast<uint8_t>((g << 2) | (g >> 4)),
+            static_cast<uint8_t>((b << 3) | (b >> 2)),
+            255
+        };
+    }
+
+    static std::array<std::array<uint8_t, 4>, 4> bc1_palette(uint16_t color0, uint16_t color1, bool four_colors)
+    {
+        std::array<std::array<uint8_t, 4>, 4> palette{};
+        palette[0] = unpack_565(color0);
+        palette[1] = unpack_565(color1);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (four_colors)
+            {
+                palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+            } else
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c] + 1) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = four_colors ? 255 : 0;
+        return palette;
+    }
+
+    // Always four color mode, so the block stays valid as color part of BC3
+    static void encode_bc1(const BlockTexels& texels, uint8_t* output)
+    {
+        std::array<float, 4> low{}, high{};
+        find_endpoints(texels, 3, low, high);
+
+        uint16_t color0 = pack_565(high);
+        uint16_t color1 = pack_565(low);
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+        }
+
+        uint32_t index_bits = 0;
+        if (color0 != color1)
+        {
+            auto palette = bc1_palette(color0, color1, true);
+            std::array<uint8_t, 16> indices{};
+            assign_indices(texels, palette, 4, 3, indices);
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                index_bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+            }
+        }
+
+        std::memcpy(output, &color0, 2);
+        std::memcpy(output + 2, &color1, 2);
+        std::memcpy(output + 4, &index_bits, 4);
+    }
+
+    static void decode_bc1(const uint8_t* input, BlockTexels& texels, bool force_four_colors)
+    {
+        uint16_t color0 = 0, color1 = 0;
+        uint32_t index_bits = 0;
+        std::memcpy(&color0, input, 2);
+        std::memcpy(&color1, input + 2, 2);
+        std::memcpy(&index_bits, input + 4, 4);
+
+        auto palette = bc1_palette(color0, color1, force_four_colors || color0 > color1);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            auto&& entry = palette[(index_bits >> (i * 2)) & 3];
+            std::copy_n(entry.data(), 3, texels[i].data());
+            if (!force_four_colors)
+            {
+                texels[i][3] = entry[3];
+            }
+        }
+    }
+
+    // BC4, one channel of a block
+
+    static std::array<uint8_t, 8> bc4_palette(uint8_t value0, uint8_t value1)
+    {
+        std::array<uint8_t, 8> palette{ value0, value1 };
+        if (value0 > value1)
+        {
+            for (uint32_t i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = static_cast<uint8_t>(((7 - i) * value0 + i * value1 + 3) / 7);
+            }
+        } else
+        {
+            for (uint32_t i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = static_cast<uint8_t>(((5 - i) * value0 + i * value1 + 2) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        return palette;
+    }
+
+    // Always eight value mode between block extremes
+    static void encode_bc4(const BlockTexels& texels, uint32_t channel, uint8_t* output)
+    {
+        uint8_t min_value = 255, max_value = 0;
+        for (auto&& texel : texels)
+        {
+            min_value = std::min(min_value, texel[channel]);
+            max_value = std::max(max_value, texel[channel]);
+        }
+
+        uint64_t bits = static_cast<uint64_t>(max_value) | (static_cast<uint64_t>(min_value) << 8);
+        if (max_value != min_value)
+        {
+            auto palette = bc4_palette(max_value, min_value);
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t best_index = 0;
+                uint32_t best_error = std::numeric_limits<uint32_t>::max();
+                for (uint32_t p = 0; p < 8; ++p)
+                {
+                    int32_t delta = static_cast<int32_t>(palette[p]) - static_cast<int32_t>(texels[i][channel]);
+                    auto error = static_cast<uint32_t>(delta * delta);
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        best_index = p;
+                    }
+                }
+                bits |= static_cast<uint64_t>(best_index) << (16 + i * 3);
+            }
+        }
+        std::memcpy(output, &bits, 8);
+    }
+
+    static void decode_bc4(const uint8_t* input, uint32_t channel, BlockTexels& texels)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, input, 8);
+        auto palette = bc4_palette(static_cast<uint8_t>(bits & 0xff), static_cast<uint8_t>((bits >> 8) & 0xff));
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            texels[i][channel] = palette[(bits >> (16 + i * 3)) & 7];
+        }
+    }
+
+    // BC7 mode 6, RGBA endpoints of 7 bits with a shared low bit each, 4-bit indices
+
+    struct Bc7Mode6Block
+    {
+        std::array<std::array<uint8_t, 4>, 2> endpoints{};      // 7-bit values
+        std::array<uint8_t, 2> p_bits{};
+        std::array<uint8_t, 16> indices{};
+    };
+
+    static std::array<std::array<uint8_t, 4>, 16> bc7_palette(const Bc7Mode6Block& block)
+    {
+        std::array<std::array<uint8_t, 4>, 2> colors{};
+        for (uint32_t e = 0; e < 2; ++e)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                colors[e][c] = static_cast<uint8_t>((block.endpoints[e][c] << 1) | block.p_bits[e]);
+            }
+        }
+
+        std::array<std::array<uint8_t, 4>, 16> palette{};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                palette[i][c] = static_cast<uint8_t>(((64 - s_bc7_weights[i]) * colors[0][c] + s_bc7_weights[i] * colors[1][c] + 32) >> 6);
+            }
+        }
+        return palette;
+    }
+
+    // Quantize endpoints under every p-bit choice, keep the one of least error
+    static uint32_t fit_bc7_block(const BlockTexels& texels, const std::array<float, 4>& low, const std::array<float, 4>& high,
+        Bc7Mode6Block& block)
+    {
+        uint32_t best_error = std::numeric_limits<uint32_t>::max();
+        for (uint32_t p = 0; p < 4; ++p)
+        {
+            Bc7Mode6Block candidate{};
+            candidate.p_bits = { static_cast<uint8_t>(p & 1), static_cast<uint8_t>(p >> 1) };
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                auto quantize = [](float value, uint8_t p_bit)
+                {
+                    return static_cast<uint8_t>(std::clamp<long>(std::lround((value - p_bit) * 0.5f), 0, 127));
+                };
+                candidate.endpoints[0][c] = quantize(low[c], candidate.p_bits[0]);
+                candidate.endpoints[1][c] = quantize(high[c], candidate.p_bits[1]);
+            }
+
+            uint32_t error = assign_indices(texels, bc7_palette(candidate), 16, 4, candidate.indices);
+            if (error < best_error)
+            {
+                best_error = error;
+                block = candidate;
+            }
+        }
+        return best_error;
+    }
+
+    // Endpoints minimizing squared error of texels for fixed indices
+    static bool refine_endpoints(const BlockTexels& texels, const std::array<uint8_t, 16>& indices,
+        std::array<float, 4>& low, std::array<float, 4>& high)
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        std::array<float, 4> ax{}, bx{};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            float b = s_bc7_weights[indices[i]] / 64.0f;
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                ax[c] += a * texels[i][c];
+                bx[c] += b * texels[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            low[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+            high[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    // Little endian bit stream of a 128-bit block
+    class BlockBitWriter
+    {
+    public:
+        explicit BlockBitWriter(uint8_t* output) : m_output(output) { std::fill_n(output, 16, 0); }
+
+        void write(uint32_t value, uint32_t bit_count)
+        {
+            for (uint32_t i = 0; i < bit_count; ++i, ++m_position)
+            {
+                m_output[m_position / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (m_position % 8));
+            }
+        }
+
+    private:
+        uint8_t* m_output;
+        uint32_t m_position = 0;
+    };
+
+    class BlockBitReader
+    {
+    public:
+        explicit BlockBitReader(const uint8_t* input) : m_input(input) {}
+
+        uint32_t read(uint32_t bit_count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < bit_count; ++i, ++m_position)
+            {
+                value |= static_cast<uint32_t>((m_input[m_position / 8] >> (m_position % 8)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* m_input;
+        uint32_t m_position = 0;
+    };
+
+    static void encode_bc7(const BlockTexels& texels, uint8_t* output)
+    {
+        std::array<float, 4> low{}, high{};
+        find_endpoints(texels, 4, low, high);
+
+        Bc7Mode6Block block{};
+        uint32_t error = fit_bc7_block(texels, low, high, block);
+        // Least squares passes while they keep lowering the error
+        for (uint32_t iteration = 0; iteration < 2 && error > 0; ++iteration)
+        {
+            if (!refine_endpoints(texels, block.indices, low, high))
+            {
+                break;
+            }
+            Bc7Mode6Block refined{};
+            uint32_t refined_error = fit_bc7_block(texels, low, high, refined);
+            if (refined_error >= error)
+            {
+                break;
+            }
+            error = refined_error;
+            block = refined;
+        }
+
+        // Highest bit of first index is implicit 0, swap endpoints when it is set
+        if (block.indices[0] & 8)
+        {
+            std::swap(block.endpoints[0], block.endpoints[1]);
+            std::swap(block.p_bits[0], block.p_bits[1]);
+            for (auto&& index : block.indices)
+            {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        BlockBitWriter writer(output);
+        writer.write(1u << 6, 7);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            writer.write(block.endpoints[0][c], 7);
+            writer.write(block.endpoints[1][c], 7);
+        }
+        writer.write(block.p_bits[0], 1);
+        writer.write(block.p_bits[1], 1);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            writer.write(block.indices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    // Only mode 6 is decoded, other modes are written by no encoder of this engine and decode to zero
+    static void decode_bc7(const uint8_t* input, BlockTexels& texels)
+    {
+        BlockBitReader reader(input);
+        if (reader.read(7) != (1u << 6))
+        {
+            texels = {};
+            return;
+        }
+
+        Bc7Mode6Block block{};
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            block.endpoints[0][c] = static_cast<uint8_t>(reader.read(7));
+            block.endpoints[1][c] = static_cast<uint8_t>(reader.read(7));
+        }
+        block.p_bits[0] = static_cast<uint8_t>(reader.read(1));
+        block.p_bits[1] = static_cast<uint8_t>(reader.read(1));
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            block.indices[i] = static_cast<uint8_t>(reader.read(i == 0 ? 3 : 4));
+        }
+
+        auto palette = bc7_palette(block);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            texels[i] = palette[block.indices[i]];
+        }
+    }
+
+    static void encode_block(const BlockTexels& texels, BlockFormat format, uint8_t* output)
+    {
+        switch (format)
+        {
+            case BlockFormat::BC1:
+                encode_bc1(texels, output);
+                break;
+            case BlockFormat::BC3:
+                encode_bc4(texels, 3, output);
+                encode_bc1(texels, output + 8);
+                break;
+            case BlockFormat::BC4:
+                encode_bc4(texels, 0, output);
+                break;
+            case BlockFormat::BC5:
+                encode_bc4(texels, 0, output);
+                encode_bc4(texels, 1, output + 8);
+                break;
+            case BlockFormat::BC7:
+                encode_bc7(texels, output);
+                break;
+        }
+    }
+
+    static void decode_block(const uint8_t* input, BlockFormat format, BlockTexels& texels)
+    {
+        for (auto&& texel : texels)
+        {
+            texel = { 0, 0, 0, 255 };
+        }
+        switch (format)
+        {
+            case BlockFormat::BC1:
+                decode_bc1(input, texels, false);
+                break;
+            case BlockFormat::BC3:
+                decode_bc4(input, 3, texels);
+                decode_bc1(input + 8, texels, true);
+                break;
+            case BlockFormat::BC4:
+                decode_bc4(input, 0, texels);
+                break;
+            case BlockFormat::BC5:
+                decode_bc4(input, 0, texels);
+                decode_bc4(input + 8, 1, texels);
+                break;
+            case BlockFormat::BC7:
+                decode_bc7(input, texels);
+                break;
+        }
+    }
+
+    uint32_t get_block_byte_width(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+    }
+
+    DXGI_FORMAT get_dxgi_format(BlockFormat format, bool srgb)
+    {
+        switch (format)
+        {
+            case BlockFormat::BC1:
+                return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+            case BlockFormat::BC3:
+                return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+            case BlockFormat::BC4:
+                return DXGI_FORMAT_BC4_UNORM;
+            case BlockFormat::BC5:
+                return DXGI_FORMAT_BC5_UNORM;
+            case BlockFormat::BC7:
+                return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    uint32_t get_channel_count(BlockFormat format)
+    {
+        switch (format)
+        {
+            case BlockFormat::BC1:
+                return 3;
+            case BlockFormat::BC4:
+                return 1;
+            case BlockFormat::BC5:
+                return 2;
+            default:
+                return 4;
+        }
+    }
+
+    size_t get_compressed_byte_width(uint32_t width, uint32_t height, BlockFormat format)
+    {
+        size_t block_count = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+        return block_count * get_block_byte_width(format);
+    }
+
+    std::vector<uint8_t> compress_image(const ImageMip& image, BlockFormat format)
+    {
+        uint32_t blocks_x = (image.width + 3) / 4;
+        uint32_t blocks_y = (image.height + 3) / 4;
+        uint32_t block_byte_width = get_block_byte_width(format);
+        std::vector<uint8_t> blocks(get_compressed_byte_width(image.width, image.height, format));
+
+        // Rows write disjoint ranges of output
+        parallel_for(blocks_y, [&](size_t block_y)
+        {
+            uint8_t* output = blocks.data() + block_y * blocks_x * block_byte_width;
+            for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+            {
+                auto texels = load_block(image, block_x, static_cast<uint32_t>(block_y));
+                encode_block(texels, format, output + static_cast<size_t>(block_x) * block_byte_width);
+            }
+        });
+        return blocks;
+    }
+
+    ImageMip decompress_image(std::span<const uint8_t> blocks, uint32_t width, uint32_t height, BlockFormat format)
+    {
+        ImageMip image{};
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * height * 4);
+        if (blocks.size() < get_compressed_byte_width(width, height, format))
+        {
+            DX_CORE_WARN("Compressed image of {}x{} is truncated", width, height);
+            return image;
+        }
+
+        uint32_t blocks_x = (width + 3) / 4;
+        uint32_t blocks_y = (height + 3) / 4;
+        uint32_t block_byte_width = get_block_byte_width(format);
+        for (uint32_t block_y = 0; block_y < blocks_y; ++block_y)
+        {
+            for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+            {
+                BlockTexels texels{};
+                decode_block(blocks.data() + (static_cast<size_t>(block_y) * blocks_x + block_x) * block_byte_width, format, texels);
+                store_block(image, block_x, block_y, texels);
+            }
+        }
+        return image;
+    }
+
+    double compute_psnr(const ImageMip& reference, const ImageMip& image, BlockFormat format)
+    {
+        if (reference.width != image.width || reference.height != image.height || reference.pixels.size() != image.pixels.size())
+        {
+            DX_CORE_WARN("PSNR of images of different size");
+            return 0.0;
+        }
+
+        uint32_t channel_count = get_channel_count(format);
+        double squared_error = 0.0;
+        for (size_t i = 0; i < reference.pixels.size(); i += 4)
+        {
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                double delta = static_cast<double>(reference.pixels[i + c]) - static_cast<double>(image.pixels[i + c]);
+                squared_error += delta * delta;
+            }
+        }
+
+        size_t sample_count = reference.pixels.size() / 4 * channel_count;
+        if (squared_error == 0.0 || sample_count == 0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        double mean_squared_error = squared_error / static_cast<double>(sample_count);
+        return 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+    }
+}
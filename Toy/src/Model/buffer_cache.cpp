@@ -0,0 +1,148 @@
+//
+// Created by ZZK on 2024/4/13.
+//
+
+#include <Toy/Model/buffer_cache.h>
+
+namespace toy::model
+{
+    static constexpr uint64_t s_check_seed = 0x5851F42D4C957F2Dull;
+
+    // Trivially destructible, so that it can still be read while other static objects are destroyed
+    static std::atomic<bool> s_buffer_cache_alive = false;
+
+    BufferCache::BufferCache()
+    {
+        s_buffer_cache_alive = true;
+    }
+
+    BufferCache::~BufferCache()
+    {
+        s_buffer_cache_alive = false;
+    }
+
+    BufferCache& BufferCache::get()
+    {
+        static BufferCache buffer_cache{};
+        return buffer_cache;
+    }
+
+    bool BufferCache::is_alive()
+    {
+        return s_buffer_cache_alive.load(std::memory_order_acquire);
+    }
+
+    com_ptr<ID3D11Buffer> BufferCache::create(ID3D11Device *device, const void *data, size_t byte_width, uint32_t bind_flags,
+                                              std::vector<XID> &uses)
+    {
+        com_ptr<ID3D11Buffer> buffer = nullptr;
+        if (byte_width == 0)
+        {
+            return buffer;
+        }
+
+        XID key = hash::combine(hash::combine(content_to_id(data, byte_width), byte_width), bind_flags);
+        XID check = hash::xxhash_64(data, byte_width, s_check_seed);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_statistics.request_count++;
+            m_statistics.requested_bytes += byte_width;
+            if (auto it = m_buffers.find(key); it != m_buffers.end())
+            {
+                if (it->second.check == check)
+                {
+                    m_statistics.shared_count++;
+                    m_statistics.saved_bytes += byte_width;
+                    it->second.use_count++;
+                    uses.push_back(key);
+                    return it->second.buffer;
+                }
+                // Key collision, keep first buffer shared and leave this one unshared
+                DX_CORE_WARN("Buffer content hash collision on key {:#x}, buffer is not shared", key);
+            }
+        }
+
+        CD3D11_BUFFER_DESC buffer_desc{ static_cast<uint32_t>(byte_width), bind_flags };
+        D3D11_SUBRESOURCE_DATA init_data{ data, 0, 0 };
+        if (FAILED(device->CreateBuffer(&buffer_desc, &init_data, buffer.GetAddressOf())))
+        {
+            DX_CORE_CRITICAL("Fail to create buffer of {} bytes", byte_width);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [it, is_inserted] = m_buffers.try_emplace(key, Entry{ buffer, byte_width, check });
+        if (is_inserted)
+        {
+            m_resident_bytes += byte_width;
+        } else if (it->second.check == check)
+        {
+            // Same content created by another thread meanwhile, share its buffer
+            m_statistics.shared_count++;
+            m_statistics.saved_bytes += byte_width;
+            buffer = it->second.buffer;
+        } else
+        {
+            // Unshared buffer of colliding key is owned by caller alone
+            return buffer;
+        }
+        it->second.use_count++;
+        uses.push_back(key);
+        return buffer;
+    }
+
+    void BufferCache::release(std::span<const XID> uses)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto key : uses)
+        {
+            auto it = m_buffers.find(key);
+            if (it == m_buffers.end() || it->second.use_count == 0)
+            {
+                DX_CORE_ERROR("Release of unused buffer {:#x}", key);
+                continue;
+            }
+            it->second.use_count--;
+        }
+    }
+
+    size_t BufferCache::release_unused()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t released_bytes = 0;
+        for (auto it = m_buffers.begin(); it != m_buffers.end();)
+        {
+            if (it->second.use_count == 0)
+            {
+                released_bytes += it->second.byte_width;
+                it = m_buffers.erase(it);
+            } else
+            {
+                ++it;
+            }
+        }
+        m_resident_bytes -= released_bytes;
+        return released_bytes;
+    }
+
+    size_t BufferCache::get_resident_bytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_resident_bytes;
+    }
+
+    DeduplicationStatistics BufferCache::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    uint32_t get_reference_count(IUnknown *object)
+    {
+        if (!object)
+        {
+            return 0;
+        }
+        object->AddRef();
+        return static_cast<uint32_t>(object->Release());
+    }
+}
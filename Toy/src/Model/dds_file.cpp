@@ -0,0 +1,322 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#include <Toy/Model/dds_file.h>
+#include <Toy/Model/mip_generator.h>
+#include <Toy/Core/mapped_file.h>
+
+namespace toy::model
+{
+    // DDS file layout, see DirectX documentation of DDS_HEADER and DDS_HEADER_DXT10
+    static constexpr uint32_t s_dds_magic = 0x20534444;            // "DDS "
+    static constexpr uint32_t s_dds_fourcc_dx10 = 0x30315844;      // "DX10"
+    static constexpr uint32_t s_dds_caps2_cubemap = 0xFE00;        // CUBEMAP | all six faces
+    static constexpr uint32_t s_dds_caps2_volume = 0x200000;
+    static constexpr uint32_t s_dds_pixel_alpha = 0x2;
+    static constexpr uint32_t s_dds_pixel_fourcc = 0x4;
+    static constexpr uint32_t s_dds_pixel_rgb = 0x40;
+    static constexpr uint32_t s_dds_pixel_luminance = 0x20000;
+    static constexpr uint32_t s_dds_misc_texture_cube = 0x4;       // D3D11_RESOURCE_MISC_TEXTURECUBE
+
+    struct DdsPixelFormat
+    {
+        uint32_t size = sizeof(DdsPixelFormat);
+        uint32_t flags = s_dds_pixel_fourcc;
+        uint32_t fourcc = s_dds_fourcc_dx10;
+        uint32_t rgb_bit_count = 0;
+        uint32_t r_bit_mask = 0;
+        uint32_t g_bit_mask = 0;
+        uint32_t b_bit_mask = 0;
+        uint32_t a_bit_mask = 0;
+    };
+
+    struct DdsHeader
+    {
+        uint32_t size = sizeof(DdsHeader);
+        uint32_t flags = 0xA1007;               // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+        uint32_t height = 0;
+        uint32_t width = 0;
+        uint32_t pitch_or_linear_size = 0;
+        uint32_t depth = 0;
+        uint32_t mip_map_count = 0;
+        uint32_t reserved1[11] = {};
+        DdsPixelFormat pixel_format;
+        uint32_t caps = 0x401008;               // TEXTURE | MIPMAP | COMPLEX
+        uint32_t caps2 = 0;
+        uint32_t caps3 = 0;
+        uint32_t caps4 = 0;
+        uint32_t reserved2 = 0;
+    };
+
+    struct DdsHeaderDx10
+    {
+        uint32_t dxgi_format = 0;
+        uint32_t resource_dimension = 3;        // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+        uint32_t misc_flag = 0;
+        uint32_t array_size = 1;                // Cubes rather than faces when misc_flag has TEXTURECUBE
+        uint32_t misc_flags2 = 0;
+    };
+
+    static_assert(sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20);
+
+    static constexpr size_t s_dds_data_offset = sizeof(uint32_t) + sizeof(DdsHeader) + sizeof(DdsHeaderDx10);
+
+    // Direct3D 11 limits of 2D texture, larger header values are rejected before any size is computed
+    static constexpr uint32_t s_max_dimension = 16384;
+    static constexpr uint32_t s_max_array_size = 2048;
+
+    static constexpr uint32_t make_fourcc(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    // Format of legacy header, covering what D3D9-era tools wrote, unknown for the rest
+    static DXGI_FORMAT get_legacy_format(const DdsPixelFormat& pixel_format)
+    {
+        if (pixel_format.flags & s_dds_pixel_fourcc)
+        {
+            switch (pixel_format.fourcc)
+            {
+                case make_fourcc('D', 'X', 'T', '1'): return DXGI_FORMAT_BC1_UNORM;
+                case make_fourcc('D', 'X', 'T', '2'):
+                case make_fourcc('D', 'X', 'T', '3'): return DXGI_FORMAT_BC2_UNORM;
+                case make_fourcc('D', 'X', 'T', '4'):
+                case make_fourcc('D', 'X', 'T', '5'): return DXGI_FORMAT_BC3_UNORM;
+                case make_fourcc('A', 'T', 'I', '1'):
+                case make_fourcc('B', 'C', '4', 'U'): return DXGI_FORMAT_BC4_UNORM;
+                case make_fourcc('A', 'T', 'I', '2'):
+                case make_fourcc('B', 'C', '5', 'U'): return DXGI_FORMAT_BC5_UNORM;
+                // D3DFORMAT values stored as fourcc
+                case 36: return DXGI_FORMAT_R16G16B16A16_UNORM;
+                case 111: return DXGI_FORMAT_R16_FLOAT;
+                case 112: return DXGI_FORMAT_R16G16_FLOAT;
+                case 113: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+                case 114: return DXGI_FORMAT_R32_FLOAT;
+                case 115: return DXGI_FORMAT_R32G32_FLOAT;
+                case 116: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+                default: return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+
+        auto has_masks = [&pixel_format](uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+        {
+            return pixel_format.r_bit_mask == r && pixel_format.g_bit_mask == g && pixel_format.b_bit_mask == b && pixel_format.a_bit_mask == a;
+        };
+        if ((pixel_format.flags & s_dds_pixel_rgb) && pixel_format.rgb_bit_count == 32)
+        {
+            if (has_masks(0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000)) return DXGI_FORMAT_R8G8B8A8_UNORM;
+            if (has_masks(0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000)) return DXGI_FORMAT_B8G8R8A8_UNORM;
+            if (has_masks(0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000)) return DXGI_FORMAT_B8G8R8X8_UNORM;
+        } else if ((pixel_format.flags & s_dds_pixel_rgb) && pixel_format.rgb_bit_count == 16)
+        {
+            if (has_masks(0xF800, 0x07E0, 0x001F, 0x0000)) return DXGI_FORMAT_B5G6R5_UNORM;
+        } else if ((pixel_format.flags & s_dds_pixel_luminance) && pixel_format.rgb_bit_count == 8)
+        {
+            if (has_masks(0xFF, 0, 0, 0)) return DXGI_FORMAT_R8_UNORM;
+        } else if ((pixel_format.flags & s_dds_pixel_alpha) && pixel_format.rgb_bit_count == 8)
+        {
+            return DXGI_FORMAT_A8_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    // Bytes of a 4 x 4 block, or of a texel when not block compressed, 0 for formats not laid out here
+    static std::pair<uint32_t, bool> get_element_byte_width(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+            case DXGI_FORMAT_BC1_TYPELESS: case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB:
+            case DXGI_FORMAT_BC4_TYPELESS: case DXGI_FORMAT_BC4_UNORM: case DXGI_FORMAT_BC4_SNORM:
+                return { 8, true };
+            case DXGI_FORMAT_BC2_TYPELESS: case DXGI_FORMAT_BC2_UNORM: case DXGI_FORMAT_BC2_UNORM_SRGB:
+            case DXGI_FORMAT_BC3_TYPELESS: case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB:
+            case DXGI_FORMAT_BC5_TYPELESS: case DXGI_FORMAT_BC5_UNORM: case DXGI_FORMAT_BC5_SNORM:
+            case DXGI_FORMAT_BC6H_TYPELESS: case DXGI_FORMAT_BC6H_UF16: case DXGI_FORMAT_BC6H_SF16:
+            case DXGI_FORMAT_BC7_TYPELESS: case DXGI_FORMAT_BC7_UNORM: case DXGI_FORMAT_BC7_UNORM_SRGB:
+                return { 16, true };
+            case DXGI_FORMAT_R32G32B32A32_TYPELESS: case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            case DXGI_FORMAT_R32G32B32A32_UINT: case DXGI_FORMAT_R32G32B32A32_SINT:
+                return { 16, false };
+            case DXGI_FORMAT_R32G32B32_TYPELESS: case DXGI_FORMAT_R32G32B32_FLOAT:
+            case DXGI_FORMAT_R32G32B32_UINT: case DXGI_FORMAT_R32G32B32_SINT:
+                return { 12, false };
+            case DXGI_FORMAT_R16G16B16A16_TYPELESS: case DXGI_FORMAT_R16G16B16A16_FLOAT: case DXGI_FORMAT_R16G16B16A16_UNORM:
+            case DXGI_FORMAT_R16G16B16A16_UINT: case DXGI_FORMAT_R16G16B16A16_SNORM: case DXGI_FORMAT_R16G16B16A16_SINT:
+            case DXGI_FORMAT_R32G32_TYPELESS: case DXGI_FORMAT_R32G32_FLOAT: case DXGI_FORMAT_R32G32_UINT: case DXGI_FORMAT_R32G32_SINT:
+                return { 8, false };
+            case DXGI_FORMAT_R10G10B10A2_TYPELESS: case DXGI_FORMAT_R10G10B10A2_UNORM: case DXGI_FORMAT_R10G10B10A2_UINT:
+            case DXGI_FORMAT_R11G11B10_FLOAT: case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+            case DXGI_FORMAT_R8G8B8A8_TYPELESS: case DXGI_FORMAT_R8G8B8A8_UNORM: case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_R8G8B8A8_UINT: case DXGI_FORMAT_R8G8B8A8_SNORM: case DXGI_FORMAT_R8G8B8A8_SINT:
+            case DXGI_FORMAT_B8G8R8A8_TYPELESS: case DXGI_FORMAT_B8G8R8A8_UNORM: case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8X8_TYPELESS: case DXGI_FORMAT_B8G8R8X8_UNORM: case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            case DXGI_FORMAT_R16G16_TYPELESS: case DXGI_FORMAT_R16G16_FLOAT: case DXGI_FORMAT_R16G16_UNORM:
+            case DXGI_FORMAT_R16G16_UINT: case DXGI_FORMAT_R16G16_SNORM: case DXGI_FORMAT_R16G16_SINT:
+            case DXGI_FORMAT_R32_TYPELESS: case DXGI_FORMAT_R32_FLOAT: case DXGI_FORMAT_R32_UINT: case DXGI_FORMAT_R32_SINT:
+                return { 4, false };
+            case DXGI_FORMAT_R8G8_TYPELESS: case DXGI_FORMAT_R8G8_UNORM: case DXGI_FORMAT_R8G8_UINT:
+            case DXGI_FORMAT_R8G8_SNORM: case DXGI_FORMAT_R8G8_SINT:
+            case DXGI_FORMAT_R16_TYPELESS: case DXGI_FORMAT_R16_FLOAT: case DXGI_FORMAT_R16_UNORM:
+            case DXGI_FORMAT_R16_UINT: case DXGI_FORMAT_R16_SNORM: case DXGI_FORMAT_R16_SINT:
+            case DXGI_FORMAT_B5G6R5_UNORM: case DXGI_FORMAT_B5G5R5A1_UNORM:
+                return { 2, false };
+            case DXGI_FORMAT_R8_TYPELESS: case DXGI_FORMAT_R8_UNORM: case DXGI_FORMAT_R8_UINT:
+            case DXGI_FORMAT_R8_SNORM: case DXGI_FORMAT_R8_SINT: case DXGI_FORMAT_A8_UNORM:
+                return { 1, false };
+            default:
+                return { 0, false };
+        }
+    }
+
+    uint32_t get_block_byte_width(DXGI_FORMAT format)
+    {
+        auto [element_byte_width, is_block_compressed] = get_element_byte_width(format);
+        return is_block_compressed ? element_byte_width : 0;
+    }
+
+    std::optional<DdsView> parse_dds(std::span<const uint8_t> bytes)
+    {
+        constexpr size_t header_byte_width = sizeof(uint32_t) + sizeof(DdsHeader);
+        if (bytes.size() < header_byte_width)
+        {
+            return std::nullopt;
+        }
+        uint32_t magic = 0;
+        DdsHeader header{};
+        std::memcpy(&magic, bytes.data(), sizeof(magic));
+        std::memcpy(&header, bytes.data() + sizeof(magic), sizeof(header));
+        if (magic != s_dds_magic || header.size != sizeof(DdsHeader) || header.pixel_format.size != sizeof(DdsPixelFormat))
+        {
+            return std::nullopt;
+        }
+
+        DdsView view{};
+        auto&& desc = view.desc;
+        size_t data_offset = header_byte_width;
+        bool is_dx10 = (header.pixel_format.flags & s_dds_pixel_fourcc) && header.pixel_format.fourcc == s_dds_fourcc_dx10;
+        if (is_dx10)
+        {
+            DdsHeaderDx10 header_dx10{};
+            if (bytes.size() < s_dds_data_offset)
+            {
+                return std::nullopt;
+            }
+            std::memcpy(&header_dx10, bytes.data() + header_byte_width, sizeof(header_dx10));
+            data_offset = s_dds_data_offset;
+            if (header_dx10.resource_dimension != 3 || header_dx10.array_size == 0 || header_dx10.array_size > s_max_array_size)
+            {
+                return std::nullopt;
+            }
+            desc.format = static_cast<DXGI_FORMAT>(header_dx10.dxgi_format);
+            desc.is_cube = (header_dx10.misc_flag & s_dds_misc_texture_cube) != 0;
+            desc.array_size = header_dx10.array_size * (desc.is_cube ? 6 : 1);
+        } else
+        {
+            // Legacy cube stores all six faces or is not loaded, volume texture is not handled
+            if ((header.caps2 & s_dds_caps2_volume) || ((header.caps2 & s_dds_caps2_cubemap) != 0 && (header.caps2 & s_dds_caps2_cubemap) != s_dds_caps2_cubemap))
+            {
+                return std::nullopt;
+            }
+            desc.format = get_legacy_format(header.pixel_format);
+            desc.is_cube = (header.caps2 & s_dds_caps2_cubemap) == s_dds_caps2_cubemap;
+            desc.array_size = desc.is_cube ? 6 : 1;
+        }
+
+        // Tools leave mip count 0 for a single level
+        desc.width = header.width;
+        desc.height = header.height;
+        desc.mip_count = std::max(header.mip_map_count, 1u);
+        desc.pitch_or_linear_size = header.pitch_or_linear_size;
+        auto [element_byte_width, is_block_compressed] = get_element_byte_width(desc.format);
+        if (element_byte_width == 0 || desc.width == 0 || desc.height == 0 || desc.width > s_max_dimension || desc.height > s_max_dimension ||
+            desc.array_size > s_max_array_size || desc.mip_count > get_mip_count(desc.width, desc.height) ||
+            (desc.is_cube && desc.width != desc.height))
+        {
+            return std::nullopt;
+        }
+
+        view.subresources.reserve(static_cast<size_t>(desc.mip_count) * desc.array_size);
+        std::span<const uint8_t> data = bytes.subspan(data_offset);
+        size_t offset = 0;
+        for (uint32_t slice = 0; slice < desc.array_size; ++slice)
+        {
+            for (uint32_t mip = 0; mip < desc.mip_count; ++mip)
+            {
+                uint32_t width = std::max(desc.width >> mip, 1u);
+                uint32_t height = std::max(desc.height >> mip, 1u);
+                uint32_t row_count = is_block_compressed ? (height + 3) / 4 : height;
+                uint32_t row_pitch = (is_block_compressed ? (width + 3) / 4 : width) * element_byte_width;
+                uint64_t slice_pitch = static_cast<uint64_t>(row_pitch) * row_count;
+                if (slice_pitch > std::numeric_limits<uint32_t>::max() || data.size() - offset < slice_pitch)
+                {
+                    return std::nullopt;
+                }
+                view.subresources.push_back({ data.subspan(offset, slice_pitch), row_pitch, static_cast<uint32_t>(slice_pitch) });
+                offset += slice_pitch;
+            }
+        }
+        return view;
+    }
+
+    std::optional<DdsFile> read_dds_file(const std::filesystem::path& file_path)
+    {
+        MappedFile file{ file_path };
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+        auto view = parse_dds(file.bytes());
+        if (!view)
+        {
+            DX_CORE_WARN("DDS file {} is malformed or truncated", file_path.string());
+            return std::nullopt;
+        }
+
+        // Subresources are contiguous, trailing bytes of file are left out
+        auto&& last = view->subresources.back().bytes;
+        auto&& first = view->subresources.front().bytes;
+        return DdsFile{ view->desc, std::vector<uint8_t>(first.data(), last.data() + last.size()) };
+    }
+
+    bool write_dds_file(const std::filesystem::path& file_path, const DdsDesc& desc, std::span<const uint8_t> data)
+    {
+        std::error_code error_code{};
+        std::filesystem::create_directories(file_path.parent_path(), error_code);
+
+        DdsHeader header{};
+        header.width = desc.width;
+        header.height = desc.height;
+        header.mip_map_count = desc.mip_count;
+        header.pitch_or_linear_size = desc.pitch_or_linear_size;
+        DdsHeaderDx10 header_dx10{};
+        header_dx10.dxgi_format = static_cast<uint32_t>(desc.format);
+        header_dx10.array_size = desc.is_cube ? desc.array_size / 6 : desc.array_size;
+        if (desc.is_cube)
+        {
+            header.caps2 = s_dds_caps2_cubemap;
+            header_dx10.misc_flag = s_dds_misc_texture_cube;
+        }
+
+        std::filesystem::path temp_path = file_path;
+        temp_path += ".tmp";
+        {
+            std::ofstream file_stream(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file_stream.is_open())
+            {
+                return false;
+            }
+            file_stream.write(reinterpret_cast<const char*>(&s_dds_magic), sizeof(s_dds_magic));
+            file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file_stream.write(reinterpret_cast<const char*>(&header_dx10), sizeof(header_dx10));
+            file_stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file_stream.good())
+            {
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp_path, file_path, error_code);
+        return !error_code;
+    }
+}
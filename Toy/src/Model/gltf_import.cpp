@@ -0,0 +1,808 @@
+//
+// Created by ZZK on 2024/4/8.
+//
+
+#include <Toy/Model/gltf_import.h>
+#include <Toy/Model/mesh_cache.h>
+#include <Toy/Model/mesh_optimizer.h>
+#include <Toy/Model/texture_streaming.h>
+#include <Toy/Core/virtual_file_system.h>
+#include <Toy/Core/json.h>
+#include <Toy/Core/parallel.h>
+
+namespace toy::model
+{
+    static constexpr uint32_t s_glb_magic = 0x46546C67;              // "glTF"
+    static constexpr uint32_t s_glb_chunk_json = 0x4E4F534A;         // "JSON"
+    static constexpr uint32_t s_glb_chunk_bin = 0x004E4942;          // "BIN\0"
+
+    static constexpr uint32_t s_gltf_byte = 5120;
+    static constexpr uint32_t s_gltf_unsigned_byte = 5121;
+    static constexpr uint32_t s_gltf_short = 5122;
+    static constexpr uint32_t s_gltf_unsigned_short = 5123;
+    static constexpr uint32_t s_gltf_unsigned_int = 5125;
+    static constexpr uint32_t s_gltf_float = 5126;
+
+    static constexpr int64_t s_gltf_mode_triangles = 4;
+    static constexpr int64_t s_gltf_mode_triangle_strip = 5;
+    static constexpr int64_t s_gltf_mode_triangle_fan = 6;
+
+    // Extensions that only add data ignored here, or are covered by generic accessor conversion
+    static constexpr std::array<std::string_view, 3> s_supported_required_extensions{
+        "KHR_mesh_quantization",
+        "KHR_texture_transform",
+        "KHR_materials_emissive_strength",
+    };
+
+    static uint32_t component_size(uint32_t component_type)
+    {
+        switch (component_type)
+        {
+            case s_gltf_byte:
+            case s_gltf_unsigned_byte: return 1;
+            case s_gltf_short:
+            case s_gltf_unsigned_short: return 2;
+            case s_gltf_unsigned_int:
+            case s_gltf_float: return 4;
+            default: return 0;
+        }
+    }
+
+    static uint32_t component_count(std::string_view type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0;
+    }
+
+    template<typename T>
+    static T load_unaligned(const uint8_t* src)
+    {
+        T value{};
+        std::memcpy(&value, src, sizeof(T));
+        return value;
+    }
+
+    static float read_component(const uint8_t* src, uint32_t component_type, bool normalized)
+    {
+        switch (component_type)
+        {
+            case s_gltf_byte:
+            {
+                auto value = static_cast<float>(load_unaligned<int8_t>(src));
+                return normalized ? std::max(value / 127.0f, -1.0f) : value;
+            }
+            case s_gltf_unsigned_byte:
+            {
+                auto value = static_cast<float>(load_unaligned<uint8_t>(src));
+                return normalized ? value / 255.0f : value;
+            }
+            case s_gltf_short:
+            {
+                auto value = static_cast<float>(load_unaligned<int16_t>(src));
+                return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+            }
+            case s_gltf_unsigned_short:
+            {
+                auto value = static_cast<float>(load_unaligned<uint16_t>(src));
+                return normalized ? value / 65535.0f : value;
+            }
+            case s_gltf_unsigned_int: return static_cast<float>(load_unaligned<uint32_t>(src));
+            case s_gltf_float: return load_unaligned<float>(src);
+            default: return 0.0f;
+        }
+    }
+
+    static std::string percent_decode(std::string_view uri)
+    {
+        std::string result{};
+        result.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size())
+            {
+                char hex[3] = { uri[i + 1], uri[i + 2], '\0' };
+                char* end_str = nullptr;
+                auto value = std::strtol(hex, &end_str, 16);
+                if (end_str == hex + 2)
+                {
+                    result += static_cast<char>(value);
+                    i += 2;
+                    continue;
+                }
+            }
+            result += uri[i];
+        }
+        return result;
+    }
+
+    // Decode "data:...;base64," URI, return false if uri is not a base64 data URI
+    static bool decode_data_uri(std::string_view uri, std::vector<uint8_t>& bytes)
+    {
+        if (!uri.starts_with("data:"))
+        {
+            return false;
+        }
+        size_t comma = uri.find(',');
+        if (comma == std::string_view::npos || uri.substr(0, comma).find(";base64") == std::string_view::npos)
+        {
+            return false;
+        }
+
+        auto decode_char = [](char c) -> int32_t
+        {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        };
+
+        bytes.clear();
+        bytes.reserve((uri.size() - comma) / 4 * 3);
+        uint32_t accumulator = 0;
+        int32_t bits = 0;
+        for (char c : uri.substr(comma + 1))
+        {
+            int32_t value = decode_char(c);
+            if (value < 0)
+            {
+                continue;
+            }
+            accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                bytes.push_back(static_cast<uint8_t>((accumulator >> bits) & 0xFF));
+            }
+        }
+        return true;
+    }
+
+    struct GltfAccessorView
+    {
+        const uint8_t* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        uint32_t component_type = 0;
+        uint32_t component_count = 0;
+        bool normalized = false;
+
+        // Tightly packed float elements of N components can be handed to buffer creation as is
+        [[nodiscard]] bool is_packed_float(uint32_t components) const
+        {
+            return component_type == s_gltf_float && component_count == components && stride == components * sizeof(float);
+        }
+
+        // Read element into float array, missing components are left untouched
+        void read(size_t index, float* dst, uint32_t dst_components) const
+        {
+            uint32_t size = component_size(component_type);
+            const uint8_t* src = data + index * stride;
+            for (uint32_t c = 0; c < std::min(component_count, dst_components); ++c)
+            {
+                dst[c] = read_component(src + c * size, component_type, normalized);
+            }
+        }
+
+        [[nodiscard]] uint32_t read_index(size_t index) const
+        {
+            const uint8_t* src = data + index * stride;
+            switch (component_type)
+            {
+                case s_gltf_unsigned_byte: return load_unaligned<uint8_t>(src);
+                case s_gltf_unsigned_short: return load_unaligned<uint16_t>(src);
+                default: return load_unaligned<uint32_t>(src);
+            }
+        }
+    };
+
+    class GltfDocument
+    {
+    public:
+        bool open(std::string_view file_name)
+        {
+            m_file_name = file_name;
+            m_base_dir = std::filesystem::path(file_name).parent_path();
+            m_file = VirtualFileSystem::get().open(std::filesystem::path(file_name));
+            if (!m_file.is_open() || m_file.size() == 0)
+            {
+                DX_CORE_WARN("Fail to open glTF file '{}'", file_name);
+                return false;
+            }
+
+            // Binary container, JSON chunk followed by optional BIN chunk
+            std::string_view json_text{};
+            if (m_file.size() >= 12 && load_unaligned<uint32_t>(m_file.data()) == s_glb_magic)
+            {
+                size_t offset = 12;
+                while (offset + 8 <= m_file.size())
+                {
+                    uint32_t chunk_length = load_unaligned<uint32_t>(m_file.data() + offset);
+                    uint32_t chunk_type = load_unaligned<uint32_t>(m_file.data() + offset + 4);
+                    offset += 8;
+                    if (chunk_length > m_file.size() - offset)
+                    {
+                        DX_CORE_WARN("glTF binary '{}' has truncated chunk", file_name);
+                        return false;
+                    }
+                    if (chunk_type == s_glb_chunk_json && json_text.empty())
+                    {
+                        json_text = { reinterpret_cast<const char *>(m_file.data() + offset), chunk_length };
+                    } else if (chunk_type == s_glb_chunk_bin && m_glb_bin.empty())
+                    {
+                        m_glb_bin = { m_file.data() + offset, chunk_length };
+                    }
+                    // Chunks are 4-byte aligned
+                    offset += (chunk_length + 3) & ~3u;
+                }
+            } else
+            {
+                json_text = { reinterpret_cast<const char *>(m_file.data()), m_file.size() };
+            }
+
+            std::string error{};
+            if (!json::parse(json_text, m_root, &error))
+            {
+                DX_CORE_WARN("Fail to parse glTF '{}': {}", file_name, error);
+                return false;
+            }
+
+            for (auto&& extension : m_root["extensionsRequired"].array())
+            {
+                if (std::find(s_supported_required_extensions.begin(), s_supported_required_extensions.end(), extension.as_string()) ==
+                    s_supported_required_extensions.end())
+                {
+                    DX_CORE_INFO("glTF '{}' requires unsupported extension {}", file_name, extension.as_string());
+                    return false;
+                }
+            }
+
+            return load_buffers();
+        }
+
+        [[nodiscard]] const json::Value& root() const { return m_root; }
+        [[nodiscard]] const std::string& file_name() const { return m_file_name; }
+        [[nodiscard]] const std::filesystem::path& base_dir() const { return m_base_dir; }
+
+        // Byte range of buffer view, empty if out of range
+        [[nodiscard]] std::span<const uint8_t> get_buffer_view(const json::Value& buffer_view) const
+        {
+            auto buffer_index = static_cast<size_t>(buffer_view["buffer"].as_integer(-1));
+            if (buffer_index >= m_buffers.size())
+            {
+                return {};
+            }
+            auto&& buffer = m_buffers[buffer_index];
+            auto offset = static_cast<size_t>(buffer_view["byteOffset"].as_integer(0));
+            auto length = static_cast<size_t>(buffer_view["byteLength"].as_integer(0));
+            if (offset > buffer.size() || length > buffer.size() - offset)
+            {
+                return {};
+            }
+            return buffer.subspan(offset, length);
+        }
+
+        bool get_accessor(int64_t accessor_index, GltfAccessorView& view) const
+        {
+            auto&& accessor = m_root["accessors"][static_cast<size_t>(accessor_index)];
+            if (!accessor.is_object() || accessor.contains("sparse") || !accessor.contains("bufferView"))
+            {
+                return false;
+            }
+
+            view.component_type = static_cast<uint32_t>(accessor["componentType"].as_integer());
+            view.component_count = component_count(accessor["type"].as_string());
+            view.count = static_cast<size_t>(accessor["count"].as_integer());
+            view.normalized = accessor["normalized"].as_boolean();
+            uint32_t element_size = component_size(view.component_type) * view.component_count;
+            if (element_size == 0)
+            {
+                return false;
+            }
+
+            auto&& buffer_view = m_root["bufferViews"][static_cast<size_t>(accessor["bufferView"].as_integer(-1))];
+            auto bytes = get_buffer_view(buffer_view);
+            auto offset = static_cast<size_t>(accessor["byteOffset"].as_integer(0));
+            view.stride = static_cast<size_t>(buffer_view["byteStride"].as_integer(element_size));
+            if (view.count == 0 || offset > bytes.size() ||
+                (view.count - 1) * view.stride + element_size > bytes.size() - offset)
+            {
+                return false;
+            }
+            view.data = bytes.data() + offset;
+            return true;
+        }
+
+    private:
+        bool load_buffers()
+        {
+            auto&& buffers = m_root["buffers"].array();
+            m_buffers.resize(buffers.size());
+            m_mapped_buffers.resize(buffers.size());
+            m_decoded_buffers.resize(buffers.size());
+            for (size_t i = 0; i < buffers.size(); ++i)
+            {
+                auto&& buffer = buffers[i];
+                auto byte_length = static_cast<size_t>(buffer["byteLength"].as_integer());
+                std::string_view uri = buffer["uri"].as_string();
+                if (uri.empty())
+                {
+                    // GLB-stored buffer
+                    m_buffers[i] = m_glb_bin;
+                } else if (decode_data_uri(uri, m_decoded_buffers[i]))
+                {
+                    m_buffers[i] = m_decoded_buffers[i];
+                } else
+                {
+                    // External buffer, accessors point straight into mapped file or asset pack
+                    std::filesystem::path buffer_path = m_base_dir / percent_decode(uri);
+                    m_mapped_buffers[i] = VirtualFileSystem::get().open(buffer_path);
+                    if (!m_mapped_buffers[i].is_open())
+                    {
+                        DX_CORE_WARN("Fail to open glTF buffer '{}'", buffer_path.string());
+                        return false;
+                    }
+                    m_buffers[i] = m_mapped_buffers[i].bytes();
+                }
+
+                if (m_buffers[i].size() < byte_length)
+                {
+                    DX_CORE_WARN("glTF buffer {} of '{}' is smaller than declared", i, m_file_name);
+                    return false;
+                }
+                m_buffers[i] = m_buffers[i].first(byte_length);
+            }
+            return true;
+        }
+
+    private:
+        std::string m_file_name;
+        std::filesystem::path m_base_dir;
+        json::Value m_root;
+        VirtualFile m_file;
+        std::span<const uint8_t> m_glb_bin;
+        std::vector<VirtualFile> m_mapped_buffers;
+        std::vector<std::vector<uint8_t>> m_decoded_buffers;
+        std::vector<std::span<const uint8_t>> m_buffers;
+    };
+
+    // Primitive converted into engine layout, texture coordinates point into glTF buffers until primitive is optimised
+    struct GltfPrimitive
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT4> tangents;
+        std::vector<DirectX::XMFLOAT4> bitangents;
+        std::vector<std::span<const DirectX::XMFLOAT2>> texcoords;
+        std::vector<std::vector<DirectX::XMFLOAT2>> converted_texcoords;
+        std::vector<uint32_t> indices;
+        uint32_t material_index = 0;
+        float uv_density = 0.0f;
+        MeshStatistics statistics_before;
+        MeshStatistics statistics_after;
+    };
+
+    static bool convert_primitive(const GltfDocument& document, const json::Value& primitive, GltfPrimitive& result)
+    {
+        using namespace DirectX;
+        auto&& attributes = primitive["attributes"];
+
+        // Position, flip z to left-handed as aiProcess_ConvertToLeftHanded does
+        GltfAccessorView position_view{};
+        if (!document.get_accessor(attributes["POSITION"].as_integer(-1), position_view))
+        {
+            return false;
+        }
+        size_t num_vertices = position_view.count;
+        result.positions.resize(num_vertices);
+        for (size_t i = 0; i < num_vertices; ++i)
+        {
+            position_view.read(i, &result.positions[i].x, 3);
+            result.positions[i].z = -result.positions[i].z;
+        }
+
+        // Normal
+        GltfAccessorView normal_view{};
+        if (attributes.contains("NORMAL"))
+        {
+            if (!document.get_accessor(attributes["NORMAL"].as_integer(-1), normal_view) || normal_view.count != num_vertices)
+            {
+                return false;
+            }
+            result.normals.resize(num_vertices);
+            for (size_t i = 0; i < num_vertices; ++i)
+            {
+                normal_view.read(i, &result.normals[i].x, 3);
+                result.normals[i].z = -result.normals[i].z;
+            }
+        }
+
+        // Texture coordinates, glTF origin is top-left as in Direct3D, so uv is kept as is
+        // Note: tightly packed float2 coordinates are uploaded straight from the glTF buffer
+        for (uint32_t set = 0; set < mesh_cache_max_texcoords; ++set)
+        {
+            std::string attribute_name = "TEXCOORD_" + std::to_string(set);
+            if (!attributes.contains(attribute_name))
+            {
+                break;
+            }
+            GltfAccessorView uv_view{};
+            if (!document.get_accessor(attributes[attribute_name].as_integer(-1), uv_view) || uv_view.count != num_vertices)
+            {
+                return false;
+            }
+            if (uv_view.is_packed_float(2) && reinterpret_cast<uintptr_t>(uv_view.data) % alignof(float) == 0)
+            {
+                result.texcoords.emplace_back(reinterpret_cast<const XMFLOAT2 *>(uv_view.data), num_vertices);
+            } else
+            {
+                auto&& uvs = result.converted_texcoords.emplace_back(num_vertices);
+                for (size_t i = 0; i < num_vertices; ++i)
+                {
+                    uv_view.read(i, &uvs[i].x, 2);
+                }
+                result.texcoords.emplace_back(uvs);
+            }
+        }
+
+        // Index, strips and fans are converted into lists, then winding order is flipped for left-handed
+        std::vector<uint32_t> source_indices{};
+        if (primitive.contains("indices"))
+        {
+            GltfAccessorView index_view{};
+            if (!document.get_accessor(primitive["indices"].as_integer(-1), index_view) || index_view.component_count != 1)
+            {
+                return false;
+            }
+            source_indices.resize(index_view.count);
+            for (size_t i = 0; i < index_view.count; ++i)
+            {
+                source_indices[i] = index_view.read_index(i);
+                if (source_indices[i] >= num_vertices)
+                {
+                    return false;
+                }
+            }
+        } else
+        {
+            source_indices.resize(num_vertices);
+            std::iota(source_indices.begin(), source_indices.end(), 0u);
+        }
+
+        int64_t mode = primitive["mode"].as_integer(s_gltf_mode_triangles);
+        auto add_triangle = [&result](uint32_t i0, uint32_t i1, uint32_t i2)
+        {
+            result.indices.push_back(i2);
+            result.indices.push_back(i1);
+            result.indices.push_back(i0);
+        };
+        if (mode == s_gltf_mode_triangles)
+        {
+            result.indices.reserve(source_indices.size());
+            for (size_t i = 0; i + 2 < source_indices.size(); i += 3)
+            {
+                add_triangle(source_indices[i], source_indices[i + 1], source_indices[i + 2]);
+            }
+        } else if (mode == s_gltf_mode_triangle_strip)
+        {
+            for (size_t i = 0; i + 2 < source_indices.size(); ++i)
+            {
+                if (i % 2 == 0)
+                {
+                    add_triangle(source_indices[i], source_indices[i + 1], source_indices[i + 2]);
+                } else
+                {
+                    add_triangle(source_indices[i + 1], source_indices[i], source_indices[i + 2]);
+                }
+            }
+        } else
+        {
+            for (size_t i = 1; i + 1 < source_indices.size(); ++i)
+            {
+                add_triangle(source_indices[0], source_indices[i], source_indices[i + 1]);
+            }
+        }
+
+        // Tangent and bitangent, bitangent = cross(normal, tangent) * w evaluated in right-handed space as Assimp does
+        if (attributes.contains("TANGENT") && !result.normals.empty())
+        {
+            GltfAccessorView tangent_view{};
+            if (!document.get_accessor(attributes["TANGENT"].as_integer(-1), tangent_view) || tangent_view.count != num_vertices)
+            {
+                return false;
+            }
+            result.tangents.resize(num_vertices);
+            result.bitangents.resize(num_vertices);
+            for (size_t i = 0; i < num_vertices; ++i)
+            {
+                XMFLOAT4 tangent{ 0.0f, 0.0f, 0.0f, 1.0f };
+                tangent_view.read(i, &tangent.x, 4);
+                XMFLOAT3 normal = result.normals[i];
+                normal.z = -normal.z;
+                XMVECTOR bitangent = XMVectorScale(XMVector3Cross(XMLoadFloat3(&normal), XMLoadFloat4(&tangent)), tangent.w);
+
+                result.tangents[i] = XMFLOAT4{ tangent.x, tangent.y, -tangent.z, 1.0f };
+                XMStoreFloat4(&result.bitangents[i], bitangent);
+                result.bitangents[i].z = -result.bitangents[i].z;
+                result.bitangents[i].w = 1.0f;
+            }
+        }
+        // Compute from uv derivatives as aiProcess_CalcTangentSpace does
+        else if (!result.normals.empty() && !result.texcoords.empty())
+        {
+            auto&& uvs = result.texcoords[0];
+            std::vector<XMFLOAT3> tangent_sum(num_vertices, XMFLOAT3{});
+            std::vector<XMFLOAT3> bitangent_sum(num_vertices, XMFLOAT3{});
+            for (size_t face = 0; face + 2 < result.indices.size(); face += 3)
+            {
+                uint32_t i0 = result.indices[face], i1 = result.indices[face + 1], i2 = result.indices[face + 2];
+                XMVECTOR p0 = XMLoadFloat3(&result.positions[i0]);
+                XMVECTOR edge1 = XMVectorSubtract(XMLoadFloat3(&result.positions[i1]), p0);
+                XMVECTOR edge2 = XMVectorSubtract(XMLoadFloat3(&result.positions[i2]), p0);
+                float du1 = uvs[i1].x - uvs[i0].x, dv1 = uvs[i1].y - uvs[i0].y;
+                float du2 = uvs[i2].x - uvs[i0].x, dv2 = uvs[i2].y - uvs[i0].y;
+                float det = du1 * dv2 - du2 * dv1;
+                if (std::abs(det) < 1e-12f)
+                {
+                    continue;
+                }
+                float inv_det = 1.0f / det;
+                XMVECTOR tangent = XMVectorScale(XMVectorSubtract(XMVectorScale(edge1, dv2), XMVectorScale(edge2, dv1)), inv_det);
+                XMVECTOR bitangent = XMVectorScale(XMVectorSubtract(XMVectorScale(edge2, du1), XMVectorScale(edge1, du2)), inv_det);
+                for (uint32_t index : { i0, i1, i2 })
+                {
+                    XMStoreFloat3(&tangent_sum[index], XMVectorAdd(XMLoadFloat3(&tangent_sum[index]), tangent));
+                    XMStoreFloat3(&bitangent_sum[index], XMVectorAdd(XMLoadFloat3(&bitangent_sum[index]), bitangent));
+                }
+            }
+
+            result.tangents.resize(num_vertices);
+            result.bitangents.resize(num_vertices);
+            for (size_t i = 0; i < num_vertices; ++i)
+            {
+                // Gram-Schmidt orthogonalize against normal
+                XMVECTOR normal = XMLoadFloat3(&result.normals[i]);
+                XMVECTOR tangent = XMLoadFloat3(&tangent_sum[i]);
+                tangent = XMVector3Normalize(XMVectorSubtract(tangent, XMVectorScale(normal, XMVectorGetX(XMVector3Dot(normal, tangent)))));
+                XMVECTOR bitangent = XMVector3Normalize(XMLoadFloat3(&bitangent_sum[i]));
+                XMStoreFloat4(&result.tangents[i], XMVectorSetW(tangent, 1.0f));
+                XMStoreFloat4(&result.bitangents[i], XMVectorSetW(bitangent, 1.0f));
+            }
+        }
+
+        return true;
+    }
+
+    // Weld converted primitive and reorder for vertex cache, overdraw and vertex fetch
+    // Remapped texture coordinates are always owned, primitive no longer points into glTF buffers
+    static void optimize_primitive(GltfPrimitive& primitive)
+    {
+        using namespace DirectX;
+        std::vector<VertexStreamView> attributes{};
+        if (!primitive.normals.empty())
+        {
+            attributes.push_back(make_stream_view<XMFLOAT3>(primitive.normals));
+        }
+        if (!primitive.tangents.empty())
+        {
+            attributes.push_back(make_stream_view<XMFLOAT4>(primitive.tangents));
+            attributes.push_back(make_stream_view<XMFLOAT4>(primitive.bitangents));
+        }
+        for (auto&& uvs : primitive.texcoords)
+        {
+            attributes.push_back(make_stream_view(uvs));
+        }
+
+        primitive.statistics_before = analyze_mesh(primitive.indices, primitive.positions);
+        auto remap = optimize_mesh(primitive.indices, primitive.positions, attributes);
+        primitive.positions = remap_vertex_stream<XMFLOAT3>(primitive.positions, remap);
+        primitive.normals = remap_vertex_stream<XMFLOAT3>(primitive.normals, remap);
+        primitive.tangents = remap_vertex_stream<XMFLOAT4>(primitive.tangents, remap);
+        primitive.bitangents = remap_vertex_stream<XMFLOAT4>(primitive.bitangents, remap);
+
+        std::vector<std::vector<XMFLOAT2>> texcoords{};
+        for (auto&& uvs : primitive.texcoords)
+        {
+            texcoords.push_back(remap_vertex_stream(uvs, remap));
+        }
+        primitive.converted_texcoords = std::move(texcoords);
+        primitive.texcoords.assign(primitive.converted_texcoords.begin(), primitive.converted_texcoords.end());
+        primitive.statistics_after = analyze_mesh(primitive.indices, primitive.positions);
+        if (!primitive.texcoords.empty())
+        {
+            primitive.uv_density = compute_uv_density(primitive.indices, primitive.positions, primitive.texcoords[0]);
+        }
+    }
+
+    // Textures are only collected into texture_sources, data URI images are decoded into decoded_images which must outlive creation
+    static void convert_material(const GltfDocument& document, const json::Value& gltf_material, Material& material,
+                                 std::vector<TextureSource>& texture_sources, std::deque<std::vector<uint8_t>>& decoded_images)
+    {
+        using namespace DirectX;
+        auto&& pbr = gltf_material["pbrMetallicRoughness"];
+
+        // Base color factor is what Assimp exposes as diffuse color
+        auto&& base_color = pbr["baseColorFactor"];
+        XMFLOAT4 diffuse_color{ base_color[0].as_float(1.0f), base_color[1].as_float(1.0f),
+                                base_color[2].as_float(1.0f), base_color[3].as_float(1.0f) };
+        material.set_color(MaterialSemantics::DiffuseColor, diffuse_color);
+        material.set_scalar(MaterialSemantics::Opacity, diffuse_color.w);
+
+        auto&& emissive = gltf_material["emissiveFactor"];
+        material.set("$EmissiveColor"_xid, XMFLOAT4{ emissive[0].as_float(), emissive[1].as_float(), emissive[2].as_float(), 1.0f });
+
+        auto try_create_texture = [&document, &material, &texture_sources, &decoded_images](const json::Value& texture_info, std::span<const MaterialSemantics> semantics_list,
+                                                                            bool gen_mips = false, uint32_t force_SRGB = 0)
+        {
+            if (!texture_info.is_object())
+            {
+                return;
+            }
+            auto&& root = document.root();
+            auto&& texture = root["textures"][static_cast<size_t>(texture_info["index"].as_integer(-1))];
+            auto image_index = static_cast<size_t>(texture["source"].as_integer(-1));
+            auto&& image = root["images"][image_index];
+            if (!image.is_object())
+            {
+                return;
+            }
+
+            std::string tex_name{};
+            std::string_view uri = image["uri"].as_string();
+            std::vector<uint8_t> decoded_bytes{};
+            if (image.contains("bufferView") || decode_data_uri(uri, decoded_bytes))
+            {
+                // Embedded image, named as Assimp names embedded textures
+                tex_name = fmt::format("{}*{}", document.file_name(), image_index);
+                std::span<const uint8_t> bytes = decoded_bytes;
+                if (image.contains("bufferView"))
+                {
+                    bytes = document.get_buffer_view(root["bufferViews"][static_cast<size_t>(image["bufferView"].as_integer(-1))]);
+                }
+                if (bytes.empty())
+                {
+                    return;
+                }
+                if (!decoded_bytes.empty())
+                {
+                    bytes = decoded_images.emplace_back(std::move(decoded_bytes));
+                }
+                texture_sources.push_back({ tex_name, bytes, gen_mips, force_SRGB, get_texture_usage(semantics_list.front()) });
+            } else if (!uri.empty())
+            {
+                tex_name = (document.base_dir() / percent_decode(uri)).string();
+                texture_sources.push_back({ tex_name, {}, gen_mips, force_SRGB, get_texture_usage(semantics_list.front()) });
+            } else
+            {
+                return;
+            }
+
+            for (auto semantics : semantics_list)
+            {
+                material.set_texture(semantics, string_to_id(tex_name));
+            }
+        };
+
+        // Same texture mapping as Assimp glTF importer: base color feeds diffuse and base color slots
+        // Note: metallic-roughness texture packs roughness in G and metalness in B, Assimp does not map it either
+        static constexpr std::array s_base_color_semantics{ MaterialSemantics::DiffuseMap, MaterialSemantics::AlbedoMap };
+        static constexpr std::array s_normal_semantics{ MaterialSemantics::NormalMap };
+        try_create_texture(pbr["baseColorTexture"], s_base_color_semantics, true, 1);
+        try_create_texture(gltf_material["normalTexture"], s_normal_semantics);
+    }
+
+    static void set_default_material(Material& material)
+    {
+        if (!material.has(MaterialSemantics::DiffuseColor))
+        {
+            material.set_color(MaterialSemantics::DiffuseColor, DirectX::XMFLOAT4{ 0.8f, 0.8f, 0.8f, 1.0f });
+        }
+        if (!material.has(MaterialSemantics::Opacity))
+        {
+            material.set_scalar(MaterialSemantics::Opacity, 1.0f);
+        }
+        material.set_scalar(MaterialSemantics::Metalness, 0.5f);
+        material.set_scalar(MaterialSemantics::Roughness, 0.5f);
+        material.bake();
+    }
+
+    bool import_gltf(std::string_view file_name, GltfModel& model)
+    {
+        using namespace DirectX;
+        auto document = std::make_shared<GltfDocument>();
+        if (!document->open(file_name))
+        {
+            return false;
+        }
+        auto&& root = document->root();
+
+        // Convert every primitive before anything is kept, so that unsupported files fall back cleanly
+        std::vector<GltfPrimitive> primitives{};
+        auto num_materials = static_cast<uint32_t>(root["materials"].size());
+        bool need_default_material = false;
+        for (auto&& gltf_mesh : root["meshes"].array())
+        {
+            for (auto&& primitive : gltf_mesh["primitives"].array())
+            {
+                // Points and lines are removed, as aiProcess_SortByPType with AI_CONFIG_PP_SBP_REMOVE does
+                int64_t mode = primitive["mode"].as_integer(s_gltf_mode_triangles);
+                if (mode != s_gltf_mode_triangles && mode != s_gltf_mode_triangle_strip && mode != s_gltf_mode_triangle_fan)
+                {
+                    continue;
+                }
+
+                auto&& result = primitives.emplace_back();
+                if (!convert_primitive(*document, primitive, result))
+                {
+                    DX_CORE_INFO("glTF '{}' has primitive not supported by native loader", file_name);
+                    return false;
+                }
+                int64_t material_index = primitive["material"].as_integer(-1);
+                if (material_index < 0 || material_index >= num_materials)
+                {
+                    need_default_material = true;
+                    result.material_index = num_materials;
+                } else
+                {
+                    result.material_index = static_cast<uint32_t>(material_index);
+                }
+            }
+        }
+        if (primitives.empty())
+        {
+            return false;
+        }
+
+        // Primitives are independent, optimise them on worker threads
+        parallel_for(primitives.size(), [&primitives](size_t i) { optimize_primitive(primitives[i]); });
+        MeshStatistics statistics_before{};
+        MeshStatistics statistics_after{};
+        for (auto&& primitive : primitives)
+        {
+            statistics_before += primitive.statistics_before;
+            statistics_after += primitive.statistics_after;
+        }
+        log_mesh_statistics(file_name, statistics_before, statistics_after);
+
+        model = GltfModel{};
+        model.meshes.reserve(primitives.size());
+        for (size_t i = 0; i < primitives.size(); ++i)
+        {
+            auto&& primitive = primitives[i];
+            auto&& mesh = model.meshes.emplace_back();
+            BoundingBox::CreateFromPoints(mesh.bounding_box, primitive.positions.size(), primitive.positions.data(), sizeof(XMFLOAT3));
+            if (i == 0)
+            {
+                model.bounding_box = mesh.bounding_box;
+            } else
+            {
+                BoundingBox::CreateMerged(model.bounding_box, model.bounding_box, mesh.bounding_box);
+            }
+            mesh.positions = std::move(primitive.positions);
+            mesh.normals = std::move(primitive.normals);
+            mesh.tangents = std::move(primitive.tangents);
+            mesh.bitangents = std::move(primitive.bitangents);
+            mesh.texcoords = std::move(primitive.converted_texcoords);
+            mesh.indices = std::move(primitive.indices);
+            mesh.material_index = primitive.material_index;
+            mesh.uv_density = primitive.uv_density;
+        }
+
+        model.materials.resize(num_materials + (need_default_material ? 1 : 0));
+        for (uint32_t i = 0; i < num_materials; ++i)
+        {
+            convert_material(*document, root["materials"][i], model.materials[i], model.texture_sources, model.decoded_images);
+        }
+        for (auto&& material : model.materials)
+        {
+            set_default_material(material);
+        }
+        model.document = std::move(document);
+        return true;
+    }
+}
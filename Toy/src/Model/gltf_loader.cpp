@@ -0,0 +1,128 @@
+//
+// Created by ZZK on 2024/4/8.
+//
+
+#include <Toy/Model/gltf_loader.h>
+#include <Toy/Model/gltf_import.h>
+#include <Toy/Model/model_manager.h>
+#include <Toy/Model/texture_manager.h>
+#include <Toy/Model/buffer_cache.h>
+#include <Toy/Model/vertex_encoding.h>
+
+namespace toy::model
+{
+    bool load_gltf(Model& model, ID3D11Device *device, std::string_view file_name, VertexEncoding vertex_encoding)
+    {
+        using namespace DirectX;
+        // Convert every primitive before creating any resource, so that unsupported files fall back cleanly
+        GltfModel gltf_model{};
+        if (!import_gltf(file_name, gltf_model))
+        {
+            return false;
+        }
+
+        model.clear();
+        model.meshes.reserve(gltf_model.meshes.size());
+        model.materials = std::move(gltf_model.materials);
+        model.bounding_box = gltf_model.bounding_box;
+
+        // Identical streams share one buffer, see BufferCache
+        auto&& buffer_cache = BufferCache::get();
+        uint32_t bind_flags = D3D11_BIND_VERTEX_BUFFER;
+        auto create_buffer = [device, &buffer_cache, &bind_flags, &model](const void* data, size_t byte_width, com_ptr<ID3D11Buffer>& buffer)
+        {
+            buffer = buffer_cache.create(device, data, byte_width, bind_flags, model.cached_buffers);
+        };
+
+        std::pair<size_t, size_t> stream_byte_width{};
+        for (auto&& primitive : gltf_model.meshes)
+        {
+            auto num_vertices = static_cast<uint32_t>(primitive.positions.size());
+
+            // Quantized primitive is split into 16-bit indexable chunks, one mesh per chunk
+            if (vertex_encoding == VertexEncoding::Quantized)
+            {
+                // Full precision tangents keep w = 1 beside explicit bitangents, quantized ones carry handedness
+                auto tangents = make_handed_tangents(primitive.normals, primitive.tangents, primitive.bitangents);
+                VertexStreams streams{};
+                streams.positions = primitive.positions;
+                streams.normals = primitive.normals;
+                streams.tangents = tangents;
+                streams.texcoords.assign(primitive.texcoords.begin(), primitive.texcoords.end());
+                streams.indices = primitive.indices;
+                auto chunks = quantize_vertex_streams(streams);
+                stream_byte_width.first += full_precision_byte_width(num_vertices, primitive.indices.size(), primitive.texcoords.size());
+                stream_byte_width.second += quantized_byte_width(chunks);
+
+                for (auto&& chunk : chunks)
+                {
+                    auto&& mesh = model.meshes.emplace_back();
+                    bind_flags = D3D11_BIND_VERTEX_BUFFER;
+                    create_buffer(chunk.positions.data(), chunk.positions.size() * sizeof(PackedVector::XMUSHORTN4), mesh.vertices);
+                    create_buffer(chunk.normals.data(), chunk.normals.size() * sizeof(PackedVector::XMSHORTN2), mesh.normals);
+                    create_buffer(chunk.tangents.data(), chunk.tangents.size() * sizeof(PackedVector::XMSHORTN2), mesh.tangents);
+                    mesh.texcoord_arrays.resize(chunk.texcoords.size());
+                    for (size_t row = 0; row < chunk.texcoords.size(); ++row)
+                    {
+                        create_buffer(chunk.texcoords[row].data(), chunk.texcoords[row].size() * sizeof(PackedVector::XMHALF2), mesh.texcoord_arrays[row]);
+                    }
+                    bind_flags = D3D11_BIND_INDEX_BUFFER;
+                    create_buffer(chunk.indices.data(), chunk.indices.size() * sizeof(uint16_t), mesh.indices);
+
+                    mesh.vertex_count = static_cast<uint32_t>(chunk.positions.size());
+                    mesh.index_count = static_cast<uint32_t>(chunk.indices.size());
+                    mesh.index_format = DXGI_FORMAT_R16_UINT;
+                    mesh.vertex_encoding = VertexEncoding::Quantized;
+                    mesh.material_index = primitive.material_index;
+                    mesh.uv_density = primitive.uv_density;
+                    mesh.bounding_box = chunk.bounding_box;
+                }
+                continue;
+            }
+
+            auto&& mesh = model.meshes.emplace_back();
+            bind_flags = D3D11_BIND_VERTEX_BUFFER;
+
+            create_buffer(primitive.positions.data(), num_vertices * sizeof(XMFLOAT3), mesh.vertices);
+            create_buffer(primitive.normals.data(), primitive.normals.size() * sizeof(XMFLOAT3), mesh.normals);
+            create_buffer(primitive.tangents.data(), primitive.tangents.size() * sizeof(XMFLOAT4), mesh.tangents);
+            create_buffer(primitive.bitangents.data(), primitive.bitangents.size() * sizeof(XMFLOAT4), mesh.bitangents);
+            mesh.texcoord_arrays.resize(primitive.texcoords.size());
+            for (size_t row = 0; row < primitive.texcoords.size(); ++row)
+            {
+                create_buffer(primitive.texcoords[row].data(), primitive.texcoords[row].size() * sizeof(XMFLOAT2), mesh.texcoord_arrays[row]);
+            }
+
+            // 16-bit indices whenever every vertex is addressable
+            auto num_indices = static_cast<uint32_t>(primitive.indices.size());
+            bind_flags = D3D11_BIND_INDEX_BUFFER;
+            if (num_vertices <= 65536)
+            {
+                std::vector<uint16_t> indices(primitive.indices.begin(), primitive.indices.end());
+                create_buffer(indices.data(), num_indices * sizeof(uint16_t), mesh.indices);
+                mesh.index_format = DXGI_FORMAT_R16_UINT;
+            } else
+            {
+                create_buffer(primitive.indices.data(), num_indices * sizeof(uint32_t), mesh.indices);
+                mesh.index_format = DXGI_FORMAT_R32_UINT;
+            }
+
+            mesh.vertex_count = num_vertices;
+            mesh.index_count = num_indices;
+            mesh.material_index = primitive.material_index;
+            mesh.uv_density = primitive.uv_density;
+            mesh.bounding_box = primitive.bounding_box;
+        }
+
+        if (vertex_encoding == VertexEncoding::Quantized && stream_byte_width.first > 0)
+        {
+            DX_CORE_INFO("glTF '{}' quantized vertex streams {:.2f} MB -> {:.2f} MB ({:.1f}%)", file_name,
+                         static_cast<double>(stream_byte_width.first) / (1024.0 * 1024.0),
+                         static_cast<double>(stream_byte_width.second) / (1024.0 * 1024.0),
+                         100.0 * static_cast<double>(stream_byte_width.second) / static_cast<double>(stream_byte_width.first));
+        }
+
+        TextureManager::get().create_batch(gltf_model.texture_sources);
+        return true;
+    }
+}
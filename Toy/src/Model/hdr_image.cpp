@@ -0,0 +1,230 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#include <Toy/Model/hdr_image.h>
+#include <Toy/Core/virtual_file_system.h>
+
+namespace toy::model
+{
+    using namespace DirectX;
+
+    // Scanlines of this width range may be run length encoded
+    static constexpr uint32_t s_min_rle_width = 8;
+    static constexpr uint32_t s_max_rle_width = 0x7fff;
+
+    // Sequential reader of image bytes, reads past the end fail
+    class HdrReader
+    {
+    public:
+        explicit HdrReader(std::span<const uint8_t> data) : m_data(data) {}
+
+        bool read(uint8_t* output, size_t count)
+        {
+            if (count > m_data.size() - m_position)
+            {
+                return false;
+            }
+            std::memcpy(output, m_data.data() + m_position, count);
+            m_position += count;
+            return true;
+        }
+
+        bool read_byte(uint8_t& value) { return read(&value, 1); }
+
+        // Line without its newline, false at end of data
+        bool read_line(std::string_view& line)
+        {
+            if (m_position >= m_data.size())
+            {
+                return false;
+            }
+            auto begin = reinterpret_cast<const char*>(m_data.data()) + m_position;
+            size_t length = 0;
+            while (m_position + length < m_data.size() && begin[length] != '\n')
+            {
+                length++;
+            }
+            line = std::string_view(begin, length);
+            m_position += std::min(length + 1, m_data.size() - m_position);
+            return true;
+        }
+
+    private:
+        std::span<const uint8_t> m_data;
+        size_t m_position = 0;
+    };
+
+    // Scale of mantissa bytes for every exponent byte, exponent 0 is black
+    static const std::array<float, 256>& rgbe_scale_table()
+    {
+        static const std::array<float, 256> table = []
+        {
+            std::array<float, 256> result{};
+            for (int32_t exponent = 1; exponent < 256; ++exponent)
+            {
+                result[exponent] = std::ldexp(1.0f, exponent - (128 + 8));
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    // Interleaved RGBE scanline, either flat or new style run length encoded per component
+    static bool read_scanline(HdrReader& reader, uint32_t width, uint8_t* scanline)
+    {
+        if (width < s_min_rle_width || width > s_max_rle_width)
+        {
+            return reader.read(scanline, static_cast<size_t>(width) * 4);
+        }
+
+        std::array<uint8_t, 4> marker{};
+        if (!reader.read(marker.data(), 4))
+        {
+            return false;
+        }
+        if (marker[0] != 2 || marker[1] != 2 || (marker[2] & 0x80))
+        {
+            // Flat scanline, marker was its first texel
+            std::copy(marker.begin(), marker.end(), scanline);
+            return reader.read(scanline + 4, static_cast<size_t>(width - 1) * 4);
+        }
+        if ((static_cast<uint32_t>(marker[2]) << 8 | marker[3]) != width)
+        {
+            return false;
+        }
+
+        for (uint32_t component = 0; component < 4; ++component)
+        {
+            uint32_t x = 0;
+            while (x < width)
+            {
+                uint8_t count = 0;
+                if (!reader.read_byte(count))
+                {
+                    return false;
+                }
+                bool is_run = count > 128;
+                uint32_t length = is_run ? count - 128u : count;
+                if (length == 0 || x + length > width)
+                {
+                    return false;
+                }
+
+                uint8_t value = 0;
+                if (is_run && !reader.read_byte(value))
+                {
+                    return false;
+                }
+                for (uint32_t i = 0; i < length; ++i, ++x)
+                {
+                    if (!is_run && !reader.read_byte(value))
+                    {
+                        return false;
+                    }
+                    scanline[static_cast<size_t>(x) * 4 + component] = value;
+                }
+            }
+        }
+        return true;
+    }
+
+    static void convert_scanline(const uint8_t* scanline, uint32_t width, HdrFormat format, uint8_t* output)
+    {
+        auto&& scale_table = rgbe_scale_table();
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            auto rgbe = reinterpret_cast<const PackedVector::XMUBYTE4*>(scanline) + x;
+            XMVECTOR color = XMVectorScale(PackedVector::XMLoadUByte4(rgbe), scale_table[rgbe->w]);
+            color = XMVectorSelect(g_XMOne, color, g_XMSelect1110);
+            if (format == HdrFormat::RGBA16F)
+            {
+                PackedVector::XMStoreHalf4(reinterpret_cast<PackedVector::XMHALF4*>(output) + x, color);
+            } else
+            {
+                PackedVector::XMStoreFloat3SE(reinterpret_cast<PackedVector::XMFLOAT3SE*>(output) + x, color);
+            }
+        }
+    }
+
+    uint32_t get_texel_byte_width(HdrFormat format)
+    {
+        return format == HdrFormat::RGBA16F ? 8 : 4;
+    }
+
+    DXGI_FORMAT get_dxgi_format(HdrFormat format)
+    {
+        return format == HdrFormat::RGBA16F ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+    }
+
+    bool is_radiance_image(std::span<const uint8_t> data)
+    {
+        auto starts_with = [data](std::string_view signature)
+        {
+            return data.size() >= signature.size() && std::memcmp(data.data(), signature.data(), signature.size()) == 0;
+        };
+        return starts_with("#?RADIANCE\n") || starts_with("#?RGBE\n");
+    }
+
+    std::optional<HdrImage> decode_hdr_image(std::span<const uint8_t> data, HdrFormat format)
+    {
+        if (!is_radiance_image(data))
+        {
+            return std::nullopt;
+        }
+
+        // Header lines end with an empty line, followed by resolution line
+        HdrReader reader(data);
+        std::string_view line{};
+        bool is_rgbe = false;
+        while (reader.read_line(line) && !line.empty())
+        {
+            if (line == "FORMAT=32-bit_rle_rgbe")
+            {
+                is_rgbe = true;
+            }
+        }
+        if (!is_rgbe)
+        {
+            DX_CORE_WARN("Unsupported Radiance image format, only 32-bit_rle_rgbe is read");
+            return std::nullopt;
+        }
+
+        uint32_t width = 0, height = 0;
+        if (!reader.read_line(line) ||
+            std::sscanf(std::string(line).c_str(), "-Y %u +X %u", &height, &width) != 2 || width == 0 || height == 0)
+        {
+            DX_CORE_WARN("Unsupported Radiance image orientation: {}", line);
+            return std::nullopt;
+        }
+
+        HdrImage image{};
+        image.format = format;
+        image.width = width;
+        image.height = height;
+        size_t row_byte_width = static_cast<size_t>(width) * get_texel_byte_width(format);
+        image.pixels.resize(row_byte_width * height);
+
+        std::vector<uint8_t> scanline(static_cast<size_t>(width) * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            if (!read_scanline(reader, width, scanline.data()))
+            {
+                DX_CORE_WARN("Radiance image is truncated or corrupted at scanline {}", y);
+                return std::nullopt;
+            }
+            convert_scanline(scanline.data(), width, format, image.pixels.data() + row_byte_width * y);
+        }
+        return image;
+    }
+
+    std::optional<HdrImage> load_hdr_image(const std::filesystem::path& file_path, HdrFormat format)
+    {
+        auto file = VirtualFileSystem::get().open(file_path);
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+        return decode_hdr_image(file.bytes(), format);
+    }
+}
@@ -0,0 +1,129 @@
+//
+// Created by ZZK on 2024/4/7.
+//
+
+#include <Toy/Model/mapped_io_system.h>
+
+namespace toy::model
+{
+    MappedIOStream::MappedIOStream(VirtualFile&& file)
+    : m_file(std::move(file))
+    {
+    }
+
+    size_t MappedIOStream::Read(void *buffer, size_t size, size_t count)
+    {
+        if (size == 0 || count == 0)
+        {
+            return 0;
+        }
+
+        // Only whole elements are read, as fread does
+        size_t element_count = std::min(count, (m_file.size() - m_position) / size);
+        size_t byte_width = element_count * size;
+        if (byte_width > 0)
+        {
+            std::memcpy(buffer, m_file.data() + m_position, byte_width);
+            m_position += byte_width;
+        }
+        return element_count;
+    }
+
+    size_t MappedIOStream::Write(const void *buffer, size_t size, size_t count)
+    {
+        DX_CORE_WARN("Mapped IO stream is read-only");
+        return 0;
+    }
+
+    aiReturn MappedIOStream::Seek(size_t offset, aiOrigin origin)
+    {
+        size_t new_position = 0;
+        switch (origin)
+        {
+            case aiOrigin_SET: new_position = offset; break;
+            case aiOrigin_CUR: new_position = m_position + offset; break;
+            case aiOrigin_END: new_position = m_file.size() - offset; break;
+            default: return aiReturn_FAILURE;
+        }
+
+        if (new_position > m_file.size())
+        {
+            return aiReturn_FAILURE;
+        }
+        m_position = new_position;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t MappedIOStream::Tell() const
+    {
+        return m_position;
+    }
+
+    size_t MappedIOStream::FileSize() const
+    {
+        return m_file.size();
+    }
+
+    void MappedIOStream::Flush()
+    {
+    }
+
+    MappedIOSystem::MappedIOSystem(std::string_view model_file_name)
+    : m_base_dir(std::filesystem::path(model_file_name).parent_path())
+    {
+    }
+
+    bool MappedIOSystem::Exists(const char *file_name) const
+    {
+        return VirtualFileSystem::get().exists(resolve(file_name));
+    }
+
+    char MappedIOSystem::getOsSeparator() const
+    {
+        return '/';
+    }
+
+    Assimp::IOStream* MappedIOSystem::Open(const char *file_name, const char *mode)
+    {
+        // Importing never writes, refuse write modes instead of silently mapping read-only
+        if (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+'))
+        {
+            DX_CORE_WARN("Mapped IO system can not open '{}' with mode '{}'", file_name, mode);
+            return nullptr;
+        }
+
+        std::filesystem::path file_path = resolve(file_name);
+        auto file = VirtualFileSystem::get().open(file_path);
+        if (!file.is_open())
+        {
+            return nullptr;
+        }
+        if (std::find(m_opened_files.begin(), m_opened_files.end(), file_path.string()) == m_opened_files.end())
+        {
+            m_opened_files.push_back(file_path.string());
+        }
+        return new MappedIOStream(std::move(file));
+    }
+
+    void MappedIOSystem::Close(Assimp::IOStream *stream)
+    {
+        delete stream;
+    }
+
+    std::filesystem::path MappedIOSystem::resolve(const char *file_name) const
+    {
+        std::filesystem::path file_path(file_name);
+        if (file_path.is_absolute() || m_base_dir.empty())
+        {
+            return file_path;
+        }
+
+        // Sibling file of model takes precedence, then fall back to path relative to working directory
+        std::filesystem::path sibling_path = m_base_dir / file_path;
+        if (VirtualFileSystem::get().exists(sibling_path))
+        {
+            return sibling_path;
+        }
+        return file_path;
+    }
+}
@@ -0,0 +1,271 @@
+//
+// Created by ZZK on 2024/4/6.
+//
+
+#include <Toy/Model/mesh_cache.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Model/mesh_codec.h>
+#include <Toy/Model/texture_decoder.h>
+
+namespace toy::model
+{
+    MeshCacheWriter::MeshCacheWriter(XID key, MeshStreamStorage stream_storage) : m_stream_storage(stream_storage)
+    {
+        m_header.key = key;
+        // Header is patched by finish()
+        m_image.resize(sizeof(MeshCacheHeader));
+    }
+
+    MeshCacheBlob MeshCacheWriter::append(const void *data, size_t byte_width)
+    {
+        size_t offset = (m_image.size() + mesh_cache_alignment - 1) & ~static_cast<size_t>(mesh_cache_alignment - 1);
+        m_image.resize(offset + byte_width);
+        if (byte_width > 0)
+        {
+            std::memcpy(m_image.data() + offset, data, byte_width);
+        }
+        return MeshCacheBlob{ offset, byte_width, 0 };
+    }
+
+    static MeshCacheBlob append_encoded(MeshCacheWriter& writer, std::span<const uint8_t> encoded, const void *data, size_t byte_width)
+    {
+        if (encoded.empty() || static_cast<float>(encoded.size()) > static_cast<float>(byte_width) * mesh_cache_max_encoded_ratio)
+        {
+            return writer.append(data, byte_width);
+        }
+        MeshCacheBlob blob = writer.append(encoded.data(), encoded.size());
+        blob.decoded_byte_width = byte_width;
+        return blob;
+    }
+
+    MeshCacheBlob MeshCacheWriter::append_vertex_stream(const void *data, size_t vertex_count, uint32_t vertex_stride)
+    {
+        if (m_stream_storage == MeshStreamStorage::Plain)
+        {
+            return append(data, vertex_count * vertex_stride);
+        }
+        return append_encoded(*this, encode_vertex_stream(data, vertex_count, vertex_stride), data, vertex_count * vertex_stride);
+    }
+
+    MeshCacheBlob MeshCacheWriter::append_index_buffer(const void *data, size_t index_count, uint32_t index_stride)
+    {
+        if (m_stream_storage == MeshStreamStorage::Plain)
+        {
+            return append(data, index_count * index_stride);
+        }
+        return append_encoded(*this, encode_index_buffer(data, index_count, index_stride), data, index_count * index_stride);
+    }
+
+    MeshCacheBlob MeshCacheWriter::append_string(std::string_view str)
+    {
+        return append(str.data(), str.size());
+    }
+
+    MeshCacheBlob MeshCacheWriter::append_embedded_texture(std::string_view name, const void *data, size_t byte_width)
+    {
+        XID name_id = string_to_id(name);
+        if (auto it = m_embedded_textures.find(name_id); it != m_embedded_textures.end())
+        {
+            return it->second;
+        }
+        MeshCacheBlob blob = append(data, byte_width);
+        m_embedded_textures.try_emplace(name_id, blob);
+        return blob;
+    }
+
+    void MeshCacheWriter::add_dependency(std::string_view file_name)
+    {
+        XID content_id = file_content_to_id(file_name);
+        m_dependencies.push_back({ content_id, append_string(file_name) });
+    }
+
+    std::vector<uint8_t> MeshCacheWriter::finish()
+    {
+        m_header.mesh_count = static_cast<uint32_t>(m_meshes.size());
+        m_header.material_count = static_cast<uint32_t>(m_materials.size());
+        m_header.dependency_count = static_cast<uint32_t>(m_dependencies.size());
+        m_header.meshes = append(m_meshes.data(), m_meshes.size() * sizeof(MeshCacheMesh));
+        m_header.materials = append(m_materials.data(), m_materials.size() * sizeof(MeshCacheMaterial));
+        m_header.dependencies = append(m_dependencies.data(), m_dependencies.size() * sizeof(MeshCacheDependency));
+        m_header.byte_width = m_image.size();
+        std::memcpy(m_image.data(), &m_header, sizeof(MeshCacheHeader));
+
+        m_meshes.clear();
+        m_materials.clear();
+        m_dependencies.clear();
+        m_embedded_textures.clear();
+        return std::move(m_image);
+    }
+
+    XID mesh_cache_key(std::string_view file_name, uint32_t import_flags, uint32_t import_properties, VertexEncoding vertex_encoding,
+                       MeshStreamStorage stream_storage)
+    {
+        XID content_id = file_content_to_id(file_name);
+        if (content_id == 0)
+        {
+            return 0;
+        }
+        XID key = hash::combine(content_id, import_flags);
+        key = hash::combine(key, import_properties);
+        key = hash::combine(key, static_cast<uint32_t>(vertex_encoding));
+        key = hash::combine(key, static_cast<uint32_t>(stream_storage));
+        return hash::combine(key, mesh_cache_version);
+    }
+
+    std::filesystem::path mesh_cache_path(XID key)
+    {
+        return std::filesystem::path(DXTOY_HOME "data/cache/models") / fmt::format("{:016x}.tmesh", key);
+    }
+
+    static bool blob_in_range(const MeshCacheBlob& blob, size_t image_size)
+    {
+        return blob.offset <= image_size && blob.byte_width <= image_size - blob.offset;
+    }
+
+    // Encoded stream must decode to the byte width recorded in blob, stream content is checked while decoding
+    static bool stream_blob_valid(std::span<const uint8_t> image, const MeshCacheBlob& blob)
+    {
+        return blob_in_range(blob, image.size()) && (blob.decoded_byte_width == 0 ||
+               get_decoded_byte_width(image.subspan(blob.offset, blob.byte_width)) == blob.decoded_byte_width);
+    }
+
+    std::string_view get_mesh_cache_string(std::span<const uint8_t> image, const MeshCacheBlob& blob)
+    {
+        return { reinterpret_cast<const char *>(image.data() + blob.offset), static_cast<size_t>(blob.byte_width) };
+    }
+
+    TextureSource get_mesh_cache_texture(std::span<const uint8_t> image, const MeshCacheTexture& texture, uint32_t slot)
+    {
+        TextureSource texture_source{};
+        texture_source.name = get_mesh_cache_string(image, texture.name);
+        texture_source.enable_mips = texture.gen_mips != 0;
+        texture_source.force_SRGB = texture.force_SRGB;
+        texture_source.usage = get_texture_usage(static_cast<MaterialSemantics>(slot));
+        if (texture.source == MeshCacheTextureSource::Embedded)
+        {
+            texture_source.data = image.subspan(texture.data.offset, texture.data.byte_width);
+        }
+        return texture_source;
+    }
+
+    bool validate_mesh_cache(std::span<const uint8_t> image, XID key)
+    {
+        if (image.size() < sizeof(MeshCacheHeader))
+        {
+            return false;
+        }
+
+        auto&& header = *reinterpret_cast<const MeshCacheHeader *>(image.data());
+        if (header.magic != mesh_cache_magic || header.version != mesh_cache_version ||
+            header.key != key || header.byte_width != image.size())
+        {
+            return false;
+        }
+        if (!blob_in_range(header.meshes, image.size()) || header.meshes.byte_width != header.mesh_count * sizeof(MeshCacheMesh) ||
+            !blob_in_range(header.materials, image.size()) || header.materials.byte_width != header.material_count * sizeof(MeshCacheMaterial) ||
+            !blob_in_range(header.dependencies, image.size()) ||
+            header.dependencies.byte_width != header.dependency_count * sizeof(MeshCacheDependency))
+        {
+            return false;
+        }
+
+        for (auto&& mesh : get_mesh_cache_blob<MeshCacheMesh>(image, header.meshes))
+        {
+            bool valid = mesh.texcoord_count <= mesh_cache_max_texcoords &&
+                            (mesh.index_stride == sizeof(uint16_t) || mesh.index_stride == sizeof(uint32_t)) &&
+                            mesh.material_index < header.material_count &&
+                            mesh.vertex_encoding <= static_cast<uint32_t>(VertexEncoding::Quantized) &&
+                            stream_blob_valid(image, mesh.positions) && stream_blob_valid(image, mesh.normals) &&
+                            stream_blob_valid(image, mesh.tangents) && stream_blob_valid(image, mesh.bitangents) &&
+                            stream_blob_valid(image, mesh.indices);
+            for (auto&& texcoords : mesh.texcoords)
+            {
+                valid = valid && stream_blob_valid(image, texcoords);
+            }
+            if (!valid)
+            {
+                return false;
+            }
+        }
+
+        for (auto&& material : get_mesh_cache_blob<MeshCacheMaterial>(image, header.materials))
+        {
+            bool valid = blob_in_range(material.properties, image.size()) &&
+                            material.properties.byte_width == material.property_count * sizeof(MeshCacheProperty);
+            for (auto&& texture : material.textures)
+            {
+                valid = valid && blob_in_range(texture.name, image.size()) && blob_in_range(texture.data, image.size());
+            }
+            if (!valid)
+            {
+                return false;
+            }
+        }
+
+        // Dependency changed or appeared since import, cache is stale
+        for (auto&& dependency : get_mesh_cache_blob<MeshCacheDependency>(image, header.dependencies))
+        {
+            if (!blob_in_range(dependency.path, image.size()) ||
+                file_content_to_id(get_mesh_cache_string(image, dependency.path)) != dependency.content_id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<TextureSource> get_mesh_cache_textures(std::span<const uint8_t> image)
+    {
+        auto&& header = *reinterpret_cast<const MeshCacheHeader *>(image.data());
+        std::vector<TextureSource> texture_sources{};
+        for (auto&& cached_material : get_mesh_cache_blob<MeshCacheMaterial>(image, header.materials))
+        {
+            for (uint32_t slot = 0; slot < material_texture_count; ++slot)
+            {
+                if (cached_material.textures[slot].source != MeshCacheTextureSource::None)
+                {
+                    texture_sources.push_back(get_mesh_cache_texture(image, cached_material.textures[slot], slot));
+                }
+            }
+        }
+        return texture_sources;
+    }
+
+    std::vector<std::string_view> get_mesh_cache_dependencies(std::span<const uint8_t> image)
+    {
+        auto&& header = *reinterpret_cast<const MeshCacheHeader *>(image.data());
+        std::vector<std::string_view> dependencies{};
+        for (auto&& dependency : get_mesh_cache_blob<MeshCacheDependency>(image, header.dependencies))
+        {
+            dependencies.push_back(get_mesh_cache_string(image, dependency.path));
+        }
+        return dependencies;
+    }
+
+    bool save_mesh_cache(const std::filesystem::path &cache_path, std::span<const uint8_t> image)
+    {
+        std::error_code error_code{};
+        std::filesystem::create_directories(cache_path.parent_path(), error_code);
+
+        std::filesystem::path temp_path = make_temp_path(cache_path);
+        bool is_written = false;
+        {
+            std::ofstream file_stream(temp_path, std::ios::binary | std::ios::trunc);
+            file_stream.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+            file_stream.close();
+            is_written = file_stream.good();
+        }
+
+        // Concurrent writer of the same key wrote the same image, the last rename wins
+        if (is_written)
+        {
+            std::filesystem::rename(temp_path, cache_path, error_code);
+        }
+        if (!is_written || error_code)
+        {
+            std::filesystem::remove(temp_path, error_code);
+            return false;
+        }
+        return true;
+    }
+}
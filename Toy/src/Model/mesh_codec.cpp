@@ -0,0 +1,554 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Model/mesh_codec.h>
+
+#include <emmintrin.h>
+
+namespace toy::model
+{
+    static_assert(sizeof(MeshStreamHeader) == 8);
+
+    // Index codec
+    // Stream holds a code byte per triangle, then 2 bits of rotation per triangle, then data in triangle order
+    // Rotation tells which vertex of triangle starts the shared edge, so that triangles decode in their original vertex order
+    // Code byte, high nibble is the edge FIFO slot of shared edge, low nibble is vertex code of the remaining vertex
+    // If no edge is shared high nibble is 15, low nibble is vertex code of first vertex and a data byte holds codes of the others
+    // Vertex code, 0 is the next vertex never seen, 1-14 are vertex FIFO slots, 15 is a zigzag varint relative to next vertex
+    static constexpr uint32_t s_edge_fifo_size = 16;
+    static constexpr uint32_t s_edge_fifo_slots = 15;
+    static constexpr uint32_t s_edge_none = 15;
+    static constexpr uint32_t s_vertex_fifo_size = 16;
+    static constexpr uint32_t s_vertex_fifo_slots = 14;
+    static constexpr uint32_t s_vertex_code_next = 0;
+    static constexpr uint32_t s_vertex_code_explicit = 15;
+    static constexpr size_t s_index_batch_size = 64;       // Triangles decoded between stores into output
+
+    static inline uint64_t make_edge(uint32_t a, uint32_t b)
+    {
+        return a | (static_cast<uint64_t>(b) << 32);
+    }
+
+    // Encoder state, decode_index_buffer mirrors it, FIFOs start zeroed on both sides
+    struct IndexCodecState
+    {
+        std::array<uint64_t, s_edge_fifo_size> edges{};    // First vertex in low half
+        std::array<uint32_t, s_vertex_fifo_size> vertices{};
+        uint32_t edge_offset = 0;
+        uint32_t vertex_offset = 0;
+        uint32_t next = 0;
+
+        // Slot 0 holds the most recent
+        [[nodiscard]] uint64_t get_edge(uint32_t slot) const
+        {
+            return edges[(edge_offset - 1 - slot) & (s_edge_fifo_size - 1)];
+        }
+        [[nodiscard]] uint32_t get_vertex(uint32_t slot) const
+        {
+            return vertices[(vertex_offset - 1 - slot) & (s_vertex_fifo_size - 1)];
+        }
+        void push_edge(uint32_t a, uint32_t b) { edges[edge_offset++ & (s_edge_fifo_size - 1)] = make_edge(a, b); }
+        void push_vertex(uint32_t vertex) { vertices[vertex_offset++ & (s_vertex_fifo_size - 1)] = vertex; }
+
+        // Edges of triangle as a neighbour with the same winding walks them, (x, y) is left out when it was just shared
+        void push_triangle_edges(uint32_t x, uint32_t y, uint32_t z, bool shared_first_edge)
+        {
+            if (!shared_first_edge)
+            {
+                push_edge(y, x);
+            }
+            push_edge(z, y);
+            push_edge(x, z);
+        }
+    };
+
+    static void write_varint(std::vector<uint8_t>& data, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(value));
+    }
+
+    static inline bool read_varint(const uint8_t*& ip, const uint8_t* end, uint32_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; shift < 35 && ip < end; shift += 7)
+        {
+            uint8_t byte = *ip++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (byte < 0x80)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static uint32_t peek_vertex_code(const IndexCodecState& state, uint32_t vertex)
+    {
+        if (vertex == state.next)
+        {
+            return s_vertex_code_next;
+        }
+        for (uint32_t slot = 0; slot < s_vertex_fifo_slots; ++slot)
+        {
+            if (state.get_vertex(slot) == vertex)
+            {
+                return 1 + slot;
+            }
+        }
+        return s_vertex_code_explicit;
+    }
+
+    static uint32_t encode_vertex(IndexCodecState& state, uint32_t vertex, std::vector<uint8_t>& data)
+    {
+        uint32_t code = peek_vertex_code(state, vertex);
+        if (code == s_vertex_code_next)
+        {
+            ++state.next;
+            state.push_vertex(vertex);
+        } else if (code == s_vertex_code_explicit)
+        {
+            auto delta = static_cast<int32_t>(vertex - state.next);
+            write_varint(data, (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+            state.push_vertex(vertex);
+        }
+        return code;
+    }
+
+    static uint32_t read_index(const uint8_t* indices, size_t i, uint32_t index_stride)
+    {
+        if (index_stride == sizeof(uint16_t))
+        {
+            uint16_t index = 0;
+            std::memcpy(&index, indices + i * sizeof(uint16_t), sizeof(uint16_t));
+            return index;
+        }
+        uint32_t index = 0;
+        std::memcpy(&index, indices + i * sizeof(uint32_t), sizeof(uint32_t));
+        return index;
+    }
+
+    static void write_header(std::vector<uint8_t>& encoded, MeshStreamKind kind, uint32_t stride, size_t count)
+    {
+        MeshStreamHeader header{ kind, mesh_codec_version, static_cast<uint16_t>(stride), static_cast<uint32_t>(count) };
+        encoded.resize(sizeof(MeshStreamHeader));
+        std::memcpy(encoded.data(), &header, sizeof(MeshStreamHeader));
+    }
+
+    std::vector<uint8_t> encode_index_buffer(const void* indices, size_t index_count, uint32_t index_stride)
+    {
+        if (index_count % 3 != 0 || index_count > std::numeric_limits<uint32_t>::max() ||
+            (index_stride != sizeof(uint16_t) && index_stride != sizeof(uint32_t)))
+        {
+            return {};
+        }
+
+        auto source = static_cast<const uint8_t*>(indices);
+        size_t triangle_count = index_count / 3;
+        std::vector<uint8_t> encoded{};
+        write_header(encoded, MeshStreamKind::Index, index_stride, index_count);
+        size_t code_offset = encoded.size();
+        size_t rotation_offset = code_offset + triangle_count;
+        encoded.resize(rotation_offset + (triangle_count + 3) / 4, 0);
+        std::vector<uint8_t> data{};
+        data.reserve(triangle_count);
+
+        IndexCodecState state{};
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            std::array<uint32_t, 3> triangle = {
+                read_index(source, i * 3, index_stride), read_index(source, i * 3 + 1, index_stride), read_index(source, i * 3 + 2, index_stride)
+            };
+
+            // Rotation whose shared edge is in edge FIFO, preferring one whose remaining vertex needs no explicit index
+            uint32_t best_rotation = 0, best_slot = s_edge_none, best_code = s_vertex_code_explicit;
+            for (uint32_t rotation = 0; rotation < 3 && best_code == s_vertex_code_explicit; ++rotation)
+            {
+                uint64_t edge = make_edge(triangle[rotation], triangle[(rotation + 1) % 3]);
+                for (uint32_t slot = 0; slot < s_edge_fifo_slots; ++slot)
+                {
+                    if (state.get_edge(slot) == edge)
+                    {
+                        uint32_t code = peek_vertex_code(state, triangle[(rotation + 2) % 3]);
+                        if (best_slot == s_edge_none || code != s_vertex_code_explicit)
+                        {
+                            best_rotation = rotation;
+                            best_slot = slot;
+                            best_code = code;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            if (best_slot != s_edge_none)
+            {
+                uint32_t x = triangle[best_rotation], y = triangle[(best_rotation + 1) % 3], z = triangle[(best_rotation + 2) % 3];
+                encode_vertex(state, z, data);
+                encoded[code_offset + i] = static_cast<uint8_t>((best_slot << 4) | best_code);
+                encoded[rotation_offset + i / 4] |= static_cast<uint8_t>(best_rotation << (i % 4 * 2));
+                state.push_triangle_edges(x, y, z, true);
+            } else
+            {
+                // Codes of the last two vertices go before any of their explicit indices
+                size_t data_offset = data.size();
+                uint32_t code_a = encode_vertex(state, triangle[0], data);
+                uint32_t code_b = encode_vertex(state, triangle[1], data);
+                uint32_t code_c = encode_vertex(state, triangle[2], data);
+                data.insert(data.begin() + static_cast<ptrdiff_t>(data_offset), static_cast<uint8_t>(code_b | (code_c << 4)));
+                encoded[code_offset + i] = static_cast<uint8_t>((s_edge_none << 4) | code_a);
+                state.push_triangle_edges(triangle[0], triangle[1], triangle[2], false);
+            }
+        }
+
+        encoded.insert(encoded.end(), data.begin(), data.end());
+        return encoded;
+    }
+
+    template<typename T>
+    static bool decode_index_buffer(const uint8_t* ip, const uint8_t* end, uint8_t* output, size_t index_count)
+    {
+        size_t triangle_count = index_count / 3;
+        size_t rotation_byte_width = (triangle_count + 3) / 4;
+        if (static_cast<size_t>(end - ip) < triangle_count + rotation_byte_width)
+        {
+            return false;
+        }
+        const uint8_t* codes = ip;
+        const uint8_t* rotations = ip + triangle_count;
+        ip += triangle_count + rotation_byte_width;
+
+        // Same state as IndexCodecState, kept in locals so that counters stay in registers
+        std::array<uint64_t, s_edge_fifo_size> edges{};
+        std::array<uint32_t, s_vertex_fifo_size> vertices{};
+        uint32_t edge_offset = 0, vertex_offset = 0, next = 0;
+
+        // Only explicit vertex takes a branch, next and FIFO vertices are hard to predict and decoded branch free
+        auto decode_vertex = [&](uint32_t code, uint32_t& vertex)
+        {
+            // Code of next vertex reads slot past the most recent one, which is never addressed by FIFO codes
+            uint32_t is_next = code == s_vertex_code_next ? 1 : 0;
+            uint32_t is_pushed = is_next;
+            vertex = is_next ? next : vertices[(vertex_offset - code) & (s_vertex_fifo_size - 1)];
+            if (code == s_vertex_code_explicit)
+            {
+                uint32_t zigzag = 0;
+                if (!read_varint(ip, end, zigzag))
+                {
+                    return false;
+                }
+                vertex = next + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+                is_pushed = 1;
+            }
+            // Slot past the most recent is written either way, it is only kept when pushed
+            vertices[vertex_offset & (s_vertex_fifo_size - 1)] = vertex;
+            vertex_offset += is_pushed;
+            next += is_next;
+            return true;
+        };
+        auto push_edge = [&](uint32_t a, uint32_t b) { edges[edge_offset++ & (s_edge_fifo_size - 1)] = make_edge(a, b); };
+
+        // Triangles are staged in a local batch, byte stores into output could alias codec state and force it out of registers
+        std::array<T, s_index_batch_size * 3> batch{};
+        uint32_t combined = 0;
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            uint32_t code = codes[i];
+            uint32_t a = 0, b = 0, c = 0;
+            if ((code >> 4) != s_edge_none)
+            {
+                uint64_t edge = edges[(edge_offset - 1 - (code >> 4)) & (s_edge_fifo_size - 1)];
+                auto x = static_cast<uint32_t>(edge), y = static_cast<uint32_t>(edge >> 32);
+                uint32_t z = 0;
+                if (!decode_vertex(code & 15, z))
+                {
+                    return false;
+                }
+                push_edge(z, y);
+                push_edge(x, z);
+
+                // Rotate back to original vertex order, selects rather than indexing keep vertices in registers
+                uint32_t rotation = (rotations[i / 4] >> (i % 4 * 2)) & 3;
+                if (rotation == 3)
+                {
+                    return false;
+                }
+                a = rotation == 0 ? x : rotation == 1 ? z : y;
+                b = rotation == 0 ? y : rotation == 1 ? x : z;
+                c = rotation == 0 ? z : rotation == 1 ? y : x;
+            } else
+            {
+                if (ip >= end)
+                {
+                    return false;
+                }
+                uint32_t codes_bc = *ip++;
+                if (!decode_vertex(code & 15, a) || !decode_vertex(codes_bc & 15, b) || !decode_vertex(codes_bc >> 4, c))
+                {
+                    return false;
+                }
+                push_edge(b, a);
+                push_edge(c, b);
+                push_edge(a, c);
+            }
+
+            combined |= a | b | c;
+            size_t slot = i % s_index_batch_size;
+            batch[slot * 3] = static_cast<T>(a);
+            batch[slot * 3 + 1] = static_cast<T>(b);
+            batch[slot * 3 + 2] = static_cast<T>(c);
+            if (slot == s_index_batch_size - 1 || i == triangle_count - 1)
+            {
+                std::memcpy(output + (i - slot) * 3 * sizeof(T), batch.data(), (slot + 1) * 3 * sizeof(T));
+            }
+        }
+        // 16-bit index past 0xFFFF can only come from a corrupt stream
+        return ip == end && combined <= std::numeric_limits<T>::max();
+    }
+
+    // Vertex codec
+    // Stream holds groups of 16 vertices, a group has 2 bits of mode per byte plane, then packed deltas of every plane
+    // Mode is the width of zigzag deltas of plane, 0, 2, 4 or 8 bits, last group is padded with last vertex
+    static constexpr uint32_t s_vertex_group_size = 16;
+
+    static constexpr std::array<uint32_t, 4> s_mode_byte_widths = { 0, 4, 8, 16 };
+
+    // 4 deltas of 2 bits to 4 bytes, first delta in lowest bits
+    static constexpr auto s_unpack_2bit = []()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t byte = 0; byte < 256; ++byte)
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                table[byte] |= ((byte >> (i * 2)) & 3u) << (i * 8);
+            }
+        }
+        return table;
+    }();
+
+    // Data bytes of the 4 planes described by one mode byte
+    static constexpr auto s_mode_group_byte_widths = []()
+    {
+        std::array<uint8_t, 256> table{};
+        for (uint32_t byte = 0; byte < 256; ++byte)
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                table[byte] = static_cast<uint8_t>(table[byte] + s_mode_byte_widths[(byte >> (i * 2)) & 3u]);
+            }
+        }
+        return table;
+    }();
+
+    std::vector<uint8_t> encode_vertex_stream(const void* vertices, size_t vertex_count, uint32_t vertex_stride)
+    {
+        if (vertex_stride == 0 || vertex_stride % 4 != 0 || vertex_stride > mesh_codec_max_vertex_stride ||
+            vertex_count > std::numeric_limits<uint32_t>::max())
+        {
+            return {};
+        }
+
+        auto source = static_cast<const uint8_t*>(vertices);
+        std::vector<uint8_t> encoded{};
+        write_header(encoded, MeshStreamKind::Vertex, vertex_stride, vertex_count);
+        encoded.reserve(encoded.size() + vertex_count * vertex_stride);
+
+        std::vector<uint8_t> previous(vertex_stride, 0);
+        std::array<uint8_t, s_vertex_group_size> deltas{};
+        for (size_t base = 0; base < vertex_count; base += s_vertex_group_size)
+        {
+            size_t mode_offset = encoded.size();
+            encoded.resize(mode_offset + vertex_stride / 4, 0);
+            for (uint32_t k = 0; k < vertex_stride; ++k)
+            {
+                uint8_t last = previous[k];
+                uint8_t max_delta = 0;
+                for (size_t i = 0; i < s_vertex_group_size; ++i)
+                {
+                    uint8_t value = source[std::min(base + i, vertex_count - 1) * vertex_stride + k];
+                    auto delta = static_cast<uint8_t>(value - last);
+                    deltas[i] = static_cast<uint8_t>((delta << 1) ^ (static_cast<int8_t>(delta) >> 7));
+                    max_delta = std::max(max_delta, deltas[i]);
+                    last = value;
+                }
+                previous[k] = last;
+
+                uint32_t mode = max_delta == 0 ? 0 : max_delta < 4 ? 1 : max_delta < 16 ? 2 : 3;
+                encoded[mode_offset + k / 4] |= static_cast<uint8_t>(mode << (k % 4 * 2));
+                if (mode == 1)
+                {
+                    for (size_t i = 0; i < s_vertex_group_size; i += 4)
+                    {
+                        encoded.push_back(static_cast<uint8_t>(deltas[i] | (deltas[i + 1] << 2) | (deltas[i + 2] << 4) | (deltas[i + 3] << 6)));
+                    }
+                } else if (mode == 2)
+                {
+                    for (size_t i = 0; i < s_vertex_group_size; i += 2)
+                    {
+                        encoded.push_back(static_cast<uint8_t>(deltas[i] | (deltas[i + 1] << 4)));
+                    }
+                } else if (mode == 3)
+                {
+                    encoded.insert(encoded.end(), deltas.begin(), deltas.end());
+                }
+            }
+        }
+        return encoded;
+    }
+
+    // Zigzag deltas of 16 vertices of one plane
+    static inline __m128i unpack_plane(const uint8_t*& ip, uint32_t mode)
+    {
+        switch (mode)
+        {
+            case 0:
+                return _mm_setzero_si128();
+            case 1:
+            {
+                __m128i deltas = _mm_set_epi32(static_cast<int32_t>(s_unpack_2bit[ip[3]]), static_cast<int32_t>(s_unpack_2bit[ip[2]]),
+                                               static_cast<int32_t>(s_unpack_2bit[ip[1]]), static_cast<int32_t>(s_unpack_2bit[ip[0]]));
+                ip += 4;
+                return deltas;
+            }
+            case 2:
+            {
+                __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ip));
+                __m128i mask = _mm_set1_epi8(0x0F);
+                ip += 8;
+                return _mm_unpacklo_epi8(_mm_and_si128(packed, mask), _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+            }
+            default:
+            {
+                __m128i deltas = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ip));
+                ip += 16;
+                return deltas;
+            }
+        }
+    }
+
+    // Undo zigzag and delta coding, previous holds last value of plane broadcast to every byte
+    static inline __m128i decode_plane(__m128i zigzag, __m128i& previous)
+    {
+        __m128i delta = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(zigzag, 1), _mm_set1_epi8(0x7F)),
+                                      _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(zigzag, _mm_set1_epi8(1))));
+        // Prefix sum over the 16 vertices
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 1));
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 2));
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 8));
+        __m128i values = _mm_add_epi8(delta, previous);
+
+        __m128i last = _mm_unpackhi_epi8(values, values);
+        last = _mm_unpackhi_epi16(last, last);
+        previous = _mm_shuffle_epi32(last, 0xFF);
+        return values;
+    }
+
+    // Interleave 4 planes of 16 vertices into 4 consecutive bytes of every vertex
+    static inline void store_planes(uint8_t* output, size_t vertex_stride, __m128i p0, __m128i p1, __m128i p2, __m128i p3)
+    {
+        __m128i t0 = _mm_unpacklo_epi8(p0, p1);
+        __m128i t1 = _mm_unpackhi_epi8(p0, p1);
+        __m128i t2 = _mm_unpacklo_epi8(p2, p3);
+        __m128i t3 = _mm_unpackhi_epi8(p2, p3);
+        __m128i rows[4] = { _mm_unpacklo_epi16(t0, t2), _mm_unpackhi_epi16(t0, t2), _mm_unpacklo_epi16(t1, t3), _mm_unpackhi_epi16(t1, t3) };
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+            __m128i vertices = rows[row];
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                auto value = static_cast<uint32_t>(_mm_cvtsi128_si32(vertices));
+                std::memcpy(output + (row * 4 + i) * vertex_stride, &value, sizeof(uint32_t));
+                vertices = _mm_srli_si128(vertices, 4);
+            }
+        }
+    }
+
+    static bool decode_vertex_stream(const uint8_t* ip, const uint8_t* end, uint8_t* output, size_t vertex_count, uint32_t vertex_stride)
+    {
+        // Last value of every byte plane, broadcast
+        __m128i previous[mesh_codec_max_vertex_stride];
+        std::fill_n(previous, vertex_stride, _mm_setzero_si128());
+        std::array<uint8_t, s_vertex_group_size * mesh_codec_max_vertex_stride> tail{};
+        uint32_t mode_byte_width = vertex_stride / 4;
+        for (size_t base = 0; base < vertex_count; base += s_vertex_group_size)
+        {
+            if (static_cast<size_t>(end - ip) < mode_byte_width)
+            {
+                return false;
+            }
+            const uint8_t* modes = ip;
+            ip += mode_byte_width;
+            size_t data_byte_width = 0;
+            for (uint32_t i = 0; i < mode_byte_width; ++i)
+            {
+                data_byte_width += s_mode_group_byte_widths[modes[i]];
+            }
+            if (static_cast<size_t>(end - ip) < data_byte_width)
+            {
+                return false;
+            }
+
+            // Padded last group is decoded aside, only its real vertices are copied out
+            size_t group_vertex_count = std::min<size_t>(s_vertex_group_size, vertex_count - base);
+            uint8_t* group_output = group_vertex_count == s_vertex_group_size ? output + base * vertex_stride : tail.data();
+            for (uint32_t k = 0; k < vertex_stride; k += 4)
+            {
+                uint32_t mode = modes[k / 4];
+                __m128i p0 = decode_plane(unpack_plane(ip, mode & 3), previous[k]);
+                __m128i p1 = decode_plane(unpack_plane(ip, (mode >> 2) & 3), previous[k + 1]);
+                __m128i p2 = decode_plane(unpack_plane(ip, (mode >> 4) & 3), previous[k + 2]);
+                __m128i p3 = decode_plane(unpack_plane(ip, mode >> 6), previous[k + 3]);
+                store_planes(group_output + k, vertex_stride, p0, p1, p2, p3);
+            }
+            if (group_output == tail.data())
+            {
+                std::memcpy(output + base * vertex_stride, tail.data(), group_vertex_count * vertex_stride);
+            }
+        }
+        return ip == end;
+    }
+
+    static std::optional<MeshStreamHeader> read_header(std::span<const uint8_t> encoded)
+    {
+        if (encoded.size() < sizeof(MeshStreamHeader))
+        {
+            return std::nullopt;
+        }
+        MeshStreamHeader header{};
+        std::memcpy(&header, encoded.data(), sizeof(MeshStreamHeader));
+        bool valid = header.version == mesh_codec_version &&
+            ((header.kind == MeshStreamKind::Index && (header.stride == sizeof(uint16_t) || header.stride == sizeof(uint32_t)) && header.count % 3 == 0) ||
+             (header.kind == MeshStreamKind::Vertex && header.stride != 0 && header.stride % 4 == 0 && header.stride <= mesh_codec_max_vertex_stride));
+        return valid ? std::optional<MeshStreamHeader>(header) : std::nullopt;
+    }
+
+    size_t get_decoded_byte_width(std::span<const uint8_t> encoded)
+    {
+        auto header = read_header(encoded);
+        return header ? static_cast<size_t>(header->count) * header->stride : 0;
+    }
+
+    bool decode_mesh_stream(std::span<const uint8_t> encoded, std::span<uint8_t> output)
+    {
+        auto header = read_header(encoded);
+        if (!header || output.size() != static_cast<size_t>(header->count) * header->stride)
+        {
+            return false;
+        }
+        const uint8_t* ip = encoded.data() + sizeof(MeshStreamHeader);
+        const uint8_t* end = encoded.data() + encoded.size();
+        if (header->kind == MeshStreamKind::Index)
+        {
+            return header->stride == sizeof(uint16_t) ? decode_index_buffer<uint16_t>(ip, end, output.data(), header->count) :
+                                                        decode_index_buffer<uint32_t>(ip, end, output.data(), header->count);
+        }
+        return decode_vertex_stream(ip, end, output.data(), header->count, header->stride);
+    }
+}
@@ -0,0 +1,481 @@
+//
+// Created by ZZK on 2023/5/31.
+//
+
+#include <Toy/Model/mesh_import.h>
+#include <Toy/Model/mapped_io_system.h>
+#include <Toy/Model/mesh_optimizer.h>
+#include <Toy/Model/material.h>
+#include <Toy/Model/texture_streaming.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Core/parallel.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+namespace toy::model
+{
+    // Import post processing, part of processed mesh cache key
+    static constexpr uint32_t s_import_flags =
+        aiProcess_ConvertToLeftHanded |                 // Left hand coordinate
+        aiProcess_CalcTangentSpace |                    // Tangent space
+        aiProcess_GenBoundingBoxes |                    // Generate bounding box
+        aiProcess_Triangulate |                         // Polygon splitting
+        aiProcess_SortByPType;                          // Can remove no-triangle primitive
+    // Remove point and line primitive
+    static constexpr uint32_t s_import_removed_primitives = aiPrimitiveType_LINE | aiPrimitiveType_POINT;
+
+    XID import_cache_key(std::string_view file_name, VertexEncoding vertex_encoding, MeshStreamStorage stream_storage)
+    {
+        return mesh_cache_key(file_name, s_import_flags, s_import_removed_primitives, vertex_encoding, stream_storage);
+    }
+
+    // Streams of one imported mesh in upload order, see optimize_mesh
+    struct ImportedMesh
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT4> tangents;
+        std::vector<DirectX::XMFLOAT4> bitangents;
+        std::vector<std::vector<DirectX::XMFLOAT2>> texcoords;
+        std::vector<uint32_t> indices;
+        float uv_density = 0.0f;
+        MeshStatistics statistics_before;
+        MeshStatistics statistics_after;
+    };
+
+    // Copy streams out of Assimp mesh, then weld and reorder for vertex cache, overdraw and vertex fetch
+    // Only reads the mesh, so meshes of a scene can be processed in parallel
+    static ImportedMesh optimize_imported_mesh(const aiMesh* ai_mesh)
+    {
+        using namespace DirectX;
+        ImportedMesh mesh{};
+        uint32_t num_vertices = ai_mesh->mNumVertices;
+        std::span<const XMFLOAT3> positions{ reinterpret_cast<const XMFLOAT3 *>(ai_mesh->mVertices), num_vertices };
+
+        mesh.indices.resize(ai_mesh->mNumFaces * 3);
+        for (uint32_t i = 0; i < ai_mesh->mNumFaces; ++i)
+        {
+            std::memcpy(mesh.indices.data() + i * 3, ai_mesh->mFaces[i].mIndices, sizeof(uint32_t) * 3);
+        }
+
+        uint32_t num_uvs = mesh_cache_max_texcoords;
+        while (num_uvs && !ai_mesh->HasTextureCoords(num_uvs - 1))
+        {
+            num_uvs--;
+        }
+
+        // Every imported stream takes part in welding, Assimp texture coordinates are 3D of which uv is compared
+        std::vector<VertexStreamView> attributes{};
+        auto add_attribute = [&attributes](const aiVector3D* data, size_t byte_width)
+        {
+            attributes.push_back({ data, sizeof(aiVector3D), byte_width });
+        };
+        if (ai_mesh->HasNormals())
+        {
+            add_attribute(ai_mesh->mNormals, sizeof(aiVector3D));
+        }
+        if (ai_mesh->HasTangentsAndBitangents())
+        {
+            add_attribute(ai_mesh->mTangents, sizeof(aiVector3D));
+            add_attribute(ai_mesh->mBitangents, sizeof(aiVector3D));
+        }
+        for (uint32_t row = 0; row < num_uvs; ++row)
+        {
+            add_attribute(ai_mesh->mTextureCoords[row], sizeof(XMFLOAT2));
+        }
+
+        mesh.statistics_before = analyze_mesh(mesh.indices, positions);
+        auto remap = optimize_mesh(mesh.indices, positions, attributes);
+        mesh.positions = remap_vertex_stream(positions, remap);
+        mesh.statistics_after = analyze_mesh(mesh.indices, mesh.positions);
+
+        if (ai_mesh->HasNormals())
+        {
+            mesh.normals = remap_vertex_stream<XMFLOAT3>({ reinterpret_cast<const XMFLOAT3 *>(ai_mesh->mNormals), num_vertices }, remap);
+        }
+        if (ai_mesh->HasTangentsAndBitangents())
+        {
+            mesh.tangents.resize(remap.size());
+            mesh.bitangents.resize(remap.size());
+            for (size_t i = 0; i < remap.size(); ++i)
+            {
+                auto&& t = ai_mesh->mTangents[remap[i]];
+                auto&& b = ai_mesh->mBitangents[remap[i]];
+                mesh.tangents[i] = XMFLOAT4{ t.x, t.y, t.z, 1.0f };
+                mesh.bitangents[i] = XMFLOAT4{ b.x, b.y, b.z, 1.0f };
+            }
+        }
+
+        mesh.texcoords.resize(num_uvs);
+        for (uint32_t row = 0; row < num_uvs; ++row)
+        {
+            mesh.texcoords[row].resize(remap.size());
+            for (size_t col = 0; col < remap.size(); ++col)
+            {
+                auto&& uv = ai_mesh->mTextureCoords[row][remap[col]];
+                mesh.texcoords[row][col] = XMFLOAT2{ uv.x, uv.y };
+            }
+        }
+        if (num_uvs > 0)
+        {
+            mesh.uv_density = compute_uv_density(mesh.indices, mesh.positions, mesh.texcoords[0]);
+        }
+        return mesh;
+    }
+
+    // Quantize mesh into 16-bit indexable chunks, every chunk becomes a cache mesh sharing the material
+    // Return full precision and quantized byte width of streams
+    static std::pair<size_t, size_t> append_quantized_mesh(MeshCacheWriter& writer, const ImportedMesh& imported_mesh,
+                                                           uint32_t material_index, [[maybe_unused]] std::string_view mesh_name)
+    {
+        using namespace DirectX;
+        size_t num_vertices = imported_mesh.positions.size();
+        VertexStreams streams{};
+        streams.positions = imported_mesh.positions;
+        streams.normals = imported_mesh.normals;
+
+        auto tangents = make_handed_tangents(imported_mesh.normals, imported_mesh.tangents, imported_mesh.bitangents);
+        streams.tangents = tangents;
+
+        auto num_uvs = static_cast<uint32_t>(imported_mesh.texcoords.size());
+        for (auto&& uvs : imported_mesh.texcoords)
+        {
+            streams.texcoords.emplace_back(uvs);
+        }
+        streams.indices = imported_mesh.indices;
+
+        auto chunks = quantize_vertex_streams(streams);
+#if defined(_DEBUG)
+        auto error = measure_quantization_error(streams, chunks);
+        BoundingBox bounding_box{};
+        BoundingBox::CreateFromPoints(bounding_box, num_vertices, streams.positions.data(), sizeof(XMFLOAT3));
+        if (!within_error_bounds(error, bounding_box))
+        {
+            DX_CORE_WARN("Quantization error of mesh '{}' out of bounds: position {}, normal {}, tangent {}, texcoord {}",
+                         mesh_name, error.position, error.normal, error.tangent, error.texcoord);
+        }
+#endif
+
+        for (auto&& chunk : chunks)
+        {
+            auto&& mesh = writer.meshes().emplace_back();
+            mesh.vertex_count = static_cast<uint32_t>(chunk.positions.size());
+            mesh.index_count = static_cast<uint32_t>(chunk.indices.size());
+            mesh.index_stride = sizeof(uint16_t);
+            mesh.texcoord_count = num_uvs;
+            mesh.material_index = material_index;
+            mesh.vertex_encoding = static_cast<uint32_t>(VertexEncoding::Quantized);
+            mesh.uv_density = imported_mesh.uv_density;
+            mesh.bounding_box = chunk.bounding_box;
+
+            mesh.positions = writer.append_vertex_stream(chunk.positions.data(), chunk.positions.size(), sizeof(PackedVector::XMUSHORTN4));
+            mesh.normals = writer.append_vertex_stream(chunk.normals.data(), chunk.normals.size(), sizeof(PackedVector::XMSHORTN2));
+            mesh.tangents = writer.append_vertex_stream(chunk.tangents.data(), chunk.tangents.size(), sizeof(PackedVector::XMSHORTN2));
+            for (uint32_t row = 0; row < num_uvs; ++row)
+            {
+                mesh.texcoords[row] = writer.append_vertex_stream(chunk.texcoords[row].data(), chunk.texcoords[row].size(), sizeof(PackedVector::XMHALF2));
+            }
+            mesh.indices = writer.append_index_buffer(chunk.indices.data(), chunk.indices.size(), sizeof(uint16_t));
+        }
+
+        return { full_precision_byte_width(num_vertices, imported_mesh.indices.size(), num_uvs), quantized_byte_width(chunks) };
+    }
+
+    std::vector<uint8_t> import_model(std::string_view file_name, XID cache_key, VertexEncoding vertex_encoding, MeshStreamStorage stream_storage)
+    {
+        static_assert(sizeof(aiVector3D) == sizeof(DirectX::XMFLOAT3), "size of aiVector3D is not equal to sizeof DirectX::XMFLOAT3");
+
+        Assimp::Importer importer;
+        // Read source and sibling files from asset packs or through memory mapping, importer takes ownership of IO system
+        auto io_system = new MappedIOSystem(file_name);
+        importer.SetIOHandler(io_system);
+        importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, s_import_removed_primitives);
+        auto assimp_scene = importer.ReadFile(file_name.data(), s_import_flags);
+
+        if (!assimp_scene || (assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !assimp_scene->HasMeshes())
+        {
+            DX_CORE_CRITICAL("Fail to load model asset, model file '{0}' may be incomplete", file_name);
+        }
+
+        // Meshes are independent, optimise them on worker threads, then pack sequentially
+        std::vector<ImportedMesh> imported_meshes(assimp_scene->mNumMeshes);
+        parallel_for(imported_meshes.size(), [&imported_meshes, &assimp_scene](size_t i)
+        {
+            imported_meshes[i] = optimize_imported_mesh(assimp_scene->mMeshes[i]);
+        });
+
+        using namespace DirectX;
+        MeshCacheWriter writer(cache_key, stream_storage);
+        // Sibling files such as material libraries decide materials and texture references, cache is stale once they change
+        XID source_path_id = path_to_id(file_name);
+        for (auto&& opened_file : io_system->get_opened_files())
+        {
+            if (path_to_id(opened_file) != source_path_id)
+            {
+                writer.add_dependency(opened_file);
+            }
+        }
+        auto&& materials = writer.materials();
+        materials.resize(assimp_scene->mNumMaterials);
+        BoundingBox model_bounding_box{};
+        std::pair<size_t, size_t> stream_byte_width{};
+        MeshStatistics statistics_before{};
+        MeshStatistics statistics_after{};
+        for (uint32_t i = 0; i < assimp_scene->mNumMeshes; ++i)
+        {
+            auto ai_mesh = assimp_scene->mMeshes[i];
+            auto&& imported_mesh = imported_meshes[i];
+            statistics_before += imported_mesh.statistics_before;
+            statistics_after += imported_mesh.statistics_after;
+
+            uint32_t num_vertices = ai_mesh->mNumVertices;
+            if (num_vertices > 0)
+            {
+                BoundingBox mesh_bounding_box{};
+                BoundingBox::CreateFromPoints(mesh_bounding_box, num_vertices, (const XMFLOAT3 *)ai_mesh->mVertices, sizeof(XMFLOAT3));
+                if (i == 0)
+                {
+                    model_bounding_box = mesh_bounding_box;
+                } else
+                {
+                    BoundingBox::CreateMerged(model_bounding_box, model_bounding_box, mesh_bounding_box);
+                }
+            }
+
+            if (vertex_encoding == VertexEncoding::Quantized && !imported_mesh.positions.empty())
+            {
+                auto [full_byte_width, quantized_byte_width] = append_quantized_mesh(writer, imported_mesh, ai_mesh->mMaterialIndex, ai_mesh->mName.C_Str());
+                stream_byte_width.first += full_byte_width;
+                stream_byte_width.second += quantized_byte_width;
+                continue;
+            }
+
+            // Unreferenced vertices are dropped by vertex fetch optimisation
+            num_vertices = static_cast<uint32_t>(imported_mesh.positions.size());
+            auto&& mesh = writer.meshes().emplace_back();
+            mesh.vertex_count = num_vertices;
+
+            // Position
+            if (num_vertices > 0)
+            {
+                mesh.positions = writer.append_vertex_stream(imported_mesh.positions.data(), num_vertices, sizeof(XMFLOAT3));
+                BoundingBox::CreateFromPoints(mesh.bounding_box, num_vertices, imported_mesh.positions.data(), sizeof(XMFLOAT3));
+            }
+            // Normal
+            if (!imported_mesh.normals.empty())
+            {
+                mesh.normals = writer.append_vertex_stream(imported_mesh.normals.data(), num_vertices, sizeof(XMFLOAT3));
+            }
+            // Tangent and bitangent
+            if (!imported_mesh.tangents.empty())
+            {
+                mesh.tangents = writer.append_vertex_stream(imported_mesh.tangents.data(), num_vertices, sizeof(XMFLOAT4));
+                mesh.bitangents = writer.append_vertex_stream(imported_mesh.bitangents.data(), num_vertices, sizeof(XMFLOAT4));
+            }
+            // Texture coordinates
+            auto num_uvs = static_cast<uint32_t>(imported_mesh.texcoords.size());
+            mesh.texcoord_count = num_uvs;
+            for (uint32_t row = 0; row < num_uvs; ++row)
+            {
+                mesh.texcoords[row] = writer.append_vertex_stream(imported_mesh.texcoords[row].data(), num_vertices, sizeof(XMFLOAT2));
+            }
+            // Index
+            auto num_indices = static_cast<uint32_t>(imported_mesh.indices.size());
+            mesh.index_stride = num_indices < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (num_indices > 0)
+            {
+                mesh.index_count = num_indices;
+                if (num_indices < 65536)
+                {
+                    std::vector<uint16_t> indices(imported_mesh.indices.begin(), imported_mesh.indices.end());
+                    mesh.indices = writer.append_index_buffer(indices.data(), num_indices, sizeof(uint16_t));
+                } else
+                {
+                    mesh.indices = writer.append_index_buffer(imported_mesh.indices.data(), num_indices, sizeof(uint32_t));
+                }
+            }
+            // Material
+            mesh.material_index = ai_mesh->mMaterialIndex;
+            mesh.uv_density = imported_mesh.uv_density;
+        }
+        writer.set_bounding_box(model_bounding_box);
+
+        if (vertex_encoding == VertexEncoding::Quantized && stream_byte_width.first > 0)
+        {
+            DX_CORE_INFO("Model '{}' quantized vertex streams {:.2f} MB -> {:.2f} MB ({:.1f}%), geometry pass fetch {} -> {} bytes per vertex",
+                         file_name, static_cast<double>(stream_byte_width.first) / (1024.0 * 1024.0),
+                         static_cast<double>(stream_byte_width.second) / (1024.0 * 1024.0),
+                         100.0 * static_cast<double>(stream_byte_width.second) / static_cast<double>(stream_byte_width.first),
+                         full_precision_vertex_byte_width, quantized_vertex_byte_width);
+        }
+        log_mesh_statistics(file_name, statistics_before, statistics_after);
+
+        for (uint32_t i = 0; i < assimp_scene->mNumMaterials; ++i)
+        {
+            // Populate material first, then flatten it into cache record
+            Material material{};
+            auto ai_material = assimp_scene->mMaterials[i];
+            XMFLOAT4 vec{};
+            float value{};
+            uint32_t num = 3;
+            std::vector<MeshCacheProperty> properties{};
+
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_AMBIENT, (float*)&vec, &num))
+            {
+                material.set_color(MaterialSemantics::AmbientColor, vec);
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_DIFFUSE, (float*)&vec, &num))
+            {
+                material.set_color(MaterialSemantics::DiffuseColor, vec);
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_SPECULAR, (float*)&vec, &num))
+            {
+                material.set_color(MaterialSemantics::SpecularColor, vec);
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_SPECULAR_FACTOR, value))
+            {
+                material.set_scalar(MaterialSemantics::SpecularFactor, value);
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_EMISSIVE, (float*)&vec, &num))
+            {
+                properties.push_back({ "$EmissiveColor"_xid, vec });
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_OPACITY, value))
+            {
+                material.set_scalar(MaterialSemantics::Opacity, value);
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_TRANSPARENT, (float*)&vec, &num))
+            {
+                properties.push_back({ "$TransparentColor"_xid, vec });
+            }
+            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_REFLECTIVE, (float*)&vec, &num))
+            {
+                properties.push_back({ "$ReflectiveColor"_xid, vec });
+            }
+
+            auto&& cached_material = materials[i];
+            aiString ai_path{};
+            std::filesystem::path tex_file_name{};
+            std::string tex_name{};
+
+            // Texture references, textures are created when cache image is loaded
+            auto try_add_texture = [&file_name, &assimp_scene, &ai_material, &material, &cached_material, &writer, &ai_path, &tex_file_name, &tex_name]
+                            (aiTextureType type, MaterialSemantics semantics, bool gen_mips = false, uint32_t force_SRGB = 0)
+            {
+                if (!ai_material->GetTextureCount(type))
+                {
+                    return;
+                }
+
+                ai_material->GetTexture(type, 0, &ai_path);
+                auto&& texture = cached_material.textures[static_cast<uint32_t>(semantics)];
+                texture.gen_mips = gen_mips;
+                texture.force_SRGB = force_SRGB;
+
+                // If texture has been loaded
+                if (ai_path.data[0] == '*')
+                {
+                    tex_name = file_name;
+                    tex_name += ai_path.C_Str();
+                    char* end_str = nullptr;
+                    aiTexture* p_tex = assimp_scene->mTextures[std::strtol(ai_path.data + 1, &end_str, 10)];
+                    texture.source = MeshCacheTextureSource::Embedded;
+                    texture.data = writer.append_embedded_texture(tex_name, p_tex->pcData,
+                                                                    (p_tex->mHeight ? p_tex->mWidth * p_tex->mHeight * sizeof(aiTexel) : p_tex->mWidth));
+                }
+                // Texture indexed by file name
+                else
+                {
+                    tex_file_name = file_name;
+                    tex_file_name = tex_file_name.parent_path() / ai_path.C_Str();
+                    tex_name = tex_file_name.string();
+                    texture.source = MeshCacheTextureSource::File;
+                }
+                texture.name = writer.append_string(tex_name);
+                material.set_texture(semantics, string_to_id(tex_name));
+            };
+
+            // Collect textures
+            try_add_texture(aiTextureType_DIFFUSE, MaterialSemantics::DiffuseMap, true, 1);
+            try_add_texture(aiTextureType_SPECULAR, MaterialSemantics::SpecularMap, true, 1);
+            try_add_texture(aiTextureType_NORMALS, MaterialSemantics::NormalMap);
+            try_add_texture(aiTextureType_BASE_COLOR, MaterialSemantics::AlbedoMap, true, 1);
+            try_add_texture(aiTextureType_NORMAL_CAMERA, MaterialSemantics::NormalCameraMap);
+            try_add_texture(aiTextureType_METALNESS, MaterialSemantics::MetalnessMap);
+            try_add_texture(aiTextureType_DIFFUSE_ROUGHNESS, MaterialSemantics::RoughnessMap);
+            try_add_texture(aiTextureType_AMBIENT_OCCLUSION, MaterialSemantics::AmbientOcclusionMap);
+
+            // Set diffuse color and opacity and metalness and roughness material properties
+            if (!material.has(MaterialSemantics::DiffuseColor))
+            {
+                material.set_color(MaterialSemantics::DiffuseColor, XMFLOAT4{ 0.8f, 0.8f, 0.8f, 1.0f });
+            }
+            if (!material.has(MaterialSemantics::Opacity))
+            {
+                material.set_scalar(MaterialSemantics::Opacity, 1.0f);
+            }
+            if (!material.has(MaterialSemantics::Metalness))
+            {
+                material.set_scalar(MaterialSemantics::Metalness, 0.5f);
+            }
+            if (!material.has(MaterialSemantics::Roughness))
+            {
+                material.set_scalar(MaterialSemantics::Roughness, 0.5f);
+            }
+
+            cached_material.presence_mask = material.get_presence_mask();
+            for (uint32_t slot = 0; slot < material_color_count; ++slot)
+            {
+                cached_material.colors[slot] = material.get_color(static_cast<MaterialSemantics>(material_texture_count + slot));
+            }
+            for (uint32_t slot = 0; slot < material_scalar_count; ++slot)
+            {
+                cached_material.scalars[slot] = material.get_scalar(static_cast<MaterialSemantics>(material_texture_count + material_color_count + slot));
+            }
+            cached_material.property_count = static_cast<uint32_t>(properties.size());
+            cached_material.properties = writer.append(properties.data(), properties.size() * sizeof(MeshCacheProperty));
+        }
+
+        return writer.finish();
+    }
+
+    bool is_gltf_file(std::string_view file_name)
+    {
+        std::string extension = std::filesystem::path(file_name).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; });
+        return extension == ".gltf" || extension == ".glb";
+    }
+
+    BakeResult bake_mesh_cache(std::string_view file_name, VertexEncoding vertex_encoding, MeshStreamStorage stream_storage)
+    {
+        if (is_gltf_file(file_name))
+        {
+            return {};
+        }
+
+        XID cache_key = import_cache_key(file_name, vertex_encoding, stream_storage);
+        if (cache_key == 0)
+        {
+            DX_CORE_WARN("Fail to read model file '{}'", file_name);
+            return { BakeStatus::Failed, {} };
+        }
+        std::filesystem::path cache_path = mesh_cache_path(cache_key);
+        {
+            MappedFile cache_file(cache_path);
+            if (cache_file.is_open() && validate_mesh_cache(cache_file.bytes(), cache_key))
+            {
+                return { BakeStatus::Cached, { cache_path } };
+            }
+        }
+
+        std::vector<uint8_t> image = import_model(file_name, cache_key, vertex_encoding, stream_storage);
+        if (!save_mesh_cache(cache_path, image))
+        {
+            DX_CORE_WARN("Fail to write processed mesh cache of model '{}'", file_name);
+            return { BakeStatus::Failed, {} };
+        }
+        return { BakeStatus::Baked, { cache_path } };
+    }
+}
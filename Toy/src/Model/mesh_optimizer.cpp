@@ -0,0 +1,483 @@
+//
+// Created by ZZK on 2024/4/12.
+//
+
+#include <Toy/Model/mesh_optimizer.h>
+#include <Toy/Core/hash.h>
+
+namespace toy::model
+{
+    using namespace DirectX;
+
+    static constexpr uint32_t s_invalid_vertex = UINT32_MAX;
+
+    // FIFO post-transform cache, a vertex stays cached until vertex_cache_size newer vertices were transformed
+    struct VertexCache
+    {
+        std::vector<uint32_t> timestamps;
+        uint32_t timestamp = vertex_cache_size + 1;
+
+        explicit VertexCache(size_t vertex_count) : timestamps(vertex_count, 0) {}
+
+        [[nodiscard]] bool is_cached(uint32_t vertex) const { return timestamp - timestamps[vertex] <= vertex_cache_size; }
+
+        // Return true on cache miss
+        bool fetch(uint32_t vertex)
+        {
+            if (is_cached(vertex))
+            {
+                return false;
+            }
+            timestamps[vertex] = timestamp++;
+            return true;
+        }
+
+        void flush() { timestamp += vertex_cache_size + 1; }
+    };
+
+    static XMFLOAT3 subtract(const XMFLOAT3 &a, const XMFLOAT3 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    static XMFLOAT3 cross(const XMFLOAT3 &a, const XMFLOAT3 &b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    static float dot(const XMFLOAT3 &a, const XMFLOAT3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    static float component(const XMFLOAT3 &v, uint32_t axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+
+    static void validate_indices(std::span<const uint32_t> indices, size_t vertex_count)
+    {
+        for (auto index : indices)
+        {
+            if (index >= vertex_count)
+            {
+                DX_CORE_CRITICAL("Vertex index {} out of range of {} vertices", index, vertex_count);
+            }
+        }
+    }
+
+    MeshStatistics& MeshStatistics::operator+=(const MeshStatistics &other)
+    {
+        triangle_count += other.triangle_count;
+        vertex_count += other.vertex_count;
+        transformed_vertex_count += other.transformed_vertex_count;
+        shaded_pixel_count += other.shaded_pixel_count;
+        covered_pixel_count += other.covered_pixel_count;
+        return *this;
+    }
+
+    // Rasterize mesh in index order looking along +axis or -axis, with depth test and back face culling
+    static void analyze_overdraw(std::span<const uint32_t> indices, std::span<const XMFLOAT3> positions,
+                                 const BoundingBox &bounding_box, uint32_t axis, float direction, MeshStatistics &statistics)
+    {
+        uint32_t u_axis = (axis + 1) % 3;
+        uint32_t v_axis = (axis + 2) % 3;
+        XMFLOAT3 forward{};
+        (axis == 0 ? forward.x : (axis == 1 ? forward.y : forward.z)) = direction;
+
+        // Uniform scale so that every view keeps aspect of mesh
+        XMFLOAT3 minimum = subtract(bounding_box.Center, bounding_box.Extents);
+        float extent = 2.0f * std::max({ bounding_box.Extents.x, bounding_box.Extents.y, bounding_box.Extents.z });
+        float scale = extent > 0.0f ? static_cast<float>(overdraw_grid_size) / extent : 0.0f;
+
+        std::vector<float> depth_buffer(overdraw_grid_size * overdraw_grid_size, std::numeric_limits<float>::infinity());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const XMFLOAT3& a = positions[indices[i]];
+            const XMFLOAT3& b = positions[indices[i + 1]];
+            const XMFLOAT3& c = positions[indices[i + 2]];
+            // Front face normal points toward viewer
+            if (dot(cross(subtract(b, a), subtract(c, a)), forward) >= 0.0f)
+            {
+                continue;
+            }
+
+            XMFLOAT3 screen[3]{};
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const XMFLOAT3& position = positions[indices[i + corner]];
+                screen[corner] = {
+                    (component(position, u_axis) - component(minimum, u_axis)) * scale,
+                    (component(position, v_axis) - component(minimum, v_axis)) * scale,
+                    component(position, axis) * direction
+                };
+            }
+            auto edge = [](const XMFLOAT3& p0, const XMFLOAT3& p1, float x, float y) { return (p1.x - p0.x) * (y - p0.y) - (p1.y - p0.y) * (x - p0.x); };
+            float area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+            if (area == 0.0f)
+            {
+                continue;
+            }
+
+            auto to_pixel = [](float value) { return std::clamp(static_cast<int32_t>(value), 0, static_cast<int32_t>(overdraw_grid_size) - 1); };
+            int32_t min_x = to_pixel(std::min({ screen[0].x, screen[1].x, screen[2].x }));
+            int32_t max_x = to_pixel(std::max({ screen[0].x, screen[1].x, screen[2].x }));
+            int32_t min_y = to_pixel(std::min({ screen[0].y, screen[1].y, screen[2].y }));
+            int32_t max_y = to_pixel(std::max({ screen[0].y, screen[1].y, screen[2].y }));
+            for (int32_t y = min_y; y <= max_y; ++y)
+            {
+                for (int32_t x = min_x; x <= max_x; ++x)
+                {
+                    float center_x = static_cast<float>(x) + 0.5f;
+                    float center_y = static_cast<float>(y) + 0.5f;
+                    float w0 = edge(screen[1], screen[2], center_x, center_y) / area;
+                    float w1 = edge(screen[2], screen[0], center_x, center_y) / area;
+                    float w2 = edge(screen[0], screen[1], center_x, center_y) / area;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                    {
+                        continue;
+                    }
+
+                    float depth = w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z;
+                    auto&& stored_depth = depth_buffer[y * overdraw_grid_size + x];
+                    if (depth < stored_depth)
+                    {
+                        stored_depth = depth;
+                        ++statistics.shaded_pixel_count;
+                    }
+                }
+            }
+        }
+
+        statistics.covered_pixel_count += std::count_if(depth_buffer.begin(), depth_buffer.end(), [](float depth) { return depth != std::numeric_limits<float>::infinity(); });
+    }
+
+    MeshStatistics analyze_mesh(std::span<const uint32_t> indices, std::span<const XMFLOAT3> positions)
+    {
+        validate_indices(indices, positions.size());
+
+        MeshStatistics statistics{};
+        statistics.triangle_count = indices.size() / 3;
+
+        VertexCache cache(positions.size());
+        std::vector<bool> referenced(positions.size(), false);
+        for (size_t i = 0; i < statistics.triangle_count * 3; ++i)
+        {
+            statistics.transformed_vertex_count += cache.fetch(indices[i]) ? 1 : 0;
+            if (!referenced[indices[i]])
+            {
+                referenced[indices[i]] = true;
+                ++statistics.vertex_count;
+            }
+        }
+
+        if (statistics.triangle_count > 0)
+        {
+            BoundingBox bounding_box{};
+            BoundingBox::CreateFromPoints(bounding_box, positions.size(), positions.data(), sizeof(XMFLOAT3));
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                analyze_overdraw(indices, positions, bounding_box, axis, 1.0f, statistics);
+                analyze_overdraw(indices, positions, bounding_box, axis, -1.0f, statistics);
+            }
+        }
+        return statistics;
+    }
+
+    size_t weld_vertices(std::span<uint32_t> indices, size_t vertex_count, std::span<const VertexStreamView> streams)
+    {
+        validate_indices(indices, vertex_count);
+
+        auto vertex_bytes = [](const VertexStreamView& stream, uint32_t vertex)
+        {
+            return static_cast<const uint8_t *>(stream.data) + vertex * stream.stride;
+        };
+        auto vertex_hash = [&streams, &vertex_bytes](uint32_t vertex)
+        {
+            uint64_t result = 0;
+            for (auto&& stream : streams)
+            {
+                result = hash::combine(result, hash::xxhash_64(vertex_bytes(stream, vertex), stream.byte_width));
+            }
+            return result;
+        };
+        auto vertex_equal = [&streams, &vertex_bytes](uint32_t a, uint32_t b)
+        {
+            return std::all_of(streams.begin(), streams.end(), [&vertex_bytes, a, b](const VertexStreamView& stream)
+            {
+                return std::memcmp(vertex_bytes(stream, a), vertex_bytes(stream, b), stream.byte_width) == 0;
+            });
+        };
+
+        // Hash buckets hold first vertex of every distinct value, full comparison resolves hash collisions
+        std::unordered_multimap<uint64_t, uint32_t> unique_vertices{};
+        unique_vertices.reserve(vertex_count);
+        std::vector<uint32_t> canonical(vertex_count);
+        for (uint32_t vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            uint64_t key = vertex_hash(vertex);
+            canonical[vertex] = vertex;
+            auto [begin, end] = unique_vertices.equal_range(key);
+            auto it = std::find_if(begin, end, [&vertex_equal, vertex](const auto& entry) { return vertex_equal(entry.second, vertex); });
+            if (it != end)
+            {
+                canonical[vertex] = it->second;
+            } else
+            {
+                unique_vertices.emplace(key, vertex);
+            }
+        }
+
+        for (auto&& index : indices)
+        {
+            index = canonical[index];
+        }
+        return unique_vertices.size();
+    }
+
+    std::vector<uint32_t> optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count)
+    {
+        // Tipsify, Sander et al. 2007
+        // Fan around a vertex, then pick next fanning vertex among the vertices just emitted,
+        // preferring vertices still in cache whose remaining triangles can be emitted before they are evicted
+        std::vector<uint32_t> clusters{};
+        size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+        {
+            return clusters;
+        }
+        validate_indices(indices, vertex_count);
+
+        // Vertex to triangle adjacency in compressed rows
+        std::vector<uint32_t> live_triangles(vertex_count, 0);
+        for (size_t i = 0; i < triangle_count * 3; ++i)
+        {
+            ++live_triangles[indices[i]];
+        }
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        std::partial_sum(live_triangles.begin(), live_triangles.end(), adjacency_offsets.begin() + 1);
+        std::vector<uint32_t> adjacency(triangle_count * 3);
+        {
+            std::vector<uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < triangle_count * 3; ++i)
+            {
+                adjacency[fill_offsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<uint32_t> result{};
+        result.reserve(triangle_count * 3);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> dead_end_stack{};
+        std::vector<uint32_t> candidates{};
+        VertexCache cache(vertex_count);
+        size_t cursor = 0;
+
+        clusters.push_back(0);
+        uint32_t fanning_vertex = indices[0];
+        while (fanning_vertex != s_invalid_vertex)
+        {
+            candidates.clear();
+            for (uint32_t a = adjacency_offsets[fanning_vertex]; a < adjacency_offsets[fanning_vertex + 1]; ++a)
+            {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                emitted[triangle] = true;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t vertex = indices[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    dead_end_stack.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --live_triangles[vertex];
+                    cache.fetch(vertex);
+                }
+            }
+
+            uint32_t next_vertex = s_invalid_vertex;
+            int64_t best_priority = -1;
+            for (auto candidate : candidates)
+            {
+                if (live_triangles[candidate] == 0)
+                {
+                    continue;
+                }
+                int64_t priority = 0;
+                uint32_t age = cache.timestamp - cache.timestamps[candidate];
+                if (age + 2 * live_triangles[candidate] <= vertex_cache_size)
+                {
+                    priority = age;
+                }
+                if (priority > best_priority)
+                {
+                    best_priority = priority;
+                    next_vertex = candidate;
+                }
+            }
+
+            if (next_vertex == s_invalid_vertex)
+            {
+                // Dead end, resume from recently emitted vertices, then from input order
+                while (!dead_end_stack.empty() && next_vertex == s_invalid_vertex)
+                {
+                    uint32_t vertex = dead_end_stack.back();
+                    dead_end_stack.pop_back();
+                    next_vertex = live_triangles[vertex] > 0 ? vertex : s_invalid_vertex;
+                }
+                for (; cursor < vertex_count && next_vertex == s_invalid_vertex; ++cursor)
+                {
+                    next_vertex = live_triangles[cursor] > 0 ? static_cast<uint32_t>(cursor) : s_invalid_vertex;
+                }
+                if (next_vertex != s_invalid_vertex)
+                {
+                    clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+                }
+            }
+            fanning_vertex = next_vertex;
+        }
+
+        std::copy(result.begin(), result.end(), indices.begin());
+        return clusters;
+    }
+
+    void optimize_overdraw(std::span<uint32_t> indices, std::span<const XMFLOAT3> positions,
+                           std::span<const uint32_t> clusters, float threshold)
+    {
+        size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0 || clusters.empty())
+        {
+            return;
+        }
+        validate_indices(indices, positions.size());
+
+        // Split hard clusters where running ACMR drops to threshold * ACMR of whole cluster,
+        // reordering such soft clusters costs at most threshold in vertex cache efficiency
+        std::vector<uint32_t> soft_clusters{};
+        VertexCache cache(positions.size());
+        auto triangle_misses = [&cache, &indices](size_t triangle)
+        {
+            uint32_t misses = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                misses += cache.fetch(indices[triangle * 3 + corner]) ? 1 : 0;
+            }
+            return misses;
+        };
+        for (size_t c = 0; c < clusters.size(); ++c)
+        {
+            size_t begin = clusters[c];
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+
+            cache.flush();
+            size_t cluster_misses = 0;
+            for (size_t t = begin; t < end; ++t)
+            {
+                cluster_misses += triangle_misses(t);
+            }
+            float cluster_threshold = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+            cache.flush();
+            soft_clusters.push_back(static_cast<uint32_t>(begin));
+            size_t misses = 0;
+            size_t faces = 0;
+            for (size_t t = begin; t < end; ++t)
+            {
+                misses += triangle_misses(t);
+                ++faces;
+                if (t + 1 < end && static_cast<float>(misses) <= cluster_threshold * static_cast<float>(faces))
+                {
+                    soft_clusters.push_back(static_cast<uint32_t>(t + 1));
+                    cache.flush();
+                    misses = 0;
+                    faces = 0;
+                }
+            }
+        }
+
+        // Area weighted centroid and normal of every cluster
+        struct ClusterInfo
+        {
+            XMFLOAT3 centroid{};
+            XMFLOAT3 normal{};
+            float area = 0.0f;
+            float sort_key = 0.0f;
+            uint32_t begin = 0;
+            uint32_t end = 0;
+        };
+        std::vector<ClusterInfo> infos(soft_clusters.size());
+        XMFLOAT3 mesh_centroid{};
+        float mesh_area = 0.0f;
+        for (size_t cluster = 0; cluster < soft_clusters.size(); ++cluster)
+        {
+            auto&& info = infos[cluster];
+            info.begin = soft_clusters[cluster];
+            info.end = cluster + 1 < soft_clusters.size() ? soft_clusters[cluster + 1] : static_cast<uint32_t>(triangle_count);
+            for (uint32_t t = info.begin; t < info.end; ++t)
+            {
+                const XMFLOAT3& a = positions[indices[t * 3]];
+                const XMFLOAT3& b = positions[indices[t * 3 + 1]];
+                const XMFLOAT3& c = positions[indices[t * 3 + 2]];
+                XMFLOAT3 normal = cross(subtract(b, a), subtract(c, a));
+                float area = std::sqrt(dot(normal, normal));
+                info.normal = { info.normal.x + normal.x, info.normal.y + normal.y, info.normal.z + normal.z };
+                info.centroid = {
+                    info.centroid.x + (a.x + b.x + c.x) * area / 3.0f,
+                    info.centroid.y + (a.y + b.y + c.y) * area / 3.0f,
+                    info.centroid.z + (a.z + b.z + c.z) * area / 3.0f
+                };
+                info.area += area;
+            }
+            mesh_centroid = { mesh_centroid.x + info.centroid.x, mesh_centroid.y + info.centroid.y, mesh_centroid.z + info.centroid.z };
+            mesh_area += info.area;
+            if (info.area > 0.0f)
+            {
+                info.centroid = { info.centroid.x / info.area, info.centroid.y / info.area, info.centroid.z / info.area };
+            }
+        }
+        if (mesh_area > 0.0f)
+        {
+            mesh_centroid = { mesh_centroid.x / mesh_area, mesh_centroid.y / mesh_area, mesh_centroid.z / mesh_area };
+        }
+
+        // Clusters facing away from mesh center are likely to occlude others, draw them first
+        for (auto&& info : infos)
+        {
+            float normal_length = std::sqrt(dot(info.normal, info.normal));
+            info.sort_key = normal_length > 0.0f ? dot(subtract(info.centroid, mesh_centroid), info.normal) / normal_length : 0.0f;
+        }
+        std::stable_sort(infos.begin(), infos.end(), [](const ClusterInfo& a, const ClusterInfo& b) { return a.sort_key > b.sort_key; });
+
+        std::vector<uint32_t> result{};
+        result.reserve(triangle_count * 3);
+        for (auto&& info : infos)
+        {
+            result.insert(result.end(), indices.begin() + info.begin * 3, indices.begin() + info.end * 3);
+        }
+        std::copy(result.begin(), result.end(), indices.begin());
+    }
+
+    std::vector<uint32_t> optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count)
+    {
+        validate_indices(indices, vertex_count);
+
+        std::vector<uint32_t> old_to_new(vertex_count, s_invalid_vertex);
+        std::vector<uint32_t> remap{};
+        for (auto&& index : indices)
+        {
+            auto&& new_vertex = old_to_new[index];
+            if (new_vertex == s_invalid_vertex)
+            {
+                new_vertex = static_cast<uint32_t>(remap.size());
+                remap.push_back(index);
+            }
+            index = new_vertex;
+        }
+        return remap;
+    }
+
+    std::vector<uint32_t> optimize_mesh(std::span<uint32_t> indices, std::span<const XMFLOAT3> positions,
+                                        std::span<const VertexStreamView> attributes)
+    {
+        std::vector<VertexStreamView> streams{ make_stream_view(positions) };
+        streams.insert(streams.end(), attributes.begin(), attributes.end());
+        weld_vertices(indices, positions.size(), streams);
+
+        auto clusters = optimize_vertex_cache(indices, positions.size());
+        optimize_overdraw(indices, positions, clusters);
+        return optimize_vertex_fetch(indices, positions.size());
+    }
+
+    void log_mesh_statistics(std::string_view name, const MeshStatistics &before, const MeshStatistics &after)
+    {
+        DX_CORE_INFO("Mesh optimisation of '{}' ({} triangles): ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, overdraw {:.3f} -> {:.3f}",
+                     name, after.triangle_count, before.acmr(), after.acmr(), before.atvr(), after.atvr(), before.overdraw(), after.overdraw());
+    }
+}
@@ -0,0 +1,499 @@
+//
+// Created by ZZK on 2024/4/15.
+//
+
+#include <Toy/Model/mip_generator.h>
+#include <Toy/Core/parallel.h>
+
+#include <emmintrin.h>
+
+namespace toy::model
+{
+    using namespace DirectX;
+
+    // Levels are filtered in linear space at full precision, one 4-wide vector per texel
+    // Note: storage is left uninitialized, every texel is written before it is read
+    using LinearImage = std::unique_ptr<XMFLOAT4A[]>;
+
+    static LinearImage allocate_linear_image(size_t texel_count)
+    {
+        return std::make_unique_for_overwrite<XMFLOAT4A[]>(texel_count);
+    }
+
+    // Source taps along one axis, destination texel x reads source texels from 2x + first_offset on
+    struct MipKernel
+    {
+        int32_t first_offset = 0;
+        std::vector<float> weights;
+    };
+
+    static constexpr uint32_t s_max_kernel_taps = 6;
+
+    // Rows are filtered in bands on worker threads, levels smaller than this stay on calling thread
+    static constexpr uint32_t s_rows_per_band = 16;
+    static constexpr size_t s_parallel_texel_count = 64 * 1024;
+
+    // Linear values are encoded to sRGB through a coarse table refined by exact code boundaries
+    static constexpr uint32_t s_srgb_encode_table_size = 4096;
+
+    static float srgb_to_linear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    // Decode table of 8-bit sRGB values
+    static const std::array<float, 256>& srgb_decode_table()
+    {
+        static const std::array<float, 256> table = []
+        {
+            std::array<float, 256> result{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                result[i] = srgb_to_linear(static_cast<float>(i) / 255.0f);
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    struct SrgbEncodeTable
+    {
+        std::array<float, 256> boundaries{};                            // Linear value halfway between code i and i + 1
+        std::array<uint8_t, s_srgb_encode_table_size> codes{};          // Lowest code of each table bucket
+    };
+
+    static const SrgbEncodeTable& srgb_encode_table()
+    {
+        static const SrgbEncodeTable table = []
+        {
+            SrgbEncodeTable result{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                result.boundaries[i] = i < 255 ? srgb_to_linear((static_cast<float>(i) + 0.5f) / 255.0f) : 2.0f;
+            }
+            uint32_t code = 0;
+            for (uint32_t i = 0; i < s_srgb_encode_table_size; ++i)
+            {
+                float value = static_cast<float>(i) / static_cast<float>(s_srgb_encode_table_size - 1);
+                while (value >= result.boundaries[code])
+                {
+                    code++;
+                }
+                result.codes[i] = static_cast<uint8_t>(code);
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    // Nearest sRGB code of saturated linear value
+    static uint8_t linear_to_srgb_code(const SrgbEncodeTable& table, float value)
+    {
+        auto bucket = static_cast<uint32_t>(value * static_cast<float>(s_srgb_encode_table_size - 1));
+        uint32_t code = table.codes[bucket];
+        while (value >= table.boundaries[code])
+        {
+            code++;
+        }
+        return static_cast<uint8_t>(code);
+    }
+
+    // Modified Bessel function of the first kind of order 0, power series
+    static float bessel_i0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        for (uint32_t k = 1; k < 32 && term > sum * 1e-8f; ++k)
+        {
+            float half_x_over_k = x * 0.5f / static_cast<float>(k);
+            term *= half_x_over_k * half_x_over_k;
+            sum += term;
+        }
+        return sum;
+    }
+
+    static float sinc(float x)
+    {
+        return std::abs(x) < 1e-6f ? 1.0f : std::sin(XM_PI * x) / (XM_PI * x);
+    }
+
+    static const MipKernel& get_kernel(MipFilter filter)
+    {
+        static const MipKernel box_kernel{ 0, { 0.5f, 0.5f } };
+        static const MipKernel kaiser_kernel = []
+        {
+            // Window half width in destination texels and shape parameter
+            constexpr float width = 1.5f;
+            constexpr float alpha = 4.0f;
+
+            MipKernel kernel{ -2, {} };
+            float sum = 0.0f;
+            for (int32_t offset = -2; offset <= 3; ++offset)
+            {
+                // Distance from destination texel center, in destination texels
+                float t = (static_cast<float>(offset) - 0.5f) * 0.5f;
+                float ratio = t / width;
+                float window = bessel_i0(alpha * std::sqrt(std::max(1.0f - ratio * ratio, 0.0f))) / bessel_i0(alpha);
+                kernel.weights.push_back(sinc(t) * window);
+                sum += kernel.weights.back();
+            }
+            for (auto&& weight : kernel.weights)
+            {
+                weight /= sum;
+            }
+            return kernel;
+        }();
+        return filter == MipFilter::Kaiser ? kaiser_kernel : box_kernel;
+    }
+
+    static void for_each_row_band(uint32_t row_count, uint32_t row_width, const std::function<void(uint32_t, uint32_t)>& func)
+    {
+        if (static_cast<size_t>(row_count) * row_width < s_parallel_texel_count)
+        {
+            func(0, row_count);
+            return;
+        }
+
+        uint32_t band_count = (row_count + s_rows_per_band - 1) / s_rows_per_band;
+        parallel_for(band_count, [row_count, &func](size_t band)
+        {
+            auto first_row = static_cast<uint32_t>(band) * s_rows_per_band;
+            func(first_row, std::min(first_row + s_rows_per_band, row_count));
+        });
+    }
+
+    static void decode_row(const uint8_t* pixels, uint32_t width, const MipOptions& options, XMFLOAT4A* output)
+    {
+        auto&& decode_table = srgb_decode_table();
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            XMVECTOR texel{};
+            switch (options.format)
+            {
+                case MipFormat::RGBA8:
+                {
+                    const uint8_t* source = pixels + static_cast<size_t>(x) * 4;
+                    if (options.srgb)
+                    {
+                        // Alpha is always linear
+                        texel = XMVectorSet(decode_table[source[0]], decode_table[source[1]], decode_table[source[2]],
+                                            static_cast<float>(source[3]) / 255.0f);
+                    } else
+                    {
+                        texel = PackedVector::XMLoadUByteN4(reinterpret_cast<const PackedVector::XMUBYTEN4*>(source));
+                    }
+                    break;
+                }
+                case MipFormat::RGBA16F:
+                    texel = PackedVector::XMLoadHalf4(reinterpret_cast<const PackedVector::XMHALF4*>(pixels) + x);
+                    break;
+                case MipFormat::RGBA32F:
+                    texel = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pixels) + x);
+                    break;
+            }
+            XMStoreFloat4A(&output[x], texel);
+        }
+    }
+
+    static ImageMip encode_level(const LinearImage& image, uint32_t width, uint32_t height, const MipOptions& options)
+    {
+        ImageMip mip{};
+        mip.width = width;
+        mip.height = height;
+        mip.pixels.resize(static_cast<size_t>(width) * height * get_texel_byte_width(options.format));
+        auto&& encode_table = srgb_encode_table();
+        for_each_row_band(height, width, [&](uint32_t first_row, uint32_t last_row)
+        {
+            for (size_t i = static_cast<size_t>(first_row) * width; i < static_cast<size_t>(last_row) * width; ++i)
+            {
+                XMVECTOR texel = XMLoadFloat4A(&image[i]);
+                switch (options.format)
+                {
+                    case MipFormat::RGBA8:
+                    {
+                        // Negative lobes of Kaiser filter may leave the unit range
+                        texel = XMVectorSaturate(texel);
+                        auto output = reinterpret_cast<PackedVector::XMUBYTEN4*>(mip.pixels.data() + i * 4);
+                        PackedVector::XMStoreUByteN4(output, texel);
+                        if (options.srgb)
+                        {
+                            XMFLOAT4A color{};
+                            XMStoreFloat4A(&color, texel);
+                            output->x = linear_to_srgb_code(encode_table, color.x);
+                            output->y = linear_to_srgb_code(encode_table, color.y);
+                            output->z = linear_to_srgb_code(encode_table, color.z);
+                        }
+                        break;
+                    }
+                    case MipFormat::RGBA16F:
+                        PackedVector::XMStoreHalf4(reinterpret_cast<PackedVector::XMHALF4*>(mip.pixels.data()) + i, texel);
+                        break;
+                    case MipFormat::RGBA32F:
+                        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(mip.pixels.data()) + i, texel);
+                        break;
+                }
+            }
+        });
+        return mip;
+    }
+
+    // Kernel weights splatted once per level
+    struct KernelTaps
+    {
+        int32_t first_offset = 0;
+        uint32_t count = 0;
+        XMVECTOR weights[s_max_kernel_taps]{};
+    };
+
+    static void filter_row(const XMFLOAT4A* row, uint32_t width, const KernelTaps& taps, XMFLOAT4A* output, uint32_t mip_width)
+    {
+        auto last_x = static_cast<int32_t>(width) - 1;
+        for (uint32_t x = 0; x < mip_width; ++x)
+        {
+            XMVECTOR sum = XMVectorZero();
+            int32_t first = static_cast<int32_t>(x * 2) + taps.first_offset;
+            if (first >= 0 && first + static_cast<int32_t>(taps.count) <= static_cast<int32_t>(width))
+            {
+                for (uint32_t k = 0; k < taps.count; ++k)
+                {
+                    sum = XMVectorMultiplyAdd(XMLoadFloat4A(&row[first + k]), taps.weights[k], sum);
+                }
+            } else
+            {
+                // Odd or outer edge of source is clamped
+                for (uint32_t k = 0; k < taps.count; ++k)
+                {
+                    sum = XMVectorMultiplyAdd(XMLoadFloat4A(&row[std::clamp(first + static_cast<int32_t>(k), 0, last_x)]), taps.weights[k], sum);
+                }
+            }
+            XMStoreFloat4A(&output[x], sum);
+        }
+    }
+
+    // Separable filter, every band of destination rows keeps a ring of horizontally filtered source rows
+    // so that source rows shared by neighbouring destination rows are decoded and filtered once
+    // Source is either encoded pixels of top level or the previous linear level
+    static LinearImage downsample(const uint8_t* pixels, const LinearImage& source, uint32_t width, uint32_t height, const MipOptions& options)
+    {
+        uint32_t mip_width = std::max(width / 2, 1u);
+        uint32_t mip_height = std::max(height / 2, 1u);
+
+        auto&& kernel = get_kernel(options.filter);
+        KernelTaps taps{ kernel.first_offset, static_cast<uint32_t>(kernel.weights.size()) };
+        for (uint32_t k = 0; k < taps.count; ++k)
+        {
+            taps.weights[k] = XMVectorReplicate(kernel.weights[k]);
+        }
+
+        LinearImage mip = allocate_linear_image(static_cast<size_t>(mip_width) * mip_height);
+        size_t row_byte_width = static_cast<size_t>(width) * get_texel_byte_width(options.format);
+        XMVECTOR two = XMVectorReplicate(2.0f);
+        XMVECTOR half = XMVectorReplicate(0.5f);
+        for_each_row_band(mip_height, mip_width, [&](uint32_t first_row, uint32_t last_row)
+        {
+            LinearImage ring = allocate_linear_image(static_cast<size_t>(mip_width) * taps.count);
+            std::array<int32_t, s_max_kernel_taps> ring_rows{};
+            ring_rows.fill(-1);
+            LinearImage decoded_row = allocate_linear_image(pixels ? width : 0);
+
+            std::array<const XMFLOAT4A*, s_max_kernel_taps> rows{};
+            for (uint32_t y = first_row; y < last_row; ++y)
+            {
+                for (uint32_t k = 0; k < taps.count; ++k)
+                {
+                    int32_t source_y = std::clamp(static_cast<int32_t>(y * 2) + taps.first_offset + static_cast<int32_t>(k),
+                                                  0, static_cast<int32_t>(height) - 1);
+                    uint32_t slot = static_cast<uint32_t>(source_y) % taps.count;
+                    XMFLOAT4A* filtered = ring.get() + static_cast<size_t>(slot) * mip_width;
+                    if (ring_rows[slot] != source_y)
+                    {
+                        const XMFLOAT4A* source_row = nullptr;
+                        if (pixels)
+                        {
+                            decode_row(pixels + static_cast<size_t>(source_y) * row_byte_width, width, options, decoded_row.get());
+                            source_row = decoded_row.get();
+                        } else
+                        {
+                            source_row = source.get() + static_cast<size_t>(source_y) * width;
+                        }
+                        filter_row(source_row, width, taps, filtered, mip_width);
+                        ring_rows[slot] = source_y;
+                    }
+                    rows[k] = filtered;
+                }
+
+                XMFLOAT4A* output = mip.get() + static_cast<size_t>(y) * mip_width;
+                for (uint32_t x = 0; x < mip_width; ++x)
+                {
+                    XMVECTOR sum = XMVectorZero();
+                    for (uint32_t k = 0; k < taps.count; ++k)
+                    {
+                        sum = XMVectorMultiplyAdd(XMLoadFloat4A(&rows[k][x]), taps.weights[k], sum);
+                    }
+
+                    // Filtered unit vectors are shorter, alpha is left alone
+                    if (options.normal_map)
+                    {
+                        bool scale_biased = options.format == MipFormat::RGBA8;
+                        XMVECTOR normal = scale_biased ? XMVectorMultiplyAdd(sum, two, g_XMNegativeOne) : sum;
+                        normal = XMVector3Normalize(normal);
+                        normal = scale_biased ? XMVectorMultiplyAdd(normal, half, half) : normal;
+                        sum = XMVectorSelect(sum, normal, g_XMSelect1110);
+                    }
+                    XMStoreFloat4A(&output[x], sum);
+                }
+            }
+        });
+        return mip;
+    }
+
+    // Linear RGBA8 box filter stays in 8-bit, converting every texel to float and back costs more than the filter itself
+    static bool is_byte_box_filter(const MipOptions& options)
+    {
+        return options.format == MipFormat::RGBA8 && options.filter == MipFilter::Box && !options.srgb && !options.normal_map;
+    }
+
+    // 4 destination texels from 8 texels of 2 source rows, channels are summed in 16-bit lanes
+    static __m128i average_texels_4(const uint8_t* row0, const uint8_t* row1)
+    {
+        __m128i zero = _mm_setzero_si128();
+        auto load = [](const uint8_t* row, uint32_t offset) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(row) + offset); };
+        __m128i a0 = load(row0, 0), a1 = load(row0, 1), b0 = load(row1, 0), b1 = load(row1, 1);
+
+        // Vertical sums, 2 texels per register
+        __m128i v0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i v1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i v2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i v3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // Horizontal sums of texel pairs, then rounded like the scalar average
+        __m128i round = _mm_set1_epi16(2);
+        __m128i h0 = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi64(v0, v1), _mm_unpackhi_epi64(v0, v1)), round);
+        __m128i h1 = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi64(v2, v3), _mm_unpackhi_epi64(v2, v3)), round);
+        return _mm_packus_epi16(_mm_srli_epi16(h0, 2), _mm_srli_epi16(h1, 2));
+    }
+
+    // Rounded average of 4 texels, the 4 channels at once: even and odd bytes are summed in 16-bit lanes that can not overflow
+    static uint32_t average_texels(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+    {
+        constexpr uint32_t mask = 0x00FF00FF;
+        constexpr uint32_t round = 0x00020002;
+        uint32_t even = (a & mask) + (b & mask) + (c & mask) + (d & mask) + round;
+        uint32_t odd = ((a >> 8) & mask) + ((b >> 8) & mask) + ((c >> 8) & mask) + ((d >> 8) & mask) + round;
+        return ((even >> 2) & mask) | (((odd >> 2) & mask) << 8);
+    }
+
+    static ImageMip downsample_bytes(const uint8_t* pixels, uint32_t width, uint32_t height)
+    {
+        ImageMip mip{};
+        mip.width = std::max(width / 2, 1u);
+        mip.height = std::max(height / 2, 1u);
+        mip.pixels.resize(static_cast<size_t>(mip.width) * mip.height * 4);
+
+        auto load = [](const uint8_t* row, uint32_t x)
+        {
+            uint32_t texel = 0;
+            std::memcpy(&texel, row + static_cast<size_t>(x) * 4, sizeof(texel));
+            return texel;
+        };
+        // Odd last row or column is dropped, only a single texel wide source reads its edge twice
+        uint32_t next_x = width > 1 ? 1 : 0;
+        uint32_t next_y = height > 1 ? 1 : 0;
+        for_each_row_band(mip.height, mip.width, [&](uint32_t first_row, uint32_t last_row)
+        {
+            for (uint32_t y = first_row; y < last_row; ++y)
+            {
+                const uint8_t* row0 = pixels + static_cast<size_t>(y * 2) * width * 4;
+                const uint8_t* row1 = pixels + static_cast<size_t>(y * 2 + next_y) * width * 4;
+                uint8_t* output = mip.pixels.data() + static_cast<size_t>(y) * mip.width * 4;
+                uint32_t x = 0;
+                for (; next_x == 1 && x + 4 <= mip.width; x += 4)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + static_cast<size_t>(x) * 4),
+                                     average_texels_4(row0 + static_cast<size_t>(x) * 8, row1 + static_cast<size_t>(x) * 8));
+                }
+                for (; x < mip.width; ++x)
+                {
+                    uint32_t texel = average_texels(load(row0, x * 2), load(row0, x * 2 + next_x), load(row1, x * 2), load(row1, x * 2 + next_x));
+                    std::memcpy(output + static_cast<size_t>(x) * 4, &texel, sizeof(texel));
+                }
+            }
+        });
+        return mip;
+    }
+
+    uint32_t get_mip_count(uint32_t width, uint32_t height)
+    {
+        uint32_t mip_count = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+        {
+            mip_count++;
+        }
+        return mip_count;
+    }
+
+    uint32_t get_texel_byte_width(MipFormat format)
+    {
+        switch (format)
+        {
+            case MipFormat::RGBA16F:
+                return 8;
+            case MipFormat::RGBA32F:
+                return 16;
+            default:
+                return 4;
+        }
+    }
+
+    std::vector<ImageMip> generate_mip_chain(const uint8_t* pixels, uint32_t width, uint32_t height, const MipOptions& options,
+        uint32_t first_mip)
+    {
+        uint32_t mip_count = get_mip_count(width, height);
+        first_mip = std::min(first_mip, mip_count - 1);
+
+        std::vector<ImageMip> chain{};
+        chain.reserve(mip_count - first_mip);
+        if (first_mip == 0)
+        {
+            auto&& top = chain.emplace_back();
+            top.width = width;
+            top.height = height;
+            top.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * get_texel_byte_width(options.format));
+        }
+
+        // Each byte level is filtered from the previous encoded one
+        if (is_byte_box_filter(options))
+        {
+            ImageMip skipped{};
+            const uint8_t* source = pixels;
+            for (uint32_t mip = 1; mip < mip_count; ++mip)
+            {
+                ImageMip level = downsample_bytes(source, width, height);
+                width = level.width;
+                height = level.height;
+                if (mip >= first_mip)
+                {
+                    source = chain.emplace_back(std::move(level)).pixels.data();
+                } else
+                {
+                    skipped = std::move(level);
+                    source = skipped.pixels.data();
+                }
+            }
+            return chain;
+        }
+
+        LinearImage level = nullptr;
+        for (uint32_t mip = 1; mip < mip_count; ++mip)
+        {
+            level = downsample(mip == 1 ? pixels : nullptr, level, width, height, options);
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+            if (mip >= first_mip)
+            {
+                chain.push_back(encode_level(level, width, height, options));
+            }
+        }
+        return chain;
+    }
+}
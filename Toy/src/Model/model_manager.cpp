@@ -4,335 +4,346 @@
 
 #include <Toy/Model/model_manager.h>
 #include <Toy/Model/texture_manager.h>
-
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
+#include <Toy/Model/mesh_cache.h>
+#include <Toy/Model/mesh_codec.h>
+#include <Toy/Model/buffer_cache.h>
+#include <Toy/Model/gltf_loader.h>
+#include <Toy/Model/mesh_optimizer.h>
+#include <Toy/Core/mapped_file.h>
 
 namespace toy::model
 {
-    void Model::create_from_file(toy::model::Model &model, ID3D11Device *device, std::string_view file_name, uint32_t entity_id)
+    // Create buffers, materials and textures from a validated cache image
+    // Return false if an encoded stream fails to decode, model is then left incomplete and no texture is created
+    static bool load_mesh_cache(Model& model, ID3D11Device *device, std::span<const uint8_t> image)
     {
-        static_assert(sizeof(aiVector3D) == sizeof(DirectX::XMFLOAT3), "size of aiVector3D is not equal to sizeof DirectX::XMFLOAT3");
-
-        model.materials.clear();
-        model.meshes.clear();
-        model.bounding_box = DirectX::BoundingBox{};
-
-        Assimp::Importer importer;
-        // Remove point and line primitive
-        importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_LINE | aiPrimitiveType_POINT);
-        auto assimp_scene = importer.ReadFile(file_name.data(),
-            aiProcess_ConvertToLeftHanded |     // Left hand coordinate
-            aiProcess_CalcTangentSpace |               // Tangent space
-            aiProcess_GenBoundingBoxes |               // Generate bounding box
-            aiProcess_Triangulate |                    // Polygon splitting
-            aiProcess_ImproveCacheLocality |           // Improve cache locality
-            aiProcess_SortByPType);                    // Can remove no-triangle primitive
-
-        if (!assimp_scene || (assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !assimp_scene->HasMeshes())
-        {
-            DX_CORE_CRITICAL("Fail to load model asset, model file '{0}' may be incomplete", file_name);
-        }
-
         using namespace DirectX;
-        model.meshes.resize(assimp_scene->mNumMeshes);
-        model.materials.resize(assimp_scene->mNumMaterials);
-        for (uint32_t i = 0; i < assimp_scene->mNumMeshes; ++i)
+        auto&& header = *reinterpret_cast<const MeshCacheHeader *>(image.data());
+        auto cached_meshes = get_mesh_cache_blob<MeshCacheMesh>(image, header.meshes);
+        auto cached_materials = get_mesh_cache_blob<MeshCacheMaterial>(image, header.materials);
+
+        model.meshes.resize(cached_meshes.size());
+        model.materials.resize(cached_materials.size());
+        model.bounding_box = header.bounding_box;
+
+        // Plain streams are created straight from the image, no intermediate copy, encoded ones are decoded into a reused scratch
+        // Identical streams share one buffer
+        auto&& buffer_cache = BufferCache::get();
+        std::vector<uint8_t> decoded{};
+        auto create_buffer = [&image, &buffer_cache, &decoded, &model, device](const MeshCacheBlob& blob, uint32_t bind_flags, com_ptr<ID3D11Buffer>& buffer)
         {
-            auto&& mesh = model.meshes[i];
-            auto ai_mesh = assimp_scene->mMeshes[i];
-            uint32_t num_vertices = ai_mesh->mNumVertices;
-
-            CD3D11_BUFFER_DESC buffer_desc{ 0, D3D11_BIND_VERTEX_BUFFER };
-            D3D11_SUBRESOURCE_DATA init_data{ nullptr, 0, 0 };
-
-            // Entity id
+            if (blob.decoded_byte_width == 0)
             {
-                std::vector<uint32_t> entity_id_array(num_vertices, entity_id);
-                init_data.pSysMem = entity_id_array.data();
-                buffer_desc.ByteWidth = static_cast<uint32_t>(num_vertices * sizeof(uint32_t));
-                device->CreateBuffer(&buffer_desc, &init_data, mesh.entity_id_buffer.GetAddressOf());
+                buffer = buffer_cache.create(device, image.data() + blob.offset, blob.byte_width, bind_flags, model.cached_buffers);
+                return true;
             }
-            // Position
-            if (ai_mesh->mNumVertices > 0)
+            decoded.resize(blob.decoded_byte_width);
+            if (!decode_mesh_stream(image.subspan(blob.offset, blob.byte_width), decoded))
             {
-                init_data.pSysMem = ai_mesh->mVertices;
-                buffer_desc.ByteWidth = num_vertices * sizeof(XMFLOAT3);
-                device->CreateBuffer(&buffer_desc, &init_data, mesh.vertices.GetAddressOf());
+                return false;
+            }
+            buffer = buffer_cache.create(device, decoded.data(), decoded.size(), bind_flags, model.cached_buffers);
+            return true;
+        };
 
-                BoundingBox::CreateFromPoints(mesh.bounding_box, num_vertices, (const XMFLOAT3 *)ai_mesh->mVertices, sizeof(XMFLOAT3));
-                if (i == 0)
-                {
-                    model.bounding_box = mesh.bounding_box;
-                } else
-                {
-                    BoundingBox::CreateMerged(model.bounding_box, model.bounding_box, mesh.bounding_box);
-                }
+        for (size_t i = 0; i < cached_meshes.size(); ++i)
+        {
+            auto&& cached_mesh = cached_meshes[i];
+            auto&& mesh = model.meshes[i];
+
+            bool created = create_buffer(cached_mesh.positions, D3D11_BIND_VERTEX_BUFFER, mesh.vertices) &&
+                           create_buffer(cached_mesh.normals, D3D11_BIND_VERTEX_BUFFER, mesh.normals) &&
+                           create_buffer(cached_mesh.tangents, D3D11_BIND_VERTEX_BUFFER, mesh.tangents) &&
+                           create_buffer(cached_mesh.bitangents, D3D11_BIND_VERTEX_BUFFER, mesh.bitangents) &&
+                           create_buffer(cached_mesh.indices, D3D11_BIND_INDEX_BUFFER, mesh.indices);
+            mesh.texcoord_arrays.resize(cached_mesh.texcoord_count);
+            for (uint32_t row = 0; row < cached_mesh.texcoord_count; ++row)
+            {
+                created = created && create_buffer(cached_mesh.texcoords[row], D3D11_BIND_VERTEX_BUFFER, mesh.texcoord_arrays[row]);
             }
-            // Normal
-            if (ai_mesh->HasNormals())
+            if (!created)
             {
-                init_data.pSysMem = ai_mesh->mNormals;
-                buffer_desc.ByteWidth = num_vertices * sizeof(XMFLOAT3);
-                device->CreateBuffer(&buffer_desc, &init_data, mesh.normals.GetAddressOf());
+                return false;
             }
-            // Tangent and bitangent
-            if (ai_mesh->HasTangentsAndBitangents())
+
+            mesh.vertex_count = cached_mesh.vertex_count;
+            mesh.index_count = cached_mesh.index_count;
+            mesh.material_index = cached_mesh.material_index;
+            mesh.index_format = cached_mesh.index_stride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+            mesh.vertex_encoding = static_cast<VertexEncoding>(cached_mesh.vertex_encoding);
+            mesh.bounding_box = cached_mesh.bounding_box;
+            mesh.uv_density = cached_mesh.uv_density;
+        }
+
+        // Textures of every material are created as one batch, decoded in parallel
+        std::vector<TextureSource> texture_sources{};
+        for (size_t i = 0; i < cached_materials.size(); ++i)
+        {
+            auto&& cached_material = cached_materials[i];
+            auto&& material = model.materials[i];
+
+            for (uint32_t slot = 0; slot < material_texture_count; ++slot)
             {
-                std::vector<XMFLOAT4> tangents(num_vertices, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
-                for (uint32_t index = 0; index < ai_mesh->mNumVertices; ++index)
+                auto&& texture = cached_material.textures[slot];
+                if (texture.source == MeshCacheTextureSource::None)
                 {
-                    memcpy_s(&tangents[index], sizeof(XMFLOAT3), ai_mesh->mTangents + index, sizeof(XMFLOAT3));
+                    continue;
                 }
 
-                init_data.pSysMem = tangents.data();
-                buffer_desc.ByteWidth = ai_mesh->mNumVertices * sizeof(XMFLOAT4);
-                device->CreateBuffer(&buffer_desc, &init_data, mesh.tangents.GetAddressOf());
+                auto&& texture_source = texture_sources.emplace_back(get_mesh_cache_texture(image, texture, slot));
+                material.set_texture(static_cast<MaterialSemantics>(slot), string_to_id(texture_source.name));
+            }
 
-                for (uint32_t index = 0; index < ai_mesh->mNumVertices; ++index)
+            for (uint32_t slot = 0; slot < material_color_count; ++slot)
+            {
+                auto semantics = static_cast<MaterialSemantics>(material_texture_count + slot);
+                if ((cached_material.presence_mask >> static_cast<uint32_t>(semantics)) & 1u)
                 {
-                    memcpy_s(&tangents[index], sizeof(XMFLOAT3), ai_mesh->mBitangents + index, sizeof(XMFLOAT3));
+                    material.set_color(semantics, cached_material.colors[slot]);
                 }
-                device->CreateBuffer(&buffer_desc, &init_data, mesh.bitangents.GetAddressOf());
             }
-            // Texture coordinates
-            uint32_t num_uvs = 8;
-            while (num_uvs && !ai_mesh->HasTextureCoords(num_uvs - 1))
-            {
-                num_uvs--;
-            }
-            if (num_uvs > 0)
+
+            for (uint32_t slot = 0; slot < material_scalar_count; ++slot)
             {
-                mesh.texcoord_arrays.resize(num_uvs);
-                for (uint32_t row = 0; row < num_uvs; ++row)
+                auto semantics = static_cast<MaterialSemantics>(material_texture_count + material_color_count + slot);
+                if ((cached_material.presence_mask >> static_cast<uint32_t>(semantics)) & 1u)
                 {
-                    std::vector<XMFLOAT2> uvs(num_vertices);
-                    for (uint32_t col = 0; col < num_vertices; ++col)
-                    {
-                        memcpy_s(&uvs[col], sizeof(XMFLOAT2), ai_mesh->mTextureCoords[row] + col, sizeof(XMFLOAT2));
-                    }
-                    init_data.pSysMem = uvs.data();
-                    buffer_desc.ByteWidth = num_vertices * sizeof(XMFLOAT2);
-                    device->CreateBuffer(&buffer_desc, &init_data, mesh.texcoord_arrays[row].GetAddressOf());
+                    material.set_scalar(semantics, cached_material.scalars[slot]);
                 }
             }
-            // Index
-            uint32_t num_faces = ai_mesh->mNumFaces;
-            uint32_t num_indices = num_faces * 3;
-            if (num_faces > 0)
+
+            for (auto&& property : get_mesh_cache_blob<MeshCacheProperty>(image, cached_material.properties))
             {
-                mesh.index_count = num_indices;
-                if (num_indices < 65536)
-                {
-                    std::vector<uint16_t> indices(num_indices);
-                    for (size_t index = 0; index < num_faces; ++index)
-                    {
-                        indices[index * 3] = static_cast<uint16_t>(ai_mesh->mFaces[index].mIndices[0]);
-                        indices[index * 3 + 1] = static_cast<uint16_t>(ai_mesh->mFaces[index].mIndices[1]);
-                        indices[index * 3 + 2] = static_cast<uint16_t>(ai_mesh->mFaces[index].mIndices[2]);
-                    }
-                    buffer_desc = CD3D11_BUFFER_DESC{ static_cast<uint32_t>(num_indices * sizeof(uint16_t)), D3D11_BIND_INDEX_BUFFER };
-                    init_data.pSysMem = indices.data();
-                    device->CreateBuffer(&buffer_desc, &init_data, mesh.indices.GetAddressOf());
-                } else
-                {
-                    std::vector<uint32_t> indices(num_indices);
-                    for (size_t index = 0; index < num_faces; ++index)
-                    {
-                        memcpy_s(indices.data() + index * 3, sizeof(uint32_t) * 3, ai_mesh->mFaces[index].mIndices, sizeof(uint32_t) * 3);
-                    }
-                    buffer_desc = CD3D11_BUFFER_DESC{ static_cast<uint32_t>(num_indices * sizeof(uint32_t)), D3D11_BIND_INDEX_BUFFER };
-                    init_data.pSysMem = indices.data();
-                    device->CreateBuffer(&buffer_desc, &init_data, mesh.indices.GetAddressOf());
-                }
+                material.set(property.id, property.value);
             }
-            // Material
-            mesh.material_index = ai_mesh->mMaterialIndex;
+
+            material.bake();
         }
+        TextureManager::get().create_batch(texture_sources);
+        return true;
+    }
+
+    Model::~Model()
+    {
+        clear();
+    }
 
-        for (uint32_t i = 0; i < assimp_scene->mNumMaterials; ++i)
+    Model& Model::operator=(Model &&other) noexcept
+    {
+        if (this != &other)
         {
-            auto&& material = model.materials[i];
-            auto ai_material = assimp_scene->mMaterials[i];
-            XMFLOAT4 vec{};
-            float value{};
-            uint32_t boolean{};
-            uint32_t num = 3;
+            clear();
+            materials = std::move(other.materials);
+            meshes = std::move(other.meshes);
+            bounding_box = other.bounding_box;
+            cached_buffers = std::move(other.cached_buffers);
+            other.cached_buffers.clear();
+        }
+        return *this;
+    }
 
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_AMBIENT, (float*)&vec, &num))
-            {
-                material.set("$AmbientColor", vec);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_DIFFUSE, (float*)&vec, &num))
-            {
-                material.set("$DiffuseColor", vec);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_SPECULAR, (float*)&vec, &num))
-            {
-                material.set("$SpecularColor", vec);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_SPECULAR_FACTOR, value))
-            {
-                material.set("$SpecularFactor", value);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_EMISSIVE, (float*)&vec, &num))
-            {
-                material.set("$EmissiveColor", vec);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_OPACITY, value))
-            {
-                material.set("$Opacity", value);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_TRANSPARENT, (float*)&vec, &num))
-            {
-                material.set("$TransparentColor", vec);
-            }
-            if (aiReturn_SUCCESS == ai_material->Get(AI_MATKEY_COLOR_REFLECTIVE, (float*)&vec, &num))
-            {
-                material.set("$ReflectiveColor", vec);
-            }
+    void Model::clear()
+    {
+        // Buffers are held by meshes, drop them before their uses
+        materials.clear();
+        meshes.clear();
+        bounding_box = DirectX::BoundingBox{};
+        if (!cached_buffers.empty() && BufferCache::is_alive())
+        {
+            BufferCache::get().release(cached_buffers);
+        }
+        cached_buffers.clear();
+    }
+
+    void Model::create_from_file(toy::model::Model &model, ID3D11Device *device, std::string_view file_name, VertexEncoding vertex_encoding,
+                                 MeshStreamStorage stream_storage)
+    {
+        model.clear();
 
-            aiString ai_path{};
-            std::filesystem::path tex_file_name{};
-            std::string tex_name{};
+        auto start_time = std::chrono::steady_clock::now();
+        auto elapsed_ms = [&start_time]()
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        };
+
+        // glTF buffers are already typed arrays, load natively and only fall back to Assimp for unsupported features
+        if (is_gltf_file(file_name) && load_gltf(model, device, file_name, vertex_encoding))
+        {
+            DX_CORE_INFO("Model '{}' loaded via native glTF loader in {:.2f} ms", file_name, elapsed_ms());
+            return;
+        }
 
-            // Texture manage
-            auto try_create_texture = [&file_name, &assimp_scene, &ai_material, &material, &ai_path, &tex_file_name, &tex_name]
-                            (aiTextureType type, std::string_view property_name, bool gen_mips = false, uint32_t force_SRGB = 0)
+        // Warm load, map processed mesh cache and upload straight from the mapped view
+        XID cache_key = import_cache_key(file_name, vertex_encoding, stream_storage);
+        std::filesystem::path cache_path = mesh_cache_path(cache_key);
+        if (cache_key != 0)
+        {
+            MappedFile cache_file(cache_path);
+            if (cache_file.is_open() && validate_mesh_cache(cache_file.bytes(), cache_key))
             {
-                if (!ai_material->GetTextureCount(type))
+                if (load_mesh_cache(model, device, cache_file.bytes()))
                 {
+                    DX_CORE_INFO("Model '{}' loaded from processed mesh cache in {:.2f} ms", file_name, elapsed_ms());
                     return;
                 }
+                DX_CORE_WARN("Processed mesh cache of model '{}' is corrupt, import again", file_name);
+                model.clear();
+            }
+        }
 
-                ai_material->GetTexture(type, 0, &ai_path);
+        // Cold load, import via Assimp then write cache for next time
+        std::vector<uint8_t> image = import_model(file_name, cache_key, vertex_encoding, stream_storage);
+        if (!load_mesh_cache(model, device, image))
+        {
+            DX_CORE_CRITICAL("Fail to decode imported mesh streams of model '{}'", file_name);
+        }
+        if (cache_key != 0 && !save_mesh_cache(cache_path, image))
+        {
+            DX_CORE_WARN("Fail to write processed mesh cache of model '{}'", file_name);
+        }
+        DX_CORE_INFO("Model '{}' imported via Assimp in {:.2f} ms", file_name, elapsed_ms());
+    }
 
-                // If texture has been loaded
-                if (ai_path.data[0] == '*')
-                {
-                    tex_name = file_name;
-                    tex_name += ai_path.C_Str();
-                    char* end_str = nullptr;
-                    aiTexture* p_tex = assimp_scene->mTextures[std::strtol(ai_path.data + 1, &end_str, 10)];
-                    TextureManager::get().create_from_memory(tex_name, p_tex->pcData, (p_tex->mHeight ? p_tex->mWidth * p_tex->mHeight : p_tex->mWidth),
-                                                                    gen_mips, force_SRGB);
-                    material.set(property_name, std::string(tex_name));
-                }
-                // Texture indexed by file name
-                else
-                {
-                    tex_file_name = file_name;
-                    tex_file_name = tex_file_name.parent_path() / ai_path.C_Str();
-                    TextureManager::get().create_from_file(tex_file_name.string(), gen_mips, force_SRGB);
-                    material.set(property_name, tex_file_name.string());
-                }
-            };
-
-            // Create textures
-            try_create_texture(aiTextureType_DIFFUSE, material_semantics_name(MaterialSemantics::DiffuseMap), true, 1);
-            try_create_texture(aiTextureType_SPECULAR, material_semantics_name(MaterialSemantics::SpecularMap), true, 1);
-            try_create_texture(aiTextureType_NORMALS, material_semantics_name(MaterialSemantics::NormalMap));
-            try_create_texture(aiTextureType_BASE_COLOR, material_semantics_name(MaterialSemantics::AlbedoMap), true, 1);
-            try_create_texture(aiTextureType_NORMAL_CAMERA, material_semantics_name(MaterialSemantics::NormalCameraMap));
-            try_create_texture(aiTextureType_METALNESS, material_semantics_name(MaterialSemantics::MetalnessMap));
-            try_create_texture(aiTextureType_DIFFUSE_ROUGHNESS, material_semantics_name(MaterialSemantics::RoughnessMap));
-            try_create_texture(aiTextureType_AMBIENT_OCCLUSION, material_semantics_name(MaterialSemantics::AmbientOcclusionMap));
-
-            // Set diffuse color and opacity and metalness and roughness material properties
-            if (auto diffuse_color_name = material_semantics_name(MaterialSemantics::DiffuseColor); !material.has_property(diffuse_color_name))
-            {
-                material.set<XMFLOAT4>(diffuse_color_name, XMFLOAT4{ 0.8f, 0.8f, 0.8f, 1.0f });
-            }
-            if (auto opacity_name = material_semantics_name(MaterialSemantics::Opacity); !material.has_property(opacity_name))
-            {
-                material.set<float>(opacity_name, 1.0f);
-            }
-            if (auto metalness_name = material_semantics_name(MaterialSemantics::Metalness); !material.has_property(metalness_name))
-            {
-                material.set<float>(metalness_name, 0.5f);
-            }
-            if (auto roughness_name = material_semantics_name(MaterialSemantics::Roughness); !material.has_property(roughness_name))
-            {
-                material.set<float>(roughness_name, 0.5f);
-            }
+    // Weld and reorder procedural geometry like imported meshes, index width is kept
+    static geometry::GeometryData optimize_geometry(const geometry::GeometryData& data)
+    {
+        using namespace DirectX;
+        geometry::GeometryData result{};
+        std::vector<uint32_t> indices = data.indices16.empty() ? data.indices32 :
+                                        std::vector<uint32_t>(data.indices16.begin(), data.indices16.end());
+
+        std::vector<VertexStreamView> attributes{};
+        if (!data.normals.empty())
+        {
+            attributes.push_back(make_stream_view<XMFLOAT3>(data.normals));
+        }
+        if (!data.texcoords.empty())
+        {
+            attributes.push_back(make_stream_view<XMFLOAT2>(data.texcoords));
+        }
+        if (!data.tangents.empty())
+        {
+            attributes.push_back(make_stream_view<XMFLOAT4>(data.tangents));
         }
+
+        auto statistics_before = analyze_mesh(indices, data.vertices);
+        auto remap = optimize_mesh(indices, data.vertices, attributes);
+        result.vertices = remap_vertex_stream<XMFLOAT3>(data.vertices, remap);
+        result.normals = remap_vertex_stream<XMFLOAT3>(data.normals, remap);
+        result.texcoords = remap_vertex_stream<XMFLOAT2>(data.texcoords, remap);
+        result.tangents = remap_vertex_stream<XMFLOAT4>(data.tangents, remap);
+        log_mesh_statistics("geometry", statistics_before, analyze_mesh(indices, result.vertices));
+
+        if (data.indices16.empty())
+        {
+            result.indices32 = std::move(indices);
+        } else
+        {
+            result.indices16.assign(indices.begin(), indices.end());
+        }
+        return result;
     }
 
     void Model::create_from_geometry(toy::model::Model &model, ID3D11Device *device, const geometry::GeometryData &data,
                                         bool is_dynamic)
     {
         using namespace DirectX;
+        model.clear();
         // Default material
         model.materials.resize(1);
-        model.materials[0].set<XMFLOAT4>(material_semantics_name(MaterialSemantics::AmbientColor), XMFLOAT4{0.2f, 0.2f, 0.2f, 1.0f });
-        model.materials[0].set<XMFLOAT4>(material_semantics_name(MaterialSemantics::DiffuseColor), XMFLOAT4{0.8f, 0.8f, 0.8f, 1.0f });
-        model.materials[0].set<XMFLOAT4>(material_semantics_name(MaterialSemantics::SpecularColor), XMFLOAT4{0.2f, 0.2f, 0.2f, 1.0f });
-        model.materials[0].set<float>(material_semantics_name(MaterialSemantics::SpecularFactor), 10.0f);
-        model.materials[0].set<float>(material_semantics_name(MaterialSemantics::Opacity), 1.0f);
-        model.materials[0].set<float>(material_semantics_name(MaterialSemantics::Metalness), 0.5f);
-        model.materials[0].set<float>(material_semantics_name(MaterialSemantics::Roughness), 0.5f);
+        model.materials[0].set_color(MaterialSemantics::AmbientColor, XMFLOAT4{0.2f, 0.2f, 0.2f, 1.0f });
+        model.materials[0].set_color(MaterialSemantics::DiffuseColor, XMFLOAT4{0.8f, 0.8f, 0.8f, 1.0f });
+        model.materials[0].set_color(MaterialSemantics::SpecularColor, XMFLOAT4{0.2f, 0.2f, 0.2f, 1.0f });
+        model.materials[0].set_scalar(MaterialSemantics::SpecularFactor, 10.0f);
+        model.materials[0].set_scalar(MaterialSemantics::Opacity, 1.0f);
+        model.materials[0].set_scalar(MaterialSemantics::Metalness, 0.5f);
+        model.materials[0].set_scalar(MaterialSemantics::Roughness, 0.5f);
+        model.materials[0].bake();
+
+        // Dynamic geometry is updated by caller in its own vertex order, so only static geometry is reordered
+        geometry::GeometryData optimized_data{};
+        if (!is_dynamic)
+        {
+            optimized_data = optimize_geometry(data);
+        }
+        const geometry::GeometryData& mesh_data = is_dynamic ? data : optimized_data;
 
         model.meshes.resize(1);
         model.meshes[0].texcoord_arrays.resize(1);
-        model.meshes[0].vertex_count = (uint32_t)data.vertices.size();
-        model.meshes[0].index_count = (uint32_t)(!data.indices16.empty() ? data.indices16.size() : data.indices32.size());
+        model.meshes[0].vertex_count = (uint32_t)mesh_data.vertices.size();
+        model.meshes[0].index_count = (uint32_t)(!mesh_data.indices16.empty() ? mesh_data.indices16.size() : mesh_data.indices32.size());
         model.meshes[0].material_index = 0;
 
-        CD3D11_BUFFER_DESC buffer_desc(0,
-                                        D3D11_BIND_VERTEX_BUFFER,
-                                        is_dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT,
-                                        is_dynamic ? D3D11_CPU_ACCESS_WRITE : 0);
-        D3D11_SUBRESOURCE_DATA init_data{ nullptr, 0, 0 };
+        // Static buffers are shared by content, dynamic buffers are owned since caller updates them in place
+        auto&& buffer_cache = BufferCache::get();
+        auto create_vertex_buffer = [device, is_dynamic, &buffer_cache, &model](const void* data, size_t byte_width, com_ptr<ID3D11Buffer>& buffer)
+        {
+            if (!is_dynamic)
+            {
+                buffer = buffer_cache.create(device, data, byte_width, D3D11_BIND_VERTEX_BUFFER, model.cached_buffers);
+                return;
+            }
+            CD3D11_BUFFER_DESC buffer_desc(static_cast<uint32_t>(byte_width), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+            D3D11_SUBRESOURCE_DATA init_data{ data, 0, 0 };
+            device->CreateBuffer(&buffer_desc, &init_data, buffer.ReleaseAndGetAddressOf());
+        };
 
-        init_data.pSysMem = data.vertices.data();
-        buffer_desc.ByteWidth = (uint32_t)(data.vertices.size() * sizeof(XMFLOAT3));
-        device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].vertices.GetAddressOf());
+        create_vertex_buffer(mesh_data.vertices.data(), mesh_data.vertices.size() * sizeof(XMFLOAT3), model.meshes[0].vertices);
 
-        // Entity id buffer
+        if (!mesh_data.normals.empty())
         {
-            init_data.pSysMem = data.entity_id_array.data();
-            buffer_desc.ByteWidth = static_cast<uint32_t>(data.entity_id_array.size() * sizeof(uint32_t));
-            device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].entity_id_buffer.GetAddressOf());
+            create_vertex_buffer(mesh_data.normals.data(), mesh_data.normals.size() * sizeof(XMFLOAT3), model.meshes[0].normals);
         }
 
-        if (!data.normals.empty())
+        if (!mesh_data.texcoords.empty())
         {
-            init_data.pSysMem = data.normals.data();
-            buffer_desc.ByteWidth = static_cast<uint32_t>(data.normals.size() * sizeof(XMFLOAT3));
-            device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].normals.GetAddressOf());
+            create_vertex_buffer(mesh_data.texcoords.data(), mesh_data.texcoords.size() * sizeof(XMFLOAT2), model.meshes[0].texcoord_arrays[0]);
         }
 
-        if (!data.texcoords.empty())
+        if (!mesh_data.tangents.empty())
         {
-            init_data.pSysMem = data.texcoords.data();
-            buffer_desc.ByteWidth = static_cast<uint32_t>(data.texcoords.size() * sizeof(XMFLOAT2));
-            device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].texcoord_arrays[0].GetAddressOf());
+            create_vertex_buffer(mesh_data.tangents.data(), mesh_data.tangents.size() * sizeof(XMFLOAT4), model.meshes[0].tangents);
         }
 
-        if (!data.tangents.empty())
+        if (!mesh_data.indices16.empty())
         {
-            init_data.pSysMem = data.tangents.data();
-            buffer_desc.ByteWidth = static_cast<uint32_t>(data.tangents.size() * sizeof(XMFLOAT4));
-            device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].tangents.GetAddressOf());
+            model.meshes[0].indices = buffer_cache.create(device, mesh_data.indices16.data(), mesh_data.indices16.size() * sizeof(uint16_t), D3D11_BIND_INDEX_BUFFER,
+                                                          model.cached_buffers);
+            model.meshes[0].index_format = DXGI_FORMAT_R16_UINT;
         }
-
-        if (!data.indices16.empty())
+        else
         {
-            init_data.pSysMem = data.indices16.data();
-            buffer_desc = CD3D11_BUFFER_DESC(static_cast<uint16_t>(data.indices16.size() * sizeof(uint16_t)), D3D11_BIND_INDEX_BUFFER);
-            buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-            buffer_desc.CPUAccessFlags = 0;
-            device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].indices.GetAddressOf());
+            model.meshes[0].indices = buffer_cache.create(device, mesh_data.indices32.data(), mesh_data.indices32.size() * sizeof(uint32_t), D3D11_BIND_INDEX_BUFFER,
+                                                          model.cached_buffers);
+            model.meshes[0].index_format = DXGI_FORMAT_R32_UINT;
         }
-        else
+    }
+
+    size_t Model::get_byte_width() const
+    {
+        auto buffer_byte_width = [](ID3D11Buffer* buffer) -> size_t
         {
-            init_data.pSysMem = data.indices32.data();
-            buffer_desc = CD3D11_BUFFER_DESC(static_cast<uint32_t>(data.indices32.size() * sizeof(uint32_t)), D3D11_BIND_INDEX_BUFFER);
-            buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-            buffer_desc.CPUAccessFlags = 0;
-            device->CreateBuffer(&buffer_desc, &init_data, model.meshes[0].indices.GetAddressOf());
+            if (!buffer)
+            {
+                return 0;
+            }
+            D3D11_BUFFER_DESC buffer_desc{};
+            buffer->GetDesc(&buffer_desc);
+            return buffer_desc.ByteWidth;
+        };
+
+        size_t byte_width = 0;
+        for (auto&& mesh : meshes)
+        {
+            byte_width += buffer_byte_width(mesh.vertices.Get()) + buffer_byte_width(mesh.normals.Get()) +
+                          buffer_byte_width(mesh.tangents.Get()) + buffer_byte_width(mesh.bitangents.Get()) +
+                          buffer_byte_width(mesh.colors.Get()) + buffer_byte_width(mesh.indices.Get());
+            for (auto&& texcoords : mesh.texcoord_arrays)
+            {
+                byte_width += buffer_byte_width(texcoords.Get());
+            }
         }
+        return byte_width;
     }
 
     void Model::set_debug_object_name(std::string_view name)
@@ -340,87 +351,299 @@ namespace toy::model
         // TODO
     }
 
-    ModelManager& ModelManager::get()
+    ModelHandle::ModelHandle(XID id, std::shared_ptr<Model> model) : m_id(id), m_model(std::move(model))
     {
-        static ModelManager model_manager{};
-        return model_manager;
+
     }
 
-    void ModelManager::init(ID3D11Device *device)
+    ModelHandle::~ModelHandle()
     {
-        m_device_ = device;
-        m_device_->GetImmediateContext(m_device_context_.ReleaseAndGetAddressOf());
+        reset();
     }
 
-    Model* ModelManager::create_from_file(std::string_view file_name, uint32_t entity_id)
+    ModelHandle::ModelHandle(const ModelHandle &other) : m_id(other.m_id), m_model(other.m_model)
     {
-        return create_from_file(file_name, file_name, entity_id);
+        if (m_model && ModelManager::is_alive())
+        {
+            ModelManager::get().add_reference(m_id);
+        }
     }
 
-    Model* ModelManager::create_from_file(std::string_view name, std::string_view file_name, uint32_t entity_id)
+    ModelHandle& ModelHandle::operator=(const ModelHandle &other)
     {
-        XID model_id = string_to_id(name);
-        auto& model = m_models[model_id];
-        Model::create_from_file(model, m_device_.Get(), file_name, entity_id);
-        return &model;
+        if (this != &other)
+        {
+            ModelHandle copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
     }
 
-    Model* ModelManager::create_from_geometry(std::string_view name, const geometry::GeometryData &data,
-                                                bool is_dynamic)
+    ModelHandle::ModelHandle(ModelHandle &&other) noexcept : m_id(other.m_id), m_model(std::move(other.m_model))
     {
-        XID model_id = string_to_id(name);
-        auto& model = m_models[model_id];
-        Model::create_from_geometry(model, m_device_.Get(), data, is_dynamic);
-        return &model;
+        other.m_id = 0;
     }
 
-    const Model* ModelManager::get_model(std::string_view name) const
+    ModelHandle& ModelHandle::operator=(ModelHandle &&other) noexcept
     {
-        XID name_id = string_to_id(name);
-        if (auto it = m_models.find(name_id); it != m_models.end())
+        if (this != &other)
         {
-            return &(it->second);
+            reset();
+            std::swap(m_id, other.m_id);
+            std::swap(m_model, other.m_model);
         }
-        return nullptr;
+        return *this;
     }
 
-    Model* ModelManager::get_model(std::string_view name)
+    void ModelHandle::reset()
     {
-        XID name_id = string_to_id(name);
-        if (m_models.count(name_id))
+        if (m_model)
         {
-            return &m_models[name_id];
+            m_model.reset();
+            // Handle held by another static object may be released during exit, after manager is gone
+            if (ModelManager::is_alive())
+            {
+                ModelManager::get().release_reference(m_id);
+            }
         }
-        return nullptr;
+        m_id = 0;
     }
-}
 
+    // Trivially destructible, so that it can still be read while other static objects are destroyed
+    static std::atomic<bool> s_model_manager_alive = false;
 
+    ModelManager::ModelManager()
+    {
+        s_model_manager_alive = true;
+    }
 
+    ModelManager::~ModelManager()
+    {
+        s_model_manager_alive = false;
+    }
 
+    bool ModelManager::is_alive()
+    {
+        return s_model_manager_alive.load(std::memory_order_acquire);
+    }
 
+    ModelManager& ModelManager::get()
+    {
+        static ModelManager model_manager{};
+        return model_manager;
+    }
 
+    void ModelManager::init(ID3D11Device *device)
+    {
+        m_device_ = device;
+        m_device_->GetImmediateContext(m_device_context_.ReleaseAndGetAddressOf());
+    }
 
+    ModelHandle ModelManager::create_from_file(std::string_view file_name)
+    {
+        return create_from_file(file_name, file_name);
+    }
 
+    ModelHandle ModelManager::create_from_file(std::string_view name, std::string_view file_name)
+    {
+        return create_from_file(string_to_id(name), name, file_name);
+    }
 
+    ModelHandle ModelManager::create_from_file(XID model_id, std::string_view name, std::string_view file_name)
+    {
+        // ID given by a saved scene is not the hash of name, so there is nothing to check
+        if (model_id == string_to_id(name))
+        {
+            check_model_id(model_id, name);
+        }
 
+        // Threads requesting the same model wait for the one loading it
+        bool is_created = false;
+        auto model = m_models.get_or_create(model_id, [this, file_name, &is_created]()
+        {
+            auto model = std::make_shared<Model>();
+            Model::create_from_file(*model, m_device_.Get(), file_name, m_vertex_encoding, m_stream_storage);
+            is_created = true;
+            return model;
+        });
 
+        if (is_created)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_model_files[model_id] = file_name;
+        }
+        ModelHandle model_handle = register_model(model_id, model, is_created);
+        if (is_created)
+        {
+            report_deduplication();
+        }
+        return model_handle;
+    }
 
+    ModelHandle ModelManager::create_from_geometry(std::string_view name, const geometry::GeometryData &data,
+                                                   bool is_dynamic)
+    {
+        XID model_id = string_to_id(name);
+        check_model_id(model_id, name);
+
+        auto model = std::make_shared<Model>();
+        Model::create_from_geometry(*model, m_device_.Get(), data, is_dynamic);
+        return register_model(model_id, model, true);
+    }
 
+    ModelHandle ModelManager::acquire(std::string_view name)
+    {
+        return acquire(string_to_id(name));
+    }
+
+    ModelHandle ModelManager::acquire(XID model_id, std::string_view file_name)
+    {
+        if (auto model = m_models.find(model_id))
+        {
+            return register_model(model_id, *model, false);
+        }
 
+        // Only models loaded from file can be brought back after eviction
+        std::string source_file{ file_name };
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto file_it = m_model_files.find(model_id); file_it != m_model_files.end())
+            {
+                source_file = file_it->second;
+                DX_CORE_INFO("Reload evicted model '{}'", source_file);
+            }
+        }
+        if (source_file.empty())
+        {
+            return {};
+        }
+        return create_from_file(model_id, source_file, source_file);
+    }
 
+    void ModelManager::remove_model(std::string_view name)
+    {
+        XID model_id = string_to_id(name);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_residency.get_reference_count(model_id) > 0)
+            {
+                DX_CORE_WARN("Model '{}' is still referenced, it is not removed", name);
+                return;
+            }
+            if (!m_models.erase(model_id))
+            {
+                return;
+            }
+            m_id_checker.remove(model_id);
+            m_residency.remove(model_id);
+            m_model_files.erase(model_id);
+        }
 
+        size_t released_bytes = BufferCache::get().release_unused();
+        DX_CORE_INFO("Model '{}' removed, {:.2f} MB of buffers released", name, static_cast<double>(released_bytes) / (1024.0 * 1024.0));
+    }
 
+    void ModelManager::set_memory_budget(size_t budget)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_residency.set_budget(budget);
+        evict_unused();
+    }
 
+    size_t ModelManager::get_memory_budget() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_residency.get_budget();
+    }
 
+    ResidencyStatistics ModelManager::get_residency_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_residency.get_statistics();
+    }
 
+    void ModelManager::add_reference(XID model_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_residency.add_reference(model_id);
+    }
 
+    void ModelManager::release_reference(XID model_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_residency.release_reference(model_id);
+        evict_unused();
+    }
 
+    ModelHandle ModelManager::register_model(XID model_id, const std::shared_ptr<Model> &model, bool is_created)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (is_created || !m_residency.contains(model_id))
+        {
+            m_models.insert_or_assign(model_id, model);
+            m_residency.add(model_id, model->get_byte_width());
+        }
+        m_residency.touch(model_id);
+        m_residency.add_reference(model_id);
+        ModelHandle model_handle(model_id, model);
 
+        // New model is referenced while making room, so that it is not its own victim
+        evict_unused();
+        return model_handle;
+    }
 
+    void ModelManager::evict_unused()
+    {
+        auto victims = m_residency.evict();
+        if (victims.empty())
+        {
+            return;
+        }
 
+        for (auto model_id : victims)
+        {
+            m_models.erase(model_id);
+            m_id_checker.remove(model_id);
+        }
+        size_t released_bytes = BufferCache::get().release_unused();
 
+        auto&& statistics = m_residency.get_statistics();
+        DX_CORE_INFO("Evicted {} unused models, {:.2f} MB of buffers released, {:.2f} of {:.2f} MB resident",
+                     victims.size(), static_cast<double>(released_bytes) / (1024.0 * 1024.0),
+                     static_cast<double>(statistics.resident_bytes) / (1024.0 * 1024.0),
+                     static_cast<double>(m_residency.get_budget()) / (1024.0 * 1024.0));
+    }
 
+    void ModelManager::check_model_id(XID model_id, std::string_view name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_id_checker.check(model_id, name))
+        {
+            DX_CORE_CRITICAL("Model '{}' is refused, its ID belongs to another model", name);
+        }
+    }
 
+    void ModelManager::report_deduplication() const
+    {
+        auto&& buffer_statistics = BufferCache::get().get_statistics();
+        auto&& texture_statistics = TextureManager::get().get_statistics();
+        DX_CORE_INFO("De-duplication: {} of {} buffers shared, {:.2f} MB saved; {} of {} textures shared, {:.2f} MB of images saved",
+                     buffer_statistics.shared_count, buffer_statistics.request_count,
+                     static_cast<double>(buffer_statistics.saved_bytes) / (1024.0 * 1024.0),
+                     texture_statistics.shared_count, texture_statistics.request_count,
+                     static_cast<double>(texture_statistics.saved_bytes) / (1024.0 * 1024.0));
+    }
 
+    std::shared_ptr<Model> ModelManager::get_model(std::string_view name) const
+    {
+        auto model = m_models.find(string_to_id(name));
+        return model ? *model : nullptr;
+    }
 
+    std::string ModelManager::get_model_file(XID model_id) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_model_files.find(model_id);
+        return it != m_model_files.end() ? it->second : std::string{};
+    }
+}
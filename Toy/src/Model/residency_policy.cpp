@@ -0,0 +1,122 @@
+//
+// Created by ZZK on 2024/4/14.
+//
+
+#include <Toy/Model/residency_policy.h>
+
+namespace toy::model
+{
+    void ResidencyPolicy::add(XID id, size_t byte_width)
+    {
+        if (auto it = m_entries.find(id); it != m_entries.end())
+        {
+            m_statistics.resident_bytes = m_statistics.resident_bytes - it->second.byte_width + byte_width;
+            it->second.byte_width = byte_width;
+            touch(id);
+        } else
+        {
+            auto&& entry = m_entries[id];
+            entry.byte_width = byte_width;
+            entry.lru_position = m_lru.insert(m_lru.end(), id);
+            m_statistics.resident_bytes += byte_width;
+            m_statistics.resident_count++;
+            if (m_evicted.erase(id))
+            {
+                m_statistics.reload_count++;
+            }
+        }
+        m_statistics.peak_resident_bytes = std::max(m_statistics.peak_resident_bytes, m_statistics.resident_bytes);
+    }
+
+    void ResidencyPolicy::remove(XID id)
+    {
+        if (auto it = m_entries.find(id); it != m_entries.end())
+        {
+            untrack(it);
+        }
+    }
+
+    void ResidencyPolicy::add_reference(XID id)
+    {
+        auto it = m_entries.find(id);
+        if (it == m_entries.end())
+        {
+            DX_CORE_CRITICAL("Reference to untracked resource {:#x}", id);
+        }
+        if (it->second.reference_count++ == 0)
+        {
+            m_lru.erase(it->second.lru_position);
+        }
+    }
+
+    void ResidencyPolicy::release_reference(XID id)
+    {
+        auto it = m_entries.find(id);
+        if (it == m_entries.end() || it->second.reference_count == 0)
+        {
+            DX_CORE_CRITICAL("Release of unreferenced resource {:#x}", id);
+        }
+        if (--it->second.reference_count == 0)
+        {
+            it->second.lru_position = m_lru.insert(m_lru.end(), id);
+        }
+    }
+
+    void ResidencyPolicy::touch(XID id)
+    {
+        auto it = m_entries.find(id);
+        if (it != m_entries.end() && it->second.reference_count == 0)
+        {
+            m_lru.splice(m_lru.end(), m_lru, it->second.lru_position);
+        }
+    }
+
+    uint32_t ResidencyPolicy::get_reference_count(XID id) const
+    {
+        auto it = m_entries.find(id);
+        return it != m_entries.end() ? it->second.reference_count : 0;
+    }
+
+    std::vector<XID> ResidencyPolicy::evict(size_t incoming_byte_width)
+    {
+        std::vector<XID> victims{};
+        while (!m_lru.empty() && m_statistics.resident_bytes + incoming_byte_width > m_budget)
+        {
+            XID id = m_lru.front();
+            auto it = m_entries.find(id);
+            m_statistics.eviction_count++;
+            m_statistics.evicted_bytes += it->second.byte_width;
+            untrack(it);
+            remember_eviction(id);
+            victims.push_back(id);
+        }
+        return victims;
+    }
+
+    void ResidencyPolicy::remember_eviction(XID id)
+    {
+        m_evicted[id] = ++m_eviction_number;
+        m_eviction_order.emplace_back(id, m_eviction_number);
+        // Entry of ID reloaded or evicted again since then is stale, it only takes a slot of history until dropped here
+        while (m_eviction_order.size() > residency_eviction_history)
+        {
+            auto [oldest_id, number] = m_eviction_order.front();
+            if (auto it = m_evicted.find(oldest_id); it != m_evicted.end() && it->second == number)
+            {
+                m_evicted.erase(it);
+            }
+            m_eviction_order.pop_front();
+        }
+    }
+
+    void ResidencyPolicy::untrack(std::unordered_map<XID, Entry>::iterator it)
+    {
+        if (it->second.reference_count == 0)
+        {
+            m_lru.erase(it->second.lru_position);
+        }
+        m_statistics.resident_bytes -= it->second.byte_width;
+        m_statistics.resident_count--;
+        m_entries.erase(it);
+    }
+}
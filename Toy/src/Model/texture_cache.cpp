@@ -0,0 +1,172 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#include <Toy/Model/texture_cache.h>
+#include <Toy/Model/dds_file.h>
+
+namespace toy::model
+{
+    static constexpr std::array<BlockFormat, 5> s_block_formats = {
+        BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7
+    };
+
+    static size_t get_mip_chain_byte_width(uint32_t width, uint32_t height, uint32_t mip_count, BlockFormat format)
+    {
+        size_t byte_width = 0;
+        for (uint32_t mip = 0; mip < mip_count; ++mip)
+        {
+            byte_width += get_compressed_byte_width(std::max(width >> mip, 1u), std::max(height >> mip, 1u), format);
+        }
+        return byte_width;
+    }
+
+    TextureUsage get_texture_usage(MaterialSemantics semantics)
+    {
+        switch (semantics)
+        {
+            case MaterialSemantics::DiffuseMap:
+            case MaterialSemantics::AlbedoMap:
+                return TextureUsage::Albedo;
+            case MaterialSemantics::SpecularMap:
+                return TextureUsage::Specular;
+            case MaterialSemantics::NormalMap:
+            case MaterialSemantics::NormalCameraMap:
+                return TextureUsage::Normal;
+            case MaterialSemantics::MetalnessMap:
+            case MaterialSemantics::RoughnessMap:
+            case MaterialSemantics::AmbientOcclusionMap:
+                return TextureUsage::Mask;
+            default:
+                return TextureUsage::Generic;
+        }
+    }
+
+    std::optional<BlockFormat> get_block_format(TextureUsage usage)
+    {
+        switch (usage)
+        {
+            case TextureUsage::Albedo:
+                return BlockFormat::BC7;
+            case TextureUsage::Specular:
+                return BlockFormat::BC1;
+            case TextureUsage::Normal:
+                return BlockFormat::BC5;
+            case TextureUsage::Mask:
+                return BlockFormat::BC4;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    uint32_t CompressedTexture::get_row_pitch(uint32_t mip) const
+    {
+        return (get_mip_width(mip) + 3) / 4 * get_block_byte_width(block_format);
+    }
+
+    std::span<const uint8_t> CompressedTexture::get_mip(uint32_t mip) const
+    {
+        size_t offset = get_mip_chain_byte_width(width, height, mip, block_format);
+        size_t byte_width = get_compressed_byte_width(get_mip_width(mip), get_mip_height(mip), block_format);
+        return std::span<const uint8_t>(data).subspan(offset, byte_width);
+    }
+
+    XID texture_cache_key(XID content_key, TextureUsage usage)
+    {
+        XID key = hash::combine(content_key, static_cast<uint32_t>(usage));
+        return hash::combine(key, texture_cache_version);
+    }
+
+    std::filesystem::path texture_cache_path(XID key)
+    {
+        return std::filesystem::path(DXTOY_HOME "data/cache/textures") / fmt::format("{:016x}.dds", key);
+    }
+
+    CompressedTexture compress_texture(std::string_view name, const uint8_t* pixels, uint32_t width, uint32_t height,
+        TextureUsage usage, bool srgb)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        auto block_format = get_block_format(usage);
+        if (!block_format)
+        {
+            DX_CORE_CRITICAL("Texture usage {} is not compressed", static_cast<uint32_t>(usage));
+        }
+
+        CompressedTexture texture{};
+        texture.block_format = *block_format;
+        // Formats without sRGB variant hold linear data, such as normals, and are filtered as such
+        texture.srgb = srgb && get_dxgi_format(*block_format, true) != get_dxgi_format(*block_format, false);
+        texture.width = width;
+        texture.height = height;
+
+        // Normals are renormalized on every mip, as block compression keeps only XY
+        MipOptions mip_options{ MipFormat::RGBA8, MipFilter::Kaiser, texture.srgb, usage == TextureUsage::Normal };
+        auto mips = generate_mip_chain(pixels, width, height, mip_options);
+        texture.mip_count = static_cast<uint32_t>(mips.size());
+        texture.data.reserve(get_mip_chain_byte_width(width, height, texture.mip_count, texture.block_format));
+
+        size_t source_byte_width = 0;
+        for (auto&& mip : mips)
+        {
+            auto blocks = compress_image(mip, texture.block_format);
+            texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+            source_byte_width += mip.pixels.size();
+        }
+
+        auto decoded = decompress_image(texture.get_mip(0), width, height, texture.block_format);
+        double psnr = compute_psnr(mips.front(), decoded, texture.block_format);
+        std::chrono::duration<double, std::milli> compress_time = std::chrono::steady_clock::now() - start_time;
+        DX_CORE_INFO("Compressed texture '{}' {}x{} with {} mips in {:.1f} ms, {:.2f} MB to {:.2f} MB, PSNR {:.2f} dB",
+            name, width, height, texture.mip_count, compress_time.count(),
+            static_cast<double>(source_byte_width) / (1024.0 * 1024.0),
+            static_cast<double>(texture.data.size()) / (1024.0 * 1024.0), psnr);
+        return texture;
+    }
+
+    std::optional<CompressedTexture> load_texture_cache(const std::filesystem::path& cache_path)
+    {
+        auto dds_file = read_dds_file(cache_path);
+        if (!dds_file)
+        {
+            return std::nullopt;
+        }
+
+        CompressedTexture texture{};
+        texture.width = dds_file->desc.width;
+        texture.height = dds_file->desc.height;
+        texture.mip_count = dds_file->desc.mip_count;
+        bool known_format = false;
+        for (auto block_format : s_block_formats)
+        {
+            for (bool srgb : { false, true })
+            {
+                if (get_dxgi_format(block_format, srgb) == dds_file->desc.format)
+                {
+                    texture.block_format = block_format;
+                    texture.srgb = srgb;
+                    known_format = true;
+                }
+            }
+        }
+
+        size_t byte_width = get_mip_chain_byte_width(texture.width, texture.height, texture.mip_count, texture.block_format);
+        if (!known_format || dds_file->desc.array_size != 1 || dds_file->data.size() != byte_width)
+        {
+            DX_CORE_WARN("Texture cache {} does not match its header", cache_path.string());
+            return std::nullopt;
+        }
+        texture.data = std::move(dds_file->data);
+        return texture;
+    }
+
+    bool save_texture_cache(const std::filesystem::path& cache_path, const CompressedTexture& texture)
+    {
+        DdsDesc desc{};
+        desc.format = texture.get_format();
+        desc.width = texture.width;
+        desc.height = texture.height;
+        desc.mip_count = texture.mip_count;
+        desc.pitch_or_linear_size = static_cast<uint32_t>(texture.get_mip(0).size());
+        return write_dds_file(cache_path, desc, texture.data);
+    }
+}
@@ -0,0 +1,170 @@
+//
+// Created by ZZK on 2023/5/31.
+//
+
+#include <Toy/Model/texture_decoder.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace toy::model
+{
+    void StbImageDeleter::operator()(uint8_t *pixel_data) const
+    {
+        stbi_image_free(pixel_data);
+    }
+
+    XID texture_content_key(XID content_id, bool enable_mips, uint32_t force_SRGB)
+    {
+        if (content_id == 0)
+        {
+            return 0;
+        }
+        return hash::combine(hash::combine(content_id, enable_mips ? 1 : 0), force_SRGB);
+    }
+
+    bool is_dds_file(std::string_view filename)
+    {
+        std::string extension = std::filesystem::path(filename).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".dds";
+    }
+
+    std::pair<XID, size_t> source_content_key(const TextureSource& source)
+    {
+        if (!source.data.empty())
+        {
+            return { texture_content_key(content_to_id(source.data.data(), source.data.size()), source.enable_mips, source.force_SRGB),
+                     source.data.size() };
+        }
+
+        // Packed file has both in pack index, nothing is read
+        auto&& file_system = VirtualFileSystem::get();
+        std::filesystem::path file_path(source.name);
+        auto file_size = static_cast<size_t>(file_system.get_file_size(file_path));
+        if (file_size == 0)
+        {
+            return { 0, 0 };
+        }
+        return { texture_content_key(file_system.get_content_id(file_path), source.enable_mips, source.force_SRGB), file_size };
+    }
+
+    DecodedImage decode_image(const TextureSource& source, XID content_key, bool allow_dds)
+    {
+        DecodedImage image{};
+        bool from_file = source.data.empty();
+        if (from_file && allow_dds && is_dds_file(source.name))
+        {
+            // Header is validated here, upload reads subresources straight from the file view
+            image.dds_file = VirtualFileSystem::get().open(std::filesystem::path(source.name));
+            image.dds = parse_dds(image.dds_file.bytes());
+            // Single level of uncompressed DDS gets its mips generated by DDS loader
+            if (!image.dds || (source.enable_mips && image.dds->desc.mip_count == 1 && get_block_byte_width(image.dds->desc.format) == 0))
+            {
+                image.dds.reset();
+                image.dds_file = {};
+                image.is_dds = true;
+            }
+            return image;
+        }
+
+        // File is read from asset pack or mapped, images are decoded from memory either way
+        VirtualFile file{};
+        std::span<const uint8_t> encoded = source.data;
+        if (from_file)
+        {
+            file = VirtualFileSystem::get().open(std::filesystem::path(source.name));
+            encoded = file.bytes();
+        }
+
+        // Radiance image is converted scanline by scanline, it never exists as float RGBA
+        if (is_radiance_image(encoded))
+        {
+            // Shared exponent is half the size of half floats, which CPU mip generator needs
+            HdrFormat format = source.enable_mips ? HdrFormat::RGBA16F : HdrFormat::RGB9E5;
+            image.hdr = decode_hdr_image(encoded, format);
+            if (image.hdr)
+            {
+                image.width = static_cast<int32_t>(image.hdr->width);
+                image.height = static_cast<int32_t>(image.hdr->height);
+                if (source.enable_mips)
+                {
+                    image.mips = generate_mip_chain(image.hdr->pixels.data(), image.hdr->width, image.hdr->height,
+                                                    MipOptions{ MipFormat::RGBA16F, MipFilter::Box });
+                    image.hdr->pixels = {};
+                }
+            }
+            return image;
+        }
+
+        // Texture cache hit skips decoding, a miss is compressed below and fills the cache
+        auto block_format = get_block_format(source.usage);
+        if (block_format && content_key != 0)
+        {
+            image.cache_path = texture_cache_path(texture_cache_key(content_key, source.usage));
+            image.compressed = load_texture_cache(image.cache_path);
+            if (image.compressed)
+            {
+                return image;
+            }
+        }
+
+        int32_t comp = 0;
+        if (!encoded.empty())
+        {
+            image.pixels.reset(stbi_load_from_memory(encoded.data(), static_cast<int32_t>(encoded.size()),
+                                                     &image.width, &image.height, &comp, STBI_rgb_alpha));
+        }
+
+        // Direct3D requires block compressed textures of whole blocks, other sizes stay uncompressed
+        if (image.cache_path.empty() || !image.pixels || image.width % 4 != 0 || image.height % 4 != 0)
+        {
+            image.cache_path.clear();
+            // Mips are filtered here on worker thread, so upload needs neither GenerateMips nor render target binding
+            if (source.enable_mips && image.pixels)
+            {
+                MipOptions mip_options{ MipFormat::RGBA8, MipFilter::Box, source.force_SRGB != 0, false };
+                image.mips = generate_mip_chain(image.pixels.get(), static_cast<uint32_t>(image.width),
+                                                static_cast<uint32_t>(image.height), mip_options);
+                image.pixels.reset();
+            }
+            return image;
+        }
+        image.compressed = compress_texture(source.name, image.pixels.get(), static_cast<uint32_t>(image.width),
+                                            static_cast<uint32_t>(image.height), source.usage, source.force_SRGB != 0);
+        image.pixels.reset();
+        if (!save_texture_cache(image.cache_path, *image.compressed))
+        {
+            DX_CORE_WARN("Fail to write texture cache {}", image.cache_path.string());
+            image.cache_path.clear();
+        }
+        return image;
+    }
+
+    BakeResult bake_texture_cache(const TextureSource& source)
+    {
+        if (!get_block_format(source.usage) || (source.data.empty() && is_dds_file(source.name)))
+        {
+            return {};
+        }
+        XID content_key = source_content_key(source).first;
+        if (content_key == 0)
+        {
+            DX_CORE_WARN("Fail to read texture {}", source.name);
+            return { BakeStatus::Failed, {} };
+        }
+
+        // Cache files are written atomically, so existing ones are complete
+        auto cache_path = texture_cache_path(texture_cache_key(content_key, source.usage));
+        if (std::filesystem::exists(cache_path))
+        {
+            return { BakeStatus::Cached, { cache_path } };
+        }
+        auto image = decode_image(source, content_key, false);
+        if (!image.compressed || image.cache_path.empty())
+        {
+            return { image.pixels || image.hdr || !image.mips.empty() ? BakeStatus::Skipped : BakeStatus::Failed, {} };
+        }
+        return { BakeStatus::Baked, { image.cache_path } };
+    }
+}
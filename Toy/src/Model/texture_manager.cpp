@@ -3,21 +3,73 @@
 //
 
 #include <Toy/Model/texture_manager.h>
+#include <Toy/Core/parallel.h>
 
 #include <DDSTextureLoader/DDSTextureLoader11.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 namespace toy::model
 {
-    struct StbImageDeleter
+    // Decoded images waiting for upload, bounds memory held when upload falls behind decode
+    static constexpr size_t s_decode_queue_capacity = 8;
+
+    // Subresources of mips from first_mip down
+    static std::vector<D3D11_SUBRESOURCE_DATA> get_init_data(std::span<const ImageMip> mips, uint32_t texel_byte_width)
+    {
+        std::vector<D3D11_SUBRESOURCE_DATA> init_data(mips.size());
+        for (size_t i = 0; i < mips.size(); ++i)
+        {
+            init_data[i] = { mips[i].pixels.data(), mips[i].width * texel_byte_width, 0 };
+        }
+        return init_data;
+    }
+
+    static std::vector<D3D11_SUBRESOURCE_DATA> get_init_data(const CompressedTexture& texture, uint32_t first_mip)
     {
-        void operator()(uint8_t *pixel_data) const
+        std::vector<D3D11_SUBRESOURCE_DATA> init_data{};
+        for (uint32_t mip = first_mip; mip < texture.mip_count; ++mip)
         {
-            stbi_image_free(pixel_data);
+            init_data.push_back({ texture.get_mip(mip).data(), texture.get_row_pitch(mip), 0 });
         }
-    };
+        return init_data;
+    }
+
+    // Subresources of every slice from first_mip down, pointing into the bytes DDS was parsed from
+    static std::vector<D3D11_SUBRESOURCE_DATA> get_init_data(const DdsView& dds, uint32_t first_mip)
+    {
+        std::vector<D3D11_SUBRESOURCE_DATA> init_data{};
+        for (uint32_t slice = 0; slice < dds.desc.array_size; ++slice)
+        {
+            for (uint32_t mip = first_mip; mip < dds.desc.mip_count; ++mip)
+            {
+                auto&& subresource = dds.get_subresource(mip, slice);
+                init_data.push_back({ subresource.bytes.data(), subresource.row_pitch, subresource.slice_pitch });
+            }
+        }
+        return init_data;
+    }
+
+    // sRGB variant of format, as DDS_LOADER_FORCE_SRGB, format itself if it has none
+    static DXGI_FORMAT get_srgb_format(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+            case DXGI_FORMAT_R8G8B8A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+            case DXGI_FORMAT_B8G8R8A8_UNORM: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+            case DXGI_FORMAT_B8G8R8X8_UNORM: return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+            case DXGI_FORMAT_BC1_UNORM: return DXGI_FORMAT_BC1_UNORM_SRGB;
+            case DXGI_FORMAT_BC2_UNORM: return DXGI_FORMAT_BC2_UNORM_SRGB;
+            case DXGI_FORMAT_BC3_UNORM: return DXGI_FORMAT_BC3_UNORM_SRGB;
+            case DXGI_FORMAT_BC7_UNORM: return DXGI_FORMAT_BC7_UNORM_SRGB;
+            default: return format;
+        }
+    }
+
+    com_ptr<ID3D11ShaderResourceView> TextureHandle::get() const
+    {
+        return TextureManager::get().get_texture_view(m_id);
+    }
 
     TextureManager& TextureManager::get()
     {
@@ -29,6 +81,7 @@ namespace toy::model
     {
         m_device = device;
         m_device->GetImmediateContext(m_device_context.ReleaseAndGetAddressOf());
+        m_owner_thread = std::this_thread::get_id();
 
         // 1 X 1 empty texture
         com_ptr<ID3D11Texture2D> tex = nullptr;
@@ -41,164 +94,558 @@ namespace toy::model
 
         com_ptr<ID3D11ShaderResourceView> srv = nullptr;
         m_device->CreateShaderResourceView(tex.Get(), nullptr, srv.GetAddressOf());
-        m_texture_srvs.try_emplace(0, srv.Get());
+        m_texture_srvs.insert(0, srv);
     }
 
-    ID3D11ShaderResourceView *TextureManager::create_from_file(std::string_view filename, bool enable_mips, uint32_t force_SRGB)
+    TextureHandle TextureManager::create_from_file(std::string_view filename, bool enable_mips, uint32_t force_SRGB, TextureUsage usage)
     {
-        XID file_id = string_to_id(filename);
-        if (m_texture_srvs.count(file_id))
+        return create_texture({ std::string(filename), {}, enable_mips, force_SRGB, usage });
+    }
+
+    TextureHandle TextureManager::create_from_memory(std::string_view name, void *data, size_t byte_width, bool enable_mips,
+                                                     uint32_t force_SRGB, TextureUsage usage)
+    {
+        return create_texture({ std::string(name), { static_cast<const uint8_t *>(data), byte_width }, enable_mips, force_SRGB, usage });
+    }
+
+    void TextureManager::create_batch(std::span<const TextureSource> sources)
+    {
+        // First occurrence of names not loaded yet
+        std::vector<const TextureSource*> pending{};
+        std::unordered_set<XID> pending_names{};
+        for (auto&& source : sources)
+        {
+            // Name whose ID belongs to another texture is refused, error is logged by check
+            XID name_id = string_to_id(source.name);
+            if (!check_texture_id(name_id, source.name))
+            {
+                continue;
+            }
+            if (!m_texture_srvs.contains(name_id) && pending_names.insert(name_id).second)
+            {
+                pending.push_back(&source);
+            }
+        }
+        if (pending.empty())
         {
-            DX_CORE_WARN("{} texture asset has been loaded", filename);
-            return m_texture_srvs[file_id].Get();
+            return;
         }
 
-        auto &&res = m_texture_srvs[file_id];
-        std::wstring file_str = utf8_to_wstring(filename);
-        auto hr = DirectX::CreateDDSTextureFromFileEx(
-                m_device.Get(), (enable_mips ? m_device_context.Get() : nullptr),
-                file_str.c_str(), 0, D3D11_USAGE_DEFAULT,
-                D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                static_cast<DirectX::DDS_LOADER_FLAGS>(force_SRGB), nullptr, res.ReleaseAndGetAddressOf());
+        auto start_time = std::chrono::steady_clock::now();
+        // Content key hashes whole source, so it is computed on worker threads as well
+        std::vector<std::pair<XID, size_t>> content_keys(pending.size());
+        parallel_for(pending.size(), [&pending, &content_keys](size_t i) { content_keys[i] = source_content_key(*pending[i]); });
 
-        if (FAILED(hr))
+        // Only decode textures not sharing content with a loaded texture or with an earlier texture of batch
+        std::vector<size_t> decode_indices{};
+        std::vector<size_t> duplicate_indices{};
+        std::unordered_set<XID> batch_content_keys{};
+        for (size_t i = 0; i < pending.size(); ++i)
         {
-            DX_CORE_INFO("Unsupported image type for DDS texture library, try to use stb image");
-        } else
+            auto [content_key, byte_width] = content_keys[i];
+            if (content_key != 0 && !m_content_srvs.contains(content_key) && batch_content_keys.count(content_key))
+            {
+                duplicate_indices.push_back(i);
+                continue;
+            }
+            if (auto shared_texture = share_texture(pending[i]->name, content_key, byte_width))
+            {
+                m_texture_srvs.insert(string_to_id(pending[i]->name), std::move(shared_texture));
+                continue;
+            }
+            if (content_key != 0)
+            {
+                batch_content_keys.insert(content_key);
+            }
+            decode_indices.push_back(i);
+        }
+
+        struct DecodedSource
+        {
+            size_t index = 0;
+            DecodedImage image;
+        };
+        size_t num_threads = m_decode_thread_count ? m_decode_thread_count.load() : get_worker_count();
+        std::chrono::duration<double, std::milli> upload_time{};
+        parallel_pipeline(decode_indices.size(), num_threads, s_decode_queue_capacity,
+            [&pending, &decode_indices, &content_keys](size_t i)
+            {
+                size_t index = decode_indices[i];
+                return DecodedSource{ index, decode_image(*pending[index], content_keys[index].first, true) };
+            },
+            [this, &pending, &content_keys, &upload_time](DecodedSource&& decoded)
+            {
+                auto upload_start_time = std::chrono::steady_clock::now();
+                auto&& source = *pending[decoded.index];
+                m_texture_srvs.get_or_create(string_to_id(source.name), [this, &source, &content_keys, &decoded]()
+                {
+                    return upload_image(string_to_id(source.name), source, content_keys[decoded.index].first, decoded.image);
+                });
+                upload_time += std::chrono::steady_clock::now() - upload_start_time;
+            });
+
+        // Duplicates of batch share now, unless their twin is not shared by content
+        for (auto i : duplicate_indices)
         {
-            return res.Get();
+            auto&& source = *pending[i];
+            XID name_id = string_to_id(source.name);
+            auto [content_key, byte_width] = content_keys[i];
+            m_texture_srvs.get_or_create(name_id, [this, &source, name_id, content_key, byte_width]()
+            {
+                if (auto shared_texture = share_texture(source.name, content_key, byte_width))
+                {
+                    return shared_texture;
+                }
+                auto image = decode_image(source, content_key, true);
+                return upload_image(name_id, source, content_key, image);
+            });
         }
 
-        com_ptr<ID3D11Texture2D> texture = nullptr;
-        int32_t width = 0, height = 0, comp = 0;
+        std::chrono::duration<double, std::milli> total_time = std::chrono::steady_clock::now() - start_time;
+        DX_CORE_INFO("Created {} textures, {} decoded on {} threads in {:.1f} ms, of which upload on calling thread {:.1f} ms",
+                     pending.size(), decode_indices.size(), std::min(num_threads, std::max<size_t>(decode_indices.size(), 1)),
+                     total_time.count(), upload_time.count());
+    }
 
-        uint8_t* pixels = nullptr;
-        auto is_hdr = stbi_is_hdr(filename.data());
-        if (is_hdr)
-        {
-            auto float_pixels = stbi_loadf(filename.data(), &width, &height, &comp, STBI_rgb_alpha);
-            pixels = reinterpret_cast<uint8_t *>(float_pixels);
-            DX_CORE_INFO("Load HDR image: {}", filename);
-        } else
-        {
-            pixels = stbi_load(filename.data(), &width, &height, &comp, STBI_rgb_alpha);
-            DX_CORE_INFO("Load image: {}", filename);
-        }
-
-        std::unique_ptr<uint8_t, StbImageDeleter> img_data(pixels);
-        if (img_data)
-        {
-            DXGI_FORMAT texture_format = is_hdr ? DXGI_FORMAT_R32G32B32A32_FLOAT : (force_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM);
-            uint32_t row_pitch = is_hdr ? (static_cast<uint32_t>(STBI_rgb_alpha) * width * sizeof(float)) : (static_cast<uint32_t>(STBI_rgb_alpha) * width * sizeof(uint8_t));
-            CD3D11_TEXTURE2D_DESC tex_desc(texture_format,
-                                            width, height, 1,
-                                            enable_mips ? 0 : 1,
-                                            D3D11_BIND_SHADER_RESOURCE | (enable_mips ? D3D11_BIND_RENDER_TARGET : 0),
-                                            D3D11_USAGE_DEFAULT, 0, 1, 0,
-                                            enable_mips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0);
-
-            m_device->CreateTexture2D(&tex_desc, nullptr, texture.GetAddressOf());
-            // Upload texture data
-            m_device_context->UpdateSubresource(texture.Get(), 0, nullptr, img_data.get(), row_pitch, 0);
-            // Create SRV
-            CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(D3D11_SRV_DIMENSION_TEXTURE2D,texture_format);
-            m_device->CreateShaderResourceView(texture.Get(), &srv_desc, res.ReleaseAndGetAddressOf());
-            // Generate mipmap
-            if (enable_mips)
-            {
-                m_device_context->GenerateMips(res.Get());
+    TextureHandle TextureManager::create_texture(const TextureSource &source)
+    {
+        // Threads requesting the same texture wait for the one creating it
+        XID name_id = string_to_id(source.name);
+        if (!check_texture_id(name_id, source.name))
+        {
+            DX_CORE_CRITICAL("Texture '{}' is refused, its ID belongs to another texture", source.name);
+        }
+        bool is_created = false;
+        m_texture_srvs.get_or_create(name_id, [this, &source, name_id, &is_created]()
+        {
+            is_created = true;
+            auto [content_key, byte_width] = source_content_key(source);
+            if (auto shared_texture = share_texture(source.name, content_key, byte_width))
+            {
+                return shared_texture;
             }
 
-            return res.Get();
-        } else
+            auto image = decode_image(source, content_key, true);
+            return upload_image(name_id, source, content_key, image);
+        });
+
+        if (!is_created && source.data.empty())
         {
-            DX_CORE_CRITICAL("Fail to create texture via stb image: {}", filename);
+            DX_CORE_WARN("{} texture asset has been loaded", source.name);
         }
+        return TextureHandle{ name_id };
     }
 
-    ID3D11ShaderResourceView *TextureManager::create_from_memory(std::string_view name, void *data, size_t byte_width, bool enable_mips, uint32_t force_SRGB)
+    com_ptr<ID3D11ShaderResourceView> TextureManager::upload_image(XID name_id, const TextureSource &source, XID content_key, DecodedImage &image)
     {
-        XID file_id = string_to_id(name);
-        if (m_texture_srvs.count(file_id))
+        if (image.dds)
         {
-            return m_texture_srvs[file_id].Get();
+            if (auto texture = upload_dds(name_id, source, content_key, image))
+            {
+                return texture;
+            }
+            DX_CORE_INFO("Fail to create texture from DDS, try DDS texture library: {}", source.name);
+            image.dds.reset();
+            image.dds_file = {};
+            image.is_dds = true;
         }
 
-        auto&& res = m_texture_srvs[file_id];
-        int32_t width = 0, height = 0, comp = 0;
-        std::unique_ptr<uint8_t, StbImageDeleter> img_data(stbi_load_from_memory(reinterpret_cast<uint8_t *>(data), static_cast<int32_t>(byte_width),
-                                                                &width, &height, &comp, STBI_rgb_alpha));
-        if (img_data)
-        {
-            CD3D11_TEXTURE2D_DESC tex_desc(force_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM,
-                                        width, height, 1,
-                                        enable_mips ? 0 : 1,
-                                        D3D11_BIND_SHADER_RESOURCE | (enable_mips ? D3D11_BIND_RENDER_TARGET : 0),
-                                        D3D11_USAGE_DEFAULT, 0, 1, 0,
-                                        enable_mips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0);
-            com_ptr<ID3D11Texture2D> tex = nullptr;
-            m_device->CreateTexture2D(&tex_desc, nullptr, tex.GetAddressOf());
-            // Update texture data
-            m_device_context->UpdateSubresource(tex.Get(), 0, nullptr, img_data.get(), width * sizeof(uint32_t), 0);
-            CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(D3D11_SRV_DIMENSION_TEXTURE2D,
-                                                    force_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM);
-            // Create srv
-            m_device->CreateShaderResourceView(tex.Get(), &srv_desc, res.ReleaseAndGetAddressOf());
-            // Generate mipmap
-            if (enable_mips)
-            {
-                m_device_context->GenerateMips(res.Get());
+        com_ptr<ID3D11ShaderResourceView> res = nullptr;
+        if (image.is_dds)
+        {
+            // Mips are generated by immediate context, so only on owning thread
+            auto file = VirtualFileSystem::get().open(std::filesystem::path(source.name));
+            auto hr = file.is_open() ? DirectX::CreateDDSTextureFromMemoryEx(
+                    m_device.Get(), (source.enable_mips && is_owner_thread() ? m_device_context.Get() : nullptr),
+                    file.data(), file.size(), 0, D3D11_USAGE_DEFAULT,
+                    D3D11_BIND_SHADER_RESOURCE, 0, 0,
+                    static_cast<DirectX::DDS_LOADER_FLAGS>(source.force_SRGB), nullptr, res.ReleaseAndGetAddressOf()) : E_FAIL;
+            if (SUCCEEDED(hr))
+            {
+                register_texture_content(content_key, res.Get());
+                return res;
             }
+            DX_CORE_INFO("Unsupported image type for DDS texture library, try to use stb image");
+            image = decode_image(source, content_key, false);
+        }
 
-            return res.Get();
-        } else
+        if (image.compressed)
         {
-            DX_CORE_CRITICAL("Fail to create texture");
+            return upload_compressed(name_id, source, content_key, image);
         }
+
+        if (!image.pixels && !image.hdr && image.mips.empty())
+        {
+            DX_CORE_CRITICAL("Fail to create texture via stb image: {}", source.name);
+        }
+        bool from_file = source.data.empty();
+        if (from_file && image.hdr)
+        {
+            DX_CORE_INFO("Load HDR image: {}", source.name);
+        } else if (from_file)
+        {
+            DX_CORE_INFO("Load image: {}", source.name);
+        }
+
+        auto width = static_cast<uint32_t>(image.width);
+        auto height = static_cast<uint32_t>(image.height);
+        if (from_file && m_streaming_enabled && !image.mips.empty() && !image.hdr)
+        {
+            // Streamed texture is not shared by content, its view is replaced on every mip change
+            StreamedTexture streamed_texture{ source.name, width, height,
+                                              source.force_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM };
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_streaming.add(name_id, width, height, STBI_rgb_alpha * 8);
+            uint32_t tail_mip = m_streaming.get_tail_mip(name_id);
+            res = upload_streamed_mips(streamed_texture, tail_mip, get_init_data(std::span(image.mips).subspan(tail_mip), STBI_rgb_alpha));
+            m_streamed_textures[name_id] = std::move(streamed_texture);
+            return res;
+        }
+
+        DXGI_FORMAT texture_format = image.hdr ? get_dxgi_format(image.hdr->format) :
+                                     (source.force_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM);
+        uint32_t texel_byte_width = image.hdr ? get_texel_byte_width(image.hdr->format) : static_cast<uint32_t>(STBI_rgb_alpha);
+        const void* top_pixels = image.hdr ? static_cast<const void*>(image.hdr->pixels.data()) : image.pixels.get();
+        std::vector<D3D11_SUBRESOURCE_DATA> init_data = image.mips.empty() ?
+            std::vector<D3D11_SUBRESOURCE_DATA>{ { top_pixels, width * texel_byte_width, 0 } } :
+            get_init_data(image.mips, texel_byte_width);
+        // Mips come from CPU, texture needs no render target binding
+        CD3D11_TEXTURE2D_DESC tex_desc(texture_format, width, height, 1, static_cast<uint32_t>(init_data.size()), D3D11_BIND_SHADER_RESOURCE);
+
+        com_ptr<ID3D11Texture2D> texture = nullptr;
+        if (FAILED(m_device->CreateTexture2D(&tex_desc, init_data.data(), texture.GetAddressOf())))
+        {
+            DX_CORE_CRITICAL("Fail to create texture: {}", source.name);
+        }
+        // Create SRV
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(D3D11_SRV_DIMENSION_TEXTURE2D, texture_format);
+        m_device->CreateShaderResourceView(texture.Get(), &srv_desc, res.ReleaseAndGetAddressOf());
+
+        register_texture_content(content_key, res.Get());
+        return res;
+    }
+
+    com_ptr<ID3D11ShaderResourceView> TextureManager::upload_dds(XID name_id, const TextureSource &source, XID content_key, const DecodedImage &image)
+    {
+        auto&& dds = *image.dds;
+        auto&& desc = dds.desc;
+        DXGI_FORMAT format = source.force_SRGB ? get_srgb_format(desc.format) : desc.format;
+        DX_CORE_INFO("Load DDS image: {}", source.name);
+
+        // Block compressed DDS with every mip streams as texture cache does, promotion maps the file again
+        uint32_t block_byte_width = get_block_byte_width(desc.format);
+        if (m_streaming_enabled && block_byte_width != 0 && desc.array_size == 1 && desc.mip_count == get_mip_count(desc.width, desc.height))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_streaming.add(name_id, desc.width, desc.height, block_byte_width / 2);
+            uint32_t tail_mip = m_streaming.get_tail_mip(name_id);
+            if (desc.width % (4u << tail_mip) == 0 && desc.height % (4u << tail_mip) == 0)
+            {
+                StreamedTexture streamed_texture{ source.name, desc.width, desc.height, format, std::filesystem::path(source.name) };
+                auto res = upload_streamed_mips(streamed_texture, tail_mip, get_init_data(dds, tail_mip));
+                m_streamed_textures[name_id] = std::move(streamed_texture);
+                return res;
+            }
+            m_streaming.remove(name_id);
+        }
+
+        // Driver copies subresources straight from file view, DDS data is never copied to heap
+        auto init_data = get_init_data(dds, 0);
+        CD3D11_TEXTURE2D_DESC tex_desc(format, desc.width, desc.height, desc.array_size, desc.mip_count, D3D11_BIND_SHADER_RESOURCE,
+                                       D3D11_USAGE_DEFAULT, 0, 1, 0, desc.is_cube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0);
+        com_ptr<ID3D11Texture2D> texture = nullptr;
+        if (FAILED(m_device->CreateTexture2D(&tex_desc, init_data.data(), texture.GetAddressOf())))
+        {
+            return nullptr;
+        }
+        D3D11_SRV_DIMENSION dimension = desc.is_cube ? (desc.array_size > 6 ? D3D11_SRV_DIMENSION_TEXTURECUBEARRAY : D3D11_SRV_DIMENSION_TEXTURECUBE) :
+                                        (desc.array_size > 1 ? D3D11_SRV_DIMENSION_TEXTURE2DARRAY : D3D11_SRV_DIMENSION_TEXTURE2D);
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(texture.Get(), dimension, format);
+        com_ptr<ID3D11ShaderResourceView> res = nullptr;
+        m_device->CreateShaderResourceView(texture.Get(), &srv_desc, res.ReleaseAndGetAddressOf());
+
+        register_texture_content(content_key, res.Get());
+        return res;
+    }
+
+    com_ptr<ID3D11ShaderResourceView> TextureManager::upload_compressed(XID name_id, const TextureSource &source, XID content_key, const DecodedImage &image)
+    {
+        auto&& compressed = *image.compressed;
+        DX_CORE_INFO("Load compressed image: {}", source.name);
+
+        // Streamed texture must keep whole blocks in its most detailed resident mip down to mip tail
+        if (m_streaming_enabled && !image.cache_path.empty())
+        {
+            // Blocks of 4 x 4 texels take 8 or 16 bytes
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_streaming.add(name_id, compressed.width, compressed.height, get_block_byte_width(compressed.block_format) / 2);
+            uint32_t tail_mip = m_streaming.get_tail_mip(name_id);
+            if (compressed.width % (4u << tail_mip) == 0 && compressed.height % (4u << tail_mip) == 0)
+            {
+                StreamedTexture streamed_texture{ source.name, compressed.width, compressed.height, compressed.get_format(), image.cache_path };
+                auto res = upload_streamed_mips(streamed_texture, tail_mip, get_init_data(compressed, tail_mip));
+                m_streamed_textures[name_id] = std::move(streamed_texture);
+                return res;
+            }
+            m_streaming.remove(name_id);
+        }
+
+        auto init_data = get_init_data(compressed, 0);
+        CD3D11_TEXTURE2D_DESC tex_desc(compressed.get_format(), compressed.width, compressed.height, 1, compressed.mip_count,
+                                       D3D11_BIND_SHADER_RESOURCE);
+        com_ptr<ID3D11Texture2D> texture = nullptr;
+        com_ptr<ID3D11ShaderResourceView> res = nullptr;
+        if (FAILED(m_device->CreateTexture2D(&tex_desc, init_data.data(), texture.GetAddressOf())))
+        {
+            DX_CORE_CRITICAL("Fail to create compressed texture: {}", source.name);
+        }
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(D3D11_SRV_DIMENSION_TEXTURE2D, tex_desc.Format);
+        m_device->CreateShaderResourceView(texture.Get(), &srv_desc, res.ReleaseAndGetAddressOf());
+
+        register_texture_content(content_key, res.Get());
+        return res;
     }
 
     bool TextureManager::add_texture(std::string_view name, ID3D11ShaderResourceView *texture)
     {
         XID name_id = string_to_id(name);
-        return m_texture_srvs.try_emplace(name_id, texture).second;
+        if (!check_texture_id(name_id, name))
+        {
+            return false;
+        }
+        return m_texture_srvs.insert(name_id, com_ptr<ID3D11ShaderResourceView>(texture));
     }
 
     void TextureManager::remove_texture(std::string_view name)
     {
         XID name_id = string_to_id(name);
-        m_texture_srvs.erase(name_id);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_id_checker.remove(name_id);
+            m_texture_srvs.erase(name_id);
+            m_streaming.remove(name_id);
+            m_streamed_textures.erase(name_id);
+        }
+
+        // Release shared textures no longer referenced by any name
+        m_content_srvs.erase_if([](XID, const com_ptr<ID3D11ShaderResourceView>& texture) { return get_reference_count(texture.Get()) == 1; });
     }
 
-    ID3D11ShaderResourceView* TextureManager::get_texture(std::string_view filename)
+    com_ptr<ID3D11ShaderResourceView> TextureManager::share_texture(std::string_view name, XID content_key, size_t byte_width)
     {
-        XID file_id = string_to_id(filename);
-        if (m_texture_srvs.count(file_id))
+        std::optional<com_ptr<ID3D11ShaderResourceView>> shared_texture{};
+        if (content_key != 0)
         {
-            return m_texture_srvs[file_id].Get();
+            shared_texture = m_content_srvs.find(content_key);
         }
-        return nullptr;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.request_count++;
+        m_statistics.requested_bytes += byte_width;
+        if (!shared_texture)
+        {
+            return nullptr;
+        }
+
+        m_statistics.shared_count++;
+        m_statistics.saved_bytes += byte_width;
+        DX_CORE_INFO("Texture '{}' shares content with a loaded texture", name);
+        return *shared_texture;
     }
 
-    ID3D11ShaderResourceView* TextureManager::get_null_texture()
+    bool TextureManager::check_texture_id(XID name_id, std::string_view name)
     {
-        return m_texture_srvs[0].Get();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_id_checker.check(name_id, name);
     }
-}
 
+    void TextureManager::register_texture_content(XID content_key, ID3D11ShaderResourceView *texture)
+    {
+        if (content_key != 0 && texture)
+        {
+            m_content_srvs.insert(content_key, com_ptr<ID3D11ShaderResourceView>(texture));
+        }
+    }
 
+    DeduplicationStatistics TextureManager::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
 
+    void TextureManager::enable_streaming(size_t budget)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streaming.set_budget(budget);
+        m_streaming_enabled = true;
+    }
 
+    void TextureManager::request_texture(XID texture_id, float screen_uv_area)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streaming.request(texture_id, screen_uv_area);
+    }
 
+    void TextureManager::update_streaming()
+    {
+        // Textures created meanwhile on other threads wait for their streaming bookkeeping
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_streamed_textures.empty())
+        {
+            return;
+        }
 
+        // Demotions come first and free memory for promotions
+        for (auto&& change : m_streaming.update())
+        {
+            if (change.promotion)
+            {
+                promote_texture(change.id, change.resident_mip);
+            } else
+            {
+                demote_texture(change.id, change.resident_mip);
+            }
+        }
+    }
 
+    TextureStreamingStatistics TextureManager::get_streaming_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_streaming.get_statistics();
+    }
 
+    com_ptr<ID3D11ShaderResourceView> TextureManager::upload_streamed_mips(const StreamedTexture &streamed_texture, uint32_t first_mip,
+                                                                           std::span<const D3D11_SUBRESOURCE_DATA> mips)
+    {
+        CD3D11_TEXTURE2D_DESC tex_desc(streamed_texture.format, std::max(streamed_texture.width >> first_mip, 1u),
+                                       std::max(streamed_texture.height >> first_mip, 1u), 1,
+                                       static_cast<uint32_t>(mips.size()), D3D11_BIND_SHADER_RESOURCE);
+        com_ptr<ID3D11Texture2D> texture = nullptr;
+        if (FAILED(m_device->CreateTexture2D(&tex_desc, mips.data(), texture.GetAddressOf())))
+        {
+            DX_CORE_WARN("Fail to create streamed texture '{}' of {} x {}", streamed_texture.file_name, tex_desc.Width, tex_desc.Height);
+            return nullptr;
+        }
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(D3D11_SRV_DIMENSION_TEXTURE2D, streamed_texture.format);
+        com_ptr<ID3D11ShaderResourceView> res = nullptr;
+        m_device->CreateShaderResourceView(texture.Get(), &srv_desc, res.GetAddressOf());
+        return res;
+    }
+
+    void TextureManager::promote_texture(XID texture_id, uint32_t resident_mip)
+    {
+        auto it = m_streamed_textures.find(texture_id);
+        if (it == m_streamed_textures.end())
+        {
+            return;
+        }
+
+        auto&& streamed_texture = it->second;
+        if (!streamed_texture.dds_path.empty())
+        {
+            // Only pages of mips from resident_mip down are touched
+            auto file = VirtualFileSystem::get().open(streamed_texture.dds_path);
+            auto dds = parse_dds(file.bytes());
+            if (!dds || dds->desc.width != streamed_texture.width || dds->desc.height != streamed_texture.height ||
+                dds->desc.array_size != 1 || dds->desc.mip_count != get_mip_count(streamed_texture.width, streamed_texture.height))
+            {
+                DX_CORE_WARN("Fail to stream texture '{}', DDS is unreadable or has changed", streamed_texture.file_name);
+                return;
+            }
+            if (auto res = upload_streamed_mips(streamed_texture, resident_mip, get_init_data(*dds, resident_mip)))
+            {
+                m_texture_srvs.insert_or_assign(texture_id, std::move(res));
+            }
+            return;
+        }
 
+        int32_t width = 0, height = 0, comp = 0;
+        auto file = VirtualFileSystem::get().open(std::filesystem::path(streamed_texture.file_name));
+        std::unique_ptr<uint8_t, StbImageDeleter> img_data{};
+        if (file.size() > 0)
+        {
+            img_data.reset(stbi_load_from_memory(file.data(), static_cast<int32_t>(file.size()), &width, &height, &comp, STBI_rgb_alpha));
+        }
+        if (!img_data || static_cast<uint32_t>(width) != streamed_texture.width || static_cast<uint32_t>(height) != streamed_texture.height)
+        {
+            DX_CORE_WARN("Fail to stream texture '{}', source image is unreadable or has changed", streamed_texture.file_name);
+            return;
+        }
 
+        bool srgb = streamed_texture.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        auto mips = generate_mip_chain(img_data.get(), streamed_texture.width, streamed_texture.height, srgb, resident_mip);
+        if (auto res = upload_streamed_mips(streamed_texture, resident_mip, get_init_data(mips, STBI_rgb_alpha)))
+        {
+            m_texture_srvs.insert_or_assign(texture_id, std::move(res));
+        }
+    }
 
+    void TextureManager::demote_texture(XID texture_id, uint32_t resident_mip)
+    {
+        auto it = m_streamed_textures.find(texture_id);
+        auto current_texture = m_texture_srvs.find(texture_id);
+        if (it == m_streamed_textures.end() || !current_texture || !*current_texture)
+        {
+            return;
+        }
 
+        // Less detailed mips are already resident, copy them into a smaller texture
+        auto&& streamed_texture = it->second;
+        com_ptr<ID3D11Resource> resource = nullptr;
+        (*current_texture)->GetResource(resource.GetAddressOf());
+        com_ptr<ID3D11Texture2D> old_texture = nullptr;
+        if (FAILED(resource.As(&old_texture)))
+        {
+            return;
+        }
+        D3D11_TEXTURE2D_DESC old_desc{};
+        old_texture->GetDesc(&old_desc);
 
+        uint32_t mip_count = get_mip_count(streamed_texture.width, streamed_texture.height) - resident_mip;
+        if (mip_count >= old_desc.MipLevels)
+        {
+            return;
+        }
+        uint32_t skipped_mips = old_desc.MipLevels - mip_count;
 
+        CD3D11_TEXTURE2D_DESC tex_desc(streamed_texture.format, std::max(old_desc.Width >> skipped_mips, 1u),
+                                       std::max(old_desc.Height >> skipped_mips, 1u), 1, mip_count, D3D11_BIND_SHADER_RESOURCE);
+        com_ptr<ID3D11Texture2D> texture = nullptr;
+        if (FAILED(m_device->CreateTexture2D(&tex_desc, nullptr, texture.GetAddressOf())))
+        {
+            DX_CORE_WARN("Fail to create streamed texture '{}' of {} x {}", streamed_texture.file_name, tex_desc.Width, tex_desc.Height);
+            return;
+        }
+        for (uint32_t mip = 0; mip < mip_count; ++mip)
+        {
+            m_device_context->CopySubresourceRegion(texture.Get(), mip, 0, 0, 0, old_texture.Get(), mip + skipped_mips, nullptr);
+        }
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srv_desc(D3D11_SRV_DIMENSION_TEXTURE2D, streamed_texture.format);
+        com_ptr<ID3D11ShaderResourceView> res = nullptr;
+        m_device->CreateShaderResourceView(texture.Get(), &srv_desc, res.GetAddressOf());
+        m_texture_srvs.insert_or_assign(texture_id, std::move(res));
+    }
 
+    ID3D11ShaderResourceView* TextureManager::get_texture(std::string_view filename) const
+    {
+        return get_texture(string_to_id(filename));
+    }
 
+    ID3D11ShaderResourceView* TextureManager::get_texture(XID texture_id) const
+    {
+        // Registry keeps its own reference, view stays valid until it is replaced or removed
+        auto texture = m_texture_srvs.find(texture_id);
+        return texture ? texture->Get() : nullptr;
+    }
 
+    ID3D11ShaderResourceView* TextureManager::get_null_texture() const
+    {
+        return get_texture(XID{ 0 });
+    }
 
+    com_ptr<ID3D11ShaderResourceView> TextureManager::get_texture_view(XID texture_id) const
+    {
+        auto texture = m_texture_srvs.find(texture_id);
+        return texture ? *texture : nullptr;
+    }
+}
@@ -0,0 +1,231 @@
+//
+// Created by ZZK on 2024/4/15.
+//
+
+#include <Toy/Model/texture_streaming.h>
+#include <Toy/Model/mip_generator.h>
+
+namespace toy::model
+{
+    float compute_uv_density(std::span<const uint32_t> indices, std::span<const DirectX::XMFLOAT3> positions,
+                             std::span<const DirectX::XMFLOAT2> texcoords)
+    {
+        using namespace DirectX;
+        if (texcoords.size() < positions.size())
+        {
+            return 0.0f;
+        }
+
+        double world_area = 0.0;
+        double uv_area = 0.0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            uint32_t i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+            XMVECTOR p0 = XMLoadFloat3(&positions[i0]);
+            XMVECTOR edge = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&positions[i1]), p0),
+                                           XMVectorSubtract(XMLoadFloat3(&positions[i2]), p0));
+            world_area += 0.5 * XMVectorGetX(XMVector3Length(edge));
+
+            auto&& t0 = texcoords[i0];
+            auto&& t1 = texcoords[i1];
+            auto&& t2 = texcoords[i2];
+            uv_area += 0.5 * std::abs((t1.x - t0.x) * (t2.y - t0.y) - (t2.x - t0.x) * (t1.y - t0.y));
+        }
+        return uv_area > 0.0 ? static_cast<float>(world_area / uv_area) : 0.0f;
+    }
+
+    float compute_screen_uv_area(float uv_density, float world_scale, float distance, float projection_scale)
+    {
+        // Unknown density or camera inside bounds, ask for full resolution
+        if (uv_density <= 0.0f || distance <= 1e-4f)
+        {
+            return std::numeric_limits<float>::max();
+        }
+        float pixels_per_unit = world_scale * projection_scale / distance;
+        return uv_density * pixels_per_unit * pixels_per_unit;
+    }
+
+    uint32_t compute_required_mip(uint32_t width, uint32_t height, float screen_uv_area)
+    {
+        if (screen_uv_area <= 0.0f)
+        {
+            return get_mip_count(width, height) - 1;
+        }
+        // Every mip quarters texel area
+        float texels_per_pixel = static_cast<float>(width) * static_cast<float>(height) / screen_uv_area;
+        float mip = 0.5f * std::log2(std::max(texels_per_pixel, 1.0f));
+        return std::min(static_cast<uint32_t>(mip), get_mip_count(width, height) - 1);
+    }
+
+    void TextureStreamingPolicy::add(XID id, uint32_t width, uint32_t height, uint32_t bits_per_texel)
+    {
+        remove(id);
+
+        auto&& texture = m_textures[id];
+        texture.width = width;
+        texture.height = height;
+        texture.bits_per_texel = bits_per_texel;
+        texture.tail_mip = get_mip_count(width, height) - 1;
+        while (texture.tail_mip > 0 &&
+               std::max(width >> (texture.tail_mip - 1), height >> (texture.tail_mip - 1)) <= streaming_mip_tail_size)
+        {
+            texture.tail_mip--;
+        }
+        texture.resident_mip = texture.tail_mip;
+        texture.requested_mip = texture.tail_mip;
+
+        m_statistics.resident_bytes += byte_width(texture, texture.resident_mip);
+        m_statistics.streamed_texture_count++;
+    }
+
+    void TextureStreamingPolicy::remove(XID id)
+    {
+        if (auto it = m_textures.find(id); it != m_textures.end())
+        {
+            m_statistics.resident_bytes -= byte_width(it->second, it->second.resident_mip);
+            m_statistics.streamed_texture_count--;
+            m_textures.erase(it);
+        }
+    }
+
+    void TextureStreamingPolicy::request(XID id, float screen_uv_area)
+    {
+        if (auto it = m_textures.find(id); it != m_textures.end())
+        {
+            it->second.screen_uv_area = std::max(it->second.screen_uv_area, screen_uv_area);
+        }
+    }
+
+    std::vector<MipChange> TextureStreamingPolicy::update()
+    {
+        m_update_index++;
+        m_statistics.requested_bytes = 0;
+
+        std::vector<std::pair<XID, StreamedTexture*>> promotions{};
+        for (auto&& [id, texture] : m_textures)
+        {
+            if (texture.screen_uv_area > 0.0f)
+            {
+                texture.requested_mip = std::min(compute_required_mip(texture.width, texture.height, texture.screen_uv_area), texture.tail_mip);
+                texture.last_request = m_update_index;
+                if (texture.requested_mip < texture.resident_mip)
+                {
+                    promotions.emplace_back(id, &texture);
+                }
+            } else
+            {
+                texture.requested_mip = texture.tail_mip;
+            }
+            m_statistics.requested_bytes += byte_width(texture, texture.requested_mip);
+        }
+        std::sort(promotions.begin(), promotions.end(), [](auto&& lhs, auto&& rhs)
+        {
+            return lhs.second->screen_uv_area > rhs.second->screen_uv_area;
+        });
+
+        // Textures holding more than requested are demoted least recently requested first,
+        // textures requested in this update are only demoted down to their request
+        std::vector<std::pair<XID, StreamedTexture*>> candidates{};
+        for (auto&& [id, texture] : m_textures)
+        {
+            if (texture.resident_mip < texture.requested_mip)
+            {
+                candidates.emplace_back(id, &texture);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](auto&& lhs, auto&& rhs)
+        {
+            return lhs.second->last_request < rhs.second->last_request;
+        });
+
+        std::vector<MipChange> changes{};
+        size_t next_candidate = 0;
+        auto make_room = [&](size_t incoming_byte_width)
+        {
+            while (m_statistics.resident_bytes + incoming_byte_width > m_budget && next_candidate < candidates.size())
+            {
+                auto [id, texture] = candidates[next_candidate++];
+                demote(id, *texture, texture->requested_mip, changes);
+            }
+            return m_statistics.resident_bytes + incoming_byte_width <= m_budget;
+        };
+
+        // Budget may have been lowered since last update
+        make_room(0);
+
+        size_t uploaded_bytes = 0;
+        for (auto [id, texture] : promotions)
+        {
+            if (uploaded_bytes >= streaming_upload_bytes_per_update)
+            {
+                break;
+            }
+
+            // Fall back to the most detailed mip that fits when requested one does not
+            size_t resident_byte_width = byte_width(*texture, texture->resident_mip);
+            uint32_t mip = texture->requested_mip;
+            for (; mip < texture->resident_mip; ++mip)
+            {
+                if (make_room(byte_width(*texture, mip) - resident_byte_width))
+                {
+                    break;
+                }
+            }
+            if (mip == texture->resident_mip)
+            {
+                continue;
+            }
+
+            size_t promoted_byte_width = byte_width(*texture, mip) - resident_byte_width;
+            texture->resident_mip = mip;
+            m_statistics.resident_bytes += promoted_byte_width;
+            m_statistics.promotion_count++;
+            m_statistics.promoted_bytes += promoted_byte_width;
+            uploaded_bytes += promoted_byte_width;
+            changes.push_back({ id, mip, true });
+        }
+
+        for (auto&& [id, texture] : m_textures)
+        {
+            texture.screen_uv_area = 0.0f;
+        }
+        return changes;
+    }
+
+    uint32_t TextureStreamingPolicy::get_resident_mip(XID id) const
+    {
+        auto it = m_textures.find(id);
+        return it != m_textures.end() ? it->second.resident_mip : 0;
+    }
+
+    uint32_t TextureStreamingPolicy::get_tail_mip(XID id) const
+    {
+        auto it = m_textures.find(id);
+        return it != m_textures.end() ? it->second.tail_mip : 0;
+    }
+
+    size_t TextureStreamingPolicy::get_mip_chain_byte_width(uint32_t width, uint32_t height, uint32_t bits_per_texel, uint32_t first_mip)
+    {
+        size_t byte_width = 0;
+        uint32_t mip_count = get_mip_count(width, height);
+        for (uint32_t mip = first_mip; mip < mip_count; ++mip)
+        {
+            byte_width += static_cast<size_t>(std::max(width >> mip, 1u)) * std::max(height >> mip, 1u) * bits_per_texel / 8;
+        }
+        return byte_width;
+    }
+
+    size_t TextureStreamingPolicy::byte_width(const StreamedTexture &texture, uint32_t mip) const
+    {
+        return get_mip_chain_byte_width(texture.width, texture.height, texture.bits_per_texel, mip);
+    }
+
+    void TextureStreamingPolicy::demote(XID id, StreamedTexture &texture, uint32_t mip, std::vector<MipChange> &changes)
+    {
+        size_t released_bytes = byte_width(texture, texture.resident_mip) - byte_width(texture, mip);
+        texture.resident_mip = mip;
+        m_statistics.resident_bytes -= released_bytes;
+        m_statistics.demotion_count++;
+        changes.push_back({ id, mip, false });
+    }
+}
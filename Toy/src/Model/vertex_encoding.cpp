@@ -0,0 +1,290 @@
+//
+// Created by ZZK on 2024/4/10.
+//
+
+#include <Toy/Model/vertex_encoding.h>
+
+namespace toy::model
+{
+    using namespace DirectX;
+    using namespace DirectX::PackedVector;
+
+    static constexpr uint32_t s_invalid_vertex = UINT32_MAX;
+
+    XMUSHORTN4 encode_position(const XMFLOAT3 &position, const BoundingBox &bounding_box, float handedness)
+    {
+        XMFLOAT3 scale{};
+        XMFLOAT3 offset{};
+        get_position_dequantization(bounding_box, scale, offset);
+
+        // Flat axis of bounding box is encoded as 0, decoded back to offset
+        auto normalize = [](float value, float scale, float offset) { return scale > 0.0f ? (value - offset) / scale : 0.0f; };
+        XMFLOAT4 normalized{
+            normalize(position.x, scale.x, offset.x),
+            normalize(position.y, scale.y, offset.y),
+            normalize(position.z, scale.z, offset.z),
+            handedness < 0.0f ? 0.0f : 1.0f
+        };
+
+        XMUSHORTN4 result{};
+        XMStoreUShortN4(&result, XMLoadFloat4(&normalized));
+        return result;
+    }
+
+    XMFLOAT3 decode_position(const XMUSHORTN4 &position, const BoundingBox &bounding_box)
+    {
+        XMFLOAT3 scale{};
+        XMFLOAT3 offset{};
+        get_position_dequantization(bounding_box, scale, offset);
+
+        XMFLOAT3 result{};
+        XMStoreFloat3(&result, XMVectorMultiplyAdd(XMLoadUShortN4(&position), XMLoadFloat3(&scale), XMLoadFloat3(&offset)));
+        return result;
+    }
+
+    float decode_handedness(const XMUSHORTN4 &position)
+    {
+        return position.w > 0 ? 1.0f : -1.0f;
+    }
+
+    XMSHORTN2 encode_octahedral(const XMFLOAT3 &direction)
+    {
+        // Project onto octahedron, then fold lower hemisphere over the diagonals
+        float inv_l1 = 1.0f / std::max(std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z), 1.0e-20f);
+        float x = direction.x * inv_l1;
+        float y = direction.y * inv_l1;
+        if (direction.z < 0.0f)
+        {
+            float folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = folded_x;
+            y = folded_y;
+        }
+
+        XMFLOAT2 encoded{ x, y };
+        XMSHORTN2 result{};
+        XMStoreShortN2(&result, XMLoadFloat2(&encoded));
+        return result;
+    }
+
+    XMFLOAT3 decode_octahedral(const XMSHORTN2 &direction)
+    {
+        XMFLOAT2 encoded{};
+        XMStoreFloat2(&encoded, XMLoadShortN2(&direction));
+
+        XMFLOAT3 result{ encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+        float t = std::clamp(-result.z, 0.0f, 1.0f);
+        result.x += result.x >= 0.0f ? -t : t;
+        result.y += result.y >= 0.0f ? -t : t;
+        XMStoreFloat3(&result, XMVector3Normalize(XMLoadFloat3(&result)));
+        return result;
+    }
+
+    std::vector<XMFLOAT4> make_handed_tangents(std::span<const XMFLOAT3> normals, std::span<const XMFLOAT4> tangents,
+                                               std::span<const XMFLOAT4> bitangents)
+    {
+        std::vector<XMFLOAT4> handed_tangents(tangents.begin(), tangents.end());
+        for (size_t i = 0; i < handed_tangents.size(); ++i)
+        {
+            XMVECTOR t = XMLoadFloat4(&tangents[i]);
+            XMVECTOR b = i < bitangents.size() ? XMLoadFloat4(&bitangents[i]) : XMVectorZero();
+            XMVECTOR n = i < normals.size() ? XMLoadFloat3(&normals[i]) : XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+            handed_tangents[i].w = XMVectorGetX(XMVector3Dot(XMVector3Cross(n, t), b)) < 0.0f ? -1.0f : 1.0f;
+        }
+        return handed_tangents;
+    }
+
+    void get_position_dequantization(const BoundingBox &bounding_box, XMFLOAT3 &scale, XMFLOAT3 &offset)
+    {
+        XMVECTOR center = XMLoadFloat3(&bounding_box.Center);
+        XMVECTOR extents = XMLoadFloat3(&bounding_box.Extents);
+        XMStoreFloat3(&scale, XMVectorAdd(extents, extents));
+        XMStoreFloat3(&offset, XMVectorSubtract(center, extents));
+    }
+
+    static void encode_chunk(const VertexStreams &streams, QuantizedChunk &chunk)
+    {
+        auto num_vertices = chunk.source_vertices.size();
+
+        std::vector<XMFLOAT3> positions(num_vertices);
+        for (size_t i = 0; i < num_vertices; ++i)
+        {
+            positions[i] = streams.positions[chunk.source_vertices[i]];
+        }
+        BoundingBox::CreateFromPoints(chunk.bounding_box, num_vertices, positions.data(), sizeof(XMFLOAT3));
+
+        chunk.positions.resize(num_vertices);
+        for (size_t i = 0; i < num_vertices; ++i)
+        {
+            float handedness = streams.tangents.empty() ? 1.0f : streams.tangents[chunk.source_vertices[i]].w;
+            chunk.positions[i] = encode_position(positions[i], chunk.bounding_box, handedness);
+        }
+
+        if (!streams.normals.empty())
+        {
+            chunk.normals.resize(num_vertices);
+            for (size_t i = 0; i < num_vertices; ++i)
+            {
+                chunk.normals[i] = encode_octahedral(streams.normals[chunk.source_vertices[i]]);
+            }
+        }
+
+        if (!streams.tangents.empty())
+        {
+            chunk.tangents.resize(num_vertices);
+            for (size_t i = 0; i < num_vertices; ++i)
+            {
+                auto&& tangent = streams.tangents[chunk.source_vertices[i]];
+                chunk.tangents[i] = encode_octahedral(XMFLOAT3{ tangent.x, tangent.y, tangent.z });
+            }
+        }
+
+        chunk.texcoords.resize(streams.texcoords.size());
+        for (size_t row = 0; row < streams.texcoords.size(); ++row)
+        {
+            chunk.texcoords[row].resize(num_vertices);
+            for (size_t i = 0; i < num_vertices; ++i)
+            {
+                XMStoreHalf2(&chunk.texcoords[row][i], XMLoadFloat2(&streams.texcoords[row][chunk.source_vertices[i]]));
+            }
+        }
+    }
+
+    std::vector<QuantizedChunk> quantize_vertex_streams(const VertexStreams &streams)
+    {
+        std::vector<QuantizedChunk> chunks{};
+        if (streams.positions.empty() || streams.indices.size() < 3)
+        {
+            return chunks;
+        }
+
+        // Greedy split in triangle order, a triangle starts a new chunk when its new vertices do not fit
+        std::vector<uint32_t> remap(streams.positions.size(), s_invalid_vertex);
+        QuantizedChunk chunk{};
+        auto flush_chunk = [&streams, &remap, &chunk, &chunks]()
+        {
+            for (auto source_vertex : chunk.source_vertices)
+            {
+                remap[source_vertex] = s_invalid_vertex;
+            }
+            encode_chunk(streams, chunk);
+            chunks.push_back(std::move(chunk));
+            chunk = QuantizedChunk{};
+        };
+
+        for (size_t i = 0; i + 2 < streams.indices.size(); i += 3)
+        {
+            const uint32_t* triangle = streams.indices.data() + i;
+            size_t new_vertices = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                if (triangle[corner] >= streams.positions.size())
+                {
+                    DX_CORE_CRITICAL("Vertex index {} out of range of {} vertices", triangle[corner], streams.positions.size());
+                }
+                new_vertices += remap[triangle[corner]] == s_invalid_vertex ? 1 : 0;
+            }
+            if (chunk.source_vertices.size() + new_vertices > quantized_chunk_max_vertices)
+            {
+                flush_chunk();
+            }
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                auto&& local_vertex = remap[triangle[corner]];
+                if (local_vertex == s_invalid_vertex)
+                {
+                    local_vertex = static_cast<uint32_t>(chunk.source_vertices.size());
+                    chunk.source_vertices.push_back(triangle[corner]);
+                }
+                chunk.indices.push_back(static_cast<uint16_t>(local_vertex));
+            }
+        }
+        if (!chunk.indices.empty())
+        {
+            flush_chunk();
+        }
+        return chunks;
+    }
+
+    static float angle_between(const XMFLOAT3 &source, const XMFLOAT3 &decoded)
+    {
+        // atan2 keeps precision for small angles where acos of dot product does not
+        XMVECTOR a = XMVector3Normalize(XMLoadFloat3(&source));
+        XMVECTOR b = XMLoadFloat3(&decoded);
+        return std::atan2(XMVectorGetX(XMVector3Length(XMVector3Cross(a, b))), XMVectorGetX(XMVector3Dot(a, b)));
+    }
+
+    QuantizationError measure_quantization_error(const VertexStreams &streams, std::span<const QuantizedChunk> chunks)
+    {
+        QuantizationError error{};
+        for (auto&& chunk : chunks)
+        {
+            for (size_t i = 0; i < chunk.source_vertices.size(); ++i)
+            {
+                uint32_t source_vertex = chunk.source_vertices[i];
+
+                XMFLOAT3 position = decode_position(chunk.positions[i], chunk.bounding_box);
+                auto&& source_position = streams.positions[source_vertex];
+                error.position = std::max({ error.position, std::abs(position.x - source_position.x),
+                                            std::abs(position.y - source_position.y), std::abs(position.z - source_position.z) });
+
+                if (!chunk.normals.empty())
+                {
+                    error.normal = std::max(error.normal, angle_between(streams.normals[source_vertex], decode_octahedral(chunk.normals[i])));
+                }
+                if (!chunk.tangents.empty())
+                {
+                    auto&& tangent = streams.tangents[source_vertex];
+                    error.tangent = std::max(error.tangent, angle_between(XMFLOAT3{ tangent.x, tangent.y, tangent.z }, decode_octahedral(chunk.tangents[i])));
+                }
+                for (size_t row = 0; row < chunk.texcoords.size(); ++row)
+                {
+                    XMFLOAT2 texcoord{};
+                    XMStoreFloat2(&texcoord, XMLoadHalf2(&chunk.texcoords[row][i]));
+                    auto&& source_texcoord = streams.texcoords[row][source_vertex];
+                    error.texcoord = std::max({ error.texcoord,
+                                                std::abs(texcoord.x - source_texcoord.x) / std::max(std::abs(source_texcoord.x), 1.0f),
+                                                std::abs(texcoord.y - source_texcoord.y) / std::max(std::abs(source_texcoord.y), 1.0f) });
+                }
+            }
+        }
+        return error;
+    }
+
+    bool within_error_bounds(const QuantizationError &error, const BoundingBox &bounding_box)
+    {
+        // Half step of 16-bit grid, plus float rounding of decode
+        float max_extent = std::max({ bounding_box.Extents.x, bounding_box.Extents.y, bounding_box.Extents.z });
+        float max_center = std::max({ std::abs(bounding_box.Center.x), std::abs(bounding_box.Center.y), std::abs(bounding_box.Center.z) });
+        float position_bound = max_extent * quantized_position_error_bound + (max_extent + max_center) * 1.0e-6f;
+
+        return error.position <= position_bound &&
+                error.normal <= quantized_direction_error_bound &&
+                error.tangent <= quantized_direction_error_bound &&
+                error.texcoord <= quantized_texcoord_error_bound;
+    }
+
+    size_t full_precision_byte_width(size_t vertex_count, size_t index_count, size_t texcoord_count)
+    {
+        // Position, normal, tangent, bitangent and texture coordinates, index width follows index count
+        size_t vertex_stride = sizeof(XMFLOAT3) * 2 + sizeof(XMFLOAT4) * 2 + sizeof(XMFLOAT2) * texcoord_count;
+        size_t index_stride = index_count < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+        return vertex_count * vertex_stride + index_count * index_stride;
+    }
+
+    size_t quantized_byte_width(std::span<const QuantizedChunk> chunks)
+    {
+        size_t byte_width = 0;
+        for (auto&& chunk : chunks)
+        {
+            byte_width += chunk.positions.size() * sizeof(XMUSHORTN4) + chunk.normals.size() * sizeof(XMSHORTN2) +
+                            chunk.tangents.size() * sizeof(XMSHORTN2) + chunk.indices.size() * sizeof(uint16_t);
+            for (auto&& texcoords : chunk.texcoords)
+            {
+                byte_width += texcoords.size() * sizeof(XMHALF2);
+            }
+        }
+        return byte_width;
+    }
+}
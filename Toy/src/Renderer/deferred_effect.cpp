@@ -7,6 +7,7 @@
 #include <Toy/Core/d3d_util.h>
 #include <Toy/Geometry/vertex.h>
 #include <Toy/Model/mesh_data.h>
+#include <Toy/Model/vertex_encoding.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Model/material.h>
 
@@ -23,6 +24,16 @@ namespace toy
         D3D11_PRIMITIVE_TOPOLOGY m_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
         com_ptr<ID3D11InputLayout> m_vertex_pos_normal_tex_layout;
+        com_ptr<ID3D11InputLayout> m_quantized_vertex_layout;
+
+        // Current G-Buffer pass and its variant for quantized vertex streams, selected per mesh
+        std::string m_gbuffer_pass;
+        std::string m_gbuffer_quantized_pass;
+
+        // Dequantization of current mesh, identity for full precision mesh
+        DirectX::XMFLOAT3 m_position_scale = { 1.0f, 1.0f, 1.0f };
+        DirectX::XMFLOAT3 m_position_offset = {};
+
         DirectX::XMFLOAT4X4 m_world{};
         DirectX::XMFLOAT4X4 m_view{};
         DirectX::XMFLOAT4X4 m_proj{};
@@ -73,6 +84,17 @@ namespace toy
         device->CreateInputLayout(input_layout.data(), uint32_t(input_layout.size()), blob->GetBufferPointer(), blob->GetBufferSize(),
                                     m_effect_impl->m_vertex_pos_normal_tex_layout.ReleaseAndGetAddressOf());
 
+        // Vertex shader variant decoding quantized vertex streams
+        D3D_SHADER_MACRO quantized_defines[] = {
+            {"QUANTIZED_VERTEX", "1"},
+            {nullptr, nullptr}
+        };
+        m_effect_impl->m_effect_helper->create_shader_from_file("GeometryQuantizedVS", DXTOY_HOME L"data/defer/gbuffer.hlsl", device,
+                                                                "GeometryVS", "vs_5_0", quantized_defines, blob.ReleaseAndGetAddressOf());
+        auto&& quantized_input_layout = VertexPosNormalTangentTexQuantized::get_input_layout();
+        device->CreateInputLayout(quantized_input_layout.data(), uint32_t(quantized_input_layout.size()), blob->GetBufferPointer(), blob->GetBufferSize(),
+                                    m_effect_impl->m_quantized_vertex_layout.ReleaseAndGetAddressOf());
+
         int32_t msaa_samples = 1;
         while (msaa_samples <= 8)
         {
@@ -126,6 +148,14 @@ namespace toy
                 pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
             }
 
+            std::string gbuffer_quantized_pass = "GBufferQuantized_" + msaaSamplesStr + "xMSAA";
+            pass_desc.nameVS = "GeometryQuantizedVS";
+            m_effect_impl->m_effect_helper->add_effect_pass(gbuffer_quantized_pass, device, &pass_desc);
+            {
+                auto pass = m_effect_impl->m_effect_helper->get_effect_pass(gbuffer_quantized_pass);
+                pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
+            }
+
             pass_desc.nameVS = "FullScreenTriangleVS";
             pass_desc.namePS = shaderNames[1];
             m_effect_impl->m_effect_helper->add_effect_pass(passNames[1], device, &pass_desc);
@@ -206,8 +236,10 @@ namespace toy
 
     void DeferredEffect::set_gbuffer_render()
     {
-        std::string gbuffer_pass_str = "GBuffer_" + std::to_string(m_effect_impl->m_msaa_samples) + "xMSAA";
-        m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(gbuffer_pass_str);
+        std::string msaa_samples_str = std::to_string(m_effect_impl->m_msaa_samples);
+        m_effect_impl->m_gbuffer_pass = "GBuffer_" + msaa_samples_str + "xMSAA";
+        m_effect_impl->m_gbuffer_quantized_pass = "GBufferQuantized_" + msaa_samples_str + "xMSAA";
+        m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(m_effect_impl->m_gbuffer_pass);
         m_effect_impl->m_cur_input_layout = m_effect_impl->m_vertex_pos_normal_tex_layout.Get();
         m_effect_impl->m_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
     }
@@ -369,26 +401,50 @@ namespace toy
     {
         auto&& texture_manager = model::TextureManager::get();
 
-        auto texture_id_str = material.try_get<std::string>("$Diffuse");
+        auto texture_id_str = material.try_get<std::string>("$Diffuse"_xid);
         m_effect_impl->m_effect_helper->set_shader_resource_by_name("g_DiffuseMap",
                                                                     texture_id_str ? texture_manager.get_texture(*texture_id_str) : texture_manager.get_null_texture());
     }
 
     MeshDataInput DeferredEffect::get_input_data(const model::MeshData &mesh_data)
     {
+        // Quantized mesh needs decoding vertex shader, pass is selected here before the effect is applied
+        bool is_quantized = mesh_data.vertex_encoding == model::VertexEncoding::Quantized;
+        if (!m_effect_impl->m_gbuffer_pass.empty())
+        {
+            m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(
+                    is_quantized ? m_effect_impl->m_gbuffer_quantized_pass : m_effect_impl->m_gbuffer_pass);
+            m_effect_impl->m_cur_input_layout = is_quantized ? m_effect_impl->m_quantized_vertex_layout.Get() : m_effect_impl->m_vertex_pos_normal_tex_layout.Get();
+        }
+        if (is_quantized)
+        {
+            model::get_position_dequantization(mesh_data.bounding_box, m_effect_impl->m_position_scale, m_effect_impl->m_position_offset);
+        } else
+        {
+            m_effect_impl->m_position_scale = DirectX::XMFLOAT3{ 1.0f, 1.0f, 1.0f };
+            m_effect_impl->m_position_offset = DirectX::XMFLOAT3{};
+        }
+
         MeshDataInput input;
         input.input_layout = m_effect_impl->m_cur_input_layout.Get();
         input.topology = m_effect_impl->m_topology;
-        input.vertex_buffers = {
-                mesh_data.vertices.Get(),
-                mesh_data.normals.Get(),
-                mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
-        };
-        input.strides = { 12, 12, 8 };
-        input.offsets = { 0, 0, 0 };
+        auto texcoord = mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get();
+        if (is_quantized)
+        {
+            // Quantized layout reads tangent stream at slot 2
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), mesh_data.tangents.Get(), texcoord };
+            input.strides = { 8, 4, 4, 4 };
+            input.offsets = { 0, 0, 0, 0 };
+        } else
+        {
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), texcoord };
+            input.strides = { 12, 12, 8 };
+            input.offsets = { 0, 0, 0 };
+        }
 
         input.index_buffer = mesh_data.indices.Get();
         input.index_count = mesh_data.index_count;
+        input.index_format = mesh_data.index_format;
 
         return input;
     }
@@ -419,6 +475,8 @@ namespace toy
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_InvView")->set_float_matrix(4, 4, (float*)&inv_view);
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_ViewProj")->set_float_matrix(4, 4, (float*)&view_proj);
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_Proj")->set_float_matrix(4, 4, (float*)&proj);
+        m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_PositionScale")->set_float_vector(3, (const float*)&m_effect_impl->m_position_scale);
+        m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_PositionOffset")->set_float_vector(3, (const float*)&m_effect_impl->m_position_offset);
 
         if (m_effect_impl->m_cur_effect_pass)
         {
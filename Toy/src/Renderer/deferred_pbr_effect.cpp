@@ -6,26 +6,22 @@
 #include <Toy/Renderer/render_states.h>
 #include <Toy/Geometry/vertex.h>
 #include <Toy/Model/mesh_data.h>
+#include <Toy/Model/vertex_encoding.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Model/material.h>
 #include <Toy/Renderer/taa_settings.h>
 #include <Toy/Renderer/cascaded_shadow_defines.h>
 #include <Toy/Renderer/gbuffer_definition.h>
+#include <Toy/Renderer/spherical_harmonics.h>
 
 namespace toy
 {
     // Note: ensure material semantics must correspond one-to-one with shader semantics
-    struct ShaderSemantics
-    {
-        std::string_view constant_buffer_semantics = {};
-        std::string_view shader_resource_view_semantics = {};
-    };
-
-    static std::unordered_map<model::MaterialSemantics, ShaderSemantics> g_ms_ss_map{
-        { model::MaterialSemantics::DiffuseMap,   ShaderSemantics{ "gNoDiffuseSrv", "gAlbedoMap" } },
-        { model::MaterialSemantics::NormalMap,    ShaderSemantics{ "gNoNormalSrv", "gNormalMap" } },
-        { model::MaterialSemantics::MetalnessMap, ShaderSemantics{ "gNoMetalnessSrv", "gMetalnessMap" } },
-        { model::MaterialSemantics::RoughnessMap, ShaderSemantics{ "gNoRoughnessSrv", "gRoughnessMap" } },
+    static constexpr std::array<std::pair<model::MaterialSemantics, std::string_view>, 4> s_material_srv_semantics{
+        std::pair{ model::MaterialSemantics::DiffuseMap,   "gAlbedoMap" },
+        std::pair{ model::MaterialSemantics::NormalMap,    "gNormalMap" },
+        std::pair{ model::MaterialSemantics::MetalnessMap, "gMetalnessMap" },
+        std::pair{ model::MaterialSemantics::RoughnessMap, "gRoughnessMap" },
     };
 
     struct DeferredPBREffect::EffectImpl
@@ -37,8 +33,10 @@ namespace toy
         std::shared_ptr<IEffectPass> cur_effect_pass = nullptr;
         com_ptr<ID3D11InputLayout> cur_vertex_layout = nullptr;
         com_ptr<ID3D11InputLayout> vertex_layout = nullptr;
+        com_ptr<ID3D11InputLayout> quantized_vertex_layout = nullptr;
 
         std::string_view geometry_pass = {};
+        std::string_view geometry_quantized_pass = {};
         std::string_view deferred_lighting_csm_pass = {};
         std::string_view deferred_lighting_vsm_pass = {};
         std::string_view deferred_lighting_esm_pass = {};
@@ -53,6 +51,13 @@ namespace toy
         DirectX::XMFLOAT4X4 pre_view_proj_matrix = {};
         DirectX::XMFLOAT4X4 unjittered_view_proj_matrix = {};
 
+        uint32_t entity_id = 1;
+
+        // Dequantization of current mesh, identity for full precision mesh
+        DirectX::XMFLOAT3 position_scale = { 1.0f, 1.0f, 1.0f };
+        DirectX::XMFLOAT3 position_offset = {};
+        bool is_geometry_pass = false;
+
         int32_t viewer_width = 0;
         int32_t viewer_height = 0;
 
@@ -66,37 +71,20 @@ namespace toy
 
         ShadowType shadow_type = ShadowType::ShadowType_EVSM4;
 
-        void set_material(const model::Material &material, model::MaterialSemantics material_semantics) const
-        {
-            using namespace toy::model;
-            auto&& texture_manager = TextureManager::get();
+        // Material constant buffer and texture slots, resolved once after shaders are created
+        int32_t material_cb_slot = -1;
+        std::array<int32_t, s_material_srv_semantics.size()> material_srv_slots = {};
 
-            auto texture_map_name = material.try_get<std::string>(material_semantics_name(material_semantics));
-            auto constant_buffer_semantics = g_ms_ss_map[material_semantics].constant_buffer_semantics;
-            auto shader_resource_view_semantics = g_ms_ss_map[material_semantics].shader_resource_view_semantics;
-            if (texture_map_name)
-            {
-                effect_helper->get_constant_buffer_variable(constant_buffer_semantics)->set_uint(0);
-                effect_helper->set_shader_resource_by_name(shader_resource_view_semantics, texture_manager.get_texture(*texture_map_name));
-            } else
+        void set_material(const model::Material &material) const
+        {
+            auto&& texture_manager = model::TextureManager::get();
+            auto&& material_constants = material.get_constants();
+            effect_helper->set_constant_buffer_by_slot(static_cast<uint32_t>(material_cb_slot), &material_constants, sizeof(model::MaterialConstants));
+            for (size_t i = 0; i < s_material_srv_semantics.size(); ++i)
             {
-                effect_helper->get_constant_buffer_variable(constant_buffer_semantics)->set_uint(1);
-                effect_helper->set_shader_resource_by_name(shader_resource_view_semantics, texture_manager.get_null_texture()); // White texture
-                if (material_semantics == MaterialSemantics::DiffuseMap)
-                {
-                    // Currently do not consider opacity property
-                    auto diffuse_color = material.try_get<DirectX::XMFLOAT4>(material_semantics_name(MaterialSemantics::DiffuseColor));
-                    float base_color_opacity[4] = { diffuse_color->x, diffuse_color->y, diffuse_color->z, diffuse_color->w };
-                    effect_helper->get_constant_buffer_variable("gBaseColorOpacity")->set_float_vector(4, base_color_opacity);
-                } else if (material_semantics == MaterialSemantics::MetalnessMap)
-                {
-                    auto metalness_value = material.try_get<float>(material_semantics_name(MaterialSemantics::Metalness));
-                    effect_helper->get_constant_buffer_variable("gMetalness")->set_float(*metalness_value);
-                } else if (material_semantics == MaterialSemantics::RoughnessMap)
-                {
-                    auto roughness_value = material.try_get<float>(material_semantics_name(MaterialSemantics::Roughness));
-                    effect_helper->get_constant_buffer_variable("gRoughness")->set_float(*roughness_value);
-                }
+                // Texture handle of absent texture map is 0, which refers to white null texture
+                auto texture_handle = material.get_texture(s_material_srv_semantics[i].first);
+                effect_helper->set_shader_resource_by_slot(static_cast<uint32_t>(material_srv_slots[i]), texture_manager.get_texture(texture_handle));
             }
         }
     };
@@ -132,6 +120,7 @@ namespace toy
 
         // Set shader name and pass name
         std::string_view geometry_vs = "GeometryVS";
+        std::string_view geometry_quantized_vs = "GeometryQuantizedVS";
         std::string_view gbuffer_ps = "GBufferPS";
         std::string_view screen_triangle_vs = "ScreenTriangleVS";
         std::string_view deferred_pbr_ps0 = "DeferredPBRPS_CSM";
@@ -141,6 +130,7 @@ namespace toy
         std::string_view deferred_pbr_ps4 = "DeferredPBRPS_EVSM4";
 
         m_effect_impl->geometry_pass = "GeometryPass";
+        m_effect_impl->geometry_quantized_pass = "GeometryQuantizedPass";
         m_effect_impl->deferred_lighting_csm_pass = "DeferredLightingCSMPass";
         m_effect_impl->deferred_lighting_vsm_pass = "DeferredLightingVSMPass";
         m_effect_impl->deferred_lighting_esm_pass = "DeferredLightingESMPass";
@@ -162,7 +152,7 @@ namespace toy
         m_effect_impl->effect_helper->create_shader_from_file(gbuffer_ps, DXTOY_HOME L"data/pbr/gbuffer.hlsl", device,
                                                                 "PS", "ps_5_0");
 
-        auto&& input_layout = VertexPosNormalTangentTexEntity::get_input_layout();
+        auto&& input_layout = VertexPosNormalTangentTex::get_input_layout();
         device->CreateInputLayout(input_layout.data(), static_cast<uint32_t>(input_layout.size()), blob->GetBufferPointer(), blob->GetBufferSize(),
                                     m_effect_impl->vertex_layout.ReleaseAndGetAddressOf());
         if (!m_effect_impl->vertex_layout)
@@ -170,6 +160,21 @@ namespace toy
             DX_CORE_CRITICAL("Fail to create vertex layout");
         }
 
+        // Geometry pass variant decoding quantized vertex streams
+        std::array<D3D_SHADER_MACRO, 2> quantized_defines = {
+            D3D_SHADER_MACRO{ "QUANTIZED_VERTEX", "1" },
+            D3D_SHADER_MACRO{ nullptr, nullptr }
+        };
+        m_effect_impl->effect_helper->create_shader_from_file(geometry_quantized_vs, DXTOY_HOME L"data/pbr/geometry_vs.hlsl", device,
+                                                                "VS", "vs_5_0", quantized_defines.data(), blob.ReleaseAndGetAddressOf());
+        auto&& quantized_input_layout = VertexPosNormalTangentTexQuantized::get_input_layout();
+        device->CreateInputLayout(quantized_input_layout.data(), static_cast<uint32_t>(quantized_input_layout.size()), blob->GetBufferPointer(), blob->GetBufferSize(),
+                                    m_effect_impl->quantized_vertex_layout.ReleaseAndGetAddressOf());
+        if (!m_effect_impl->quantized_vertex_layout)
+        {
+            DX_CORE_CRITICAL("Fail to create quantized vertex layout");
+        }
+
         m_effect_impl->effect_helper->create_shader_from_file(screen_triangle_vs, DXTOY_HOME L"data/pbr/screen_triangle_vs.hlsl", device,
                                                                 "VS", "vs_5_0", nullptr, blob.ReleaseAndGetAddressOf());
         shader_defines[0].Definition = "0";
@@ -193,6 +198,9 @@ namespace toy
         pass_desc.nameVS = geometry_vs;
         pass_desc.namePS = gbuffer_ps;
         m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->geometry_pass, device, &pass_desc);
+        pass_desc.nameVS = geometry_quantized_vs;
+        pass_desc.namePS = gbuffer_ps;
+        m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->geometry_quantized_pass, device, &pass_desc);
 
         pass_desc.nameVS = screen_triangle_vs;
         pass_desc.namePS = deferred_pbr_ps0;
@@ -215,15 +223,23 @@ namespace toy
         m_effect_impl->effect_helper->set_sampler_state_by_name("gSamAnisotropicWrap", RenderStates::ss_anisotropic_wrap_16x.Get());
         m_effect_impl->effect_helper->set_sampler_state_by_name("gSamAnisotropicClamp", RenderStates::ss_anisotropic_clamp_16x.Get());
         m_effect_impl->effect_helper->set_sampler_state_by_name("gSamShadow", RenderStates::ss_shadow_pcf.Get());
+
+        // Resolve material bindings
+        m_effect_impl->material_cb_slot = m_effect_impl->effect_helper->map_constant_buffer_slot("CBMaterial");
+        for (size_t i = 0; i < s_material_srv_semantics.size(); ++i)
+        {
+            m_effect_impl->material_srv_slots[i] = m_effect_impl->effect_helper->map_shader_resource_slot(s_material_srv_semantics[i].second);
+        }
     }
 
     void DeferredPBREffect::set_material(const model::Material &material)
     {
-        using namespace toy::model;
-        m_effect_impl->set_material(material, MaterialSemantics::DiffuseMap);
-        m_effect_impl->set_material(material, MaterialSemantics::NormalMap);
-        m_effect_impl->set_material(material, MaterialSemantics::MetalnessMap);
-        m_effect_impl->set_material(material, MaterialSemantics::RoughnessMap);
+        m_effect_impl->set_material(material);
+    }
+
+    void DeferredPBREffect::set_entity_id(uint32_t entity_id)
+    {
+        m_effect_impl->entity_id = entity_id;
     }
 
     void DeferredPBREffect::set_viewer_size(int32_t width, int32_t height)
@@ -245,7 +261,23 @@ namespace toy
 
     MeshDataInput DeferredPBREffect::get_input_data(const model::MeshData &mesh_data)
     {
-        // TODO: check layout
+        // Quantized mesh needs decoding vertex shader, pass is selected here before the effect is applied
+        bool is_quantized = mesh_data.vertex_encoding == model::VertexEncoding::Quantized;
+        if (m_effect_impl->is_geometry_pass)
+        {
+            m_effect_impl->cur_effect_pass = m_effect_impl->effect_helper->get_effect_pass(
+                    is_quantized ? m_effect_impl->geometry_quantized_pass : m_effect_impl->geometry_pass);
+            m_effect_impl->cur_vertex_layout = is_quantized ? m_effect_impl->quantized_vertex_layout.Get() : m_effect_impl->vertex_layout.Get();
+        }
+        if (is_quantized)
+        {
+            model::get_position_dequantization(mesh_data.bounding_box, m_effect_impl->position_scale, m_effect_impl->position_offset);
+        } else
+        {
+            m_effect_impl->position_scale = DirectX::XMFLOAT3{ 1.0f, 1.0f, 1.0f };
+            m_effect_impl->position_offset = DirectX::XMFLOAT3{};
+        }
+
         MeshDataInput input;
         input.input_layout = m_effect_impl->cur_vertex_layout.Get();
         input.topology = m_effect_impl->topology;
@@ -253,23 +285,31 @@ namespace toy
             mesh_data.vertices.Get(),
             mesh_data.normals.Get(),
             mesh_data.tangents.Get(),
-            (mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()),
-            mesh_data.entity_id_buffer.Get()
+            (mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get())
         };
-        input.strides = { 12, 12, 16, 8, 4 };
-        input.offsets = { 0, 0, 0, 0, 0 };
+        if (is_quantized)
+        {
+            input.strides = { 8, 4, 4, 4 };
+        } else
+        {
+            input.strides = { 12, 12, 16, 8 };
+        }
+        input.offsets = { 0, 0, 0, 0 };
 
         input.index_buffer = mesh_data.indices.Get();
         input.index_count = mesh_data.index_count;
+        input.index_format = mesh_data.index_format;
 
         return input;
     }
 
     void DeferredPBREffect::set_gbuffer_render()
     {
+        m_effect_impl->effect_helper->get_effect_pass(m_effect_impl->geometry_quantized_pass)->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
         m_effect_impl->cur_effect_pass = m_effect_impl->effect_helper->get_effect_pass(m_effect_impl->geometry_pass);
         m_effect_impl->cur_effect_pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
         m_effect_impl->cur_vertex_layout = m_effect_impl->vertex_layout.Get();
+        m_effect_impl->is_geometry_pass = true;
         m_effect_impl->topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
     }
 
@@ -314,6 +354,9 @@ namespace toy
         m_effect_impl->effect_helper->get_constant_buffer_variable("gPreWorld")->set_float_matrix(4, 4, (float*)&pre_world);
         m_effect_impl->effect_helper->get_constant_buffer_variable("gPreViewProj")->set_float_matrix(4, 4, (float*)&pre_view_proj);
         m_effect_impl->effect_helper->get_constant_buffer_variable("gUnjitteredViewProj")->set_float_matrix(4, 4, (float*)&unjittered_view_proj);
+        m_effect_impl->effect_helper->get_constant_buffer_variable("gEntityId")->set_uint(m_effect_impl->entity_id);
+        m_effect_impl->effect_helper->get_constant_buffer_variable("gPositionScale")->set_float_vector(3, (const float *)&m_effect_impl->position_scale);
+        m_effect_impl->effect_helper->get_constant_buffer_variable("gPositionOffset")->set_float_vector(3, (const float *)&m_effect_impl->position_offset);
 
         if (m_effect_impl->cur_effect_pass)
         {
@@ -327,6 +370,7 @@ namespace toy
 
     void DeferredPBREffect::set_lighting_pass_render()
     {
+        m_effect_impl->is_geometry_pass = false;
         switch (m_effect_impl->shadow_type)
         {
             case ShadowType::ShadowType_CSM: m_effect_impl->cur_effect_pass = m_effect_impl->effect_helper->get_effect_pass(m_effect_impl->deferred_lighting_csm_pass); break;
@@ -358,7 +402,8 @@ namespace toy
         {
             m_effect_impl->effect_helper->get_constant_buffer_variable("gNoPreprocess")->set_uint(0);
             m_effect_impl->effect_helper->set_shader_resource_by_name("gPrefilteredSpecularMap", preprocess_effect.get_environment_srv());
-            m_effect_impl->effect_helper->set_shader_resource_by_name("gIrradianceMap", preprocess_effect.get_irradiance_srv());
+            auto irradiance_sh = get_constant_data(*preprocess_effect.get_irradiance_sh());
+            m_effect_impl->effect_helper->get_constant_buffer_variable("gIrradianceSH")->set_raw(irradiance_sh.data());
             m_effect_impl->effect_helper->set_shader_resource_by_name("gBRDFLUT", preprocess_effect.get_brdf_srv());
         } else
         {
@@ -378,7 +423,6 @@ namespace toy
         m_effect_impl->effect_helper->set_shader_resource_by_name("gGeometryNormalRoughness", nullptr);
         m_effect_impl->effect_helper->set_shader_resource_by_name("gGeometryWorldPosition", nullptr);
         m_effect_impl->effect_helper->set_shader_resource_by_name("gPrefilteredSpecularMap", nullptr);
-        m_effect_impl->effect_helper->set_shader_resource_by_name("gIrradianceMap", nullptr);
         m_effect_impl->effect_helper->set_shader_resource_by_name("gBRDFLUT", nullptr);
         m_effect_impl->cur_effect_pass->apply(device_context);
     }
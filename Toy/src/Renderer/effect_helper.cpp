@@ -4,6 +4,7 @@
 
 #include <Toy/Renderer/effect_helper.h>
 #include <Toy/Core/d3d_util.h>
+#include <Toy/Core/virtual_file_system.h>
 
 namespace toy
 {
@@ -414,6 +415,65 @@ namespace toy
         return hr;
     }
 
+    // Read shader source or byte code through virtual file system, asset pack first
+    static HRESULT read_file_to_blob(const std::filesystem::path& file_path, ID3DBlob** blob)
+    {
+        auto file = VirtualFileSystem::get().open(file_path);
+        if (!file.is_open())
+        {
+            return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+        }
+        HRESULT hr = D3DCreateBlob(file.size(), blob);
+        if (SUCCEEDED(hr))
+        {
+            std::memcpy((*blob)->GetBufferPointer(), file.data(), file.size());
+        }
+        return hr;
+    }
+
+    // Include handler of D3DCompile reading headers through virtual file system
+    // Relative includes resolve against directory of including file, as D3D_COMPILE_STANDARD_FILE_INCLUDE does
+    class VirtualFileInclude final : public ID3DInclude
+    {
+    public:
+        explicit VirtualFileInclude(const std::filesystem::path& file_path) : m_root_dir(file_path.parent_path()) {}
+
+        HRESULT __stdcall Open(D3D_INCLUDE_TYPE include_type, LPCSTR file_name, LPCVOID parent_data, LPCVOID* data, UINT* byte_width) override
+        {
+            auto parent = m_opened.find(parent_data);
+            std::filesystem::path include_path = (parent != m_opened.end() ? parent->second.directory : m_root_dir) / file_name;
+            auto file = VirtualFileSystem::get().open(include_path);
+            if (!file.is_open())
+            {
+                return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+            }
+
+            // Content is copied so that every open has its own address, the same header may be opened while still open
+            auto text = std::make_unique<char[]>(file.size() + 1);
+            std::memcpy(text.get(), file.data(), file.size());
+            *data = text.get();
+            *byte_width = static_cast<UINT>(file.size());
+            m_opened.emplace(text.get(), OpenedInclude{ std::move(text), include_path.parent_path() });
+            return S_OK;
+        }
+
+        HRESULT __stdcall Close(LPCVOID data) override
+        {
+            m_opened.erase(data);
+            return S_OK;
+        }
+
+    private:
+        struct OpenedInclude
+        {
+            std::unique_ptr<char[]> text;
+            std::filesystem::path directory;
+        };
+
+        std::filesystem::path m_root_dir;
+        std::unordered_map<LPCVOID, OpenedInclude> m_opened;
+    };
+
     // Effect helper
     effect_helper_c::effect_helper_c() : p_impl_(std::make_unique<effect_helper_c::EffectHelperImpl>())
     {
@@ -469,8 +529,7 @@ namespace toy
         if (!p_impl_->m_cache_dir.empty() && !p_impl_->m_force_write)
         {
             std::filesystem::path cacheFilename = p_impl_->m_cache_dir / (utf8_to_wstring(shader_name) + L".cso");
-            std::wstring wstr = cacheFilename.generic_wstring();
-            HRESULT hr = D3DReadFileToBlob(wstr.c_str(), &pBlobOut);
+            HRESULT hr = read_file_to_blob(cacheFilename, &pBlobOut);
             if (SUCCEEDED(hr))
             {
                 hr = add_shader(shader_name, device, pBlobOut);
@@ -488,7 +547,7 @@ namespace toy
         // 编译好的DXBC文件头
         static char dxbc_header[] = { 'D', 'X', 'B', 'C' };
 
-        HRESULT hr = D3DReadFileToBlob(file_name.data(), &pBlobIn);
+        HRESULT hr = read_file_to_blob(std::filesystem::path(file_name), &pBlobIn);
         if (FAILED(hr))
             return hr;
         if (memcmp(pBlobIn->GetBufferPointer(), dxbc_header, sizeof(dxbc_header)))
@@ -506,8 +565,9 @@ namespace toy
 #endif
             ID3DBlob* errorBlob = nullptr;
             std::string filenameu8str = wstring_to_utf8(file_name);
+            VirtualFileInclude include_handler(std::filesystem::path(file_name));
             hr = D3DCompile(pBlobIn->GetBufferPointer(), pBlobIn->GetBufferSize(), filenameu8str.c_str(),
-                            p_defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, entry_point, shader_model,
+                            p_defines, &include_handler, entry_point, shader_model,
                             dwShaderFlags, 0, &pBlobOut, &errorBlob);
             pBlobIn->Release();
 
@@ -558,8 +618,21 @@ namespace toy
         // 在Debug环境下禁用优化以避免出现一些不合理的情况
         dwShaderFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
-        return D3DCompileFromFile(filename.data(), pDefines, pInclude, entryPoint, shaderModel,
-                                    dwShaderFlags, 0, ppShaderByteCode, ppErrorBlob);
+        auto file = VirtualFileSystem::get().open(std::filesystem::path(filename));
+        if (!file.is_open())
+        {
+            return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+        }
+
+        // Standard include handler only reads loose files
+        VirtualFileInclude include_handler(std::filesystem::path(filename));
+        if (pInclude == D3D_COMPILE_STANDARD_FILE_INCLUDE)
+        {
+            pInclude = &include_handler;
+        }
+        std::string source_name = wstring_to_utf8(filename);
+        return D3DCompile(file.data(), file.size(), source_name.c_str(), pDefines, pInclude, entryPoint, shaderModel,
+                          dwShaderFlags, 0, ppShaderByteCode, ppErrorBlob);
     }
 
     HRESULT effect_helper_c::add_geometry_shader_with_stream_output(std::string_view name, ID3D11Device *device,
@@ -641,6 +714,30 @@ namespace toy
             return nullptr;
     }
 
+    void effect_helper_c::set_constant_buffer_by_slot(uint32_t slot, const void *data, uint32_t byte_width)
+    {
+        auto it = p_impl_->m_CBuffers.find(slot);
+        if (it == p_impl_->m_CBuffers.end() || !data || byte_width > it->second.cbuffer_data.size())
+            return;
+        // Only update when the data is not equal
+        if (memcmp(it->second.cbuffer_data.data(), data, byte_width))
+        {
+            memcpy_s(it->second.cbuffer_data.data(), byte_width, data, byte_width);
+            it->second.is_dirty = true;
+        }
+    }
+
+    int32_t effect_helper_c::map_constant_buffer_slot(std::string_view name)
+    {
+        auto it = std::find_if(p_impl_->m_CBuffers.begin(), p_impl_->m_CBuffers.end(),
+        [name](const std::pair<uint32_t, CBufferData>& p) {
+            return p.second.cbuffer_name == name;
+        });
+        if (it != p_impl_->m_CBuffers.end())
+            return static_cast<int32_t>(it->first);
+        return -1;
+    }
+
     void effect_helper_c::set_sampler_state_by_slot(uint32_t slot, ID3D11SamplerState *sampler_state)
     {
         auto it = p_impl_->m_Samplers.find(slot);
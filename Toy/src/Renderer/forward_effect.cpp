@@ -7,6 +7,7 @@
 #include <Toy/Core/d3d_util.h>
 #include <Toy/Geometry/vertex.h>
 #include <Toy/Model/mesh_data.h>
+#include <Toy/Model/vertex_encoding.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Model/material.h>
 
@@ -21,8 +22,17 @@ namespace toy
         std::shared_ptr<IEffectPass> m_cur_effect_pass;
         com_ptr<ID3D11InputLayout> m_cur_input_layout;
         com_ptr<ID3D11InputLayout> m_vertex_pos_normal_tex_layout;
+        com_ptr<ID3D11InputLayout> m_quantized_vertex_layout;
         D3D11_PRIMITIVE_TOPOLOGY  m_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
 
+        // Current geometry pass and its variant for quantized vertex streams, selected per mesh
+        std::string_view m_geometry_pass = {};
+        std::string_view m_geometry_quantized_pass = {};
+
+        // Dequantization of current mesh, identity for full precision mesh
+        DirectX::XMFLOAT3 m_position_scale = { 1.0f, 1.0f, 1.0f };
+        DirectX::XMFLOAT3 m_position_offset = {};
+
         DirectX::XMFLOAT4X4 m_world{};
         DirectX::XMFLOAT4X4 m_view{};
         DirectX::XMFLOAT4X4 m_proj{};
@@ -71,37 +81,42 @@ namespace toy
         device->CreateInputLayout(input_layout.data(), (uint32_t)input_layout.size(), blob->GetBufferPointer(),
                                     blob->GetBufferSize(), m_effect_impl->m_vertex_pos_normal_tex_layout.ReleaseAndGetAddressOf());
 
+        // Vertex shader variant decoding quantized vertex streams
+        D3D_SHADER_MACRO quantized_defines[] = {
+            {"QUANTIZED_VERTEX", "1"},
+            {nullptr, nullptr}
+        };
+        m_effect_impl->m_effect_helper->create_shader_from_file("GeometryQuantizedVS", L"../data/defer/forward.hlsl", device,
+                                                                "GeometryVS", "vs_5_0", quantized_defines, blob.ReleaseAndGetAddressOf());
+        auto&& quantized_input_layout = VertexPosNormalTangentTexQuantized::get_input_layout();
+        device->CreateInputLayout(quantized_input_layout.data(), (uint32_t)quantized_input_layout.size(), blob->GetBufferPointer(),
+                                    blob->GetBufferSize(), m_effect_impl->m_quantized_vertex_layout.ReleaseAndGetAddressOf());
+
         // Create pixel shader
         m_effect_impl->m_effect_helper->create_shader_from_file("ForwardPS", L"../data/defer/forward.hlsl", device,
                                                                 "ForwardPS", "ps_5_0");
         m_effect_impl->m_effect_helper->create_shader_from_file("ForwardPlusPS", L"../data/defer/forward.hlsl", device,
                                                                 "ForwardPlusPS", "ps_5_0");
 
-        // Create pass
+        // Create passes, each with a variant for quantized vertex streams
         EffectPassDesc pass_desc{};
-        pass_desc.nameVS = "GeometryVS";
-        pass_desc.namePS = "ForwardPS";
-        m_effect_impl->m_effect_helper->add_effect_pass("Forward", device, &pass_desc);
-        {
-            auto pass = m_effect_impl->m_effect_helper->get_effect_pass("Forward");
-            // Reverse Z => GREATER_EQUAL
-            pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
-        }
-
-        pass_desc.namePS = "ForwardPlusPS";
-        m_effect_impl->m_effect_helper->add_effect_pass("ForwardPlus", device, &pass_desc);
-        {
-            auto pass = m_effect_impl->m_effect_helper->get_effect_pass("ForwardPlus");
-            // Reverse Z => GREATER_EQUAL
-            pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
-        }
-
-        pass_desc.namePS = "";
-        m_effect_impl->m_effect_helper->add_effect_pass("PreZ", device, &pass_desc);
+        std::array<std::pair<std::string_view, std::string_view>, 3> geometry_passes = {
+            std::pair{ "Forward", "ForwardPS" },
+            std::pair{ "ForwardPlus", "ForwardPlusPS" },
+            std::pair{ "PreZ", "" }
+        };
+        for (auto&& [pass_name, ps_name] : geometry_passes)
         {
-            auto pass = m_effect_impl->m_effect_helper->get_effect_pass("PreZ");
-            // Reverse Z => GREATER_EQUAL
-            pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
+            pass_desc.namePS = ps_name;
+            for (bool is_quantized : { false, true })
+            {
+                std::string name = std::string(pass_name) + (is_quantized ? "Quantized" : "");
+                pass_desc.nameVS = is_quantized ? "GeometryQuantizedVS" : "GeometryVS";
+                m_effect_impl->m_effect_helper->add_effect_pass(name, device, &pass_desc);
+                auto pass = m_effect_impl->m_effect_helper->get_effect_pass(name);
+                // Reverse Z => GREATER_EQUAL
+                pass->set_depth_stencil_state(RenderStates::dss_greater_equal.Get(), 0);
+            }
         }
 
         m_effect_impl->m_effect_helper->set_sampler_state_by_name("g_Sam", RenderStates::ss_anisotropic_wrap_16x.Get());
@@ -165,6 +180,8 @@ namespace toy
 
     void ForwardEffect::set_pre_z_pass_render()
     {
+        m_effect_impl->m_geometry_pass = "PreZ";
+        m_effect_impl->m_geometry_quantized_pass = "PreZQuantized";
         m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass("PreZ");
         m_effect_impl->m_cur_input_layout = m_effect_impl->m_vertex_pos_normal_tex_layout.Get();
         m_effect_impl->m_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -172,6 +189,8 @@ namespace toy
 
     void ForwardEffect::set_default_render()
     {
+        m_effect_impl->m_geometry_pass = "Forward";
+        m_effect_impl->m_geometry_quantized_pass = "ForwardQuantized";
         m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass("Forward");
         m_effect_impl->m_cur_input_layout = m_effect_impl->m_vertex_pos_normal_tex_layout.Get();
         m_effect_impl->m_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -212,6 +231,8 @@ namespace toy
 
     void ForwardEffect::set_tiled_light_culling_render()
     {
+        m_effect_impl->m_geometry_pass = "ForwardPlus";
+        m_effect_impl->m_geometry_quantized_pass = "ForwardPlusQuantized";
         m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass("ForwardPlus");
         m_effect_impl->m_cur_input_layout = m_effect_impl->m_vertex_pos_normal_tex_layout.Get();
         m_effect_impl->m_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -236,26 +257,50 @@ namespace toy
     {
         auto&& texture_manager = model::TextureManager::get();
 
-        auto texture_id_str = material.try_get<std::string>("$Diffuse");
+        auto texture_id_str = material.try_get<std::string>("$Diffuse"_xid);
         m_effect_impl->m_effect_helper->set_shader_resource_by_name("g_DiffuseMap",
                                                                     texture_id_str ? texture_manager.get_texture(*texture_id_str) : texture_manager.get_null_texture());
     }
 
     MeshDataInput ForwardEffect::get_input_data(const model::MeshData &mesh_data)
     {
+        // Quantized mesh needs decoding vertex shader, pass is selected here before the effect is applied
+        bool is_quantized = mesh_data.vertex_encoding == model::VertexEncoding::Quantized;
+        if (!m_effect_impl->m_geometry_pass.empty())
+        {
+            m_effect_impl->m_cur_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(
+                    is_quantized ? m_effect_impl->m_geometry_quantized_pass : m_effect_impl->m_geometry_pass);
+            m_effect_impl->m_cur_input_layout = is_quantized ? m_effect_impl->m_quantized_vertex_layout.Get() : m_effect_impl->m_vertex_pos_normal_tex_layout.Get();
+        }
+        if (is_quantized)
+        {
+            model::get_position_dequantization(mesh_data.bounding_box, m_effect_impl->m_position_scale, m_effect_impl->m_position_offset);
+        } else
+        {
+            m_effect_impl->m_position_scale = DirectX::XMFLOAT3{ 1.0f, 1.0f, 1.0f };
+            m_effect_impl->m_position_offset = DirectX::XMFLOAT3{};
+        }
+
         MeshDataInput input;
         input.input_layout = m_effect_impl->m_cur_input_layout.Get();
         input.topology = m_effect_impl->m_topology;
-        input.vertex_buffers = {
-            mesh_data.vertices.Get(),
-            mesh_data.normals.Get(),
-            mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
-        };
-        input.strides = { 12, 12, 8 };
-        input.offsets = { 0, 0, 0 };
+        auto texcoord = mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get();
+        if (is_quantized)
+        {
+            // Quantized layout reads tangent stream at slot 2
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), mesh_data.tangents.Get(), texcoord };
+            input.strides = { 8, 4, 4, 4 };
+            input.offsets = { 0, 0, 0, 0 };
+        } else
+        {
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), texcoord };
+            input.strides = { 12, 12, 8 };
+            input.offsets = { 0, 0, 0 };
+        }
 
         input.index_buffer = mesh_data.indices.Get();
         input.index_count = mesh_data.index_count;
+        input.index_format = mesh_data.index_format;
 
         return input;
     }
@@ -283,6 +328,8 @@ namespace toy
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_WorldView")->set_float_matrix(4, 4, (float*)&world_view);
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_ViewProj")->set_float_matrix(4, 4, (float*)&view_proj);
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_Proj")->set_float_matrix(4, 4, (float*)&proj);
+        m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_PositionScale")->set_float_vector(3, (const float*)&m_effect_impl->m_position_scale);
+        m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_PositionOffset")->set_float_vector(3, (const float*)&m_effect_impl->m_position_offset);
 
         if (m_effect_impl->m_cur_effect_pass)
         {
@@ -0,0 +1,516 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#include <Toy/Renderer/ibl_cache.h>
+#include <Toy/Model/dds_file.h>
+#include <Toy/Model/mip_generator.h>
+#include <Toy/Core/parallel.h>
+
+namespace toy
+{
+    // Constants of the compute shaders under data/pbr, CPU results follow them exactly
+    static constexpr float s_pi = 3.141592f;
+    static constexpr uint32_t s_sp_env_sample_count = 1024;
+    static constexpr uint32_t s_irradiance_sample_count = 64 * 1024;
+    static constexpr uint32_t s_brdf_sample_count = 1024;
+
+    IblTexture::IblTexture(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t mip_count, uint32_t array_size)
+    : format(format), width(width), height(height), mip_count(mip_count), array_size(array_size)
+    {
+        size_t byte_width = 0;
+        for (uint32_t mip = 0; mip < mip_count; ++mip)
+        {
+            byte_width += static_cast<size_t>(get_row_pitch(mip)) * get_mip_height(mip);
+        }
+        data.resize(byte_width * array_size);
+    }
+
+    uint32_t IblTexture::get_texel_byte_width() const
+    {
+        return format == DXGI_FORMAT_R16G16_FLOAT ? 4 : 8;
+    }
+
+    static size_t get_subresource_offset(const IblTexture& texture, uint32_t mip, uint32_t slice)
+    {
+        size_t chain_byte_width = 0;
+        size_t mip_offset = 0;
+        for (uint32_t level = 0; level < texture.mip_count; ++level)
+        {
+            if (level == mip)
+            {
+                mip_offset = chain_byte_width;
+            }
+            chain_byte_width += static_cast<size_t>(texture.get_row_pitch(level)) * texture.get_mip_height(level);
+        }
+        return chain_byte_width * slice + mip_offset;
+    }
+
+    std::span<uint8_t> IblTexture::get_subresource(uint32_t mip, uint32_t slice)
+    {
+        size_t byte_width = static_cast<size_t>(get_row_pitch(mip)) * get_mip_height(mip);
+        return std::span<uint8_t>(data).subspan(get_subresource_offset(*this, mip, slice), byte_width);
+    }
+
+    std::span<const uint8_t> IblTexture::get_subresource(uint32_t mip, uint32_t slice) const
+    {
+        size_t byte_width = static_cast<size_t>(get_row_pitch(mip)) * get_mip_height(mip);
+        return std::span<const uint8_t>(data).subspan(get_subresource_offset(*this, mip, slice), byte_width);
+    }
+
+    bool IblTexture::matches(DXGI_FORMAT expected_format, uint32_t size, uint32_t expected_mip_count, uint32_t expected_array_size) const
+    {
+        return format == expected_format && width == size && height == size && mip_count == expected_mip_count &&
+               array_size == expected_array_size && data.size() == get_subresource_offset(*this, 0, array_size);
+    }
+
+    XID ibl_cache_key(XID content_key)
+    {
+        return hash::combine(content_key, ibl_cache_version);
+    }
+
+    std::filesystem::path ibl_environment_cache_path(XID key)
+    {
+        return std::filesystem::path(DXTOY_HOME "data/cache/ibl") / fmt::format("{:016x}_environment.dds", key);
+    }
+
+    std::filesystem::path ibl_brdf_lut_cache_path()
+    {
+        return std::filesystem::path(DXTOY_HOME "data/cache/ibl") / fmt::format("brdf_lut_v{}.dds", ibl_cache_version);
+    }
+
+    std::optional<IblTexture> load_ibl_cache(const std::filesystem::path& cache_path)
+    {
+        auto dds_file = model::read_dds_file(cache_path);
+        if (!dds_file)
+        {
+            return std::nullopt;
+        }
+
+        auto&& desc = dds_file->desc;
+        if (desc.format != DXGI_FORMAT_R16G16B16A16_FLOAT && desc.format != DXGI_FORMAT_R16G16_FLOAT)
+        {
+            DX_CORE_WARN("IBL cache {} has unexpected format", cache_path.string());
+            return std::nullopt;
+        }
+        IblTexture texture{ desc.format, desc.width, desc.height, desc.mip_count, desc.array_size };
+        if (texture.data.size() != dds_file->data.size())
+        {
+            DX_CORE_WARN("IBL cache {} does not match its header", cache_path.string());
+            return std::nullopt;
+        }
+        texture.data = std::move(dds_file->data);
+        return texture;
+    }
+
+    bool save_ibl_cache(const std::filesystem::path& cache_path, const IblTexture& texture)
+    {
+        model::DdsDesc desc{};
+        desc.format = texture.format;
+        desc.width = texture.width;
+        desc.height = texture.height;
+        desc.mip_count = texture.mip_count;
+        desc.array_size = texture.array_size;
+        desc.is_cube = texture.array_size == 6;
+        desc.pitch_or_linear_size = texture.get_row_pitch(0);
+        return model::write_dds_file(cache_path, desc, texture.data);
+    }
+
+    // Hammersley point i of count, see radicalInverse_VdC
+    static DirectX::XMFLOAT2 sample_hammersley(uint32_t i, uint32_t count)
+    {
+        uint32_t bits = i;
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return { static_cast<float>(i) / static_cast<float>(count), static_cast<float>(bits) * 2.3283064365386963e-10f };
+    }
+
+    // GGX importance sampled half vector in tangent space
+    static DirectX::XMFLOAT3 sample_ggx(float u1, float u2, float roughness)
+    {
+        float alpha = roughness * roughness;
+        float cos_theta = std::sqrt((1.0f - u2) / (1.0f + (alpha * alpha - 1.0f) * u2));
+        float sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+        float phi = 2.0f * s_pi * u1;
+        return { sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta };
+    }
+
+    static float ndf_ggx(float cos_lh, float roughness)
+    {
+        float alpha = roughness * roughness;
+        float alpha_sq = alpha * alpha;
+        float denom = (cos_lh * cos_lh) * (alpha_sq - 1.0f) + 1.0f;
+        return alpha_sq / (s_pi * denom * denom);
+    }
+
+    // Direction of cube texel, the shaders use texel corner rather than center, kept for identical results
+    static DirectX::XMVECTOR get_sampling_vector(uint32_t face, uint32_t x, uint32_t y, uint32_t size)
+    {
+        using namespace DirectX;
+        float u = 2.0f * static_cast<float>(x) / static_cast<float>(size) - 1.0f;
+        float v = 2.0f * (1.0f - static_cast<float>(y) / static_cast<float>(size)) - 1.0f;
+        switch (face)
+        {
+            case 0: return XMVector3Normalize(XMVectorSet(1.0f, v, -u, 0.0f));
+            case 1: return XMVector3Normalize(XMVectorSet(-1.0f, v, u, 0.0f));
+            case 2: return XMVector3Normalize(XMVectorSet(u, 1.0f, -v, 0.0f));
+            case 3: return XMVector3Normalize(XMVectorSet(u, -1.0f, v, 0.0f));
+            case 4: return XMVector3Normalize(XMVectorSet(u, v, 1.0f, 0.0f));
+            default: return XMVector3Normalize(XMVectorSet(-u, v, -1.0f, 0.0f));
+        }
+    }
+
+    // Tangent frame of normal, see computeBasisVectors
+    static void compute_basis_vectors(DirectX::FXMVECTOR n, DirectX::XMVECTOR& s, DirectX::XMVECTOR& t)
+    {
+        using namespace DirectX;
+        t = XMVector3Cross(n, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        if (XMVectorGetX(XMVector3Dot(t, t)) < 0.00001f)
+        {
+            t = XMVector3Cross(n, XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f));
+        }
+        t = XMVector3Normalize(t);
+        s = XMVector3Normalize(XMVector3Cross(n, t));
+    }
+
+    // Bilinear, wrapped in both directions like the sampler of equirect_to_cube.hlsl
+    static DirectX::XMVECTOR sample_equirect(const model::HdrImage& image, float u, float v)
+    {
+        using namespace DirectX;
+        using namespace DirectX::PackedVector;
+        auto load_texel = [&image](int32_t x, int32_t y)
+        {
+            auto width = static_cast<int32_t>(image.width);
+            auto height = static_cast<int32_t>(image.height);
+            size_t index = static_cast<size_t>((y % height + height) % height) * image.width + static_cast<size_t>((x % width + width) % width);
+            if (image.format == model::HdrFormat::RGBA16F)
+            {
+                return XMLoadHalf4(reinterpret_cast<const XMHALF4*>(image.pixels.data()) + index);
+            }
+            return XMLoadFloat3SE(reinterpret_cast<const XMFLOAT3SE*>(image.pixels.data()) + index);
+        };
+
+        float x = u * static_cast<float>(image.width) - 0.5f;
+        float y = v * static_cast<float>(image.height) - 0.5f;
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        auto ix = static_cast<int32_t>(x0);
+        auto iy = static_cast<int32_t>(y0);
+        XMVECTOR top = XMVectorLerp(load_texel(ix, iy), load_texel(ix + 1, iy), x - x0);
+        XMVECTOR bottom = XMVectorLerp(load_texel(ix, iy + 1), load_texel(ix + 1, iy + 1), x - x0);
+        return XMVectorLerp(top, bottom, y - y0);
+    }
+
+    // Float cube with 2 x 2 box filtered mips, as GenerateMips produces
+    struct FloatCube
+    {
+        uint32_t size = 0;
+        std::array<std::vector<model::ImageMip>, 6> faces;
+    };
+
+    // Bilinear within face, texels are clamped at face edge rather than filtered across faces
+    static DirectX::XMVECTOR sample_face(const model::ImageMip& mip, float u, float v)
+    {
+        using namespace DirectX;
+        auto texels = reinterpret_cast<const XMFLOAT4*>(mip.pixels.data());
+        auto max_x = static_cast<int32_t>(mip.width) - 1;
+        auto max_y = static_cast<int32_t>(mip.height) - 1;
+        float x = u * static_cast<float>(mip.width) - 0.5f;
+        float y = v * static_cast<float>(mip.height) - 0.5f;
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        auto load_texel = [texels, &mip, max_x, max_y](int32_t tx, int32_t ty)
+        {
+            return XMLoadFloat4(texels + static_cast<size_t>(std::clamp(ty, 0, max_y)) * mip.width + std::clamp(tx, 0, max_x));
+        };
+
+        auto ix = static_cast<int32_t>(x0);
+        auto iy = static_cast<int32_t>(y0);
+        XMVECTOR top = XMVectorLerp(load_texel(ix, iy), load_texel(ix + 1, iy), x - x0);
+        XMVECTOR bottom = XMVectorLerp(load_texel(ix, iy + 1), load_texel(ix + 1, iy + 1), x - x0);
+        return XMVectorLerp(top, bottom, y - y0);
+    }
+
+    // Trilinear sample in direction, faces are selected as Direct3D does
+    static DirectX::XMVECTOR sample_cube(const FloatCube& cube, DirectX::FXMVECTOR direction, float level)
+    {
+        using namespace DirectX;
+        XMFLOAT3 d{};
+        XMStoreFloat3(&d, direction);
+        float ax = std::abs(d.x);
+        float ay = std::abs(d.y);
+        float az = std::abs(d.z);
+
+        uint32_t face = 0;
+        float sc = 0.0f, tc = 0.0f, ma = 0.0f;
+        if (ax >= ay && ax >= az)
+        {
+            face = d.x >= 0.0f ? 0 : 1;
+            sc = d.x >= 0.0f ? -d.z : d.z;
+            tc = -d.y;
+            ma = ax;
+        } else if (ay >= az)
+        {
+            face = d.y >= 0.0f ? 2 : 3;
+            sc = d.x;
+            tc = d.y >= 0.0f ? d.z : -d.z;
+            ma = ay;
+        } else
+        {
+            face = d.z >= 0.0f ? 4 : 5;
+            sc = d.z >= 0.0f ? d.x : -d.x;
+            tc = -d.y;
+            ma = az;
+        }
+        float u = 0.5f * (sc / ma + 1.0f);
+        float v = 0.5f * (tc / ma + 1.0f);
+
+        auto&& mips = cube.faces[face];
+        level = std::clamp(level, 0.0f, static_cast<float>(mips.size() - 1));
+        auto mip = static_cast<uint32_t>(level);
+        float weight = level - static_cast<float>(mip);
+        XMVECTOR color = sample_face(mips[mip], u, v);
+        if (weight > 0.0f && mip + 1 < mips.size())
+        {
+            color = XMVectorLerp(color, sample_face(mips[mip + 1], u, v), weight);
+        }
+        return color;
+    }
+
+    // Run func(face, y) for every row of a cube of size on worker threads
+    template <typename Func>
+    static void for_each_cube_row(uint32_t size, Func&& func)
+    {
+        parallel_for(static_cast<size_t>(size) * 6, [size, &func](size_t row)
+        {
+            func(static_cast<uint32_t>(row / size), static_cast<uint32_t>(row % size));
+        });
+    }
+
+    static void store_texel(std::span<uint8_t> subresource, size_t index, DirectX::FXMVECTOR color)
+    {
+        using namespace DirectX;
+        PackedVector::XMStoreHalf4(reinterpret_cast<PackedVector::XMHALF4*>(subresource.data()) + index,
+                                   XMVectorSetW(color, 1.0f));
+    }
+
+    IblMaps bake_ibl_maps(const model::HdrImage& equirect_image, uint32_t environment_size, uint32_t irradiance_size)
+    {
+        using namespace DirectX;
+
+        // Equirectangular image to cube, see equirect_to_cube.hlsl
+        FloatCube cube{};
+        cube.size = environment_size;
+        std::array<std::vector<XMFLOAT4>, 6> face_pixels{};
+        for (auto&& pixels : face_pixels)
+        {
+            pixels.resize(static_cast<size_t>(environment_size) * environment_size);
+        }
+        for_each_cube_row(environment_size, [&](uint32_t face, uint32_t y)
+        {
+            for (uint32_t x = 0; x < environment_size; ++x)
+            {
+                XMFLOAT3 v{};
+                XMStoreFloat3(&v, get_sampling_vector(face, x, y, environment_size));
+                float phi = std::atan2(v.z, v.x);
+                float theta = std::acos(std::clamp(v.y, -1.0f, 1.0f));
+                XMVECTOR color = sample_equirect(equirect_image, phi / (2.0f * s_pi), theta / s_pi);
+                XMStoreFloat4(&face_pixels[face][static_cast<size_t>(y) * environment_size + x], color);
+            }
+        });
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            cube.faces[face] = model::generate_mip_chain(reinterpret_cast<const uint8_t*>(face_pixels[face].data()), environment_size,
+                                                         environment_size, model::MipOptions{ model::MipFormat::RGBA32F, model::MipFilter::Box });
+            face_pixels[face] = {};
+        }
+
+        // Pre-filtered specular environment, mip 0 is the cube itself, see sp_env_map.hlsl
+        uint32_t mip_count = model::get_mip_count(environment_size, environment_size);
+        IblMaps maps{};
+        maps.environment = IblTexture{ DXGI_FORMAT_R16G16B16A16_FLOAT, environment_size, environment_size, mip_count, 6 };
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            auto subresource = maps.environment.get_subresource(0, face);
+            auto texels = reinterpret_cast<const XMFLOAT4*>(cube.faces[face][0].pixels.data());
+            for (size_t i = 0; i < static_cast<size_t>(environment_size) * environment_size; ++i)
+            {
+                store_texel(subresource, i, XMLoadFloat4(texels + i));
+            }
+        }
+
+        // Samples of a level are the same for every texel, so incident direction, its weight and source mip are
+        // computed once in tangent space, where normal and view direction are +Z
+        struct SpecularSample
+        {
+            XMFLOAT3 direction;
+            float cos_li;
+            float level;
+        };
+        float texel_solid_angle = 4.0f * s_pi / (6.0f * static_cast<float>(environment_size) * static_cast<float>(environment_size));
+        const float delta_roughness = 1.0f / std::max(static_cast<float>(mip_count - 1), 1.0f);
+        std::vector<SpecularSample> specular_samples{};
+        for (uint32_t mip = 1; mip < mip_count; ++mip)
+        {
+            float roughness = static_cast<float>(mip) * delta_roughness;
+            specular_samples.clear();
+            for (uint32_t i = 0; i < s_sp_env_sample_count; ++i)
+            {
+                auto u = sample_hammersley(i, s_sp_env_sample_count);
+                auto lh = sample_ggx(u.x, u.y, roughness);
+                XMFLOAT3 li{ 2.0f * lh.z * lh.x, 2.0f * lh.z * lh.y, 2.0f * lh.z * lh.z - 1.0f };
+                if (li.z > 0.0f)
+                {
+                    float pdf = ndf_ggx(std::max(lh.z, 0.0f), roughness) * 0.25f;
+                    float sample_solid_angle = 1.0f / (static_cast<float>(s_sp_env_sample_count) * pdf);
+                    float level = std::max(0.5f * std::log2(sample_solid_angle / texel_solid_angle) + 1.0f, 0.0f);
+                    specular_samples.push_back(SpecularSample{ li, li.z, level });
+                }
+            }
+
+            uint32_t size = maps.environment.get_mip_width(mip);
+            for_each_cube_row(size, [&](uint32_t face, uint32_t y)
+            {
+                auto subresource = maps.environment.get_subresource(mip, face);
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    XMVECTOR n = get_sampling_vector(face, x, y, size);
+                    XMVECTOR s{}, t{};
+                    compute_basis_vectors(n, s, t);
+
+                    XMVECTOR color = XMVectorZero();
+                    float weight = 0.0f;
+                    for (auto&& sample : specular_samples)
+                    {
+                        XMVECTOR li = XMVectorMultiplyAdd(s, XMVectorReplicate(sample.direction.x),
+                                      XMVectorMultiplyAdd(t, XMVectorReplicate(sample.direction.y),
+                                                          XMVectorScale(n, sample.direction.z)));
+                        color = XMVectorMultiplyAdd(sample_cube(cube, li, sample.level), XMVectorReplicate(sample.cos_li), color);
+                        weight += sample.cos_li;
+                    }
+                    store_texel(subresource, static_cast<size_t>(y) * size + x, XMVectorScale(color, 1.0f / weight));
+                }
+            });
+        }
+
+        // Diffuse irradiance from mip 0 of environment, cosine weighted hemisphere samples around each texel direction
+        if (irradiance_size == 0)
+        {
+            return maps;
+        }
+        std::vector<XMFLOAT3> hemisphere_samples(s_irradiance_sample_count);
+        for (uint32_t i = 0; i < s_irradiance_sample_count; ++i)
+        {
+            auto u = sample_hammersley(i, s_irradiance_sample_count);
+            float u1p = std::sqrt(std::max(0.0f, 1.0f - u.x * u.x));
+            hemisphere_samples[i] = XMFLOAT3{ std::cos(2.0f * s_pi * u.y) * u1p, std::sin(2.0f * s_pi * u.y) * u1p, u.x };
+        }
+
+        maps.irradiance = IblTexture{ DXGI_FORMAT_R16G16B16A16_FLOAT, irradiance_size, irradiance_size, 1, 6 };
+        for_each_cube_row(irradiance_size, [&](uint32_t face, uint32_t y)
+        {
+            auto subresource = maps.irradiance.get_subresource(0, face);
+            for (uint32_t x = 0; x < irradiance_size; ++x)
+            {
+                XMVECTOR n = get_sampling_vector(face, x, y, irradiance_size);
+                XMVECTOR s{}, t{};
+                compute_basis_vectors(n, s, t);
+
+                XMVECTOR irradiance = XMVectorZero();
+                for (auto&& sample : hemisphere_samples)
+                {
+                    XMVECTOR li = XMVectorMultiplyAdd(s, XMVectorReplicate(sample.x),
+                                  XMVectorMultiplyAdd(t, XMVectorReplicate(sample.y), XMVectorScale(n, sample.z)));
+                    irradiance = XMVectorMultiplyAdd(sample_cube(cube, li, 0.0f), XMVectorReplicate(2.0f * sample.z), irradiance);
+                }
+                store_texel(subresource, static_cast<size_t>(y) * irradiance_size + x,
+                            XMVectorScale(irradiance, 1.0f / static_cast<float>(s_irradiance_sample_count)));
+            }
+        });
+        return maps;
+    }
+
+    // Separable Schlick-GGX with Epic's IBL remapping, see gaSchlickGGX_IBL
+    static float ga_schlick_ggx_ibl(float cos_li, float cos_lo, float roughness)
+    {
+        float k = roughness * roughness / 2.0f;
+        return cos_li / (cos_li * (1.0f - k) + k) * (cos_lo / (cos_lo * (1.0f - k) + k));
+    }
+
+    IblTexture bake_brdf_lut(uint32_t size)
+    {
+        using namespace DirectX;
+
+        // Split-sum DFG terms over view angle and roughness, see sp_brdf.hlsl
+        IblTexture lut{ DXGI_FORMAT_R16G16_FLOAT, size, size, 1, 1 };
+        auto texels = reinterpret_cast<PackedVector::XMHALF2*>(lut.data.data());
+        parallel_for(size, [size, texels](size_t y)
+        {
+            float roughness = static_cast<float>(y) / static_cast<float>(size);
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                float cos_lo = std::max(static_cast<float>(x) / static_cast<float>(size), 0.001f);
+                XMFLOAT3 lo{ std::sqrt(1.0f - cos_lo * cos_lo), 0.0f, cos_lo };
+
+                float dfg1 = 0.0f;
+                float dfg2 = 0.0f;
+                for (uint32_t i = 0; i < s_brdf_sample_count; ++i)
+                {
+                    auto u = sample_hammersley(i, s_brdf_sample_count);
+                    auto lh = sample_ggx(u.x, u.y, roughness);
+                    float lo_dot_lh = lo.x * lh.x + lo.y * lh.y + lo.z * lh.z;
+                    float cos_li = 2.0f * lo_dot_lh * lh.z - lo.z;
+                    float cos_lo_lh = std::max(lo_dot_lh, 0.0f);
+                    if (cos_li > 0.0f)
+                    {
+                        float g = ga_schlick_ggx_ibl(cos_li, cos_lo, roughness);
+                        float gv = g * cos_lo_lh / (lh.z * cos_lo);
+                        float fc = std::pow(1.0f - cos_lo_lh, 5.0f);
+                        dfg1 += (1.0f - fc) * gv;
+                        dfg2 += fc * gv;
+                    }
+                }
+                float inv_sample_count = 1.0f / static_cast<float>(s_brdf_sample_count);
+                PackedVector::XMStoreHalf2(texels + y * size + x, XMVectorSet(dfg1 * inv_sample_count, dfg2 * inv_sample_count, 0.0f, 0.0f));
+            }
+        });
+        return lut;
+    }
+
+    bool bake_ibl_cache(std::string_view file_path)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        XID content_key = file_content_to_id(file_path);
+        if (content_key == 0)
+        {
+            DX_CORE_WARN("Fail to read HDR image {}", file_path);
+            return false;
+        }
+
+        // Cache files are written atomically, so existing ones are complete
+        auto environment_path = ibl_environment_cache_path(ibl_cache_key(content_key));
+        if (!std::filesystem::exists(environment_path))
+        {
+            // Same texel format as the HDR texture GPU passes sample
+            auto image = model::load_hdr_image(std::filesystem::path(file_path), model::HdrFormat::RGB9E5);
+            if (!image)
+            {
+                DX_CORE_WARN("Fail to decode HDR image {}", file_path);
+                return false;
+            }
+            save_ibl_cache(environment_path, bake_ibl_maps(*image).environment);
+        }
+
+        if (!std::filesystem::exists(ibl_brdf_lut_cache_path()))
+        {
+            save_ibl_cache(ibl_brdf_lut_cache_path(), bake_brdf_lut());
+        }
+
+        std::chrono::duration<double, std::milli> bake_time = std::chrono::steady_clock::now() - start_time;
+        DX_CORE_INFO("Bake IBL cache of {} on CPU: {:.1f} ms", file_path, bake_time.count());
+        return true;
+    }
+}
@@ -6,6 +6,7 @@
 #include <Toy/Renderer/render_states.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Renderer/texture_2d.h>
+#include <Toy/Renderer/spherical_harmonics.h>
 
 namespace toy
 {
@@ -16,17 +17,89 @@ namespace toy
 
         std::unique_ptr<TextureCube> cube_texture = nullptr;
         std::unique_ptr<TextureCube> env_texture = nullptr;
-        std::unique_ptr<TextureCube> ir_map_texture = nullptr;
         std::unique_ptr<Texture2D> sp_brdf_texture = nullptr;
+        std::optional<IrradianceSH> irradiance_sh = std::nullopt;
 
         std::unique_ptr<EffectHelper> effect_helper = nullptr;
 
         std::string_view equirect_to_cube_pass = {};
         std::string_view sp_env_map_pass = {};
-        std::string_view ir_map_pass = {};
         std::string_view brdf_lut_pass = {};
+
+        // Maps are created once with what compute passes need, cache loads fill the same textures
+        void create_env_texture(ID3D11Device *device)
+        {
+            if (!env_texture)
+            {
+                env_texture = std::make_unique<TextureCube>(device, ibl_environment_size, ibl_environment_size, DXGI_FORMAT_R16G16B16A16_FLOAT, 0,
+                                                            D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
+            }
+        }
+
+        void create_brdf_texture(ID3D11Device *device)
+        {
+            if (!sp_brdf_texture)
+            {
+                sp_brdf_texture = std::make_unique<Texture2D>(device, ibl_brdf_lut_size, ibl_brdf_lut_size, DXGI_FORMAT_R16G16_FLOAT, 1,
+                                                              D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
+                create_texture_uav(device, sp_brdf_texture.get(), 0);
+            }
+        }
     };
 
+    // Copy every subresource of texture to CPU through a staging texture, waits for GPU work writing it
+    static std::optional<IblTexture> read_back_texture(ID3D11Device *device, ID3D11DeviceContext *device_context, ID3D11Texture2D *texture)
+    {
+        D3D11_TEXTURE2D_DESC tex_desc{};
+        texture->GetDesc(&tex_desc);
+        IblTexture result{ tex_desc.Format, tex_desc.Width, tex_desc.Height, tex_desc.MipLevels, tex_desc.ArraySize };
+
+        tex_desc.Usage = D3D11_USAGE_STAGING;
+        tex_desc.BindFlags = 0;
+        tex_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        tex_desc.MiscFlags &= D3D11_RESOURCE_MISC_TEXTURECUBE;
+        com_ptr<ID3D11Texture2D> staging_texture = nullptr;
+        if (FAILED(device->CreateTexture2D(&tex_desc, nullptr, staging_texture.GetAddressOf())))
+        {
+            return std::nullopt;
+        }
+        device_context->CopyResource(staging_texture.Get(), texture);
+
+        for (uint32_t slice = 0; slice < result.array_size; ++slice)
+        {
+            for (uint32_t mip = 0; mip < result.mip_count; ++mip)
+            {
+                D3D11_MAPPED_SUBRESOURCE mapped_data{};
+                uint32_t subresource = D3D11CalcSubresource(mip, slice, result.mip_count);
+                if (FAILED(device_context->Map(staging_texture.Get(), subresource, D3D11_MAP_READ, 0, &mapped_data)))
+                {
+                    return std::nullopt;
+                }
+                auto destination = result.get_subresource(mip, slice);
+                uint32_t row_pitch = result.get_row_pitch(mip);
+                for (uint32_t row = 0; row < result.get_mip_height(mip); ++row)
+                {
+                    std::memcpy(destination.data() + static_cast<size_t>(row) * row_pitch,
+                                static_cast<const uint8_t *>(mapped_data.pData) + static_cast<size_t>(row) * mapped_data.RowPitch, row_pitch);
+                }
+                device_context->Unmap(staging_texture.Get(), subresource);
+            }
+        }
+        return result;
+    }
+
+    static void upload_texture(ID3D11DeviceContext *device_context, ID3D11Texture2D *texture, const IblTexture& source)
+    {
+        for (uint32_t slice = 0; slice < source.array_size; ++slice)
+        {
+            for (uint32_t mip = 0; mip < source.mip_count; ++mip)
+            {
+                device_context->UpdateSubresource(texture, D3D11CalcSubresource(mip, slice, source.mip_count), nullptr,
+                                                  source.get_subresource(mip, slice).data(), source.get_row_pitch(mip), 0);
+            }
+        }
+    }
+
     PreProcessEffect::PreProcessEffect() : m_effect_impl(std::make_unique<EffectImpl>()) {}
 
     PreProcessEffect::~PreProcessEffect() = default;
@@ -56,19 +129,15 @@ namespace toy
         // Create computer shaders
         std::string_view equirect_to_cube_cs = "EquirectToCube";
         std::string_view sp_env_map_cs = "SpEnvMap";
-        std::string_view irradiance_map_cs = "IrradianceMap";
         std::string_view brdf_lut_cs = "BRDF_LUT";
         m_effect_impl->equirect_to_cube_pass = "EqToCubePass";
         m_effect_impl->sp_env_map_pass = "SpEnvMapPass";
-        m_effect_impl->ir_map_pass = "IrMapPass";
         m_effect_impl->brdf_lut_pass = "BRDFLUTPass";
 
         m_effect_impl->effect_helper->create_shader_from_file(equirect_to_cube_cs, DXTOY_HOME L"data/pbr/equirect_to_cube.hlsl", device,
                                                                 "main", "cs_5_0");
         m_effect_impl->effect_helper->create_shader_from_file(sp_env_map_cs, DXTOY_HOME L"data/pbr/sp_env_map.hlsl", device,
                                                                 "main", "cs_5_0");
-        m_effect_impl->effect_helper->create_shader_from_file(irradiance_map_cs, DXTOY_HOME L"data/pbr/irradiance_map.hlsl", device,
-                                                                "main", "cs_5_0");
         m_effect_impl->effect_helper->create_shader_from_file(brdf_lut_cs, DXTOY_HOME L"data/pbr/sp_brdf.hlsl", device,
                                                                 "main", "cs_5_0");
 
@@ -78,8 +147,6 @@ namespace toy
         m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->equirect_to_cube_pass, device, &pass_desc);
         pass_desc.nameCS = sp_env_map_cs;
         m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->sp_env_map_pass, device, &pass_desc);
-        pass_desc.nameCS = irradiance_map_cs;
-        m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->ir_map_pass, device, &pass_desc);
         pass_desc.nameCS = brdf_lut_cs;
         m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->brdf_lut_pass, device, &pass_desc);
     }
@@ -88,11 +155,12 @@ namespace toy
     {
         // Load and convert equirectangular environment map to a cubemap texture
         auto&& texture_manager = model::TextureManager::get();
-        auto hdr_srv = texture_manager.create_from_file(file_path);
+        auto hdr_texture = texture_manager.create_from_file(file_path).get();
+        ID3D11ShaderResourceView* hdr_srv = hdr_texture.Get();
 
         if (!m_effect_impl->cube_texture)
         {
-            m_effect_impl->cube_texture = std::make_unique<TextureCube>(device, 1024, 1024, DXGI_FORMAT_R16G16B16A16_FLOAT, 0,
+            m_effect_impl->cube_texture = std::make_unique<TextureCube>(device, ibl_environment_size, ibl_environment_size, DXGI_FORMAT_R16G16B16A16_FLOAT, 0,
                                                                         D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
             create_texture_uav(device, m_effect_impl->cube_texture.get(), 0);
         }
@@ -124,11 +192,7 @@ namespace toy
     void PreProcessEffect::compute_sp_env_map(ID3D11Device *device, ID3D11DeviceContext *device_context)
     {
         // Compute pre-filtered specular environment map
-        if (!m_effect_impl->env_texture)
-        {
-            m_effect_impl->env_texture = std::make_unique<TextureCube>(device, 1024, 1024, DXGI_FORMAT_R16G16B16A16_FLOAT, 0,
-                                                                        D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
-        }
+        m_effect_impl->create_env_texture(device);
 
         //// Copy 0th mip-map level into destination environment map
         auto env_resource = m_effect_impl->env_texture->get_texture();
@@ -150,7 +214,7 @@ namespace toy
 
         auto mip_levels = m_effect_impl->env_texture->get_mip_levels();
         const float delta_roughness = 1.0f / std::max(float(mip_levels - 1), 1.0f);
-        for (uint32_t level = 1, size = 512; level < mip_levels; ++level, size /= 2)
+        for (uint32_t level = 1, size = ibl_environment_size / 2; level < mip_levels; ++level, size /= 2)
         {
             float roughness = static_cast<float>(level) * delta_roughness;
 
@@ -176,46 +240,10 @@ namespace toy
         device_context->CSSetUnorderedAccessViews(uav_slot, 1, &env_uav, nullptr);
     }
 
-    void PreProcessEffect::compute_irradiance_map(ID3D11Device *device, ID3D11DeviceContext *device_context)
-    {
-        // Compute diffuse irradiance cube map
-        if (!m_effect_impl->ir_map_texture)
-        {
-            m_effect_impl->ir_map_texture = std::make_unique<TextureCube>(device, 32, 32, DXGI_FORMAT_R16G16B16A16_FLOAT, 1,
-                                                                            D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
-            create_texture_uav(device, m_effect_impl->ir_map_texture.get(), 0);
-        }
-
-        auto width = m_effect_impl->ir_map_texture->get_width();
-        auto height = m_effect_impl->ir_map_texture->get_height();
-        auto ir_map_uav = m_effect_impl->ir_map_texture->get_unordered_access();
-        auto env_srv = m_effect_impl->env_texture->get_shader_resource();
-        auto pass = m_effect_impl->effect_helper->get_effect_pass(m_effect_impl->ir_map_pass);
-        m_effect_impl->effect_helper->set_shader_resource_by_name("gInputCubeMap", env_srv);
-        m_effect_impl->effect_helper->set_unordered_access_by_name("gOutputCubeMap", ir_map_uav);
-        m_effect_impl->effect_helper->set_sampler_state_by_name("gSamAnisotropicWrap", RenderStates::ss_anisotropic_wrap_16x.Get());
-        pass->apply(device_context);
-        pass->dispatch(device_context, width, height, 6);
-
-        //// Clear
-        ir_map_uav = nullptr;
-        env_srv = nullptr;
-        auto srv_slot = m_effect_impl->effect_helper->map_shader_resource_slot("gInputCubeMap");
-        auto uav_slot = m_effect_impl->effect_helper->map_unordered_access_slot("gOutputCubeMap");
-        DX_CORE_INFO("Environment map's shader resource view slot: {}; irradiance map's unordered access view slot: {}", srv_slot, uav_slot);
-        device_context->CSSetShaderResources(srv_slot, 1, &env_srv);
-        device_context->CSSetUnorderedAccessViews(uav_slot, 1, &ir_map_uav, nullptr);
-    }
-
     void PreProcessEffect::compute_brdf_lut(ID3D11Device *device, ID3D11DeviceContext *device_context)
     {
         // Compute Cook-Torrance BRDF 2D LUT for split-sum approximation
-        if (!m_effect_impl->sp_brdf_texture)
-        {
-            m_effect_impl->sp_brdf_texture = std::make_unique<Texture2D>(device, 256, 256, DXGI_FORMAT_R16G16_FLOAT, 1,
-                                                                            D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
-            create_texture_uav(device, m_effect_impl->sp_brdf_texture.get(), 0);
-        }
+        m_effect_impl->create_brdf_texture(device);
 
         auto width = m_effect_impl->sp_brdf_texture->get_width();
         auto height = m_effect_impl->sp_brdf_texture->get_height();
@@ -233,6 +261,68 @@ namespace toy
         device_context->CSSetUnorderedAccessViews(uav_slot, 1, &brdf_uav, nullptr);
     }
 
+    void PreProcessEffect::compute_ibl(ID3D11Device *device, ID3D11DeviceContext *device_context, std::string_view file_path)
+    {
+        if (!device)
+        {
+            bake_ibl_cache(file_path);
+            return;
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        XID content_key = file_content_to_id(file_path);
+        XID cache_key = content_key != 0 ? ibl_cache_key(content_key) : 0;
+
+        std::optional<IblTexture> environment{};
+        if (cache_key != 0)
+        {
+            environment = load_ibl_cache(ibl_environment_cache_path(cache_key));
+        }
+
+        m_effect_impl->create_env_texture(device);
+        auto&& env_texture = *m_effect_impl->env_texture;
+        bool cache_hit = environment && environment->matches(DXGI_FORMAT_R16G16B16A16_FLOAT, ibl_environment_size, env_texture.get_mip_levels(), 6);
+        if (cache_hit)
+        {
+            upload_texture(device_context, env_texture.get_texture(), *environment);
+        } else
+        {
+            compute_cubemap(device, device_context, file_path);
+            compute_sp_env_map(device, device_context);
+
+            // Read back waits for the passes once, later loads of the same image skip them
+            environment = read_back_texture(device, device_context, env_texture.get_texture());
+            if (environment && cache_key != 0)
+            {
+                save_ibl_cache(ibl_environment_cache_path(cache_key), *environment);
+            }
+        }
+
+        // Diffuse irradiance is projected from mip 0 on CPU, much cheaper than convolving an irradiance cube
+        m_effect_impl->irradiance_sh = environment ? std::optional<IrradianceSH>(project_irradiance_sh(*environment)) : std::nullopt;
+
+        // BRDF LUT does not depend on environment
+        if (!m_effect_impl->sp_brdf_texture)
+        {
+            auto brdf_lut = load_ibl_cache(ibl_brdf_lut_cache_path());
+            if (brdf_lut && brdf_lut->matches(DXGI_FORMAT_R16G16_FLOAT, ibl_brdf_lut_size, 1, 1))
+            {
+                m_effect_impl->create_brdf_texture(device);
+                upload_texture(device_context, m_effect_impl->sp_brdf_texture->get_texture(), *brdf_lut);
+            } else
+            {
+                compute_brdf_lut(device, device_context);
+                if (auto computed = read_back_texture(device, device_context, m_effect_impl->sp_brdf_texture->get_texture()))
+                {
+                    save_ibl_cache(ibl_brdf_lut_cache_path(), *computed);
+                }
+            }
+        }
+
+        std::chrono::duration<double, std::milli> switch_time = std::chrono::steady_clock::now() - start_time;
+        DX_CORE_INFO("Switch environment to {}: {:.1f} ms, IBL cache {}", file_path, switch_time.count(), cache_hit ? "hit" : "miss");
+    }
+
     ID3D11ShaderResourceView* PreProcessEffect::get_environment_srv() const
     {
         if (m_effect_impl->env_texture)
@@ -242,13 +332,9 @@ namespace toy
         return nullptr;
     }
 
-    ID3D11ShaderResourceView* PreProcessEffect::get_irradiance_srv() const
+    const IrradianceSH* PreProcessEffect::get_irradiance_sh() const
     {
-        if (m_effect_impl->ir_map_texture)
-        {
-            return m_effect_impl->ir_map_texture->get_shader_resource();
-        }
-        return nullptr;
+        return m_effect_impl->irradiance_sh ? &*m_effect_impl->irradiance_sh : nullptr;
     }
 
     ID3D11ShaderResourceView* PreProcessEffect::get_brdf_srv() const
@@ -262,7 +348,7 @@ namespace toy
 
     bool PreProcessEffect::is_ready() const
     {
-        return m_effect_impl->env_texture && m_effect_impl->ir_map_texture && m_effect_impl->sp_brdf_texture;
+        return m_effect_impl->env_texture && m_effect_impl->irradiance_sh && m_effect_impl->sp_brdf_texture;
     }
 }
 
@@ -6,6 +6,7 @@
 #include <Toy/Renderer/render_states.h>
 #include <Toy/Geometry/vertex.h>
 #include <Toy/Model/mesh_data.h>
+#include <Toy/Model/vertex_encoding.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Model/material.h>
 
@@ -20,8 +21,15 @@ namespace toy
         std::shared_ptr<IEffectPass>  cur_effect_pass = nullptr;
         com_ptr<ID3D11InputLayout>    cur_vertex_layout = nullptr;
         com_ptr<ID3D11InputLayout>    vertex_layout = nullptr;
+        com_ptr<ID3D11InputLayout>    quantized_vertex_layout = nullptr;
 
         std::string_view skybox_pass = {};
+        std::string_view skybox_quantized_pass = {};
+        bool is_skybox_pass = false;
+
+        // Dequantization of current mesh, identity for full precision mesh
+        DirectX::XMFLOAT3 position_scale = { 1.0f, 1.0f, 1.0f };
+        DirectX::XMFLOAT3 position_offset = {};
 
         DirectX::XMFLOAT4X4 view_matrix = {};
         DirectX::XMFLOAT4X4 proj_matrix = {};
@@ -58,8 +66,10 @@ namespace toy
         m_effect_impl->effect_helper = std::make_unique<EffectHelper>();
         m_effect_impl->effect_helper->set_binary_cache_directory(DXTOY_HOME L"data/pbr/cache");
         m_effect_impl->skybox_pass = "SkyboxPass";
+        m_effect_impl->skybox_quantized_pass = "SkyboxQuantizedPass";
 
         std::string_view skybox_vs = "SkyboxVS";
+        std::string_view skybox_quantized_vs = "SkyboxQuantizedVS";
         std::string_view skybox_ps = "SkyboxPS";
 
         // Create vertex and pixel shaders and input layout
@@ -77,6 +87,22 @@ namespace toy
             DX_CORE_CRITICAL("Fail to create vertex layout");
         }
 
+        // Vertex shader variant decoding quantized vertex streams
+        std::array<D3D_SHADER_MACRO, 2> quantized_defines = {
+            D3D_SHADER_MACRO{ "QUANTIZED_VERTEX", "1" },
+            D3D_SHADER_MACRO{ nullptr, nullptr }
+        };
+        m_effect_impl->effect_helper->create_shader_from_file(skybox_quantized_vs, DXTOY_HOME L"data/pbr/skybox.hlsl", device,
+                                                                "VS", "vs_5_0", quantized_defines.data(), blob.ReleaseAndGetAddressOf());
+        auto&& quantized_input_layout = VertexPosNormalTangentTexQuantized::get_input_layout();
+        device->CreateInputLayout(quantized_input_layout.data(), (uint32_t)quantized_input_layout.size(),
+                                    blob->GetBufferPointer(), blob->GetBufferSize(),
+                                    m_effect_impl->quantized_vertex_layout.ReleaseAndGetAddressOf());
+        if (!m_effect_impl->quantized_vertex_layout)
+        {
+            DX_CORE_CRITICAL("Fail to create quantized vertex layout");
+        }
+
         // Create skybox pass ans rasterizer state
         // Note: skybox pass shares the same depth-stencil state with deferred pbr pass
         EffectPassDesc pass_desc = {};
@@ -88,6 +114,13 @@ namespace toy
             pass->set_rasterizer_state(RenderStates::rs_no_cull.Get());
             pass->set_depth_stencil_state(RenderStates::dss_less_equal.Get(), 0);
         }
+        pass_desc.nameVS = skybox_quantized_vs;
+        m_effect_impl->effect_helper->add_effect_pass(m_effect_impl->skybox_quantized_pass, device, &pass_desc);
+        {
+            auto pass = m_effect_impl->effect_helper->get_effect_pass(m_effect_impl->skybox_quantized_pass);
+            pass->set_rasterizer_state(RenderStates::rs_no_cull.Get());
+            pass->set_depth_stencil_state(RenderStates::dss_less_equal.Get(), 0);
+        }
 
         // Set sampler state
         m_effect_impl->effect_helper->set_sampler_state_by_name("gSamAnisotropicWrap", RenderStates::ss_anisotropic_wrap_16x.Get());
@@ -102,7 +135,7 @@ namespace toy
             m_effect_impl->effect_helper->set_shader_resource_by_name("gSkyboxMap",env_map_srv);
         } else
         {
-            auto texture_map_name = material.try_get<std::string>("$Skybox");
+            auto texture_map_name = material.try_get<std::string>("$Skybox"_xid);
             m_effect_impl->effect_helper->set_shader_resource_by_name("gSkyboxMap",texture_map_name ? texture_manager.get_texture(*texture_map_name) : nullptr);
         }
     }
@@ -119,24 +152,50 @@ namespace toy
 
     MeshDataInput SimpleSkyboxEffect::get_input_data(const model::MeshData &mesh_data)
     {
+        // Quantized mesh needs decoding vertex shader, pass is selected here before the effect is applied
+        bool is_quantized = mesh_data.vertex_encoding == model::VertexEncoding::Quantized;
+        if (m_effect_impl->is_skybox_pass)
+        {
+            m_effect_impl->cur_effect_pass = m_effect_impl->effect_helper->get_effect_pass(
+                    is_quantized ? m_effect_impl->skybox_quantized_pass : m_effect_impl->skybox_pass);
+            m_effect_impl->cur_vertex_layout = is_quantized ? m_effect_impl->quantized_vertex_layout.Get() : m_effect_impl->vertex_layout.Get();
+        }
+        if (is_quantized)
+        {
+            model::get_position_dequantization(mesh_data.bounding_box, m_effect_impl->position_scale, m_effect_impl->position_offset);
+        } else
+        {
+            m_effect_impl->position_scale = DirectX::XMFLOAT3{ 1.0f, 1.0f, 1.0f };
+            m_effect_impl->position_offset = DirectX::XMFLOAT3{};
+        }
+
         MeshDataInput input;
         input.input_layout = m_effect_impl->cur_vertex_layout.Get();
         input.topology = m_effect_impl->cur_topology;
-        input.vertex_buffers = {
-            mesh_data.vertices.Get(),
-            mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
-        };
-        input.strides = { 12, 8 };
-        input.offsets = { 0, 0 };
+        auto texcoord = mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get();
+        if (is_quantized)
+        {
+            // Quantized layout reads texture coordinates at slot 3
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), mesh_data.tangents.Get(), texcoord };
+            input.strides = { 8, 4, 4, 4 };
+            input.offsets = { 0, 0, 0, 0 };
+        } else
+        {
+            input.vertex_buffers = { mesh_data.vertices.Get(), texcoord };
+            input.strides = { 12, 8 };
+            input.offsets = { 0, 0 };
+        }
 
         input.index_buffer = mesh_data.indices.Get();
         input.index_count = mesh_data.index_count;
+        input.index_format = mesh_data.index_format;
 
         return input;
     }
 
     void SimpleSkyboxEffect::set_skybox_render()
     {
+        m_effect_impl->is_skybox_pass = true;
         m_effect_impl->cur_effect_pass = m_effect_impl->effect_helper->get_effect_pass(m_effect_impl->skybox_pass);
         m_effect_impl->cur_vertex_layout = m_effect_impl->vertex_layout;
         m_effect_impl->cur_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -148,6 +207,8 @@ namespace toy
         XMMATRIX view_proj = XMLoadFloat4x4(&m_effect_impl->view_matrix) * XMLoadFloat4x4(&m_effect_impl->proj_matrix);
         view_proj = XMMatrixTranspose(view_proj);
         m_effect_impl->effect_helper->get_constant_buffer_variable("gViewProj")->set_float_matrix(4, 4, (const float *)&view_proj);
+        m_effect_impl->effect_helper->get_constant_buffer_variable("gPositionScale")->set_float_vector(3, (const float *)&m_effect_impl->position_scale);
+        m_effect_impl->effect_helper->get_constant_buffer_variable("gPositionOffset")->set_float_vector(3, (const float *)&m_effect_impl->position_offset);
 
         m_effect_impl->cur_effect_pass->apply(device_context);
     }
@@ -0,0 +1,215 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Renderer/shader_reflection.h>
+
+namespace toy
+{
+    static constexpr uint32_t make_fourcc(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+               (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+    }
+
+    // Header is magic, 16 byte checksum, version, total size and chunk count, followed by chunk offsets
+    static constexpr uint32_t s_dxbc_magic = make_fourcc('D', 'X', 'B', 'C');
+    static constexpr size_t s_dxbc_header_byte_width = 32;
+
+    // Offsets inside a chunk are relative to its data, reads out of chunk fail instead of running past it
+    class ChunkReader
+    {
+    public:
+        explicit ChunkReader(std::span<const uint8_t> data) : m_data(data) {}
+
+        [[nodiscard]] bool read(size_t offset, uint32_t& value) const
+        {
+            if (offset > m_data.size() || m_data.size() - offset < sizeof(uint32_t))
+            {
+                return false;
+            }
+            std::memcpy(&value, m_data.data() + offset, sizeof(uint32_t));
+            return true;
+        }
+
+        // Null terminated string, it must end inside chunk
+        [[nodiscard]] bool read_string(size_t offset, std::string& str) const
+        {
+            if (offset >= m_data.size())
+            {
+                return false;
+            }
+            auto begin = reinterpret_cast<const char *>(m_data.data() + offset);
+            auto end = static_cast<const char *>(std::memchr(begin, 0, m_data.size() - offset));
+            if (!end)
+            {
+                return false;
+            }
+            str.assign(begin, end);
+            return true;
+        }
+
+        // Array of count elements of stride bytes
+        [[nodiscard]] bool contains(size_t offset, size_t count, size_t stride) const
+        {
+            return offset <= m_data.size() && count <= (m_data.size() - offset) / stride;
+        }
+
+    private:
+        std::span<const uint8_t> m_data;
+    };
+
+    // Resource definitions, bindings are 32 bytes, 40 with register space from shader model 5.1
+    static bool reflect_resources(const ChunkReader& reader, ShaderReflection& reflection)
+    {
+        uint32_t cb_count = 0, cb_offset = 0, binding_count = 0, binding_offset = 0, version = 0;
+        if (!reader.read(0, cb_count) || !reader.read(4, cb_offset) || !reader.read(8, binding_count) ||
+            !reader.read(12, binding_offset) || !reader.read(16, version))
+        {
+            return false;
+        }
+        uint32_t major = (version >> 4) & 0xF;
+        uint32_t minor = version & 0xF;
+        bool has_space = major > 5 || (major == 5 && minor >= 1);
+        size_t binding_stride = has_space ? 40 : 32;
+
+        if (!reader.contains(binding_offset, binding_count, binding_stride) || !reader.contains(cb_offset, cb_count, 24))
+        {
+            return false;
+        }
+        reflection.bindings.resize(binding_count);
+        for (uint32_t i = 0; i < binding_count; ++i)
+        {
+            size_t offset = binding_offset + i * binding_stride;
+            auto&& binding = reflection.bindings[i];
+            uint32_t name_offset = 0;
+            if (!reader.read(offset, name_offset) || !reader.read_string(name_offset, binding.name) ||
+                !reader.read(offset + 4, binding.type) || !reader.read(offset + 20, binding.bind_point) ||
+                !reader.read(offset + 24, binding.bind_count) || (has_space && !reader.read(offset + 32, binding.space)))
+            {
+                return false;
+            }
+        }
+
+        reflection.constant_buffers.resize(cb_count);
+        for (uint32_t i = 0; i < cb_count; ++i)
+        {
+            size_t offset = cb_offset + i * 24;
+            auto&& constant_buffer = reflection.constant_buffers[i];
+            uint32_t name_offset = 0;
+            if (!reader.read(offset, name_offset) || !reader.read_string(name_offset, constant_buffer.name) ||
+                !reader.read(offset + 4, constant_buffer.variable_count) || !reader.read(offset + 12, constant_buffer.byte_width))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Signature is element count and a constant 8, then elements, stream and minimum precision widen them in later chunk kinds
+    static bool reflect_signature(const ChunkReader& reader, size_t stride, size_t field_offset, std::vector<ShaderParameter>& parameters)
+    {
+        uint32_t count = 0;
+        if (!reader.read(0, count) || !reader.contains(8, count, stride))
+        {
+            return false;
+        }
+        parameters.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            size_t offset = 8 + i * stride + field_offset;
+            auto&& parameter = parameters[i];
+            uint32_t name_offset = 0, mask = 0;
+            if (!reader.read(offset, name_offset) || !reader.read_string(name_offset, parameter.semantic) ||
+                !reader.read(offset + 4, parameter.semantic_index) || !reader.read(offset + 8, parameter.system_value) ||
+                !reader.read(offset + 12, parameter.component_type) || !reader.read(offset + 16, parameter.reg) ||
+                !reader.read(offset + 20, mask))
+            {
+                return false;
+            }
+            parameter.mask = mask & 0xF;
+        }
+        return true;
+    }
+
+    // First token of shader program holds stage and shader model
+    static bool reflect_program(const ChunkReader& reader, ShaderReflection& reflection)
+    {
+        uint32_t version = 0;
+        if (!reader.read(0, version))
+        {
+            return false;
+        }
+        uint32_t program_type = version >> 16;
+        reflection.stage = program_type < static_cast<uint32_t>(ShaderStage::Unknown) ? static_cast<ShaderStage>(program_type) : ShaderStage::Unknown;
+        reflection.major_version = (version >> 4) & 0xF;
+        reflection.minor_version = version & 0xF;
+        return true;
+    }
+
+    std::optional<ShaderReflection> reflect_shader(std::span<const uint8_t> bytecode)
+    {
+        ChunkReader reader(bytecode);
+        uint32_t magic = 0, total_size = 0, chunk_count = 0;
+        if (!reader.read(0, magic) || magic != s_dxbc_magic || !reader.read(24, total_size) || total_size > bytecode.size() ||
+            !reader.read(28, chunk_count) || !reader.contains(s_dxbc_header_byte_width, chunk_count, sizeof(uint32_t)))
+        {
+            return std::nullopt;
+        }
+
+        ShaderReflection reflection{};
+        reflection.content_id = content_to_id(bytecode.data(), total_size);
+        for (uint32_t i = 0; i < chunk_count; ++i)
+        {
+            uint32_t chunk_offset = 0, fourcc = 0, chunk_size = 0;
+            if (!reader.read(s_dxbc_header_byte_width + i * sizeof(uint32_t), chunk_offset) || !reader.read(chunk_offset, fourcc) ||
+                !reader.read(size_t{ chunk_offset } + 4, chunk_size) || !reader.contains(size_t{ chunk_offset } + 8, chunk_size, 1))
+            {
+                return std::nullopt;
+            }
+
+            ChunkReader chunk(bytecode.subspan(size_t{ chunk_offset } + 8, chunk_size));
+            bool is_valid = true;
+            switch (fourcc)
+            {
+                case make_fourcc('R', 'D', 'E', 'F'): is_valid = reflect_resources(chunk, reflection); break;
+                case make_fourcc('I', 'S', 'G', 'N'): is_valid = reflect_signature(chunk, 24, 0, reflection.inputs); break;
+                case make_fourcc('I', 'S', 'G', '1'): is_valid = reflect_signature(chunk, 32, 4, reflection.inputs); break;
+                case make_fourcc('O', 'S', 'G', 'N'): is_valid = reflect_signature(chunk, 24, 0, reflection.outputs); break;
+                case make_fourcc('O', 'S', 'G', '5'): is_valid = reflect_signature(chunk, 28, 4, reflection.outputs); break;
+                case make_fourcc('O', 'S', 'G', '1'): is_valid = reflect_signature(chunk, 32, 4, reflection.outputs); break;
+                case make_fourcc('S', 'H', 'D', 'R'):
+                case make_fourcc('S', 'H', 'E', 'X'): is_valid = reflect_program(chunk, reflection); break;
+                default: break;
+            }
+            if (!is_valid)
+            {
+                return std::nullopt;
+            }
+        }
+        return reflection;
+    }
+
+    std::string_view get_shader_stage_name(ShaderStage stage)
+    {
+        switch (stage)
+        {
+            case ShaderStage::Pixel: return "ps";
+            case ShaderStage::Vertex: return "vs";
+            case ShaderStage::Geometry: return "gs";
+            case ShaderStage::Hull: return "hs";
+            case ShaderStage::Domain: return "ds";
+            case ShaderStage::Compute: return "cs";
+            default: return "??";
+        }
+    }
+
+    std::string_view get_shader_binding_type_name(uint32_t type)
+    {
+        static constexpr std::array<std::string_view, 12> type_names = {
+            "cbuffer", "tbuffer", "texture", "sampler", "rwtyped", "structured", "rwstructured", "byteaddress",
+            "rwbyteaddress", "append_structured", "consume_structured", "rwstructured_with_counter"
+        };
+        return type < type_names.size() ? type_names[type] : "unknown";
+    }
+}
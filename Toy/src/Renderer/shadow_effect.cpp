@@ -6,6 +6,7 @@
 #include <Toy/Renderer/render_states.h>
 #include <Toy/Geometry/vertex.h>
 #include <Toy/Model/mesh_data.h>
+#include <Toy/Model/vertex_encoding.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Model/material.h>
 
@@ -38,8 +39,11 @@ namespace toy
         std::unique_ptr<EffectHelper> effect_helper = nullptr;
         std::shared_ptr<IEffectPass> cur_effect_pass = nullptr;
         com_ptr<ID3D11InputLayout> cur_input_layout = nullptr;
+        com_ptr<ID3D11InputLayout> quantized_input_layout = nullptr;
+        bool is_quantized = false;
 
         DirectX::XMFLOAT4X4 world_matrix = {};
+        DirectX::XMFLOAT4X4 position_decode_matrix = {};     // Quantized position decode, folded into world matrix
         DirectX::XMFLOAT4X4 view_matrix = {};
         DirectX::XMFLOAT4X4 proj_matrix = {};
 
@@ -125,6 +129,10 @@ namespace toy
         auto&& input_layout = VertexPosNormalTex::get_input_layout();
         device->CreateInputLayout(input_layout.data(), uint32_t(input_layout.size()), blob->GetBufferPointer(),
                                     blob->GetBufferSize(), m_effect_impl->cur_input_layout.GetAddressOf());
+        // Shadow vertex shader only reads position and texcoord, quantized normalized position is decoded by world matrix
+        auto&& quantized_input_layout = VertexPosNormalTangentTexQuantized::get_input_layout();
+        device->CreateInputLayout(quantized_input_layout.data(), uint32_t(quantized_input_layout.size()), blob->GetBufferPointer(),
+                                    blob->GetBufferSize(), m_effect_impl->quantized_input_layout.GetAddressOf());
         m_effect_impl->effect_helper->create_shader_from_file(screen_triangle_vs, DXTOY_HOME L"data/pbr/screen_triangle_vs.hlsl", device,
                                                                 "VS", "vs_5_0");
 
@@ -385,19 +393,41 @@ namespace toy
 
     MeshDataInput ShadowEffect::get_input_data(const model::MeshData &mesh_data)
     {
+        using namespace DirectX;
         MeshDataInput input;
-        input.input_layout = m_effect_impl->cur_input_layout.Get();
         input.topology = m_effect_impl->topology;
-        input.vertex_buffers = {
-            mesh_data.vertices.Get(),
-            mesh_data.normals.Get(),
-            mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
-        };
-        input.strides = { 12, 12, 8 };
-        input.offsets = { 0, 0, 0 };
+        m_effect_impl->is_quantized = mesh_data.vertex_encoding == model::VertexEncoding::Quantized;
+        if (m_effect_impl->is_quantized)
+        {
+            XMFLOAT3 scale{};
+            XMFLOAT3 offset{};
+            model::get_position_dequantization(mesh_data.bounding_box, scale, offset);
+            XMStoreFloat4x4(&m_effect_impl->position_decode_matrix, XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixTranslation(offset.x, offset.y, offset.z));
+
+            input.input_layout = m_effect_impl->quantized_input_layout.Get();
+            input.vertex_buffers = {
+                mesh_data.vertices.Get(),
+                mesh_data.normals.Get(),
+                mesh_data.tangents.Get(),
+                mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
+            };
+            input.strides = { 8, 4, 4, 4 };
+            input.offsets = { 0, 0, 0, 0 };
+        } else
+        {
+            input.input_layout = m_effect_impl->cur_input_layout.Get();
+            input.vertex_buffers = {
+                mesh_data.vertices.Get(),
+                mesh_data.normals.Get(),
+                mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
+            };
+            input.strides = { 12, 12, 8 };
+            input.offsets = { 0, 0, 0 };
+        }
 
         input.index_buffer = mesh_data.indices.Get();
         input.index_count = mesh_data.index_count;
+        input.index_format = mesh_data.index_format;
 
         return input;
     }
@@ -407,6 +437,10 @@ namespace toy
         using namespace DirectX;
         XMMATRIX world_view_proj = XMLoadFloat4x4(&m_effect_impl->world_matrix) * XMLoadFloat4x4(&m_effect_impl->view_matrix) *
                                     XMLoadFloat4x4(&m_effect_impl->proj_matrix);
+        if (m_effect_impl->is_quantized)
+        {
+            world_view_proj = XMLoadFloat4x4(&m_effect_impl->position_decode_matrix) * world_view_proj;
+        }
         world_view_proj = XMMatrixTranspose(world_view_proj);
         m_effect_impl->effect_helper->get_constant_buffer_variable("gWorldViewProj")->set_float_matrix(4, 4, (const float *)&world_view_proj);
 
@@ -7,6 +7,7 @@
 #include <Toy/Core/d3d_util.h>
 #include <Toy/Geometry/vertex.h>
 #include <Toy/Model/mesh_data.h>
+#include <Toy/Model/vertex_encoding.h>
 #include <Toy/Model/texture_manager.h>
 #include <Toy/Model/material.h>
 
@@ -27,6 +28,15 @@ namespace toy
         std::shared_ptr<IEffectPass> m_curr_effect_pass;
         com_ptr<ID3D11InputLayout> m_curr_input_layout;
         com_ptr<ID3D11InputLayout> m_vertex_pos_normal_tex_layout;
+        com_ptr<ID3D11InputLayout> m_quantized_vertex_layout;
+
+        // Current skybox pass and its variant for quantized vertex streams, selected per mesh
+        std::string m_skybox_pass;
+        std::string m_skybox_quantized_pass;
+
+        // Dequantization of current mesh, identity for full precision mesh
+        DirectX::XMFLOAT3 m_position_scale = { 1.0f, 1.0f, 1.0f };
+        DirectX::XMFLOAT3 m_position_offset = {};
 
         DirectX::XMFLOAT4X4 m_view, m_proj;
         D3D11_PRIMITIVE_TOPOLOGY m_curr_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -75,6 +85,19 @@ namespace toy
                                     blob->GetBufferPointer(), blob->GetBufferSize(),
                                     m_effect_impl->m_vertex_pos_normal_tex_layout.ReleaseAndGetAddressOf());
 
+        // Vertex shader variant decoding quantized vertex streams
+        D3D_SHADER_MACRO quantized_defines[] = {
+            {"MSAA_SAMPLES", "1"},
+            {"QUANTIZED_VERTEX", "1"},
+            {nullptr, nullptr}
+        };
+        m_effect_impl->m_effect_helper->create_shader_from_file("SkyboxQuantizedVS", DXTOY_HOME L"data/defer/skybox.hlsl", device,
+                                                                "SkyboxVS", "vs_5_0", quantized_defines, blob.ReleaseAndGetAddressOf());
+        auto&& quantized_input_layout = VertexPosNormalTangentTexQuantized::get_input_layout();
+        device->CreateInputLayout(quantized_input_layout.data(), (uint32_t)quantized_input_layout.size(),
+                                    blob->GetBufferPointer(), blob->GetBufferSize(),
+                                    m_effect_impl->m_quantized_vertex_layout.ReleaseAndGetAddressOf());
+
         int32_t msaa_samples = 1;
         while (msaa_samples <= 8)
         {
@@ -100,6 +123,14 @@ namespace toy
                 pPass->set_rasterizer_state(RenderStates::rs_no_cull.Get());
             }
 
+            std::string quantizedPassName = "SkyboxQuantized_" + msaaSamplesStr + "xMSAA";
+            passDesc.nameVS = "SkyboxQuantizedVS";
+            m_effect_impl->m_effect_helper->add_effect_pass(quantizedPassName, device, &passDesc);
+            {
+                auto pPass = m_effect_impl->m_effect_helper->get_effect_pass(quantizedPassName);
+                pPass->set_rasterizer_state(RenderStates::rs_no_cull.Get());
+            }
+
             msaa_samples <<= 1;
         }
 
@@ -113,8 +144,10 @@ namespace toy
 
     void SkyboxEffect::set_default_render()
     {
-        std::string passName = "Skybox_" + std::to_string(m_effect_impl->m_msaa_levels) + "xMSAA";
-        m_effect_impl->m_curr_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(passName);
+        std::string msaaLevelsStr = std::to_string(m_effect_impl->m_msaa_levels);
+        m_effect_impl->m_skybox_pass = "Skybox_" + msaaLevelsStr + "xMSAA";
+        m_effect_impl->m_skybox_quantized_pass = "SkyboxQuantized_" + msaaLevelsStr + "xMSAA";
+        m_effect_impl->m_curr_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(m_effect_impl->m_skybox_pass);
         m_effect_impl->m_curr_input_layout = m_effect_impl->m_vertex_pos_normal_tex_layout;
         m_effect_impl->m_curr_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
     }
@@ -143,7 +176,7 @@ namespace toy
             m_effect_impl->m_effect_helper->set_shader_resource_by_name("g_SkyboxTexture",env_map_srv);
         } else
         {
-            auto texture_id_str = material.try_get<std::string>("$Skybox");
+            auto texture_id_str = material.try_get<std::string>("$Skybox"_xid);
             m_effect_impl->m_effect_helper->set_shader_resource_by_name("g_SkyboxTexture",
                                                                         texture_id_str ? texture_manager.get_texture(*texture_id_str) : nullptr);
         }
@@ -151,19 +184,43 @@ namespace toy
 
     MeshDataInput SkyboxEffect::get_input_data(const model::MeshData &mesh_data)
     {
+        // Quantized mesh needs decoding vertex shader, pass is selected here before the effect is applied
+        bool is_quantized = mesh_data.vertex_encoding == model::VertexEncoding::Quantized;
+        if (!m_effect_impl->m_skybox_pass.empty())
+        {
+            m_effect_impl->m_curr_effect_pass = m_effect_impl->m_effect_helper->get_effect_pass(
+                    is_quantized ? m_effect_impl->m_skybox_quantized_pass : m_effect_impl->m_skybox_pass);
+            m_effect_impl->m_curr_input_layout = is_quantized ? m_effect_impl->m_quantized_vertex_layout : m_effect_impl->m_vertex_pos_normal_tex_layout;
+        }
+        if (is_quantized)
+        {
+            model::get_position_dequantization(mesh_data.bounding_box, m_effect_impl->m_position_scale, m_effect_impl->m_position_offset);
+        } else
+        {
+            m_effect_impl->m_position_scale = DirectX::XMFLOAT3{ 1.0f, 1.0f, 1.0f };
+            m_effect_impl->m_position_offset = DirectX::XMFLOAT3{};
+        }
+
         MeshDataInput input;
         input.input_layout = m_effect_impl->m_curr_input_layout.Get();
         input.topology = m_effect_impl->m_curr_topology;
-        input.vertex_buffers = {
-            mesh_data.vertices.Get(),
-            mesh_data.normals.Get(),
-            mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get()
-        };
-        input.strides = { 12, 12, 8 };
-        input.offsets = { 0, 0, 0 };
+        auto texcoord = mesh_data.texcoord_arrays.empty() ? nullptr : mesh_data.texcoord_arrays[0].Get();
+        if (is_quantized)
+        {
+            // Quantized layout reads tangent stream at slot 2
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), mesh_data.tangents.Get(), texcoord };
+            input.strides = { 8, 4, 4, 4 };
+            input.offsets = { 0, 0, 0, 0 };
+        } else
+        {
+            input.vertex_buffers = { mesh_data.vertices.Get(), mesh_data.normals.Get(), texcoord };
+            input.strides = { 12, 12, 8 };
+            input.offsets = { 0, 0, 0 };
+        }
 
         input.index_buffer = mesh_data.indices.Get();
         input.index_count = mesh_data.index_count;
+        input.index_format = mesh_data.index_format;
 
         return input;
     }
@@ -201,6 +258,8 @@ namespace toy
         XMMATRIX view_proj = XMLoadFloat4x4(&m_effect_impl->m_view) * XMLoadFloat4x4(&m_effect_impl->m_proj);
         view_proj = XMMatrixTranspose(view_proj);
         m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_ViewProj")->set_float_matrix(4, 4, (const float *)&view_proj);
+        m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_PositionScale")->set_float_vector(3, (const float *)&m_effect_impl->m_position_scale);
+        m_effect_impl->m_effect_helper->get_constant_buffer_variable("g_PositionOffset")->set_float_vector(3, (const float *)&m_effect_impl->m_position_offset);
 
         m_effect_impl->m_curr_effect_pass->apply(device_context);
     }
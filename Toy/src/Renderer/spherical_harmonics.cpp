@@ -0,0 +1,227 @@
+//
+// Created by ZZK on 2024/4/16.
+//
+
+#include <Toy/Renderer/spherical_harmonics.h>
+#include <Toy/Core/parallel.h>
+
+namespace toy
+{
+    // Real SH basis constants of bands 0 to 2
+    static constexpr float s_sh_y00 = 0.282095f;
+    static constexpr float s_sh_y1 = 0.488603f;
+    static constexpr float s_sh_y2 = 1.092548f;
+    static constexpr float s_sh_y20 = 0.315392f;
+    static constexpr float s_sh_y22 = 0.546274f;
+
+    // Clamped cosine convolution over pi of each band, see Ramamoorthi and Hanrahan, An Efficient Representation for Irradiance Environment Maps
+    static constexpr std::array<float, 9> s_irradiance_factors = {
+        1.0f * s_sh_y00,
+        2.0f / 3.0f * s_sh_y1, 2.0f / 3.0f * s_sh_y1, 2.0f / 3.0f * s_sh_y1,
+        0.25f * s_sh_y2, 0.25f * s_sh_y2, 0.25f * s_sh_y20, 0.25f * s_sh_y2, 0.25f * s_sh_y22
+    };
+
+    // Sums of a row, RGB of every coefficient followed by total solid angle
+    using ShRowSums = std::array<float, 28>;
+
+    // Running sums of 4 texels at once, one lane per texel
+    class ShAccumulator
+    {
+    public:
+        ShAccumulator()
+        {
+            std::fill(std::begin(m_sums), std::end(m_sums), DirectX::XMVectorZero());
+        }
+
+        // Direction of every lane is a unit vector, colors are RGBA of 4 texels with channels in rows
+        void add(DirectX::FXMVECTOR x, DirectX::FXMVECTOR y, DirectX::FXMVECTOR z, DirectX::GXMVECTOR weight, const DirectX::XMMATRIX& colors)
+        {
+            using namespace DirectX;
+            XMVECTOR xy = XMVectorMultiply(x, y);
+            XMVECTOR zz = XMVectorMultiply(z, z);
+            const XMVECTOR basis[9] = {
+                XMVectorReplicate(s_sh_y00),
+                XMVectorScale(y, s_sh_y1),
+                XMVectorScale(z, s_sh_y1),
+                XMVectorScale(x, s_sh_y1),
+                XMVectorScale(xy, s_sh_y2),
+                XMVectorScale(XMVectorMultiply(y, z), s_sh_y2),
+                XMVectorScale(XMVectorSubtract(XMVectorAdd(zz, XMVectorAdd(zz, zz)), g_XMOne), s_sh_y20),
+                XMVectorScale(XMVectorMultiply(x, z), s_sh_y2),
+                XMVectorScale(XMVectorSubtract(XMVectorMultiply(x, x), XMVectorMultiply(y, y)), s_sh_y22)
+            };
+            for (size_t i = 0; i < std::size(basis); ++i)
+            {
+                XMVECTOR weighted_basis = XMVectorMultiply(basis[i], weight);
+                m_sums[i * 3 + 0] = XMVectorMultiplyAdd(colors.r[0], weighted_basis, m_sums[i * 3 + 0]);
+                m_sums[i * 3 + 1] = XMVectorMultiplyAdd(colors.r[1], weighted_basis, m_sums[i * 3 + 1]);
+                m_sums[i * 3 + 2] = XMVectorMultiplyAdd(colors.r[2], weighted_basis, m_sums[i * 3 + 2]);
+            }
+            m_sums[27] = XMVectorAdd(m_sums[27], weight);
+        }
+
+        [[nodiscard]] ShRowSums get_sums() const
+        {
+            ShRowSums row_sums{};
+            for (size_t i = 0; i < std::size(m_sums); ++i)
+            {
+                DirectX::XMFLOAT4 lanes{};
+                DirectX::XMStoreFloat4(&lanes, m_sums[i]);
+                row_sums[i] = (lanes.x + lanes.y) + (lanes.z + lanes.w);
+            }
+            return row_sums;
+        }
+
+    private:
+        DirectX::XMVECTOR m_sums[28]{};
+    };
+
+    // Zero weight of lanes past the end of row, their texels are clamped loads of the last one
+    static DirectX::XMVECTOR mask_lanes(DirectX::FXMVECTOR weight, uint32_t x, uint32_t width)
+    {
+        using namespace DirectX;
+        XMVECTOR lanes = XMVectorSet(static_cast<float>(x), static_cast<float>(x + 1), static_cast<float>(x + 2), static_cast<float>(x + 3));
+        return XMVectorSelect(XMVectorZero(), weight, XMVectorLess(lanes, XMVectorReplicate(static_cast<float>(width))));
+    }
+
+    // Rows are summed in double, in order, so result does not depend on worker count
+    static IrradianceSH finish_projection(std::span<const ShRowSums> row_sums)
+    {
+        std::array<double, 28> sums{};
+        for (auto&& row : row_sums)
+        {
+            for (size_t i = 0; i < sums.size(); ++i)
+            {
+                sums[i] += row[i];
+            }
+        }
+
+        // Discrete solid angles are normalized to cover the sphere exactly
+        double scale = sums[27] > 0.0 ? 4.0 * 3.14159265358979 / sums[27] : 0.0;
+        IrradianceSH irradiance_sh{};
+        for (size_t i = 0; i < irradiance_sh.coefficients.size(); ++i)
+        {
+            double factor = scale * s_irradiance_factors[i];
+            irradiance_sh.coefficients[i] = DirectX::XMFLOAT3{ static_cast<float>(sums[i * 3 + 0] * factor),
+                                                               static_cast<float>(sums[i * 3 + 1] * factor),
+                                                               static_cast<float>(sums[i * 3 + 2] * factor) };
+        }
+        return irradiance_sh;
+    }
+
+    IrradianceSH project_irradiance_sh(const IblTexture& environment_cube)
+    {
+        using namespace DirectX;
+        uint32_t size = environment_cube.width;
+        std::vector<ShRowSums> row_sums(static_cast<size_t>(size) * 6);
+        parallel_for(row_sums.size(), [&environment_cube, &row_sums, size](size_t row)
+        {
+            auto face = static_cast<uint32_t>(row / size);
+            auto y = static_cast<uint32_t>(row % size);
+            auto texels = reinterpret_cast<const PackedVector::XMHALF4*>(environment_cube.get_subresource(0, face).data()) +
+                          static_cast<size_t>(y) * size;
+
+            // Texel center is (u, v, 1) on face, its solid angle is texel area over distance cubed
+            float texel_size = 2.0f / static_cast<float>(size);
+            XMVECTOR v = XMVectorReplicate(1.0f - (static_cast<float>(y) + 0.5f) * texel_size);
+            ShAccumulator accumulator{};
+            for (uint32_t x = 0; x < size; x += 4)
+            {
+                XMVECTOR lanes = XMVectorSet(static_cast<float>(x), static_cast<float>(x + 1), static_cast<float>(x + 2), static_cast<float>(x + 3));
+                XMVECTOR u = XMVectorMultiplyAdd(XMVectorAdd(lanes, XMVectorReplicate(0.5f)), XMVectorReplicate(texel_size), g_XMNegativeOne);
+                XMVECTOR inv_length = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(u, u, XMVectorMultiplyAdd(v, v, g_XMOne)));
+                XMVECTOR weight = XMVectorScale(XMVectorMultiply(inv_length, XMVectorMultiply(inv_length, inv_length)), texel_size * texel_size);
+
+                // Same face orientation as get_sampling_vector of the preprocess shaders
+                XMVECTOR one = g_XMOne;
+                XMVECTOR direction[3]{};
+                switch (face)
+                {
+                    case 0: direction[0] = one; direction[1] = v; direction[2] = XMVectorNegate(u); break;
+                    case 1: direction[0] = XMVectorNegate(one); direction[1] = v; direction[2] = u; break;
+                    case 2: direction[0] = u; direction[1] = one; direction[2] = XMVectorNegate(v); break;
+                    case 3: direction[0] = u; direction[1] = XMVectorNegate(one); direction[2] = v; break;
+                    case 4: direction[0] = u; direction[1] = v; direction[2] = one; break;
+                    default: direction[0] = XMVectorNegate(u); direction[1] = v; direction[2] = XMVectorNegate(one); break;
+                }
+
+                auto load_texel = [texels, size](uint32_t tx) { return PackedVector::XMLoadHalf4(texels + std::min(tx, size - 1)); };
+                XMMATRIX colors = XMMatrixTranspose(XMMATRIX(load_texel(x), load_texel(x + 1), load_texel(x + 2), load_texel(x + 3)));
+                accumulator.add(XMVectorMultiply(direction[0], inv_length), XMVectorMultiply(direction[1], inv_length),
+                                XMVectorMultiply(direction[2], inv_length), mask_lanes(weight, x, size), colors);
+            }
+            row_sums[row] = accumulator.get_sums();
+        });
+        return finish_projection(row_sums);
+    }
+
+    IrradianceSH project_irradiance_sh(const model::HdrImage& equirect_image)
+    {
+        using namespace DirectX;
+        uint32_t width = equirect_image.width;
+        uint32_t height = equirect_image.height;
+        std::vector<ShRowSums> row_sums(height);
+        parallel_for(height, [&equirect_image, &row_sums, width, height](size_t y)
+        {
+            auto load_texel = [&equirect_image, width, y](uint32_t x)
+            {
+                size_t index = y * width + std::min(x, width - 1);
+                if (equirect_image.format == model::HdrFormat::RGBA16F)
+                {
+                    return PackedVector::XMLoadHalf4(reinterpret_cast<const PackedVector::XMHALF4*>(equirect_image.pixels.data()) + index);
+                }
+                return PackedVector::XMLoadFloat3SE(reinterpret_cast<const PackedVector::XMFLOAT3SE*>(equirect_image.pixels.data()) + index);
+            };
+
+            // Row is a ring of constant polar angle, as equirect_to_cube.hlsl maps it, solid angle shrinks with sin(theta)
+            float delta_phi = 2.0f * XM_PI / static_cast<float>(width);
+            float delta_theta = XM_PI / static_cast<float>(height);
+            float theta = (static_cast<float>(y) + 0.5f) * delta_theta;
+            XMVECTOR sin_theta = XMVectorReplicate(std::sin(theta));
+            XMVECTOR cos_theta = XMVectorReplicate(std::cos(theta));
+            XMVECTOR row_weight = XMVectorReplicate(std::sin(theta) * delta_phi * delta_theta);
+            ShAccumulator accumulator{};
+            for (uint32_t x = 0; x < width; x += 4)
+            {
+                XMVECTOR lanes = XMVectorSet(static_cast<float>(x), static_cast<float>(x + 1), static_cast<float>(x + 2), static_cast<float>(x + 3));
+                XMVECTOR phi = XMVectorScale(XMVectorAdd(lanes, XMVectorReplicate(0.5f)), delta_phi);
+                XMVECTOR sin_phi{}, cos_phi{};
+                XMVectorSinCos(&sin_phi, &cos_phi, phi);
+
+                XMMATRIX colors = XMMatrixTranspose(XMMATRIX(load_texel(x), load_texel(x + 1), load_texel(x + 2), load_texel(x + 3)));
+                accumulator.add(XMVectorMultiply(cos_phi, sin_theta), cos_theta, XMVectorMultiply(sin_phi, sin_theta),
+                                mask_lanes(row_weight, x, width), colors);
+            }
+            row_sums[y] = accumulator.get_sums();
+        });
+        return finish_projection(row_sums);
+    }
+
+    DirectX::XMVECTOR evaluate_irradiance_sh(const IrradianceSH& irradiance_sh, DirectX::FXMVECTOR normal)
+    {
+        using namespace DirectX;
+        XMFLOAT3 n{};
+        XMStoreFloat3(&n, normal);
+        const std::array<float, 9> polynomial = {
+            1.0f, n.y, n.z, n.x, n.x * n.y, n.y * n.z, 3.0f * n.z * n.z - 1.0f, n.x * n.z, n.x * n.x - n.y * n.y
+        };
+
+        XMVECTOR irradiance = XMVectorZero();
+        for (size_t i = 0; i < polynomial.size(); ++i)
+        {
+            irradiance = XMVectorMultiplyAdd(XMLoadFloat3(&irradiance_sh.coefficients[i]), XMVectorReplicate(polynomial[i]), irradiance);
+        }
+        return XMVectorMax(irradiance, XMVectorZero());
+    }
+
+    std::array<DirectX::XMFLOAT4, 9> get_constant_data(const IrradianceSH& irradiance_sh)
+    {
+        std::array<DirectX::XMFLOAT4, 9> constant_data{};
+        for (size_t i = 0; i < constant_data.size(); ++i)
+        {
+            auto&& coefficient = irradiance_sh.coefficients[i];
+            constant_data[i] = DirectX::XMFLOAT4{ coefficient.x, coefficient.y, coefficient.z, 0.0f };
+        }
+        return constant_data;
+    }
+}
@@ -11,6 +11,10 @@
 #include <Toy/Runtime/render_window.h>
 #include <Toy/Runtime/scene_graph.h>
 #include <Toy/Runtime/task_system.h>
+#include <Toy/Runtime/world_streamer.h>
+#include <Toy/Runtime/async_model_loader.h>
+#include <Toy/ECS/components.h>
+#include <Toy/Core/virtual_file_system.h>
 
 namespace toy::runtime
 {
@@ -24,6 +28,8 @@ namespace toy::runtime
         auto&& simulation = core::add_subsystem<Simulation>();
         auto&& input_controller = core::add_subsystem<InputController>();
         input_controller.register_event(render_window.get_native_window());
+        core::add_subsystem<AsyncModelLoader>(scene_graph, task_system);
+        // World streamer is only added once a world is opened, see open_world
     }
 
     void Application::setup()
@@ -49,9 +55,25 @@ namespace toy::runtime
         input_controller.update_state();
 
         process_events();
+        // Loads that completed in events above are released
+        core::get_subsystem<AsyncModelLoader>().update();
 
         if (!m_is_running || renderer.is_renderer_minimized()) return;
 
+        // Stream world cells around the first camera before rendering it
+        if (core::has_subsystems<WorldStreamer>())
+        {
+            auto&& world_streamer = core::get_subsystem<WorldStreamer>();
+            bool is_streamed = false;
+            core::get_subsystem<SceneGraph>().for_each<CameraComponent>([&world_streamer, &is_streamed] (CameraComponent &camera_component){
+                if (!is_streamed && camera_component.camera)
+                {
+                    world_streamer.update(*camera_component.camera);
+                    is_streamed = true;
+                }
+            });
+        }
+
         float delta_time = simulation.get_delta_ime();
         renderer.tick();
 
@@ -67,6 +89,9 @@ namespace toy::runtime
     {
         core::details::initialize();
 
+        // Assets are read from pack when one has been built by ToyPack, loose files otherwise
+        VirtualFileSystem::get().mount(std::filesystem::path(DXTOY_HOME) / default_asset_pack_name, DXTOY_HOME);
+
         setup();
 
         start();
@@ -86,6 +111,14 @@ namespace toy::runtime
         m_is_running = false;
     }
 
+    bool Application::open_world(const std::filesystem::path &file_path)
+    {
+        // Created after renderer, so that model manager has a device when cells are activated
+        auto&& world_streamer = core::has_subsystems<WorldStreamer>() ? core::get_subsystem<WorldStreamer>() :
+                                core::add_subsystem<WorldStreamer>(core::get_subsystem<SceneGraph>());
+        return world_streamer.load_world(file_path);
+    }
+
     void Application::process_events()
     {
         auto&& render_window = core::get_subsystem<RenderWindow>();
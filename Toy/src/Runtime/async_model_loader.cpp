@@ -0,0 +1,202 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Runtime/async_model_loader.h>
+#include <Toy/Runtime/scene_graph.h>
+#include <Toy/Runtime/task_system.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Model/model_manager.h>
+#include <Toy/Model/mesh_cache.h>
+#include <Toy/Model/texture_manager.h>
+#include <Toy/ECS/components.h>
+
+namespace toy::runtime
+{
+    // Touch every page of file, so that main thread reads it from memory
+    static void prefetch_file(const std::filesystem::path& file_path)
+    {
+        constexpr size_t page_size = 4096;
+        MappedFile file(file_path);
+        uint8_t checksum = 0;
+        for (size_t offset = 0; offset < file.size(); offset += page_size)
+        {
+            checksum ^= file.data()[offset];
+        }
+        static_cast<void>(*static_cast<volatile uint8_t*>(&checksum));
+    }
+
+    // Placeholder is made from geometry, it is created again if it has been evicted
+    static model::ModelHandle acquire_placeholder()
+    {
+        auto&& model_manager = model::ModelManager::get();
+        model::ModelHandle placeholder = model_manager.acquire(model_placeholder_name);
+        if (!placeholder)
+        {
+            placeholder = model_manager.create_from_geometry(model_placeholder_name, geometry::create_box());
+        }
+        return placeholder;
+    }
+
+    static double get_elapsed_ms(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    AsyncModelLoader::AsyncModelLoader(SceneGraph &scene_graph, TaskSystem &task_system, size_t num_threads)
+        : m_scene_graph(scene_graph), m_task_system(task_system), m_vertex_encoding(model::ModelManager::get().get_vertex_encoding()),
+          m_stream_storage(model::ModelManager::get().get_stream_storage()),
+          m_pool(std::max<size_t>(num_threads, 1))
+    {
+
+    }
+
+    AsyncModelLoader::~AsyncModelLoader()
+    {
+        cancel_all();
+    }
+
+    std::shared_ptr<ModelLoad> AsyncModelLoader::load(std::string_view file_name, const Transform &transform)
+    {
+        auto entity = m_scene_graph.create_entity(std::filesystem::path(file_name).filename().string());
+        // Placeholder entity is not saved until its model is loaded
+        entity.add_component<TransientComponent>().owner = "Model loader";
+        entity.add_component<TransformComponent>().transform = transform;
+        entity.add_component<StaticMeshComponent>().model_asset = acquire_placeholder();
+
+        auto load = std::make_shared<ModelLoad>(file_name, entity);
+        m_loads.push_back({ load, run_load(load) });
+        return load;
+    }
+
+    void AsyncModelLoader::cancel_all()
+    {
+        for (auto&& [load, task] : m_loads)
+        {
+            load->cancel();
+        }
+    }
+
+    void AsyncModelLoader::update()
+    {
+        // Finished loads have ended on main thread, their coroutines wait at their end
+        std::erase_if(m_loads, [](const LoadTask &load_task) { return load_task.load->is_finished() && load_task.task.is_done(); });
+    }
+
+    std::vector<std::shared_ptr<ModelLoad>> AsyncModelLoader::get_loads() const
+    {
+        std::vector<std::shared_ptr<ModelLoad>> loads{};
+        loads.reserve(m_loads.size());
+        for (auto&& [load, task] : m_loads)
+        {
+            loads.push_back(load);
+        }
+        return loads;
+    }
+
+    AsyncTask AsyncModelLoader::run_load(std::shared_ptr<ModelLoad> load)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        co_await resume_on(m_pool);
+
+        // Worker threads, caches are written as on first load of create_from_file, so that it only maps them
+        std::string error{};
+        try
+        {
+            if (!load->is_cancelled())
+            {
+                load->m_progress = 0.05f;
+                model::BakeResult mesh_result = model::bake_mesh_cache(load->m_file_name, m_vertex_encoding, m_stream_storage);
+                if (mesh_result.status == model::BakeStatus::Failed)
+                {
+                    throw std::runtime_error("processed mesh cache can not be written");
+                }
+                if (mesh_result.status == model::BakeStatus::Skipped)
+                {
+                    prefetch_file(load->m_file_name);
+                }
+                load->m_progress = 0.5f;
+
+                load->m_stage = ModelLoadStage::Textures;
+                for (auto&& mesh_cache_file : mesh_result.outputs)
+                {
+                    MappedFile image(mesh_cache_file);
+                    std::vector<model::TextureSource> textures = model::get_mesh_cache_textures(image.bytes());
+                    for (size_t i = 0; i < textures.size() && !load->is_cancelled(); ++i)
+                    {
+                        model::bake_texture_cache(textures[i]);
+                        load->m_progress = 0.5f + 0.4f * static_cast<float>(i + 1) / static_cast<float>(textures.size());
+                    }
+                }
+            }
+        } catch (const std::exception &exception)
+        {
+            error = exception.what();
+        }
+        double worker_ms = get_elapsed_ms(start_time);
+
+        co_await resume_on_main_thread(m_task_system, load);
+
+        // Main thread, entity may have been deleted or scene replaced meanwhile
+        if (!error.empty())
+        {
+            DX_CORE_ERROR("Fail to load model '{}': {}", load->m_file_name, error);
+            remove_entity(*load);
+            load->m_stage = ModelLoadStage::Failed;
+            co_return;
+        }
+        if (load->is_cancelled() || !m_scene_graph.contains(load->m_entity))
+        {
+            DX_CORE_INFO("Load of model '{}' cancelled", load->m_file_name);
+            remove_entity(*load);
+            load->m_stage = ModelLoadStage::Cancelled;
+            co_return;
+        }
+
+        load->m_stage = ModelLoadStage::Uploading;
+        load->m_progress = 0.9f;
+        auto upload_start_time = std::chrono::steady_clock::now();
+        try
+        {
+            finish_load(*load);
+        } catch (const std::exception &exception)
+        {
+            DX_CORE_ERROR("Fail to load model '{}': {}", load->m_file_name, exception.what());
+            remove_entity(*load);
+            load->m_stage = ModelLoadStage::Failed;
+            co_return;
+        }
+        DX_CORE_INFO("Model '{}' loaded in {:.2f} ms, {:.2f} ms on workers and {:.2f} ms on main thread", load->m_file_name,
+                     get_elapsed_ms(start_time), worker_ms, get_elapsed_ms(upload_start_time));
+        load->m_progress = 1.0f;
+        load->m_stage = ModelLoadStage::Finished;
+    }
+
+    void AsyncModelLoader::finish_load(ModelLoad &load)
+    {
+        auto&& model_manager = model::ModelManager::get();
+        model::ModelHandle model_asset = model_manager.acquire(load.m_file_name);
+        if (!model_asset)
+        {
+            model_asset = model_manager.create_from_file(load.m_file_name);
+        }
+
+        if (!load.m_entity.has_component<StaticMeshComponent>())
+        {
+            load.m_entity.add_component<StaticMeshComponent>();
+        }
+        load.m_entity.get_component<StaticMeshComponent>().model_asset = std::move(model_asset);
+        if (load.m_entity.has_component<TransientComponent>())
+        {
+            load.m_entity.remove_component<TransientComponent>();
+        }
+    }
+
+    void AsyncModelLoader::remove_entity(ModelLoad &load)
+    {
+        if (m_scene_graph.contains(load.m_entity))
+        {
+            m_scene_graph.destroy_entity(load.m_entity);
+        }
+    }
+}
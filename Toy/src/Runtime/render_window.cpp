@@ -119,15 +119,10 @@ namespace toy::runtime
             task_system.push(m_framebuffer_resize_event);
         }
 
-        if (task_system.empty() && !m_delegate_events.empty())
+        // Appended rather than assigned, workers may have queued completion events meanwhile
+        for (auto&& event : m_delegate_events)
         {
-            task_system.assign(m_delegate_events.cbegin(), m_delegate_events.cend());
-        } else if (!task_system.empty() && !m_delegate_events.empty())
-        {
-            for (auto&& event : m_delegate_events)
-            {
-                task_system.push(event);
-            }
+            task_system.push(event);
         }
     }
 }
\ No newline at end of file
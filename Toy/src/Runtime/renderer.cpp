@@ -12,6 +12,7 @@
 #include <Toy/Core/subsystem.h>
 #include <Toy/Runtime/scene_graph.h>
 #include <Toy/Runtime/task_system.h>
+#include <Toy/Runtime/async_model_loader.h>
 #include <Toy/ECS/components.h>
 
 namespace toy::runtime
@@ -74,7 +75,7 @@ namespace toy::runtime
     {
         auto&& task_system = core::get_subsystem<TaskSystem>();
         if (task_system.empty()) return;
-        // Note: current only handle WindowResizeEvent, DockResizeEvent, DropEvent
+        // Note: current only handle WindowResizeEvent, DockResizeEvent, DropEvent, CompletionEvent
         EngineEventVariant delegate_event;
         while (task_system.try_get(delegate_event))
         {
@@ -89,6 +90,9 @@ namespace toy::runtime
                 } else if constexpr (std::is_same_v<event_type, DropEvent>)
                 {
                     this->on_file_drop(event.drop_filename);
+                } else if constexpr (std::is_same_v<event_type, CompletionEvent>)
+                {
+                    event.continuation();
                 }
             }, delegate_event);
         }
@@ -105,6 +109,9 @@ namespace toy::runtime
             this->lighting_and_taa_pass(*camera);
             this->skybox_pass(*camera);
         });
+
+        // Requests of every camera are in, stream texture mips for next frame
+        model::TextureManager::get().update_streaming();
     }
 
     void Renderer::init()
@@ -255,6 +262,7 @@ namespace toy::runtime
     {
         // Initialize texture manager and model manager
         model::TextureManager::get().init(m_d3d_device.Get());
+        model::TextureManager::get().enable_streaming();
         model::ModelManager::get().init(m_d3d_device.Get());
     }
 
@@ -338,25 +346,18 @@ namespace toy::runtime
 
     void Renderer::on_file_drop(std::string_view filepath)
     {
-        auto&& scene_graph = core::get_subsystem<SceneGraph>();
         const std::string extension = std::filesystem::path(filepath).extension().string();
-        auto filename = std::filesystem::path(filepath).filename();
         if (extension == ".gltf" || extension == ".glb" || extension == ".fbx")
         {
-            auto new_entity = scene_graph.create_entity(filename.string());
-            model::ModelManager::get().create_from_file(filepath, static_cast<uint32_t>(new_entity.entity_inst));
-            auto& new_transform = new_entity.add_component<TransformComponent>();
-            new_transform.transform.set_scale(0.5f, 0.5f, 0.5f);
-            auto& new_mesh = new_entity.add_component<StaticMeshComponent>();
-            new_mesh.model_asset = model::ModelManager::get().get_model(filepath);
+            // Entity shows a placeholder until model is loaded on workers, so that a large model does not stall frames
+            Transform new_transform{};
+            new_transform.set_scale(0.5f, 0.5f, 0.5f);
+            core::get_subsystem<AsyncModelLoader>().load(filepath, new_transform);
         } else if (extension == ".hdr")
         {
             auto d3d_device = m_d3d_device.Get();
             auto d3d_device_context = m_d3d_immediate_context.Get();
-            PreProcessEffect::get().compute_cubemap(d3d_device, d3d_device_context, filepath);
-            PreProcessEffect::get().compute_sp_env_map(d3d_device, d3d_device_context);
-            PreProcessEffect::get().compute_irradiance_map(d3d_device, d3d_device_context);
-            PreProcessEffect::get().compute_brdf_lut(d3d_device, d3d_device_context);
+            PreProcessEffect::get().compute_ibl(d3d_device, d3d_device_context, filepath);
         }
     }
 
@@ -410,6 +411,7 @@ namespace toy::runtime
         BoundingFrustum::CreateFromMatrix(frustum, camera.get_proj_xm());
         frustum.Transform(frustum, camera.get_local_to_world_xm());
         scene_graph.frustum_culling(frustum);
+        scene_graph.request_textures(camera);
     }
 
     void Renderer::shadow_pass(const Camera &camera)
@@ -0,0 +1,301 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Runtime/scene_file.h>
+#include <Toy/Runtime/scene_graph.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Model/model_manager.h>
+
+namespace toy::runtime
+{
+    static constexpr uint32_t s_invalid_entity_index = std::numeric_limits<uint32_t>::max();
+
+    bool validate_scene_file(std::span<const uint8_t> image)
+    {
+        if (!validate_scene_image(image))
+        {
+            return false;
+        }
+        // Component type of a table changed size since the image was written
+        auto&& header = *reinterpret_cast<const SceneFileHeader *>(image.data());
+        auto is_width_valid = [](const SceneFileTable &table, size_t component_byte_width)
+        {
+            return table.count == 0 || table.component_byte_width == component_byte_width;
+        };
+        if (!is_width_valid(header.transforms, sizeof(TransformComponent)) ||
+            !is_width_valid(header.directional_lights, sizeof(DirectionalLightComponent)) ||
+            !is_width_valid(header.cameras, sizeof(SceneFileCamera)))
+        {
+            return false;
+        }
+        auto cameras = get_scene_array<SceneFileCamera>(image, header.cameras.components);
+        return std::all_of(cameras.begin(), cameras.end(),
+                           [](const SceneFileCamera &camera) { return camera.camera_type <= static_cast<uint32_t>(CameraType::ThirdPersonCamera); });
+    }
+
+    bool SceneGraph::save_scene(const std::filesystem::path &file_path)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        auto&& model_manager = model::ModelManager::get();
+
+        // Entities are numbered in tag order, entity without tag was not created by scene graph and is not saved
+        // Transient entities belong to world streamer or model loader, which create them again
+        SceneImageWriter writer{};
+        std::vector<uint32_t> entity_indices{};
+        auto tag_view = registry_handle.view<TagComponent>();
+        for (auto entity : tag_view)
+        {
+            if (registry_handle.all_of<TransientComponent>(entity))
+            {
+                continue;
+            }
+            auto entity_slot = static_cast<size_t>(entt::to_entity(entity));
+            if (entity_slot >= entity_indices.size())
+            {
+                entity_indices.resize(entity_slot + 1, s_invalid_entity_index);
+            }
+            entity_indices[entity_slot] = writer.add_entity(tag_view.get<TagComponent>(entity).tag);
+        }
+        auto get_entity_index = [&entity_indices](entt::entity entity)
+        {
+            auto entity_slot = static_cast<size_t>(entt::to_entity(entity));
+            return entity_slot < entity_indices.size() ? entity_indices[entity_slot] : s_invalid_entity_index;
+        };
+
+        std::vector<uint32_t> transform_entities{};
+        std::vector<TransformComponent> transforms{};
+        auto transform_view = registry_handle.view<TransformComponent>();
+        for (auto entity : transform_view)
+        {
+            if (uint32_t entity_index = get_entity_index(entity); entity_index != s_invalid_entity_index)
+            {
+                transform_entities.push_back(entity_index);
+                transforms.push_back(transform_view.get<TransformComponent>(entity));
+            }
+        }
+
+        // Models are written once, entities refer to them by index into asset table
+        std::unordered_set<XID> known_models{};
+        std::vector<uint32_t> static_mesh_entities{};
+        std::vector<SceneFileStaticMesh> static_meshes{};
+        auto static_mesh_view = registry_handle.view<StaticMeshComponent>();
+        for (auto entity : static_mesh_view)
+        {
+            auto&& static_mesh_component = static_mesh_view.get<StaticMeshComponent>(entity);
+            uint32_t entity_index = get_entity_index(entity);
+            if (entity_index == s_invalid_entity_index || !static_mesh_component.model_asset)
+            {
+                continue;
+            }
+
+            XID model_id = static_mesh_component.model_asset.get_id();
+            std::string model_file{};
+            if (known_models.insert(model_id).second)
+            {
+                model_file = model_manager.get_model_file(model_id);
+                if (model_file.empty())
+                {
+                    DX_CORE_WARN("Model {:016x} of entity '{}' has no source file, scene resolves it only while it is resident", model_id,
+                                 registry_handle.get<TagComponent>(entity).tag);
+                }
+            }
+            static_mesh_entities.push_back(entity_index);
+            static_meshes.push_back({ writer.add_asset(model_id, model_file), static_mesh_component.is_skybox, static_mesh_component.is_camera, 0 });
+        }
+
+        std::vector<uint32_t> directional_light_entities{};
+        std::vector<DirectionalLightComponent> directional_lights{};
+        auto directional_light_view = registry_handle.view<DirectionalLightComponent>();
+        for (auto entity : directional_light_view)
+        {
+            if (uint32_t entity_index = get_entity_index(entity); entity_index != s_invalid_entity_index)
+            {
+                directional_light_entities.push_back(entity_index);
+                directional_lights.push_back(directional_light_view.get<DirectionalLightComponent>(entity));
+            }
+        }
+
+        std::vector<uint32_t> camera_entities{};
+        std::vector<SceneFileCamera> cameras{};
+        auto camera_view = registry_handle.view<CameraComponent>();
+        for (auto entity : camera_view)
+        {
+            auto&& camera_component = camera_view.get<CameraComponent>(entity);
+            uint32_t entity_index = get_entity_index(entity);
+            if (entity_index == s_invalid_entity_index || !camera_component.camera)
+            {
+                continue;
+            }
+
+            const Camera &camera = *camera_component.camera;
+            SceneFileCamera &camera_record = cameras.emplace_back();
+            camera_record.camera_type = static_cast<uint32_t>(camera_component.camera_type);
+            camera_record.transform = camera.get_transform();
+            camera_record.fov_y = camera.get_fov_y();
+            camera_record.aspect = camera.get_aspect_ratio();
+            camera_record.near_z = camera.get_near_z();
+            camera_record.far_z = camera.get_far_z();
+            camera_record.viewport = camera.get_viewport();
+            if (auto third_person_camera = dynamic_cast<const ThirdPersonCamera *>(&camera))
+            {
+                camera_record.target = third_person_camera->get_target_position();
+                camera_record.distance = third_person_camera->get_distance();
+                camera_record.min_distance = third_person_camera->get_min_distance();
+                camera_record.max_distance = third_person_camera->get_max_distance();
+            }
+            camera_entities.push_back(entity_index);
+        }
+
+        auto&& header = writer.header();
+        header.transforms = writer.append_table<TransformComponent>(transform_entities, transforms);
+        header.static_meshes = writer.append_table<SceneFileStaticMesh>(static_mesh_entities, static_meshes);
+        header.directional_lights = writer.append_table<DirectionalLightComponent>(directional_light_entities, directional_lights);
+        header.cameras = writer.append_table<SceneFileCamera>(camera_entities, cameras);
+        std::vector<uint8_t> image = writer.finish();
+        if (!save_scene_image(file_path, image))
+        {
+            return false;
+        }
+
+        DX_CORE_INFO("Scene '{}' saved, {} entities, {} models, {:.2f} KB in {:.2f} ms", file_path.string(), header.entity_count,
+                     header.asset_count, static_cast<double>(image.size()) / 1024.0,
+                     std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+        return true;
+    }
+
+    static std::shared_ptr<Camera> create_camera(const SceneFileCamera &camera_record)
+    {
+        std::shared_ptr<Camera> camera{};
+        switch (static_cast<CameraType>(camera_record.camera_type))
+        {
+            case CameraType::FirstPersonCamera:
+                camera = std::make_shared<FirstPersonCamera>();
+                break;
+            case CameraType::ThirdPersonCamera:
+            {
+                auto third_person_camera = std::make_shared<ThirdPersonCamera>();
+                third_person_camera->set_target(camera_record.target);
+                third_person_camera->set_distance(camera_record.distance);
+                third_person_camera->set_min_max_distance(camera_record.min_distance, camera_record.max_distance);
+                camera = std::move(third_person_camera);
+                break;
+            }
+            default:
+                camera = std::make_shared<Camera>();
+                break;
+        }
+        camera->get_transform() = camera_record.transform;
+        camera->set_frustum(camera_record.fov_y, camera_record.aspect, camera_record.near_z, camera_record.far_z);
+        camera->set_viewport(camera_record.viewport);
+        camera->set_dirty_flag(true);
+        return camera;
+    }
+
+    bool SceneGraph::load_scene(const std::filesystem::path &file_path)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        MappedFile file(file_path);
+        if (!file.is_open() || !validate_scene_file(file.bytes()))
+        {
+            DX_CORE_WARN("Fail to load scene file '{}', scene is left as is", file_path.string());
+            return false;
+        }
+        std::span<const uint8_t> image = file.bytes();
+        auto&& header = *reinterpret_cast<const SceneFileHeader *>(image.data());
+        clear();
+
+        // Every entity is created at once, then each component type is inserted in one call
+        std::vector<entt::entity> entities(header.entity_count);
+        registry_handle.create(entities.begin(), entities.end());
+        auto get_entities = [&image, &entities](const SceneFileTable &table)
+        {
+            std::vector<entt::entity> table_entities{};
+            table_entities.reserve(table.count);
+            for (uint32_t entity_index : get_scene_array<uint32_t>(image, table.entities))
+            {
+                table_entities.push_back(entities[entity_index]);
+            }
+            return table_entities;
+        };
+
+        auto tag_offsets = get_scene_array<uint32_t>(image, header.tag_offsets);
+        std::string_view tags = get_scene_string(image, header.tags);
+        std::vector<TagComponent> tag_components(header.entity_count);
+        for (size_t i = 0; i < tag_components.size(); ++i)
+        {
+            tag_components[i].tag = tags.substr(tag_offsets[i], tag_offsets[i + 1] - tag_offsets[i]);
+        }
+        registry_handle.insert<TagComponent>(entities.begin(), entities.end(), std::make_move_iterator(tag_components.begin()));
+
+        // Trivially copyable components are constructed straight from mapped file
+        auto transform_entities = get_entities(header.transforms);
+        auto transforms = get_scene_array<TransformComponent>(image, header.transforms.components);
+        registry_handle.insert<TransformComponent>(transform_entities.begin(), transform_entities.end(), transforms.begin());
+
+        auto directional_light_entities = get_entities(header.directional_lights);
+        auto directional_lights = get_scene_array<DirectionalLightComponent>(image, header.directional_lights.components);
+        registry_handle.insert<DirectionalLightComponent>(directional_light_entities.begin(), directional_light_entities.end(),
+                                                          directional_lights.begin());
+
+        auto camera_entities = get_entities(header.cameras);
+        std::vector<CameraComponent> camera_components{};
+        camera_components.reserve(header.cameras.count);
+        for (auto&& camera_record : get_scene_array<SceneFileCamera>(image, header.cameras.components))
+        {
+            camera_components.push_back({ create_camera(camera_record), static_cast<CameraType>(camera_record.camera_type) });
+        }
+        registry_handle.insert<CameraComponent>(camera_entities.begin(), camera_entities.end(), std::make_move_iterator(camera_components.begin()));
+        auto construct_time = std::chrono::steady_clock::now();
+
+        // Models are resolved once each, those the session does not know are loaded from their source file
+        auto&& model_manager = model::ModelManager::get();
+        auto assets = get_scene_array<SceneFileAsset>(image, header.assets);
+        std::string_view asset_names = get_scene_string(image, header.asset_names);
+        std::vector<model::ModelHandle> models(assets.size());
+        for (size_t i = 0; i < assets.size(); ++i)
+        {
+            std::string_view model_file = asset_names.substr(assets[i].name_offset, assets[i].name_length);
+            try
+            {
+                models[i] = model_manager.acquire(assets[i].id, model_file);
+            } catch (const std::exception &exception)
+            {
+                DX_CORE_WARN("Fail to load model '{}' of scene: {}", model_file, exception.what());
+            }
+            if (!models[i])
+            {
+                DX_CORE_WARN("Model {:016x} of scene can not be resolved, its entities have no mesh", assets[i].id);
+            }
+        }
+        auto resolve_time = std::chrono::steady_clock::now();
+
+        std::vector<entt::entity> static_mesh_entities_to_insert{};
+        std::vector<StaticMeshComponent> static_mesh_components{};
+        static_mesh_entities_to_insert.reserve(header.static_meshes.count);
+        static_mesh_components.reserve(header.static_meshes.count);
+        auto static_mesh_entity_indices = get_scene_array<uint32_t>(image, header.static_meshes.entities);
+        auto static_meshes = get_scene_array<SceneFileStaticMesh>(image, header.static_meshes.components);
+        for (size_t i = 0; i < static_meshes.size(); ++i)
+        {
+            auto&& model = models[static_meshes[i].asset_index];
+            if (!model)
+            {
+                continue;
+            }
+            static_mesh_entities_to_insert.push_back(entities[static_mesh_entity_indices[i]]);
+            auto&& static_mesh_component = static_mesh_components.emplace_back();
+            static_mesh_component.model_asset = model;
+            static_mesh_component.is_skybox = static_meshes[i].is_skybox != 0;
+            static_mesh_component.is_camera = static_meshes[i].is_camera != 0;
+        }
+        registry_handle.insert<StaticMeshComponent>(static_mesh_entities_to_insert.begin(), static_mesh_entities_to_insert.end(),
+                                                    std::make_move_iterator(static_mesh_components.begin()));
+
+        auto end_time = std::chrono::steady_clock::now();
+        DX_CORE_INFO("Scene '{}' loaded, {} entities in {:.2f} ms, {} models resolved in {:.2f} ms", file_path.string(), header.entity_count,
+                     std::chrono::duration<double, std::milli>((construct_time - start_time) + (end_time - resolve_time)).count(),
+                     header.asset_count, std::chrono::duration<double, std::milli>(resolve_time - construct_time).count());
+        return true;
+    }
+}
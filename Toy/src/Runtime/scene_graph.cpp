@@ -24,6 +24,34 @@ namespace toy::runtime
         entity_wrapper.registry_handle = nullptr;
     }
 
+    bool SceneGraph::contains(const EntityWrapper &entity_wrapper) const
+    {
+        return entity_wrapper.registry_handle == &registry_handle && registry_handle.valid(entity_wrapper.entity_inst);
+    }
+
+    EntityWrapper SceneGraph::find_entity(std::string_view entity_name)
+    {
+        auto view = registry_handle.view<TagComponent>();
+        for (auto entity : view)
+        {
+            if (view.get<TagComponent>(entity).tag == entity_name)
+            {
+                return EntityWrapper{ &registry_handle, entity };
+            }
+        }
+        return EntityWrapper{};
+    }
+
+    void SceneGraph::clear()
+    {
+        registry_handle.clear();
+        static_mesh_entities.clear();
+        entities_in_frustum.clear();
+        skybox_entity = entt::null;
+        scene_bounding_box = {};
+        generation++;
+    }
+
     EntityWrapper SceneGraph::get_skybox_entity()
     {
         return EntityWrapper{ &registry_handle, skybox_entity };
@@ -94,7 +122,20 @@ namespace toy::runtime
         for (auto entity : entities_in_frustum)
         {
             const auto [transform_component, static_mesh_component] = view.get<TransformComponent, StaticMeshComponent>(entity);
-            static_mesh_component.render(device_context, effect, transform_component.transform);
+            static_mesh_component.render(device_context, effect, transform_component.transform, static_cast<uint32_t>(entity));
+        }
+    }
+
+    void SceneGraph::request_textures(const Camera &camera)
+    {
+        float projection_scale = camera.get_viewport().Height / (2.0f * std::tan(0.5f * camera.get_fov_y()));
+        DirectX::XMFLOAT3 view_position = camera.get_position();
+
+        auto view = registry_handle.view<TransformComponent, StaticMeshComponent>();
+        for (auto entity : entities_in_frustum)
+        {
+            const auto [transform_component, static_mesh_component] = view.get<TransformComponent, StaticMeshComponent>(entity);
+            static_mesh_component.request_textures(transform_component.transform, view_position, projection_scale);
         }
     }
 
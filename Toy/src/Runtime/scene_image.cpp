@@ -0,0 +1,181 @@
+//
+// Created by ZZK on 2024/4/18.
+//
+
+#include <Toy/Runtime/scene_image.h>
+
+namespace toy::runtime
+{
+    static bool is_blob_valid(std::span<const uint8_t> image, const SceneFileBlob &blob, size_t element_byte_width)
+    {
+        return blob.offset % scene_file_alignment == 0 && blob.offset <= image.size() && blob.byte_width <= image.size() - blob.offset &&
+               blob.byte_width % element_byte_width == 0;
+    }
+
+    static bool is_table_valid(std::span<const uint8_t> image, const SceneFileTable &table, uint32_t entity_count,
+                               std::vector<uint8_t> &has_component)
+    {
+        // Table that was never appended is empty and has no width
+        if (table.component_byte_width == 0)
+        {
+            return table.count == 0 && table.entities.byte_width == 0 && table.components.byte_width == 0;
+        }
+        if (!is_blob_valid(image, table.entities, sizeof(uint32_t)) || !is_blob_valid(image, table.components, table.component_byte_width) ||
+            table.entities.byte_width != static_cast<uint64_t>(table.count) * sizeof(uint32_t) ||
+            table.components.byte_width != static_cast<uint64_t>(table.count) * table.component_byte_width)
+        {
+            return false;
+        }
+
+        // Entity can hold one component of a type
+        has_component.assign(entity_count, 0);
+        for (uint32_t entity_index : get_scene_array<uint32_t>(image, table.entities))
+        {
+            if (entity_index >= entity_count || has_component[entity_index])
+            {
+                return false;
+            }
+            has_component[entity_index] = 1;
+        }
+        return true;
+    }
+
+    SceneImageWriter::SceneImageWriter() : m_image(sizeof(SceneFileHeader)), m_tag_offsets{ 0 }
+    {
+    }
+
+    uint32_t SceneImageWriter::add_entity(std::string_view tag)
+    {
+        m_tags += tag;
+        m_tag_offsets.push_back(static_cast<uint32_t>(m_tags.size()));
+        return static_cast<uint32_t>(m_tag_offsets.size() - 2);
+    }
+
+    uint32_t SceneImageWriter::add_asset(XID id, std::string_view file_name)
+    {
+        auto [it, inserted] = m_asset_indices.try_emplace(id, static_cast<uint32_t>(m_assets.size()));
+        if (inserted)
+        {
+            m_assets.push_back({ id, static_cast<uint32_t>(m_asset_names.size()), static_cast<uint32_t>(file_name.size()) });
+            m_asset_names += file_name;
+        }
+        return it->second;
+    }
+
+    SceneFileTable SceneImageWriter::append_table(std::span<const uint32_t> entities, const void *components, size_t count,
+                                                  uint32_t component_byte_width)
+    {
+        SceneFileTable table{};
+        table.count = static_cast<uint32_t>(count);
+        table.component_byte_width = component_byte_width;
+        table.entities = append(entities.data(), entities.size() * sizeof(uint32_t));
+        table.components = append(components, count * component_byte_width);
+        return table;
+    }
+
+    std::vector<uint8_t> SceneImageWriter::finish()
+    {
+        m_header.entity_count = static_cast<uint32_t>(m_tag_offsets.size() - 1);
+        m_header.asset_count = static_cast<uint32_t>(m_assets.size());
+        m_header.assets = append(m_assets.data(), m_assets.size() * sizeof(SceneFileAsset));
+        m_header.asset_names = append(m_asset_names.data(), m_asset_names.size());
+        m_header.tag_offsets = append(m_tag_offsets.data(), m_tag_offsets.size() * sizeof(uint32_t));
+        m_header.tags = append(m_tags.data(), m_tags.size());
+        m_header.byte_width = m_image.size();
+        std::memcpy(m_image.data(), &m_header, sizeof(SceneFileHeader));
+
+        return std::move(m_image);
+    }
+
+    SceneFileBlob SceneImageWriter::append(const void *data, size_t byte_width)
+    {
+        size_t offset = (m_image.size() + scene_file_alignment - 1) / scene_file_alignment * scene_file_alignment;
+        m_image.resize(offset + byte_width);
+        if (byte_width > 0)
+        {
+            std::memcpy(m_image.data() + offset, data, byte_width);
+        }
+        return { offset, byte_width };
+    }
+
+    bool validate_scene_image(std::span<const uint8_t> image)
+    {
+        if (image.size() < sizeof(SceneFileHeader))
+        {
+            return false;
+        }
+        auto&& header = *reinterpret_cast<const SceneFileHeader *>(image.data());
+        if (header.magic != scene_file_magic || header.version != scene_file_version || header.byte_width != image.size())
+        {
+            return false;
+        }
+
+        if (!is_blob_valid(image, header.assets, sizeof(SceneFileAsset)) || !is_blob_valid(image, header.asset_names, 1) ||
+            header.assets.byte_width != static_cast<uint64_t>(header.asset_count) * sizeof(SceneFileAsset))
+        {
+            return false;
+        }
+        for (auto&& asset : get_scene_array<SceneFileAsset>(image, header.assets))
+        {
+            if (static_cast<uint64_t>(asset.name_offset) + asset.name_length > header.asset_names.byte_width)
+            {
+                return false;
+            }
+        }
+
+        if (!is_blob_valid(image, header.tag_offsets, sizeof(uint32_t)) || !is_blob_valid(image, header.tags, 1) ||
+            header.tag_offsets.byte_width != (static_cast<uint64_t>(header.entity_count) + 1) * sizeof(uint32_t))
+        {
+            return false;
+        }
+        auto tag_offsets = get_scene_array<uint32_t>(image, header.tag_offsets);
+        if (tag_offsets.front() != 0 || tag_offsets.back() > header.tags.byte_width ||
+            std::adjacent_find(tag_offsets.begin(), tag_offsets.end(), std::greater<>()) != tag_offsets.end())
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> has_component{};
+        if (!is_table_valid(image, header.transforms, header.entity_count, has_component) ||
+            !is_table_valid(image, header.static_meshes, header.entity_count, has_component) ||
+            !is_table_valid(image, header.directional_lights, header.entity_count, has_component) ||
+            !is_table_valid(image, header.cameras, header.entity_count, has_component) ||
+            (header.static_meshes.count > 0 && header.static_meshes.component_byte_width != sizeof(SceneFileStaticMesh)))
+        {
+            return false;
+        }
+        auto static_meshes = get_scene_array<SceneFileStaticMesh>(image, header.static_meshes.components);
+        return std::all_of(static_meshes.begin(), static_meshes.end(),
+                           [&header](const SceneFileStaticMesh &static_mesh) { return static_mesh.asset_index < header.asset_count; });
+    }
+
+    std::string_view get_scene_string(std::span<const uint8_t> image, const SceneFileBlob &blob)
+    {
+        return { reinterpret_cast<const char *>(image.data() + blob.offset), static_cast<size_t>(blob.byte_width) };
+    }
+
+    bool save_scene_image(const std::filesystem::path &file_path, std::span<const uint8_t> image)
+    {
+        std::error_code error_code{};
+        std::filesystem::path temp_path = file_path;
+        temp_path += ".tmp";
+        bool is_written = false;
+        {
+            std::ofstream file_stream(temp_path, std::ios::binary | std::ios::trunc);
+            file_stream.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+            file_stream.close();
+            is_written = file_stream.good();
+        }
+        if (is_written)
+        {
+            std::filesystem::rename(temp_path, file_path, error_code);
+        }
+        if (!is_written || error_code)
+        {
+            DX_CORE_WARN("Fail to write scene file '{}': {}", file_path.string(), is_written ? error_code.message() : "write error");
+            std::filesystem::remove(temp_path, error_code);
+            return false;
+        }
+        return true;
+    }
+}
@@ -8,26 +8,31 @@ namespace toy::runtime
 {
     void TaskSystem::push(EngineEventVariant &&engine_event)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_pending_events.emplace_back(std::move(engine_event));
     }
 
     void TaskSystem::push(const EngineEventVariant &engine_event)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_pending_events.emplace_back(engine_event);
     }
 
     void TaskSystem::clear()
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_pending_events.clear();
     }
 
     bool TaskSystem::empty() const
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         return m_pending_events.empty();
     }
 
     EngineEventVariant TaskSystem::try_pop()
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         if (!m_pending_events.empty())
         {
             EngineEventVariant engine_event = std::move(m_pending_events.front());
@@ -39,6 +44,7 @@ namespace toy::runtime
 
     bool TaskSystem::try_get(toy::EngineEventVariant &engine_event)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         if (!m_pending_events.empty())
         {
             engine_event = std::move(m_pending_events.front());
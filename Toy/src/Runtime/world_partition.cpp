@@ -0,0 +1,323 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Runtime/world_partition.h>
+
+namespace toy::runtime
+{
+    static uint64_t get_cell_key(const WorldCellCoord& coord)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z);
+    }
+
+    static bool is_pending(WorldCellState state)
+    {
+        return state == WorldCellState::Queued || state == WorldCellState::Loading || state == WorldCellState::Loaded;
+    }
+
+    WorldPartition::WorldPartition(IWorldCellLoader &loader, const WorldStreamingSettings &settings)
+        : m_loader(loader), m_settings(settings)
+    {
+        m_settings.cell_size = std::max(m_settings.cell_size, 1.0f);
+        m_settings.unload_radius = std::max(m_settings.unload_radius, m_settings.load_radius);
+        m_settings.max_activations_per_update = std::max(m_settings.max_activations_per_update, 1u);
+
+        m_io_threads.reserve(m_settings.io_thread_count);
+        for (uint32_t i = 0; i < m_settings.io_thread_count; ++i)
+        {
+            m_io_threads.emplace_back([this]() { run_io_thread(); });
+        }
+    }
+
+    WorldPartition::~WorldPartition()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_queue_not_empty.notify_all();
+        for (auto&& io_thread : m_io_threads)
+        {
+            io_thread.join();
+        }
+    }
+
+    WorldCellCoord WorldPartition::get_cell_coord(const DirectX::XMFLOAT3 &position) const
+    {
+        return { static_cast<int32_t>(std::floor(position.x / m_settings.cell_size)),
+                 static_cast<int32_t>(std::floor(position.z / m_settings.cell_size)) };
+    }
+
+    uint32_t WorldPartition::add_item(const DirectX::XMFLOAT3 &position, uint32_t item)
+    {
+        WorldCellCoord coord = get_cell_coord(position);
+        auto [it, inserted] = m_cell_lookup.try_emplace(get_cell_key(coord), static_cast<uint32_t>(m_cells.size()));
+        if (inserted)
+        {
+            auto&& cell = m_cells.emplace_back(std::make_unique<WorldCell>());
+            cell->index = it->second;
+            cell->coord = coord;
+            m_statistics.cell_count = m_cells.size();
+        }
+        m_cells[it->second]->items.push_back(item);
+        return it->second;
+    }
+
+    float WorldPartition::get_cell_distance(const WorldCell &cell, const DirectX::XMFLOAT3 &view_position) const
+    {
+        float min_x = static_cast<float>(cell.coord.x) * m_settings.cell_size;
+        float min_z = static_cast<float>(cell.coord.z) * m_settings.cell_size;
+        float dx = std::max({ min_x - view_position.x, 0.0f, view_position.x - min_x - m_settings.cell_size });
+        float dz = std::max({ min_z - view_position.z, 0.0f, view_position.z - min_z - m_settings.cell_size });
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    void WorldPartition::set_state(WorldCell &cell, WorldCellState state)
+    {
+        // Queued to loading on I/O threads touches nothing but cell state, statistics are read without locking
+        if (cell.state == WorldCellState::Active)
+        {
+            m_statistics.active_cell_count--;
+        } else if (state == WorldCellState::Active)
+        {
+            m_statistics.active_cell_count++;
+        }
+        if (is_pending(cell.state) && !is_pending(state))
+        {
+            m_statistics.pending_cell_count--;
+        } else if (!is_pending(cell.state) && is_pending(state))
+        {
+            m_statistics.pending_cell_count++;
+        }
+        if (cell.state == WorldCellState::Unloaded && state != WorldCellState::Unloaded)
+        {
+            m_streaming_cells.insert(cell.index);
+        } else if (state == WorldCellState::Unloaded)
+        {
+            m_streaming_cells.erase(cell.index);
+        }
+        cell.state = state;
+    }
+
+    void WorldPartition::finish_load(WorldCell &cell, size_t resident_bytes)
+    {
+        set_state(cell, WorldCellState::Loaded);
+        cell.resident_bytes = resident_bytes;
+        m_statistics.resident_bytes += resident_bytes;
+        m_statistics.peak_resident_bytes = std::max(m_statistics.peak_resident_bytes, m_statistics.resident_bytes);
+        m_statistics.load_count++;
+    }
+
+    void WorldPartition::update(const DirectX::XMFLOAT3 &view_position, const DirectX::XMFLOAT3 &view_direction)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        auto elapsed_ms = [&start_time]()
+        {
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        };
+
+        std::vector<std::pair<float, uint32_t>> activations{};
+        std::vector<uint32_t> unloads{};
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto&& [cell_index, resident_bytes] : m_completed_loads)
+            {
+                finish_load(*m_cells[cell_index], resident_bytes);
+            }
+            m_completed_loads.clear();
+
+            // Cells streaming already, and unloaded cells within reach of load radius
+            std::vector<uint32_t> candidates(m_streaming_cells.begin(), m_streaming_cells.end());
+            WorldCellCoord center = get_cell_coord(view_position);
+            auto reach = static_cast<int32_t>(std::ceil(m_settings.load_radius / m_settings.cell_size));
+            for (int32_t z = center.z - reach; z <= center.z + reach; ++z)
+            {
+                for (int32_t x = center.x - reach; x <= center.x + reach; ++x)
+                {
+                    auto it = m_cell_lookup.find(get_cell_key({ x, z }));
+                    if (it != m_cell_lookup.end() && m_cells[it->second]->state == WorldCellState::Unloaded)
+                    {
+                        candidates.push_back(it->second);
+                    }
+                }
+            }
+
+            // Queue is rebuilt every update, so that loads follow the view
+            m_load_queue.clear();
+            for (uint32_t cell_index : candidates)
+            {
+                auto&& cell = *m_cells[cell_index];
+                float distance = get_cell_distance(cell, view_position);
+                float center_x = (static_cast<float>(cell.coord.x) + 0.5f) * m_settings.cell_size - view_position.x;
+                float center_z = (static_cast<float>(cell.coord.z) + 0.5f) * m_settings.cell_size - view_position.z;
+                bool behind = center_x * view_direction.x + center_z * view_direction.z < 0.0f;
+                float priority = behind ? distance * m_settings.behind_priority_scale : distance;
+                bool in_load_range = distance <= m_settings.load_radius;
+                bool in_keep_range = distance <= m_settings.unload_radius;
+
+                switch (cell.state)
+                {
+                    case WorldCellState::Unloaded:
+                        if (in_load_range)
+                        {
+                            set_state(cell, WorldCellState::Queued);
+                            m_load_queue.emplace_back(priority, cell_index);
+                        }
+                        break;
+                    case WorldCellState::Queued:
+                        if (in_keep_range)
+                        {
+                            m_load_queue.emplace_back(priority, cell_index);
+                        } else
+                        {
+                            set_state(cell, WorldCellState::Unloaded);
+                            m_statistics.cancel_count++;
+                        }
+                        break;
+                    case WorldCellState::Loading:
+                        // Cell that is no longer wanted is unloaded once loaded
+                        break;
+                    case WorldCellState::Loaded:
+                        if (in_keep_range)
+                        {
+                            activations.emplace_back(priority, cell_index);
+                        } else
+                        {
+                            unloads.push_back(cell_index);
+                        }
+                        break;
+                    case WorldCellState::Active:
+                        if (!in_keep_range)
+                        {
+                            unloads.push_back(cell_index);
+                        }
+                        break;
+                }
+            }
+            std::sort(m_load_queue.begin(), m_load_queue.end(), [](auto&& lhs, auto&& rhs) { return lhs.first > rhs.first; });
+        }
+
+        if (!m_io_threads.empty())
+        {
+            m_queue_not_empty.notify_all();
+        } else
+        {
+            // Baseline, queued cells are loaded right here
+            for (auto&& [priority, cell_index] : std::vector<std::pair<float, uint32_t>>(std::move(m_load_queue)))
+            {
+                auto&& cell = *m_cells[cell_index];
+                set_state(cell, WorldCellState::Loading);
+                finish_load(cell, load_cell(cell));
+                activations.emplace_back(priority, cell_index);
+            }
+            m_load_queue.clear();
+        }
+
+        // Unloads free memory and are cheap, they are never deferred
+        for (uint32_t cell_index : unloads)
+        {
+            auto&& cell = *m_cells[cell_index];
+            m_loader.unload_cell(cell);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_statistics.resident_bytes -= cell.resident_bytes;
+            m_statistics.unload_count++;
+            cell.resident_bytes = 0;
+            set_state(cell, WorldCellState::Unloaded);
+        }
+
+        // Nearest first, the rest waits for next update
+        std::sort(activations.begin(), activations.end());
+        uint32_t activation_count = 0;
+        for (auto&& [priority, cell_index] : activations)
+        {
+            if (activation_count == m_settings.max_activations_per_update ||
+                (activation_count > 0 && elapsed_ms() > m_settings.activation_budget_ms))
+            {
+                break;
+            }
+            auto&& cell = *m_cells[cell_index];
+            m_loader.activate_cell(cell);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            set_state(cell, WorldCellState::Active);
+            ++activation_count;
+        }
+
+        m_statistics.last_update_ms = elapsed_ms();
+        m_statistics.max_update_ms = std::max(m_statistics.max_update_ms, m_statistics.last_update_ms);
+    }
+
+    void WorldPartition::unload_all()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (auto&& [priority, cell_index] : m_load_queue)
+            {
+                set_state(*m_cells[cell_index], WorldCellState::Unloaded);
+            }
+            m_load_queue.clear();
+            m_load_finished.wait(lock, [this]() { return m_loads_in_flight == 0; });
+            for (auto&& [cell_index, resident_bytes] : m_completed_loads)
+            {
+                finish_load(*m_cells[cell_index], resident_bytes);
+            }
+            m_completed_loads.clear();
+        }
+
+        std::vector<uint32_t> cells(m_streaming_cells.begin(), m_streaming_cells.end());
+        for (uint32_t cell_index : cells)
+        {
+            auto&& cell = *m_cells[cell_index];
+            if (cell.state == WorldCellState::Loaded || cell.state == WorldCellState::Active)
+            {
+                m_loader.unload_cell(cell);
+                m_statistics.unload_count++;
+            }
+            m_statistics.resident_bytes -= cell.resident_bytes;
+            cell.resident_bytes = 0;
+            set_state(cell, WorldCellState::Unloaded);
+        }
+    }
+
+    size_t WorldPartition::load_cell(const WorldCell &cell)
+    {
+        // Cell whose load fails is activated empty, loader reports what went wrong
+        try
+        {
+            return m_loader.load_cell(cell);
+        } catch (const std::exception& exception)
+        {
+            DX_CORE_ERROR("Fail to load world cell ({}, {}): {}", cell.coord.x, cell.coord.z, exception.what());
+            return 0;
+        }
+    }
+
+    void WorldPartition::run_io_thread()
+    {
+        while (true)
+        {
+            WorldCell* cell = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_queue_not_empty.wait(lock, [this]() { return m_stopping || !m_load_queue.empty(); });
+                if (m_stopping)
+                {
+                    break;
+                }
+                cell = m_cells[m_load_queue.back().second].get();
+                m_load_queue.pop_back();
+                set_state(*cell, WorldCellState::Loading);
+                ++m_loads_in_flight;
+            }
+
+            size_t resident_bytes = load_cell(*cell);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_completed_loads.emplace_back(cell->index, resident_bytes);
+                --m_loads_in_flight;
+            }
+            m_load_finished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,237 @@
+//
+// Created by ZZK on 2024/4/17.
+//
+
+#include <Toy/Runtime/world_streamer.h>
+#include <Toy/Runtime/scene_graph.h>
+#include <Toy/Core/mapped_file.h>
+#include <Toy/Core/virtual_file_system.h>
+#include <Toy/Core/json.h>
+#include <Toy/Model/model_manager.h>
+#include <Toy/Model/mesh_cache.h>
+#include <Toy/Model/texture_manager.h>
+#include <Toy/ECS/components.h>
+#include <Toy/ECS/camera.h>
+
+namespace toy::runtime
+{
+    // Touch every page of file, so that activation reads it from memory, return bytes of file
+    static size_t prefetch_file(const std::filesystem::path& file_path)
+    {
+        constexpr size_t page_size = 4096;
+        MappedFile file(file_path);
+        if (!file.is_open())
+        {
+            return 0;
+        }
+        uint8_t checksum = 0;
+        for (size_t offset = 0; offset < file.size(); offset += page_size)
+        {
+            checksum ^= file.data()[offset];
+        }
+        static_cast<void>(*static_cast<volatile uint8_t*>(&checksum));
+        return file.size();
+    }
+
+    WorldStreamer::WorldStreamer(SceneGraph &scene_graph, const WorldStreamingSettings &settings)
+        : m_scene_graph(scene_graph), m_scene_generation(scene_graph.get_generation()),
+          m_vertex_encoding(model::ModelManager::get().get_vertex_encoding()),
+          m_stream_storage(model::ModelManager::get().get_stream_storage()), m_partition(*this, settings)
+    {
+
+    }
+
+    WorldStreamer::~WorldStreamer()
+    {
+        m_partition.unload_all();
+    }
+
+    void WorldStreamer::add_entity(WorldEntityDesc &&entity_desc)
+    {
+        m_partition.add_item(entity_desc.transform.position, static_cast<uint32_t>(m_entities.size()));
+        m_entities.emplace_back(std::move(entity_desc));
+    }
+
+    bool WorldStreamer::load_world(const std::filesystem::path &file_path)
+    {
+        if (!m_entities.empty())
+        {
+            DX_CORE_WARN("World streamer has entities already, world '{}' is not loaded", file_path.string());
+            return false;
+        }
+
+        VirtualFile file = VirtualFileSystem::get().open(file_path);
+        json::Value root{};
+        std::string error{};
+        if (!file.is_open() ||
+            !json::parse({ reinterpret_cast<const char *>(file.data()), file.size() }, root, &error) || !root.is_object())
+        {
+            DX_CORE_WARN("Fail to read world description '{}' {}", file_path.string(), error);
+            return false;
+        }
+
+        auto&& tiles = root["tiles"];
+        auto size_x = root["size"][0].as_integer();
+        auto size_z = root["size"][1].as_integer();
+        float tile_size = root["tile_size"].as_float(default_world_cell_size);
+        if (tiles.size() == 0 || size_x <= 0 || size_z <= 0 || tile_size <= 0.0f)
+        {
+            DX_CORE_WARN("World description '{}' has no tile or an empty grid", file_path.string());
+            return false;
+        }
+
+        auto get_model_file = [](const json::Value& value)
+        {
+            return (std::filesystem::path(DXTOY_HOME) / value["model"].as_string()).string();
+        };
+        auto get_scale = [](const json::Value& value)
+        {
+            auto&& scale = value["scale"];
+            if (scale.is_number())
+            {
+                return DirectX::XMFLOAT3{ scale.as_float(), scale.as_float(), scale.as_float() };
+            }
+            return DirectX::XMFLOAT3{ scale[0].as_float(1.0f), scale[1].as_float(1.0f), scale[2].as_float(1.0f) };
+        };
+
+        // Same description places the same world on every machine, mt19937 and its integer output are fully specified
+        std::mt19937 generator(static_cast<uint32_t>(root["seed"].as_integer()));
+        auto uniform = [&generator]() { return static_cast<float>(generator() >> 8) * (1.0f / 16777216.0f); };
+        auto&& props = root["props"];
+        for (int64_t z = 0; z < size_z; ++z)
+        {
+            for (int64_t x = 0; x < size_x; ++x)
+            {
+                DirectX::XMFLOAT3 tile_center{ (static_cast<float>(x) - 0.5f * static_cast<float>(size_x - 1)) * tile_size, 0.0f,
+                                               (static_cast<float>(z) - 0.5f * static_cast<float>(size_z - 1)) * tile_size };
+                auto&& tile = tiles[std::min(static_cast<size_t>(uniform() * static_cast<float>(tiles.size())), tiles.size() - 1)];
+                WorldEntityDesc tile_desc{ "Ground", get_model_file(tile) };
+                tile_desc.transform.set_position(tile_center);
+                tile_desc.transform.set_scale(get_scale(tile));
+                add_entity(std::move(tile_desc));
+
+                for (auto&& prop : props.array())
+                {
+                    float per_tile = prop["per_tile"].as_float();
+                    auto count = static_cast<uint32_t>(per_tile) + (uniform() < per_tile - std::floor(per_tile) ? 1 : 0);
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        WorldEntityDesc prop_desc{ std::string(prop["name"].as_string("Prop")), get_model_file(prop) };
+                        prop_desc.transform.set_position(tile_center.x + (uniform() - 0.5f) * tile_size, 0.0f,
+                                                         tile_center.z + (uniform() - 0.5f) * tile_size);
+                        prop_desc.transform.set_rotation(0.0f, uniform() * DirectX::XM_2PI, 0.0f);
+                        prop_desc.transform.set_scale(get_scale(prop));
+                        add_entity(std::move(prop_desc));
+                    }
+                }
+            }
+        }
+
+        DX_CORE_INFO("World '{}' loaded, {} entities in {} cells", file_path.string(), m_entities.size(), m_partition.get_cell_count());
+        return true;
+    }
+
+    void WorldStreamer::update(const Camera &camera)
+    {
+        if (m_scene_generation != m_scene_graph.get_generation())
+        {
+            reset_cells();
+        }
+        if (!m_entities.empty())
+        {
+            m_partition.update(camera.get_position(), camera.get_look_axis());
+        }
+    }
+
+    void WorldStreamer::reset_cells()
+    {
+        m_partition.unload_all();
+        m_cell_entities.clear();
+        m_scene_generation = m_scene_graph.get_generation();
+    }
+
+    size_t WorldStreamer::load_cell(const WorldCell &cell)
+    {
+        std::unordered_set<std::string_view> model_files{};
+        for (uint32_t item : cell.items)
+        {
+            model_files.insert(m_entities[item].model_file);
+        }
+
+        size_t resident_bytes = 0;
+        for (std::string_view model_file : model_files)
+        {
+            std::vector<std::filesystem::path> cache_files{};
+            bool is_baker = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto [it, inserted] = m_model_caches.try_emplace(std::string(model_file));
+                cache_files = it->second;
+                is_baker = inserted;
+            }
+
+            // First cell of model bakes its caches, the others only read them, caches being baked are skipped
+            if (is_baker)
+            {
+                model::BakeResult mesh_result = model::bake_mesh_cache(model_file, m_vertex_encoding, m_stream_storage);
+                cache_files = mesh_result.outputs;
+                for (auto&& mesh_cache_file : mesh_result.outputs)
+                {
+                    MappedFile image(mesh_cache_file);
+                    for (auto&& texture : model::get_mesh_cache_textures(image.bytes()))
+                    {
+                        model::BakeResult texture_result = model::bake_texture_cache(texture);
+                        cache_files.insert(cache_files.end(), texture_result.outputs.begin(), texture_result.outputs.end());
+                    }
+                }
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_model_caches[std::string(model_file)] = cache_files;
+            }
+
+            for (auto&& cache_file : cache_files)
+            {
+                resident_bytes += prefetch_file(cache_file);
+            }
+        }
+        return resident_bytes;
+    }
+
+    void WorldStreamer::activate_cell(const WorldCell &cell)
+    {
+        auto&& model_manager = model::ModelManager::get();
+        auto&& cell_entities = m_cell_entities[cell.index];
+        for (uint32_t item : cell.items)
+        {
+            auto&& entity_desc = m_entities[item];
+            model::ModelHandle model_asset = model_manager.acquire(entity_desc.model_file);
+            if (!model_asset)
+            {
+                model_asset = model_manager.create_from_file(entity_desc.model_file);
+            }
+
+            auto entity = m_scene_graph.create_entity(entity_desc.name);
+            entity.add_component<TransientComponent>().owner = "World streamer";
+            entity.add_component<TransformComponent>().transform = entity_desc.transform;
+            entity.add_component<StaticMeshComponent>().model_asset = std::move(model_asset);
+            cell_entities.push_back(entity);
+        }
+    }
+
+    void WorldStreamer::unload_cell(const WorldCell &cell)
+    {
+        auto it = m_cell_entities.find(cell.index);
+        if (it == m_cell_entities.end())
+        {
+            return;
+        }
+        // Entity may have been deleted in editor meanwhile
+        for (auto&& entity : it->second)
+        {
+            if (m_scene_graph.contains(entity))
+            {
+                m_scene_graph.destroy_entity(entity);
+            }
+        }
+        m_cell_entities.erase(it);
+    }
+}
@@ -10,6 +10,11 @@ cbuffer CBChangesEveryInstanceDrawing : register(b0)
     matrix g_ViewProj;
     matrix g_Proj;
     matrix g_WorldViewProj;
+
+    float3 g_PositionScale;     // Dequantization of quantized vertex position, decoded = offset + encoded * scale
+    float  g_PositionPad0;
+    float3 g_PositionOffset;
+    float  g_PositionPad1;
 }
 
 cbuffer CBPerFrame : register(b1)
@@ -19,12 +19,52 @@ float linstep(float min_value, float max_value, float value)
 Texture2D g_DiffuseMap : register(t0);
 SamplerState g_Sam : register(s0);
 
+#ifndef QUANTIZED_VERTEX
+#define QUANTIZED_VERTEX 0
+#endif
+
+#if QUANTIZED_VERTEX
+// Quantized streams, decoded with g_PositionScale and g_PositionOffset of mesh bounding box
+struct VertexPosNormalTex
+{
+    float4 posL : POSITION;         // Unorm, w is tangent handedness
+    float2 normalL : NORMAL;        // Octahedral snorm
+    float2 texCoord : TEXCOORD;     // Half float
+};
+
+float3 OctahedralDecode(float2 e)
+{
+    float3 v = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+#else
 struct VertexPosNormalTex
 {
     float3 posL : POSITION;
     float3 normalL : NORMAL;
     float2 texCoord : TEXCOORD;
 };
+#endif
+
+float3 DecodePositionL(VertexPosNormalTex input)
+{
+#if QUANTIZED_VERTEX
+    return g_PositionOffset + input.posL.xyz * g_PositionScale;
+#else
+    return input.posL;
+#endif
+}
+
+float3 DecodeNormalL(VertexPosNormalTex input)
+{
+#if QUANTIZED_VERTEX
+    return OctahedralDecode(input.normalL);
+#else
+    return input.normalL;
+#endif
+}
 
 struct VertexPosHVNormalVTex
 {
@@ -38,9 +78,10 @@ VertexPosHVNormalVTex GeometryVS(VertexPosNormalTex input)
 {
     VertexPosHVNormalVTex output;
 
-    output.posH = mul(float4(input.posL, 1.0f), g_WorldViewProj);
-    output.posV = mul(float4(input.posL, 1.0f), g_WorldView).xyz;
-    output.normalV = mul(float4(input.normalL, 0.0f), g_WorldInvTransposeView).xyz;
+    float3 posL = DecodePositionL(input);
+    output.posH = mul(float4(posL, 1.0f), g_WorldViewProj);
+    output.posV = mul(float4(posL, 1.0f), g_WorldView).xyz;
+    output.normalV = mul(float4(DecodeNormalL(input), 0.0f), g_WorldInvTransposeView).xyz;
     output.texCoord = input.texCoord;
     
     return output;
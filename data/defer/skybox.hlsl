@@ -32,8 +32,9 @@ SkyboxVSOut SkyboxVS(VertexPosNormalTex input)
     SkyboxVSOut output;
     
     // 注意：不要移动天空盒并确保深度值为1(避免裁剪)
-    output.posViewport = mul(float4(input.posL, 0.0f), g_ViewProj).xyww;
-    output.skyboxCoord = input.posL;
+    float3 posL = DecodePositionL(input);
+    output.posViewport = mul(float4(posL, 0.0f), g_ViewProj).xyww;
+    output.skyboxCoord = posL;
     
     return output;
 }
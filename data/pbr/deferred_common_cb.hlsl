@@ -14,11 +14,18 @@ cbuffer CBPerObject      : register(b0)
     matrix gPreViewProj; 
     matrix gUnjitteredViewProj;
 
+    float3 gPositionScale;          // Dequantization of quantized vertex position, decoded = offset + encoded * scale
+    float  gPositionPadding0;
+    float3 gPositionOffset;
+    float  gPositionPadding1;
+
     // 2. For deferred pbr pass - pixel shader
     float4 gEyeWorldPos;
 
     uint   gNoPreprocess;
-    uint3  gPreprocessPadding;
+    uint   gEntityId;               // Per-draw entity id for picking, written to GBuffer
+    uint2  gPreprocessPadding;
+    float4 gIrradianceSH[9];        // SH9 diffuse irradiance over pi, basis constants folded in, w unused
 
     // 3. For deferred pbr pass, cascaded shadow map - pixel shader
     matrix gShadowView;
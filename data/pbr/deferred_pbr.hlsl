@@ -29,6 +29,22 @@ float3 sample_prefiltered_color(float3 view_dir, float3 normal, float roughness)
     return prefiltered_color;
 }
 
+// Diffuse irradiance of SH9 projected environment, same polynomial as evaluate_irradiance_sh on CPU
+float3 evaluate_irradiance_sh(float3 n)
+{
+    float3 irradiance = gIrradianceSH[0].rgb +
+                        gIrradianceSH[1].rgb * n.y +
+                        gIrradianceSH[2].rgb * n.z +
+                        gIrradianceSH[3].rgb * n.x +
+                        gIrradianceSH[4].rgb * (n.x * n.y) +
+                        gIrradianceSH[5].rgb * (n.y * n.z) +
+                        gIrradianceSH[6].rgb * (3.0f * n.z * n.z - 1.0f) +
+                        gIrradianceSH[7].rgb * (n.x * n.z) +
+                        gIrradianceSH[8].rgb * (n.x * n.x - n.y * n.y);
+    // Ringing of band 2 may turn dark side of strong lights negative
+    return max(irradiance, 0.0f);
+}
+
 // Ambient BRDF
 float3 ambient_brdf(PBRMaterial pbr_mat, float3 irradiance_color, float3 prefiltered_color, float2 BRDFLUT, float normal_dot_view)
 {
@@ -85,7 +101,7 @@ float4 PS(float4 homog_position : SV_Position, float2 texcoord : TEXCOORD) : SV_
     {
         float2 brdf = gBRDFLUT.Sample(gSamAnisotropicWrap, float2(normal_dot_view, pbr_mat.roughness)).rg;
         float3 prefiltered_color = sample_prefiltered_color(view_dir, world_normal, pbr_mat.roughness);
-        float3 irradiance_color = gIrradianceMap.Sample(gSamAnisotropicWrap, world_normal).rgb;
+        float3 irradiance_color = evaluate_irradiance_sh(world_normal);
         float3 ambient_color = ambient_brdf(pbr_mat, irradiance_color, prefiltered_color, brdf, normal_dot_view);
         final_color.rgb = ambient_color;
     }
@@ -18,7 +18,10 @@ GBuffer PS(VertexShaderOutput pin)
 {
     GBuffer gbuffer;
 
-    float3 normal_from_tex = lerp(2.0f * (gNormalMap.Sample(gSamAnisotropicWrap, pin.texcoord).rgb - 0.5f), s_normal, gNoNormalSrv);
+    // Normal map may be BC5 holding only XY, Z is reconstructed
+    float2 normal_xy = 2.0f * gNormalMap.Sample(gSamAnisotropicWrap, pin.texcoord).rg - 1.0f;
+    float3 normal_sample = float3(normal_xy, sqrt(saturate(1.0f - dot(normal_xy, normal_xy))));
+    float3 normal_from_tex = lerp(normal_sample, s_normal, gNoNormalSrv);
     // Construct TBN
     float3x3 TBN = float3x3(pin.tangent, pin.bi_normal, pin.world_normal);
     float3 normal = mul(normal_from_tex, TBN);
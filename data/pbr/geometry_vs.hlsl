@@ -5,18 +5,30 @@ VertexShaderOutput VS(VertexShaderInput vin)
 {
     VertexShaderOutput vout;
 
+#if QUANTIZED_VERTEX
+    float3 position = gPositionOffset + vin.position.xyz * gPositionScale;
+    float3 normal = octahedral_decode(vin.normal);
+    float3 tangent = octahedral_decode(vin.tangent);
+    float handedness = vin.position.w > 0.5f ? 1.0f : -1.0f;
+#else
+    float3 position = vin.position;
+    float3 normal = vin.normal;
+    float3 tangent = vin.tangent.xyz;
+    float handedness = vin.tangent.w < 0.0f ? -1.0f : 1.0f;
+#endif
+
     // Transform to world space
-    float4 world_position = mul(float4(vin.position, 1.0f), gWorld);
+    float4 world_position = mul(float4(position, 1.0f), gWorld);
     vout.world_position = world_position.xyz;
-    vout.local_position = vin.position;
+    vout.local_position = position;
 
     // TODO: Enable TAA
-    float4 pre_world_position = mul(float4(vin.position, 1.0f), gPreWorld);
+    float4 pre_world_position = mul(float4(position, 1.0f), gPreWorld);
     vout.cur_vp_position = mul(world_position, gUnjitteredViewProj);
     vout.pre_vp_position = mul(pre_world_position, gPreViewProj);
 
     // Assume non-uniform scaling, otherwise need to use inverse-transpose of world matrix
-    vout.world_normal = normalize(mul(vin.normal, (float3x3)gWorld));
+    vout.world_normal = normalize(mul(normal, (float3x3)gWorld));
 
     // Transform to homogeneous clip space
     vout.homog_position = mul(world_position, gViewProj);
@@ -25,10 +37,12 @@ VertexShaderOutput VS(VertexShaderInput vin)
     // Output vertex attributes for interpolation across triangle - TAA
     vout.texcoord = vin.texcoord;
 
-    vout.tangent = normalize(mul(vin.tangent, gWorld)).xyz;
-    vout.bi_normal = cross(vout.world_normal, vout.tangent);
+    // Tangent is a direction, translation of world matrix does not apply
+    vout.tangent = normalize(mul(tangent, (float3x3)gWorld));
+    // Mirrored texture mapping flips bitangent
+    vout.bi_normal = cross(vout.world_normal, vout.tangent) * handedness;
 
-    vout.entity_id = vin.entity_id;
+    vout.entity_id = gEntityId;
 
     return vout;
 }
\ No newline at end of file
@@ -4,14 +4,26 @@ TextureCube<float4> gSkyboxMap : register(t0);
 Texture2D           gDepthMap  : register(t1);
 Texture2D           gSceneMap  : register(t2);
 
+#ifndef QUANTIZED_VERTEX
+#define QUANTIZED_VERTEX 0
+#endif
+
 cbuffer CBPerObject : register(b0)
 {
     matrix gViewProj;
+    float3 gPositionScale;          // Dequantization of quantized vertex position, decoded = offset + encoded * scale
+    float  gPositionPadding0;
+    float3 gPositionOffset;
+    float  gPositionPadding1;
 }
 
 struct SkyboxInput
 {
+#if QUANTIZED_VERTEX
+    float4 position : POSITION;     // Unorm relative to mesh bounding box
+#else
     float3 position : POSITION;
+#endif
     float2 texcoord : TEXCOORD;
 };
 
@@ -25,9 +37,15 @@ SkyboxOutput VS(SkyboxInput vin)
 {
     SkyboxOutput vout;
     
+#if QUANTIZED_VERTEX
+    float3 position = gPositionOffset + vin.position.xyz * gPositionScale;
+#else
+    float3 position = vin.position;
+#endif
+
     // Ensure skybox's depth is 1.0
-    vout.view_position = mul(float4(vin.position, 0.0f), gViewProj).xyww;
-    vout.skybox_coord  = vin.position;
+    vout.view_position = mul(float4(position, 0.0f), gViewProj).xyww;
+    vout.skybox_coord  = position;
 
     return vout;
 }
@@ -1,14 +1,36 @@
 #ifndef _VERTEX_DEFINITIONS_
 #define _VERTEX_DEFINITIONS_
 
+#ifndef QUANTIZED_VERTEX
+#define QUANTIZED_VERTEX 0
+#endif
+
+#if QUANTIZED_VERTEX
+// Decoded with gPositionScale and gPositionOffset of mesh bounding box
+struct VertexShaderInput
+{
+    float4 position  : POSITION;    // Unorm, w is tangent handedness
+    float2 normal    : NORMAL;      // Octahedral snorm
+    float2 tangent   : TANGENT;     // Octahedral snorm
+    float2 texcoord  : TEXCOORD;    // Half float
+};
+
+float3 octahedral_decode(float2 e)
+{
+    float3 v = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;        // Component-wise
+    return normalize(v);
+}
+#else
 struct VertexShaderInput
 {
     float3 position  : POSITION;
     float3 normal    : NORMAL;
     float4 tangent   : TANGENT;
     float2 texcoord  : TEXCOORD;
-    uint   entity_id : ENTITY_ID;
 };
+#endif
 
 struct VertexShaderOutput
 {
@@ -19,7 +41,7 @@ struct VertexShaderOutput
     float3 tangent         : TANGENT;
     float3 bi_normal       : TBNOUT;
     float2 texcoord        : TEXCOORD;
-    uint   entity_id       : ENTITY_ID;
+    nointerpolation uint entity_id : ENTITY_ID;
 
     // TODO: enable TAA
     float4 cur_vp_position : POSITION1;